@@ -186,7 +186,7 @@ void	SimCcd::createimage() {
 	starcamera.binning(exposure.mode());
 
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "build a new image");
-	ImagePtr	image = starcamera(starfield);
+	ImagePtr	image = starcamera(starfield, &bufferpool());
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "got an %s image: %s",
 		image->getFrame().toString().c_str(), image->info().c_str());
 
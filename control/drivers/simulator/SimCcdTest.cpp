@@ -25,10 +25,12 @@ public:
 	void	tearDown();
 	void	testConfig();
 	void	testImage();
+	void	testStream();
 
 	CPPUNIT_TEST_SUITE(SimCcdTest);
 	CPPUNIT_TEST(testConfig);
 	CPPUNIT_TEST(testImage);
+	CPPUNIT_TEST(testStream);
 	CPPUNIT_TEST_SUITE_END();
 };
 
@@ -67,6 +69,46 @@ void	SimCcdTest::testImage() {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "end image test");
 }
 
+/**
+ * \brief Stream images into a short queue that drops the oldest images
+ */
+void	SimCcdTest::testStream() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "start stream test");
+	Exposure	exposure;
+	exposure.exposuretime(0.02);
+	ccd->maxqueuelength(3);
+	ccd->droppolicy(ImageQueue::oldest);
+	CPPUNIT_ASSERT(ccd->pipelinepolicy() == ImageQueue::block);
+	ccd->startStream(exposure);
+	Timer::sleep(2);
+	ccd->stopStream();
+	ImageStreamStatistics	statistics = ccd->statistics();
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%s", statistics.toString().c_str());
+	CPPUNIT_ASSERT(statistics.exposed > 3);
+	CPPUNIT_ASSERT(statistics.delivered > 3);
+	// the pipeline waits for the delivery instead of dropping images
+	CPPUNIT_ASSERT(statistics.dropped == 0);
+
+	// the queue only contains the last images
+	long	sequence = -1;
+	int	count = 0;
+	while (ccd->hasEntry()) {
+		ImageQueueEntry	entry = ccd->getEntry(false);
+		CPPUNIT_ASSERT(entry.image->size() == ImageSize(640, 480));
+		CPPUNIT_ASSERT(entry.sequence > sequence);
+		sequence = entry.sequence;
+		count++;
+	}
+	CPPUNIT_ASSERT(count == 3);
+	CPPUNIT_ASSERT(ccd->dropped() > 0);
+
+	// the dropped images have been reused for later images
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%lu buffers allocated, %lu recycled",
+		ccd->bufferpool().allocated(), ccd->bufferpool().recycled());
+	CPPUNIT_ASSERT(ccd->bufferpool().recycled() > 0);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "end stream test");
+}
+
 } // namespace test
 } // namespace simulator
 } // namespace camera
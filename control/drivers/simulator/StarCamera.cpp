@@ -6,6 +6,8 @@
 #include <Stars.h>
 #include <AstroAdapter.h>
 #include <Blurr.h>
+#include <algorithm>
+#include <cstdint>
 
 using namespace astro::image;
 using namespace astro::camera;
@@ -21,7 +23,7 @@ namespace astro {
 StarCameraBase::StarCameraBase(const ImageRectangle& rectangle, const ImageSize& totalsize)
 	: _content(STARS), _rectangle(rectangle), _totalsize(totalsize),
 	  _stretch(1), _dark(0), _noise(0), _light(true), _color(0), _radius(0),
-	  _innerradius(0) {
+	  _innerradius(0), _west(true) {
 	// check environement variable
 	char	*v = getenv("STARCONTENT");
 	if (NULL == v) {
@@ -58,46 +60,6 @@ void	StarCameraBase::addHotPixels(unsigned int npixels) {
 		hotpixels.size());
 }
 
-/**
- * \brief Compute inverse error function using Newton's algorithm
- *
- * The error function in the C Library is defined as
- *
- * erf(x) = 2/sqrt(pi)*integral from 0 to x of exp(-t*t) dt.
- *
- * The derivative of erf(x) is of course
- *
- * erf'(x) = 2/sqrt(pi) exp(-t*t)
- *
- * 
- */
-#define	epsilon	0.000001
-#define	maxiterations	10
-
-static double	inverf(double y) {
-	//debug(LOG_DEBUG, DEBUG_LOG, 0, "y = %f", y);
-	double	z = 2 * (y - 0.5);
-	double	x = 0;
-	const double	m = 2 / sqrt(M_PI);
-	double	delta = 1;
-	int	counter = 0;
-	while ((counter++ < maxiterations) && (fabs(delta) > epsilon)) {
-		delta = (erf(x) - z) / (m * exp(-x * x));
-		x -= delta;
-		//debug(LOG_DEBUG, DEBUG_LOG, 0, "x = erf(y) = %f", x);
-	}
-	//debug(LOG_DEBUG, DEBUG_LOG, 0, "x = %f, erf(x) = %f, y = %f (%d)", x,
-	//	erf(x), y, counter);
-	//debug(LOG_DEBUG, DEBUG_LOG, 0, "y = %f, x = %f", y, x);
-	return x;
-}
-
-double	StarCameraBase::noisevalue() const {
-	double	y = random() / (double)RAND_MAX;
-	return _noise * (4 + inverf(y)) * 0.1;
-}
-
-
 void    StarCameraBase::noise(double n) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "set noise value to %f", n);
 	_noise = n;
@@ -131,12 +93,14 @@ Image<double>	*StarCameraBase::doubleImage(StarField& field) {
 	// new that we have the rectangle, work out the stars
 	ImagePoint	offset;
 
-	// find out how large we should make the field which we will later
-	// transform. This must be large enough so that we catch starts that 
-	// are just ouside the image area, because they will show up when
-	// the image is out of focus.
+	// If the image is out of focus, we need to compute a larger field
+	// which we will later blurr. This must be large enough so that we
+	// catch starts that are just ouside the image area, because they
+	// will show up when the image is out of focus. Focused images are
+	// computed directly in the window we return.
+	bool	blurred = light() && (radius() > 1);
 	ImageSize	size = rect.size();
-	if (0 != _radius) {
+	if (blurred) {
 		size = ImageSize(size.width() + 2 * _radius + 1,
 				size.height() + 2 * _radius + 1);
 		// we need to ensure that the size is a multiple of
@@ -196,54 +160,38 @@ Image<double>	*StarCameraBase::doubleImage(StarField& field) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "shift = %s",
 		shift.toString().c_str());
 
-	Image<double>	image(size);
-	for (int x = 0; x < size.width(); x++) {
-		for (int y = 0; y < size.height(); y++) {
-			image.pixel(x, y) = 0;
-		}
-	}
+	Image<double>	*result = new Image<double>(size);
+	result->fill(0);
 
 	// if this is a light image, we have to expose the stars from the
-	// star field
+	// star field, the values are already stretched
 	if (light()) {
 		// depending on the content, call the methods to expose
 		switch (_content) {
 		case STARS:
-			addStarIntensities(image, field, shift);
+			addStarIntensities(*result, field, shift);
 			break;
 		case SUN:
-			addSunIntensity(image, shift);
+			addSunIntensity(*result, shift);
 			break;
 		case PLANET:
-			addPlanetIntensity(image, shift);
+			addPlanetIntensity(*result, shift);
 			break;
 		}
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "object values applied");
-
-		// compute the blurr if necessary
-		if (radius() > 1) {
-			Blurr	blurr(radius(), innerradius());
-			Image<double>	blurredimage = blurr(image);
-			image = blurredimage;
-		}
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "blurring completed");
 	}
 
-	// extract the rectangle 
-	ImageRectangle	r(offset, rect.size());
-	WindowAdapter<double>	wa(image, r);
-	Image<double>	*result = new Image<double>(wa);
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "rectangle %s extracted",
-		r.toString().c_str());
-
-	// stretch the values
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "stretch factor = %.1f", _stretch);
-	int	width = rect.size().width();
-	int	height = rect.size().height();
-	for (int x = 0; x < width; x++) {
-		for (int y = 0; y < height; y++) {
-			result->pixel(x, y) = _stretch * result->pixel(x,y);
-		}
+	// compute the blurr if necessary, and extract the rectangle
+	if (blurred) {
+		Blurr	blurr(radius(), innerradius());
+		Image<double>	blurredimage = blurr(*result);
+		delete result;
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "blurring completed");
+		ImageRectangle	r(offset, rect.size());
+		WindowAdapter<double>	wa(blurredimage, r);
+		result = new Image<double>(wa);
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "rectangle %s extracted",
+			r.toString().c_str());
 	}
 
 	// add noise to the image rectangle
@@ -252,13 +200,12 @@ Image<double>	*StarCameraBase::doubleImage(StarField& field) {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "noise added");
 	}
 
-	// if on the east position, flip the image
+	// if on the east position, flip the image, which for a central
+	// mirror just reverses the order of the pixels
 	if (!_west) {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "rotate image");
-		MirrorAdapter<double>	ma(*result, MirrorAdapter<double>::CENTRAL);
-		Image<double>	*rotated = new Image<double>(ma);
-		delete result;
-		result = rotated;
+		std::reverse(result->pixels,
+			result->pixels + result->size().getPixels());
 	}
 
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "base image complete");
@@ -287,7 +234,7 @@ void	StarCameraBase::addBodyIntensity(Image<double>& image,
 				// interpolate between 100 and 102
 				value = (radius + 2 - r) / 2;
 			}
-			image.pixel(x, y) = value;
+			image.pixel(x, y) = _stretch * value;
 		}
 	}
 }
@@ -308,93 +255,71 @@ void	StarCameraBase::addSunIntensity(Image<double>& image,
 	addBodyIntensity(image, shift, 100);
 }
 
-/**
- * \brief Add the intensity of one particular star
- */
-void	StarCameraBase::addStarIntensity(Image<double>& image,
-		StellarObjectPtr star, Point shift) const {
-	// compute the position on the image
-	ImagePoint	c(star->position().x() - shift.x(),
-				star->position().y() - shift.y());
-
-	// depending on the orientation, we have to flip the star
-	Star	*starp = dynamic_cast<Star *>(&*star);
-	if (NULL == starp) {
-		return;
-	}
-	Star	fstar = *starp;
-#if 0
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "add star at c = %s, p = %s, shift = %s",
-		c.toString().c_str(), fstar.position().toString().c_str(),
-		shift.toString().c_str());
-#endif
-
-	// compute the area around the star for which we have to modify
-	// the image to add the diffraction image of the star
-	int	xmin = c.x() - 30;
-	if (xmin < 0) { xmin = 0; }
-
-	int	xmax = c.x() + 31;
-	if (xmax > image.size().width()) { xmax = image.size().width(); }
-
-	int	ymin = c.y() - 30;
-	if (ymin < 0) { ymin = 0; }
-
-	int	ymax = c.y() + 31;
-	if (ymax > image.size().height()) { ymax = image.size().height(); }
-
-	// update the environment
-	for (int x = xmin; x < xmax; x++) {
-		for (int y = ymin; y < ymax; y++) {
-			double	value = image.pixel(x,y);
-			Point	p(shift.x() + x, shift.y() + y);
-			switch (color()) {
-			case 0:
-				value += fstar.intensity(p);
-				break;
-			case 1:
-				value += fstar.intensityR(p);
-				break;
-			case 2:
-				value += fstar.intensityG(p);
-				break;
-			case 3:
-				value += fstar.intensityB(p);
-				break;
-			default:
-				break;
-			}
-			image.pixel(x, y) = value;
-		}
-	}
-}
-
 /**
  * \brief Add intensities of all the stars
  */
 void	StarCameraBase::addStarIntensities(Image<double>& image,
 		const StarField& field,
 		const Point& shift) const {
-	ImageSize	size = image.size();
-	for (unsigned int i = 0; i < field.nObjects(); i++) {
-		// now add the object intensity for object i
-		addStarIntensity(image, field[i], shift);
-	}
+	StarFieldRenderer	renderer(field, color());
+	renderer(image, shift, _stretch);
+}
+
+/**
+ * \brief Counter based random number generator
+ *
+ * Each value only depends on its index, so noise can be generated for
+ * all pixels independently, in parallel and in vectorized loops.
+ */
+static inline uint64_t	splitmix64(uint64_t x) {
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+/**
+ * \brief Uniformly distributed random number in the interval (0,1]
+ */
+static inline double	uniform(uint64_t x) {
+	return ((splitmix64(x) >> 11) + 1) * (1. / 9007199254740992.);
 }
 
 /**
  * \brief Add noise to the image
  *
+ * The noise is normally distributed with mean 0.4 * noise() and standard
+ * deviation 0.1 * noise() / sqrt(2). The normal values are computed in
+ * pairs using the Box-Muller transform.
+ *
  * \param image		the image to be modified with noise
  */
 void	StarCameraBase::addnoise(Image<double>& image) const {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "adding noise %f", _noise);
 	int	width = image.size().width();
 	int	height = image.size().height();
-	for (int x = 0; x < width; x++) {
-		for (int y = 0; y < height; y++) {
-			double	n = noisevalue();
-			image.pixel(x, y) = image.pixel(x, y) + n;
+	double	mean = 0.4 * _noise;
+	double	sigma = 0.1 * _noise / M_SQRT2;
+	// a new seed for every image, derived from the random generator
+	// that is also used for the star field and the hot pixels
+	uint64_t	seed = ((uint64_t)random() << 31) ^ random();
+	int	pairs = (width + 1) / 2;
+#pragma omp parallel for
+	for (int y = 0; y < height; y++) {
+		double	*row = image.pixels + y * width;
+		uint64_t	base = seed + 2 * (uint64_t)y * pairs;
+		int	n = width / 2;
+#pragma omp simd
+		for (int i = 0; i < n; i++) {
+			double	r = sigma * sqrt(-2 * log(uniform(base + 2 * i)));
+			double	phi = 2 * M_PI * uniform(base + 2 * i + 1);
+			row[2 * i] += mean + r * cos(phi);
+			row[2 * i + 1] += mean + r * sin(phi);
+		}
+		if (width & 1) {
+			double	r = sigma * sqrt(-2 * log(uniform(base + 2 * n)));
+			double	phi = 2 * M_PI * uniform(base + 2 * n + 1);
+			row[width - 1] += mean + r * cos(phi);
 		}
 	}
 }
@@ -414,17 +339,13 @@ void	StarCameraBase::rescale(Image<double>& image, double scale) const {
 	int	height = image.size().height();
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "rescaling %dx%d image with scale %f",
 		width, height, scale);
-	for (int x = 0; x < width; x++) {
-		for (int y = 0; y < height; y++) {
-			double	value = scale * image.pixel(x, y);
-			if (value > scale) {
-				value = scale;
-			}
-			if (value < 0) {
-				value = 0;
-			}
-			image.pixel(x, y) = value;
-		}
+	size_t	n = image.size().getPixels();
+#pragma omp parallel for simd
+	for (size_t i = 0; i < n; i++) {
+		double	value = scale * image.pixels[i];
+		value = std::min(value, scale);
+		value = std::max(value, 0.);
+		image.pixels[i] = value;
 	}
 }
 
@@ -0,0 +1,158 @@
+/*
+ * StarFieldRenderer.cpp -- render the stars of a star field tile by tile
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <Stars.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace astro::image;
+
+namespace astro {
+
+/**
+ * \brief Table of the star profile as a function of the squared distance
+ *
+ * The table has samples entries per unit of the squared distance, and
+ * it ends with zeros, so that lookups beyond the radius of a star can
+ * be clamped to the end of the table instead of being tested. The AIRY
+ * profile is not continuous at the center, so the first entry holds the
+ * limit for r -> 0+, interpolating towards the peak value at r = 0
+ * would make pixels near the center much too bright.
+ */
+const std::vector<float>&	StarFieldRenderer::profile() {
+	static std::vector<float>	table = []() {
+		int	n = Star::maxradius * Star::maxradius * samples + 1;
+		std::vector<float>	t(n + 2, 0.f);
+		t[0] = Star::profile(1e-6);
+		for (int i = 1; i < n; i++) {
+			t[i] = Star::profile(sqrt(i / (double)samples));
+		}
+		return t;
+	}();
+	return table;
+}
+
+/**
+ * \brief Collect the stars of a star field with their peak values
+ *
+ * \param field		the star field, only stars are rendered
+ * \param color		0 for the intensity, 1, 2 or 3 for the red, green
+ *			or blue channel
+ */
+StarFieldRenderer::StarFieldRenderer(const StarField& field, int color) {
+	_stars.reserve(field.nObjects());
+	for (size_t i = 0; i < field.nObjects(); i++) {
+		StellarObjectPtr	object = field[i];
+		Star	*star = dynamic_cast<Star *>(&*object);
+		if (NULL == star) {
+			continue;
+		}
+		// the peak value of a star of magnitude m
+		double	peak = star->intensity(star->position());
+		switch (color) {
+		case 0:
+			break;
+		case 1:
+			peak *= star->color().R;
+			break;
+		case 2:
+			peak *= star->color().G;
+			break;
+		case 3:
+			peak *= star->color().B;
+			break;
+		default:
+			peak = 0;
+			break;
+		}
+		if (peak == 0) {
+			continue;
+		}
+		placedstar	s;
+		s.x = star->position().x();
+		s.y = star->position().y();
+		s.peak = peak;
+		_stars.push_back(s);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%lu stars to render", _stars.size());
+}
+
+/**
+ * \brief Add the star intensities to an image
+ *
+ * \param image		the image to add the stars to
+ * \param shift		star field coordinates of the pixel (0,0)
+ * \param scale		factor to apply to all intensities
+ */
+void	StarFieldRenderer::operator()(Image<double>& image, const Point& shift,
+		double scale) const {
+	int	w = image.size().width();
+	int	h = image.size().height();
+	int	ntx = (w + tilesize - 1) / tilesize;
+	int	nty = (h + tilesize - 1) / tilesize;
+	const double	R = Star::maxradius;
+
+	// sort the stars into the tiles touched by their disk
+	std::vector<std::vector<unsigned int> >	tiles(ntx * nty);
+	for (unsigned int i = 0; i < _stars.size(); i++) {
+		double	x = _stars[i].x - shift.x();
+		double	y = _stars[i].y - shift.y();
+		if ((x + R < 0) || (x - R >= w) || (y + R < 0) || (y - R >= h)) {
+			continue;
+		}
+		int	tx0 = std::max(0, (int)floor(x - R)) / tilesize;
+		int	tx1 = std::min(w - 1, (int)ceil(x + R)) / tilesize;
+		int	ty0 = std::max(0, (int)floor(y - R)) / tilesize;
+		int	ty1 = std::min(h - 1, (int)ceil(y + R)) / tilesize;
+		for (int ty = ty0; ty <= ty1; ty++) {
+			for (int tx = tx0; tx <= tx1; tx++) {
+				tiles[ty * ntx + tx].push_back(i);
+			}
+		}
+	}
+
+	// render the tiles in parallel
+	const float	*table = profile().data();
+	const double	limit = R * R;
+	const double	center = Star::profile(0);
+	int	ntiles = ntx * nty;
+#pragma omp parallel for schedule(dynamic)
+	for (int t = 0; t < ntiles; t++) {
+		int	xlo = (t % ntx) * tilesize;
+		int	ylo = (t / ntx) * tilesize;
+		int	xhi = std::min(w, xlo + tilesize);
+		int	yhi = std::min(h, ylo + tilesize);
+		for (auto i = tiles[t].begin(); i != tiles[t].end(); i++) {
+			const placedstar&	s = _stars[*i];
+			double	x = s.x - shift.x();
+			double	y = s.y - shift.y();
+			double	peak = scale * s.peak;
+			int	x0 = std::max(xlo, (int)floor(x - R));
+			int	x1 = std::min(xhi, (int)ceil(x + R) + 1);
+			int	y0 = std::max(ylo, (int)floor(y - R));
+			int	y1 = std::min(yhi, (int)ceil(y + R) + 1);
+			for (int yy = y0; yy < y1; yy++) {
+				double	dy2 = (yy - y) * (yy - y);
+				double	*row = image.pixels + yy * w;
+#pragma omp simd
+				for (int xx = x0; xx < x1; xx++) {
+					// pixels outside the disk end up in the
+					// zeros at the end of the table
+					double	d2 = std::min(dy2 + (xx - x) * (xx - x),
+							limit + 1. / samples);
+					double	u = d2 * samples;
+					int	k = u;
+					double	f = u - k;
+					double	v = (1 - f) * table[k]
+							+ f * table[k + 1];
+					// only the exact center has the peak value
+					row[xx] += peak * ((d2 == 0) ? center : v);
+				}
+			}
+		}
+	}
+}
+
+} // namespace astro
@@ -78,10 +78,18 @@ Star::~Star() {
 double	Star::intensity(const Point& where) const {
 	double	d = distance(where);
 	// short circuit far away points to improve speed
-	if (d > 30) {
+	if (d > maxradius) {
 		return 0;
 	}
-	double	r = distance(where);
+	return _peak * profile(d);
+}
+
+/**
+ * \brief Intensity distribution of a star of peak value 1
+ *
+ * \param r	distance from the center of the star in pixels
+ */
+double	Star::profile(double r) {
 #ifdef AIRY
 #define	AIRY_RADIUS	1.5
 static const double	vpeak = (0.5 / AIRY_RADIUS);
@@ -94,7 +102,7 @@ static const double	vpeak = (0.5 / AIRY_RADIUS);
 #define	AIRY_RADIUS	2.0
 	v = exp(-sqr(r) / sqr(AIRY_RADIUS));
 #endif
-	return _peak * v;
+	return v;
 }
 
 /**
@@ -11,6 +11,7 @@
 #include <AstroCamera.h>
 #include <AstroIO.h>
 #include <set>
+#include <vector>
 
 namespace astro {
 
@@ -60,6 +61,8 @@ public:
 	void	magnitude(const double& magnitude);
 	virtual double intensity(const Point& where) const;
 	virtual std::string	toString() const;
+	static const int	maxradius = 30;
+	static double	profile(double r);
 };
 
 /**
@@ -118,6 +121,33 @@ public:
 	void	transform(const image::transform::Transform& transform);
 };
 
+/**
+ * \brief Render the stars of a star field tile by tile
+ *
+ * A star only contributes to pixels closer than Star::maxradius, so the
+ * stars are first sorted into the tiles touched by their disk. Each tile
+ * then only looks at its own stars, and the tiles can be rendered in
+ * parallel without any locking. The star profile is tabulated as a
+ * function of the squared distance, so no square roots or Bessel
+ * functions have to be evaluated per pixel.
+ */
+class StarFieldRenderer {
+	typedef struct {
+		double	x;
+		double	y;
+		double	peak;
+	} placedstar;
+	std::vector<placedstar>	_stars;
+	static const std::vector<float>&	profile();
+public:
+	static const int	tilesize = 64;
+	static const int	samples = 16;
+	StarFieldRenderer(const StarField& field, int color);
+	size_t	nstars() const { return _stars.size(); }
+	void	operator()(Image<double>& image, const Point& shift,
+			double scale = 1) const;
+};
+
 /**
  * \brief Base class for the star camera
  * 
@@ -190,7 +220,6 @@ protected:
 	void	addhot(Image<double>& image, double hotvalue) const;
 	void	rescale(Image<double>& image, double scale) const;
 	void	bin(Image<double>& image) const;
-	double	noisevalue() const;
 	std::set<ImagePoint>	hotpixels;
 public:
 	StarCameraBase(const ImageRectangle& rectangle, const ImageSize& totalsize);
@@ -254,9 +283,6 @@ public:
 
 	// imaging operator
 private:
-	void	addStarIntensity(Image<double>& image,
-			StellarObjectPtr star, Point shift) const;
-
 	void	addStarIntensities(Image<double>& image,
 			const StarField& field,
 			const Point& shift) const;
@@ -285,11 +311,19 @@ class StarCamera : public StarCameraBase {
 public:
 	StarCamera(const ImageRectangle& rectangle, const ImageSize& totalsize)
 		: StarCameraBase(rectangle, totalsize) { }
-	ImagePtr	operator()(StarField& field);
+	ImagePtr	operator()(StarField& field,
+			camera::ImageBufferPool *pool = NULL);
 };
 
+/**
+ * \brief Compute the image of a star field
+ *
+ * \param field	the star field to image
+ * \param pool		if not NULL, the pool to take the image buffer from
+ */
 template<typename P>
-ImagePtr	StarCamera<P>::operator()(StarField& field) {
+ImagePtr	StarCamera<P>::operator()(StarField& field,
+			camera::ImageBufferPool *pool) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "apply camera to field");
 //	try {
 //		debug(LOG_DEBUG, DEBUG_LOG, 0, "imaging star field %s",
@@ -318,15 +352,18 @@ ImagePtr	StarCamera<P>::operator()(StarField& field) {
 	// now convert the image into an image of the right pixel type
 	// create the image
 	ImageSize	size = rectangle().size() / binning();
-	Image<P>	*image = new Image<P>(size);
+	std::shared_ptr<Image<P> >	image = (pool)
+		? pool->image<P>(size)
+		: std::shared_ptr<Image<P> >(new Image<P>(size));
 
 	// fill in the data
 	int	width = size.width();
 	int	height = size.height();
 	int	deltax = binning().x();
 	int	deltay = binning().y();
-	for (int x = 0; x < width; x++) {
-		for (int y = 0; y < height; y++) {
+#pragma omp parallel for
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
 			double	v = rawimage->pixel(x * deltax, y * deltay);
 			image->pixel(x, y) = v;
 		}
@@ -336,7 +373,7 @@ ImagePtr	StarCamera<P>::operator()(StarField& field) {
 	delete rawimage;
 
 	// that's the image
-	return ImagePtr(image);
+	return image;
 }
 
 } // namespace astro
@@ -10,6 +10,8 @@
 #include <cppunit/extensions/HelperMacros.h>
 #include <AstroImage.h>
 #include <AstroIO.h>
+#include <AstroUtils.h>
+#include <cmath>
 
 using namespace astro::image;
 using namespace astro::io;
@@ -22,9 +24,13 @@ public:
 	void	setUp();
 	void	tearDown();
 	void	testImage();
+	void	testRender();
+	void	testBenchmark();
 
 	CPPUNIT_TEST_SUITE(StarsTest);
 	CPPUNIT_TEST(testImage);
+	CPPUNIT_TEST(testRender);
+	CPPUNIT_TEST(testBenchmark);
 	CPPUNIT_TEST_SUITE_END();
 };
 
@@ -39,7 +45,7 @@ void	StarsTest::tearDown() {
 void	StarsTest::testImage() {
 	ImageSize	size(640, 480);
 	StarField	starfield(size, 100, 200);
-	StarCamera<unsigned char>	starcamera(size);
+	StarCamera<unsigned char>	starcamera(ImageRectangle(size), size);
 	starcamera.noise(0.05);
 	starcamera.addHotPixels(10);
 	starcamera.light(true);
@@ -49,5 +55,77 @@ void	StarsTest::testImage() {
 	out.write(image);
 }
 
+/**
+ * \brief The tiled renderer must agree with the intensity of the field
+ */
+void	StarsTest::testRender() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRender() begin");
+	ImageSize	size(200, 150);
+	StarField	starfield(size, 40, 100);
+	StarFieldRenderer	renderer(starfield, 0);
+	Image<double>	image(size);
+	image.fill(0);
+	Point	shift(3.5, -2.25);
+	renderer(image, shift);
+	double	error = 0;
+	for (int y = 0; y < size.height(); y++) {
+		for (int x = 0; x < size.width(); x++) {
+			Point	p(shift.x() + x, shift.y() + y);
+			error = std::max(error,
+				fabs(image.pixel(x, y) - starfield.intensity(p)));
+		}
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "maximum error: %g", error);
+	CPPUNIT_ASSERT(error < 1e-3);
+
+	// subpixel shifts put star centers close to pixel centers, where
+	// the profile must not be interpolated towards the central peak
+	StarField	single(size, 0, 0);
+	Star	*star = new Star(Point(100, 75), 0);
+	single.addObject(StellarObjectPtr(star));
+	StarFieldRenderer	singlerenderer(single, 0);
+	double	peak = star->intensity(star->position());
+	double	offsets[3] = { 0.05, 0.1, 0.15 };
+	for (int i = 0; i < 3; i++) {
+		image.fill(0);
+		Point	subpixel(offsets[i], -offsets[i] / 2);
+		singlerenderer(image, subpixel);
+		double	d = hypot(subpixel.x(), subpixel.y());
+		double	expected = peak * Star::profile(d);
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "d = %.3f: %g, expected %g", d,
+			image.pixel(100, 75), expected);
+		CPPUNIT_ASSERT(fabs(image.pixel(100, 75) - expected)
+			< 1e-3 * peak);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRender() end");
+}
+
+/**
+ * \brief Find the frame rate of the simulated camera
+ */
+void	StarsTest::testBenchmark() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBenchmark() begin");
+	int	sizes[3] = { 1024, 4096, 8192 };
+	int	frames[3] = { 20, 4, 1 };
+	for (int i = 0; i < 3; i++) {
+		ImageSize	size(sizes[i], sizes[i]);
+		// about one star per 1000 pixels
+		StarField	starfield(size, 100, size.getPixels() / 1000);
+		StarCamera<unsigned short>	starcamera(ImageRectangle(size),
+							size);
+		starcamera.noise(0.05);
+		starcamera.light(true);
+		Timer	timer;
+		timer.start();
+		for (int j = 0; j < frames[i]; j++) {
+			ImagePtr	image = starcamera(starfield);
+		}
+		timer.end();
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: %.2f frames/s",
+			size.toString().c_str(), frames[i] / timer.elapsed());
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBenchmark() end");
+}
+
 } // namespace test
 } // namespace astro
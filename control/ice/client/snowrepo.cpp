@@ -10,6 +10,7 @@
 #include <AstroConfig.h>
 #include <AstroFormat.h>
 #include <AstroIO.h>
+#include <fstream>
 #include <repository.h>
 #include <IceConversions.h>
 #include <RepoReplicators.h>
@@ -306,9 +307,17 @@ int	command_get(const astro::ServerName& servername,
 	// get the repo
 	RepositoryPrx	repository = getRemoteRepo(servername, reponame);
 
-	ImageBuffer	image = repository->getImage(id, ImageEncodingFITS);
-	astro::io::FITSout	out(filename);
-	out.write(convertimage(image));
+	// transfer the file in chunks, so that the size of the image is not
+	// limited by the message size
+	ImageFile	data = download(repository->openImage(id));
+	std::ofstream	out(filename, std::ios::binary);
+	out.write((const char *)data.data(), data.size());
+	if (!out) {
+		std::string	msg = astro::stringprintf("cannot write %s",
+			filename.c_str());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
 	return EXIT_SUCCESS;
 }
 
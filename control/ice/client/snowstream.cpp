@@ -19,7 +19,7 @@ namespace snowstream {
 /**
  * \brief Stream sink for this application
  */
-class StreamSink : public ImageSink {
+class StreamSink : public RawImageSink {
 	std::mutex		_mutex;
 	std::condition_variable	_condition;
 public:
@@ -38,6 +38,16 @@ public:
 			convert(entry.exposure0).toString().c_str());
 	}
 
+	void	rawimage(const RawImageQueueEntry& entry,
+			const Ice::Current& /* current */) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "new entry: %s",
+			convert(entry.exposure0).toString().c_str());
+		astro::image::ImagePtr	image = convertimage(entry);
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s image, %lu bytes on the wire",
+			image->size().toString().c_str(),
+			entry.imagedata.size());
+	}
+
 	void	wait() {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "waiting for condition");
 		std::unique_lock<std::mutex>	lock(_mutex);
@@ -206,6 +216,7 @@ int	main(int argc, char *argv[]) {
 	// register the adapter with the server
 	ccd->ice_getConnection()->setAdapter(adapter.adapter());
 	ccd->registerSink(ident);
+	negotiateStreamEncoding(ccd);
 
 	// start the stream
 	ccd->startStream(convert(exposure));
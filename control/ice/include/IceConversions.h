@@ -112,6 +112,12 @@ typedef std::shared_ptr<ImageQueueEntry>	ImageQueueEntryPtr;
 
 ImageQueueEntryPtr	convert(const astro::camera::ImageQueueEntry e);
 astro::camera::ImageQueueEntry	convert(ImageQueueEntryPtr e);
+typedef std::shared_ptr<RawImageQueueEntry>	RawImageQueueEntryPtr;
+RawImageQueueEntryPtr	convert(const astro::camera::ImageQueueEntry e,
+				StreamEncoding encoding);
+astro::image::ImagePtr	convertimage(const ImageQueueEntry& entry);
+astro::image::ImagePtr	convertimage(const RawImageQueueEntry& entry);
+StreamEncoding	negotiateStreamEncoding(CcdPrx ccd);
 
 // Cooler
 CoolerInfo	convert(const astro::camera::CoolerInfo& ci);
@@ -220,7 +226,7 @@ mountstate	string2mountstate(const std::string& s);
 // Image
 astro::image::ImagePtr	convert(ImagePrx image);
 
-astro::image::ImagePtr	convertfile(ImageFile imagefile);
+astro::image::ImagePtr	convertfile(const ImageFile& imagefile);
 ImageFile	convertfile(astro::image::ImagePtr imageptr);
 
 astro::image::Metavalue	convert(const Metavalue& metavalue);
@@ -235,6 +241,8 @@ ImageBufferPtr	convert(const astro::image::ImageBuffer& imagebuffer);
 
 astro::image::ImagePtr	convertimage(const ImageBuffer& imagebuffer);
 
+ImageFile	download(FileReaderPrx reader, int chunksize = 1 << 19);
+
 // Focusing
 FocusState	convert(astro::focusing::Focus::state_type s);
 astro::focusing::Focus::state_type	convert(FocusState s);
@@ -14,48 +14,69 @@
 namespace snowstar {
 
 /**
- * \brief Convert an Imge Proxy into an image
+ * \brief Download the contents of a file reader in chunks
+ *
+ * The result is allocated in full size before the transfer, so the
+ * chunks are copied into place only once. The reader is closed when the
+ * transfer is complete or has failed.
+ *
+ * \param reader	the reader proxy returned by the server
+ * \param chunksize	number of bytes to request in one call, must stay
+ *			below the message size limit of the communicator
  */
-astro::image::ImagePtr	convert(ImagePrx image) {
-	// get the image data from the server
-	ImageBuffer	file = image->file(ImageEncodingFITS);
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "got image of size %d", file.data.size());
-
-	// construct a temporary file name
-	char	buffer[1024];
-	if (getenv("TMPDIR")) {
-		snprintf(buffer, sizeof(buffer), "%s/convert-XXXXXX.fits",
-			getenv("TMPDIR"));
-	} else {
-		strcpy(buffer, "/tmp/convert-XXXXXX.fits");
-	}
-	int	fd = mkstemps(buffer, 5);
-	if (fd < 0) {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "cannot create temp file: %s",
-			strerror(errno));
-		throw std::runtime_error("cannot create tmp file name");
+ImageFile	download(FileReaderPrx reader, int chunksize) {
+	ImageFile	result;
+	try {
+		Ice::Long	size = reader->size();
+		result.resize(size);
+		Ice::Long	offset = 0;
+		while (offset < size) {
+			ImageFile	chunk = reader->read(offset, chunksize);
+			if (chunk.size() == 0) {
+				std::string	msg = astro::stringprintf(
+					"file truncated at %lld of %lld bytes",
+					(long long)offset, (long long)size);
+				debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+				throw std::runtime_error(msg);
+			}
+			std::copy(chunk.begin(), chunk.end(),
+				result.begin() + offset);
+			offset += chunk.size();
+		}
+	} catch (...) {
+		try {
+			reader->close();
+		} catch (...) {
+		}
+		throw;
 	}
-	std::string	filename(buffer);
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "temporary image file: %s", buffer);
+	reader->close();
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "downloaded %lu bytes", result.size());
+	return result;
+}
 
-	int	s = file.data.size();
-	if (s != write(fd, file.data.data(), s)) {
-		debug(LOG_ERR, DEBUG_LOG, 0, "writing temp file failed: %s",
-			strerror(errno));
-		close(fd);
+/**
+ * \brief Convert an Imge Proxy into an image
+ */
+astro::image::ImagePtr	convert(ImagePrx image) {
+	// get the image data from the server, in chunks if the server
+	// supports it
+	ImageFile	data;
+	try {
+		data = download(image->openFile(ImageEncodingFITS));
+	} catch (const Ice::OperationNotExistException& x) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "server cannot open files");
+		data = image->file(ImageEncodingFITS).data;
 	}
-	close(fd);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "got image of size %d", data.size());
 
-	// use FITS classes to read the temporary file
-	astro::io::FITSin	in(filename);
+	// decode the FITS data directly from the buffer
+	astro::io::FITSin	in(data.data(), data.size());
 	astro::image::ImagePtr	result = in.read();
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "got an %s image with pixel type %s",
 		result->size().toString().c_str(),
 		astro::demangle(result->pixel_type().name()).c_str());
 
-	// unlink the temporary file
-	unlink(filename.c_str());
-
 	// return the image we just read
 	return result;
 }
@@ -112,69 +133,21 @@ unsigned short	UnsignedShortAdapter<Pixel>::pixel(int x, int y) const {
 	return value;
 }
 
-/**
- * \brief auxiliary function ot create a temporary file
- */
-static std::string	tempfilename() {
-	const char	*tmpdir = "/tmp";
-	if (NULL != getenv("TMPDIR")) {
-		tmpdir = getenv("TMPDIR");
-	}
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "temp an image");
-	char    buffer[1024];
-	snprintf(buffer, sizeof(buffer), "%s/XXXXXXXX.fits", tmpdir);
-	int	fd = mkstemps(buffer, 5);
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "image file name: %s", buffer);
-	unlink(buffer);
-	close(fd);
-
-	return std::string(buffer);
-}
-
 /**
  * \brief Convert an ImageFile buffer to an ImagePtr
+ *
+ * The FITS data is decoded directly from the buffer using a cfitsio
+ * memory file, this avoids the temporary file round trip which used
+ * to dominate the latency of image streams.
  */
-astro::image::ImagePtr  convertfile(ImageFile imagefile) {
+astro::image::ImagePtr  convertfile(const ImageFile& imagefile) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "imagefile has size %d",
 		imagefile.size());
 
 	// here is the result image we would like to return
 	astro::image::ImagePtr	result;
-
-	// generate a temporary file name
-	const char	*tmpdir = "/tmp";
-	if (NULL != getenv("TMPDIR")) {
-		tmpdir = getenv("TMPDIR");
-	}
-	char    buffer[1024];
-	snprintf(buffer, sizeof(buffer), "%s/XXXXXXXX.fits", tmpdir);
-	int	fd = mkstemps(buffer, 5);
-	if (fd < 0) {
-		std::string	msg = astro::stringprintf("cannot "
-			"create temporary file: %s", strerror(errno));
-		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
-		throw std::runtime_error(msg);
-	}
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "image file name: %s", buffer);
-	std::string	filename(buffer);
-
 	try {
-		// write the image data to a temporary file
-		ssize_t	l = write(fd, imagefile.data(), imagefile.size());
-		if (l < 0) {
-			std::string	msg = astro::stringprintf("could not "
-				"write data: %s", strerror(errno));
-			close(fd);
-			throw std::runtime_error(msg);
-		}
-		close(fd);
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "bytes written: %d", l);
-		if ((ssize_t)imagefile.size() != l) {
-			throw std::runtime_error("failed to write image");
-		}
-
-		// read the image
-		astro::io::FITSin	in(filename);
+		astro::io::FITSin	in(imagefile.data(), imagefile.size());
 		result = in.read();
 	} catch (const std::exception& x) {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "failed to convert: %s (%s)",
@@ -183,9 +156,6 @@ astro::image::ImagePtr  convertfile(ImageFile imagefile) {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "exception during conversion");
 	}
 
-	// unlink the temporary file
-	unlink(filename.c_str());
-
 	// throw an exception if the image is NULL
 	if (NULL == result) {
 		throw std::runtime_error("cannot convert image");
@@ -194,68 +164,42 @@ astro::image::ImagePtr  convertfile(ImageFile imagefile) {
 }
 
 /**
- * \brief Convert an ImagePtr into an ImageFile
+ * \brief Convert an ImagePtr into an ImageFile
+ *
+ * The image is written to a cfitsio memory file, which is then copied
+ * into the ImageFile sequence.
  */
 ImageFile       convertfile(astro::image::ImagePtr imageptr) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "convert image of size %dx%d",
 		imageptr->size().width(), imageptr->size().height());
-	// generate a temporary file name
-	std::string	filename = tempfilename();
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "tempfile: %s", filename.c_str());
 
-	// write the image to a temporary file
+	// write the image to a memory buffer
+	void	*buffer = NULL;
+	size_t	buffersize = 0;
 	try {
-		astro::io::FITSout	out(filename);
-		out.setPrecious(false);
+		astro::io::FITSout	out(&buffer, &buffersize);
 		out.write(imageptr);
 	} catch (const std::exception& x) {
 		debug(LOG_ERR, DEBUG_LOG, 0, "cannot write image: %s",
 			x.what());
 		throw;
 	}
-
-	// find out how large the image is
-	struct stat	sb;
-	int	rc = stat(filename.c_str(), &sb);
-	if (rc < 0) {
-		throw NotFound("cannot stat temp image");
-	}
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "image file has size %d", sb.st_size);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "image file has size %lu", buffersize);
 
 	// empty image
-	if (0 == sb.st_size) {
+	if (0 == buffersize) {
+		if (buffer) {
+			free(buffer);
+		}
 		return ImageFile();
 	}
 
-	// read the image into a buffer
-	int	fd = open(filename.c_str(), O_RDONLY);
-	if (fd < 0) {
-		throw NotFound("temporary file disappeared");
-	}
-
-	unsigned char	*buffer = new unsigned char[sb.st_size];
-	if (sb.st_size != read(fd, buffer, sb.st_size)) {
-		delete[] buffer;
-		close(fd);
-		std::string	msg = astro::stringprintf("cannt read file %s in full length %ld", filename.c_str(), sb.st_size);
-		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
-		throw BadParameter(msg);
-	}
-	close(fd);
-
 	// create an image file object
-	ImageFile	result(sb.st_size);
-	for (int i = 0; i < sb.st_size; i++) {
-		result[i] = buffer[i];
-	}
+	Ice::Byte	*data = (Ice::Byte *)buffer;
+	ImageFile	result(data, data + buffersize);
 
 	// clean up memory
-	delete[] buffer;
-
-	// unlink the image
-	unlink(filename.c_str());
-
-	// read the image into a 
+	free(buffer);
 	return result;
 }
 
@@ -310,13 +254,18 @@ ImageBufferPtr	convert(const astro::image::ImageBuffer& imagebuffer) {
 	result->encoding = convert(imagebuffer.type());
 
 	Ice::Byte	*data = (Ice::Byte *)imagebuffer.data();
-	std::copy(data, data + imagebuffer.size(),
-		std::back_inserter(result->data));
+	result->data.assign(data, data + imagebuffer.size());
 	
 	return ImageBufferPtr(result);
 }
 
 astro::image::ImagePtr  convertimage(const ImageBuffer& imagebuffer) {
+	// FITS data can be decoded in place, without copying the buffer
+	if (ImageEncodingFITS == imagebuffer.encoding) {
+		astro::io::FITSin	in(imagebuffer.data.data(),
+						imagebuffer.data.size());
+		return in.read();
+	}
 	astro::image::ImageBufferPtr	ib = convert(imagebuffer);
 	return ib->image();
 }
@@ -0,0 +1,319 @@
+/*
+ * StreamConversions.cpp -- conversions of stream image queue entries
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <IceConversions.h>
+#include <AstroIO.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <AstroUtils.h>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+namespace snowstar {
+
+/**
+ * \brief Find out whether this host stores values big endian
+ */
+static bool	hostbigendian() {
+	const uint16_t	one = 1;
+	return 0 == *(const unsigned char *)&one;
+}
+
+/**
+ * \brief Copy pixel values into the image data as Wire values
+ *
+ * If the pixel value type has the width of the wire type, the array is
+ * copied unchanged, otherwise each value is converted.
+ */
+template<typename Element, typename Wire>
+static void	encodeelements(const Element *values, size_t n,
+			ImageFile& data) {
+	data.resize(n * sizeof(Wire));
+	if (sizeof(Element) == sizeof(Wire)) {
+		memcpy(data.data(), values, data.size());
+		return;
+	}
+	Ice::Byte	*p = data.data();
+	for (size_t i = 0; i < n; i++, p += sizeof(Wire)) {
+		Wire	w = (Wire)values[i];
+		memcpy(p, &w, sizeof(Wire));
+	}
+}
+
+/**
+ * \brief Read Wire values from the image data into pixel values
+ *
+ * Values are byte swapped if the sender had a different byte order.
+ */
+template<typename Element, typename Wire>
+static void	decodeelements(const ImageFile& data, bool bigendian,
+			Element *values, size_t n) {
+	if (data.size() != n * sizeof(Wire)) {
+		std::string	msg = astro::stringprintf("raw image data has "
+			"%lu bytes, %lu expected", data.size(),
+			n * sizeof(Wire));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	bool	swap = (bigendian != hostbigendian());
+	if ((!swap) && (sizeof(Element) == sizeof(Wire))) {
+		memcpy(values, data.data(), data.size());
+		return;
+	}
+	const Ice::Byte	*p = data.data();
+	Ice::Byte	b[sizeof(Wire)];
+	for (size_t i = 0; i < n; i++, p += sizeof(Wire)) {
+		if (swap) {
+			std::reverse_copy(p, p + sizeof(Wire), b);
+		} else {
+			memcpy(b, p, sizeof(Wire));
+		}
+		Wire	w;
+		memcpy(&w, b, sizeof(Wire));
+		values[i] = (Element)w;
+	}
+}
+
+/**
+ * \brief Copy the pixel array of an image into the image data of an entry
+ *
+ * Pixel values are sent with the width of the Wire type in host byte
+ * order, the header tells the receiver which byte order that is. 16 bit
+ * pixel arrays are Rice compressed if the encoding asks for it, the
+ * compressed stream does not depend on the byte order.
+ */
+template<typename Pixel, typename Element, typename Wire>
+static void	rawpixels(const astro::image::Image<Pixel> *image,
+			RawPixelType pixeltype, int planes,
+			StreamEncoding encoding, RawImageQueueEntry& entry) {
+	entry.header.pixeltype = pixeltype;
+	entry.header.planes = planes;
+	entry.header.bigendian = hostbigendian();
+	size_t	n = image->size().getPixels() * planes;
+	const Element	*values = (const Element *)image->pixels;
+	if ((encoding == StreamEncodingRawRice)
+		&& (pixeltype == RawPixelUInt16)
+		&& (sizeof(Element) == sizeof(uint16_t))) {
+		entry.header.compression = RawCompressionRice;
+		astro::io::RiceCoder	coder;
+		entry.imagedata.clear();
+		entry.imagedata.reserve(n * sizeof(uint16_t));
+		coder.encode((const unsigned short *)values, n,
+			entry.imagedata);
+		return;
+	}
+	entry.header.compression = RawCompressionNone;
+	encodeelements<Element, Wire>(values, n, entry.imagedata);
+}
+
+#define	raw_typed(Element, Wire, pixeltype)				\
+{									\
+	const astro::image::Image<Element >	*imagep			\
+		= dynamic_cast<const astro::image::Image<Element > *>(&*image);\
+	if (NULL != imagep) {						\
+		rawpixels<Element, Element, Wire>(imagep, pixeltype, 1,	\
+			encoding, entry);				\
+		return true;						\
+	}								\
+	const astro::image::Image<astro::image::RGB<Element > >	*rgbp	\
+		= dynamic_cast<const astro::image::Image<		\
+			astro::image::RGB<Element > > *>(&*image);	\
+	if (NULL != rgbp) {						\
+		rawpixels<astro::image::RGB<Element >, Element, Wire>(	\
+			rgbp, pixeltype, 3, encoding, entry);		\
+		return true;						\
+	}								\
+}
+
+/**
+ * \brief Fill the raw header and pixel data of an entry
+ *
+ * \return false if the pixel type of the image cannot be sent raw
+ */
+static bool	rawentry(astro::image::ImagePtr image,
+			StreamEncoding encoding, RawImageQueueEntry& entry) {
+	entry.header.size = convert(image->size());
+	entry.header.origin = convert(image->origin());
+	entry.header.mosaic = (std::string)image->getMosaicType();
+	entry.header.metadata.clear();
+	astro::image::ImageMetadata::const_iterator	i;
+	for (i = image->begin(); i != image->end(); i++) {
+		entry.header.metadata.push_back(convert(i->second));
+	}
+	raw_typed(unsigned short, uint16_t, RawPixelUInt16);
+	raw_typed(unsigned char, uint8_t, RawPixelUInt8);
+	raw_typed(unsigned int, uint32_t, RawPixelUInt32);
+	raw_typed(unsigned long, uint64_t, RawPixelUInt64);
+	raw_typed(float, float, RawPixelFloat32);
+	raw_typed(double, double, RawPixelFloat64);
+	return false;
+}
+
+/**
+ * \brief Header used for FITS encoded entries
+ */
+static RawImageHeader	emptyheader() {
+	RawImageHeader	header;
+	header.pixeltype = RawPixelUInt16;
+	header.bigendian = hostbigendian();
+	header.planes = 0;
+	header.compression = RawCompressionNone;
+	return header;
+}
+
+/**
+ * \brief Convert a camera image queue entry using a stream encoding
+ *
+ * Images with pixel types that have no raw representation (e.g. YUYV)
+ * are always sent as FITS files.
+ */
+RawImageQueueEntryPtr	convert(const astro::camera::ImageQueueEntry e,
+				StreamEncoding encoding) {
+	RawImageQueueEntryPtr	result(new RawImageQueueEntry());
+	result->exposure0 = convert(e.exposure);
+	result->header = emptyheader();
+	if (encoding != StreamEncodingFITS) {
+		if (rawentry(e.image, encoding, *result)) {
+			result->encoding = encoding;
+			return result;
+		}
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "no raw encoding for %s, "
+			"using FITS",
+			astro::demangle(e.image->pixel_type().name()).c_str());
+		result->header = emptyheader();
+	}
+	result->encoding = StreamEncodingFITS;
+	result->imagedata = convertfile(e.image);
+	return result;
+}
+
+/**
+ * \brief Construct an image from raw pixel data
+ */
+template<typename Pixel, typename Element, typename Wire>
+static astro::image::ImagePtr	rawimage(const RawImageQueueEntry& entry) {
+	astro::image::ImageSize	size = convert(entry.header.size);
+	astro::image::Image<Pixel>	*image
+		= new astro::image::Image<Pixel>(size);
+	astro::image::ImagePtr	result(image);
+	size_t	n = size.getPixels() * entry.header.planes;
+	Element	*values = (Element *)image->pixels;
+	if (entry.header.compression == RawCompressionRice) {
+		if ((entry.header.pixeltype != RawPixelUInt16)
+			|| (sizeof(Element) != sizeof(uint16_t))) {
+			std::string	msg("Rice compression requires 16 bit "
+				"pixels");
+			debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+			throw std::runtime_error(msg);
+		}
+		astro::io::RiceCoder	coder;
+		coder.decode(entry.imagedata.data(), entry.imagedata.size(),
+			(unsigned short *)values, n);
+	} else {
+		decodeelements<Element, Wire>(entry.imagedata,
+			entry.header.bigendian, values, n);
+	}
+	return result;
+}
+
+#define	rawimage_typed(Element, Wire)					\
+	if (entry.header.planes == 1) {					\
+		result = rawimage<Element, Element, Wire>(entry);	\
+	} else if (entry.header.planes == 3) {				\
+		result = rawimage<astro::image::RGB<Element >, Element,	\
+			Wire>(entry);					\
+	}
+
+/**
+ * \brief Decode the image contained in an image queue entry
+ */
+astro::image::ImagePtr	convertimage(const ImageQueueEntry& entry) {
+	return convertfile(entry.imagedata);
+}
+
+/**
+ * \brief Decode the image contained in a raw image queue entry
+ *
+ * This works for all stream encodings, so clients need not care which
+ * encoding was negotiated with the server.
+ */
+astro::image::ImagePtr	convertimage(const RawImageQueueEntry& entry) {
+	if (entry.encoding == StreamEncodingFITS) {
+		astro::io::FITSin	in(entry.imagedata.data(),
+						entry.imagedata.size());
+		return in.read();
+	}
+	astro::image::ImagePtr	result;
+	switch (entry.header.pixeltype) {
+	case RawPixelUInt8:
+		rawimage_typed(unsigned char, uint8_t);
+		break;
+	case RawPixelUInt16:
+		rawimage_typed(unsigned short, uint16_t);
+		break;
+	case RawPixelUInt32:
+		rawimage_typed(unsigned int, uint32_t);
+		break;
+	case RawPixelUInt64:
+		rawimage_typed(unsigned long, uint64_t);
+		break;
+	case RawPixelFloat32:
+		rawimage_typed(float, float);
+		break;
+	case RawPixelFloat64:
+		rawimage_typed(double, double);
+		break;
+	}
+	if (!result) {
+		std::string	msg = astro::stringprintf("cannot decode raw "
+			"image with %d planes", entry.header.planes);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	result->setOrigin(convert(entry.header.origin));
+	if (entry.header.mosaic.size() > 0) {
+		result->setMosaicType(entry.header.mosaic);
+	}
+	Metadata::const_iterator	i;
+	for (i = entry.header.metadata.begin();
+		i != entry.header.metadata.end(); i++) {
+		result->setMetadata(convert(*i));
+	}
+	return result;
+}
+
+/**
+ * \brief Negotiate the best stream encoding the server supports
+ *
+ * Servers that predate the raw encodings don't know the streamEncodings
+ * method, for them we stay with FITS. The sink registered by the client
+ * must be a RawImageSink.
+ */
+StreamEncoding	negotiateStreamEncoding(CcdPrx ccd) {
+	StreamEncoding	encoding = StreamEncodingFITS;
+	try {
+		StreamEncodingList	encodings = ccd->streamEncodings();
+		StreamEncodingList::const_iterator	i;
+		for (i = encodings.begin(); i != encodings.end(); i++) {
+			if (*i == StreamEncodingRawRice) {
+				encoding = StreamEncodingRawRice;
+			}
+			if ((*i == StreamEncodingRaw)
+				&& (encoding == StreamEncodingFITS)) {
+				encoding = StreamEncodingRaw;
+			}
+		}
+		ccd->setStreamEncoding(encoding);
+	} catch (const std::exception& x) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "cannot negotiate encoding: %s",
+			x.what());
+		encoding = StreamEncodingFITS;
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "using stream encoding %d", encoding);
+	return encoding;
+}
+
+} // namespace snowstar
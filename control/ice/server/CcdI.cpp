@@ -317,6 +317,7 @@ void	CcdI::registerSink(const Ice::Identity& imagesinkidentity,
 			_sink = NULL;
 		}
 	}
+	// a new sink always starts with FITS, it may be a legacy ImageSink
 	CcdSink	*sink = new CcdSink(_ccd, imagesinkidentity, current);
 	_ccd->imagesink(sink);
 	_sink = CcdSinkPtr(sink);
@@ -396,6 +397,47 @@ void	CcdI::unregisterSink(const ::Ice::Current& current) {
 	_sink = NULL;
 }
 
+/**
+ * \brief Get the list of stream encodings supported by the server
+ *
+ * \param current	the current call context
+ */
+StreamEncodingList	CcdI::streamEncodings(const ::Ice::Current& current) {
+	CallStatistics::count(current);
+	StreamEncodingList	result;
+	result.push_back(StreamEncodingFITS);
+	result.push_back(StreamEncodingRaw);
+	result.push_back(StreamEncodingRawRice);
+	return result;
+}
+
+/**
+ * \brief Select the encoding for images sent to the registered sink
+ *
+ * The encoding belongs to the sink, so a sink registered later by
+ * another client again receives FITS images.
+ *
+ * \param encoding	the stream encoding to use
+ * \param current	the current call context
+ */
+void	CcdI::setStreamEncoding(StreamEncoding encoding,
+		const ::Ice::Current& current) {
+	CallStatistics::count(current);
+	switch (encoding) {
+	case StreamEncodingFITS:
+	case StreamEncodingRaw:
+	case StreamEncodingRawRice:
+		break;
+	default:
+		throw BadParameter("unknown stream encoding");
+	}
+	if (!_sink) {
+		throw BadParameter("no registered image sink");
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "stream encoding %d", encoding);
+	_sink->encoding(encoding);
+}
+
 /**
  * \brief Register a callback for state upates
  *
@@ -20,11 +20,15 @@ namespace snowstar {
  */
 class CcdSink : public astro::camera::ImageSink {
 	ImageSinkPrx	sinkprx;
+	RawImageSinkPrx	rawsinkprx;
 	astro::camera::CcdPtr	_ccd;
+	StreamEncoding	_encoding;
 public:
 	CcdSink(astro::camera::CcdPtr ccd, const Ice::Identity& identity,
 		const Ice::Current& current);
 	virtual ~CcdSink() { }
+	StreamEncoding	encoding() const { return _encoding; }
+	void	encoding(StreamEncoding e);
 	void	operator()(const astro::camera::ImageQueueEntry& entry);
 	void	stop();
 };
@@ -96,6 +100,9 @@ public:
 			const Ice::Current& current);
 	void	stopStream(const ::Ice::Current& current);
 	void	unregisterSink(const ::Ice::Current& current);
+	StreamEncodingList	streamEncodings(const ::Ice::Current& current);
+	void	setStreamEncoding(StreamEncoding encoding,
+			const ::Ice::Current& current);
 
 	bool	isControllable(const ::Ice::Current& current);
 };
@@ -17,7 +17,8 @@ namespace snowstar {
  * to the client
  */
 CcdSink::CcdSink(astro::camera::CcdPtr ccd, const Ice::Identity& identity,
-		const Ice::Current& current) : _ccd(ccd) {
+		const Ice::Current& current) : _ccd(ccd),
+		_encoding(StreamEncodingFITS) {
 	std::string	is = identity.name + "@" + identity.category;
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "construct a CcdSink: %s", is.c_str());
 	Ice::ObjectPrx	oneway = current.con->createProxy(identity)
@@ -27,30 +28,58 @@ CcdSink::CcdSink(astro::camera::CcdPtr ccd, const Ice::Identity& identity,
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "cast completed");
 }
 
+/**
+ * \brief Set the stream encoding
+ *
+ * Clients only select a raw encoding if their sink is a RawImageSink,
+ * so the proxy can be cast without asking the client.
+ */
+void	CcdSink::encoding(StreamEncoding e) {
+	_encoding = e;
+	if ((_encoding != StreamEncodingFITS) && (sinkprx)) {
+		rawsinkprx = RawImageSinkPrx::uncheckedCast(sinkprx);
+	} else {
+		rawsinkprx = NULL;
+	}
+}
+
 /**
  * \brief Image sink main method
  *
  * The operator() implementation absorbs ImageQueueEntries from the camera
  * converts them to ImageQueueEntries for the ICE protocol and sends them
- * to the client.
+ * to the client. With a raw encoding, RawImageQueueEntries are sent
+ * to the rawimage method of the sink instead.
  */
 void	CcdSink::operator()(const astro::camera::ImageQueueEntry& entry) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "operator()(ImageQueueEntry&) called");
 	// don't do anything if we have no proxy (this should not happen,
 	// we play safe here)
 	if (sinkprx) {
-		ImageQueueEntryPtr	e = convert(entry);
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "image: %s, size = %ld",
-			entry.exposure.toString().c_str(),
-			e->imagedata.size());
 		try {
-			sinkprx->image(*e);
+			if (rawsinkprx) {
+				RawImageQueueEntryPtr	e
+					= convert(entry, _encoding);
+				debug(LOG_DEBUG, DEBUG_LOG, 0, "image: %s, "
+					"encoding = %d, size = %ld",
+					entry.exposure.toString().c_str(),
+					e->encoding, e->imagedata.size());
+				rawsinkprx->rawimage(*e);
+			} else {
+				ImageQueueEntryPtr	e = convert(entry);
+				debug(LOG_DEBUG, DEBUG_LOG, 0, "image: %s, "
+					"size = %ld",
+					entry.exposure.toString().c_str(),
+					e->imagedata.size());
+				sinkprx->image(*e);
+			}
 		} catch (const std::exception& x) {
 			debug(LOG_DEBUG, DEBUG_LOG, 0,
 				"cannot send image: %s %s",
 				astro::demangle_string(x).c_str(),
 				x.what());
 			sinkprx = NULL;
+			rawsinkprx = NULL;
 		}
 	} else {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "ImageQueueEntry: sink stalled");
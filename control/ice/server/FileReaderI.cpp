@@ -0,0 +1,305 @@
+/*
+ * FileReaderI.cpp -- chunked transfer of image files
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <FileReaderI.h>
+#include <IceConversions.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <AstroAdapter.h>
+#include <AstroImageops.h>
+#include <Ice/ObjectAdapter.h>
+#include <includes.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+
+namespace snowstar {
+
+/**
+ * \brief Seconds after which an unused reader is closed by the server
+ */
+#define	READER_TIMEOUT	600
+
+/**
+ * \brief Seconds between two sweeps for unused readers
+ */
+#define	READER_SWEEP_INTERVAL	60
+
+/**
+ * \brief Registry of the open readers
+ *
+ * The registry remembers when each reader was last used. A thread,
+ * started with the first reader, removes readers that have not been
+ * used for READER_TIMEOUT seconds, most likely because the client
+ * went away, so their mappings are released even if no other reader
+ * is ever opened.
+ */
+class ReaderRegistry {
+	std::mutex	_mutex;
+	std::condition_variable	_cond;
+	std::map<Ice::Identity, time_t>	_readers;
+	Ice::ObjectAdapterPtr	_adapter;
+	bool	_terminate;
+	std::thread	_thread;
+	void	remove(const Ice::Identity& identity);
+	void	sweep();
+	void	run();
+public:
+	ReaderRegistry() : _terminate(false) { }
+	~ReaderRegistry();
+	FileReaderPrx	add(Ice::ObjectPtr reader, const Ice::Current& current);
+	void	used(const Ice::Identity& identity);
+	void	close(const Ice::Identity& identity);
+};
+
+static ReaderRegistry	readers;
+
+ReaderRegistry::~ReaderRegistry() {
+	{
+		std::unique_lock<std::mutex>	lock(_mutex);
+		_terminate = true;
+		_cond.notify_all();
+	}
+	if (_thread.joinable()) {
+		_thread.join();
+	}
+}
+
+/**
+ * \brief Remove a servant from the adapter, the lock must be held
+ */
+void	ReaderRegistry::remove(const Ice::Identity& identity) {
+	_readers.erase(identity);
+	try {
+		_adapter->remove(identity);
+	} catch (const Ice::NotRegisteredException& x) {
+		debug(LOG_WARNING, DEBUG_LOG, 0, "reader already removed");
+	} catch (const Ice::Exception& x) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "cannot remove reader: %s",
+			x.what());
+	}
+}
+
+/**
+ * \brief Remove the readers not used recently, the lock must be held
+ */
+void	ReaderRegistry::sweep() {
+	time_t	now;
+	time(&now);
+	auto	i = _readers.begin();
+	while (i != _readers.end()) {
+		if ((now - i->second) > READER_TIMEOUT) {
+			debug(LOG_DEBUG, DEBUG_LOG, 0, "closing unused reader");
+			Ice::Identity	identity = (i++)->first;
+			remove(identity);
+		} else {
+			i++;
+		}
+	}
+}
+
+/**
+ * \brief Sweep the registry periodically until the server terminates
+ */
+void	ReaderRegistry::run() {
+	std::unique_lock<std::mutex>	lock(_mutex);
+	while (!_terminate) {
+		_cond.wait_for(lock,
+			std::chrono::seconds(READER_SWEEP_INTERVAL));
+		if (!_terminate) {
+			sweep();
+		}
+	}
+}
+
+/**
+ * \brief Register a reader with the adapter
+ */
+FileReaderPrx	ReaderRegistry::add(Ice::ObjectPtr reader,
+			const Ice::Current& current) {
+	std::unique_lock<std::mutex>	lock(_mutex);
+	_adapter = current.adapter;
+	if (!_thread.joinable()) {
+		_thread = std::thread(&ReaderRegistry::run, this);
+	}
+	Ice::ObjectPrx	proxy = _adapter->addWithUUID(reader);
+	time(&_readers[proxy->ice_getIdentity()]);
+	return FileReaderPrx::uncheckedCast(proxy);
+}
+
+/**
+ * \brief Remember that a reader was used
+ */
+void	ReaderRegistry::used(const Ice::Identity& identity) {
+	std::unique_lock<std::mutex>	lock(_mutex);
+	auto	i = _readers.find(identity);
+	if (i != _readers.end()) {
+		time(&i->second);
+	}
+}
+
+/**
+ * \brief Remove a reader closed by the client and any unused readers
+ */
+void	ReaderRegistry::close(const Ice::Identity& identity) {
+	std::unique_lock<std::mutex>	lock(_mutex);
+	remove(identity);
+	sweep();
+}
+
+/**
+ * \brief Map a file into memory
+ */
+FileReaderI::FileReaderI(const std::string& filename)
+	: _encoding(ImageEncodingFITS), _map(NULL), _data(NULL), _size(0) {
+	int	fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::string	msg = astro::stringprintf("cannot open %s: %s",
+			filename.c_str(), strerror(errno));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw NotFound(msg);
+	}
+	struct stat	sb;
+	if (fstat(fd, &sb) < 0) {
+		std::string	msg = astro::stringprintf("cannot stat %s: %s",
+			filename.c_str(), strerror(errno));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		::close(fd);
+		throw NotFound(msg);
+	}
+	_size = sb.st_size;
+
+	// an empty file cannot be mapped, but it needs no mapping either
+	if (_size > 0) {
+		_map = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (MAP_FAILED == _map) {
+			std::string	msg = astro::stringprintf("cannot map "
+				"%s: %s", filename.c_str(), strerror(errno));
+			debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+			::close(fd);
+			throw std::runtime_error(msg);
+		}
+		_data = (const Ice::Byte *)_map;
+	}
+	// the mapping remains valid after the file descriptor is closed
+	::close(fd);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "reader for %s, %lu bytes",
+		filename.c_str(), _size);
+}
+
+/**
+ * \brief Serve an image encoded in memory
+ */
+FileReaderI::FileReaderI(astro::image::ImageBufferPtr buffer)
+	: _encoding(convert(buffer->type())), _map(NULL), _buffer(buffer),
+	  _data((const Ice::Byte *)buffer->data()), _size(buffer->size()) {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "reader for %lu bytes buffer", _size);
+}
+
+FileReaderI::~FileReaderI() {
+	if (_map) {
+		munmap(_map, _size);
+	}
+}
+
+ImageEncoding	FileReaderI::encoding(const Ice::Current& current) {
+	readers.used(current.id);
+	return _encoding;
+}
+
+Ice::Long	FileReaderI::size(const Ice::Current& current) {
+	readers.used(current.id);
+	return _size;
+}
+
+/**
+ * \brief Read a range of the file
+ *
+ * \param offset	offset of the first byte to read
+ * \param length	maximum number of bytes to read
+ */
+ImageFile	FileReaderI::read(Ice::Long offset, int length,
+			const Ice::Current& current) {
+	readers.used(current.id);
+	if ((offset < 0) || (length < 0) || ((size_t)offset > _size)) {
+		std::string	msg = astro::stringprintf("bad range %lld/%d "
+			"for %lu bytes", (long long)offset, length, _size);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw BadParameter(msg);
+	}
+	size_t	n = std::min((size_t)length, _size - (size_t)offset);
+	return ImageFile(_data + offset, _data + offset + n);
+}
+
+/**
+ * \brief Close the reader, this destroys the servant
+ */
+void	FileReaderI::close(const Ice::Current& current) {
+	readers.close(current.id);
+}
+
+/**
+ * \brief Register a reader with the adapter
+ */
+FileReaderPrx	FileReaderI::add(FileReaderI *reader,
+			const Ice::Current& current) {
+	return readers.add(reader, current);
+}
+
+/**
+ * \brief Compute a reduced version of an image
+ *
+ * \param image		the image to reduce
+ * \param roi		region of interest in image coordinates, an empty
+ *			rectangle selects the complete image
+ * \param scale		binning factor
+ * \param encoding	encoding of the result
+ */
+ImageBuffer	preview(astro::image::ImagePtr image,
+			const ImageRectangle& roi, int scale,
+			ImageEncoding encoding) {
+	if (scale < 1) {
+		std::string	msg = astro::stringprintf("bad scale %d", scale);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw BadParameter(msg);
+	}
+	astro::image::ImageRectangle	rectangle = convert(roi);
+	if (rectangle.size().getPixels() > 0) {
+		// cut works in the frame of the image, which includes the
+		// origin of the subframe
+		rectangle = astro::image::ImageRectangle(
+			image->origin() + rectangle.origin(), rectangle.size());
+		if (!image->getFrame().contains(rectangle)) {
+			std::string	msg = astro::stringprintf("roi %s not "
+				"inside image %s", rectangle.toString().c_str(),
+				image->getFrame().toString().c_str());
+			debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+			throw BadParameter(msg);
+		}
+		image = astro::image::ops::cut(image, rectangle);
+	}
+	if (scale > 1) {
+		if ((image->size().width() < scale)
+			|| (image->size().height() < scale)) {
+			std::string	msg = astro::stringprintf("scale %d too "
+				"large for %s image", scale,
+				image->size().toString().c_str());
+			debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+			throw BadParameter(msg);
+		}
+		image = astro::adapter::downsample(image,
+			astro::image::ImageSize(scale, scale));
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "preview size %s",
+		image->size().toString().c_str());
+	astro::image::ImageBuffer	buffer(image, convert(encoding));
+	return *convert(buffer);
+}
+
+} // namespace snowstar
@@ -0,0 +1,49 @@
+/*
+ * FileReaderI.h -- chunked transfer of image files
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#ifndef _FileReaderI_h
+#define _FileReaderI_h
+
+#include <image.h>
+#include <AstroImage.h>
+
+namespace snowstar {
+
+ImageBuffer	preview(astro::image::ImagePtr image,
+			const ImageRectangle& roi, int scale,
+			ImageEncoding encoding);
+
+/**
+ * \brief Servant giving ranged access to the contents of a file
+ *
+ * FITS files are mapped into memory, so the server never holds a copy
+ * of the file, only the chunks requested are copied into Ice messages.
+ * Other encodings are computed once when the reader is created. The
+ * servant is registered with the adapter under a unique identity and
+ * removes itself when the client closes it or when it has not been
+ * used for some time.
+ */
+class FileReaderI : virtual public FileReader {
+	ImageEncoding	_encoding;
+	void	*_map;
+	astro::image::ImageBufferPtr	_buffer;
+	const Ice::Byte	*_data;
+	size_t	_size;
+public:
+	FileReaderI(const std::string& filename);
+	FileReaderI(astro::image::ImageBufferPtr buffer);
+	virtual ~FileReaderI();
+	virtual ImageEncoding	encoding(const Ice::Current& current);
+	virtual Ice::Long	size(const Ice::Current& current);
+	virtual ImageFile	read(Ice::Long offset, int length,
+					const Ice::Current& current);
+	virtual void	close(const Ice::Current& current);
+	static FileReaderPrx	add(FileReaderI *reader,
+					const Ice::Current& current);
+};
+
+} // namespace snowstar
+
+#endif /* _FileReaderI_h */
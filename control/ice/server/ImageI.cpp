@@ -19,17 +19,18 @@
 #include <ImagesI.h>
 #include <ImageDirectory.h>
 #include <ImageRepo.h>
+#include <FileReaderI.h>
 
 namespace snowstar {
 
 /**
  * \brief Construct a new Image servant
  */
-ImageI::ImageI(astro::image::ImagePtr image, const std::string& filename)
-	: _image(image), _filename(filename), _type(typeid(unsigned short)) {
+ImageI::ImageI(astro::io::FITSheaderPtr header, const std::string& filename)
+	: _filename(filename), _type(header->getPixelType()) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0,
 		"creating image servant for %s, pixel type %s",
-		_filename.c_str(), _image->pixel_type().name());
+		_filename.c_str(), _type.name());
 	// check whether the filename contains a /, because that we want all
 	// images to be in the top level
 	if (std::string::npos != _filename.find('/')) {
@@ -39,23 +40,24 @@ ImageI::ImageI(astro::image::ImagePtr image, const std::string& filename)
 		throw std::runtime_error(msg);
 	}
 
-	// origin
-	_origin = convert(_image->origin());
+	// origin, written by FITSout for subframes
+	astro::image::ImagePoint	origin;
+	if (header->hasMetadata("XORGSUBF") && header->hasMetadata("YORGSUBF")) {
+		origin = astro::image::ImagePoint(
+			(int)header->getMetadata("XORGSUBF"),
+			(int)header->getMetadata("YORGSUBF"));
+	}
+	_origin = convert(origin);
 	// size
-	_size = convert(_image->size());
-	// type	
-	_type = _image->pixel_type();
-	// bytes per pixel
-	_bytesperpixel = _image->bytesPerPixel();
-	// bytes per value
-	_bytespervalue = _image->bytesPerPlane();
+	_size = convert(header->getSize());
 	// planes
-	_planes = _image->planes();
+	_planes = header->getPlanes();
+	// bytes per value
+	_bytespervalue = header->getBytesPerPlane();
+	// bytes per pixel
+	_bytesperpixel = _planes * _bytespervalue;
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "image servant created for %s",
 		_filename.c_str());
-
-	// start the timer
-	time(&_lastused);
 }
 
 /**
@@ -127,23 +129,28 @@ int     ImageI::bytesPerValue(const Ice::Current& current) {
 
 /**
  * \brief Find out whether there is a keyword in the metadata
+ *
+ * Metadata queries only read the header of the file, the image is not
+ * loaded for them.
  */
 bool	ImageI::hasMeta(const std::string& keyword,
 			const Ice::Current& current) {
 	CallStatistics::count(current);
-	return image()->hasMetadata(keyword);
+	astro::image::ImageDirectory	_imagedirectory;
+	return _imagedirectory.hasMetadata(_filename, keyword);
 }
 
 /**
- * \brief Get the metadata for a keyword
+ * \brief Get the metadata for a keyword
  */
 Metavalue	ImageI::getMeta(const std::string& keyword,
 			const Ice::Current& current) {
 	CallStatistics::count(current);
-	if (!image()->hasMetadata(keyword)) {
+	astro::image::ImageDirectory	_imagedirectory;
+	if (!_imagedirectory.hasMetadata(_filename, keyword)) {
 		throw NotFound("keyword not found");
 	}
-	return convert(_image->getMetadata(keyword));
+	return convert(_imagedirectory.getMetadata(_filename, keyword));
 }
 
 /**
@@ -156,7 +163,6 @@ void	ImageI::setMetavalue(const Metavalue& metavalue,
 	metadata.setMetadata(convert(metavalue));
 	astro::image::ImageDirectory	_imagedirectory;
 	_imagedirectory.setMetadata(_filename, metadata);
-	_image.reset();
 }
 
 /**
@@ -173,19 +179,20 @@ void	ImageI::setMetadata(const Metadata& metadata,
 	}
 	astro::image::ImageDirectory	_imagedirectory;
 	_imagedirectory.setMetadata(_filename, m);
-	_image.reset();
 }
 
 /**
- * \brief Get a image in memorey
+ * \brief Get the pixels of the image
+ *
+ * The servant does not keep the pixels itself, they come from the image
+ * cache shared by all servants. Clients usually retrieve the images of a
+ * directory one after the other, so the next images are prefetched.
  */
 astro::image::ImagePtr	ImageI::image() {
-	if (!_image) {
-		astro::image::ImageDirectory	_imagedirectory;
-		_image = _imagedirectory.getImagePtr(_filename);
-		time(&_lastused);
-	}
-	return _image;
+	astro::image::ImageDirectory	_imagedirectory;
+	astro::image::ImagePtr	result = _imagedirectory.getImagePtr(_filename);
+	_imagedirectory.prefetch(_filename);
+	return result;
 }
 
 ImageBuffer	ImageI::fileFITS() {
@@ -218,11 +225,10 @@ ImageBuffer	ImageI::fileFITS() {
 		throw NotFound("cannot open image file");
 	}
 
-	// read the data
-	unsigned char	*buffer = new unsigned char[sb.st_size];
-	if (sb.st_size != read(fd, buffer, sb.st_size)) {
+	// read the data directly into the result
+	result.data.resize(sb.st_size);
+	if (sb.st_size != read(fd, result.data.data(), sb.st_size)) {
 		close(fd); // prevent resource leak
-		delete[] buffer;
 		std::string	msg = astro::stringprintf("could not read file %s "
 			"in full length %ld", fullname.c_str(), sb.st_size);
 		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
@@ -230,10 +236,6 @@ ImageBuffer	ImageI::fileFITS() {
 	}
 	close(fd);
 
-	// copy data from the buffer into the result
-	std::copy(buffer, buffer + sb.st_size, back_inserter(result.data));
-	delete[] buffer;
-
 	// return the result
 	return result;
 }
@@ -267,6 +269,36 @@ ImageBuffer       ImageI::file(ImageEncoding encoding,
 	throw std::runtime_error("unknown encoding");
 }
 
+/**
+ * \brief Open the file for a chunked transfer
+ *
+ * The FITS file is mapped into memory by the reader, JPEG and PNG
+ * encodings are computed once and then served from memory.
+ */
+FileReaderPrx	ImageI::openFile(ImageEncoding encoding,
+			const Ice::Current& current) {
+	CallStatistics::count(current);
+	FileReaderI	*reader = NULL;
+	if (ImageEncodingFITS == encoding) {
+		astro::image::ImageDirectory	_imagedirectory;
+		reader = new FileReaderI(_imagedirectory.fullname(_filename));
+	} else {
+		astro::image::ImageBufferPtr	buffer(
+			new astro::image::ImageBuffer(image(), convert(encoding)));
+		reader = new FileReaderI(buffer);
+	}
+	return FileReaderI::add(reader, current);
+}
+
+/**
+ * \brief Get a region of interest of the image, possibly binned
+ */
+ImageBuffer	ImageI::preview(const ImageRectangle& roi, int scale,
+			ImageEncoding encoding, const Ice::Current& current) {
+	CallStatistics::count(current);
+	return snowstar::preview(image(), roi, scale, encoding);
+}
+
 /**
  * \brief Get the size of an image file
  */
@@ -293,8 +325,11 @@ void	ImageI::toRepository(const std::string& reponame,
 		throw NotFound(msg);
 	}
 
-	// add the image to the repository;
-	repo->save(image());
+	// add the image to the repository, saving modifies the image, so we
+	// cannot use the shared image from the cache
+	astro::image::ImageDirectory	_imagedirectory;
+	astro::io::FITSin	in(_imagedirectory.fullname(_filename));
+	repo->save(in.read());
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "image %s saved in %s",
 		_filename.c_str(), reponame.c_str());
 }
@@ -312,10 +347,10 @@ void    ImageI::remove(const Ice::Current& current) {
 	_imagedirectory.remove(_filename);
 }
 
-#define	sequence_mono(pixel, size)					\
+#define	sequence_mono(img, pixel, size)				\
 {									\
 	astro::image::Image<pixel>	*imagep				\
-		= dynamic_cast<astro::image::Image<pixel> *>(&*_image);	\
+		= dynamic_cast<astro::image::Image<pixel> *>(&*img);	\
 	if (NULL != imagep) {						\
 		for (unsigned int off = 0; off < size; off++) {		\
 			result.push_back((*imagep)[off]);		\
@@ -323,10 +358,10 @@ void    ImageI::remove(const Ice::Current& current) {
 	}								\
 }
 
-#define sequence_yuyv(pixel, size)					\
+#define sequence_yuyv(img, pixel, size)					\
 {									\
 	astro::image::Image<astro::image::YUYV<pixel> >	*imagep			\
-		= dynamic_cast<astro::image::Image<astro::image::YUYV<pixel> > *>(&*_image);\
+		= dynamic_cast<astro::image::Image<astro::image::YUYV<pixel> > *>(&*img);\
 	if (NULL != imagep) {						\
 		for (unsigned int off = 0; off < size; off++) {		\
 			result.push_back((*imagep)[off].y);		\
@@ -335,10 +370,10 @@ void    ImageI::remove(const Ice::Current& current) {
 	}								\
 }
 
-#define sequence_rgb(pixel, size)					\
+#define sequence_rgb(img, pixel, size)					\
 {									\
 	astro::image::Image<astro::image::RGB<pixel> >	*imagep			\
-		= dynamic_cast<astro::image::Image<astro::image::RGB<pixel> > *>(&*_image);\
+		= dynamic_cast<astro::image::Image<astro::image::RGB<pixel> > *>(&*img);\
 	if (NULL != imagep) {						\
 		for (unsigned int off = 0; off < size; off++) {		\
 			result.push_back((*imagep)[off].R);		\
@@ -351,15 +386,12 @@ void    ImageI::remove(const Ice::Current& current) {
 //////////////////////////////////////////////////////////////////////
 // Byte image implementation
 //////////////////////////////////////////////////////////////////////
-ByteImageI::ByteImageI(astro::image::ImagePtr image,
-	const std::string& filename) : ImageI(image, filename) {
-	std::type_index	type = image->pixel_type();
-	if ((type != typeid(unsigned char))
-		&& (type != typeid(astro::image::YUYV<unsigned char>))
-		&& (type != typeid(astro::image::RGB<unsigned char>))) {
+ByteImageI::ByteImageI(astro::io::FITSheaderPtr header,
+	const std::string& filename) : ImageI(header, filename) {
+	if (_type != typeid(unsigned char)) {
 		std::string	msg = astro::stringprintf("cannot build byte "
-			"image from %s, has %s pixel", filename.c_str());
-			astro::demangle(type.name()).c_str(),
+			"image from %s, has %s pixel", filename.c_str(),
+			astro::demangle(_type.name()).c_str());
 		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
 		throw BadParameter(msg);
 	}
@@ -371,25 +403,23 @@ ByteImageI::~ByteImageI() {
 ByteSequence	ByteImageI::getBytes(const Ice::Current& current) {
 	CallStatistics::count(current);
 	ByteSequence	result;
-	unsigned int	size = image()->size().getPixels();
-	sequence_mono(unsigned char, size);
-	sequence_yuyv(unsigned char, size);
-	sequence_rgb(unsigned char, size);
+	astro::image::ImagePtr	imageptr = image();
+	unsigned int	size = imageptr->size().getPixels();
+	sequence_mono(imageptr, unsigned char, size);
+	sequence_yuyv(imageptr, unsigned char, size);
+	sequence_rgb(imageptr, unsigned char, size);
 	return result;
 }
 
 //////////////////////////////////////////////////////////////////////
 // Short image implementation
 //////////////////////////////////////////////////////////////////////
-ShortImageI::ShortImageI(astro::image::ImagePtr image,
-	const std::string& filename) : ImageI(image, filename) {
-	std::type_index	type = image->pixel_type();
-	if ((type != typeid(unsigned short))
-		&& (type != typeid(astro::image::YUYV<unsigned short>))
-		&& (type != typeid(astro::image::RGB<unsigned short>))) {
-		std::string	msg = astro::stringprintf("cannot build "
-			"short image from %s, has %s pixel", filename.c_str(),
-			astro::demangle(type.name()).c_str());
+ShortImageI::ShortImageI(astro::io::FITSheaderPtr header,
+	const std::string& filename) : ImageI(header, filename) {
+	if (_type != typeid(unsigned short)) {
+		std::string	msg = astro::stringprintf("cannot build short "
+			"image from %s, has %s pixel", filename.c_str(),
+			astro::demangle(_type.name()).c_str());
 		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
 		throw BadParameter(msg);
 	}
@@ -401,25 +431,23 @@ ShortImageI::~ShortImageI() {
 ShortSequence	ShortImageI::getShorts(const Ice::Current& current) {
 	CallStatistics::count(current);
 	ShortSequence	result;
-	unsigned int	size = image()->size().getPixels();
-        sequence_mono(unsigned short, size);
-        sequence_yuyv(unsigned short, size);
-        sequence_rgb(unsigned short, size);
+	astro::image::ImagePtr	imageptr = image();
+	unsigned int	size = imageptr->size().getPixels();
+	sequence_mono(imageptr, unsigned short, size);
+	sequence_yuyv(imageptr, unsigned short, size);
+	sequence_rgb(imageptr, unsigned short, size);
 	return result;
 }
 
 //////////////////////////////////////////////////////////////////////
 // Int image implementation
 //////////////////////////////////////////////////////////////////////
-IntImageI::IntImageI(astro::image::ImagePtr image,
-	const std::string& filename) : ImageI(image, filename) {
-	std::type_index	type = image->pixel_type();
-	if ((type != typeid(unsigned int))
-		&& (type != typeid(astro::image::YUYV<unsigned int>))
-		&& (type != typeid(astro::image::RGB<unsigned int>))) {
-		std::string	msg = astro::stringprintf("cannot build "
-			"int image from %s, has %s pixel", filename.c_str(),
-			astro::demangle(type.name()).c_str());
+IntImageI::IntImageI(astro::io::FITSheaderPtr header,
+	const std::string& filename) : ImageI(header, filename) {
+	if (_type != typeid(unsigned int)) {
+		std::string	msg = astro::stringprintf("cannot build int "
+			"image from %s, has %s pixel", filename.c_str(),
+			astro::demangle(_type.name()).c_str());
 		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
 		throw BadParameter(msg);
 	}
@@ -431,25 +459,23 @@ IntImageI::~IntImageI() {
 IntSequence	IntImageI::getInts(const Ice::Current& current) {
 	CallStatistics::count(current);
 	IntSequence	result;
-	unsigned int	size = image()->size().getPixels();
-        sequence_mono(unsigned int, size);
-        sequence_yuyv(unsigned int, size);
-        sequence_rgb(unsigned int, size);
+	astro::image::ImagePtr	imageptr = image();
+	unsigned int	size = imageptr->size().getPixels();
+	sequence_mono(imageptr, unsigned int, size);
+	sequence_yuyv(imageptr, unsigned int, size);
+	sequence_rgb(imageptr, unsigned int, size);
 	return result;
 }
 
 //////////////////////////////////////////////////////////////////////
 // Float image implementation
 //////////////////////////////////////////////////////////////////////
-FloatImageI::FloatImageI(astro::image::ImagePtr image,
-	const std::string& filename) : ImageI(image, filename) {
-	std::type_index	type = image->pixel_type();
-	if ((type != typeid(float))
-		&& (type != typeid(astro::image::YUYV<float>))
-		&& (type != typeid(astro::image::RGB<float>))) {
-		std::string	msg = astro::stringprintf("cannot build "
-			"float image from %s, has %s pixel", filename.c_str(),
-			astro::demangle(type.name()).c_str());
+FloatImageI::FloatImageI(astro::io::FITSheaderPtr header,
+	const std::string& filename) : ImageI(header, filename) {
+	if (_type != typeid(float)) {
+		std::string	msg = astro::stringprintf("cannot build float "
+			"image from %s, has %s pixel", filename.c_str(),
+			astro::demangle(_type.name()).c_str());
 		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
 		throw BadParameter(msg);
 	}
@@ -461,25 +487,23 @@ FloatImageI::~FloatImageI() {
 FloatSequence	FloatImageI::getFloats(const Ice::Current& current) {
 	CallStatistics::count(current);
 	FloatSequence	result;
-	unsigned int	size = image()->size().getPixels();
-        sequence_mono(float, size);
-        sequence_yuyv(float, size);
-        sequence_rgb(float, size);
+	astro::image::ImagePtr	imageptr = image();
+	unsigned int	size = imageptr->size().getPixels();
+	sequence_mono(imageptr, float, size);
+	sequence_yuyv(imageptr, float, size);
+	sequence_rgb(imageptr, float, size);
 	return result;
 }
 
 //////////////////////////////////////////////////////////////////////
 // Double image implementation
 //////////////////////////////////////////////////////////////////////
-DoubleImageI::DoubleImageI(astro::image::ImagePtr image,
-	const std::string& filename) : ImageI(image, filename) {
-	std::type_index	type = image->pixel_type();
-	if ((type != typeid(double)) 
-		&& (type != typeid(astro::image::YUYV<double>))
-		&& (type != typeid(astro::image::RGB<double>))) {
-		std::string	msg = astro::stringprintf("cannot build "
-			"double image from %s, has %s pixel", filename.c_str(),
-			astro::demangle(type.name()).c_str());
+DoubleImageI::DoubleImageI(astro::io::FITSheaderPtr header,
+	const std::string& filename) : ImageI(header, filename) {
+	if (_type != typeid(double)) {
+		std::string	msg = astro::stringprintf("cannot build double "
+			"image from %s, has %s pixel", filename.c_str(),
+			astro::demangle(_type.name()).c_str());
 		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
 		throw BadParameter(msg);
 	}
@@ -491,10 +515,11 @@ DoubleImageI::~DoubleImageI() {
 DoubleSequence	DoubleImageI::getDoubles(const Ice::Current& current) {
 	CallStatistics::count(current);
 	DoubleSequence	result;
-	unsigned int	size = image()->size().getPixels();
-        sequence_mono(double, size);
-        sequence_yuyv(double, size);
-        sequence_rgb(double, size);
+	astro::image::ImagePtr	imageptr = image();
+	unsigned int	size = imageptr->size().getPixels();
+	sequence_mono(imageptr, double, size);
+	sequence_yuyv(imageptr, double, size);
+	sequence_rgb(imageptr, double, size);
 	return result;
 }
 
@@ -509,28 +534,5 @@ ImagePrx	ImageI::createProxy(const std::string& filename,
 	return getImage(filename, _type, current);
 }
 
-#define	EXPIRATION_INTERVAL	30
-
-/**
- * \brief expire images to conserver memory
- *
- * The expire method lets the servant forget the image if it has not been
- * use for some time. This releases the pixel data. If clients forget to
- * release images, large memory consumption can build up in the server
- * which may break it on the small SoC systems that we use on the telescope
- */
-bool	ImageI::expire() {
-	if (!_image) {
-		return false;
-	}
-	time_t	now;
-	time(&now);
-	if ((now - _lastused) > EXPIRATION_INTERVAL) {
-		_image.reset();
-		return true;
-	}
-	return false;
-}
-
 } // namespace snowstar
 
@@ -8,6 +8,7 @@
 
 #include <image.h>
 #include <AstroImage.h>
+#include <AstroIO.h>
 #include <typeindex>
 #include "StatisticsI.h"
 
@@ -17,24 +18,23 @@ namespace snowstar {
  * \brief Base class for Image implementations
  *
  * derived classes of this class will implement returning pixel arrays for
- * different pixel types
+ * different pixel types. The servant is built from the header of the file
+ * only, the pixels are taken from the shared image cache when needed.
  */
 class ImageI : virtual public Image, public StatisticsI {
 protected:
-	astro::image::ImagePtr	_image;
 	astro::image::ImagePtr	image();
 private:
 	std::string	_filename;
 	ImagePoint	_origin;
 	ImageSize	_size;
-	time_t	_lastused;
 protected:
 	std::type_index	_type;
 	int	_bytesperpixel;
 	int	_bytespervalue;
 	int	_planes;
 public:
-	ImageI(astro::image::ImagePtr image, const std::string& filename);
+	ImageI(astro::io::FITSheaderPtr header, const std::string& filename);
 	virtual ~ImageI();
 	virtual std::string	name(const Ice::Current& current);
 	virtual int	age(const Ice::Current& current);
@@ -58,6 +58,11 @@ private:
 public:
 	virtual ImageBuffer	file(ImageEncoding encoding,
 				const Ice::Current& current);
+	virtual FileReaderPrx	openFile(ImageEncoding encoding,
+				const Ice::Current& current);
+	virtual ImageBuffer	preview(const ImageRectangle& roi, int scale,
+				ImageEncoding encoding,
+				const Ice::Current& current);
 	virtual int	filesize(const Ice::Current& current);
 	virtual void	toRepository(const std::string& reponame,
 				const Ice::Current& current);
@@ -65,8 +70,6 @@ public:
 	ImagePrx	createProxy(const std::string& filename,
 				const Ice::Current& current);
 	std::string	filename() const { return _filename; }
-	bool	expire();
-	time_t	lastused() const { return _lastused; }
 };
 
 /**
@@ -74,7 +77,7 @@ public:
  */
 class ByteImageI : virtual public ByteImage, virtual public ImageI {
 public:
-	ByteImageI(astro::image::ImagePtr image, const std::string& filename);
+	ByteImageI(astro::io::FITSheaderPtr header, const std::string& filename);
 	virtual ~ByteImageI();
 	virtual ByteSequence	getBytes(const Ice::Current& current);
 };
@@ -84,7 +87,7 @@ public:
  */
 class ShortImageI : virtual public ShortImage, virtual public ImageI {
 public:
-	ShortImageI(astro::image::ImagePtr image, const std::string& filename);
+	ShortImageI(astro::io::FITSheaderPtr header, const std::string& filename);
 	virtual ~ShortImageI();
 	virtual ShortSequence	getShorts(const Ice::Current& current);
 };
@@ -94,7 +97,7 @@ public:
  */
 class IntImageI : virtual public IntImage, virtual public ImageI {
 public:
-	IntImageI(astro::image::ImagePtr image, const std::string& filename);
+	IntImageI(astro::io::FITSheaderPtr header, const std::string& filename);
 	virtual ~IntImageI();
 	virtual IntSequence	getInts(const Ice::Current& current);
 };
@@ -104,7 +107,7 @@ public:
  */
 class FloatImageI : virtual public FloatImage, virtual public ImageI {
 public:
-	FloatImageI(astro::image::ImagePtr image, const std::string& filename);
+	FloatImageI(astro::io::FITSheaderPtr header, const std::string& filename);
 	virtual ~FloatImageI();
 	virtual FloatSequence	getFloats(const Ice::Current& current);
 };
@@ -114,7 +117,7 @@ public:
  */
 class DoubleImageI : virtual public DoubleImage, virtual public ImageI {
 public:
-	DoubleImageI(astro::image::ImagePtr image, const std::string& filename);
+	DoubleImageI(astro::io::FITSheaderPtr header, const std::string& filename);
 	virtual ~DoubleImageI();
 	virtual DoubleSequence	getDoubles(const Ice::Current& current);
 };
@@ -14,7 +14,7 @@ namespace snowstar {
 /**
  * \brief Constructor for an ImageLocator
  */
-ImageLocator::ImageLocator() : EvictorBase(5) {
+ImageLocator::ImageLocator() : EvictorBase(100) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "image locator created");
 }
 
@@ -28,7 +28,9 @@ ImageLocator::~ImageLocator() {
 /**
  * \brief locate an image
  *
- * This method creates an image servant of the correct pixel type
+ * This method creates an image servant of the correct pixel type. Only
+ * the header of the file is read, the pixels are loaded by the servant
+ * when a client asks for them.
  */
 Ice::ObjectPtr	ImageLocator::add(const Ice::Current& current,
 					Ice::LocalObjectPtr& /* cookie */) {
@@ -44,37 +46,30 @@ Ice::ObjectPtr	ImageLocator::add(const Ice::Current& current,
 		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
 		throw NotFound(msg);
 	}
-	astro::image::ImagePtr	image = _imagedirectory.getImagePtr(name);
+	astro::io::FITSheaderPtr	header
+		= astro::io::FITSinfileBase::header(
+			_imagedirectory.fullname(name));
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "found %s image with %s pixels",
-		image->size().toString().c_str(),
-		astro::demangle(image->pixel_type().name()).c_str());
+		header->getSize().toString().c_str(),
+		astro::demangle(header->getPixelType().name()).c_str());
 
-	// find build the image proxy matching the pixel type
-	std::type_index	type = image->pixel_type();
-	if ((type == typeid(unsigned char))
-		|| (type == typeid(astro::image::YUYV<unsigned char>))
-		|| (type == typeid(astro::image::RGB<unsigned char>))) {
-		ptr = new ByteImageI(image, name);
+	// find build the image proxy matching the pixel type, color images
+	// have the same value type in the file as monochrome images
+	std::type_index	type = header->getPixelType();
+	if (type == typeid(unsigned char)) {
+		ptr = new ByteImageI(header, name);
 	}
-	if ((type == typeid(unsigned short))
-		|| (type == typeid(astro::image::YUYV<unsigned short>))
-		|| (type == typeid(astro::image::RGB<unsigned short>))) {
-		ptr = new ShortImageI(image, name);
+	if (type == typeid(unsigned short)) {
+		ptr = new ShortImageI(header, name);
 	}
-	if ((type == typeid(unsigned int))
-		|| (type == typeid(astro::image::YUYV<unsigned int>))
-		|| (type == typeid(astro::image::RGB<unsigned int>))) {
-		ptr = new IntImageI(image, name);
+	if (type == typeid(unsigned int)) {
+		ptr = new IntImageI(header, name);
 	}
-	if ((type == typeid(float))
-		|| (type == typeid(astro::image::YUYV<float>))
-		|| (type == typeid(astro::image::RGB<float>))) {
-		ptr = new FloatImageI(image, name);
+	if (type == typeid(float)) {
+		ptr = new FloatImageI(header, name);
 	}
-	if ((type == typeid(double))
-		|| (type == typeid(astro::image::YUYV<double>))
-		|| (type == typeid(astro::image::RGB<double>))) {
-		ptr = new DoubleImageI(image, name);
+	if (type == typeid(double)) {
+		ptr = new DoubleImageI(header, name);
 	}
 	if (!ptr) {
 		BadParameter	exception;
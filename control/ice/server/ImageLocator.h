@@ -19,10 +19,10 @@ namespace snowstar {
 /**
  * \brief Image Locator class
  *
- * This class es used to locate ImageI objects. Since these objects
- * can consume large amounts of memory, we want to be able to tell them
- * to throw away the image they store. This is no problem because they
- * can reload the image from disk at any time.
+ * This class es used to locate ImageI objects. The servants only keep
+ * the header information of the image, the pixels live in the image
+ * cache, whose memory budget is shared by all servants. So the number of
+ * servants kept by the evictor no longer determines the memory used.
  */
 class ImageLocator : public EvictorBase {
 private:
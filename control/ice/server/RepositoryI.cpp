@@ -6,6 +6,8 @@
 #include <RepositoryI.h>
 #include <IceConversions.h>
 #include <AstroDebug.h>
+#include <ImageCache.h>
+#include <FileReaderI.h>
 
 namespace snowstar {
 
@@ -81,7 +83,16 @@ ImageBuffer       RepositoryI::getImage(int id, ImageEncoding encoding,
 			"%d", id);
 		throw NotFound(msg);
 	}
-	astro::image::ImagePtr	imageptr = _repo.getImage(id);
+	// images are read through the cache, and because clients usually
+	// download images in the order of their ids, the next images are
+	// prefetched
+	astro::image::ImagePtr	imageptr
+		= astro::image::ImageCache::get(_repo.pathname(id));
+	for (int next = id + 1; next <= id + 2; next++) {
+		if (_repo.has(next)) {
+			astro::image::ImageCache::prefetch(_repo.pathname(next));
+		}
+	}
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "found image %d: %d x %d", id,
 		imageptr->size().width(), imageptr->size().height());
 	astro::image::ImageBuffer	buffer(imageptr, convert(encoding));
@@ -89,6 +100,35 @@ ImageBuffer       RepositoryI::getImage(int id, ImageEncoding encoding,
 	return *imagebuffer;
 }
 
+/**
+ * \brief Open an image file for a chunked transfer
+ */
+FileReaderPrx	RepositoryI::openImage(int id, const Ice::Current& current) {
+	CallStatistics::count(current);
+	if (!_repo.has(id)) {
+		std::string	msg = astro::stringprintf("repo does not have "
+			"%d", id);
+		throw NotFound(msg);
+	}
+	return FileReaderI::add(new FileReaderI(_repo.pathname(id)), current);
+}
+
+/**
+ * \brief Get a region of interest of an image, possibly binned
+ */
+ImageBuffer	RepositoryI::getPreview(int id, const ImageRectangle& roi,
+			int scale, ImageEncoding encoding,
+			const Ice::Current& current) {
+	CallStatistics::count(current);
+	if (!_repo.has(id)) {
+		std::string	msg = astro::stringprintf("repo does not have "
+			"%d", id);
+		throw NotFound(msg);
+	}
+	return preview(astro::image::ImageCache::get(_repo.pathname(id)),
+		roi, scale, encoding);
+}
+
 ImageInfo	RepositoryI::getInfo(int id,
 			const Ice::Current& current) {
 	CallStatistics::count(current);
@@ -132,7 +172,9 @@ void    RepositoryI::remove(int id, const Ice::Current& current) {
 			"%d", id);
 		throw NotFound(msg);
 	}
+	std::string	pathname = _repo.pathname(id);
 	_repo.remove(id);
+	astro::image::ImageCache::invalidate(pathname);
 }
 
 } // namespace snowstar
@@ -32,6 +32,10 @@ public:
 				const Ice::Current& current);
 	virtual ImageBuffer	getImage(int id, ImageEncoding encoding,
 				const Ice::Current& current);
+	virtual FileReaderPrx	openImage(int id, const Ice::Current& current);
+	virtual ImageBuffer	getPreview(int id, const ImageRectangle& roi,
+				int scale, ImageEncoding encoding,
+				const Ice::Current& current);
 	virtual ImageInfo	getInfo(int id, const Ice::Current& current);
 	virtual int	save(const ImageFile& image,
 				const Ice::Current& current);
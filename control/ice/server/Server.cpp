@@ -38,6 +38,7 @@
 #include <EventServantLocator.h>
 #include <ConfigurationI.h>
 #include <DaemonI.h>
+#include <ImageCache.h>
 #include <GatewayI.h>
 
 namespace snowstar {
@@ -110,6 +111,13 @@ static astro::config::ConfigurationRegister	_heartbeat_interval_registration(
 	_heartbeat_interval_key,
 	"the default heartbeat interval");
 
+// memory budget of the image cache
+static astro::config::ConfigurationKey	_images_cachesize_key(
+	"snowstar", "images", "cachesize");
+static astro::config::ConfigurationRegister	_images_cachesize_registration(
+	_images_cachesize_key,
+	"memory in MB available for cached image pixels, default 256");
+
 /**
  * \brief Get the services to be activated from the configuration
  */
@@ -238,7 +246,25 @@ void	Server::add_daemon_servant() {
 		"Daemon server added");
 }
 
+/**
+ * \brief Set the memory budget of the image cache from the configuration
+ */
+void	Server::configure_image_cache() {
+	astro::config::ConfigurationPtr	configuration
+		= astro::config::Configuration::get();
+	std::string	cachesizestring = configuration->get(
+				_images_cachesize_key, "256");
+	try {
+		size_t	cachesize = std::stoul(cachesizestring);
+		astro::image::ImageCache::budget(cachesize * 1024 * 1024);
+	} catch (const std::exception& x) {
+		debug(LOG_ERR, DEBUG_LOG, 0, "invalid cache size '%s': %s",
+			cachesizestring.c_str(), x.what());
+	}
+}
+
 void	Server::add_images_servant() {
+	configure_image_cache();
 	Ice::ObjectPtr	object = new ImagesI();
 	adapter->add(object, STRING_TO_IDENTITY("Images"));
 	ImageLocator	*imagelocator = new ImageLocator();
@@ -273,6 +299,7 @@ void	Server::add_instruments_servant() {
 }
 
 void	Server::add_repository_servant() {
+	configure_image_cache();
 	_repositories = new RepositoriesI();
 	Ice::ObjectPtr	object = _repositories;
 	adapter->add(object, STRING_TO_IDENTITY("Repositories"));
@@ -351,6 +378,9 @@ Server::Server(Ice::CommunicatorPtr _ic, const std::string& dbfilename)
 	// initialize the guider factory
 	astro::guiding::GuiderFactory::initialize(repository, database);
 
+	// FFTW planning settings for guiding and image processing
+	astro::config::FFTWConfiguration::apply();
+
 	// initialize servants
 
 	// create the adapter
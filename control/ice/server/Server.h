@@ -46,6 +46,7 @@ class Server {
 	void	add_gateway_servant();
 	void	add_configuration_servant();
 	void	add_daemon_servant();
+	void	configure_image_cache();
 	void	add_images_servant();
 	void	add_tasks_servant();
 	void	add_instruments_servant();
@@ -6,6 +6,7 @@
 #include "StatisticsI.h"
 #include <AstroFormat.h>
 #include <AstroDebug.h>
+#include <ImageCache.h>
 
 namespace snowstar {
 
@@ -96,4 +97,28 @@ Ice::Long	StatisticsI::operationCalls(const std::string& operation,
 	return CallStatistics::recall(current.id)->calls(operation);
 }
 
+/**
+ * \brief Return the number of image requests served from the image cache
+ */
+Ice::Long	StatisticsI::imageCacheHits(const Ice::Current& current) {
+	CallStatistics::count(current);
+	return astro::image::ImageCache::hits();
+}
+
+/**
+ * \brief Return the number of image requests that had to read the file
+ */
+Ice::Long	StatisticsI::imageCacheMisses(const Ice::Current& current) {
+	CallStatistics::count(current);
+	return astro::image::ImageCache::misses();
+}
+
+/**
+ * \brief Return the number of bytes of pixel data in the image cache
+ */
+Ice::Long	StatisticsI::imageCacheBytes(const Ice::Current& current) {
+	CallStatistics::count(current);
+	return astro::image::ImageCache::bytes();
+}
+
 } // namespace snowstar
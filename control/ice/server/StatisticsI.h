@@ -86,6 +86,11 @@ public:
 	Ice::Long	calls(const Ice::Current& current);
 	Ice::Long	operationCalls(const std::string& operation,
 			const Ice::Current& current);
+
+	// image cache of the server
+	Ice::Long	imageCacheHits(const Ice::Current& current);
+	Ice::Long	imageCacheMisses(const Ice::Current& current);
+	Ice::Long	imageCacheBytes(const Ice::Current& current);
 };
 
 } // namespace snowstar
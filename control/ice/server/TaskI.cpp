@@ -15,6 +15,7 @@
 #include <AstroConfig.h>
 #include <ImageDirectory.h>
 #include <ImageRepo.h>
+#include <AstroIO.h>
 
 namespace snowstar {
 
@@ -84,7 +85,9 @@ int	TaskI::imageToRepo(const std::string& reponame,
 		debug(LOG_ERR, DEBUG_LOG, 0, "%s", exception.cause.c_str());
 		throw exception;
 	}
-	astro::image::ImagePtr	image = imagedir.getImagePtr(filename);
+	// saving modifies the image, so it must not come from the image cache
+	astro::io::FITSin	in(imagedir.fullname(filename));
+	astro::image::ImagePtr	image = in.read();
 
 	// now get the named image repository configuration
 	astro::project::ImageRepoPtr	repo;
@@ -11,6 +11,7 @@
 #include <AstroDebug.h>
 #include <AstroTypes.h>
 #include <deque>
+#include <vector>
 
 using namespace astro::image;
 
@@ -35,6 +36,9 @@ public:
 	virtual Pixel	pixel(int x, int y) const {
 		return _image.pixel(x, y);
 	}
+	virtual void	readrow(int y, int x0, int n, Pixel *out) const {
+		_image.readrow(y, x0, n, out);
+	}
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -50,6 +54,10 @@ public:
 	virtual Pixel	pixel(int x, int y) const {
 		return _a[_size.offset(x, y)];
 	}
+	virtual void	readrow(int y, int x0, int n, Pixel *out) const {
+		const Pixel	*p = _a + _size.offset(x0, y);
+		std::copy(p, p + n, out);
+	}
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -272,6 +280,7 @@ public:
 	WindowAdapter(const ConstImageAdapter<Pixel>& image, const ImageRectangle& frame);
 	
 	virtual Pixel	pixel(int x, int y) const;
+	virtual void	readrow(int y, int x0, int n, Pixel *out) const;
 };
 
 /**
@@ -295,6 +304,14 @@ Pixel	WindowAdapter<Pixel>::pixel(int x, int y) const {
 	return	image.pixel(frame.origin().x() + x, frame.origin().y() + y);
 }
 
+/**
+ * \brief Access a row segment inside the subwindow
+ */
+template<typename Pixel>
+void	WindowAdapter<Pixel>::readrow(int y, int x0, int n, Pixel *out) const {
+	image.readrow(frame.origin().y() + y, frame.origin().x() + x0, n, out);
+}
+
 template<typename Pixel>
 class SubimageAdapter : public ImageAdapter<Pixel> {
 	ImageAdapter<Pixel>&	_image;
@@ -487,6 +504,7 @@ class ConvertingAdapter : public ConstImageAdapter<TargetPixel> {
 public:
 	ConvertingAdapter(const ConstImageAdapter<SourcePixel>& image);
 	virtual TargetPixel	pixel(int x, int y) const;
+	virtual void	readrow(int y, int x0, int n, TargetPixel *out) const;
 };
 
 template<typename TargetPixel, typename SourcePixel>
@@ -503,6 +521,16 @@ TargetPixel	ConvertingAdapter<TargetPixel, SourcePixel>::pixel(int x, int y) con
 	return p;
 }
 
+template<typename TargetPixel, typename SourcePixel>
+void	ConvertingAdapter<TargetPixel, SourcePixel>::readrow(int y, int x0,
+		int n, TargetPixel *out) const {
+	std::vector<SourcePixel>	row(n);
+	image.readrow(y, x0, n, row.data());
+	for (int i = 0; i < n; i++) {
+		out[i] = TargetPixel(row[i]);
+	}
+}
+
 /**
  * \brief Adapter to convert image pixels between different color spaces
  */
@@ -1055,6 +1083,7 @@ public:
 		minimum(_minimum), maximum(_maximum) {
 	}
 	T	pixel(int x, int y) const;
+	void	readrow(int y, int x0, int n, T *out) const;
 };
 
 template<typename Pixel, typename T>
@@ -1069,6 +1098,16 @@ T	ClampingAdapter<Pixel, T>::pixel(int x, int y) const {
 	return v;
 }
 
+template<typename Pixel, typename T>
+void	ClampingAdapter<Pixel, T>::readrow(int y, int x0, int n, T *out) const {
+	std::vector<Pixel>	row(n);
+	image.readrow(y, x0, n, row.data());
+	for (int i = 0; i < n; i++) {
+		T	v = row[i];
+		out[i] = (v < minimum) ? minimum : ((v > maximum) ? maximum : v);
+	}
+}
+
 template<typename T>
 class ColorClampingAdapter : public ConstImageAdapter<RGB<T> > {
 	const ConstImageAdapter<RGB<T> >&	_image;
@@ -1302,6 +1341,7 @@ class RGBAdapter : public ConstImageAdapter<RGB<S> > {
 public:
 	RGBAdapter(const ConstImageAdapter<RGB<T> >& image);
 	RGB<S>	pixel(int x, int y) const;
+	void	readrow(int y, int x0, int n, RGB<S> *out) const;
 };
 
 template<typename S, typename T>
@@ -1314,6 +1354,15 @@ RGB<S>	RGBAdapter<S, T>::pixel(int x, int y) const {
 	return RGB<S>(image.pixel(x, y));
 }
 
+template<typename S, typename T>
+void	RGBAdapter<S, T>::readrow(int y, int x0, int n, RGB<S> *out) const {
+	std::vector<RGB<T> >	row(n);
+	image.readrow(y, x0, n, row.data());
+	for (int i = 0; i < n; i++) {
+		out[i] = RGB<S>(row[i]);
+	}
+}
+
 //////////////////////////////////////////////////////////////////////
 // Color adapters
 //////////////////////////////////////////////////////////////////////
@@ -1985,6 +2034,13 @@ public:
 	double	pixel(int x, int y) const {
 		return image.pixel(x, y);
 	}
+	void	readrow(int y, int x0, int n, double *out) const {
+		std::vector<Pixel>	row(n);
+		image.readrow(y, x0, n, row.data());
+		for (int i = 0; i < n; i++) {
+			out[i] = row[i];
+		}
+	}
 };
 
 class DoubleAdapter : public ConstImageAdapter<double> {
@@ -48,6 +48,9 @@ protected:
 	void	copyMetadata(astro::image::ImagePtr calframe,
 			const astro::image::ImageSequence& images,
 			const std::string& purpose) const;
+	void	copyMetadata(astro::image::ImagePtr calframe,
+			astro::image::ImagePtr firstimage, size_t count,
+			const std::string& purpose) const;
 public:
 	astro::image::ImagePtr	operator()(
 		const astro::image::ImageSequence& images) const;
@@ -56,6 +59,9 @@ public:
 template<typename T>
 class ImageMean;
 
+class ImageAccumulatorBase;
+typedef std::shared_ptr<ImageAccumulatorBase>	ImageAccumulatorPtr;
+
 /**
  * \brief Factory for dark frames.
  *
@@ -98,12 +104,16 @@ private:
 	ImagePtr	dark(const ImageSequence& images,
 				bool gridded) const;
 
+	template<typename DarkPixelType>
+	ImagePtr	dark(ImageMean<DarkPixelType>& im, bool gridded) const;
+
 	template<typename DarkPixelType>
 	size_t	subdark(ImageMean<DarkPixelType>& im,
 			const Subgrid grid) const;
 public:
 	// Constructor
 	DarkFrameFactory();
+	friend class DarkFrameBuilder;
 
 	astro::image::ImagePtr	operator()(
 		const astro::image::ImageSequence& images) const;
@@ -137,14 +147,70 @@ private:
 	template<typename FlatPixelType>
 	ImagePtr	flat(const astro::image::ImageSequence& images,
 		const Image<FlatPixelType>& bias) const;
+
+	ImagePtr	flat(ImageMean<float>& im) const;
+
+	template<typename FlatPixelType>
+	ImagePtr	flat(ImageMean<FlatPixelType>& im,
+		const Image<FlatPixelType>& bias) const;
 public:
 	FlatFrameFactory(bool mosaic = false, bool interpolate = false);
+	friend class FlatFrameBuilder;
 
 	astro::image::ImagePtr	operator()(
 				const astro::image::ImageSequence& images,
 				const astro::image::ImagePtr biasimage) const;
 };
 
+/**
+ * \brief Incremental construction of dark frames
+ *
+ * The DarkFrameFactory needs all images of the sequence in memory at
+ * the same time. The builder instead accepts the images one at a time,
+ * e.g. as they come from the camera or are read from files, and only
+ * keeps running mean and variance for each pixel. In robust mode, the
+ * images are in addition spilled to a temporary file, so that the
+ * outlier rejection of the DarkFrameFactory can be reproduced at the
+ * end without keeping the images in memory.
+ */
+class DarkFrameBuilder {
+	DarkFrameFactory	_factory;
+	bool	_robust;
+	ImagePtr	_first;
+	ImageAccumulatorPtr	_accumulator;
+public:
+	bool	robust() const { return _robust; }
+	void	robust(bool r);
+	DarkFrameBuilder(const DarkFrameFactory& factory = DarkFrameFactory(),
+		bool robust = true);
+	void	add(ImagePtr image);
+	size_t	count() const;
+	ImagePtr	operator()();
+};
+
+/**
+ * \brief Incremental construction of flat frames
+ *
+ * Like the DarkFrameBuilder, this accepts the images one at a time.
+ * The bias image has to be known before the first image is added,
+ * because it is subtracted as the images arrive.
+ */
+class FlatFrameBuilder {
+	FlatFrameFactory	_factory;
+	ImagePtr	_bias;
+	bool	_robust;
+	ImagePtr	_first;
+	ImageAccumulatorPtr	_accumulator;
+public:
+	bool	robust() const { return _robust; }
+	void	robust(bool r);
+	FlatFrameBuilder(const FlatFrameFactory& factory = FlatFrameFactory(),
+		ImagePtr bias = ImagePtr(), bool robust = true);
+	void	add(ImagePtr image);
+	size_t	count() const;
+	ImagePtr	operator()();
+};
+
 /**
  * \brief Clamp an image
  */
@@ -234,6 +300,52 @@ public:
 	astro::image::ImagePtr	operator()(const astro::image::ImagePtr image) const;
 };
 
+/**
+ * \brief Fused calibration with dark and flat frames
+ *
+ * The kernel extracts dark values and inverse flat values for a frame
+ * once, so that many images of the same frame can be calibrated with it.
+ * Dark subtraction, flat division, bad pixel interpolation, clamping and
+ * binning are then done in a single row by row pass over the image.
+ * Pixels that are NaN in the dark or the flat are bad pixels. They are
+ * interpolated from their good neighbours like the Interpolator does,
+ * i.e. only from pixels of the same color for mosaic images. Binning
+ * adds pixels of the same color, so a binned mosaic image is still
+ * a mosaic image of the same type.
+ */
+class CalibrationKernel {
+	astro::image::ImageSize	_size;
+	std::vector<float>	_dark;
+	std::vector<float>	_gain;
+	std::vector<unsigned char>	_bad;
+	std::vector<size_t>	_badpixels;
+	std::vector<size_t>	_badrows;
+	bool	_interpolate;
+	int	_binning;
+	double	_minvalue;
+	double	_maxvalue;
+	template<typename Pixel, typename W>
+	W	interpolated(const astro::image::Image<Pixel>& image,
+			size_t offset, W lo, W hi) const;
+	template<typename Pixel, typename W>
+	astro::image::ImagePtr	calibrate(astro::image::Image<Pixel>& image)
+					const;
+public:
+	CalibrationKernel(astro::image::ImagePtr dark,
+		astro::image::ImagePtr flat,
+		const astro::image::ImageRectangle rectangle
+			= astro::image::ImageRectangle());
+	const astro::image::ImageSize&	size() const { return _size; }
+	size_t	badpixels() const { return _badpixels.size(); }
+	bool	interpolate() const { return _interpolate; }
+	void	interpolate(bool i) { _interpolate = i; }
+	int	binning() const { return _binning; }
+	void	binning(int b);
+	void	clamp(double minvalue, double maxvalue);
+	astro::image::ImagePtr	operator()(astro::image::ImagePtr image) const;
+};
+typedef std::shared_ptr<CalibrationKernel>	CalibrationKernelPtr;
+
 /**
  * \brief Class to record and average calibration images
  */
@@ -307,6 +307,10 @@ public:
  * \brief Interface to retrieve multiple images from a Ccd
  *
  * The Basic CCD interface can retrieve single images, but the real 
+ *
+ * When the queue is full, the drop policy decides what happens to a new
+ * entry: it either replaces the oldest entry, it is dropped itself,
+ * or the caller is blocked until a client has retrieved an entry.
  */
 class ImageQueue {
 	std::mutex	mutex;
@@ -316,6 +320,17 @@ class ImageQueue {
 public:
 	unsigned long	maxqueuelength() const { return _maxqueuelength; }
 	void	maxqueuelength(unsigned long m) { _maxqueuelength = m; }
+	typedef enum { oldest, newest, block } droppolicy_type;
+	static std::string	droppolicy2string(droppolicy_type d);
+	static droppolicy_type	string2droppolicy(const std::string& s);
+private:
+	std::atomic<droppolicy_type>	_droppolicy;
+	bool	_blocking;
+public:
+	droppolicy_type	droppolicy() const { return _droppolicy; }
+	void	droppolicy(droppolicy_type d) { _droppolicy = d; }
+protected:
+	void	blocking(bool b);
 private:
 	long	_processed;
 	long	_dropped;
@@ -334,6 +349,78 @@ public:
 	void	add(ImageQueueEntry& entry);
 };
 
+/**
+ * \brief Pool of image buffers
+ *
+ * Allocating the pixel array for every frame of a stream is expensive
+ * for large images. An image obtained from the pool goes back to the
+ * pool instead of being destroyed when the last reference to it is
+ * released, e.g. when a client has retrieved and processed the entry
+ * from the ImageQueue. The pool keeps at most maxbuffers free images.
+ */
+class ImageBufferPool {
+	struct pooldata {
+		std::mutex	mutex;
+		std::deque<ImageBase *>	free;
+		unsigned long	maxbuffers;
+		unsigned long	allocated;
+		unsigned long	recycled;
+		~pooldata();
+	};
+	typedef std::shared_ptr<pooldata>	pooldataptr;
+	pooldataptr	_data;
+	static void	recycle(std::weak_ptr<pooldata> data, ImageBase *image);
+	ImageBufferPool(const ImageBufferPool& other);
+	ImageBufferPool&	operator=(const ImageBufferPool& other);
+public:
+	ImageBufferPool(unsigned long maxbuffers = 4);
+	unsigned long	maxbuffers() const;
+	void	maxbuffers(unsigned long m);
+	unsigned long	allocated() const;
+	unsigned long	recycled() const;
+	unsigned long	available() const;
+	void	clear();
+	template<typename Pixel>
+	std::shared_ptr<Image<Pixel> >	image(const ImageSize& size);
+};
+
+/**
+ * \brief Get an image of a given size from the pool
+ *
+ * The pixel values of a recycled image are not cleared, but metadata,
+ * origin and mosaic type are reset.
+ */
+template<typename Pixel>
+std::shared_ptr<Image<Pixel> >	ImageBufferPool::image(const ImageSize& size) {
+	Image<Pixel>	*result = NULL;
+	{
+		std::unique_lock<std::mutex>	lock(_data->mutex);
+		for (auto i = _data->free.begin(); i != _data->free.end(); i++) {
+			Image<Pixel>	*candidate
+				= dynamic_cast<Image<Pixel> *>(*i);
+			if ((candidate) && (candidate->size() == size)) {
+				_data->free.erase(i);
+				result = candidate;
+				_data->recycled++;
+				break;
+			}
+		}
+		if (NULL == result) {
+			_data->allocated++;
+		}
+	}
+	if (result) {
+		result->metadata(ImageMetadata());
+		result->setOrigin(ImagePoint());
+		result->setMosaicType(MosaicType::NONE);
+	} else {
+		result = new Image<Pixel>(size);
+	}
+	std::weak_ptr<pooldata>	data(_data);
+	return std::shared_ptr<Image<Pixel> >(result,
+		[data](Image<Pixel> *image) { recycle(data, image); });
+}
+
 /**
  * \brief Sink for images
  */
@@ -351,8 +438,35 @@ public:
 	CannotStream() { }
 };
 
+/**
+ * \brief Counters and timing of the stages of an image stream
+ *
+ * All times are totals in seconds. The acquisition stage exposes and
+ * reads out images, the delivery stage hands them to the sink or queue.
+ * The stall time is the time the acquisition stage had to wait for
+ * the delivery stage with the block drop policy.
+ */
+class ImageStreamStatistics {
+public:
+	long	exposed;
+	long	delivered;
+	long	dropped;
+	double	exposuretime;
+	double	readouttime;
+	double	deliverytime;
+	double	stalltime;
+	ImageStreamStatistics();
+	std::string	toString() const;
+};
+
 /**
  * \brief Interface for Image Streams
+ *
+ * Streaming uses two threads, so that the next exposure can already
+ * be started while the previous image is still delivered to the sink
+ * or queue. At most pipelinedepth images wait between the two stages,
+ * further images are handled according to the pipeline policy, which
+ * by default makes the acquisition wait for the delivery.
  */
 class ImageStream : public ImageQueue, public ImageSink {
 protected:
@@ -364,6 +478,22 @@ private:
 	void	cleanup();
 	ImageStream(const ImageStream& other);
 	ImageStream&	operator()(const ImageStream& other);
+	unsigned long	_pipelinedepth;
+	std::atomic<droppolicy_type>	_pipelinepolicy;
+public:
+	unsigned long	pipelinedepth() const { return _pipelinedepth; }
+	void	pipelinedepth(unsigned long p) { _pipelinedepth = p; }
+	droppolicy_type	pipelinepolicy() const { return _pipelinepolicy; }
+	void	pipelinepolicy(droppolicy_type d) { _pipelinepolicy = d; }
+private:
+	ImageBufferPool	_bufferpool;
+public:
+	ImageBufferPool&	bufferpool() { return _bufferpool; }
+private:
+	std::mutex	_statisticsmutex;
+	ImageStreamStatistics	_statistics;
+public:
+	ImageStreamStatistics	statistics();
 public:
 	void	imagesink(ImageSink *i);
 	ImageStream(unsigned long _maxqueuelength = 10);
@@ -376,6 +506,7 @@ public:
 	virtual void	streamExposure(const Exposure& exposure);
 	virtual Exposure	streamExposure();
 	virtual void	operator()(const ImageQueueEntry& entry);
+friend class ImageStreamThread;
 };
 
 /**
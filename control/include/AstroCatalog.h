@@ -328,7 +328,8 @@ public:
 		Tycho2 = 3,
 		Ucac4 = 4,
 		Combined = 5,
-		Database = 6
+		Database = 6,
+		Compact = 7
 	} BackendType;
 	static CatalogPtr	get(BackendType type,
 					const std::string& parameter);
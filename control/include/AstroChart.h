@@ -155,6 +155,55 @@ public:
 	virtual double	pixel(int x, int y) const;
 };
 
+/**
+ * \brief A star to be rendered at a pixel position with some intensity
+ */
+class ChartPoint : public astro::Point {
+	double	_intensity;
+public:
+	double	intensity() const { return _intensity; }
+	ChartPoint(const astro::Point& point, double intensity)
+		: astro::Point(point), _intensity(intensity) { }
+};
+
+/**
+ * \brief Render stars by adding point spread function kernels
+ *
+ * Instead of drawing point stars and convolving the complete image with
+ * the point spread function, each star adds a precomputed kernel to the
+ * pixels around it. The point spread function is sampled once into a
+ * radial profile table, from which kernels for a grid of subpixel
+ * offsets are computed. The kernel radius of a star is chosen such
+ * that the contribution of the omitted pixels is below the threshold,
+ * so faint stars only touch a few pixels. The image is rendered in
+ * horizontal strips in parallel.
+ */
+class StarRenderer {
+	double	_angularpixelsize;
+	int	_radius;
+	int	_subpixels;
+	double	_threshold;
+	bool	_dirac;
+	std::vector<double>	_profile;
+	std::vector<double>	_envelope;
+	std::vector<float>	_kernels;
+	const float	*kernel(int sx, int sy) const;
+public:
+	static int	oversampling;
+	int	maxradius() const { return _radius; }
+	int	subpixels() const { return _subpixels; }
+	double	threshold() const { return _threshold; }
+	StarRenderer(const PointSpreadFunction& pointspreadfunction,
+		double angularpixelsize, int maxradius = 100,
+		int subpixels = 4, double threshold = 0.0001);
+	double	profile(double r) const;
+	int	radius(double intensity) const;
+	void	operator()(Image<double>& image,
+			const std::vector<ChartPoint>& stars) const;
+	static void	deposit(Image<double>& image,
+			const std::vector<ChartPoint>& stars);
+};
+
 class ChartFactoryBase {
 // parameters valid for all images
 protected:
@@ -175,6 +224,11 @@ private:
 public:
 	bool	logarithmic() const { return _logarithmic; }
 	void	logarithmic(bool l) { _logarithmic = l; }
+private:
+	bool	_fft;
+public:
+	bool	fft() const { return _fft; }
+	void	fft(bool f) { _fft = f; }
 public:
 	// constructors
 	ChartFactoryBase(CatalogPtr catalog, const PointSpreadFunction& psf,
@@ -183,15 +237,17 @@ public:
 		: _catalog(catalog), pointspreadfunction(psf),
 		  _limit_magnitude(limit_magnitude),
 		  _scale(scale),
-		  _logarithmic(logarithmic) {
+		  _logarithmic(logarithmic), _fft(false) {
 	}
 
 protected:
-	void	draw(Image<double>& image, const Point& p,
-			const Star& star) const;
+	double	intensity(const Star& star) const;
 	void	limit(Image<double>& image, double limit) const;
 	void	spread(Image<double>& image, int morepixels,
-			const ImageGeometry& geometry) const;
+			double angularpixelsize) const;
+	void	render(Image<double>& image,
+			const std::vector<ChartPoint>& stars,
+			double angularpixelsize, int morepixels) const;
 };
 
 /**
@@ -212,11 +268,14 @@ public:
 	// functions needed to produce a chart
 	Chart	chart(const RaDec& center, const ImageGeometry& geometry) const;
 private:
-	void	draw(Image<double>& image, const SkyRectangle& rectangle,
+	void	draw(std::vector<ChartPoint>& points,
+			const SkyRectangle& rectangle, const ImageSize& size,
 			const Catalog::starset& star) const;
-	void	draw(Image<double>& image, const SkyRectangle& rectangle,
+	void	draw(std::vector<ChartPoint>& points,
+			const SkyRectangle& rectangle, const ImageSize& size,
 			const Catalog::starsetptr star) const;
-	void	draw(Image<double>& image, const SkyRectangle& rectangle,
+	void	draw(std::vector<ChartPoint>& points,
+			const SkyRectangle& rectangle, const ImageSize& size,
 			const Star& star) const;
 };
 
@@ -263,15 +322,15 @@ public:
 	StereographicChart	chart(const RaDec& center,
 					unsigned int diameter) const;
 private:
-	void	draw(Image<double>& image,
+	void	draw(std::vector<ChartPoint>& points, const ImageSize& size,
 			const astro::image::transform::StereographicProjection& projection,
 			const Star& star) const;
 
-	void	draw(Image<double>& image,
+	void	draw(std::vector<ChartPoint>& points, const ImageSize& size,
 			const astro::image::transform::StereographicProjection& projection,
 			const Catalog::starsetptr stars) const;
 
-	void	draw(Image<double>& image,
+	void	draw(std::vector<ChartPoint>& points, const ImageSize& size,
 			const astro::image::transform::StereographicProjection& projection,
 			const Catalog::starset& stars) const;
 };
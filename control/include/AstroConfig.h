@@ -355,6 +355,20 @@ static DeviceMapperConfigurationPtr	get(ConfigurationPtr config);
 	virtual DeviceMapperPtr	devicemapper() = 0;
 };
 
+/**
+ * \brief FFTW planning settings from the configuration
+ *
+ * The keys global.fftw.measure, global.fftw.threads and global.fftw.wisdom
+ * are passed on to image::FFTWPlans, which does not depend on the
+ * configuration itself. Applications doing fourier transforms call
+ * apply() at startup.
+ */
+class FFTWConfiguration {
+public:
+static void	apply();
+static void	apply(ConfigurationPtr config);
+};
+
 } // namespace config
 } // namespace astro
 
@@ -14,6 +14,34 @@
 namespace astro {
 namespace image {
 
+/**
+ * \brief Process wide cache of FFTW plans
+ *
+ * Planning a transform is expensive, in particular with FFTW_MEASURE, and
+ * the FFTW planner must not be called from several threads at the same
+ * time. This class keeps one plan for each combination of size, direction
+ * and array alignment, and executes it on the arrays passed in with the
+ * new-array execute functions of FFTW, which are thread safe. Only
+ * out-of-place transforms are supported, the c2r transform destroys
+ * its input.
+ *
+ * Planning rigor, number of threads and the wisdom file are set by the
+ * applications at startup, config::FFTWConfiguration reads them from the
+ * configuration. Wisdom of measured plans is saved by save() and when
+ * the process exits.
+ */
+class FFTWPlans {
+public:
+	typedef enum { R2C, C2R } direction_type;
+static void	r2c(const ImageSize& size, double *in, fftw_complex *out);
+static void	c2r(const ImageSize& size, fftw_complex *in, double *out);
+static void	measure(bool m);
+static void	threads(int n);
+static void	wisdom(const std::string& filename);
+static void	save();
+static void	clear();
+};
+
 class FourierImage;
 typedef std::shared_ptr<FourierImage>	FourierImagePtr;
 
@@ -11,6 +11,9 @@
 #include <limits>
 #include <AstroDebug.h>
 #include <list>
+#include <vector>
+#include <algorithm>
+#include <cmath>
 #include <AstroFormat.h>
 #include <AstroFilter.h>
 
@@ -317,125 +320,422 @@ public:
 };
 
 /**
- * \brief Filter that finds the median of an image
+ * \brief Percentiles of an image
+ *
+ * The result of a PercentileFilter. The value for level q is the order
+ * statistic with index round(q * (n - 1)) of the n pixels that are not
+ * NaN, so the median of an even number of pixels is the upper of the
+ * two middle values.
  */
+class Percentiles {
+	size_t	_count;
+	std::vector<double>	_levels;
+	std::vector<double>	_values;
+	double	_mad;
+public:
+	Percentiles() : _count(0),
+		_mad(std::numeric_limits<double>::quiet_NaN()) { }
+	size_t	count() const { return _count; }
+	void	count(size_t c) { _count = c; }
+	const std::vector<double>&	levels() const { return _levels; }
+	const std::vector<double>&	values() const { return _values; }
+	void	add(double level, double value) {
+		_levels.push_back(level);
+		_values.push_back(value);
+	}
+	double	value(double level) const {
+		for (size_t i = 0; i < _levels.size(); i++) {
+			if (_levels[i] == level) {
+				return _values[i];
+			}
+		}
+		std::string	msg = stringprintf("percentile %f not computed",
+			level);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::range_error(msg);
+	}
+	double	median() const { return value(0.5); }
+	double	mad() const { return _mad; }
+	void	mad(double m) { _mad = m; }
+};
 
-template<typename T, typename S>
-class Median : public PixelTypeFilter<T, S> {
-	enum { N = 4 };
-	T	upper_limit;
-	T	lower_limit;
+/**
+ * \brief Index of the order statistic for a percentile level
+ */
+static inline size_t	percentile_rank(double level, size_t n) {
+	if (level <= 0) {
+		return 0;
+	}
+	if (level >= 1) {
+		return n - 1;
+	}
+	return (size_t)floor(level * (n - 1) + 0.5);
+}
 
-	T	median(const ConstImageAdapter<T>& image,
-			const T& left, const T& right);
+/**
+ * \brief Compute several percentiles of an image together
+ *
+ * For integer pixel types of at most 16 bits, all percentiles come
+ * from a histogram built in a single parallel pass over the image rows.
+ * For all other pixel types, a sample of the pixels is sorted to find
+ * a narrow bracket for each percentile. A single parallel pass then
+ * counts the pixels below each bracket and collects the pixels inside
+ * it, and nth_element on the collected pixels gives the exact value.
+ * If a bracket misses, which is very unlikely, all pixels are collected.
+ * Small images are always evaluated by collecting all pixels.
+ *
+ * The median absolute deviation is free for histogram types, for the
+ * other types it takes a second pass.
+ */
+template<typename T>
+class PercentileFilter {
+	std::vector<double>	_levels;
+	bool	_mad;
+	size_t	_samplesize;
+	bool	histogramtype(size_t pixels) const;
+	Percentiles	histogram(const ConstImageAdapter<T>& image) const;
+	template<typename F>
+	std::vector<double>	select(const ConstImageAdapter<T>& image,
+			const std::vector<double>& levels, F transform,
+			size_t& count) const;
+	Percentiles	selection(const ConstImageAdapter<T>& image) const;
 public:
-	Median() { }
-
-	virtual T	operator()(const ConstImageAdapter<T>& image);
-	virtual S	filter(const ConstImageAdapter<T>& image);
+	PercentileFilter(const std::vector<double>& levels, bool mad = false);
+	PercentileFilter(double level);
+	const std::vector<double>&	levels() const { return _levels; }
+	size_t	samplesize() const { return _samplesize; }
+	void	samplesize(size_t s) { _samplesize = (s < 100) ? 100 : s; }
+	Percentiles	operator()(const ConstImageAdapter<T>& image) const;
+	std::vector<Percentiles>	operator()(
+			const ConstImageAdapter<T>& image,
+			const std::vector<ImageRectangle>& tiles) const;
 };
 
-template<typename T, typename S>
-T	Median<T, S>::operator()(const ConstImageAdapter<T>& image) {
-	// compute the maximum value that we have to consider.
-	// this depends on whether we have a floating point type,
-	// in which case we have to compute the maximum and minimum,
-	// or whether we have an integer type, in which case we
-	// can use std::numeric_limits
-	T	lower_limit;
-	T	upper_limit;
-	// 
-	if (std::numeric_limits<T>::is_integer) {
-		lower_limit = 0;
-		upper_limit = std::numeric_limits<T>::max();
-	} else {
-		Min<T, S>	minfilter;
-		lower_limit = minfilter(image);
-		Max<T, S>	maxfilter;
-		upper_limit = maxfilter(image);
-	}
-	T	result = median(image, lower_limit, upper_limit);
-	return result;
+/**
+ * \brief Construct a filter for a set of percentile levels
+ *
+ * \param levels	percentile levels between 0 and 1
+ * \param mad		whether to also compute the median absolute
+ *			deviation, this adds the median to the levels
+ */
+template<typename T>
+PercentileFilter<T>::PercentileFilter(const std::vector<double>& levels,
+	bool mad) : _levels(levels), _mad(mad), _samplesize(65536) {
+	if (_mad && (std::find(_levels.begin(), _levels.end(), 0.5)
+		== _levels.end())) {
+		_levels.push_back(0.5);
+	}
 }
 
-template<typename T, typename S>
-S	Median<T, S>::filter(const ConstImageAdapter<T>& image) {
-	return (S)this->operator()(image);
+template<typename T>
+PercentileFilter<T>::PercentileFilter(double level)
+	: _levels(1, level), _mad(false), _samplesize(65536) {
 }
 
-template<typename T, typename S>
-T	Median<T, S>::median(const ConstImageAdapter<T>& image,
-		const T& left, const T& right) {
-	ImageSize	size = image.getSize();
-	size_t	pixels = size.getPixels();
-#if 0
-std::cout << "left: " << (unsigned int)left << ", right: "
-	<< (unsigned int)right << std::endl;
-#endif
-	unsigned long	count[N + 1];
-	T	limits[N + 1];
-	int	delta = 0;
-	// reset all the limit values 
-	for (unsigned int i = 0; i < N + 1; i++) {
-		count[i] = 0;
-		limits[i] = left + (i * (right - left)) / N;
-		if (i > 0) {
-			int	d = limits[i] - limits[i - 1];
-			if (d > delta) {
-				delta = d;
+/**
+ * \brief Whether to use a histogram
+ *
+ * A histogram only pays off if it is not much larger than the image.
+ */
+template<typename T>
+bool	PercentileFilter<T>::histogramtype(size_t pixels) const {
+	if (!std::numeric_limits<T>::is_integer || (sizeof(T) > 2)) {
+		return false;
+	}
+	return (4 * pixels) >= ((size_t)std::numeric_limits<T>::max() + 1);
+}
+
+/**
+ * \brief Percentiles from a histogram of the pixel values
+ */
+template<typename T>
+Percentiles	PercentileFilter<T>::histogram(
+		const ConstImageAdapter<T>& image) const {
+	int	w = image.getSize().width();
+	int	h = image.getSize().height();
+	size_t	bins = (size_t)std::numeric_limits<T>::max() + 1;
+	std::vector<unsigned long>	counts(bins, 0);
+#pragma omp parallel
+	{
+	std::vector<unsigned long>	local(bins, 0);
+	std::vector<T>	row(w);
+#pragma omp for schedule(static)
+	for (int y = 0; y < h; y++) {
+		image.readrow(y, 0, w, row.data());
+		for (int x = 0; x < w; x++) {
+			local[(size_t)row[x]]++;
+		}
+	}
+#pragma omp critical
+	for (size_t b = 0; b < bins; b++) {
+		counts[b] += local[b];
+	}
+	}
+
+	Percentiles	result;
+	size_t	n = (size_t)w * h;
+	result.count(n);
+	std::vector<double>::const_iterator	l;
+	for (l = _levels.begin(); l != _levels.end(); l++) {
+		size_t	k = percentile_rank(*l, n);
+		size_t	cumulative = 0;
+		size_t	b = 0;
+		while ((cumulative += counts[b]) <= k) {
+			b++;
+		}
+		result.add(*l, b);
+	}
+	if (_mad) {
+		// histogram of the absolute deviations from the median
+		size_t	m = result.median();
+		std::vector<unsigned long>	deviations(bins, 0);
+		for (size_t b = 0; b < bins; b++) {
+			deviations[(b > m) ? (b - m) : (m - b)] += counts[b];
+		}
+		size_t	k = percentile_rank(0.5, n);
+		size_t	cumulative = 0;
+		size_t	b = 0;
+		while ((cumulative += deviations[b]) <= k) {
+			b++;
+		}
+		result.mad(b);
+	}
+	return result;
+}
+
+/**
+ * \brief Select order statistics of transformed pixel values
+ *
+ * \param image		the image to evaluate
+ * \param levels	the percentile levels
+ * \param transform	function applied to each pixel value
+ * \param count		returns the number of pixels that are not NaN
+ */
+template<typename T>
+template<typename F>
+std::vector<double>	PercentileFilter<T>::select(
+		const ConstImageAdapter<T>& image,
+		const std::vector<double>& levels, F transform,
+		size_t& count) const {
+	int	w = image.getSize().width();
+	int	h = image.getSize().height();
+	size_t	pixels = (size_t)w * h;
+	size_t	nlevels = levels.size();
+	double	infinity = std::numeric_limits<double>::infinity();
+
+	// brackets from a sample, or no brackets at all for small images
+	std::vector<double>	lower(nlevels, -infinity);
+	std::vector<double>	upper(nlevels, infinity);
+	if (pixels > _samplesize) {
+		// a stride sharing a factor with the width would only visit
+		// a few columns, so use a stride coprime to the pixel count,
+		// wrapping around at the end of the image
+		size_t	stride = pixels / _samplesize;
+		for (;;) {
+			size_t	a = pixels, b = stride;
+			while (b > 0) {
+				size_t	r = a % b;
+				a = b;
+				b = r;
+			}
+			if (a == 1) {
+				break;
+			}
+			stride++;
+		}
+		std::vector<double>	sample(_samplesize);
+#pragma omp parallel for schedule(static)
+		for (size_t i = 0; i < _samplesize; i++) {
+			size_t	offset = (i * stride) % pixels;
+			sample[i] = transform((double)image.pixel(offset % w,
+				offset / w));
+		}
+		sample.erase(std::remove_if(sample.begin(), sample.end(),
+			[](double v) { return v != v; }), sample.end());
+		std::sort(sample.begin(), sample.end());
+		size_t	m = sample.size();
+		size_t	delta = 3 * sqrt((double)m) + 2;
+		for (size_t j = 0; (j < nlevels) && (m > 0); j++) {
+			size_t	k = percentile_rank(levels[j], m);
+			if (k > delta) {
+				lower[j] = sample[k - delta];
+			}
+			if (k + delta < m) {
+				upper[j] = sample[k + delta];
 			}
 		}
 	}
 
-	// count the number of values 
-	for (int x = 0; x < size.width(); x++) {
-		for (int y = 0; y < size.height(); y++) {
-			T	v = image.pixel(x, y);
-			for (unsigned int i = 0; i < N + 1; i++) {
-				if (v <= limits[i]) {
-					count[i]++;
+	// count the values below the brackets and collect the values inside
+	std::vector<size_t>	below(nlevels, 0);
+	std::vector<std::vector<double> >	inside(nlevels);
+	count = 0;
+#pragma omp parallel
+	{
+	std::vector<size_t>	localbelow(nlevels, 0);
+	std::vector<std::vector<double> >	localinside(nlevels);
+	size_t	localcount = 0;
+	std::vector<T>	row(w);
+#pragma omp for schedule(static)
+	for (int y = 0; y < h; y++) {
+		image.readrow(y, 0, w, row.data());
+		for (int x = 0; x < w; x++) {
+			double	v = transform((double)row[x]);
+			if (v != v) {
+				continue;
+			}
+			localcount++;
+			for (size_t j = 0; j < nlevels; j++) {
+				if (v < lower[j]) {
+					localbelow[j]++;
+				} else if (v <= upper[j]) {
+					localinside[j].push_back(v);
 				}
 			}
 		}
 	}
+#pragma omp critical
+	{
+	count += localcount;
+	for (size_t j = 0; j < nlevels; j++) {
+		below[j] += localbelow[j];
+		inside[j].insert(inside[j].end(), localinside[j].begin(),
+			localinside[j].end());
+	}
+	}
+	}
 
-	// terminal condition, if the delta <= 1, then we have
-	// enough resolution to determine the median
-	if (delta == 0) {
-		return limits[0];
+	std::vector<double>	result(nlevels,
+		std::numeric_limits<double>::quiet_NaN());
+	if (0 == count) {
+		return result;
+	}
+	bool	missed = false;
+	for (size_t j = 0; j < nlevels; j++) {
+		size_t	k = percentile_rank(levels[j], count);
+		if ((k < below[j]) || (k >= below[j] + inside[j].size())) {
+			missed = true;
+			continue;
+		}
+		std::vector<double>::iterator	nth
+			= inside[j].begin() + (k - below[j]);
+		std::nth_element(inside[j].begin(), nth, inside[j].end());
+		result[j] = *nth;
+	}
+	if (!missed) {
+		return result;
 	}
-	if (delta <= 1) {
-		for (unsigned int i = 1; i < N + 1; i++) {
-			if (((2 * count[i - 1]) < pixels)
-				&& (pixels <= (2 * count[i]))) {
-				return (limits[i - 1] + limits[i]) / 2;
+
+	// a bracket missed the percentile, so collect all values
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "percentile bracket missed");
+	std::vector<double>	values;
+	values.reserve(count);
+	std::vector<T>	row(w);
+	for (int y = 0; y < h; y++) {
+		image.readrow(y, 0, w, row.data());
+		for (int x = 0; x < w; x++) {
+			double	v = transform((double)row[x]);
+			if (v == v) {
+				values.push_back(v);
 			}
 		}
 	}
+	for (size_t j = 0; j < nlevels; j++) {
+		std::vector<double>::iterator	nth = values.begin()
+			+ percentile_rank(levels[j], count);
+		std::nth_element(values.begin(), nth, values.end());
+		result[j] = *nth;
+	}
+	return result;
+}
 
-	// now we know how many values are in each bucket
-#if 0
-	for (int i = 0; i < N + 1; i++) {
-		std::cout << "limit: " << limits[i]
-			<< ", count: " << count[i] << std::endl;
+/**
+ * \brief Percentiles by sampling and selection
+ */
+template<typename T>
+Percentiles	PercentileFilter<T>::selection(
+		const ConstImageAdapter<T>& image) const {
+	Percentiles	result;
+	size_t	count;
+	std::vector<double>	values = select(image, _levels,
+		[](double v) { return v; }, count);
+	result.count(count);
+	for (size_t j = 0; j < _levels.size(); j++) {
+		result.add(_levels[j], values[j]);
 	}
-#endif
-	// now find out in which interval we have to expect the
-	// median
-	
-	if ((2 * count[N]) < pixels) {
-		return median(image, limits[N], upper_limit);
+	if (_mad && (count > 0)) {
+		double	m = result.median();
+		std::vector<double>	half(1, 0.5);
+		result.mad(select(image, half,
+			[m](double v) { return fabs(v - m); }, count)[0]);
 	}
-	if (pixels <= (2 * count[0])) {
-		return median(image, 0, limits[0]);
+	return result;
+}
+
+/**
+ * \brief Compute the percentiles of an image
+ */
+template<typename T>
+Percentiles	PercentileFilter<T>::operator()(
+		const ConstImageAdapter<T>& image) const {
+	if (histogramtype(image.getSize().getPixels())) {
+		return histogram(image);
 	}
-	for (unsigned int i = 1; i < N + 1; i++) {
-		if (((2 * count[i - 1]) < pixels)
-			&& (pixels <= (2 * count[i]))) {
-			return median(image, limits[i - 1], limits[i]);
+	return selection(image);
+}
+
+/**
+ * \brief Compute the percentiles of each tile of an image
+ *
+ * The tiles are evaluated in parallel, e.g. for background meshes.
+ */
+template<typename T>
+std::vector<Percentiles>	PercentileFilter<T>::operator()(
+		const ConstImageAdapter<T>& image,
+		const std::vector<ImageRectangle>& tiles) const {
+	for (size_t i = 0; i < tiles.size(); i++) {
+		if (!tiles[i].fits(image.getSize())) {
+			std::string	msg = stringprintf("tile %s outside %s",
+				tiles[i].toString().c_str(),
+				image.getSize().toString().c_str());
+			debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+			throw std::range_error(msg);
 		}
 	}
-	throw std::logic_error("error in median computation");
+	std::vector<Percentiles>	result(tiles.size());
+#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < (int)tiles.size(); i++) {
+		astro::adapter::WindowAdapter<T>	window(image, tiles[i]);
+		result[i] = (*this)(window);
+	}
+	return result;
+}
+
+/**
+ * \brief Filter that finds the median of an image
+ */
+template<typename T, typename S>
+class Median : public PixelTypeFilter<T, S> {
+public:
+	Median() { }
+
+	virtual T	operator()(const ConstImageAdapter<T>& image);
+	virtual S	filter(const ConstImageAdapter<T>& image);
+};
+
+template<typename T, typename S>
+T	Median<T, S>::operator()(const ConstImageAdapter<T>& image) {
+	PercentileFilter<T>	percentiles(0.5);
+	Percentiles	result = percentiles(image);
+	if (0 == result.count()) {
+		return 0;
+	}
+	return (T)result.median();
+}
+
+template<typename T, typename S>
+S	Median<T, S>::filter(const ConstImageAdapter<T>& image) {
+	return (S)this->operator()(image);
 }
 
 /**
@@ -685,25 +985,17 @@ FWHMInfo	FWHM2<Pixel>::filter_extended(const ConstImageAdapter<Pixel>& image) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "found maximum %f at %s",
 		(double)maxvalue, target.toString().c_str());
 
-	// collect points that have pixel value > half maximum
-	astro::adapter::LevelMaskAdapter<Pixel>	lma(image, maxvalue / 2.);
-	Image<unsigned char>	levelmask(lma);
-
-	// extract the connected component of this levelmask
-	WindowedImage<unsigned char>	*connected
-		= ConnectedComponentBase(target).component(levelmask);
-	result.mask = ImagePtr(new Image<unsigned char>(*connected));
+	// label the pixels of at least half maximum, the star is the
+	// component containing the maximum
+	ComponentLabeler	labeler;
+	labeler(image, maxvalue / 2.);
+	unsigned int	label = labeler.label(target);
+	Image<unsigned char>	*mask = new Image<unsigned char>(width, height);
+	labeler.mask(label, *mask);
+	result.mask = ImagePtr(mask);
 
 	// add points in connected component to the list
-	std::list<ImagePoint>	points;
-	for (int x = 0; x < width; x++) {
-		for (int y = 0; y < height; y++) {
-			if (connected->pixel(x, y)) {
-				points.push_back(ImagePoint(x, y));
-			}
-		}
-	}
-	delete connected;
+	std::list<ImagePoint>	points = labeler.points(label);
 
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "found %d points", points.size());
 	
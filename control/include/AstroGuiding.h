@@ -238,6 +238,8 @@ protected:
 	Image<double>	*_image;
 	double	_lastimagetime;
 	Point	_offset;
+	// correlator prepared with the current reference image
+	image::transform::PhaseCorrelator	_correlator;
 	bool	refreshNeeded();
 	void	refresh(const ConstImageAdapter<double>& adapter,
 			const Point offset = Point());
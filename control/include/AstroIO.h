@@ -122,6 +122,8 @@ protected:
 	int	pixeltype;
 	int	planes;
 	int	imgtype;
+	void	writekey(const std::string& keyword, const Metavalue& value,
+			bool update);
 
 	FITSfile(const std::string & filename,
 		int _pixeltype, int _planes, int _imgtype);
@@ -136,6 +138,9 @@ public:
 	ImageMetadata	getAllMetadata() const;
 };
 
+class FITSheader;
+typedef std::shared_ptr<const FITSheader>	FITSheaderPtr;
+
 /**
  * \brief Base class for reading files
  *
@@ -145,6 +150,11 @@ public:
  * each FITS file we are reading.
  */
 class FITSinfileBase : public FITSfile {
+	// memory buffer for files read from memory, cfitsio keeps a
+	// reference to these two variables while the file is open
+	void	*_membuffer;
+	size_t	_membuffersize;
+	void	setup();
 protected:
 	/**
 	 * \brief Size of the image we are about to read
@@ -156,10 +166,13 @@ protected:
 	void	addHeaders(ImageBase *image) const;
 public:
 	FITSinfileBase(const std::string& filename);
+	FITSinfileBase(const void *buffer, size_t buffersize);
 	ImageSize	getSize() const { return size; }
 	// header access
 	bool	hasHeader(const std::string& key) const;
 	std::string	getHeader(const std::string& key) const;
+	// header only access through the header cache
+static FITSheaderPtr	header(const std::string& filename);
 };
 
 /**
@@ -169,9 +182,72 @@ template<typename Pixel>
 class FITSinfile : public FITSinfileBase {
 public:
 	FITSinfile(const std::string& filename) : FITSinfileBase(filename) { }
+	FITSinfile(const void *buffer, size_t buffersize)
+		: FITSinfileBase(buffer, buffersize) { }
 	Image<Pixel>	*read();
 };
 
+/**
+ * \brief Header information of a FITS file
+ *
+ * A FITSheader contains everything the FITSinfileBase class reads
+ * from a file before the pixel data, so that metadata queries do not
+ * have to decode the pixels.
+ */
+class FITSheader {
+	ImageSize	_size;
+	int	_pixeltype;
+	int	_planes;
+	int	_imgtype;
+	ImageMetadata	_metadata;
+public:
+	FITSheader(const FITSinfileBase& infile);
+	const ImageSize&	getSize() const { return _size; }
+	int	getPixeltype() const { return _pixeltype; }
+	int	getPlanes() const { return _planes; }
+	int	getImgtype() const { return _imgtype; }
+	int	getBytesPerPlane() const;
+	int	getBytesPerPixel() const { return _planes * getBytesPerPlane(); }
+	std::type_index	getPixelType() const;
+	bool	hasMetadata(const std::string& key) const;
+	Metavalue	getMetadata(const std::string& key) const;
+	const ImageMetadata&	getAllMetadata() const { return _metadata; }
+};
+
+/**
+ * \brief Cache of recently read FITS headers
+ *
+ * The cache keeps the headers of the most recently used files. An entry
+ * is only used as long as modification time, size and inode of the file
+ * have not changed, so files modified by other processes are read again.
+ */
+class FITSheaderCache {
+public:
+static size_t	capacity();
+static void	capacity(size_t c);
+static FITSheaderPtr	get(const std::string& filename);
+static void	invalidate(const std::string& filename);
+static void	clear();
+static unsigned long	hits();
+static unsigned long	misses();
+};
+
+/**
+ * \brief Update the headers of an existing FITS file in place
+ *
+ * Keywords are changed in the header blocks of the file, new keywords
+ * use the blank space at the end of the last header block. Only if that
+ * space is exhausted, a new header block has to be inserted in front of
+ * the pixel data. The pixel data itself is never decoded.
+ */
+class FITSupdatefile : public FITSfile {
+public:
+	FITSupdatefile(const std::string& filename);
+	virtual ~FITSupdatefile();
+	void	setMetadata(const Metavalue& value);
+	void	setMetadata(const ImageMetadata& metadata);
+};
+
 /**
  * \brief Convert the pixels read from the FITS file into 
  *
@@ -326,13 +402,22 @@ Image<Pixel>	*FITSinfile<Pixel>::read() {
  */
 class FITSoutfileBase : public FITSfile {
 	bool	_precious;
+	// target of an in memory FITS file, owned by the caller
+	void	**_buffer;
+	size_t	*_buffersize;
+	void	create();
+	void	creatememory(const ImageBase& image);
 public:
 	FITSoutfileBase(const std::string & filename,
 		int _pixeltype, int _planes, int _imgtype);
+	FITSoutfileBase(void **buffer, size_t *buffersize,
+		int _pixeltype, int _planes, int _imgtype);
 	void	write(const ImageBase& image);
 	void	postwrite();
 	bool	precious() const { return _precious; }
 	void	setPrecious(bool precious) { _precious = precious; }	
+	bool	inmemory() const { return NULL != _buffer; }
+	size_t	filesize() const;
 };
 
 /**
@@ -342,6 +427,7 @@ template<class Pixel>
 class FITSoutfile : public FITSoutfileBase {
 public:
 	FITSoutfile(const std::string& filename);
+	FITSoutfile(void **buffer, size_t *buffersize);
 	void	write(const Image<Pixel>& image);
 };
 
@@ -353,12 +439,26 @@ FITSoutfile<Pixel>::FITSoutfile(const std::string& filename)
 	: FITSoutfileBase(filename, TBYTE, 1, BYTE_IMG) {
 }
 
+/**
+ * \brief Create an in memory FITS file for writing
+ *
+ * The buffer and buffersize pointers must remain valid for the lifetime
+ * of the FITSoutfile object. After the object has been destroyed, the
+ * buffer belongs to the caller and must be released with free().
+ */
+template<class Pixel>
+FITSoutfile<Pixel>::FITSoutfile(void **buffer, size_t *buffersize)
+	: FITSoutfileBase(buffer, buffersize, TBYTE, 1, BYTE_IMG) {
+}
+
 // Specializations for just about any type. They are all needed, because
 // this is where we map the pixel type and image type codes from the
 // CFITSIO library to C++ types
 #define	FITS_OUTFILE_SPECIALIZATION(T)					\
 template<>								\
-FITSoutfile<T >::FITSoutfile(const std::string& filename);
+FITSoutfile<T >::FITSoutfile(const std::string& filename);		\
+template<>								\
+FITSoutfile<T >::FITSoutfile(void **buffer, size_t *buffersize);
 
 FITS_OUTFILE_SPECIALIZATION(unsigned char)
 FITS_OUTFILE_SPECIALIZATION(unsigned short)
@@ -391,6 +491,9 @@ FITS_OUTFILE_SPECIALIZATION(YUYV<double>)
 #define	FITS_OUTFILE_SPECIALIZATION_MULTI(T, N)				\
 template<>								\
 FITSoutfile<Multiplane<T, N> >::FITSoutfile(const std::string& filename);\
+template<>								\
+FITSoutfile<Multiplane<T, N> >::FITSoutfile(void **buffer,		\
+	size_t *buffersize);
 
 FITS_OUTFILE_SPECIALIZATION_MULTI(unsigned char, 1)
 FITS_OUTFILE_SPECIALIZATION_MULTI(unsigned short, 1)
@@ -676,13 +779,17 @@ void	FITSoutfile<Pixel>::write(const Image<Pixel>& image) {
  *
  * The ImagePtr is independent of the pixel type. This class can determine
  * the pixel type and use an appropriate FITSoutfile<Pixel> instance to
- * write the image.
+ * write the image. If constructed with a buffer pointer, the FITS data
+ * is written to a malloc()ed memory buffer instead of a file.
  */
 class FITSout {
 	std::string	filename;
 	bool	_precious;
+	void	**_buffer;
+	size_t	*_buffersize;
 public:
 	FITSout(const std::string& filename);
+	FITSout(void **buffer, size_t *buffersize);
 	bool	exists() const;
 	void	unlink();
 	bool	precious() const { return _precious; }
@@ -694,15 +801,38 @@ public:
  * \brief Read a generic image as a FITS file
  *
  * Read the image file and create an appropriate Image<P> object, then
- * wrap it in an ImagePtr.
+ * wrap it in an ImagePtr. The FITS data can also come from a memory buffer,
+ * in which case no temporary file is needed.
  */
 class FITSin {
 	std::string	filename;
+	const void	*_buffer;
+	size_t	_buffersize;
 public:
 	FITSin(const std::string& filename);
+	FITSin(const void *buffer, size_t buffersize);
 	ImagePtr	read();
 };
 
+/**
+ * \brief Lossless delta/Rice compression for 16 bit pixel arrays
+ *
+ * Raw image streams do not need the overhead of a FITS file, but 16 bit
+ * camera images compress well when neighbouring pixels are differenced.
+ * This class encodes the differences with a Rice code, using a separate
+ * Rice parameter for each block of values.
+ */
+class RiceCoder {
+	int	_blocksize;
+public:
+	RiceCoder(int blocksize = 32);
+	int	blocksize() const { return _blocksize; }
+	void	encode(const unsigned short *values, size_t n,
+			std::vector<unsigned char>& result) const;
+	void	decode(const unsigned char *data, size_t datasize,
+			unsigned short *values, size_t n) const;
+};
+
 /**
  * \brief Image directory
  */
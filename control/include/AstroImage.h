@@ -643,6 +643,21 @@ public:
 		return pixel(p.x(), p.y());
 	}
 
+	/**
+	 * \brief Read n consecutive pixels of row y starting at x0
+	 *
+	 * The default implementation calls pixel() for each pixel. Adapters
+	 * that can compute a whole row more efficiently, e.g. because they
+	 * just forward rows of an underlying image, override this method.
+	 * Consumers walking through an image should use this method in
+	 * row order, because it matches the memory layout of Image.
+	 */
+	virtual void	readrow(int y, int x0, int n, Pixel *out) const {
+		for (int i = 0; i < n; i++) {
+			out[i] = pixel(x0 + i, y);
+		}
+	}
+
 	/**
 	 * \brief Give some information about the image (including pixel type)
 	 */
@@ -774,12 +789,7 @@ public:
 			pixels);
 		statistics::Memory::image_allocate(number_of_pixels,
 			sizeof(Pixel));
-#		pragma omp parallel for
-		for (int x = 0; x < frame.size().width(); x++) {
-			for (int y = 0; y < frame.size().height(); y++) {
-				pixel(x, y) = adapter.pixel(x, y);
-			}
-		}
+		copyrows(adapter);
 	}
 
 	/**
@@ -803,13 +813,7 @@ public:
 			frame.size().getPixels(), pixels);
 		statistics::Memory::image_allocate(number_of_pixels,
 			sizeof(Pixel));
-#		pragma omp parallel for
-		for (int x = 0; x < frame.size().width(); x++) {
-			for (int y = 0; y < frame.size().height(); y++) {
-//debug(LOG_DEBUG, DEBUG_LOG, 0, "x = %4d, y = %4d, scalefactor = %f", x, y, scalefactor);
-				pixel(x, y) = adapter.pixel(x, y) * scalefactor;
-			}
-		}
+		copyrows(adapter, scalefactor);
 	}
 
 	/**
@@ -918,12 +922,7 @@ public:
 			debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
 			throw std::length_error(msg);
 		}
-#		pragma omp parallel for
-		for (int x = 0; x < other.getSize().width(); x++) {
-			for (int y = 0; y < other.getSize().height(); y++) {
-				pixel(x, y) = other.pixel(x, y);
-			}
-		}
+		copyrows(other);
 		return *this;
 	}
 
@@ -988,6 +987,60 @@ public:
 		return writablepixel(p.x(), p.y());
 	}
 
+	/**
+	 * \brief Read a row segment directly from the pixel array
+	 */
+	virtual void	readrow(int y, int x0, int n, Pixel *out) const {
+		const Pixel	*p = pixels + pixeloffset(x0, y);
+		std::copy(p, p + n, out);
+	}
+
+private:
+	/**
+	 * \brief Copy the pixels of an adapter into the pixel array
+	 *
+	 * The rows are distributed over the threads, each thread reads
+	 * complete rows from the adapter, so the pixel array is written
+	 * in the order of its memory layout.
+	 */
+	template<typename srcPixel>
+	void	copyrows(const ConstImageAdapter<srcPixel>& adapter) {
+		int	w = frame.size().width();
+		int	h = frame.size().height();
+#		pragma omp parallel
+		{
+			std::vector<srcPixel>	row(w);
+#			pragma omp for schedule(static)
+			for (int y = 0; y < h; y++) {
+				adapter.readrow(y, 0, w, row.data());
+				Pixel	*p = pixels + pixeloffset(0, y);
+				for (int x = 0; x < w; x++) {
+					p[x] = row[x];
+				}
+			}
+		}
+	}
+
+	template<typename srcPixel>
+	void	copyrows(const ConstImageAdapter<srcPixel>& adapter,
+			double scalefactor) {
+		int	w = frame.size().width();
+		int	h = frame.size().height();
+#		pragma omp parallel
+		{
+			std::vector<srcPixel>	row(w);
+#			pragma omp for schedule(static)
+			for (int y = 0; y < h; y++) {
+				adapter.readrow(y, 0, w, row.data());
+				Pixel	*p = pixels + pixeloffset(0, y);
+				for (int x = 0; x < w; x++) {
+					p[x] = row[x] * scalefactor;
+				}
+			}
+		}
+	}
+public:
+
 	// Iterators come either from Rows or from Columns
 	class	iterator;
 	class	const_iterator;
@@ -1546,6 +1599,126 @@ public:
 	}
 };
 
+/**
+ * \brief Statistics of a connected component
+ *
+ * The statistics are accumulated while the component is labeled, so
+ * no further pass over the image is needed to get area, bounding box,
+ * flux weighted centroid and peak of a component.
+ */
+class ComponentStatistics {
+	unsigned long	_area;
+	int	_xmin, _ymin, _xmax, _ymax;
+	double	_flux, _xmoment, _ymoment;
+	double	_peak;
+	ImagePoint	_peakpoint;
+public:
+	ComponentStatistics();
+	void	add(int x, int y, double value) {
+		_area++;
+		if (x < _xmin) { _xmin = x; }
+		if (x > _xmax) { _xmax = x; }
+		if (y < _ymin) { _ymin = y; }
+		if (y > _ymax) { _ymax = y; }
+		_flux += value;
+		_xmoment += x * value;
+		_ymoment += y * value;
+		if (value > _peak) {
+			_peak = value;
+			_peakpoint = ImagePoint(x, y);
+		}
+	}
+	void	add(const ComponentStatistics& other);
+	unsigned long	area() const { return _area; }
+	ImageRectangle	boundingbox() const;
+	double	flux() const { return _flux; }
+	double	xcentroid() const;
+	double	ycentroid() const;
+	double	peak() const { return _peak; }
+	const ImagePoint&	peakpoint() const { return _peakpoint; }
+	std::string	toString() const;
+};
+
+/**
+ * \brief Label all connected components of an image
+ *
+ * Pixels with a value of at least the threshold belong to some component.
+ * The labeler finds all components in two passes with a union find
+ * structure: the first pass assigns provisional labels and records
+ * which of them are connected, the second replaces them by the final
+ * labels 1, 2, ... in the order in which the components first appear.
+ * The first pass works on horizontal strips in parallel, the strips
+ * are then joined along their boundary rows. Labels are 0 for pixels
+ * that do not belong to any component.
+ */
+class ComponentLabeler {
+	bool	_eightconnected;
+	ImageSize	_size;
+	std::vector<unsigned int>	_labels;
+	std::vector<ComponentStatistics>	_components;
+	struct Strip {
+		int	ymin, ymax;
+		std::vector<unsigned int>	parent;
+		std::vector<ComponentStatistics>	statistics;
+	};
+	std::vector<Strip>	_strips;
+	void	begin(const ImageSize& size);
+	void	labelrow(Strip& strip, int y, const double *values,
+			double threshold);
+	void	end();
+public:
+	ComponentLabeler(bool eightconnected = false);
+	template<typename Pixel>
+	void	operator()(const ConstImageAdapter<Pixel>& image,
+			double threshold);
+	const ImageSize&	size() const { return _size; }
+	unsigned int	ncomponents() const { return _components.size(); }
+	const std::vector<ComponentStatistics>&	components() const {
+		return _components;
+	}
+	const ComponentStatistics&	component(unsigned int label) const;
+	unsigned int	label(int x, int y) const {
+		return _labels[(size_t)y * _size.width() + x];
+	}
+	unsigned int	label(const ImagePoint& point) const {
+		return label(point.x(), point.y());
+	}
+	void	mask(unsigned int label, ImageAdapter<unsigned char>& image,
+			const ImagePoint& origin = ImagePoint()) const;
+	std::list<ImagePoint>	points(unsigned int label) const;
+};
+
+/**
+ * \brief Label the components of the pixels at or above a threshold
+ *
+ * Pixels are converted to double for the statistics, NaN pixels never
+ * belong to a component.
+ */
+template<typename Pixel>
+void	ComponentLabeler::operator()(const ConstImageAdapter<Pixel>& image,
+		double threshold) {
+	begin(image.getSize());
+	int	width = _size.width();
+	int	nstrips = _strips.size();
+#pragma omp parallel
+	{
+		std::vector<Pixel>	row(width);
+		std::vector<double>	values(width);
+#pragma omp for schedule(dynamic)
+		for (int s = 0; s < nstrips; s++) {
+			Strip&	strip = _strips[s];
+			for (int y = strip.ymin; y < strip.ymax; y++) {
+				image.readrow(y, 0, width, row.data());
+				for (int x = 0; x < width; x++) {
+					values[x] = row[x];
+				}
+				labelrow(strip, y, values.data(), threshold);
+			}
+		}
+	}
+	end();
+}
+
 /**
  * \brief connected component criterion
  *
@@ -1573,9 +1746,6 @@ protected:
 	ImagePoint	_point;
 	ImageRectangle	_roi;
 	void	setupRoi(const ImageRectangle& roi);
-	unsigned char	growpixel(ImageAdapter<unsigned char>& image,
-				int x, int y) const;
-	int	grow(ImageAdapter<unsigned char>& image) const;
 public:
 	ConnectedComponentBase(const ImagePoint& point);
 	ConnectedComponentBase(const ImagePoint& point,
@@ -1593,8 +1763,8 @@ public:
  * \brief General connected component class for an arbitrarily typed image
  *
  * The _criterion member decides whether points should at all be considered
- * for the connected component, these points then are iteratively grown into
- * a connected component.
+ * for the connected component, the component containing the point is then
+ * found with a ComponentLabeler.
  */
 template<typename Pixel>
 class ConnectedComponent : public ConnectedComponentBase {
@@ -15,10 +15,18 @@ using namespace astro::image;
 using namespace astro::callback;
 
 namespace astro {
+namespace calibration {
+class CalibrationKernel;
+typedef std::shared_ptr<CalibrationKernel>	CalibrationKernelPtr;
+} // namespace calibration
+
 namespace camera {
 
 class Imager {
 private:
+	// kernel for the frame of the last image calibrated
+	calibration::CalibrationKernelPtr	_kernel;
+	ImageRectangle	_kernelframe;
 	ImagePtr	_dark;
 public:
 	ImagePtr	dark() const { return _dark; }
@@ -29,7 +37,10 @@ private:
 	bool	_darksubtract;
 public:
 	bool	darksubtract() const { return _darksubtract; }
-	void	darksubtract(bool darksubtract) { _darksubtract = darksubtract; }
+	void	darksubtract(bool darksubtract) {
+		_darksubtract = darksubtract;
+		_kernel.reset();
+	}
 
 private:
 	ImagePtr	_flat;
@@ -42,7 +53,10 @@ private:
 	bool	_flatdivide;
 public:
 	bool	flatdivide() const { return _flatdivide; }
-	void	flatdivide(bool flatdivide) { _flatdivide = flatdivide; }
+	void	flatdivide(bool flatdivide) {
+		_flatdivide = flatdivide;
+		_kernel.reset();
+	}
 
 private:
 	int	_interpolation;
@@ -10,10 +10,17 @@
 #include <list>
 #include <vector>
 #include <map>
+#include <set>
+#include <unordered_map>
 #include <memory>
 #include <algorithm>
 #include <stdexcept>
 #include <sys/time.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
 #include <AstroFormat.h>
 #include <AstroDebug.h>
 
@@ -110,17 +117,43 @@ public:
 
 std::ostream&	operator<<(std::ostream& out, const Field& field);
 
+/**
+ * \brief Map from column names to column numbers
+ *
+ * The index is built once per query and shared by all rows of the
+ * result, so that access to a field by name is a hash lookup.
+ */
+class ColumnIndex : public std::unordered_map<std::string, int> {
+public:
+	ColumnIndex() { }
+	ColumnIndex(const std::vector<std::string>& names);
+	int	column(const std::string& name) const;
+};
+typedef std::shared_ptr<const ColumnIndex>	ColumnIndexPtr;
+
 /**
  * \brief A Row is a vector of fields, together with a vector of field names
  * 
- * A row can access fiel values by name
+ * A row can access fiel values by name. Rows retrieved from the database
+ * share the column index of the query, rows without an index are
+ * searched linearly.
  */
 class Row : public std::vector<Field> {
+	ColumnIndexPtr	_index;
 public:
+	void	index(ColumnIndexPtr index) { _index = index; }
 	const FieldValuePtr&	operator[](const size_t idx) const {
 		return std::vector<Field>::operator[](idx).second;
 	}
 	const FieldValuePtr&	operator[](const std::string& fieldname) const {
+		if (_index) {
+			ColumnIndex::const_iterator	c
+				= _index->find(fieldname);
+			if ((c != _index->end()) && (c->second < (int)size())) {
+				return std::vector<Field>::operator[](
+					c->second).second;
+			}
+		}
 		std::vector<Field>::const_iterator	i
 			= std::find(begin(), end(), fieldname);
 		if (i == end()) {
@@ -144,6 +177,129 @@ public:
 
 std::ostream&	operator<<(std::ostream& out, const Result& result);
 
+/**
+ * \brief Streaming access to the rows of a query result
+ *
+ * A cursor reads the values of the current row directly from the
+ * statement, no objects are created for the rows or the fields. Column
+ * numbers should be looked up once using column() and then used for
+ * all rows.
+ */
+class Cursor {
+public:
+	typedef enum { null_type, integer_type, double_type, string_type }
+		column_type;
+	virtual ~Cursor() { }
+	virtual bool	next() = 0;
+	virtual int	columns() const = 0;
+	virtual const ColumnIndex&	index() const = 0;
+	int	column(const std::string& name) const {
+		return index().column(name);
+	}
+	virtual column_type	type(int colno) const = 0;
+	bool	isnull(int colno) const { return type(colno) == null_type; }
+	virtual long	intValue(int colno) const = 0;
+	virtual double	doubleValue(int colno) const = 0;
+	virtual std::string	stringValue(int colno) const = 0;
+	time_t	timeValue(int colno) const;
+	struct timeval	timevalValue(int colno) const;
+};
+typedef std::shared_ptr<Cursor>	CursorPtr;
+
+/**
+ * \brief A field of the current row of a cursor
+ *
+ * The arrow operator makes a CursorField usable like the FieldValuePtr
+ * returned by a Row.
+ */
+class CursorField {
+	const Cursor&	_cursor;
+	int	_colno;
+public:
+	CursorField(const Cursor& cursor, int colno)
+		: _cursor(cursor), _colno(colno) { }
+	const CursorField	*operator->() const { return this; }
+	bool	isnull() const { return _cursor.isnull(_colno); }
+	long	intValue() const { return _cursor.intValue(_colno); }
+	double	doubleValue() const { return _cursor.doubleValue(_colno); }
+	std::string	stringValue() const {
+		return _cursor.stringValue(_colno);
+	}
+	time_t	timeValue() const { return _cursor.timeValue(_colno); }
+	struct timeval	timevalValue() const {
+		return _cursor.timevalValue(_colno);
+	}
+};
+
+/**
+ * \brief The current row of a cursor with the interface of a Row
+ *
+ * Table adapters whose row_to_object is a template accepting both Row
+ * and CursorRow can convert the rows of a cursor without creating any
+ * field objects, see ObjectCollector.
+ */
+class CursorRow {
+	const Cursor&	_cursor;
+public:
+	CursorRow(const Cursor& cursor) : _cursor(cursor) { }
+	CursorField	operator[](const std::string& fieldname) const {
+		return CursorField(_cursor, _cursor.column(fieldname));
+	}
+};
+
+/**
+ * \brief Visitor converting the rows of a cursor with a table adapter
+ */
+template<typename object, typename dbadapter>
+class ObjectCollector {
+public:
+	std::list<object>	objects;
+	void	operator()(const Cursor& cursor) {
+		CursorRow	row(cursor);
+		objects.push_back(dbadapter::row_to_object(
+			row["id"]->intValue(), row));
+	}
+};
+
+/**
+ * \brief A query result stored in columns
+ *
+ * Each column is kept in a contiguous vector of the type of its values,
+ * which avoids the field objects of a Result. This is the preferred way
+ * to load large results, like the points of a tracking history.
+ */
+class ColumnResult {
+	class Column {
+	public:
+		Cursor::column_type	type;
+		std::vector<long>	integers;
+		std::vector<double>	doubles;
+		std::vector<std::string>	strings;
+		std::vector<bool>	nulls;
+		Column() : type(Cursor::null_type) { }
+		void	append(const Cursor& cursor, int colno, size_t row);
+	};
+	ColumnIndexPtr	_index;
+	std::vector<Column>	_columns;
+	size_t	_rows;
+	const Column&	col(int colno) const;
+public:
+	ColumnResult(Cursor& cursor);
+	size_t	size() const { return _rows; }
+	int	columns() const { return _columns.size(); }
+	int	column(const std::string& name) const {
+		return _index->column(name);
+	}
+	Cursor::column_type	type(int colno) const { return col(colno).type; }
+	bool	isnull(size_t row, int colno) const;
+	long	intValue(size_t row, int colno) const;
+	double	doubleValue(size_t row, int colno) const;
+	std::string	stringValue(size_t row, int colno) const;
+	time_t	timeValue(size_t row, int colno) const;
+	const std::vector<long>&	integers(int colno) const;
+	const std::vector<double>&	doubles(int colno) const;
+};
+
 /**
  * \brief Interface for statements
  *
@@ -177,6 +333,8 @@ protected:
 	virtual Row	row() = 0;
 public:
 	virtual Result	result() = 0;
+	// the statement must live as long as the cursor
+	virtual CursorPtr	cursor() = 0;
 	virtual int	integerColumn(int colno) = 0;
 	virtual double	doubleColumn(int colno) = 0;
 	virtual std::string	stringColumn(int colno) = 0;
@@ -184,15 +342,39 @@ public:
 
 typedef std::shared_ptr<Statement>	StatementPtr;
 
+class BatchWriter;
+
 /**
  * \brief The generic backend interface
  *
  * This class only defines the interface, a derived backend class will
  * implement the methods for a particular type of database. Thus applications
  * using this interface are not tied to the actual database system used.
+ *
+ * All threads using a backend share its connection, so transactions are
+ * serialized through the transaction mutex: begin() acquires it, and the
+ * commit() or rollback() that ends the transaction releases it. Single
+ * statements hold it while they execute, so that they don't become part
+ * of a transaction of another thread. Rolling back to a savepoint does
+ * not end it, it still has to be released with commit(savepoint).
  */
 class DatabaseBackend {
+	std::recursive_mutex	_transaction_mutex;
+	std::atomic<std::thread::id>	_transaction_owner;
+	int	_transaction_depth;
+	std::mutex	_writer_mutex;
+	std::shared_ptr<BatchWriter>	_writer;
+protected:
+	void	lock_transaction();
+	void	unlock_transaction();
+	void	stopwriter();
 public:
+	DatabaseBackend() : _transaction_depth(0) { }
+	virtual ~DatabaseBackend() { }
+	std::recursive_mutex&	transaction_mutex() {
+		return _transaction_mutex;
+	}
+	std::shared_ptr<BatchWriter>	writer(bool create);
 	virtual std::string	escape(const std::string& value) = 0;
 	virtual Result	query(const std::string& query) = 0;
 	virtual std::vector<std::string>
@@ -241,7 +423,9 @@ protected:
 	std::string	_tablename;
 	std::vector<std::string>	_fieldnames;
 	std::string	selectquery() const;
+	void	sync();
 protected:
+	StatementPtr	selectstatement(const std::string& condition);
 	Database	database() { return _database; }
 public:
 	TableBase(Database database, const std::string& tablename,
@@ -260,9 +444,68 @@ public:
 	void	remove(const std::string& condition);
 	std::list<long>	selectids(const std::string& condition);
 	Result	selectrows(const std::string& condition);
+	ColumnResult	selectcolumns(const std::string& condition);
 	bool	has(const std::string& condition);
 };
 
+/**
+ * \brief Writer that collects inserts and commits them in batches
+ *
+ * Inserting rows one at a time in autocommit mode costs a transaction
+ * per row, which is too slow for data produced at high rates, like
+ * tracking points. The batch writer queues rows and a background thread
+ * writes them in a single transaction as soon as maxrows rows are queued
+ * or the oldest row has waited for maxdelay milliseconds.
+ *
+ * Ids are assigned when a row is queued, so the caller gets the id right
+ * away. Rows added directly through TableBase take their ids from the
+ * same counter, so they cannot collide with queued rows. TableBase
+ * flushes the rows queued for a table before it reads from it, so queued
+ * rows are visible to queries in the same process.
+ *
+ * The writer belongs to its backend, which stops it before it closes
+ * the connection.
+ */
+class BatchWriter {
+	DatabaseBackend	*_database;
+	size_t	_maxrows;
+	int	_maxdelay;
+	typedef struct {
+		std::string	tablename;
+		UpdateSpec	updatespec;
+		long	id;
+	} entry_t;
+	std::list<entry_t>	_queue;
+	std::chrono::steady_clock::time_point	_oldest;
+	std::map<std::string, long>	_nextids;
+	std::set<std::string>	_stale;
+	std::mutex	_mutex;
+	std::mutex	_write_mutex;
+	std::condition_variable	_condition;
+	bool	_running;
+	std::thread	_thread;
+	long	nextid(const std::string& tablename);
+	void	insert(const entry_t& entry, long id);
+	void	write(std::list<entry_t>& entries);
+	void	run();
+	// prevent copying
+	BatchWriter(const BatchWriter& other);
+	BatchWriter&	operator=(const BatchWriter& other);
+public:
+	BatchWriter(DatabaseBackend *database, size_t maxrows = 100,
+		int maxdelay = 500);
+	~BatchWriter();
+	long	reserve(const std::string& tablename);
+	long	add(const std::string& tablename,
+			const UpdateSpec& updatespec);
+	bool	pending(const std::string& tablename);
+	void	flush();
+	void	stop();
+static std::shared_ptr<BatchWriter>	get(Database database);
+static void	sync(Database database, const std::string& tablename);
+};
+typedef std::shared_ptr<BatchWriter>	BatchWriterPtr;
+
 /**
  * \brief Template to create a persistent version of an object
  *
@@ -330,6 +573,7 @@ public:
 			dbadapter::createstatement()) { }
 	object	byid(long objectid);
 	long	add(const object&);
+	long	queue(const object&);
 	void	update(long objectid, const object& o);
 	std::list<object>	select(const std::string& condition) {
 		std::list<object>	result;
@@ -341,8 +585,33 @@ public:
 		}
 		return result;
 	}
+	template<typename visitor>
+	long	select(const std::string& condition, visitor& v);
 };
 
+/**
+ * \brief Visit all rows satisfying a condition
+ *
+ * The visitor is called with a cursor positioned on each row in turn,
+ * the cursor has the id column and all fields of the table. This avoids
+ * building Row and object lists for large results.
+ *
+ * \return the number of rows visited
+ */
+template<typename object, typename dbadapter>
+template<typename visitor>
+long	Table<object, dbadapter>::select(const std::string& condition,
+		visitor& v) {
+	StatementPtr	stmt = selectstatement(condition);
+	CursorPtr	cursor = stmt->cursor();
+	long	counter = 0;
+	while (cursor->next()) {
+		v(*cursor);
+		counter++;
+	}
+	return counter;
+}
+
 template<typename object, typename dbadapter>
 object	Table<object, dbadapter>::byid(long objectid) {
 	return dbadapter::row_to_object(objectid, rowbyid(objectid));
@@ -353,6 +622,15 @@ long	Table<object, dbadapter>::add(const object& o) {
 	return addrow(dbadapter::object_to_updatespec(o));
 }
 
+/**
+ * \brief Add an object through the batch writer of the database
+ */
+template<typename object, typename dbadapter>
+long	Table<object, dbadapter>::queue(const object& o) {
+	return BatchWriter::get(_database)->add(_tablename,
+		dbadapter::object_to_updatespec(o));
+}
+
 template<typename object, typename dbadapter>
 void	Table<object, dbadapter>::update(long objectid, const object& o) {
 	updaterow(objectid, dbadapter::object_to_updatespec(o));
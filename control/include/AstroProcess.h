@@ -14,9 +14,11 @@
 #include <AstroPostprocessing.h>
 #include <AstroTonemapping.h>
 #include <AstroTransform.h>
+#include <AstroStacking.h>
 #include <AstroCamera.h>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <iostream>
 
 namespace astro {
@@ -147,6 +149,7 @@ namespace test {
 class ProcessingStepTest;
 class WriteImageFileStepTest;
 class ImageCalibrationStepTest;
+class ProcessorNetworkTest;
 
 } // namespace test
 
@@ -157,6 +160,7 @@ typedef std::shared_ptr<ProcessingStep>	ProcessingStepPtr;
 
 class ProcessorParser;
 class ProcessorNetwork;
+class NetworkScheduler;
 class ProcessingThread;
 
 class ProcessingSteps;
@@ -267,6 +271,7 @@ private:
 	friend class astro::test::ProcessingStepTest;
 	friend class astro::test::WriteImageFileStepTest;
 	friend class astro::test::ImageCalibrationStepTest;
+	friend class astro::test::ProcessorNetworkTest;
 public:
 	void	remove_me();
 
@@ -292,7 +297,7 @@ private:
 	state	precursorstate() const;
 	void	checkyourstate();
 private:
-	state	_status;
+	std::atomic<state>	_status;
 public:
 	virtual state	status();
 	state	status(state newsstate);
@@ -305,6 +310,7 @@ public:
 private:
 	astro::thread::Barrier	_barrier;
 	friend class ProcessorNetwork;
+	friend class NetworkScheduler;
 	friend class ProcessingThread;
 protected:
 	virtual state	do_work();
@@ -357,9 +363,18 @@ typedef std::shared_ptr<ProcessingThread>	ProcessingThreadPtr;
 class ImageStep : public ProcessingStep {
 protected:
 	ImagePtr	_image;
+	std::mutex	_imagemutex;
+private:
+	std::string	_spillfile;
 public:
-	virtual ImagePtr	image() { return _image; }
+	virtual ImagePtr	image();
 	ImageStep(NodePaths& parent) : ProcessingStep(parent) { }
+	virtual ~ImageStep();
+	// memory management by the processor network
+	virtual bool	ondemand() const { return false; }
+	virtual size_t	imagebytes();
+	virtual void	release();
+	virtual bool	spill(const std::string& directory);
 	ImageSequence	precursorimages(std::vector<int> exlude
 				= std::vector<int>()) const;
 	bool	precursorSizesConsistent(std::vector<int> exlude
@@ -428,6 +443,9 @@ private:
 	virtual ProcessingStep::state	status();
 	virtual std::string	what() const;
 	virtual ImagePtr	image();
+	virtual size_t	imagebytes();
+	virtual void	release();
+	virtual bool	spill(const std::string& directory);
 };
 
 /**
@@ -511,6 +529,7 @@ class ImageCalibrationStep : public ImageStep {
 	bool	_demosaic;
 	bool	_flip;
 	bool	_hflip;
+	int	_binning;
 public:
 	ProcessingStepPtr	dark() const { return _dark; }
 	void	dark(ProcessingStepPtr d) { _dark = d; }
@@ -526,6 +545,8 @@ public:
 	void	flip(bool f) { _flip = f; }
 	bool	hflip() const { return _hflip; }
 	void	hflip(bool f) { _hflip = f; }
+	int	binning() const { return _binning; }
+	void	binning(int b) { _binning = b; }
 	ImageCalibrationStep(NodePaths& parent);
 	virtual ProcessingStep::state	do_work();
 	virtual ProcessingStep::state	status();
@@ -571,6 +592,9 @@ class StackingStep : public ImageStep {
 	bool	_usetriangles;
 	bool	_rigid;
 	bool	_rescale;
+	astro::image::stacking::Stacker::method_type	_method;
+	double	_kappa;
+	int	_iterations;
 	void	rescale_image(ImagePtr image, double s);
 public:
 	StackingStep(NodePaths& parent);
@@ -592,6 +616,16 @@ public:
 	void	rigid(bool r) { _rigid = r; }
 	bool	rescale() const { return _rescale; }
 	void	rescale(bool r) { _rescale = r; }
+	astro::image::stacking::Stacker::method_type	method() const {
+		return _method;
+	}
+	void	method(astro::image::stacking::Stacker::method_type m) {
+		_method = m;
+	}
+	double	kappa() const { return _kappa; }
+	void	kappa(double k) { _kappa = k; }
+	int	iterations() const { return _iterations; }
+	void	iterations(int i) { _iterations = i; }
 private:
 	virtual ProcessingStep::state	do_work();
 	virtual std::string	what() const;
@@ -646,6 +680,7 @@ public:
 	virtual ProcessingStep::state	do_work();
 	virtual std::string	what() const;
 	virtual ImagePtr	image();
+	virtual bool	ondemand() const { return true; }
 };
 
 /**
@@ -671,6 +706,7 @@ public:
 	virtual ProcessingStep::state	do_work();
 	virtual std::string	what() const;
 	virtual ImagePtr	image();
+	virtual bool	ondemand() const { return true; }
 };
 
 /**
@@ -691,6 +727,7 @@ public:
 	virtual ProcessingStep::state	do_work();
 	virtual std::string	what() const;
 	virtual ImagePtr	image();
+	virtual bool	ondemand() const { return true; }
 };
 
 /**
@@ -730,6 +767,7 @@ public:
 	virtual ProcessingStep::state	do_work();
 	virtual std::string	what() const;
 	virtual ImagePtr	image();
+	virtual bool	ondemand() const { return true; }
 };
 
 /**
@@ -744,6 +782,7 @@ public:
 	virtual ProcessingStep::state	do_work();
 	virtual std::string	what() const;
 	virtual ImagePtr	image();
+	virtual bool	ondemand() const { return true; }
 };
 
 /**
@@ -787,8 +826,41 @@ public:
 	virtual std::string	what() const;
 };
 
+/**
+ * \brief Plate solving step
+ *
+ * The step passes on the image of its precursor with the world
+ * coordinate system found by the plate solver added to the metadata.
+ */
+class SolveStep : public ImageStep {
+	std::string	_index;
+	double	_minscale;
+	double	_maxscale;
+public:
+	const std::string&	index() const { return _index; }
+	void	index(const std::string& i) { _index = i; }
+
+	double	minscale() const { return _minscale; }
+	void	minscale(double m) { _minscale = m; }
+
+	double	maxscale() const { return _maxscale; }
+	void	maxscale(double m) { _maxscale = m; }
+
+	SolveStep(NodePaths& parent);
+	virtual ProcessingStep::state	do_work();
+	virtual std::string	what() const;
+};
+
 /**
 * \brief Network Class to manage a complete network of interdependen steps
+*
+* The network runs steps whose precursors are complete on up to
+* maxthreads() worker threads. Each worker queues the successors made
+* ready by its own steps, and idle workers steal from the queues of the
+* others. If a memory limit is set, no new step is started while the
+* images held by completed steps exceed the limit, and images that are
+* still needed are spilled to disk. Images no remaining step needs are
+* always released, except those of terminal steps.
 */
 class ProcessorNetwork : public NodePaths {
 	typedef std::map<int, ProcessingStepPtr>	stepmap_t;
@@ -809,16 +881,33 @@ public:
 	ProcessingStep::steps	initials() const;
 private:
 	int	_maxthreads;
+	size_t	_memorylimit;
 public:
 	int	maxthreads() const { return _maxthreads; }
-	void	maxthreads(int m) { _maxthreads = m; }
+	void	maxthreads(int m);
+	size_t	memorylimit() const { return _memorylimit; }
+	void	memorylimit(size_t m) { _memorylimit = m; }
+public:
+	// timing of the steps executed by the last call to process()
+	typedef struct steptiming_s {
+		double	start;
+		double	end;
+		ProcessingStep::state	result;
+	} steptiming_t;
 private:
-	std::vector<ProcessingThreadPtr>	_threads;
+	std::map<int, steptiming_t>	_timings;
+	double	_start;
+	double	_end;
 public:
+	const std::map<int, steptiming_t>&	timings() const {
+		return _timings;
+	}
 	bool	hasneedswork();
 	void	process();
 	int	process(int id);
 	int	process(const ProcessingStep::steps& steps);
+	ProcessingStep::steps	criticalpath() const;
+	void	report(std::ostream& out) const;
 	void	dump(std::ostream& out) const;
 };
 typedef std::shared_ptr<ProcessorNetwork>	ProcessorNetworkPtr;
@@ -214,15 +214,15 @@ class ImageRepo {
 	astro::persistence::Database	_database;
 	std::string	_directory;
 	long	id(const std::string& filename);
-	void	scan_directory(bool recurse = false);
-	void	scan_recursive();
-	void	scan_file(const std::string& filename);
 	void	update_filename(long id, const std::string& filename);
+	std::string	imagename(long id) const;
+	friend class RepoReplicator;
 public:
 	ImageRepo(const std::string& name,
 		astro::persistence::Database database,
 		const std::string& directory, bool scan = false);
 	const std::string&	name() const { return _name; }
+	long	scan(bool recurse = false);
 	bool	has(long id);
 	bool	has(const UUID& uuid);
 	std::string	filename(long id);
@@ -248,14 +248,32 @@ typedef std::shared_ptr<ImageRepo>	ImageRepoPtr;
 
 /**
  * \brief A class that implements a replication from one repo to another
+ *
+ * Images are replicated by copying the FITS files unchanged and copying
+ * their index rows, the images are neither decoded nor encoded again.
+ * Progress is recorded in a journal in the target repository database,
+ * so an interrupted replication can be resumed.
  */
 class RepoReplicator {
-	std::set<long>	uuid2ids(ImageRepoPtr repo, const std::set<UUID>& uuids);
+	int	_parallelism;
+	size_t	_batchsize;
+	typedef std::multimap<UUID, long>	uuidmap_t;
+	uuidmap_t	uuidmap(ImageRepoPtr repo);
+	std::set<long>	uuid2ids(const uuidmap_t& map,
+				const std::set<UUID>& uuids);
+	void	recover(ImageRepoPtr dst);
+	int	copybatch(ImageRepoPtr src, ImageRepoPtr dst,
+			const std::vector<long>& ids);
 public:
 	RepoReplicator();
+	int	parallelism() const { return _parallelism; }
+	void	parallelism(int p);
+	size_t	batchsize() const { return _batchsize; }
+	void	batchsize(size_t b);
 	int	replicate(ImageRepoPtr from, ImageRepoPtr to,
 			bool remove = false);
 	int	synchronize(ImageRepoPtr repo1, ImageRepoPtr repo2);
+	static std::string	checksum(const std::string& filename);
 };
 
 /**
@@ -0,0 +1,233 @@
+/*
+ * AstroSolver.h -- blind plate solving with a quad hash index
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#ifndef _AstroSolver_h
+#define _AstroSolver_h
+
+#include <AstroCatalog.h>
+#include <AstroTransform.h>
+#include <memory>
+#include <cstdint>
+
+namespace astro {
+namespace catalog {
+
+/**
+ * \brief Gnomonic projection onto the tangent plane at a point of the sky
+ *
+ * The first coordinate of the plane points towards increasing right
+ * ascension, the second towards the north pole, both in radians. This
+ * is the intermediate world coordinate system of the FITS TAN projection.
+ */
+class TangentPlane {
+	RaDec	_center;
+	double	_sindec;
+	double	_cosdec;
+public:
+	const RaDec&	center() const { return _center; }
+	TangentPlane(const RaDec& center);
+	Point	project(const RaDec& position) const;
+	RaDec	inverse(const Point& point) const;
+};
+
+/**
+ * \brief Geometric hash code of four stars
+ *
+ * The two stars farthest apart, A and B, define a coordinate system in
+ * which A is at (0,0) and B at (1,1). The code consists of the
+ * coordinates of the two other stars C and D in this system, so it does
+ * not change under translation, rotation and scaling. The stars are
+ * ordered such that the code is unique: A and B are swapped if the x
+ * coordinates of C and D sum to more than 1, and C is the star with the
+ * smaller x coordinate.
+ */
+class QuadCode {
+	float	_code[4];
+	int	_order[4];
+	bool	_valid;
+public:
+	QuadCode(const Point points[4]);
+	bool	valid() const { return _valid; }
+	float	operator[](int i) const { return _code[i]; }
+	int	order(int i) const { return _order[i]; }
+	const float	*code() const { return _code; }
+	static double	distance(const float *a, const float *b);
+};
+
+/**
+ * \brief A quad from the index
+ */
+typedef struct quadindex_quad {
+	uint32_t	key;
+	uint32_t	stars[4];
+	float	code[4];
+} QuadIndexEntry;
+
+struct quadindex_header;
+struct quadindex_level;
+struct quadindex_star;
+class MappedFile;
+
+/**
+ * \brief Memory mapped index of star quads
+ *
+ * The index consists of several levels, each containing quads of stars
+ * from sky cells of a given size. The quads of a level are sorted by
+ * the bucket of their code in a 4-dimensional grid, so that lookups
+ * only have to scan a few buckets. The stars are sorted by declination,
+ * which makes it possible to retrieve all stars in a field for the
+ * verification of a solution.
+ */
+class QuadIndex {
+	std::shared_ptr<MappedFile>	_file;
+	const quadindex_header	*_header;
+	const quadindex_level	*_levels;
+	const quadindex_star	*_stars;
+	const QuadIndexEntry	*_quads;
+public:
+	QuadIndex(const std::string& filename);
+	unsigned int	nlevels() const;
+	Angle	scale(unsigned int level) const;
+	size_t	nquads(unsigned int level) const;
+	const QuadIndexEntry&	quad(unsigned int level, size_t index) const;
+	size_t	nstars() const;
+	LightWeightStar	star(size_t index) const;
+	std::vector<size_t>	stars(const RaDec& center,
+					const Angle& radius) const;
+	std::vector<QuadIndexEntry>	lookup(unsigned int level,
+					const QuadCode& code,
+					double tolerance) const;
+	static unsigned int	bins;
+	static double	codemin;
+	static double	codemax;
+	static uint32_t	key(const float *code);
+};
+
+typedef std::shared_ptr<QuadIndex>	QuadIndexPtr;
+
+/**
+ * \brief Build a quad index from a star catalog
+ *
+ * The sky is divided into cells of the size of each level. From the
+ * brightest stars in a slightly enlarged window around each cell a
+ * few quads are formed whose size is comparable to the cell size.
+ */
+class QuadIndexBuilder {
+	CatalogPtr	_catalog;
+	float	_maglimit;
+public:
+	float	maglimit() const { return _maglimit; }
+	void	maglimit(float m) { _maglimit = m; }
+private:
+	unsigned int	_starspercell;
+public:
+	unsigned int	starspercell() const { return _starspercell; }
+	void	starspercell(unsigned int s) { _starspercell = s; }
+private:
+	unsigned int	_quadspercell;
+public:
+	unsigned int	quadspercell() const { return _quadspercell; }
+	void	quadspercell(unsigned int q) { _quadspercell = q; }
+private:
+	SkyWindow	_window;
+public:
+	const SkyWindow&	window() const { return _window; }
+	void	window(const SkyWindow& w) { _window = w; }
+private:
+	std::vector<Angle>	_scales;
+public:
+	const std::vector<Angle>&	scales() const { return _scales; }
+	void	scales(const Angle& minfield, const Angle& maxfield);
+	QuadIndexBuilder(CatalogPtr catalog);
+	void	build(const std::string& filename) const;
+};
+
+/**
+ * \brief World coordinate system found by the plate solver
+ *
+ * The solution maps pixel coordinates to the tangent plane at the
+ * center using the CD matrix, which is in degrees per pixel as in
+ * the FITS standard.
+ */
+class PlateSolution {
+	RaDec	_center;
+	Point	_reference;
+	double	_cd[4];
+	unsigned int	_matches;
+public:
+	const RaDec&	center() const { return _center; }
+	const Point&	reference() const { return _reference; }
+	double	cd(int i) const { return _cd[i]; }
+	unsigned int	matches() const { return _matches; }
+	PlateSolution();
+	PlateSolution(const RaDec& center, const Point& reference,
+		const astro::image::transform::Transform& transform,
+		unsigned int matches);
+	double	scale() const;
+	Angle	rotation() const;
+	bool	mirrored() const;
+	RaDec	radec(const Point& pixel) const;
+	Point	pixel(const RaDec& position) const;
+	void	addMetadata(astro::image::ImageBase& image) const;
+	std::string	toString() const;
+};
+
+/**
+ * \brief Blind plate solver
+ *
+ * The solver forms quads from the brightest stars of an image, looks
+ * up their codes in the index and verifies each candidate by counting
+ * how many index stars in the field coincide with image stars.
+ */
+class PlateSolver {
+	const QuadIndex&	_index;
+	unsigned int	_numberofstars;
+public:
+	unsigned int	numberofstars() const { return _numberofstars; }
+	void	numberofstars(unsigned int n) { _numberofstars = n; }
+private:
+	unsigned int	_quadstars;
+public:
+	unsigned int	quadstars() const { return _quadstars; }
+	void	quadstars(unsigned int q) { _quadstars = q; }
+private:
+	double	_codetolerance;
+public:
+	double	codetolerance() const { return _codetolerance; }
+	void	codetolerance(double c) { _codetolerance = c; }
+private:
+	double	_tolerance;
+public:
+	double	tolerance() const { return _tolerance; }
+	void	tolerance(double t) { _tolerance = t; }
+private:
+	unsigned int	_minmatches;
+public:
+	unsigned int	minmatches() const { return _minmatches; }
+	void	minmatches(unsigned int m) { _minmatches = m; }
+private:
+	double	_minscale;
+	double	_maxscale;
+public:
+	double	minscale() const { return _minscale; }
+	double	maxscale() const { return _maxscale; }
+	void	scalerange(double minscale, double maxscale);
+public:
+	PlateSolver(const QuadIndex& index);
+	PlateSolution	operator()(astro::image::ImagePtr image) const;
+	PlateSolution	operator()(const std::vector<Point>& stars,
+				const astro::image::ImageSize& size) const;
+private:
+	bool	verify(const std::vector<Point>& stars,
+			const astro::image::transform::PointTree& tree,
+			const astro::image::ImageSize& size,
+			const QuadIndexEntry& quad, const Point pixels[4],
+			PlateSolution& solution) const;
+};
+
+} // namespace catalog
+} // namespace astro
+
+#endif /* _AstroSolver_h */
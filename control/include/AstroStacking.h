@@ -92,6 +92,43 @@ private:
 public:
 	bool	rigid() const { return _rigid; }
 	void	rigid(bool r) { _rigid = r; }
+public:
+	/**
+	 * \brief Methods to combine the layers
+	 *
+	 * SUM adds each layer to an accumulator as it is added. All other
+	 * methods keep the transformed layers in temporary files and
+	 * combine them tile by tile with outlier rejection when the image
+	 * is requested.
+	 */
+	typedef enum {
+		SUM, MEDIAN, KAPPA_SIGMA, WINSORIZED_SIGMA, LINEAR_FIT
+	} method_type;
+	static std::string	method2string(method_type m);
+	static method_type	string2method(const std::string& m);
+private:
+	method_type	_method;
+public:
+	method_type	method() const { return _method; }
+	void	method(method_type m) { _method = m; }
+private:
+	// rejection threshold in units of the standard deviation
+	double	_kappa;
+public:
+	double	kappa() const { return _kappa; }
+	void	kappa(double k) { _kappa = k; }
+private:
+	// maximum number of rejection iterations
+	int	_iterations;
+public:
+	int	iterations() const { return _iterations; }
+	void	iterations(int i) { _iterations = i; }
+private:
+	// size of the tiles used when combining with rejection
+	int	_tilesize;
+public:
+	int	tilesize() const { return _tilesize; }
+	void	tilesize(int t) { _tilesize = t; }
 
 	static StackerPtr	get(ImagePtr baseimage);
 protected:
@@ -99,7 +136,8 @@ protected:
 		: _baseimage(baseimage),
 		  _patchsize(256), _residual(30),
 		  _numberofstars(0), _searchradius(16),
-		  _notransform(true), _usetriangles(false), _rigid(false) {
+		  _notransform(true), _usetriangles(false), _rigid(false),
+		  _method(SUM), _kappa(3), _iterations(5), _tilesize(64) {
 	}
 public:
 	virtual void	add(ImagePtr, transform::Transform initial_transform
@@ -112,6 +150,27 @@ protected:
 				transform::Transform initial_transform) const;
 };
 
+/**
+ * \brief Combine the values of a pixel in all layers
+ *
+ * The combiner computes the mean of the values that survive the rejection
+ * algorithm. The SUM method does not reject anything and just computes
+ * the mean of all values.
+ */
+class Combiner {
+	Stacker::method_type	_method;
+	double	_kappa;
+	int	_iterations;
+	double	median(std::vector<double>& values, size_t n) const;
+	double	kappasigma(std::vector<double>& values) const;
+	double	winsorizedsigma(std::vector<double>& values) const;
+	double	linearfit(std::vector<double>& values) const;
+public:
+	Combiner(Stacker::method_type method, double kappa = 3,
+		int iterations = 5);
+	double	operator()(std::vector<double>& values) const;
+};
+
 } // namespace stacking
 } // namespace image
 } // namespace astro
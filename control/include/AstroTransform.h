@@ -346,6 +346,7 @@ public:
 		const Transform& transform,
 		bool _use_nan = true);
 	virtual Pixel	pixel(int x, int y) const;
+	virtual void	readrow(int y, int x0, int n, Pixel *out) const;
 };
 
 template<typename Pixel>
@@ -373,6 +374,22 @@ Pixel	TransformAdapter<Pixel>::pixel(int x, int y) const {
 	return image.pixel(t);
 }
 
+/**
+ * \brief Compute a row segment of the transformed image
+ *
+ * The transform is affine, so the preimages of the pixels of a row are
+ * equally spaced and only the first two have to be computed.
+ */
+template<typename Pixel>
+void	TransformAdapter<Pixel>::readrow(int y, int x0, int n,
+		Pixel *out) const {
+	Point	t = inverse(Point(x0, y));
+	Point	step = inverse(Point(x0 + 1, y)) - t;
+	for (int i = 0; i < n; i++) {
+		out[i] = image.pixel(t + step * (double)i);
+	}
+}
+
 ImagePtr	transform(ImagePtr image, const Transform& transform);
 
 /**
@@ -397,10 +414,27 @@ private:
 public:
 	const std::string&	prefix() const { return _prefix; }
 	void	prefix(const std::string& p) { _prefix = p; }
+private:
+	// the windowed reference image and its spectrum, and work arrays
+	// for the image correlated with it
+	ImageSize	_size;
+	std::shared_ptr<double>	_reference;
+	std::shared_ptr<double>	_spectrum;
+	std::shared_ptr<double>	_work;
+	std::shared_ptr<double>	_workspectrum;
+	void	prepare(const ConstImageAdapter<double>& fromimage);
+	std::pair<Point, double>	compute(
+		const ConstImageAdapter<double>& toimage);
 public:
 	PhaseCorrelator(bool hanning = true) : _hanning(hanning),
 		_imagedir("tmp"), _prefix("corr") {
 	}
+	virtual ~PhaseCorrelator() { }
+	bool	prepared() const { return (bool)_spectrum; }
+	const ImageSize&	referencesize() const { return _size; }
+	virtual void	reference(const ConstImageAdapter<double>& fromimage);
+	virtual std::pair<Point, double>	correlate(
+		const ConstImageAdapter<double>& toimage);
 	virtual std::pair<Point, double>	operator()(
 		const ConstImageAdapter<double>& fromimage,
 		const ConstImageAdapter<double>& toimage);
@@ -425,6 +459,15 @@ public:
 		Adapter	to(toimage);
 		return PhaseCorrelator::operator()(from, to);
 	}
+	virtual void	reference(const ConstImageAdapter<double>& fromimage) {
+		Adapter	from(fromimage);
+		PhaseCorrelator::reference(from);
+	}
+	virtual std::pair<Point, double>	correlate(
+		const ConstImageAdapter<double>& toimage) {
+		Adapter	to(toimage);
+		return PhaseCorrelator::correlate(to);
+	}
 };
 
 /**
@@ -446,6 +489,15 @@ private:
 public:
 	bool	hanning() const { return _hanning; }
 	void	hanning(bool h) { _hanning = h; }
+private:
+	// correlators prepared with the patches of the base image, they
+	// are reused as long as the patch layout does not change
+	mutable std::vector<ImagePoint>	_points;
+	mutable std::vector<PhaseCorrelator>	_correlators;
+	mutable int	_preparedpatchsize;
+	mutable bool	_preparedhanning;
+	Residual	translation(const ConstImageAdapter<double>& image,
+		size_t patch) const;
 public:
 	Analyzer(const ConstImageAdapter<double>& baseimage,
 		int spacing = 128, int patchsize = 128);
@@ -492,6 +544,9 @@ public:
 	double	azimut() const { return _azimut; }
 	double	area() const { return _area; }
 
+	// shape of the triangle, independent of position, size and rotation
+	Point	invariants() const { return Point(_angle, _middleside); }
+
 	// find similar triangles
 	bool	operator<(const Triangle& other) const;
 	double	distance(const Triangle& other) const;
@@ -508,10 +563,39 @@ public:
 	operator std::string() const;
 };
 
+/**
+ * \brief Two dimensional k-d tree for nearest neighbour and radius queries
+ *
+ * The tree is stored implicitly as a permutation of the point indices:
+ * the middle element of each range is the node that splits it, in x and
+ * y alternately. Queries return indices into the vector of points the
+ * tree was built from.
+ */
+class PointTree {
+	std::vector<Point>	_points;
+	std::vector<int>	_tree;
+	void	build(int lo, int hi, bool xaxis);
+	void	nearest(int lo, int hi, bool xaxis, const Point& point,
+			unsigned int k,
+			std::vector<std::pair<double, int> >& heap) const;
+	void	within(int lo, int hi, bool xaxis, const Point& point,
+			double radius, std::vector<int>& result) const;
+public:
+	PointTree(const std::vector<Point>& points);
+	size_t	size() const { return _points.size(); }
+	const Point&	operator[](int i) const { return _points[i]; }
+	int	nearest(const Point& point) const;
+	std::vector<int>	nearest(const Point& point, unsigned int k) const;
+	std::vector<int>	within(const Point& point, double radius) const;
+};
+
 /**
  * \brief A set of triangles
  *
- * Triangle sets are used for the triangle matching algorithm.
+ * Triangle sets are used for the triangle matching algorithm. Triangles
+ * are matched through a k-d tree over their invariants, and the
+ * transforms suggested by matching triangles are verified against all
+ * stars of the two sets with RANSAC.
  */
 class TriangleSet : public std::set<Triangle> {
 	double	_tolerance;
@@ -523,6 +607,31 @@ private:
 public:
 	bool	allow_mirror() const { return _allow_mirror; }
 	void	allow_mirror(bool b) { _allow_mirror = b; }
+private:
+	/**
+	 * \brief The stars the triangles were built from
+	 *
+	 * If no stars are set, the vertices of the triangles are used to
+	 * verify transforms.
+	 */
+	std::vector<Point>	_stars;
+public:
+	std::vector<Point>	stars() const;
+	void	stars(const std::vector<Point>& s) { _stars = s; }
+private:
+	/**
+	 * \brief Maximum distance in pixels of a star from its image
+	 *        under the transform to count as a match
+	 */
+	double	_startolerance;
+public:
+	double	startolerance() const { return _startolerance; }
+	void	startolerance(double t) { _startolerance = t; }
+private:
+	unsigned int	_iterations;
+public:
+	unsigned int	iterations() const { return _iterations; }
+	void	iterations(unsigned int i) { _iterations = i; }
 
 	TriangleSet();
 	const Triangle&	closest(const Triangle& other) const;
@@ -661,14 +770,24 @@ private:
 public:
 	double	radius() const { return _radius; }
 	void	radius(double r) { _radius = r; }
+private:
+	/**
+	 * \brief Number of nearest neighbours of a star to form triangles
+	 *
+	 * With more stars than that, each star only forms triangles with
+	 * pairs of its nearest neighbours, so the number of triangles grows
+	 * linearly with the number of stars.
+	 */
+	unsigned int	_neighbors;
+public:
+	unsigned int	neighbors() const { return _neighbors; }
+	void	neighbors(unsigned int n) { _neighbors = n; }
 
 private:
 	bool	good(const Triangle& t, double l) const;
 public:
 	TriangleSetFactory();
-private:
 	TriangleSet	get(const std::vector<Star>& stars, double limit) const;
-public:
 	TriangleSet	get(ImagePtr) const;
 	TriangleSet	get(const ConstImageAdapter<double>& image) const;
 };
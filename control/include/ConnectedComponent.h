@@ -16,9 +16,6 @@ namespace image {
 class ComponentBase : public Image<unsigned char> {
 	ImagePoint	_point;
 	unsigned long	_npoints;
-	
-	int	grow();
-	int	growpixel(unsigned int x, unsigned int y);
 protected:
 	void	process();
 public:
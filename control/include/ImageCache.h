@@ -0,0 +1,49 @@
+/*
+ * ImageCache.h -- memory budgeted cache of decoded image files
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#ifndef _ImageCache_h
+#define _ImageCache_h
+
+#include <AstroImage.h>
+#include <list>
+#include <string>
+
+namespace astro {
+namespace image {
+
+/**
+ * \brief Shared cache of images read from FITS files
+ *
+ * Servers that hand out pixel data of the same files to several clients
+ * keep the decoded images in this cache. The cache is limited by the
+ * number of bytes of pixel data it holds, the least recently used images
+ * are dropped first. An image is only returned from the cache as long as
+ * modification time, size and inode of the file have not changed.
+ *
+ * Images returned by the cache are shared, they must not be modified.
+ * Files can be prefetched, they are then read by a background thread.
+ */
+class ImageCache {
+public:
+static size_t	budget();
+static void	budget(size_t bytes);
+static ImagePtr	get(const std::string& filename);
+static bool	contains(const std::string& filename);
+static void	prefetch(const std::string& filename);
+static void	prefetch(const std::list<std::string>& filenames);
+static void	invalidate(const std::string& filename);
+static void	clear();
+// statistics
+static unsigned long	hits();
+static unsigned long	misses();
+static unsigned long	prefetched();
+static size_t	bytes();
+static size_t	count();
+};
+
+} // namespace image
+} // namespace astro
+
+#endif /* _ImageCache_h */
@@ -45,8 +45,11 @@ protected:
 public:
 	virtual void	remove(const std::string& filename);
 	ImagePtr	getImagePtr(const std::string& filename);
-	void	setMetadata(const std::string& filename,
+	void	prefetch(const std::string& filename, int count = 2);
+	virtual void	setMetadata(const std::string& filename,
 				const ImageMetadata& metadata);
+	bool	hasMetadata(const std::string& filename,
+				const std::string& keyword);
 	Metavalue	getMetadata(const std::string& filename,
 				const std::string& keyword);
 };
@@ -61,6 +64,8 @@ public:
 	virtual void	remove(const std::string& filename);
 	virtual std::string	save(ImagePtr image);
 	virtual std::list<std::string>	fileList();
+	virtual void	setMetadata(const std::string& filename,
+				const ImageMetadata& metadata);
 protected:
 	virtual void	write(astro::image::ImagePtr image,
 				const std::string& filename);
@@ -10,6 +10,7 @@
 #include <Tycho2.h>
 #include <Ucac4.h>
 #include <CatalogBackend.h>
+#include <CompactCatalog.h>
 
 namespace astro {
 namespace catalog {
@@ -31,6 +32,8 @@ CatalogPtr	CatalogFactory::get(BackendType type,
 		return CatalogPtr(new FileBackend(parameter));
 	case Database:
 		return CatalogPtr(new DatabaseBackend(parameter));;
+	case Compact:
+		return CatalogPtr(new CompactCatalog(parameter));
 	}
 	throw std::runtime_error("unknown catalog");
 }
@@ -52,6 +55,8 @@ CatalogPtr	CatalogFactory::get(BackendType type) {
 		return CatalogPtr(new FileBackend(pathbase));
 	case Database:
 		throw std::runtime_error("database path required");
+	case Compact:
+		return CatalogPtr(new CompactCatalog(pathbase + "/compact.cat"));
 	}
 	throw std::runtime_error("unknown catalog");
 }
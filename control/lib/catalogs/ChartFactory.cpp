@@ -36,12 +36,13 @@ Chart	ChartFactory::chart(const RaDec& center, const ImageGeometry& geometry) co
 	Catalog::starsetptr	stars = _catalog->find(window,
                                         MagnitudeRange(-30, limit_magnitude()));
 
-	// add the stars to the image
-	draw(*chart._image, rectangle, stars);
+	// find the positions of the stars in the image
+	std::vector<ChartPoint>	points;
+	draw(points, rectangle, geometry, stars);
 
-	// apply the point spread function
+	// render the stars with the point spread function
 	int	morepixels = 100;
-	spread(*chart._image, morepixels, geometry);
+	render(*chart._image, points, geometry.angularpixelsize(), morepixels);
 
 	// limit the pixel values to 1
 	limit(*chart._image, 1.);
@@ -55,15 +56,17 @@ Chart	ChartFactory::chart(const RaDec& center, const ImageGeometry& geometry) co
  * 
  * \param stars		a set of stars to be drawn inside the image
  */
-void	ChartFactory::draw(Image<double>& image, const SkyRectangle& rectangle,
+void	ChartFactory::draw(std::vector<ChartPoint>& points,
+		const SkyRectangle& rectangle, const ImageSize& size,
 		const Catalog::starset& stars) const {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "create image for %u stars",
 		stars.size());
 
+	points.reserve(points.size() + stars.size());
 	std::set<Star>::const_iterator	s;
 	for (s = stars.begin(); s != stars.end(); s++) {
 		try {
-			draw(image, rectangle, *s);
+			draw(points, rectangle, size, *s);
 		} catch (const std::exception& x) {
 			debug(LOG_DEBUG, DEBUG_LOG, 0, "cannot map star %s",
 				s->toString().c_str());
@@ -77,14 +80,15 @@ void	ChartFactory::draw(Image<double>& image, const SkyRectangle& rectangle,
 /**
  * \brief Draw a sets of of stars to the chart
  */
-void	ChartFactory::draw(Image<double>& image, const SkyRectangle& rectangle,
+void	ChartFactory::draw(std::vector<ChartPoint>& points,
+		const SkyRectangle& rectangle, const ImageSize& size,
 		const Catalog::starsetptr stars) const {
 	Catalog::starset	*starsp
 		= dynamic_cast<Catalog::starset *>(&*stars);
 	if (starsp == NULL) {
 		throw std::runtime_error("no star set provided");
 	}
-	draw(image, rectangle, *starsp);
+	draw(points, rectangle, size, *starsp);
 }
 
 
@@ -93,14 +97,15 @@ void	ChartFactory::draw(Image<double>& image, const SkyRectangle& rectangle,
  *
  * \param star		the star to be drawn
  */
-void	ChartFactory::draw(Image<double>& image, const SkyRectangle& rectangle,
+void	ChartFactory::draw(std::vector<ChartPoint>& points,
+		const SkyRectangle& rectangle, const ImageSize& size,
 		const Star& star) const {
 
 	// compute the pixel coordinates of the star
-	astro::Point	p = rectangle.point(image.size(), star);
+	astro::Point	p = rectangle.point(size, star);
 
-	// draw the star at this point
-	ChartFactoryBase::draw(image, p, star);
+	// remember the star at this point
+	points.push_back(ChartPoint(p, intensity(star)));
 }
 
 } // namespace catalog
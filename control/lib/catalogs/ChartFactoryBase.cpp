@@ -15,47 +15,17 @@ using namespace astro::image;
 namespace astro {
 namespace catalog {
 
-void	ChartFactoryBase::draw(Image<double>& image, const Point& p,
-		const Star& star) const {
-	// compute the radius of the star
+/**
+ * \brief Intensity of a star in the chart
+ */
+double	ChartFactoryBase::intensity(const Star& star) const {
 	double	I;
 	if (_logarithmic) {
 		I = 1 - star.mag() / 20;
 	} else {
 		I = pow(10., -star.mag() / 5);
 	}
-	I *= _scale;
-	//debug(LOG_DEBUG, DEBUG_LOG, 0, "mag = %f, I = %f", star.mag(), I);
-
-	// get the coordinates of the point
-	int	x = floor(p.x());
-	int	y = floor(p.y());
-	double	wx = p.x() - x;
-	double	wy = p.y() - y;
-
-	bool	havedrawnsomething = false;
-	if (image.getFrame().contains(ImagePoint(x, y))) {
-		image.pixel(x    , y    ) += I * (1 - wx) * (1 - wy);
-		havedrawnsomething = true;
-	}
-	if (image.getFrame().contains(ImagePoint(x + 1, y))) {
-		image.pixel(x + 1, y    ) += I *      wx  * (1 - wy);
-		havedrawnsomething = true;
-	}
-	if (image.getFrame().contains(ImagePoint(x, y + 1))) {
-		image.pixel(x    , y + 1) += I * (1 - wx) *      wy ;
-		havedrawnsomething = true;
-	}
-	if (image.getFrame().contains(ImagePoint(x + 1, y + 1))) {
-		image.pixel(x + 1, y + 1) += I *      wx  *      wy ;
-		havedrawnsomething = true;
-	}
-	if (star.mag() > 10) {
-		return;
-	}
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "star %s at %s %s, value = %f",
-		star.toString().c_str(), p.toString().c_str(),
-		(havedrawnsomething) ? "drawn" : "skipped", I);
+	return I * _scale;
 }
 
 void	ChartFactoryBase::limit(Image<double>& image, double limit) const {
@@ -75,8 +45,14 @@ void	ChartFactoryBase::limit(Image<double>& image, double limit) const {
 		counter, limit, _scale);
 }
 
+/**
+ * \brief Convolve the image with the point spread function
+ *
+ * This uses Fourier transforms of the complete image with a border of
+ * morepixels pixels, which is only worthwhile for dense star fields.
+ */
 void	ChartFactoryBase::spread(Image<double>& image, int morepixels,
-		const ImageGeometry& geometry) const {
+		double angularpixelsize) const {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "apply point spread function %s",
 		typeid(pointspreadfunction).name());
 	// we don't need to to anything if the point spread function is
@@ -95,17 +71,11 @@ void	ChartFactoryBase::spread(Image<double>& image, int morepixels,
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "border adapter for image has size %s",
 		imgborder.getSize().toString().c_str());
 
-	// for debugging, write the PSF
-	io::FITSout	outimage("tmp/image.fits");
-	outimage.setPrecious(false);
-	ImagePtr	imgimage(new Image<double>(imgborder));
-	outimage.write(imgimage);
-
 	// create an image for the point spread function
 	ImageSize	psfsize(2 * morepixels, 2 * morepixels);
 	ImagePoint	psfoffset(morepixels, morepixels);
 	PointSpreadFunctionAdapter	psfadapter(psfsize, psfoffset,
-			geometry.angularpixelsize(), pointspreadfunction);
+			angularpixelsize, pointspreadfunction);
 
 	// embedd the point spread function in a larger border adapter
 	adapter::BorderAdapter<double>	psfborder(imgsize, ImagePoint(0, 0),
@@ -113,12 +83,6 @@ void	ChartFactoryBase::spread(Image<double>& image, int morepixels,
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "border adapter for PSF has size %s",
 		psfborder.getSize().toString().c_str());
 
-	// for debugging, write the PSF
-	io::FITSout	outpsf("tmp/psf.fits");
-	outpsf.setPrecious(false);
-	ImagePtr	psfimage(new Image<double>(psfborder));
-	outpsf.write(psfimage);
-
 	// now perform the convolution
 	ConvolutionResult	i(imgborder, ImagePoint(0, 0));
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "image transformed");
@@ -130,23 +94,34 @@ void	ChartFactoryBase::spread(Image<double>& image, int morepixels,
 	Image<double>	*img = dynamic_cast<Image<double> *>(&*imageptr);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "image transformed back");
 
-	io::FITSout	out2("tmp/blubb2.fits");
-	out2.setPrecious(false);
-	out2.write(imageptr);
-
 	// extract the right part
 	ImageRectangle	rectangle(ImagePoint(2 * morepixels, 2 * morepixels),
 				image.getSize());
 	adapter::WindowAdapter<double>	result(*img, rectangle);
 
-	io::FITSout	out3("tmp/blubb3.fits");
-	out3.setPrecious(false);
-	ImagePtr	image3ptr(new Image<double>(result));
-	out3.write(image3ptr);
-
 	// copy the pixels from the convolution to the image
 	copy(image, result);
 }
 
+/**
+ * \brief Render stars with the point spread function into the image
+ *
+ * Unless the Fourier transform method is selected, the stars are
+ * rendered by adding a kernel for each star, which is much faster
+ * for the sparse star fields of typical charts.
+ */
+void	ChartFactoryBase::render(Image<double>& image,
+		const std::vector<ChartPoint>& stars, double angularpixelsize,
+		int morepixels) const {
+	if (_fft) {
+		StarRenderer::deposit(image, stars);
+		spread(image, morepixels, angularpixelsize);
+		return;
+	}
+	StarRenderer	renderer(pointspreadfunction, angularpixelsize,
+				morepixels);
+	renderer(image, stars);
+}
+
 } // namespace catalog
 } // namespace astro
@@ -0,0 +1,422 @@
+/*
+ * CompactCatalog.cpp -- memory mapped star catalog in fixed point format
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include "CompactCatalog.h"
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace astro {
+namespace catalog {
+
+//////////////////////////////////////////////////////////////////////
+// fixed point conversions
+//////////////////////////////////////////////////////////////////////
+#define	TWO32	4294967296.
+#define	TWO31	2147483648.
+#define	RADIANS_to_MICROARCSEC	(180 * 3600 * 1e6 / M_PI)
+
+uint32_t	CompactCoordinates::ra(double radians) {
+	double	r = radians / (2 * M_PI);
+	r = r - floor(r);
+	return (uint32_t)(uint64_t)llround(r * TWO32);
+}
+
+double	CompactCoordinates::ra(uint32_t ra) {
+	return ra * (2 * M_PI / TWO32);
+}
+
+int32_t	CompactCoordinates::dec(double radians) {
+	return llround(radians * (TWO31 / M_PI));
+}
+
+double	CompactCoordinates::dec(int32_t dec) {
+	return dec * (M_PI / TWO31);
+}
+
+int16_t	CompactCoordinates::mag(float mag) {
+	double	m = round(mag * 1000.);
+	if (m > INT16_MAX) {
+		return INT16_MAX;
+	}
+	if (m < INT16_MIN) {
+		return INT16_MIN;
+	}
+	return m;
+}
+
+float	CompactCoordinates::mag(int16_t mag) {
+	return mag * 0.001;
+}
+
+int32_t	CompactCoordinates::pm(double radians) {
+	double	p = round(radians * RADIANS_to_MICROARCSEC);
+	if (p > INT32_MAX) {
+		return INT32_MAX;
+	}
+	if (p < INT32_MIN) {
+		return INT32_MIN;
+	}
+	return p;
+}
+
+double	CompactCoordinates::pm(int32_t pm) {
+	return pm / RADIANS_to_MICROARCSEC;
+}
+
+//////////////////////////////////////////////////////////////////////
+// cell layout
+//////////////////////////////////////////////////////////////////////
+/**
+ * \brief Zone containing a declination
+ */
+uint32_t	CompactCatalog::zone(int32_t dec, uint32_t nzones) {
+	int64_t	z = (((int64_t)dec + (1LL << 30)) * nzones) >> 31;
+	if (z < 0) {
+		return 0;
+	}
+	if (z >= nzones) {
+		return nzones - 1;
+	}
+	return z;
+}
+
+/**
+ * \brief Number of cells of a zone
+ *
+ * The cells at the declination of the zone closest to the equator
+ * are as wide as the zone is high.
+ */
+uint32_t	CompactCatalog::cellsinzone(uint32_t zone, uint32_t nzones) {
+	double	bottom = -M_PI / 2 + zone * M_PI / nzones;
+	double	top = bottom + M_PI / nzones;
+	double	dec = 0;
+	if (bottom > 0) {
+		dec = bottom;
+	}
+	if (top < 0) {
+		dec = -top;
+	}
+	uint32_t	n = ceil(2 * nzones * cos(dec) - 1e-9);
+	return (n < 1) ? 1 : n;
+}
+
+/**
+ * \brief Cell of a zone containing a right ascension
+ */
+uint32_t	CompactCatalog::cell(uint32_t ra, uint32_t ncells) {
+	return ((uint64_t)ra * ncells) >> 32;
+}
+
+//////////////////////////////////////////////////////////////////////
+// star names
+//////////////////////////////////////////////////////////////////////
+/**
+ * \brief Reconstruct the star name from catalog and catalog number
+ *
+ * The names are formatted the same way as by the catalog classes.
+ */
+std::string	CompactCatalog::starname(char catalog, uint64_t number) {
+	unsigned long long	n = number;
+	switch (catalog) {
+	case 'B':
+		return stringprintf("BSC%04llu", n);
+	case 'H':
+		return stringprintf("HIP%06llu", n);
+	case 'S':
+		return stringprintf("SAO%06llu", n);
+	case 'T':
+		return stringprintf("T%04llu %05llu %llu", n / 1000000,
+			(n / 10) % 100000, n % 10);
+	case 'U':
+		return stringprintf("UCAC4-%03llu-%06llu", n / 1000000,
+			n % 1000000);
+	}
+	return stringprintf("%c%llu", catalog, n);
+}
+
+/**
+ * \brief Find catalog and catalog number of a star name
+ */
+void	CompactCatalog::parsename(const std::string& name, char& catalog,
+		uint64_t& number) {
+	unsigned long long	a, b, c;
+	const char	*s = name.c_str();
+	if (1 == sscanf(s, "BSC%llu", &a)) {
+		catalog = 'B';
+		number = a;
+		return;
+	}
+	if (1 == sscanf(s, "HIP%llu", &a)) {
+		catalog = 'H';
+		number = a;
+		return;
+	}
+	if (1 == sscanf(s, "SAO%llu", &a)) {
+		catalog = 'S';
+		number = a;
+		return;
+	}
+	if (2 == sscanf(s, "UCAC4-%llu-%llu", &a, &b)) {
+		catalog = 'U';
+		number = 1000000 * a + b;
+		return;
+	}
+	if (3 == sscanf(s, "T%llu %llu %llu", &a, &b, &c)) {
+		catalog = 'T';
+		number = 1000000 * a + 10 * b + c;
+		return;
+	}
+	std::string	msg = stringprintf("cannot parse star name '%s'", s);
+	debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+	throw std::runtime_error(msg);
+}
+
+//////////////////////////////////////////////////////////////////////
+// catalog access
+//////////////////////////////////////////////////////////////////////
+static size_t	padded(size_t length) {
+	return (length + 7) & ~(size_t)7;
+}
+
+/**
+ * \brief Map a compact catalog file and check its consistency
+ */
+CompactCatalog::CompactCatalog(const std::string& filename)
+	: MappedFile(filename, 1) {
+	backendname = stringprintf("Compact(%s)", filename.c_str());
+	const char	*data = (const char *)data_ptr;
+	_header = (const compactcatalog_header *)data;
+	if ((data_len < sizeof(compactcatalog_header))
+		|| (0 != memcmp(_header->magic, COMPACTCATALOG_MAGIC, 8))) {
+		std::string	msg = stringprintf("%s is not a compact catalog",
+			filename.c_str());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	size_t	n = _header->nstars;
+	size_t	offset = sizeof(compactcatalog_header);
+	_zones = (const compactcatalog_zone *)(data + offset);
+	offset += padded(_header->nzones * sizeof(compactcatalog_zone));
+	_cells = (const uint64_t *)(data + offset);
+	offset += padded((_header->ncells + 1) * sizeof(uint64_t));
+	_ra = (const uint32_t *)(data + offset);
+	offset += padded(n * sizeof(uint32_t));
+	_dec = (const int32_t *)(data + offset);
+	offset += padded(n * sizeof(int32_t));
+	_mag = (const int16_t *)(data + offset);
+	offset += padded(n * sizeof(int16_t));
+	_pmra = (const int32_t *)(data + offset);
+	offset += padded(n * sizeof(int32_t));
+	_pmdec = (const int32_t *)(data + offset);
+	offset += padded(n * sizeof(int32_t));
+	_catalog = (const char *)(data + offset);
+	offset += padded(n * sizeof(char));
+	_number = (const uint64_t *)(data + offset);
+	offset += padded(n * sizeof(uint64_t));
+	if (offset != data_len) {
+		std::string	msg = stringprintf("compact catalog %s has size "
+			"%lu, expected %lu", filename.c_str(), data_len, offset);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "compact catalog %s: %u zones, "
+		"%u cells, %lu stars", filename.c_str(), _header->nzones,
+		_header->ncells, n);
+}
+
+CompactCatalog::~CompactCatalog() {
+}
+
+uint32_t	CompactCatalog::nzones() const {
+	return _header->nzones;
+}
+
+uint32_t	CompactCatalog::ncells() const {
+	return _header->ncells;
+}
+
+uint64_t	CompactCatalog::nstars() const {
+	return _header->nstars;
+}
+
+unsigned long	CompactCatalog::numberOfStars() {
+	return nstars();
+}
+
+/**
+ * \brief Get position and magnitude of a star
+ */
+LightWeightStar	CompactCatalog::lightweight(uint64_t index) const {
+	return LightWeightStar(RaDec(
+		Angle(CompactCoordinates::ra(_ra[index]), Angle::Radians),
+		Angle(CompactCoordinates::dec(_dec[index]), Angle::Radians)),
+		CompactCoordinates::mag(_mag[index]));
+}
+
+/**
+ * \brief Get a complete star
+ */
+Star	CompactCatalog::star(uint64_t index) const {
+	if (index >= _header->nstars) {
+		std::string	msg = stringprintf("star index %lu out of range",
+			index);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	Star	result(starname(_catalog[index], _number[index]));
+	result.ra().radians(CompactCoordinates::ra(_ra[index]));
+	result.dec().radians(CompactCoordinates::dec(_dec[index]));
+	result.pm().ra().radians(CompactCoordinates::pm(_pmra[index]));
+	result.pm().dec().radians(CompactCoordinates::pm(_pmdec[index]));
+	result.mag(CompactCoordinates::mag(_mag[index]));
+	result.catalog(_catalog[index]);
+	result.catalognumber(_number[index]);
+	return result;
+}
+
+/**
+ * \brief Find the indices of all stars in a window and magnitude range
+ *
+ * For each cell touching the window, the stars in the magnitude range
+ * are found by binary search. The position test is done branch free
+ * on the fixed point arrays, the right ascension test uses unsigned
+ * wrap around so that windows containing 0h need no special case.
+ */
+void	CompactCatalog::select(const SkyWindow& window,
+		const MagnitudeRange& magrange,
+		std::vector<uint64_t>& indices) const {
+	// declination range
+	double	bottom = window.center().dec().radians()
+			- window.decheight().radians() / 2;
+	double	top = window.center().dec().radians()
+			+ window.decheight().radians() / 2;
+	bottom = std::max(bottom, -M_PI / 2);
+	top = std::min(top, M_PI / 2);
+	if (bottom > top) {
+		return;
+	}
+	int32_t	declo = CompactCoordinates::dec(bottom);
+	int32_t	dechi = CompactCoordinates::dec(top);
+
+	// right ascension range
+	bool	allra = (window.rawidth().radians() >= 2 * M_PI - 1e-9);
+	uint32_t	ralo = 0;
+	uint32_t	width = UINT32_MAX;
+	if (!allra) {
+		ralo = CompactCoordinates::ra(window.center().ra().radians()
+			- window.rawidth().radians() / 2);
+		double	w = round(window.rawidth().radians()
+				* (TWO32 / (2 * M_PI)));
+		width = (w < UINT32_MAX) ? (uint32_t)w : UINT32_MAX;
+	}
+
+	// magnitude range
+	int16_t	maglo = CompactCoordinates::mag(magrange.brightest());
+	int16_t	maghi = CompactCoordinates::mag(magrange.faintest());
+
+	std::vector<uint8_t>	mask;
+	uint32_t	z0 = zone(declo, _header->nzones);
+	uint32_t	z1 = zone(dechi, _header->nzones);
+	for (uint32_t z = z0; z <= z1; z++) {
+		uint32_t	n = _zones[z].ncells;
+		uint32_t	c0 = 0;
+		uint32_t	count = n;
+		if (!allra) {
+			c0 = cell(ralo, n);
+			uint32_t	c1 = cell(ralo + width, n);
+			count = (c1 + n - c0) % n + 1;
+			// a window wider than a cell ending in its first cell
+			// has wrapped around the sky
+			if ((count == 1) && (width > UINT32_MAX / n)) {
+				count = n;
+			}
+		}
+		for (uint32_t k = 0; k < count; k++) {
+			uint32_t	c = _zones[z].firstcell + (c0 + k) % n;
+			const int16_t	*mag = _mag + _cells[c];
+			const int16_t	*magend = _mag + _cells[c + 1];
+			const int16_t	*lo = std::lower_bound(mag, magend, maglo);
+			const int16_t	*hi = std::upper_bound(lo, magend, maghi);
+			uint64_t	first = lo - _mag;
+			size_t	m = hi - lo;
+			mask.resize(m);
+			uint8_t	*masks = mask.data();
+			const uint32_t	*ra = _ra + first;
+			const int32_t	*dec = _dec + first;
+#pragma omp simd
+			for (size_t i = 0; i < m; i++) {
+				masks[i] = ((uint32_t)(ra[i] - ralo) <= width)
+					& (dec[i] >= declo) & (dec[i] <= dechi);
+			}
+			for (size_t i = 0; i < m; i++) {
+				if (masks[i]) {
+					indices.push_back(first + i);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * \brief Retrieve the stars in a window as light weight stars
+ */
+StarTilePtr	CompactCatalog::findTile(const SkyWindow& window,
+			const MagnitudeRange& magrange) {
+	std::vector<uint64_t>	indices;
+	select(window, magrange, indices);
+	StarTile	*tile = new StarTile(window, indices.size());
+	StarTilePtr	tileptr(tile);
+	for (size_t i = 0; i < indices.size(); i++) {
+		(*tile)[i] = lightweight(indices[i]);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%lu stars in tile %s",
+		tile->size(), window.toString().c_str());
+	return tileptr;
+}
+
+/**
+ * \brief Retrieve the stars in a window
+ */
+Catalog::starsetptr	CompactCatalog::find(const SkyWindow& window,
+				const MagnitudeRange& magrange) {
+	std::vector<uint64_t>	indices;
+	select(window, magrange, indices);
+	starset	*result = new starset();
+	starsetptr	resultptr(result);
+	for (auto i = indices.begin(); i != indices.end(); i++) {
+		result->insert(star(*i));
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "found %lu stars", result->size());
+	return resultptr;
+}
+
+/**
+ * \brief Retrieve a star by name
+ */
+Star	CompactCatalog::find(const std::string& name) {
+	char	catalog;
+	uint64_t	number;
+	parsename(name, catalog, number);
+	for (uint64_t i = 0; i < _header->nstars; i++) {
+		if ((_number[i] == number) && (_catalog[i] == catalog)) {
+			return star(i);
+		}
+	}
+	std::string	msg = stringprintf("star %s not found", name.c_str());
+	debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+	throw std::runtime_error(msg);
+}
+
+CatalogIterator	CompactCatalog::begin() {
+	IteratorImplementationPtr	impl(new CompactCatalogIterator(*this));
+	return CatalogIterator(impl);
+}
+
+} // namespace catalog
+} // namespace astro
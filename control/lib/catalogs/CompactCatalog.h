@@ -0,0 +1,160 @@
+/*
+ * CompactCatalog.h -- memory mapped star catalog in fixed point format
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#ifndef _CompactCatalog_h
+#define _CompactCatalog_h
+
+#include <AstroCatalog.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "MappedFile.h"
+#include "CatalogIterator.h"
+
+namespace astro {
+namespace catalog {
+
+/**
+ * \brief Header of the compact catalog file
+ *
+ * The header is followed by the zone table, the cell offsets and the
+ * star arrays ra, dec, mag, pmra, pmdec, catalog and number, each of
+ * them padded to a multiple of 8 bytes. All values are in host byte
+ * order.
+ */
+struct compactcatalog_header {
+	char	magic[8];
+	uint32_t	nzones;
+	uint32_t	ncells;
+	uint64_t	nstars;
+};
+
+#define COMPACTCATALOG_MAGIC	"ASTROCT1"
+
+/**
+ * \brief Zone table entry
+ *
+ * The sky is divided into declination zones of equal height, and each
+ * zone is divided into cells of equal right ascension width, so that
+ * the cells are roughly square. The cells of a zone are consecutive.
+ */
+struct compactcatalog_zone {
+	uint32_t	firstcell;
+	uint32_t	ncells;
+};
+
+/**
+ * \brief Conversion between angles and the fixed point representation
+ *
+ * Right ascension uses the full range of an unsigned 32 bit integer,
+ * so that differences wrap around at 24h. Declination is scaled
+ * such that pi corresponds to 2^31, magnitudes are in millimag and
+ * proper motions in micro arc seconds per year.
+ */
+class CompactCoordinates {
+public:
+	static uint32_t	ra(double radians);
+	static double	ra(uint32_t ra);
+	static int32_t	dec(double radians);
+	static double	dec(int32_t dec);
+	static int16_t	mag(float mag);
+	static float	mag(int16_t mag);
+	static int32_t	pm(double radians);
+	static double	pm(int32_t pm);
+};
+
+/**
+ * \brief Star catalog in a compact, memory mapped structure of arrays
+ *
+ * The stars of each cell are sorted by magnitude, so a magnitude range
+ * query only has to look at a contiguous range of each cell, and the
+ * position test on this range works on fixed point arrays, which the
+ * compiler can vectorize.
+ */
+class CompactCatalog : public Catalog, public MappedFile {
+	const compactcatalog_header	*_header;
+	const compactcatalog_zone	*_zones;
+	const uint64_t	*_cells;
+	const uint32_t	*_ra;
+	const int32_t	*_dec;
+	const int16_t	*_mag;
+	const int32_t	*_pmra;
+	const int32_t	*_pmdec;
+	const char	*_catalog;
+	const uint64_t	*_number;
+	void	select(const SkyWindow& window, const MagnitudeRange& magrange,
+			std::vector<uint64_t>& indices) const;
+public:
+	CompactCatalog(const std::string& filename);
+	virtual ~CompactCatalog();
+	uint32_t	nzones() const;
+	uint32_t	ncells() const;
+	uint64_t	nstars() const;
+	LightWeightStar	lightweight(uint64_t index) const;
+	Star	star(uint64_t index) const;
+	virtual Star	find(const std::string& name);
+	virtual starsetptr	find(const SkyWindow& window,
+					const MagnitudeRange& magrange);
+	virtual unsigned long	numberOfStars();
+	virtual CatalogIterator	begin();
+	virtual StarTilePtr	findTile(const SkyWindow& window,
+					const MagnitudeRange& magrange);
+	static std::string	starname(char catalog, uint64_t number);
+	static void	parsename(const std::string& name, char& catalog,
+				uint64_t& number);
+	static uint32_t	zone(int32_t dec, uint32_t nzones);
+	static uint32_t	cellsinzone(uint32_t zone, uint32_t nzones);
+	static uint32_t	cell(uint32_t ra, uint32_t ncells);
+};
+
+typedef std::shared_ptr<CompactCatalog>	CompactCatalogPtr;
+
+/**
+ * \brief Iterator over all stars of a compact catalog in file order
+ */
+class CompactCatalogIterator : public IteratorImplementation {
+	const CompactCatalog&	_catalog;
+	uint64_t	_index;
+public:
+	CompactCatalogIterator(const CompactCatalog& catalog);
+	virtual Star	operator*();
+	bool	operator==(const CompactCatalogIterator& other) const;
+	virtual bool	operator==(const IteratorImplementation& other) const;
+	virtual std::string	toString() const;
+	virtual void	increment();
+};
+
+/**
+ * \brief Create a compact catalog file
+ *
+ * Stars are collected in memory and sorted into cells when the file
+ * is written, which needs about 32 bytes per star.
+ */
+class CompactCatalogCreator {
+	std::string	_filename;
+	uint32_t	_nzones;
+	struct record {
+		uint32_t	cell;
+		int16_t	mag;
+		char	catalog;
+		uint32_t	ra;
+		int32_t	dec;
+		int32_t	pmra;
+		int32_t	pmdec;
+		uint64_t	number;
+	};
+	std::vector<record>	_records;
+public:
+	CompactCatalogCreator(const std::string& filename,
+		uint32_t nzones = 180);
+	void	add(const Star& star);
+	uint64_t	count() const { return _records.size(); }
+	void	write();
+};
+
+} // namespace catalog
+} // namespace astro
+
+#endif /* _CompactCatalog_h */
@@ -0,0 +1,135 @@
+/*
+ * CompactCatalogCreator.cpp -- write a compact catalog file
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include "CompactCatalog.h"
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace astro {
+namespace catalog {
+
+/**
+ * \brief Create a compact catalog creator
+ *
+ * \param filename	name of the catalog file to write
+ * \param nzones	number of declination zones
+ */
+CompactCatalogCreator::CompactCatalogCreator(const std::string& filename,
+	uint32_t nzones) : _filename(filename), _nzones(nzones) {
+	if (_nzones < 1) {
+		std::string	msg = stringprintf("bad number of zones: %u",
+			_nzones);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+}
+
+/**
+ * \brief Add a star to the catalog
+ */
+void	CompactCatalogCreator::add(const Star& star) {
+	record	r;
+	r.ra = CompactCoordinates::ra(star.ra().radians());
+	r.dec = CompactCoordinates::dec(star.dec().radians());
+	r.mag = CompactCoordinates::mag(star.mag());
+	r.pmra = CompactCoordinates::pm(star.pm().ra().radians());
+	r.pmdec = CompactCoordinates::pm(star.pm().dec().radians());
+	r.catalog = star.catalog();
+	r.number = star.catalognumber();
+	r.cell = 0;
+	_records.push_back(r);
+}
+
+/**
+ * \brief Write an array padded to a multiple of 8 bytes
+ */
+template<typename T, typename F>
+static void	writearray(std::ofstream& out, const std::vector<T>& records,
+			F field) {
+	typedef decltype(field(records[0]))	value_type;
+	std::vector<value_type>	values(records.size());
+	for (size_t i = 0; i < records.size(); i++) {
+		values[i] = field(records[i]);
+	}
+	size_t	length = values.size() * sizeof(value_type);
+	out.write((const char *)values.data(), length);
+	static const char	zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	out.write(zeros, ((length + 7) & ~(size_t)7) - length);
+}
+
+/**
+ * \brief Sort the stars into cells and write the file
+ */
+void	CompactCatalogCreator::write() {
+	// zone table
+	std::vector<compactcatalog_zone>	zones(_nzones);
+	uint32_t	ncells = 0;
+	for (uint32_t z = 0; z < _nzones; z++) {
+		zones[z].firstcell = ncells;
+		zones[z].ncells = CompactCatalog::cellsinzone(z, _nzones);
+		ncells += zones[z].ncells;
+	}
+
+	// sort stars by cell and magnitude
+	for (auto r = _records.begin(); r != _records.end(); r++) {
+		const compactcatalog_zone&	zone
+			= zones[CompactCatalog::zone(r->dec, _nzones)];
+		r->cell = zone.firstcell
+			+ CompactCatalog::cell(r->ra, zone.ncells);
+	}
+	std::sort(_records.begin(), _records.end(),
+		[](const record& a, const record& b) {
+			if (a.cell != b.cell) {
+				return a.cell < b.cell;
+			}
+			return a.mag < b.mag;
+		}
+	);
+
+	// cell offsets
+	std::vector<uint64_t>	cells(ncells + 1, 0);
+	for (auto r = _records.begin(); r != _records.end(); r++) {
+		cells[r->cell + 1]++;
+	}
+	for (uint32_t c = 0; c < ncells; c++) {
+		cells[c + 1] += cells[c];
+	}
+
+	// write the file
+	compactcatalog_header	header;
+	memcpy(header.magic, COMPACTCATALOG_MAGIC, 8);
+	header.nzones = _nzones;
+	header.ncells = ncells;
+	header.nstars = _records.size();
+	std::ofstream	out(_filename.c_str(),
+				std::ios::out | std::ios::binary | std::ios::trunc);
+	out.write((const char *)&header, sizeof(header));
+	writearray(out, zones,
+		[](const compactcatalog_zone& z) { return z; });
+	writearray(out, cells, [](uint64_t c) { return c; });
+	writearray(out, _records, [](const record& r) { return r.ra; });
+	writearray(out, _records, [](const record& r) { return r.dec; });
+	writearray(out, _records, [](const record& r) { return r.mag; });
+	writearray(out, _records, [](const record& r) { return r.pmra; });
+	writearray(out, _records, [](const record& r) { return r.pmdec; });
+	writearray(out, _records, [](const record& r) { return r.catalog; });
+	writearray(out, _records, [](const record& r) { return r.number; });
+	out.close();
+	if (!out) {
+		std::string	msg = stringprintf("cannot write compact catalog %s",
+			_filename.c_str());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "compact catalog %s: %lu stars in "
+		"%u cells", _filename.c_str(), _records.size(), ncells);
+}
+
+} // namespace catalog
+} // namespace astro
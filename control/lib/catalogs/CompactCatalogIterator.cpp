@@ -0,0 +1,45 @@
+/*
+ * CompactCatalogIterator.cpp -- iterate through a compact catalog
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include "CompactCatalog.h"
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+
+namespace astro {
+namespace catalog {
+
+CompactCatalogIterator::CompactCatalogIterator(const CompactCatalog& catalog)
+	: IteratorImplementation(true), _catalog(catalog), _index(0) {
+	_isEnd = (0 == _catalog.nstars());
+}
+
+Star	CompactCatalogIterator::operator*() {
+	return _catalog.star(_index);
+}
+
+bool	CompactCatalogIterator::operator==(
+		const CompactCatalogIterator& other) const {
+	return (&_catalog == &other._catalog) && (_index == other._index);
+}
+
+bool	CompactCatalogIterator::operator==(
+		const IteratorImplementation& other) const {
+	return equal_implementation(this, other);
+}
+
+void	CompactCatalogIterator::increment() {
+	if (isEnd()) {
+		return;
+	}
+	_index++;
+	_isEnd = (_index >= _catalog.nstars());
+}
+
+std::string	CompactCatalogIterator::toString() const {
+	return stringprintf("%lu", _index);
+}
+
+} // namespace catalog
+} // namespace astro
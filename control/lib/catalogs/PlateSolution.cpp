@@ -0,0 +1,126 @@
+/*
+ * PlateSolution.cpp -- world coordinate system found by the plate solver
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroSolver.h>
+#include <AstroIO.h>
+#include <AstroFormat.h>
+#include <cmath>
+
+using namespace astro::io;
+
+namespace astro {
+namespace catalog {
+
+PlateSolution::PlateSolution() : _matches(0) {
+	for (int i = 0; i < 4; i++) {
+		_cd[i] = 0;
+	}
+}
+
+/**
+ * \brief Construct a solution from a transform to the tangent plane
+ *
+ * \param center	the point of the sky at the reference pixel
+ * \param reference	the reference pixel
+ * \param transform	affine transform from pixel coordinates to the
+ *			tangent plane at the center in radians, only the
+ *			linear part is used
+ * \param matches	the number of stars that confirm the solution
+ */
+PlateSolution::PlateSolution(const RaDec& center, const Point& reference,
+		const astro::image::transform::Transform& transform,
+		unsigned int matches)
+	: _center(center), _reference(reference), _matches(matches) {
+	_cd[0] = transform[0] * 180 / M_PI;
+	_cd[1] = transform[1] * 180 / M_PI;
+	_cd[2] = transform[3] * 180 / M_PI;
+	_cd[3] = transform[4] * 180 / M_PI;
+}
+
+/**
+ * \brief Pixel scale in arc seconds per pixel
+ */
+double	PlateSolution::scale() const {
+	return sqrt(fabs(_cd[0] * _cd[3] - _cd[1] * _cd[2])) * 3600;
+}
+
+/**
+ * \brief Angle between the north direction and the image y axis
+ */
+Angle	PlateSolution::rotation() const {
+	return Angle(atan2(_cd[2], _cd[3]));
+}
+
+/**
+ * \brief Whether the image is mirrored with respect to the sky
+ *
+ * An image of the sky seen from the inside of the celestial sphere with
+ * north up has east on the left, so its CD matrix has negative
+ * determinant. Images taken through a diagonal mirror have positive
+ * determinant.
+ */
+bool	PlateSolution::mirrored() const {
+	return (_cd[0] * _cd[3] - _cd[1] * _cd[2]) > 0;
+}
+
+/**
+ * \brief Sky position of a pixel
+ */
+RaDec	PlateSolution::radec(const Point& pixel) const {
+	double	dx = pixel.x() - _reference.x();
+	double	dy = pixel.y() - _reference.y();
+	Point	p((_cd[0] * dx + _cd[1] * dy) * M_PI / 180,
+		(_cd[2] * dx + _cd[3] * dy) * M_PI / 180);
+	return TangentPlane(_center).inverse(p);
+}
+
+/**
+ * \brief Pixel position of a point of the sky
+ */
+Point	PlateSolution::pixel(const RaDec& position) const {
+	Point	p = TangentPlane(_center).project(position) * (180 / M_PI);
+	double	det = _cd[0] * _cd[3] - _cd[1] * _cd[2];
+	return _reference + Point((_cd[3] * p.x() - _cd[1] * p.y()) / det,
+		(_cd[0] * p.y() - _cd[2] * p.x()) / det);
+}
+
+/**
+ * \brief Add the world coordinate system to the image metadata
+ *
+ * FITS pixel coordinates start at 1, so the reference pixel is shifted.
+ */
+void	PlateSolution::addMetadata(astro::image::ImageBase& image) const {
+	image.setMetadata(FITSKeywords::meta(std::string("CTYPE1"),
+		std::string("RA---TAN")));
+	image.setMetadata(FITSKeywords::meta(std::string("CTYPE2"),
+		std::string("DEC--TAN")));
+	image.setMetadata(FITSKeywords::meta(std::string("CRPIX1"),
+		_reference.x() + 1));
+	image.setMetadata(FITSKeywords::meta(std::string("CRPIX2"),
+		_reference.y() + 1));
+	image.setMetadata(FITSKeywords::meta(std::string("CRVAL1"),
+		_center.ra().degrees()));
+	image.setMetadata(FITSKeywords::meta(std::string("CRVAL2"),
+		_center.dec().degrees()));
+	image.setMetadata(FITSKeywords::meta(std::string("CD1_1"), _cd[0]));
+	image.setMetadata(FITSKeywords::meta(std::string("CD1_2"), _cd[1]));
+	image.setMetadata(FITSKeywords::meta(std::string("CD2_1"), _cd[2]));
+	image.setMetadata(FITSKeywords::meta(std::string("CD2_2"), _cd[3]));
+	image.setMetadata(FITSKeywords::meta(std::string("EQUINOX"), 2000.));
+	image.setMetadata(FITSKeywords::meta(std::string("RACENTR"),
+		_center.ra().hours()));
+	image.setMetadata(FITSKeywords::meta(std::string("DECCENTR"),
+		_center.dec().degrees()));
+}
+
+std::string	PlateSolution::toString() const {
+	return stringprintf("center=%s, scale=%.3f\"/pixel, rotation=%.2f, "
+		"%s, %u matches", _center.toString().c_str(), scale(),
+		rotation().degrees(), (mirrored()) ? "mirrored" : "not mirrored",
+		_matches);
+}
+
+} // namespace catalog
+} // namespace astro
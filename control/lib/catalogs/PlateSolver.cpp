@@ -0,0 +1,239 @@
+/*
+ * PlateSolver.cpp -- blind plate solver using a quad index
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroSolver.h>
+#include <AstroAdapter.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <cmath>
+#include <stdexcept>
+
+using namespace astro::image;
+using namespace astro::image::transform;
+
+namespace astro {
+namespace catalog {
+
+/**
+ * \brief Create a solver with default parameters
+ *
+ * By default, 30 stars are extracted from the image and quads are
+ * formed from the 12 brightest of them. A solution is accepted if at
+ * least 8 index stars are within 3 pixels of an image star.
+ */
+PlateSolver::PlateSolver(const QuadIndex& index) : _index(index),
+	_numberofstars(30), _quadstars(12), _codetolerance(0.01),
+	_tolerance(3), _minmatches(8), _minscale(0), _maxscale(0) {
+}
+
+/**
+ * \brief Restrict the pixel scale of solutions
+ *
+ * \param minscale	smallest acceptable scale in arc seconds per pixel
+ * \param maxscale	largest acceptable scale, 0 means no limit
+ */
+void	PlateSolver::scalerange(double minscale, double maxscale) {
+	if ((minscale < 0) || ((maxscale > 0) && (maxscale < minscale))) {
+		std::string	msg = stringprintf("bad scale range %.3f - %.3f",
+			minscale, maxscale);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	_minscale = minscale;
+	_maxscale = maxscale;
+}
+
+/**
+ * \brief Solve an image
+ *
+ * If the image does not contain enough stars, the solver tries again
+ * with fewer stars.
+ */
+PlateSolution	PlateSolver::operator()(ImagePtr image) const {
+	adapter::LuminanceExtractor	luminance(image);
+	StarAcceptanceCriterion	criterion(luminance);
+	unsigned int	n = _numberofstars;
+	while (n >= std::max(4U, _minmatches)) {
+		try {
+			StarExtractor	extractor(n);
+			std::vector<Point>	points
+				= extractor.points(image, criterion);
+			return (*this)(points, image->size());
+		} catch (const std::range_error& x) {
+			debug(LOG_DEBUG, DEBUG_LOG, 0, "cannot get %u stars: %s",
+				n, x.what());
+		}
+		n = n / 2;
+	}
+	std::string	msg("not enough stars to solve the image");
+	debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+	throw std::runtime_error(msg);
+}
+
+/**
+ * \brief Solve a set of star positions
+ *
+ * \param stars		star positions in pixel coordinates, brightest
+ *			star first
+ * \param size		size of the image
+ */
+PlateSolution	PlateSolver::operator()(const std::vector<Point>& stars,
+			const ImageSize& size) const {
+	if (stars.size() < 4) {
+		std::string	msg = stringprintf("%lu stars are not enough "
+			"to form a quad", stars.size());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	PointTree	tree(stars);
+	int	n = std::min((size_t)_quadstars, stars.size());
+	unsigned long	candidates = 0;
+	PlateSolution	solution;
+
+	// form quads, using fainter stars only after all quads of
+	// brighter stars have been tried
+	for (int l = 3; l < n; l++)
+	for (int i = 0; i < l; i++)
+	for (int j = i + 1; j < l; j++)
+	for (int k = j + 1; k < l; k++) {
+		int	m[4] = { i, j, k, l };
+		// the image may be mirrored with respect to the index,
+		// mirroring the quad swaps the code coordinates
+		for (int parity = 0; parity < 2; parity++) {
+			Point	p[4];
+			for (int q = 0; q < 4; q++) {
+				const Point&	s = stars[m[q]];
+				p[q] = (parity) ? Point(s.x(), -s.y()) : s;
+			}
+			QuadCode	code(p);
+			if (!code.valid()) {
+				continue;
+			}
+			Point	pixels[4];
+			for (int q = 0; q < 4; q++) {
+				pixels[q] = stars[m[code.order(q)]];
+			}
+			for (unsigned int level = 0; level < _index.nlevels();
+				level++) {
+				std::vector<QuadIndexEntry>	quads
+					= _index.lookup(level, code,
+						_codetolerance);
+				for (auto q = quads.begin(); q != quads.end();
+					q++) {
+					candidates++;
+					if (verify(stars, tree, size, *q, pixels,
+						solution)) {
+						debug(LOG_DEBUG, DEBUG_LOG, 0,
+							"solution after %lu "
+							"candidates: %s",
+							candidates,
+							solution.toString().c_str());
+						return solution;
+					}
+				}
+			}
+		}
+	}
+	std::string	msg = stringprintf("no solution found among %lu "
+		"candidates", candidates);
+	debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+	throw std::runtime_error(msg);
+}
+
+/**
+ * \brief Fit a transform from pixels to the tangent plane at a center
+ */
+static Transform	fit(const std::vector<Point>& pixels,
+				const std::vector<RaDec>& sky,
+				const RaDec& center) {
+	TangentPlane	plane(center);
+	std::vector<Point>	to;
+	for (auto s = sky.begin(); s != sky.end(); s++) {
+		to.push_back(plane.project(*s));
+	}
+	TransformFactory	factory;
+	return factory(pixels, to);
+}
+
+/**
+ * \brief Verify a candidate match of an image quad with an index quad
+ *
+ * The four stars of the quads determine a preliminary transform from
+ * pixel coordinates to the tangent plane. The index stars in the field
+ * are then mapped to the image and matched with the image stars. The
+ * matches are used to refine the transform, and the candidate is
+ * accepted if enough stars match in the end.
+ */
+bool	PlateSolver::verify(const std::vector<Point>& stars,
+		const PointTree& tree, const ImageSize& size,
+		const QuadIndexEntry& quad, const Point pixels[4],
+		PlateSolution& solution) const {
+	std::vector<Point>	from(pixels, pixels + 4);
+	std::vector<RaDec>	sky;
+	for (int q = 0; q < 4; q++) {
+		sky.push_back(_index.star(quad.stars[q]));
+	}
+	Point	reference((size.width() - 1) / 2., (size.height() - 1) / 2.);
+	RaDec	center = sky[0];
+	unsigned int	matches = 0;
+	for (int iteration = 0; iteration < 3; iteration++) {
+		// fit the transform in the plane of the current center, then
+		// move the center to the reference pixel and fit again
+		Transform	t = fit(from, sky, center);
+		center = TangentPlane(center).inverse(t(reference));
+		t = fit(from, sky, center);
+
+		// a plausible transform is a similarity of reasonable scale
+		double	s1 = hypot(t[0], t[3]);
+		double	s2 = hypot(t[1], t[4]);
+		if ((s1 <= 0) || (s2 <= 0) || (fabs(s1 / s2 - 1) > 0.05)
+			|| (fabs(t[0] * t[1] + t[3] * t[4]) / (s1 * s2) > 0.05)) {
+			return false;
+		}
+		double	scale = sqrt(s1 * s2);
+		double	arcsec = scale * 180 * 3600 / M_PI;
+		if ((_minscale > 0) && (arcsec < _minscale)) {
+			return false;
+		}
+		if ((_maxscale > 0) && (arcsec > _maxscale)) {
+			return false;
+		}
+
+		// map the index stars in the field to the image
+		TangentPlane	plane(center);
+		Transform	inverse = t.inverse();
+		Angle	radius(scale * hypot(size.width(), size.height()) * 0.55);
+		std::vector<size_t>	candidates = _index.stars(center, radius);
+		std::vector<Point>	matchedpixels;
+		std::vector<RaDec>	matchedsky;
+		unsigned int	infield = 0;
+		for (auto c = candidates.begin(); c != candidates.end(); c++) {
+			RaDec	position = _index.star(*c);
+			Point	p = inverse(plane.project(position));
+			if ((p.x() < 0) || (p.x() > size.width() - 1)
+				|| (p.y() < 0) || (p.y() > size.height() - 1)) {
+				continue;
+			}
+			infield++;
+			int	nearest = tree.nearest(p);
+			if (distance(p, stars[nearest]) <= _tolerance) {
+				matchedpixels.push_back(stars[nearest]);
+				matchedsky.push_back(position);
+			}
+		}
+		matches = matchedpixels.size();
+		if ((matches < _minmatches) || (matches < 4)
+			|| (4 * matches < std::min((size_t)infield, stars.size()))) {
+			return false;
+		}
+		from = matchedpixels;
+		sky = matchedsky;
+		solution = PlateSolution(center, reference, t, matches);
+	}
+	return true;
+}
+
+} // namespace catalog
+} // namespace astro
@@ -0,0 +1,97 @@
+/*
+ * QuadCode.cpp -- geometric hash code of four stars
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroSolver.h>
+#include <cmath>
+#include <utility>
+
+namespace astro {
+namespace catalog {
+
+/**
+ * \brief Compute the code of four points
+ *
+ * The code is valid if C and D are inside the circle that has AB as its
+ * diameter. This keeps the code coordinates inside a bounded range and
+ * avoids quads whose codes are very sensitive to position errors.
+ */
+QuadCode::QuadCode(const Point points[4]) : _valid(true) {
+	// find the two points farthest apart
+	int	a = 0, b = 1;
+	double	dmax = -1;
+	for (int i = 0; i < 4; i++) {
+		for (int j = i + 1; j < 4; j++) {
+			double	d = astro::distance(points[i], points[j]);
+			if (d > dmax) {
+				dmax = d;
+				a = i;
+				b = j;
+			}
+		}
+	}
+	int	c = -1, d = -1;
+	for (int i = 0; i < 4; i++) {
+		if ((i == a) || (i == b)) {
+			continue;
+		}
+		if (c < 0) { c = i; } else { d = i; }
+	}
+
+	// express C and D as complex multiples w of the vector AB, the
+	// code coordinates are w * (1 + i)
+	double	abx = points[b].x() - points[a].x();
+	double	aby = points[b].y() - points[a].y();
+	double	ab2 = abx * abx + aby * aby;
+	int	cd[2] = { c, d };
+	double	x[2], y[2];
+	for (int k = 0; k < 2; k++) {
+		double	vx = points[cd[k]].x() - points[a].x();
+		double	vy = points[cd[k]].y() - points[a].y();
+		double	re = (vx * abx + vy * aby) / ab2;
+		double	im = (vy * abx - vx * aby) / ab2;
+		if (hypot(re - 0.5, im) > 0.5) {
+			_valid = false;
+		}
+		x[k] = re - im;
+		y[k] = re + im;
+	}
+
+	// swapping A and B maps the code (x,y) to (1-x,1-y)
+	if (x[0] + x[1] > 1) {
+		std::swap(a, b);
+		for (int k = 0; k < 2; k++) {
+			x[k] = 1 - x[k];
+			y[k] = 1 - y[k];
+		}
+	}
+	if (x[0] > x[1]) {
+		std::swap(cd[0], cd[1]);
+		std::swap(x[0], x[1]);
+		std::swap(y[0], y[1]);
+	}
+	_order[0] = a;
+	_order[1] = b;
+	_order[2] = cd[0];
+	_order[3] = cd[1];
+	_code[0] = x[0];
+	_code[1] = y[0];
+	_code[2] = x[1];
+	_code[3] = y[1];
+}
+
+/**
+ * \brief Euclidean distance between two codes
+ */
+double	QuadCode::distance(const float *a, const float *b) {
+	double	s = 0;
+	for (int i = 0; i < 4; i++) {
+		double	d = a[i] - b[i];
+		s += d * d;
+	}
+	return sqrt(s);
+}
+
+} // namespace catalog
+} // namespace astro
@@ -0,0 +1,206 @@
+/*
+ * QuadIndex.cpp -- memory mapped index of star quads
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <QuadIndexFile.h>
+#include <MappedFile.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace astro {
+namespace catalog {
+
+/**
+ * \brief Number of buckets per code coordinate
+ */
+unsigned int	QuadIndex::bins = 24;
+
+/**
+ * \brief Range of the code coordinates of valid quads
+ *
+ * If C and D lie inside the circle with diameter AB, the code
+ * coordinates are between 0.5 - 1/sqrt(2) and 0.5 + 1/sqrt(2).
+ */
+double	QuadIndex::codemin = -0.25;
+double	QuadIndex::codemax = 1.25;
+
+static unsigned int	bin(double c) {
+	double	b = floor((c - QuadIndex::codemin)
+			/ (QuadIndex::codemax - QuadIndex::codemin)
+			* QuadIndex::bins);
+	if (b < 0) {
+		return 0;
+	}
+	if (b >= QuadIndex::bins) {
+		return QuadIndex::bins - 1;
+	}
+	return b;
+}
+
+/**
+ * \brief Compute the bucket key of a code
+ */
+uint32_t	QuadIndex::key(const float *code) {
+	uint32_t	k = 0;
+	for (int i = 0; i < 4; i++) {
+		k = k * bins + bin(code[i]);
+	}
+	return k;
+}
+
+/**
+ * \brief Map an index file and check its consistency
+ */
+QuadIndex::QuadIndex(const std::string& filename)
+	: _file(new MappedFile(filename, 1)) {
+	const char	*data = (const char *)_file->data_ptr;
+	size_t	length = _file->data_len;
+	_header = (const quadindex_header *)data;
+	if ((length < sizeof(quadindex_header))
+		|| (0 != memcmp(_header->magic, QUADINDEX_MAGIC, 8))) {
+		std::string	msg = stringprintf("%s is not a quad index",
+			filename.c_str());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	data += sizeof(quadindex_header);
+	_levels = (const quadindex_level *)data;
+	data += _header->nlevels * sizeof(quadindex_level);
+	_stars = (const quadindex_star *)data;
+	data += _header->nstars * sizeof(quadindex_star);
+	_quads = (const QuadIndexEntry *)data;
+	size_t	expected = data - (const char *)_file->data_ptr;
+	if (expected <= length) {
+		for (unsigned int l = 0; l < _header->nlevels; l++) {
+			expected += _levels[l].nquads * sizeof(QuadIndexEntry);
+		}
+	}
+	if (expected != length) {
+		std::string	msg = stringprintf("quad index %s has size %lu, "
+			"expected %lu", filename.c_str(), length, expected);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "quad index %s: %u levels, %u stars",
+		filename.c_str(), _header->nlevels, _header->nstars);
+}
+
+unsigned int	QuadIndex::nlevels() const {
+	return _header->nlevels;
+}
+
+/**
+ * \brief Size of the sky cells of a level
+ */
+Angle	QuadIndex::scale(unsigned int level) const {
+	return Angle(_levels[level].scale);
+}
+
+size_t	QuadIndex::nquads(unsigned int level) const {
+	return _levels[level].nquads;
+}
+
+const QuadIndexEntry&	QuadIndex::quad(unsigned int level,
+				size_t index) const {
+	if ((level >= _header->nlevels) || (index >= _levels[level].nquads)) {
+		std::string	msg = stringprintf("no quad %lu in level %u",
+			index, level);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::range_error(msg);
+	}
+	return _quads[_levels[level].offset + index];
+}
+
+size_t	QuadIndex::nstars() const {
+	return _header->nstars;
+}
+
+LightWeightStar	QuadIndex::star(size_t index) const {
+	const quadindex_star&	s = _stars[index];
+	return LightWeightStar(RaDec(Angle(s.ra), Angle(s.dec)), s.mag);
+}
+
+/**
+ * \brief Find the indices of all stars within a radius of a point
+ *
+ * Since the stars are sorted by declination, only the stars in the
+ * declination band of the circle have to be checked.
+ */
+std::vector<size_t>	QuadIndex::stars(const RaDec& center,
+				const Angle& radius) const {
+	double	r = radius.radians();
+	double	dec = center.dec().radians();
+	double	ra = center.ra().radians();
+	double	cosr = cos(r);
+	double	sindec = sin(dec);
+	double	cosdec = cos(dec);
+	const quadindex_star	*end = _stars + _header->nstars;
+	const quadindex_star	*s = std::lower_bound(_stars, end, dec - r,
+		[](const quadindex_star& star, double d) {
+			return star.dec < d;
+		}
+	);
+	std::vector<size_t>	result;
+	for (; (s < end) && (s->dec <= dec + r); s++) {
+		double	c = sin(s->dec) * sindec
+				+ cos(s->dec) * cosdec * cos(s->ra - ra);
+		if (c >= cosr) {
+			result.push_back(s - _stars);
+		}
+	}
+	return result;
+}
+
+/**
+ * \brief Find all quads of a level with a code close to a given code
+ *
+ * \param level		the level to search
+ * \param code		the code to look for
+ * \param tolerance	maximum euclidean distance between the codes
+ */
+std::vector<QuadIndexEntry>	QuadIndex::lookup(unsigned int level,
+					const QuadCode& code,
+					double tolerance) const {
+	std::vector<QuadIndexEntry>	result;
+	if (level >= _header->nlevels) {
+		return result;
+	}
+	const QuadIndexEntry	*begin = _quads + _levels[level].offset;
+	const QuadIndexEntry	*end = begin + _levels[level].nquads;
+
+	// the tolerance box around the code touches at most two buckets
+	// in each coordinate
+	unsigned int	lo[4], hi[4];
+	for (int i = 0; i < 4; i++) {
+		lo[i] = bin(code[i] - tolerance);
+		hi[i] = bin(code[i] + tolerance);
+	}
+	unsigned int	b[4];
+	for (b[0] = lo[0]; b[0] <= hi[0]; b[0]++)
+	for (b[1] = lo[1]; b[1] <= hi[1]; b[1]++)
+	for (b[2] = lo[2]; b[2] <= hi[2]; b[2]++)
+	for (b[3] = lo[3]; b[3] <= hi[3]; b[3]++) {
+		uint32_t	k = ((b[0] * bins + b[1]) * bins + b[2]) * bins
+					+ b[3];
+		const QuadIndexEntry	*q = std::lower_bound(begin, end, k,
+			[](const QuadIndexEntry& quad, uint32_t key) {
+				return quad.key < key;
+			}
+		);
+		for (; (q < end) && (q->key == k); q++) {
+			if (QuadCode::distance(q->code, code.code())
+				<= tolerance) {
+				result.push_back(*q);
+			}
+		}
+	}
+	return result;
+}
+
+} // namespace catalog
+} // namespace astro
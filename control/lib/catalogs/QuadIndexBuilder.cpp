@@ -0,0 +1,251 @@
+/*
+ * QuadIndexBuilder.cpp -- build a quad index from a star catalog
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <QuadIndexFile.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+namespace astro {
+namespace catalog {
+
+/**
+ * \brief Create a builder with default parameters
+ *
+ * By default, the index covers the complete sky and fields between
+ * half a degree and four degrees, using stars up to magnitude 12.
+ */
+QuadIndexBuilder::QuadIndexBuilder(CatalogPtr catalog) : _catalog(catalog),
+	_maglimit(12), _starspercell(8), _quadspercell(8) {
+	scales(Angle(0.5, Angle::Degrees), Angle(4, Angle::Degrees));
+}
+
+/**
+ * \brief Set the levels for a range of field sizes
+ *
+ * The cell size of the first level is the largest field size, each
+ * further level halves the cell size until it is smaller than half
+ * the smallest field size.
+ */
+void	QuadIndexBuilder::scales(const Angle& minfield, const Angle& maxfield) {
+	if ((minfield.radians() <= 0) || (maxfield < minfield)) {
+		std::string	msg = stringprintf("bad field range %.3f - %.3f",
+			minfield.degrees(), maxfield.degrees());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	_scales.clear();
+	double	s = maxfield.radians();
+	do {
+		_scales.push_back(Angle(s));
+		s = s / 2;
+	} while (s >= minfield.radians() / 2);
+}
+
+namespace {
+
+/**
+ * \brief Collect the stars and quads while the index is built
+ */
+class IndexCollector {
+	std::map<std::string, uint32_t>	_names;
+public:
+	std::vector<quadindex_star>	stars;
+	std::vector<std::vector<QuadIndexEntry> >	levels;
+	uint32_t	add(const Star& star) {
+		auto	i = _names.find(star.name());
+		if (i != _names.end()) {
+			return i->second;
+		}
+		quadindex_star	s;
+		s.ra = star.ra().radians();
+		s.dec = star.dec().radians();
+		s.mag = star.mag();
+		s.reserved = 0;
+		uint32_t	index = stars.size();
+		stars.push_back(s);
+		_names.insert(std::make_pair(star.name(), index));
+		return index;
+	}
+};
+
+} // namespace
+
+/**
+ * \brief Build the index and write it to a file
+ */
+void	QuadIndexBuilder::build(const std::string& filename) const {
+	IndexCollector	collector;
+	MagnitudeRange	magrange(-30, _maglimit);
+	for (size_t level = 0; level < _scales.size(); level++) {
+		double	s = _scales[level].radians();
+		std::set<std::array<uint32_t, 4> >	known;
+		std::vector<QuadIndexEntry>	quads;
+
+		// divide the sky into declination bands of height s, and each
+		// band into cells that are at least s wide
+		int	nbands = ceil(M_PI / s);
+		double	h = M_PI / nbands;
+		for (int band = 0; band < nbands; band++) {
+			double	dec0 = -M_PI / 2 + band * h;
+			double	dec1 = dec0 + h;
+			double	cosdec = ((dec0 < 0) && (dec1 > 0)) ? 1
+				: cos(std::min(fabs(dec0), fabs(dec1)));
+			int	ncells = std::max(1, (int)ceil(2 * M_PI * cosdec / s));
+			double	w = 2 * M_PI / ncells;
+			for (int cell = 0; cell < ncells; cell++) {
+				RaDec	center(Angle((cell + 0.5) * w),
+						Angle((dec0 + dec1) / 2));
+				if (!_window.contains(center)) {
+					continue;
+				}
+
+				// get the brightest stars of an enlarged cell,
+				// so that quads across cell borders are found
+				Catalog::starsetptr	starset = _catalog->find(
+					SkyWindow(center, Angle(1.5 * w),
+						Angle(1.5 * h)), magrange);
+				std::vector<Star>	cellstars(starset->begin(),
+								starset->end());
+				std::sort(cellstars.begin(), cellstars.end(),
+					[](const Star& a, const Star& b) {
+						return a.mag() < b.mag();
+					}
+				);
+				if (cellstars.size() > _starspercell) {
+					cellstars.erase(cellstars.begin()
+						+ _starspercell, cellstars.end());
+				}
+				int	n = cellstars.size();
+				if (n < 4) {
+					continue;
+				}
+				TangentPlane	plane(center);
+				std::vector<Point>	points;
+				std::vector<uint32_t>	indices;
+				for (int i = 0; i < n; i++) {
+					points.push_back(plane.project(cellstars[i]));
+					indices.push_back(collector.add(cellstars[i]));
+				}
+
+				// form quads, preferring the brightest stars
+				unsigned int	count = 0;
+				for (int l = 3; (l < n) && (count < _quadspercell); l++)
+				for (int i = 0; (i < l) && (count < _quadspercell); i++)
+				for (int j = i + 1; (j < l) && (count < _quadspercell); j++)
+				for (int k = j + 1; (k < l) && (count < _quadspercell); k++) {
+					int	m[4] = { i, j, k, l };
+					Point	p[4];
+					for (int q = 0; q < 4; q++) {
+						p[q] = points[m[q]];
+					}
+					QuadCode	code(p);
+					if (!code.valid()) {
+						continue;
+					}
+					double	ab = distance(p[code.order(0)],
+							p[code.order(1)]);
+					if ((ab < s / 3) || (ab > s)) {
+						continue;
+					}
+					std::array<uint32_t, 4>	id;
+					QuadIndexEntry	quad;
+					for (int q = 0; q < 4; q++) {
+						quad.stars[q] = indices[m[code.order(q)]];
+						quad.code[q] = code[q];
+						id[q] = quad.stars[q];
+					}
+					std::sort(id.begin(), id.end());
+					if (!known.insert(id).second) {
+						continue;
+					}
+					quad.key = QuadIndex::key(quad.code);
+					quads.push_back(quad);
+					count++;
+				}
+			}
+		}
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "level %d, scale %.3f: %lu quads",
+			level, _scales[level].degrees(), quads.size());
+		collector.levels.push_back(quads);
+	}
+
+	// sort the stars by declination and renumber the quad vertices
+	std::vector<uint32_t>	order(collector.stars.size());
+	for (size_t i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(),
+		[&](uint32_t a, uint32_t b) {
+			return collector.stars[a].dec < collector.stars[b].dec;
+		}
+	);
+	std::vector<uint32_t>	renumber(order.size());
+	std::vector<quadindex_star>	stars(order.size());
+	for (size_t i = 0; i < order.size(); i++) {
+		renumber[order[i]] = i;
+		stars[i] = collector.stars[order[i]];
+	}
+	for (auto l = collector.levels.begin(); l != collector.levels.end();
+		l++) {
+		for (auto q = l->begin(); q != l->end(); q++) {
+			for (int i = 0; i < 4; i++) {
+				q->stars[i] = renumber[q->stars[i]];
+			}
+		}
+		std::stable_sort(l->begin(), l->end(),
+			[](const QuadIndexEntry& a, const QuadIndexEntry& b) {
+				return a.key < b.key;
+			}
+		);
+	}
+
+	// write the file
+	quadindex_header	header;
+	memcpy(header.magic, QUADINDEX_MAGIC, 8);
+	header.nlevels = _scales.size();
+	header.nstars = stars.size();
+	std::vector<quadindex_level>	levels;
+	uint64_t	offset = 0;
+	for (size_t l = 0; l < _scales.size(); l++) {
+		quadindex_level	level;
+		level.scale = _scales[l].radians();
+		level.nquads = collector.levels[l].size();
+		level.offset = offset;
+		offset += level.nquads;
+		levels.push_back(level);
+	}
+	std::ofstream	out(filename.c_str(),
+				std::ios::out | std::ios::binary | std::ios::trunc);
+	out.write((const char *)&header, sizeof(header));
+	out.write((const char *)levels.data(),
+		levels.size() * sizeof(quadindex_level));
+	out.write((const char *)stars.data(),
+		stars.size() * sizeof(quadindex_star));
+	for (auto l = collector.levels.begin(); l != collector.levels.end();
+		l++) {
+		out.write((const char *)l->data(),
+			l->size() * sizeof(QuadIndexEntry));
+	}
+	out.close();
+	if (!out) {
+		std::string	msg = stringprintf("cannot write quad index %s",
+			filename.c_str());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "quad index %s: %lu stars, %lu quads",
+		filename.c_str(), stars.size(), offset);
+}
+
+} // namespace catalog
+} // namespace astro
@@ -0,0 +1,51 @@
+/*
+ * QuadIndexFile.h -- records of the quad index file
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#ifndef _QuadIndexFile_h
+#define _QuadIndexFile_h
+
+#include <AstroSolver.h>
+#include <cstdint>
+
+namespace astro {
+namespace catalog {
+
+/**
+ * \brief Header of the quad index file
+ *
+ * The header is followed by the level table, the star table and the
+ * quads of all levels. All records are written in host byte order.
+ */
+struct quadindex_header {
+	char	magic[8];
+	uint32_t	nlevels;
+	uint32_t	nstars;
+};
+
+#define QUADINDEX_MAGIC	"QUADIDX1"
+
+/**
+ * \brief Level table entry, the quads of a level are consecutive
+ */
+struct quadindex_level {
+	float	scale;		// cell size in radians
+	uint32_t	nquads;
+	uint64_t	offset;		// index of the first quad of the level
+};
+
+/**
+ * \brief Star table entry, the stars are sorted by declination
+ */
+struct quadindex_star {
+	double	ra;		// radians
+	double	dec;		// radians
+	float	mag;
+	uint32_t	reserved;
+};
+
+} // namespace catalog
+} // namespace astro
+
+#endif /* _QuadIndexFile_h */
@@ -0,0 +1,269 @@
+/*
+ * StarRenderer.cpp -- render stars by adding point spread function kernels
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroChart.h>
+#include <AstroDebug.h>
+#include <algorithm>
+#include <cmath>
+
+namespace astro {
+namespace catalog {
+
+/**
+ * \brief Number of samples per pixel of the radial profile table
+ */
+int	StarRenderer::oversampling = 8;
+
+/**
+ * \brief Precompute the profile table and the kernels
+ *
+ * \param pointspreadfunction	the point spread function, as a function
+ *				of the angular distance from the star
+ * \param angularpixelsize	angular size of a pixel in radians
+ * \param maxradius		largest kernel radius in pixels
+ * \param subpixels		number of subpixel offsets per axis
+ * \param threshold		smallest pixel contribution to render
+ */
+StarRenderer::StarRenderer(const PointSpreadFunction& pointspreadfunction,
+	double angularpixelsize, int maxradius, int subpixels,
+	double threshold)
+	: _angularpixelsize(angularpixelsize), _radius(maxradius),
+	  _subpixels(subpixels), _threshold(threshold) {
+	if (_subpixels < 1) {
+		_subpixels = 1;
+	}
+	// a Dirac point spread function is rendered by distributing the
+	// intensity of a star over the four nearest pixels
+	_dirac = (NULL != dynamic_cast<const DiracPointSpreadFunction *>(
+		&pointspreadfunction));
+	if (_dirac) {
+		_radius = 0;
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "Dirac PSF, no kernels");
+		return;
+	}
+
+	// sample the profile up to the corner of the largest kernel
+	int	n = ceil((maxradius * M_SQRT2 + 2) * oversampling) + 1;
+	_profile.resize(n);
+	for (int i = 0; i < n; i++) {
+		double	r = i * _angularpixelsize / oversampling;
+		double	value = pointspreadfunction(r);
+		// the Airy function is only defined as a limit at the center
+		if (!std::isfinite(value)) {
+			value = pointspreadfunction(r
+				+ 0.001 * _angularpixelsize / oversampling);
+		}
+		_profile[i] = value;
+	}
+
+	// the envelope is the largest value at an integer pixel distance
+	// or beyond it, which bounds the contribution of omitted pixels
+	_envelope.resize(maxradius + 1, 0.);
+	double	m = 0;
+	for (int i = n - 1; i >= 0; i--) {
+		m = std::max(m, fabs(_profile[i]));
+		if (i / oversampling <= maxradius) {
+			_envelope[i / oversampling] = m;
+		}
+	}
+
+	// point spread functions with finite support need smaller kernels
+	int	r = 0;
+	while ((r < maxradius) && (_envelope[r] > 0)) {
+		r++;
+	}
+	_radius = r;
+
+	// compute the kernels for all subpixel offsets
+	int	k = 2 * _radius + 1;
+	_kernels.resize(_subpixels * _subpixels * k * k);
+	for (int sy = 0; sy < _subpixels; sy++) {
+		double	fy = sy / (double)_subpixels;
+		for (int sx = 0; sx < _subpixels; sx++) {
+			double	fx = sx / (double)_subpixels;
+			float	*kp = _kernels.data()
+					+ (sy * _subpixels + sx) * k * k;
+			for (int dy = -_radius; dy <= _radius; dy++) {
+				for (int dx = -_radius; dx <= _radius; dx++) {
+					*kp++ = profile(hypot(dx - fx, dy - fy));
+				}
+			}
+		}
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%d kernels of radius %d",
+		_subpixels * _subpixels, _radius);
+}
+
+/**
+ * \brief Kernel for a subpixel offset of the star
+ */
+const float	*StarRenderer::kernel(int sx, int sy) const {
+	int	k = 2 * _radius + 1;
+	return _kernels.data() + (sy * _subpixels + sx) * k * k;
+}
+
+/**
+ * \brief Value of the point spread function at a distance in pixels
+ */
+double	StarRenderer::profile(double r) const {
+	double	t = r * oversampling;
+	size_t	i = floor(t);
+	if (i + 1 >= _profile.size()) {
+		return 0.;
+	}
+	double	w = t - i;
+	return (1 - w) * _profile[i] + w * _profile[i + 1];
+}
+
+/**
+ * \brief Kernel radius needed for a star of some intensity
+ *
+ * Pixels farther away than the radius would receive less than the
+ * threshold from a star of this intensity.
+ */
+int	StarRenderer::radius(double intensity) const {
+	if (_dirac) {
+		return 0;
+	}
+	double	limit = _threshold / fabs(intensity);
+	// the envelope is decreasing, so a binary search works
+	int	lo = 0, hi = _radius;
+	while (lo < hi) {
+		int	mid = (lo + hi) / 2;
+		if (_envelope[mid] < limit) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+	return lo;
+}
+
+/**
+ * \brief Distribute the intensity of each star over the nearest pixels
+ */
+void	StarRenderer::deposit(Image<double>& image,
+		const std::vector<ChartPoint>& stars) {
+	int	w = image.size().width();
+	int	h = image.size().height();
+	for (auto s = stars.begin(); s != stars.end(); s++) {
+		int	x = floor(s->x());
+		int	y = floor(s->y());
+		double	wx = s->x() - x;
+		double	wy = s->y() - y;
+		double	I = s->intensity();
+		double	weights[2][2] = {
+			{ (1 - wx) * (1 - wy), wx * (1 - wy) },
+			{ (1 - wx) * wy, wx * wy }
+		};
+		for (int dy = 0; dy < 2; dy++) {
+			for (int dx = 0; dx < 2; dx++) {
+				int	xx = x + dx;
+				int	yy = y + dy;
+				if ((xx >= 0) && (xx < w) && (yy >= 0) && (yy < h)) {
+					image.pixel(xx, yy) += I * weights[dy][dx];
+				}
+			}
+		}
+	}
+}
+
+/**
+ * \brief Position of a star in the kernel grid
+ */
+typedef struct placedstar_s {
+	int	x, y;
+	int	sx, sy;
+	int	r;
+	double	intensity;
+} placedstar_t;
+
+/**
+ * \brief Add the kernels of all stars to an image
+ *
+ * Stars outside the image still contribute to it if their kernel
+ * reaches into the image. The stars are first sorted into horizontal
+ * strips, which can then be rendered independently.
+ */
+void	StarRenderer::operator()(Image<double>& image,
+		const std::vector<ChartPoint>& stars) const {
+	if (_dirac) {
+		deposit(image, stars);
+		return;
+	}
+	int	w = image.size().width();
+	int	h = image.size().height();
+	const int	strip = 32;
+	int	nstrips = (h + strip - 1) / strip;
+
+	// find kernel, offset and radius for each star
+	std::vector<placedstar_t>	placed;
+	placed.reserve(stars.size());
+	std::vector<std::vector<size_t> >	strips(nstrips);
+	for (auto s = stars.begin(); s != stars.end(); s++) {
+		if (!std::isfinite(s->x()) || !std::isfinite(s->y())) {
+			continue;
+		}
+		placedstar_t	p;
+		double	fx = floor(s->x());
+		double	fy = floor(s->y());
+		p.sx = lround((s->x() - fx) * _subpixels);
+		p.sy = lround((s->y() - fy) * _subpixels);
+		if (p.sx == _subpixels) {
+			p.sx = 0;
+			fx += 1;
+		}
+		if (p.sy == _subpixels) {
+			p.sy = 0;
+			fy += 1;
+		}
+		p.intensity = s->intensity();
+		p.r = radius(p.intensity);
+		if ((fx + p.r < 0) || (fx - p.r >= w)
+			|| (fy + p.r < 0) || (fy - p.r >= h)) {
+			continue;
+		}
+		p.x = fx;
+		p.y = fy;
+		int	first = std::max(0, p.y - p.r) / strip;
+		int	last = std::min(h - 1, p.y + p.r) / strip;
+		for (int i = first; i <= last; i++) {
+			strips[i].push_back(placed.size());
+		}
+		placed.push_back(p);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "rendering %lu of %lu stars",
+		placed.size(), stars.size());
+
+	// render the strips in parallel
+	int	k = 2 * _radius + 1;
+#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < nstrips; i++) {
+		int	ylo = i * strip;
+		int	yhi = std::min(h, ylo + strip);
+		for (auto j = strips[i].begin(); j != strips[i].end(); j++) {
+			const placedstar_t&	p = placed[*j];
+			const float	*kp = kernel(p.sx, p.sy);
+			int	x0 = std::max(0, p.x - p.r);
+			int	x1 = std::min(w - 1, p.x + p.r);
+			int	y0 = std::max(ylo, p.y - p.r);
+			int	y1 = std::min(yhi - 1, p.y + p.r);
+			int	n = x1 - x0 + 1;
+			double	I = p.intensity;
+			for (int y = y0; y <= y1; y++) {
+				const float	*row = kp + (y - p.y + _radius) * k
+							+ (x0 - p.x + _radius);
+				double	*pixels = image.pixels + y * w + x0;
+#pragma omp simd
+				for (int x = 0; x < n; x++) {
+					pixels[x] += I * row[x];
+				}
+			}
+		}
+	}
+}
+
+} // namespace catalog
+} // namespace astro
@@ -34,14 +34,15 @@ StereographicChart	StereographicChartFactory::chart(const RaDec& center,
 					MagnitudeRange(-30, limit_magnitude()));
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "got %u stars", stars->size());
 
-	// draw all the stars
-	draw(*(chart._image), projection, stars);
+	// find the positions of all the stars
+	std::vector<ChartPoint>	points;
+	draw(points, chart.size(), projection, stars);
 
-	// apply point spread function
-	// XXX for the spread function we need the geometry, but we don't have
-	//     that in this case, so we must compute the geometry from
-	//     from the data we have first
-	//spread(*chart._image, 100, geometry)
+	// apply point spread function, the projection maps the angle
+	// between center and star to half that angle at the center, so
+	// this is the angular size of a pixel at the center of the chart
+	double	angularpixelsize = 4. / diameter;
+	render(*(chart._image), points, angularpixelsize, 100);
 
 	// limit
 	limit(*chart._image, 1.);
@@ -50,7 +51,8 @@ StereographicChart	StereographicChartFactory::chart(const RaDec& center,
 	return chart;
 }
 
-void	StereographicChartFactory::draw(Image<double>& image,
+void	StereographicChartFactory::draw(std::vector<ChartPoint>& points,
+		const ImageSize& size,
 		const StereographicProjection& projection,
 		const Catalog::starsetptr stars) const {
 	Catalog::starset        *starsp
@@ -58,25 +60,28 @@ void	StereographicChartFactory::draw(Image<double>& image,
 	if (starsp == NULL) {
 		throw std::runtime_error("no star set provided");
 	}
-	draw(image, projection, *starsp);
+	draw(points, size, projection, *starsp);
 }
 
 
-void	StereographicChartFactory::draw(Image<double>& image,
+void	StereographicChartFactory::draw(std::vector<ChartPoint>& points,
+		const ImageSize& size,
 		const StereographicProjection& projection,
 		const Catalog::starset& stars) const {
+	points.reserve(points.size() + stars.size());
 	Catalog::starset::const_iterator	s;
 	for (s = stars.begin(); s != stars.end(); s++) {
-		draw(image, projection, *s);
+		draw(points, size, projection, *s);
 	}
 }
 
-void	StereographicChartFactory::draw(Image<double>& image,
-	const StereographicProjection& projection, const Star& star) const {
+void	StereographicChartFactory::draw(std::vector<ChartPoint>& points,
+	const ImageSize& size, const StereographicProjection& projection,
+	const Star& star) const {
 	// where
-	double	m = image.size().width() / 2;
-	Point	p = projection(star) * m + image.size().center();
-	ChartFactoryBase::draw(image, p, star);
+	double	m = size.width() / 2;
+	Point	p = projection(star) * m + size.center();
+	points.push_back(ChartPoint(p, intensity(star)));
 }
 
 } // namespace catalog
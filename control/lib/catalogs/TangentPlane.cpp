@@ -0,0 +1,53 @@
+/*
+ * TangentPlane.cpp -- gnomonic projection used by the plate solver
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroSolver.h>
+#include <cmath>
+
+namespace astro {
+namespace catalog {
+
+TangentPlane::TangentPlane(const RaDec& center) : _center(center) {
+	_sindec = sin(_center.dec().radians());
+	_cosdec = cos(_center.dec().radians());
+}
+
+/**
+ * \brief Project a point of the sky onto the tangent plane
+ *
+ * The projection is only meaningful for points on the same hemisphere
+ * as the center.
+ */
+Point	TangentPlane::project(const RaDec& position) const {
+	double	dra = position.ra().radians() - _center.ra().radians();
+	double	sindec = sin(position.dec().radians());
+	double	cosdec = cos(position.dec().radians());
+	double	cosdra = cos(dra);
+	double	d = sindec * _sindec + cosdec * _cosdec * cosdra;
+	return Point(cosdec * sin(dra) / d,
+		(sindec * _cosdec - cosdec * _sindec * cosdra) / d);
+}
+
+/**
+ * \brief Find the point of the sky belonging to a point of the plane
+ */
+RaDec	TangentPlane::inverse(const Point& point) const {
+	double	xi = point.x();
+	double	eta = point.y();
+	double	denominator = _cosdec - eta * _sindec;
+	double	ra = _center.ra().radians() + atan2(xi, denominator);
+	double	dec = atan2(eta * _cosdec + _sindec,
+			hypot(xi, denominator));
+	if (ra < 0) {
+		ra += 2 * M_PI;
+	}
+	if (ra >= 2 * M_PI) {
+		ra -= 2 * M_PI;
+	}
+	return RaDec(Angle(ra), Angle(dec));
+}
+
+} // namespace catalog
+} // namespace astro
@@ -85,6 +85,13 @@ static LightWeightStar	UCAC4_to_LightWeightStar(const UCAC4_STAR *star) {
 		star->mag1 * 0.001);
 }
 
+/**
+ * \brief Magnitude of a record, to filter before constructing a star
+ */
+static float	UCAC4_mag(const unsigned char *record) {
+	return ((const UCAC4_STAR *)record)->mag1 * 0.001;
+}
+
 /* Note: sizeof( UCAC4_STAR) = 78 bytes */
 
 Ucac4Zone::Ucac4Zone(uint16_t zone, const std::string& zonefilename)
@@ -118,30 +125,25 @@ LightWeightStar	Ucac4Zone::getLightWeight(uint32_t number) const {
  * \brief Get the first star number exceeding the ra
  */
 uint32_t	Ucac4Zone::first(const Angle& ra) const {
-	// get the last star an make sure the 
-	Ucac4Star	laststar = get(nstars() - 1);
-	if (laststar.ra() < ra) {
+	// compare the RA field of the records in place, constructing a
+	// Ucac4Star for each probe would copy the record and allocate names
+	const UCAC4_STAR	*stars = (const UCAC4_STAR *)record(0);
+	double	target = ra.radians();
+
+	// no star qualifies if even the last star is below the ra
+	if (MARCSEC_to_RADIANS * stars[nstars() - 1].ra < target) {
 		return nstars();
 	}
 
-	// search in the interval
+	// search in the interval, star numbers start at 1
 	uint32_t	l1 = 1, l2 = nstars();
-	Angle	ra1 = get(l1).ra();
-	Angle	ra2 = get(l2).ra();
 	while ((l2 - l1) > 1) {
 		uint32_t	l = (l1 + l2) / 2;
-		//debug(LOG_DEBUG, DEBUG_LOG, 0, "new subdivision: %lu", l);
-		Angle	ra0 = get(l).ra();
-		if (ra0 < ra) {
+		if (MARCSEC_to_RADIANS * stars[l - 1].ra < target) {
 			l1 = l;
-			ra1 = ra0;
-		}
-		if (ra <= ra0) {
+		} else {
 			l2 = l;
-			ra2 = ra0;
 		}
-		//debug(LOG_DEBUG, DEBUG_LOG, 0, "%u,%u = %f < %f <= %f",
-		//	l1, l2, ra1.hours(), ra.hours(), ra2.hours());
 	}
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "first: %lu", l2);
 	return l2;
@@ -165,26 +167,20 @@ Ucac4Zone::starsetptr	Ucac4Zone::add(Ucac4Zone::starsetptr set,
 	uint32_t	maxindex = first(window.rightra());
 	if (minindex < maxindex) {
 		for (uint32_t number = minindex; number < maxindex; number++) {
-			Ucac4Star	star = get(number);
-			if (magrange.contains(star.mag())) {
-				//debug(LOG_DEBUG, DEBUG_LOG, 0, "adding %s", star.toString().c_str());
-				set->insert(star);
+			if (magrange.contains(UCAC4_mag(record(number - 1)))) {
+				set->insert(get(number));
 			}
 		}
 	}
 	if (maxindex < minindex) {
 		for (uint32_t number = 1; number < maxindex; number++) {
-			Ucac4Star	star = get(number);
-			if (magrange.contains(star.mag())) {
-				//debug(LOG_DEBUG, DEBUG_LOG, 0, "adding %s", star.toString().c_str());
-				set->insert(star);
+			if (magrange.contains(UCAC4_mag(record(number - 1)))) {
+				set->insert(get(number));
 			}
 		}
 		for (uint32_t number = minindex; number < nstars(); number++) {
-			Ucac4Star	star = get(number);
-			if (magrange.contains(star.mag())) {
-				//debug(LOG_DEBUG, DEBUG_LOG, 0, "adding %s", star.toString().c_str());
-				set->insert(star);
+			if (magrange.contains(UCAC4_mag(record(number - 1)))) {
+				set->insert(get(number));
 			}
 		}
 	}
@@ -0,0 +1,180 @@
+/*
+ * CompactCatalogTest.cpp -- write a compact catalog and query it
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include "../CompactCatalog.h"
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cmath>
+#include <random>
+#include <unistd.h>
+
+using namespace astro::catalog;
+
+namespace astro {
+namespace test {
+
+class CompactCatalogTest : public CppUnit::TestFixture {
+	static std::string	filename;
+	static std::vector<Star>	stars;
+public:
+	void	setUp();
+	void	tearDown() { }
+	void	testNames();
+	void	testStars();
+	void	testTile();
+	void	testFind();
+
+	CPPUNIT_TEST_SUITE(CompactCatalogTest);
+	CPPUNIT_TEST(testNames);
+	CPPUNIT_TEST(testStars);
+	CPPUNIT_TEST(testTile);
+	CPPUNIT_TEST(testFind);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	void	compare(CompactCatalog& catalog, const SkyWindow& window,
+			const MagnitudeRange& magrange);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CompactCatalogTest);
+
+std::string	CompactCatalogTest::filename;
+std::vector<Star>	CompactCatalogTest::stars;
+
+/**
+ * \brief Write a catalog of random stars on the whole sky only once
+ */
+void	CompactCatalogTest::setUp() {
+	if (filename.size()) {
+		return;
+	}
+	std::mt19937	generator(2026);
+	std::uniform_real_distribution<double>	uniform(0, 1);
+	std::uniform_real_distribution<double>	mag(-1, 14);
+	filename = stringprintf("/tmp/compactcatalogtest-%d.cat", getpid());
+	CompactCatalogCreator	creator(filename, 36);
+	for (int i = 0; i < 20000; i++) {
+		Star	star(stringprintf("HIP%06d", i + 1));
+		star.ra().radians(2 * M_PI * uniform(generator));
+		star.dec().radians(asin(2 * uniform(generator) - 1));
+		star.mag(mag(generator));
+		star.catalog('H');
+		star.catalognumber(i + 1);
+		creator.add(star);
+		stars.push_back(star);
+	}
+	creator.write();
+}
+
+void	CompactCatalogTest::testNames() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testNames() begin");
+	const char	*names[] = { "BSC0042", "HIP012345", "SAO123456",
+		"T1234 00567 1", "UCAC4-123-004567" };
+	for (int i = 0; i < 5; i++) {
+		char	catalog;
+		uint64_t	number;
+		CompactCatalog::parsename(names[i], catalog, number);
+		CPPUNIT_ASSERT(CompactCatalog::starname(catalog, number)
+			== names[i]);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testNames() end");
+}
+
+/**
+ * \brief Every star written must be found with its attributes
+ */
+void	CompactCatalogTest::testStars() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testStars() begin");
+	CompactCatalog	catalog(filename);
+	CPPUNIT_ASSERT(catalog.numberOfStars() == stars.size());
+	unsigned long	counter = 0;
+	for (CatalogIterator i = catalog.begin(); i != catalog.end(); ++i) {
+		Star	star = *i;
+		const Star&	original = stars[star.catalognumber() - 1];
+		CPPUNIT_ASSERT(star.name() == original.name());
+		CPPUNIT_ASSERT(fabs(star.ra().radians()
+			- original.ra().radians()) < 1e-8);
+		CPPUNIT_ASSERT(fabs(star.dec().radians()
+			- original.dec().radians()) < 1e-8);
+		CPPUNIT_ASSERT(fabs(star.mag() - original.mag()) <= 0.0005);
+		counter++;
+	}
+	CPPUNIT_ASSERT(counter == stars.size());
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testStars() end");
+}
+
+/**
+ * \brief A tile must contain the same stars as a linear search
+ */
+void	CompactCatalogTest::compare(CompactCatalog& catalog,
+		const SkyWindow& window, const MagnitudeRange& magrange) {
+	StarTilePtr	tile = catalog.findTile(window, magrange);
+	size_t	count = 0;
+	for (uint64_t i = 0; i < catalog.nstars(); i++) {
+		LightWeightStar	star = catalog.lightweight(i);
+		if (window.contains(star) && magrange.contains(star.mag())) {
+			count++;
+		}
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: %lu stars, expected %lu",
+		window.toString().c_str(), tile->size(), count);
+	CPPUNIT_ASSERT(tile->size() == count);
+	for (auto s = tile->begin(); s != tile->end(); s++) {
+		CPPUNIT_ASSERT(window.contains(*s));
+		CPPUNIT_ASSERT(magrange.contains(s->mag()));
+	}
+}
+
+void	CompactCatalogTest::testTile() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testTile() begin");
+	CompactCatalog	catalog(filename);
+	MagnitudeRange	all(-30, 30);
+	MagnitudeRange	bright(0.5, 6.5);
+	// an ordinary window
+	SkyWindow	window(RaDec(Angle(80, Angle::Degrees),
+		Angle(30, Angle::Degrees)), Angle(20, Angle::Degrees),
+		Angle(15, Angle::Degrees));
+	compare(catalog, window, all);
+	compare(catalog, window, bright);
+	// a window containing 0h
+	SkyWindow	wrap(RaDec(Angle(2, Angle::Degrees),
+		Angle(-20, Angle::Degrees)), Angle(30, Angle::Degrees),
+		Angle(20, Angle::Degrees));
+	compare(catalog, wrap, bright);
+	// a window containing the pole and almost all right ascensions
+	SkyWindow	polar(RaDec(Angle(180, Angle::Degrees),
+		Angle(80, Angle::Degrees)), Angle(355, Angle::Degrees),
+		Angle(30, Angle::Degrees));
+	compare(catalog, polar, bright);
+	// the complete sky
+	compare(catalog, SkyWindow::all, all);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testTile() end");
+}
+
+void	CompactCatalogTest::testFind() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testFind() begin");
+	CompactCatalog	catalog(filename);
+	Star	star = catalog.find(stars[4711].name());
+	CPPUNIT_ASSERT(star.catalognumber() == 4712);
+	SkyWindow	window(star, Angle(2, Angle::Degrees),
+		Angle(2, Angle::Degrees));
+	Catalog::starsetptr	result = catalog.find(window,
+		MagnitudeRange(-30, 30));
+	CPPUNIT_ASSERT(result->find(star) != result->end());
+	bool	thrown = false;
+	try {
+		catalog.find(std::string("HIP999999"));
+	} catch (const std::runtime_error& x) {
+		thrown = true;
+	}
+	CPPUNIT_ASSERT(thrown);
+	unlink(filename.c_str());
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testFind() end");
+}
+
+} // namespace test
+} // namespace astro
@@ -0,0 +1,218 @@
+/*
+ * PlateSolverTest.cpp -- build a quad index and solve synthetic fields
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroSolver.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <unistd.h>
+
+using namespace astro::catalog;
+
+namespace astro {
+namespace test {
+
+/**
+ * \brief A catalog of random stars around RA 80 degrees, DEC 30 degrees
+ */
+class RandomCatalog : public Catalog {
+	starset	_stars;
+public:
+	RandomCatalog() {
+		std::mt19937	generator(2026);
+		std::uniform_real_distribution<double>	ra(75, 85);
+		std::uniform_real_distribution<double>	dec(25, 35);
+		std::uniform_real_distribution<double>	mag(4, 12);
+		for (int i = 0; i < 8000; i++) {
+			Star	star(stringprintf("R%d", i));
+			star.ra() = Angle(ra(generator), Angle::Degrees);
+			star.dec() = Angle(dec(generator), Angle::Degrees);
+			star.mag(mag(generator));
+			_stars.insert(star);
+		}
+	}
+	const starset&	stars() const { return _stars; }
+	virtual Star	find(const std::string& name) {
+		throw std::runtime_error("no star " + name);
+	}
+	virtual starsetptr	find(const SkyWindow& window,
+					const MagnitudeRange& magrange) {
+		starsetptr	result(new starset());
+		for (auto s = _stars.begin(); s != _stars.end(); s++) {
+			if (window.contains(*s) && magrange.contains(s->mag())) {
+				result->insert(*s);
+			}
+		}
+		return result;
+	}
+	virtual unsigned long	numberOfStars() { return _stars.size(); }
+};
+
+class PlateSolverTest : public CppUnit::TestFixture {
+	static std::string	indexfile;
+	static std::shared_ptr<RandomCatalog>	catalog;
+public:
+	void	setUp();
+	void	tearDown() { }
+	void	testIndex();
+	void	testSolve();
+	void	testMirrored();
+
+	CPPUNIT_TEST_SUITE(PlateSolverTest);
+	CPPUNIT_TEST(testIndex);
+	CPPUNIT_TEST(testSolve);
+	CPPUNIT_TEST(testMirrored);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	void	solve(bool mirrored);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PlateSolverTest);
+
+std::string	PlateSolverTest::indexfile;
+std::shared_ptr<RandomCatalog>	PlateSolverTest::catalog;
+
+/**
+ * \brief Build the index only once for all tests
+ */
+void	PlateSolverTest::setUp() {
+	if (indexfile.size()) {
+		return;
+	}
+	catalog = std::shared_ptr<RandomCatalog>(new RandomCatalog());
+	indexfile = stringprintf("/tmp/platesolvertest-%d.idx", getpid());
+	QuadIndexBuilder	builder(catalog);
+	builder.window(SkyWindow(RaDec(Angle(80, Angle::Degrees),
+		Angle(30, Angle::Degrees)), Angle(8, Angle::Degrees),
+		Angle(8, Angle::Degrees)));
+	builder.scales(Angle(0.5, Angle::Degrees), Angle(1, Angle::Degrees));
+	builder.build(indexfile);
+}
+
+void	PlateSolverTest::testIndex() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testIndex() begin");
+	QuadIndex	index(indexfile);
+	CPPUNIT_ASSERT(index.nlevels() == 3);
+	for (unsigned int level = 0; level < index.nlevels(); level++) {
+		CPPUNIT_ASSERT(index.nquads(level) > 100);
+	}
+
+	// stars in a circle must agree with a linear search
+	RaDec	center(Angle(80.5, Angle::Degrees), Angle(29.5, Angle::Degrees));
+	Angle	radius(1, Angle::Degrees);
+	std::vector<size_t>	inside = index.stars(center, radius);
+	size_t	count = 0;
+	for (size_t i = 0; i < index.nstars(); i++) {
+		RaDec	s = index.star(i);
+		double	c = sin(s.dec().radians()) * sin(center.dec().radians())
+			+ cos(s.dec().radians()) * cos(center.dec().radians())
+			* cos(s.ra().radians() - center.ra().radians());
+		if (c >= cos(radius.radians())) {
+			count++;
+		}
+	}
+	CPPUNIT_ASSERT(inside.size() == count);
+	CPPUNIT_ASSERT(count > 10);
+
+	// a quad computed from index stars finds itself
+	const QuadIndexEntry&	first = index.quad(1, 0);
+	TangentPlane	cell(index.star(first.stars[0]));
+	Point	p[4];
+	for (int i = 0; i < 4; i++) {
+		p[i] = cell.project(index.star(first.stars[i]));
+	}
+	std::vector<QuadIndexEntry>	found = index.lookup(1, QuadCode(p), 0.005);
+	bool	self = false;
+	for (auto q = found.begin(); q != found.end(); q++) {
+		self = self || std::equal(q->stars, q->stars + 4, first.stars);
+	}
+	CPPUNIT_ASSERT(self);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testIndex() end");
+}
+
+/**
+ * \brief Simulate an image and check the solution
+ */
+void	PlateSolverTest::solve(bool mirrored) {
+	// a 1000x800 image with 3"/pixel, rotated by 25 degrees
+	RaDec	center(Angle(80.3, Angle::Degrees), Angle(30.2, Angle::Degrees));
+	double	s = 3. / 3600;
+	double	rho = 25 * M_PI / 180;
+	double	flip = (mirrored) ? -1 : 1;
+	astro::image::ImageSize	size(1000, 800);
+	Point	reference(499.5, 399.5);
+	TangentPlane	plane(center);
+	auto	topixel = [&](const RaDec& r) {
+		Point	p = plane.project(r) * (180 / M_PI) * (1 / s);
+		double	x = -cos(rho) * p.x() + sin(rho) * p.y();
+		double	y = sin(rho) * p.x() + cos(rho) * p.y();
+		return reference + Point(flip * x, y);
+	};
+
+	// collect the brightest stars in the field
+	std::vector<Star>	field;
+	for (auto r = catalog->stars().begin(); r != catalog->stars().end();
+		r++) {
+		Point	p = topixel(*r);
+		if ((p.x() >= 0) && (p.x() < 1000) && (p.y() >= 0)
+			&& (p.y() < 800)) {
+			field.push_back(*r);
+		}
+	}
+	std::sort(field.begin(), field.end(),
+		[](const Star& a, const Star& b) { return a.mag() < b.mag(); });
+	std::mt19937	generator(17);
+	std::normal_distribution<double>	noise(0, 0.3);
+	std::uniform_real_distribution<double>	x(0, 1000);
+	std::uniform_real_distribution<double>	y(0, 800);
+	std::vector<Point>	stars;
+	for (size_t i = 0; (i < field.size()) && (stars.size() < 40); i++) {
+		// some stars are lost, some spurious stars appear
+		if (6 == (i % 7)) {
+			stars.push_back(Point(x(generator), y(generator)));
+			continue;
+		}
+		stars.push_back(topixel(field[i])
+			+ Point(noise(generator), noise(generator)));
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%lu stars in field, %lu used",
+		field.size(), stars.size());
+
+	QuadIndex	index(indexfile);
+	PlateSolver	solver(index);
+	PlateSolution	solution = solver(stars, size);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "solution: %s",
+		solution.toString().c_str());
+	CPPUNIT_ASSERT(solution.mirrored() == mirrored);
+	CPPUNIT_ASSERT(fabs(solution.scale() - 3) < 0.01);
+	for (size_t i = 0; i < field.size(); i++) {
+		CPPUNIT_ASSERT(distance(solution.pixel(field[i]),
+			topixel(field[i])) < 0.5);
+	}
+	RaDec	c = solution.radec(reference);
+	CPPUNIT_ASSERT(fabs(c.dec().degrees() - 30.2) * 3600 < 1);
+	CPPUNIT_ASSERT(fabs(c.ra().degrees() - 80.3) * 3600 < 1.5);
+}
+
+void	PlateSolverTest::testSolve() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testSolve() begin");
+	solve(false);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testSolve() end");
+}
+
+void	PlateSolverTest::testMirrored() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testMirrored() begin");
+	solve(true);
+	unlink(indexfile.c_str());
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testMirrored() end");
+}
+
+} // namespace test
+} // namespace astro
@@ -0,0 +1,190 @@
+/*
+ * StarRendererTest.cpp -- compare star rendering with FFT convolution
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroChart.h>
+#include <AstroDebug.h>
+#include <AstroUtils.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cmath>
+#include <random>
+
+using namespace astro::catalog;
+using namespace astro::image;
+
+namespace astro {
+namespace test {
+
+/**
+ * \brief Chart factory base that gives access to the rendering methods
+ */
+class RenderingFactory : public ChartFactoryBase {
+public:
+	RenderingFactory(const PointSpreadFunction& psf)
+		: ChartFactoryBase(CatalogPtr(), psf) { }
+	using ChartFactoryBase::render;
+};
+
+class StarRendererTest : public CppUnit::TestFixture {
+public:
+	void	setUp() { }
+	void	tearDown() { }
+	void	testProfile();
+	void	testRender();
+	void	testBenchmark();
+
+	CPPUNIT_TEST_SUITE(StarRendererTest);
+	CPPUNIT_TEST(testProfile);
+	CPPUNIT_TEST(testRender);
+	CPPUNIT_TEST(testBenchmark);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	std::vector<ChartPoint>	randomstars(const ImageSize& size,
+					int n) const;
+	double	difference(const Image<double>& a,
+			const Image<double>& b) const;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(StarRendererTest);
+
+#define	PIXELSIZE	(M_PI / (180 * 60 * 60))
+
+/**
+ * \brief Stars with random positions and brightness
+ *
+ * The intensities are chosen such that the peak of the turbulence point
+ * spread function with 2 pixels width is at most about 1. The stars are
+ * placed on pixel centers, because the Fourier transform method
+ * distributes a star between the four nearest pixels before the
+ * convolution, while the kernels are computed for subpixel offsets.
+ */
+std::vector<ChartPoint>	StarRendererTest::randomstars(const ImageSize& size,
+		int n) const {
+	std::mt19937	generator(2026);
+	std::uniform_real_distribution<double>	x(0, size.width());
+	std::uniform_real_distribution<double>	y(0, size.height());
+	std::uniform_real_distribution<double>	mag(0, 6);
+	std::vector<ChartPoint>	stars;
+	double	norm = 2 * sqrt(2 * M_PI) * PIXELSIZE;
+	for (int i = 0; i < n; i++) {
+		stars.push_back(ChartPoint(Point(floor(x(generator)),
+			floor(y(generator))),
+			norm * pow(10., -mag(generator) / 2.5)));
+	}
+	return stars;
+}
+
+double	StarRendererTest::difference(const Image<double>& a,
+		const Image<double>& b) const {
+	double	result = 0;
+	size_t	n = a.size().getPixels();
+	for (size_t i = 0; i < n; i++) {
+		result = std::max(result, fabs(a.pixels[i] - b.pixels[i]));
+	}
+	return result;
+}
+
+/**
+ * \brief A single star must look like the point spread function
+ */
+void	StarRendererTest::testProfile() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testProfile() begin");
+	TurbulencePointSpreadFunction	psf(2 * PIXELSIZE);
+	StarRenderer	renderer(psf, PIXELSIZE, 50, 4, 1e-6);
+	double	peak = psf(0);
+	// half pixel offsets are represented exactly by 4 subpixels
+	double	offsets[3] = { 0., 0.25, 0.5 };
+	for (int i = 0; i < 3; i++) {
+		Image<double>	image(ImageSize(64, 64));
+		image.fill(0);
+		Point	p(32 + offsets[i], 30 + offsets[2 - i]);
+		std::vector<ChartPoint>	stars;
+		stars.push_back(ChartPoint(p, 1 / peak));
+		renderer(image, stars);
+		double	error = 0;
+		for (int x = 0; x < 64; x++) {
+			for (int y = 0; y < 64; y++) {
+				double	r = hypot(x - p.x(), y - p.y()) * PIXELSIZE;
+				error = std::max(error,
+					fabs(image.pixel(x, y) - psf(r) / peak));
+			}
+		}
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "offset %.2f: error %g",
+			offsets[i], error);
+		CPPUNIT_ASSERT(error < 1e-3);
+	}
+	// a Dirac point spread function only distributes the intensity
+	DiracPointSpreadFunction	dirac;
+	StarRenderer	diracrenderer(dirac, PIXELSIZE);
+	Image<double>	image(ImageSize(8, 8));
+	image.fill(0);
+	std::vector<ChartPoint>	stars;
+	stars.push_back(ChartPoint(Point(3.25, 4.5), 1));
+	diracrenderer(image, stars);
+	CPPUNIT_ASSERT(fabs(image.pixel(3, 4) - 0.375) < 1e-12);
+	CPPUNIT_ASSERT(fabs(image.pixel(4, 5) - 0.125) < 1e-12);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testProfile() end");
+}
+
+/**
+ * \brief Kernel rendering must agree with the Fourier transform method
+ */
+void	StarRendererTest::testRender() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRender() begin");
+	TurbulencePointSpreadFunction	psf(2 * PIXELSIZE);
+	RenderingFactory	factory(psf);
+	ImageSize	size(320, 240);
+	std::vector<ChartPoint>	stars = randomstars(size, 200);
+
+	Image<double>	kernelimage(size);
+	kernelimage.fill(0);
+	factory.render(kernelimage, stars, PIXELSIZE, 20);
+
+	Image<double>	fftimage(size);
+	fftimage.fill(0);
+	factory.fft(true);
+	factory.render(fftimage, stars, PIXELSIZE, 20);
+
+	double	error = difference(kernelimage, fftimage);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "maximum difference: %g", error);
+	CPPUNIT_ASSERT(error < 1e-3);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRender() end");
+}
+
+/**
+ * \brief Compare the time needed by the two methods
+ */
+void	StarRendererTest::testBenchmark() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBenchmark() begin");
+	TurbulencePointSpreadFunction	psf(2 * PIXELSIZE);
+	RenderingFactory	factory(psf);
+	ImageSize	size(2048, 1536);
+	std::vector<ChartPoint>	stars = randomstars(size, 2000);
+
+	Image<double>	kernelimage(size);
+	kernelimage.fill(0);
+	Timer	timer;
+	timer.start();
+	factory.render(kernelimage, stars, PIXELSIZE, 100);
+	timer.end();
+	double	kerneltime = timer.elapsed();
+
+	Image<double>	fftimage(size);
+	fftimage.fill(0);
+	factory.fft(true);
+	timer.start();
+	factory.render(fftimage, stars, PIXELSIZE, 100);
+	timer.end();
+	double	ffttime = timer.elapsed();
+
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "kernels: %.3fs, FFT: %.3fs, "
+		"speedup %.1f", kerneltime, ffttime, ffttime / kerneltime);
+	CPPUNIT_ASSERT(difference(kernelimage, fftimage) < 1e-3);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBenchmark() end");
+}
+
+} // namespace test
+} // namespace astro
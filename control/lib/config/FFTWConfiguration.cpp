@@ -0,0 +1,66 @@
+/*
+ * FFTWConfiguration.cpp -- apply the FFTW settings from the configuration
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroConfig.h>
+#include <AstroConvolve.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <includes.h>
+
+namespace astro {
+namespace config {
+
+static ConfigurationKey	_fftw_measure_key(
+	"global", "fftw", "measure");
+static ConfigurationRegister	_fftw_measure_registration(
+	_fftw_measure_key,
+	"plan fourier transforms with FFTW_MEASURE instead of FFTW_ESTIMATE "
+	"(yes/no)");
+
+static ConfigurationKey	_fftw_threads_key(
+	"global", "fftw", "threads");
+static ConfigurationRegister	_fftw_threads_registration(
+	_fftw_threads_key,
+	"number of threads to use for a fourier transform");
+
+static ConfigurationKey	_fftw_wisdom_key(
+	"global", "fftw", "wisdom");
+static ConfigurationRegister	_fftw_wisdom_registration(
+	_fftw_wisdom_key,
+	"file to load FFTW wisdom from and save it to, default is "
+	"fftw.wisdom in the configuration directory");
+
+/**
+ * \brief Apply the FFTW settings of the default configuration
+ */
+void	FFTWConfiguration::apply() {
+	try {
+		apply(Configuration::get());
+	} catch (const std::exception& x) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "no FFTW configuration: %s",
+			x.what());
+	}
+}
+
+/**
+ * \brief Apply the FFTW settings of a configuration
+ */
+void	FFTWConfiguration::apply(ConfigurationPtr config) {
+	std::string	measure = config->get(_fftw_measure_key, "no");
+	image::FFTWPlans::measure((measure == "yes") || (measure == "true")
+		|| (measure == "1"));
+	std::string	threads = config->get(_fftw_threads_key, "1");
+	try {
+		image::FFTWPlans::threads(std::stoi(threads));
+	} catch (const std::exception& x) {
+		debug(LOG_ERR, DEBUG_LOG, 0, "invalid FFTW thread count '%s'",
+			threads.c_str());
+	}
+	image::FFTWPlans::wisdom(config->get(_fftw_wisdom_key,
+		Configuration::configDir() + "fftw.wisdom"));
+}
+
+} // namespace config
+} // namespace astro
@@ -28,6 +28,7 @@ ImageRepo::ImageRepo(const std::string& name, Database database,
 	try {
 		ImageTable	images(_database);
 		MetadataTable	metadatatable(_database);
+		images.createindexes();
 	} catch (std::exception& x) {
 		std::string	msg = stringprintf("cannot open image "
 			"repository tables: %s", x.what());
@@ -35,9 +36,9 @@ ImageRepo::ImageRepo(const std::string& name, Database database,
 		throw std::runtime_error(msg);
 	}
 
-	// scan the directory for 
+	// scan the directory for images not yet in the database
 	if (scan) {
-		scan_directory();
+		this->scan(false);
 	}
 }
 
@@ -49,186 +50,6 @@ long	ImageRepo::id(const std::string& filename) {
 	return images.id(filename);
 }
 
-/**
- * \brief process a single file during a scan
- */
-void	ImageRepo::scan_file(const std::string& filename) {
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "scanning file '%s' (%d)",
-		filename.c_str(), filename.length());
-	// does the filename end in ".fits"?
-	if (filename.size() < 5) {
-		return;
-	}
-	std::string	extension = filename.substr(filename.length() - 5, 5);
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "substr: '%s'", extension.c_str());
-	if (extension != ".fits") {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s not a FITS file",
-			filename.c_str());
-		return;
-	}
-
-	// check whether this is a file
-	std::string	fullname = _directory + "/" + filename;
-	struct stat	sb;
-	if (stat(fullname.c_str(), &sb) < 0) {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "cannot stat file %s: %s",
-			fullname.c_str(), strerror(errno));
-		return;
-	}
-
-	if (!S_ISREG(sb.st_mode)) {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: not a regular file",
-			fullname.c_str());
-		return;
-	}
-
-	// find out whether the database already contains this filename
-	ImageTable	images(_database);
-	try {
-		long	id = images.id(filename);
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s exists with id %ld", 
-			filename.c_str(), id);
-		// if we get to this point, the file already exists, so we
-		// skip it
-		return;
-	} catch (...) {
-		// file does not exist
-	}
-
-	// read the metadata
-        io::FITSinfileBase      infile(fullname);
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "size: %s",
-		infile.getSize().toString().c_str());
-
-	// create an information record
-	ImageRecord	imageinfo;
-	imageinfo.filename = filename;
-	imageinfo.project = "unknown";
-	imageinfo.created = sb.st_ctime;
-	try {
-		imageinfo.camera
-			= (std::string)infile.getMetadata("INSTRUME");
-	} catch (...) { }
-	imageinfo.width = infile.getSize().width();
-	imageinfo.height = infile.getSize().height();
-	imageinfo.xbin = 1;
-	try {
-		imageinfo.xbin
-			= (int)infile.getMetadata("XBINNING");
-	} catch (...) { }
-	imageinfo.ybin = 1;
-	try {
-		imageinfo.ybin
-			= (int)infile.getMetadata("YBINNING");
-	} catch (...) { }
-	imageinfo.depth = infile.getPlanes();
-	imageinfo.pixeltype = infile.getPixeltype();
-	imageinfo.exposuretime = 0;
-	try {
-		imageinfo.exposuretime
-			= (double)infile.getMetadata("EXPTIME");
-	} catch (...) { }
-	imageinfo.gain = -1;
-	try {
-		imageinfo.gain
-			= (double)infile.getMetadata("GAIN");
-	} catch (...) { }
-	imageinfo.temperature = 0;
-	try {
-		imageinfo.temperature
-			= (double)infile.getMetadata("CCD-TEMP");
-	} catch (...) { }
-	imageinfo.purpose = "light";
-	try {
-		imageinfo.purpose = (std::string)infile.getMetadata("PURPOSE");
-	} catch (...) { }
-	imageinfo.quality = "high";
-	try {
-		imageinfo.purpose = (std::string)infile.getMetadata("QUALITY");
-	} catch (...) { }
-	imageinfo.bayer = "    ";
-	try {
-		imageinfo.bayer
-			= trim((std::string)infile.getMetadata("BAYER"));
-	} catch (...) { }
-	imageinfo.focus = 0;
-	try {
-		imageinfo.focus
-			= (int)infile.getMetadata("FOCUSPOS");
-	} catch (...) { }
-	imageinfo.observation = "1970-01-01T00:00:00.000";
-	imageinfo.uuid = ""; try {
-		imageinfo.uuid = (std::string)(infile.getMetadata("UUID"));
-	} catch (...) { }
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "adding image %s, uuid=%s",
-		imageinfo.filename.c_str(), imageinfo.uuid.c_str());
-
-	// add the entry to the table
-	long	imageid = images.add(imageinfo);
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "image %s, uuid=%s gets id %ld",
-		imageinfo.filename.c_str(), imageinfo.uuid.c_str(), imageid);
-
-	// in the part below we need the metatdata table
-	MetadataTable	metadatatable(_database);
-
-	// get all the metadata from the infile
-	int	seqno = 0;
-	ImageMetadata	md = infile.getAllMetadata();
-
-	// now add an entry for each meta data record
-	ImageMetadata::const_iterator	mi;
-	for (mi = md.begin(); mi != md.end(); mi++) {
-		MetadataRecord	m(-1, imageid);
-		m.seqno = seqno;
-		m.key = mi->first;
-		m.value = mi->second.getValue();
-		m.comment = mi->second.getComment();
-		metadatatable.add(m);
-		seqno++;
-	}
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "%d metadata records added", seqno);
-}
-
-/**
- * \brief Scan a directory for images
- */
-void	ImageRepo::scan_directory(bool recurse) {
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "scan directory %s", _directory.c_str());
-
-	if (recurse) {
-		debug(LOG_DEBUG, DEBUG_LOG, 0,
-			"recursive scan not implemented");
-		throw std::runtime_error("not implemented");
-	}
-
-	// set up a counter so we can count the number of files we find
-	int	counter = 0;
-
-	// open the directory
-	DIR     *dir = opendir(_directory.c_str());
-	if (NULL == dir) {
-		std::string	msg = stringprintf("cannot open image repo "
-			"dir %s: %s", _directory.c_str(), strerror(errno));
-		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
-		throw std::runtime_error(msg);
-	}
-	struct dirent	*d;
-	do {
-		d = readdir(dir);
-		if (NULL == d)
-			continue;
-		std::string     filename(d->d_name);
-		scan_file(filename);
-		counter++;
-	} while (NULL != d);
-
-	// close the directory
-	closedir(dir);
-
-	// report the number of files scanned
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "%d files scanned", counter);
-}
-
 /**
  * \brief Retrieve an image
  */
@@ -293,28 +114,16 @@ ImagePtr	ImageRepo::getImage(const UUID& uuid) {
 	return getImage(getId(uuid));
 }
 
-static ImageEnvelope	convert(const ImageRecord& imageinfo,
-				MetadataTable& metadatatable) {
+/**
+ * \brief Build an envelope from an image record, without metadata
+ */
+static ImageEnvelope	convert(const ImageRecord& imageinfo) {
 	ImageEnvelope	result(imageinfo.id());
 
 	// image geometry
 	result.size(ImageSize(imageinfo.width, imageinfo.height));
 	result.binning(Binning(imageinfo.xbin, imageinfo.ybin));
 
-	// retrieve all the metadata available
-	std::string	condition = stringprintf("imageid = %ld",
-					imageinfo.id());
-	std::list<MetadataRecord>	mdrecords
-		= metadatatable.select(condition);
-
-	// convert the MetadataRecords into actual metadata
-	std::list<MetadataRecord>::const_iterator	mi;
-	for (mi = mdrecords.begin(); mi != mdrecords.end(); mi++) {
-		Metavalue	m = FITSKeywords::meta(mi->key, mi->value,
-					mi->comment);
-		result.metadata.setMetadata(m);
-	}
-
 	// envelope variables
 	result.filename(imageinfo.filename);
 	result.project(imageinfo.project);
@@ -334,6 +143,29 @@ static ImageEnvelope	convert(const ImageRecord& imageinfo,
 	return result;
 }
 
+/**
+ * \brief Build an envelope including the metadata of the image
+ */
+static ImageEnvelope	convert(const ImageRecord& imageinfo,
+				MetadataTable& metadatatable) {
+	ImageEnvelope	result = convert(imageinfo);
+
+	// retrieve all the metadata available
+	std::string	condition = stringprintf("imageid = %ld",
+					imageinfo.id());
+	std::list<MetadataRecord>	mdrecords
+		= metadatatable.select(condition);
+
+	// convert the MetadataRecords into actual metadata
+	std::list<MetadataRecord>::const_iterator	mi;
+	for (mi = mdrecords.begin(); mi != mdrecords.end(); mi++) {
+		Metavalue	m = FITSKeywords::meta(mi->key, mi->value,
+					mi->comment);
+		result.metadata.setMetadata(m);
+	}
+	return result;
+}
+
 /**
  * \brief Retrieve the metadata for an image
  */
@@ -365,6 +197,13 @@ ImageEnvelope	ImageRepo::getEnvelope(const UUID& uuid) {
 	return convert(imageinfo, metadatatable);
 }
 
+/**
+ * \brief Name of the file for an image added to the repository
+ */
+std::string	ImageRepo::imagename(long id) const {
+	return stringprintf("image-%s-%05ld.fits", _name.c_str(), id);
+}
+
 /**
  * \brief Save an image in the repository
  */
@@ -468,11 +307,8 @@ long	ImageRepo::save(ImagePtr image) {
 			seqno);
 
 		// first we have to create a file name for the image
-		std::string	fullname
-			= stringprintf("%s/image-%s-%05ld.fits",
-				_directory.c_str(), _name.c_str(), imageid);
-		std::string	filename
-			= fullname.substr(_directory.size() + 1);
+		std::string	filename = imagename(imageid);
+		std::string	fullname = _directory + "/" + filename;
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "full name: %s",
 			fullname.c_str());
 
@@ -494,6 +330,14 @@ long	ImageRepo::save(ImagePtr image) {
 		// when the ID became known from the add operation
 		update_filename(imageid, filename);
 
+		// remember the fingerprint of the file, so that a scan of
+		// the repository does not read its headers again
+		struct stat	sb;
+		if (0 == stat(fullname.c_str(), &sb)) {
+			FingerprintTable	fingerprints(_database);
+			fingerprints.set(imageid, FingerprintInfo::get(sb));
+		}
+
 		// commit the transaction, only at this point do the database
 		// entries become persistent. This ensures that information
 		// about the image only becomes visible in the database when
@@ -508,6 +352,7 @@ long	ImageRepo::save(ImagePtr image) {
 		// the database will be clean again. In particular, if the
 		// disk write fails, nothing will show up in the database.
 		_database->rollback("saveimage");
+		_database->commit("saveimage");
 		throw;
 	}
 
@@ -593,8 +438,40 @@ public:
 	}
 };
 
+/**
+ * \brief Visitor adding metadata rows to the envelopes they belong to
+ */
+class MetadataCollector {
+	std::map<long, ImageEnvelope>&	_envelopes;
+	bool	_resolved;
+	int	_imageid, _key, _value, _comment;
+public:
+	MetadataCollector(std::map<long, ImageEnvelope>& envelopes)
+		: _envelopes(envelopes), _resolved(false) { }
+	void	operator()(const Cursor& cursor) {
+		if (!_resolved) {
+			_imageid = cursor.column("imageid");
+			_key = cursor.column("key");
+			_value = cursor.column("value");
+			_comment = cursor.column("comment");
+			_resolved = true;
+		}
+		std::map<long, ImageEnvelope>::iterator	e
+			= _envelopes.find(cursor.intValue(_imageid));
+		if (e == _envelopes.end()) {
+			return;
+		}
+		e->second.metadata.setMetadata(FITSKeywords::meta(
+			cursor.stringValue(_key), cursor.stringValue(_value),
+			cursor.stringValue(_comment)));
+	}
+};
+
 /**
  * \brief get a set of images matching the specifcation
+ *
+ * The images and their metadata are retrieved with two queries,
+ * independently of the number of images found.
  */
 std::set<ImageEnvelope>	ImageRepo::get(const ImageSpec& spec) {
 	std::list<condition>	conditions;
@@ -606,9 +483,9 @@ std::set<ImageEnvelope>	ImageRepo::get(const ImageSpec& spec) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "conditions so far: %d",
 		conditions.size());
 
-	// add cameraname condition
+	// add camera condition
 	if (spec.camera().size() > 0) {
-		conditions.push_back(condition(stringprintf("cameraname = '%s'",
+		conditions.push_back(condition(stringprintf("camera = '%s'",
 			spec.camera().c_str())));
 	}
 
@@ -647,14 +524,30 @@ std::set<ImageEnvelope>	ImageRepo::get(const ImageSpec& spec) {
 	ImageTable	imagetable(_database);
 	MetadataTable	metadatatable(_database);
 
-	std::list<ImageRecord>	images = imagetable.select(all);
+	ObjectCollector<ImageRecord, ImageTableAdapter>	collector;
+	imagetable.select(all, collector);
+	std::map<long, ImageEnvelope>	envelopes;
+	std::list<ImageRecord>::const_iterator	ii;
+	for (ii = collector.objects.begin(); ii != collector.objects.end();
+		ii++) {
+		envelopes.insert(std::make_pair(ii->id(), convert(*ii)));
+	}
+
+	// get the metadata of all images found in a single query
+	if (envelopes.size() > 0) {
+		MetadataCollector	metadatacollector(envelopes);
+		metadatatable.select(stringprintf("imageid in (select id from "
+			"images where %s) order by imageid, seqno",
+			all.c_str()), metadatacollector);
+	}
 
 	// build the result set
 	std::set<ImageEnvelope>	resultset;
-	std::list<ImageRecord>::const_iterator	ii;
-	for (ii = images.begin(); ii != images.end(); ii++) {
-		resultset.insert(convert(*ii, metadatatable));
+	std::map<long, ImageEnvelope>::const_iterator	ei;
+	for (ei = envelopes.begin(); ei != envelopes.end(); ei++) {
+		resultset.insert(ei->second);
 	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%d images found", resultset.size());
 	return resultset;
 }
 
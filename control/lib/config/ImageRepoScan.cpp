@@ -0,0 +1,421 @@
+/*
+ * ImageRepoScan.cpp -- incremental scan of the image repository directory
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroProject.h>
+#include <AstroDebug.h>
+#include <AstroIO.h>
+#include <AstroUtils.h>
+#include <includes.h>
+#include <fitsio.h>
+#include "ImageRepoTables.h"
+
+using namespace astro::persistence;
+using namespace astro::image;
+
+namespace astro {
+namespace project {
+
+/**
+ * \brief Number of files whose headers are read before they are written
+ *
+ * The headers of a chunk are read in parallel and then written to the
+ * database in a single transaction, which also bounds the memory needed
+ * for the metadata.
+ */
+static const size_t	scan_chunk = 256;
+
+/**
+ * \brief A FITS file found during a scan
+ */
+class ScanEntry {
+public:
+	std::string	filename;
+	struct stat	sb;
+	long	oldid;
+	bool	parsed;
+	ImageRecord	imageinfo;
+	ImageMetadata	metadata;
+	ScanEntry(const std::string& f, const struct stat& s)
+		: filename(f), sb(s), oldid(-1), parsed(false) { }
+};
+
+static bool	isfits(const std::string& filename) {
+	if (filename.size() < 5) {
+		return false;
+	}
+	return filename.substr(filename.size() - 5) == ".fits";
+}
+
+/**
+ * \brief Collect the FITS files below a directory
+ *
+ * \param directory	the repository directory
+ * \param prefix	path of the subdirectory relative to the repository
+ * \param recurse	whether to descend into subdirectories
+ * \param entries	list to add the files to
+ */
+static void	collect(const std::string& directory, const std::string& prefix,
+			bool recurse, std::list<ScanEntry>& entries) {
+	std::string	path = directory;
+	if (prefix.size() > 0) {
+		path = directory + "/" + prefix;
+	}
+	DIR	*dir = opendir(path.c_str());
+	if (NULL == dir) {
+		std::string	msg = stringprintf("cannot open image repo "
+			"dir %s: %s", path.c_str(), strerror(errno));
+		if (prefix.size() > 0) {
+			debug(LOG_WARNING, DEBUG_LOG, 0, "%s", msg.c_str());
+			return;
+		}
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	struct dirent	*d;
+	while (NULL != (d = readdir(dir))) {
+		std::string	name(d->d_name);
+		if ((name == ".") || (name == "..")) {
+			continue;
+		}
+		std::string	relative = name;
+		if (prefix.size() > 0) {
+			relative = prefix + "/" + name;
+		}
+		std::string	fullname = directory + "/" + relative;
+		struct stat	sb;
+		if (lstat(fullname.c_str(), &sb) < 0) {
+			debug(LOG_DEBUG, DEBUG_LOG, 0, "cannot stat file %s: %s",
+				fullname.c_str(), strerror(errno));
+			continue;
+		}
+		// symbolic links to directories are not followed, to
+		// avoid loops
+		if (S_ISDIR(sb.st_mode)) {
+			if (recurse && (name[0] != '.')) {
+				collect(directory, relative, recurse, entries);
+			}
+			continue;
+		}
+		if (!isfits(name)) {
+			continue;
+		}
+		if (S_ISLNK(sb.st_mode) && (stat(fullname.c_str(), &sb) < 0)) {
+			continue;
+		}
+		if (!S_ISREG(sb.st_mode)) {
+			debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: not a regular file",
+				fullname.c_str());
+			continue;
+		}
+		entries.push_back(ScanEntry(relative, sb));
+	}
+	closedir(dir);
+}
+
+/**
+ * \brief Read the headers of a file
+ *
+ * This only touches the entry, so it can run in parallel for different
+ * files. The headers go through the header cache, so a file whose
+ * header was recently read does not have to be opened again.
+ */
+static void	parse(const std::string& fullname, ScanEntry& entry) {
+	io::FITSheaderPtr	header = io::FITSinfileBase::header(fullname);
+	ImageRecord&	imageinfo = entry.imageinfo;
+	imageinfo.filename = entry.filename;
+	imageinfo.project = "unknown";
+	imageinfo.created = entry.sb.st_ctime;
+	try {
+		imageinfo.camera
+			= (std::string)header->getMetadata("INSTRUME");
+	} catch (...) { }
+	imageinfo.width = header->getSize().width();
+	imageinfo.height = header->getSize().height();
+	imageinfo.xbin = 1;
+	try {
+		imageinfo.xbin
+			= (int)header->getMetadata("XBINNING");
+	} catch (...) { }
+	imageinfo.ybin = 1;
+	try {
+		imageinfo.ybin
+			= (int)header->getMetadata("YBINNING");
+	} catch (...) { }
+	imageinfo.depth = header->getPlanes();
+	imageinfo.pixeltype = header->getPixeltype();
+	imageinfo.exposuretime = 0;
+	try {
+		imageinfo.exposuretime
+			= (double)header->getMetadata("EXPTIME");
+	} catch (...) { }
+	imageinfo.gain = -1;
+	try {
+		imageinfo.gain
+			= (double)header->getMetadata("GAIN");
+	} catch (...) { }
+	imageinfo.temperature = 0;
+	try {
+		imageinfo.temperature
+			= (double)header->getMetadata("CCD-TEMP");
+	} catch (...) { }
+	imageinfo.purpose = "light";
+	try {
+		imageinfo.purpose = (std::string)header->getMetadata("PURPOSE");
+	} catch (...) { }
+	imageinfo.quality = "high";
+	try {
+		imageinfo.quality = (std::string)header->getMetadata("QUALITY");
+	} catch (...) { }
+	imageinfo.bayer = "    ";
+	try {
+		imageinfo.bayer
+			= trim((std::string)header->getMetadata("BAYER"));
+	} catch (...) { }
+	imageinfo.focus = 0;
+	try {
+		imageinfo.focus
+			= (int)header->getMetadata("FOCUSPOS");
+	} catch (...) { }
+	imageinfo.observation = "1970-01-01T00:00:00.000";
+	imageinfo.uuid = "";
+	try {
+		imageinfo.uuid = (std::string)(header->getMetadata("UUID"));
+	} catch (...) { }
+	entry.metadata = header->getAllMetadata();
+	entry.parsed = true;
+}
+
+/**
+ * \brief Write the entries of a chunk in a single transaction
+ *
+ * Each file gets its own savepoint, so that a file that cannot be added,
+ * e.g. because its UUID is already in the repository, does not prevent
+ * the other files of the chunk from being added. Files that are already
+ * indexed keep their id, their row and metadata are replaced in place.
+ *
+ * \return the number of files added or updated
+ */
+static long	write(Database database, std::vector<ScanEntry *>& work,
+			size_t start, size_t end) {
+	ImageTable	images(database);
+	MetadataTable	metadatatable(database);
+	FingerprintTable	fingerprints(database);
+	long	counter = 0;
+	database->begin("scan");
+	try {
+		for (size_t i = start; i < end; i++) {
+			ScanEntry&	entry = *work[i];
+			if (!entry.parsed) {
+				continue;
+			}
+			database->begin("scanfile");
+			try {
+				long	imageid = entry.oldid;
+				if (imageid >= 0) {
+					images.update(imageid, entry.imageinfo);
+					metadatatable.remove(stringprintf(
+						"imageid = %ld", imageid));
+				} else {
+					imageid = images.add(entry.imageinfo);
+				}
+				ImageMetadata::const_iterator	mi;
+				int	seqno = 0;
+				for (mi = entry.metadata.begin();
+					mi != entry.metadata.end(); mi++) {
+					MetadataRecord	m(-1, imageid);
+					m.seqno = seqno++;
+					m.key = mi->first;
+					m.value = mi->second.getValue();
+					m.comment = mi->second.getComment();
+					metadatatable.add(m);
+				}
+				fingerprints.set(imageid,
+					FingerprintInfo::get(entry.sb));
+				database->commit("scanfile");
+				debug(LOG_DEBUG, DEBUG_LOG, 0, "image %s gets id %ld",
+					entry.filename.c_str(), imageid);
+				counter++;
+			} catch (const std::exception& x) {
+				debug(LOG_ERR, DEBUG_LOG, 0, "cannot add %s: %s",
+					entry.filename.c_str(), x.what());
+				database->rollback("scanfile");
+				database->commit("scanfile");
+			}
+		}
+		database->commit("scan");
+	} catch (...) {
+		database->rollback("scan");
+		database->commit("scan");
+		throw;
+	}
+	return counter;
+}
+
+/**
+ * \brief Indexed files by name or UUID, with id and fingerprint or name
+ */
+typedef std::map<std::string, std::pair<long, std::string> >	known_t;
+
+/**
+ * \brief Find the entries of a chunk that are renamed indexed files
+ *
+ * A new file with the UUID of an indexed file that no longer exists is
+ * that file under a new name, its entry is updated. If the indexed file
+ * still exists, the new file is a copy and cannot be added.
+ *
+ * \param uuids	id and filename of the indexed files by UUID
+ * \param present	names of the files found in the directory
+ */
+static void	renamed(known_t& uuids, const std::set<std::string>& present,
+			std::vector<ScanEntry *>& work, size_t start, size_t end) {
+	for (size_t i = start; i < end; i++) {
+		ScanEntry&	entry = *work[i];
+		if ((!entry.parsed) || (entry.oldid >= 0)
+			|| (entry.imageinfo.uuid.size() == 0)) {
+			continue;
+		}
+		auto	u = uuids.find(entry.imageinfo.uuid);
+		if (u == uuids.end()) {
+			continue;
+		}
+		if (present.find(u->second.second) != present.end()) {
+			debug(LOG_DEBUG, DEBUG_LOG, 0, "%s has the UUID of %s, "
+				"skipped", entry.filename.c_str(),
+				u->second.second.c_str());
+			entry.parsed = false;
+			continue;
+		}
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s renamed to %s",
+			u->second.second.c_str(), entry.filename.c_str());
+		entry.oldid = u->second.first;
+		u->second.second = entry.filename;
+	}
+}
+
+/**
+ * \brief Scan the repository directory for new or changed images
+ *
+ * The fingerprints of all files indexed in the repository are read with
+ * a single query. Files with an unchanged fingerprint are skipped without
+ * opening them. Files indexed before fingerprints were introduced only
+ * get their fingerprint recorded. The headers of new or changed files are
+ * read in parallel if cfitsio is reentrant, and the results are written
+ * in chunks.
+ *
+ * \param recurse	whether to scan subdirectories too
+ * \return the number of files added or updated
+ */
+long	ImageRepo::scan(bool recurse) {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "scan directory %s%s",
+		_directory.c_str(), (recurse) ? " recursively" : "");
+	std::list<ScanEntry>	entries;
+	collect(_directory, "", recurse, entries);
+
+	std::set<std::string>	present;
+	for (auto e = entries.begin(); e != entries.end(); e++) {
+		present.insert(e->filename);
+	}
+
+	// get the fingerprints and UUIDs of all files in the repository
+	known_t	known;
+	known_t	uuids;
+	{
+		ImageTable	images(_database);
+		FingerprintTable	fingerprints(_database);
+		StatementPtr	stmt = _database->statement(
+			"select images.id, images.filename, "
+			"fingerprints.fingerprint, images.uuid "
+			"from images left outer join fingerprints "
+			"on fingerprints.imageid = images.id");
+		CursorPtr	cursor = stmt->cursor();
+		while (cursor->next()) {
+			long	id = cursor->intValue(0);
+			std::string	filename = cursor->stringValue(1);
+			known.insert(std::make_pair(filename,
+				std::make_pair(id, cursor->stringValue(2))));
+			std::string	uuid = cursor->stringValue(3);
+			if (uuid.size() > 0) {
+				uuids.insert(std::make_pair(uuid,
+					std::make_pair(id, filename)));
+			}
+		}
+	}
+
+	// find the files that have to be read
+	std::vector<ScanEntry *>	work;
+	std::list<std::pair<long, std::string> >	unfingerprinted;
+	long	unchanged = 0;
+	std::list<ScanEntry>::iterator	e;
+	for (e = entries.begin(); e != entries.end(); e++) {
+		std::string	fingerprint = FingerprintInfo::get(e->sb);
+		known_t::const_iterator	k = known.find(e->filename);
+		if (k == known.end()) {
+			work.push_back(&*e);
+		} else if (k->second.second == fingerprint) {
+			unchanged++;
+		} else if (k->second.second.size() == 0) {
+			unfingerprinted.push_back(std::make_pair(
+				k->second.first, fingerprint));
+		} else {
+			e->oldid = k->second.first;
+			work.push_back(&*e);
+		}
+	}
+
+	// record the fingerprints of files indexed by older versions
+	if (unfingerprinted.size() > 0) {
+		FingerprintTable	fingerprints(_database);
+		_database->begin("fingerprints");
+		try {
+			std::list<std::pair<long, std::string> >::const_iterator
+				u;
+			for (u = unfingerprinted.begin();
+				u != unfingerprinted.end(); u++) {
+				fingerprints.set(u->first, u->second);
+			}
+			_database->commit("fingerprints");
+		} catch (...) {
+			_database->rollback("fingerprints");
+			_database->commit("fingerprints");
+			throw;
+		}
+	}
+
+	// read the headers of new and changed files in parallel, unless
+	// cfitsio was built without thread support
+	bool	reentrant = fits_is_reentrant();
+	if (!reentrant) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "cfitsio not reentrant, "
+			"reading headers serially");
+	}
+	long	added = 0;
+	for (size_t start = 0; start < work.size(); start += scan_chunk) {
+		size_t	end = std::min(start + scan_chunk, work.size());
+#pragma omp parallel for schedule(dynamic) if (reentrant)
+		for (int i = start; i < (int)end; i++) {
+			std::string	fullname = _directory + "/"
+				+ work[i]->filename;
+			try {
+				parse(fullname, *work[i]);
+			} catch (const std::exception& x) {
+				debug(LOG_WARNING, DEBUG_LOG, 0,
+					"cannot read %s: %s", fullname.c_str(),
+					x.what());
+			}
+		}
+		renamed(uuids, present, work, start, end);
+		added += write(_database, work, start, end);
+		for (size_t i = start; i < end; i++) {
+			work[i]->metadata = ImageMetadata();
+		}
+	}
+	debug(LOG_INFO, DEBUG_LOG, 0, "%s: %d files, %ld unchanged, "
+		"%d fingerprinted, %ld added or updated", _directory.c_str(),
+		entries.size(), unchanged, unfingerprinted.size(), added);
+	return added;
+}
+
+} // namespace project
+} // namespace astro
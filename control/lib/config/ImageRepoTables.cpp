@@ -63,6 +63,28 @@ std::string	ImageTableAdapter::tablename() {
 	return std::string("images");
 }
 
+/**
+ * \brief Secondary indexes for the queries selecting calibration images
+ *
+ * ImageRepo::get filters by purpose, camera, exposure time, temperature
+ * and project. The first index serves the typical dark or flat request.
+ */
+static const char	*image_indexes[] = {
+	"create index if not exists images_x3 "
+		"on images(purpose, camera, exposuretime);\n",
+	"create index if not exists images_x4 on images(temperature);\n",
+	"create index if not exists images_x5 on images(project);\n",
+	NULL
+};
+
+static std::string	indexstatements() {
+	std::string	result;
+	for (const char **i = image_indexes; *i != NULL; i++) {
+		result.append(*i);
+	}
+	return result;
+}
+
 std::string	ImageTableAdapter::createstatement() {
 	return std::string(
 		"create table images (\n"
@@ -91,11 +113,12 @@ std::string	ImageTableAdapter::createstatement() {
 		");\n"
 		"create unique index images_x1 on images(filename);\n"
 		"create unique index images_x2 on images(uuid);\n"
-	);
+	) + indexstatements();
 }
 
+template<typename row_type>
 ImageRecord	ImageTableAdapter::row_to_object(int objectid,
-				const Row& row) {
+				const row_type& row) {
 	ImageRecord	record(objectid);
 	record.filename = row["filename"]->stringValue();
 	record.project = row["project"]->stringValue();
@@ -120,6 +143,11 @@ ImageRecord	ImageTableAdapter::row_to_object(int objectid,
 	return record;
 }
 
+template ImageRecord	ImageTableAdapter::row_to_object(int objectid,
+				const Row& row);
+template ImageRecord	ImageTableAdapter::row_to_object(int objectid,
+				const CursorRow& row);
+
 UpdateSpec	ImageTableAdapter::object_to_updatespec(const ImageRecord& imagerec) {
 	UpdateSpec	spec;
 	FieldValueFactory	factory;
@@ -155,6 +183,23 @@ long	ImageTable::id(const std::string& filename) {
 	return TableBase::id(condition);
 }
 
+/**
+ * \brief Create the secondary indexes in repositories that lack them
+ *
+ * Repositories created before the indexes were introduced only have the
+ * indexes on filename and uuid. Checking for the last index first keeps
+ * this cheap for repositories that already have them.
+ */
+void	ImageTable::createindexes() {
+	Result	result = _database->query("select count(*) from sqlite_master "
+		"where type = 'index' and name = 'images_x5'");
+	if ((result.size() == 1) && (result.front()[0]->intValue() > 0)) {
+		return;
+	}
+	debug(LOG_INFO, DEBUG_LOG, 0, "adding indexes to images table");
+	_database->query(indexstatements());
+}
+
 //////////////////////////////////////////////////////////////////////
 // MetadataInfo implementation (if necessary)
 //////////////////////////////////////////////////////////////////////
@@ -211,5 +256,100 @@ UpdateSpec	MetadataTableAdapter::object_to_updatespec(const MetadataRecord&metar
 	return spec;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Fingerprint table
+//////////////////////////////////////////////////////////////////////
+std::string	FingerprintInfo::get(const struct stat& sb) {
+	return stringprintf("%llu:%lld:%lld",
+		(unsigned long long)sb.st_ino, (long long)sb.st_size,
+		(long long)sb.st_mtime);
+}
+
+std::string	FingerprintTableAdapter::tablename() {
+	return std::string("fingerprints");
+}
+
+std::string	FingerprintTableAdapter::createstatement() {
+	return std::string(
+		"create table fingerprints (\n"
+		"    id integer not null,\n"
+		"    imageid integer not null references images(id) "
+			"on delete cascade on update cascade,\n"
+		"    fingerprint varchar(64) not null,\n"
+		"    primary key(id)\n"
+		");\n"
+		"create unique index fingerprints_x1 on fingerprints(imageid);\n"
+	);
+}
+
+FingerprintRecord	FingerprintTableAdapter::row_to_object(int objectid,
+			const Row& row) {
+	FingerprintRecord	record(objectid, row["imageid"]->intValue());
+	record.fingerprint = row["fingerprint"]->stringValue();
+	return record;
+}
+
+UpdateSpec	FingerprintTableAdapter::object_to_updatespec(
+			const FingerprintRecord& fingerprint) {
+	UpdateSpec	spec;
+	FieldValueFactory	factory;
+	spec.insert(Field("imageid", factory.get((int)fingerprint.ref())));
+	spec.insert(Field("fingerprint",
+		factory.get(fingerprint.fingerprint)));
+	return spec;
+}
+
+/**
+ * \brief Set the fingerprint of an image
+ */
+void	FingerprintTable::set(long imageid, const std::string& fingerprint) {
+	remove(stringprintf("imageid = %ld", imageid));
+	FingerprintRecord	record(-1, imageid);
+	record.fingerprint = fingerprint;
+	add(record);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Replication journal table
+//////////////////////////////////////////////////////////////////////
+std::string	ReplicationTableAdapter::tablename() {
+	return std::string("replications");
+}
+
+std::string	ReplicationTableAdapter::createstatement() {
+	return std::string(
+		"create table replications (\n"
+		"    id integer not null,\n"
+		"    uuid varchar(36) not null,\n"
+		"    tempname varchar(1024) not null,\n"
+		"    checksum varchar(32) not null,\n"
+		"    imageid integer not null,\n"
+		"    primary key(id)\n"
+		");\n"
+		"create unique index replications_x1 on replications(uuid);\n"
+	);
+}
+
+ReplicationRecord	ReplicationTableAdapter::row_to_object(int objectid,
+			const Row& row) {
+	ReplicationRecord	record(objectid);
+	record.uuid = row["uuid"]->stringValue();
+	record.tempname = row["tempname"]->stringValue();
+	record.checksum = row["checksum"]->stringValue();
+	record.imageid = row["imageid"]->intValue();
+	return record;
+}
+
+UpdateSpec	ReplicationTableAdapter::object_to_updatespec(
+			const ReplicationRecord& replication) {
+	UpdateSpec	spec;
+	FieldValueFactory	factory;
+	spec.insert(Field("uuid", factory.get(replication.uuid)));
+	spec.insert(Field("tempname", factory.get(replication.tempname)));
+	spec.insert(Field("checksum", factory.get(replication.checksum)));
+	spec.insert(Field("imageid", factory.get(replication.imageid)));
+	return spec;
+}
+
 } // namespace project
 } // namespace astro
@@ -7,6 +7,7 @@
 #define _ImageRepoTables_h
 
 #include <AstroPersistence.h>
+#include <sys/stat.h>
 
 using namespace astro::persistence;
 
@@ -57,7 +58,8 @@ class ImageTableAdapter {
 public:
 static std::string      tablename();
 static std::string      createstatement();
-static ImageRecord row_to_object(int objectid, const Row& row);
+template<typename row_type>
+static ImageRecord row_to_object(int objectid, const row_type& row);
 static UpdateSpec object_to_updatespec(const ImageRecord& imageinfo);
 };
 
@@ -70,6 +72,7 @@ public:
 		: Table<ImageRecord, ImageTableAdapter>(database) {
 	}
 	virtual long	id(const std::string& filename);
+	void	createindexes();
 };
 
 /**
@@ -120,6 +123,94 @@ public:
 		: Table<MetadataRecord, MetadataTableAdapter>(database) { }
 };
 
+/**
+ * \brief Fingerprint of an image file
+ *
+ * The fingerprint consists of inode, size and modification time of the
+ * file. A scan only reads the headers of files whose fingerprint differs
+ * from the one stored in the repository.
+ */
+class FingerprintInfo {
+public:
+	std::string	fingerprint;
+static std::string	get(const struct stat& sb);
+};
+
+class FingerprintRecord : public PersistentRef<FingerprintInfo> {
+public:
+	FingerprintRecord(int id, int imageid)
+		: PersistentRef<FingerprintInfo>(id, imageid) { }
+};
+
+/**
+ * \brief Adapter for the fingerprint table
+ */
+class FingerprintTableAdapter {
+public:
+static std::string      tablename();
+static std::string      createstatement();
+static FingerprintRecord
+        row_to_object(int objectid, const astro::persistence::Row& row);
+static astro::persistence::UpdateSpec
+        object_to_updatespec(const FingerprintRecord& fingerprint);
+};
+
+/**
+ * \brief Fingerprint table
+ */
+class FingerprintTable
+	: public Table<FingerprintRecord, FingerprintTableAdapter> {
+public:
+	FingerprintTable(Database& database)
+		: Table<FingerprintRecord, FingerprintTableAdapter>(database) { }
+	void	set(long imageid, const std::string& fingerprint);
+};
+
+/**
+ * \brief Progress of the replication of an image into this repository
+ *
+ * The file is first copied to a temporary file in the repository
+ * directory. Once the copy has been verified, the checksum is recorded,
+ * and once the index rows have been written, the id of the image.
+ * After the temporary file has been renamed, the entry is removed.
+ */
+class ReplicationInfo {
+public:
+	std::string	uuid;
+	std::string	tempname;
+	std::string	checksum;
+	int	imageid;
+	ReplicationInfo() : imageid(-1) { }
+};
+
+class ReplicationRecord : public Persistent<ReplicationInfo> {
+public:
+	ReplicationRecord(int id = -1) : Persistent<ReplicationInfo>(id) { }
+};
+
+/**
+ * \brief Adapter for the replication journal table
+ */
+class ReplicationTableAdapter {
+public:
+static std::string      tablename();
+static std::string      createstatement();
+static ReplicationRecord
+        row_to_object(int objectid, const astro::persistence::Row& row);
+static astro::persistence::UpdateSpec
+        object_to_updatespec(const ReplicationRecord& replication);
+};
+
+/**
+ * \brief Replication journal table
+ */
+class ReplicationTable
+	: public Table<ReplicationRecord, ReplicationTableAdapter> {
+public:
+	ReplicationTable(Database& database)
+		: Table<ReplicationRecord, ReplicationTableAdapter>(database) { }
+};
+
 } // namespace project
 } // namespace astro
 
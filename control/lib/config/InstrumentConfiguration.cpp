@@ -137,6 +137,7 @@ void	InstrumentConfigurationBackend::addInstrument(InstrumentPtr instrument) {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "failed to add '%s': %s",
 			instrument->name().c_str(), x.what());
 		_config->database()->rollback("addinstrument");
+		_config->database()->commit("addinstrument");
 		throw;
 	}
 }
@@ -5,30 +5,565 @@
  */
 #include <AstroProject.h>
 #include <AstroDebug.h>
+#include <AstroFormat.h>
 #include <algorithm>
 #include <iterator>
+#include <includes.h>
+#include "ImageRepoTables.h"
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif /* HAVE_SYS_SENDFILE_H */
 
 namespace astro {
 namespace project {
 
-/** 
+/**
  * \brief Create a repository replicator
  */
-RepoReplicator::RepoReplicator() {
+RepoReplicator::RepoReplicator() : _parallelism(4), _batchsize(64) {
+}
+
+/**
+ * \brief Set the number of files copied concurrently
+ */
+void	RepoReplicator::parallelism(int p) {
+	if (p < 1) {
+		std::string	msg = stringprintf("bad parallelism %d", p);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	_parallelism = p;
+}
+
+/**
+ * \brief Set the number of images whose index rows are written together
+ */
+void	RepoReplicator::batchsize(size_t b) {
+	if (b < 1) {
+		std::string	msg("batch size must be positive");
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	_batchsize = b;
+}
+
+/**
+ * \brief Read the UUIDs and ids of all images of a repository
+ *
+ * This is done once per repository and replication, with a query that
+ * only reads the two columns needed.
+ */
+RepoReplicator::uuidmap_t	RepoReplicator::uuidmap(ImageRepoPtr repo) {
+	uuidmap_t	result;
+	ImageTable	images(repo->_database);
+	StatementPtr	stmt = repo->_database->statement(
+		"select id, uuid from images");
+	CursorPtr	cursor = stmt->cursor();
+	while (cursor->next()) {
+		result.insert(std::make_pair(UUID(cursor->stringValue(1)),
+			cursor->intValue(0)));
+	}
+	return result;
 }
 
-std::set<long>	RepoReplicator::uuid2ids(ImageRepoPtr repo,
+/**
+ * \brief Find the ids of a set of UUIDs
+ */
+std::set<long>	RepoReplicator::uuid2ids(const uuidmap_t& map,
 		const std::set<UUID>& uuids) {
 	std::set<long>	result;
 	for (auto ptr = uuids.begin(); ptr != uuids.end(); ptr++) {
-		result.insert(repo->getId(*ptr));
+		auto	range = map.equal_range(*ptr);
+		for (auto i = range.first; i != range.second; i++) {
+			result.insert(i->second);
+		}
 	}
 	return result;
 }
 
+/**
+ * \brief Checksum of a sequence of blocks
+ *
+ * This is the FNV-1a hash applied to 64 bit little endian words instead
+ * of bytes, which needs an eighth of the multiplications. It is only
+ * used to verify that a copy has the same contents as the original.
+ */
+class Checksum {
+	uint64_t	_hash;
+	unsigned char	_tail[8];
+	size_t	_tailsize;
+	void	word(const unsigned char *p) {
+		uint64_t	w = 0;
+		for (int i = 7; i >= 0; i--) {
+			w = (w << 8) | p[i];
+		}
+		_hash ^= w;
+		_hash *= 0x100000001b3ULL;
+	}
+public:
+	Checksum() : _hash(0xcbf29ce484222325ULL), _tailsize(0) { }
+	void	update(const void *data, size_t size);
+	std::string	value();
+};
+
+void	Checksum::update(const void *data, size_t size) {
+	const unsigned char	*p = (const unsigned char *)data;
+	// complete a word left over from the previous block
+	while ((_tailsize > 0) && (size > 0)) {
+		_tail[_tailsize++] = *p++;
+		size--;
+		if (_tailsize == 8) {
+			word(_tail);
+			_tailsize = 0;
+		}
+	}
+	while (size >= 8) {
+		word(p);
+		p += 8;
+		size -= 8;
+	}
+	while (size > 0) {
+		_tail[_tailsize++] = *p++;
+		size--;
+	}
+}
+
+std::string	Checksum::value() {
+	uint64_t	hash = _hash;
+	for (size_t i = 0; i < _tailsize; i++) {
+		hash ^= _tail[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return stringprintf("%016llx", (unsigned long long)hash);
+}
+
+/**
+ * \brief Compute the checksum of the contents of a file
+ */
+std::string	RepoReplicator::checksum(const std::string& filename) {
+	int	fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::string	msg = stringprintf("cannot open %s: %s",
+			filename.c_str(), strerror(errno));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	Checksum	sum;
+	std::vector<unsigned char>	buffer(1 << 20);
+	ssize_t	n;
+	while ((n = read(fd, buffer.data(), buffer.size())) > 0) {
+		sum.update(buffer.data(), n);
+	}
+	int	e = errno;
+	close(fd);
+	if (n < 0) {
+		std::string	msg = stringprintf("cannot read %s: %s",
+			filename.c_str(), strerror(e));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	return sum.value();
+}
+
+/**
+ * \brief Find out whether a kernel copy failed because it is unsupported
+ */
+static bool	unsupported(int e) {
+	return (e == EXDEV) || (e == ENOSYS) || (e == EINVAL)
+		|| (e == EOPNOTSUPP);
+}
+
+/**
+ * \brief Copy with copy_file_range
+ *
+ * \return the number of bytes copied, or -1 if the kernel cannot copy
+ *         between these files
+ */
+static off_t	copy_range(int in, int out, off_t size) {
+#ifdef HAVE_COPY_FILE_RANGE
+	off_t	copied = 0;
+	while (copied < size) {
+		ssize_t	n = copy_file_range(in, NULL, out, NULL,
+				size - copied, 0);
+		if (n < 0) {
+			if ((copied == 0) && unsupported(errno)) {
+				return -1;
+			}
+			throw std::runtime_error(stringprintf(
+				"copy_file_range failed: %s", strerror(errno)));
+		}
+		if (n == 0) {
+			break;
+		}
+		copied += n;
+	}
+	return copied;
+#else
+	return -1;
+#endif /* HAVE_COPY_FILE_RANGE */
+}
+
+/**
+ * \brief Copy with sendfile
+ */
+static off_t	copy_sendfile(int in, int out, off_t size) {
+#ifdef HAVE_SENDFILE
+	off_t	copied = 0;
+	while (copied < size) {
+		ssize_t	n = sendfile(out, in, NULL, size - copied);
+		if (n < 0) {
+			if ((copied == 0) && unsupported(errno)) {
+				return -1;
+			}
+			throw std::runtime_error(stringprintf(
+				"sendfile failed: %s", strerror(errno)));
+		}
+		if (n == 0) {
+			break;
+		}
+		copied += n;
+	}
+	return copied;
+#else
+	return -1;
+#endif /* HAVE_SENDFILE */
+}
+
+/**
+ * \brief Copy through a buffer in user space, computing the checksum
+ */
+static off_t	copy_buffer(int in, int out, Checksum& sum) {
+	std::vector<char>	buffer(1 << 20);
+	off_t	copied = 0;
+	ssize_t	n;
+	while ((n = read(in, buffer.data(), buffer.size())) > 0) {
+		sum.update(buffer.data(), n);
+		ssize_t	written = 0;
+		while (written < n) {
+			ssize_t	w = write(out, buffer.data() + written,
+					n - written);
+			if (w < 0) {
+				throw std::runtime_error(stringprintf(
+					"write failed: %s", strerror(errno)));
+			}
+			written += w;
+		}
+		copied += n;
+	}
+	if (n < 0) {
+		throw std::runtime_error(stringprintf("read failed: %s",
+			strerror(errno)));
+	}
+	return copied;
+}
+
+/**
+ * \brief Copy a file byte for byte
+ *
+ * The kernel copies the data if it can, so the data does not have to
+ * pass through user space. Otherwise the checksum of the source is
+ * computed while copying, so the source is read only once. The copy is
+ * synced to disk before it is verified.
+ *
+ * \return the checksum of the source file
+ */
+static std::string	copyfile(const std::string& from,
+				const std::string& to) {
+	int	in = open(from.c_str(), O_RDONLY);
+	if (in < 0) {
+		std::string	msg = stringprintf("cannot open %s: %s",
+			from.c_str(), strerror(errno));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	struct stat	sb;
+	if (fstat(in, &sb) < 0) {
+		std::string	msg = stringprintf("cannot stat %s: %s",
+			from.c_str(), strerror(errno));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		close(in);
+		throw std::runtime_error(msg);
+	}
+	int	out = open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (out < 0) {
+		std::string	msg = stringprintf("cannot create %s: %s",
+			to.c_str(), strerror(errno));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		close(in);
+		throw std::runtime_error(msg);
+	}
+	Checksum	sum;
+	bool	summed = false;
+	try {
+		off_t	copied = copy_range(in, out, sb.st_size);
+		if (copied < 0) {
+			copied = copy_sendfile(in, out, sb.st_size);
+		}
+		if (copied < 0) {
+			copied = copy_buffer(in, out, sum);
+			summed = true;
+		}
+		if (copied != sb.st_size) {
+			throw std::runtime_error(stringprintf("copied %lld of "
+				"%lld bytes", (long long)copied,
+				(long long)sb.st_size));
+		}
+		if (fsync(out) < 0) {
+			throw std::runtime_error(stringprintf("cannot sync: "
+				"%s", strerror(errno)));
+		}
+	} catch (const std::exception& x) {
+		close(in);
+		close(out);
+		std::string	msg = stringprintf("cannot copy %s to %s: %s",
+			from.c_str(), to.c_str(), x.what());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	close(in);
+	if (close(out) < 0) {
+		std::string	msg = stringprintf("cannot close %s: %s",
+			to.c_str(), strerror(errno));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	// after a kernel copy the source is in the page cache
+	return (summed) ? sum.value() : RepoReplicator::checksum(from);
+}
+
+static std::string	idlist(const std::vector<long>& ids) {
+	std::string	result;
+	for (auto ptr = ids.begin(); ptr != ids.end(); ptr++) {
+		if (result.size() > 0) {
+			result.append(",");
+		}
+		result.append(stringprintf("%ld", *ptr));
+	}
+	return result;
+}
+
+/**
+ * \brief Finish or clean up replications that were interrupted
+ *
+ * Entries whose index rows were committed only need the temporary file
+ * renamed, all other temporary files are incomplete or unverified and
+ * are removed. Those images are copied again by the next replication.
+ */
+void	RepoReplicator::recover(ImageRepoPtr dst) {
+	ReplicationTable	journal(dst->_database);
+	std::list<ReplicationRecord>	entries = journal.select("0 = 0");
+	if (entries.size() == 0) {
+		return;
+	}
+	debug(LOG_INFO, DEBUG_LOG, 0, "recovering %d interrupted replications",
+		entries.size());
+	std::list<long>	done;
+	for (auto ptr = entries.begin(); ptr != entries.end(); ptr++) {
+		std::string	tempname = dst->_directory + "/" + ptr->tempname;
+		if ((ptr->imageid >= 0) && (0 == access(tempname.c_str(), F_OK))) {
+			if (checksum(tempname) == ptr->checksum) {
+				std::string	fullname = dst->pathname(ptr->imageid);
+				if (rename(tempname.c_str(), fullname.c_str()) < 0) {
+					debug(LOG_ERR, DEBUG_LOG, 0, "cannot rename "
+						"%s: %s", tempname.c_str(),
+						strerror(errno));
+					continue;
+				}
+			} else {
+				// forget the image, so it is copied again
+				debug(LOG_ERR, DEBUG_LOG, 0, "%s damaged, image "
+					"%d removed", tempname.c_str(),
+					ptr->imageid);
+				ImageTable	images(dst->_database);
+				images.remove(ptr->imageid);
+				unlink(tempname.c_str());
+			}
+		} else if (ptr->imageid < 0) {
+			unlink(tempname.c_str());
+		}
+		done.push_back(ptr->id());
+	}
+	journal.remove(done);
+}
+
+/**
+ * \brief An image being replicated
+ */
+class ReplicationEntry {
+public:
+	ImageRecord	record;
+	std::list<MetadataRecord>	metadata;
+	std::string	source;
+	std::string	tempname;
+	std::string	checksum;
+	long	journalid;
+	long	imageid;
+	bool	copied;
+	ReplicationEntry(const ImageRecord& r)
+		: record(r), journalid(-1), imageid(-1), copied(false) { }
+};
+
+/**
+ * \brief Replicate a batch of images
+ *
+ * The journal entries are written before the files are copied, so that
+ * incomplete files can be cleaned up after an interruption. The index
+ * rows of all images of the batch are written in a single transaction
+ * together with the journal update, the temporary files are renamed
+ * only after that.
+ *
+ * \return the number of images replicated
+ */
+int	RepoReplicator::copybatch(ImageRepoPtr src, ImageRepoPtr dst,
+		const std::vector<long>& ids) {
+	// read the index rows of the batch from the source
+	std::vector<ReplicationEntry>	work;
+	{
+		ImageTable	images(src->_database);
+		std::list<ImageRecord>	records = images.select(
+			stringprintf("id in (%s)", idlist(ids).c_str()));
+		std::map<long, size_t>	index;
+		for (auto ptr = records.begin(); ptr != records.end(); ptr++) {
+			index.insert(std::make_pair((long)ptr->id(),
+				work.size()));
+			work.push_back(ReplicationEntry(*ptr));
+			ReplicationEntry&	entry = work.back();
+			entry.source = src->_directory + "/" + ptr->filename;
+			entry.tempname = stringprintf(".replicate-%s.part",
+				ptr->uuid.c_str());
+		}
+		MetadataTable	metadatatable(src->_database);
+		std::list<MetadataRecord>	metadata = metadatatable.select(
+			stringprintf("imageid in (%s) order by imageid, seqno",
+				idlist(ids).c_str()));
+		for (auto ptr = metadata.begin(); ptr != metadata.end();
+			ptr++) {
+			auto	i = index.find(ptr->ref());
+			if (i != index.end()) {
+				work[i->second].metadata.push_back(*ptr);
+			}
+		}
+	}
+
+	// record the temporary files in the journal
+	ReplicationTable	journal(dst->_database);
+	dst->_database->begin("replication");
+	try {
+		for (auto ptr = work.begin(); ptr != work.end(); ptr++) {
+			ReplicationRecord	r;
+			r.uuid = ptr->record.uuid;
+			r.tempname = ptr->tempname;
+			ptr->journalid = journal.add(r);
+		}
+		dst->_database->commit("replication");
+	} catch (...) {
+		dst->_database->rollback("replication");
+		dst->_database->commit("replication");
+		throw;
+	}
+
+	// copy and verify the files
+	int	n = work.size();
+#pragma omp parallel for schedule(dynamic) num_threads(_parallelism)
+	for (int i = 0; i < n; i++) {
+		ReplicationEntry&	entry = work[i];
+		std::string	tempname = dst->_directory + "/" + entry.tempname;
+		try {
+			std::string	sourcesum = copyfile(entry.source,
+						tempname);
+			if (checksum(tempname) != sourcesum) {
+				throw std::runtime_error("checksum mismatch");
+			}
+			entry.checksum = sourcesum;
+			entry.copied = true;
+		} catch (const std::exception& x) {
+			debug(LOG_ERR, DEBUG_LOG, 0, "cannot replicate %s: %s",
+				entry.source.c_str(), x.what());
+			unlink(tempname.c_str());
+		}
+	}
+
+	// write the index rows of the batch
+	int	count = 0;
+	dst->_database->begin("replication");
+	try {
+		ImageTable	images(dst->_database);
+		MetadataTable	metadatatable(dst->_database);
+		FingerprintTable	fingerprints(dst->_database);
+		for (auto ptr = work.begin(); ptr != work.end(); ptr++) {
+			if (!ptr->copied) {
+				journal.remove(ptr->journalid);
+				continue;
+			}
+			ImageRecord	record(-1);
+			static_cast<ImageInfo&>(record) = ptr->record;
+			record.filename = ptr->tempname;
+			ptr->imageid = images.add(record);
+			dst->update_filename(ptr->imageid,
+				dst->imagename(ptr->imageid));
+			for (auto m = ptr->metadata.begin();
+				m != ptr->metadata.end(); m++) {
+				MetadataRecord	mr(-1, ptr->imageid);
+				static_cast<MetadataInfo&>(mr) = *m;
+				metadatatable.add(mr);
+			}
+			// renaming keeps inode, size and modification time
+			struct stat	sb;
+			std::string	tempname = dst->_directory + "/"
+				+ ptr->tempname;
+			if (0 == stat(tempname.c_str(), &sb)) {
+				fingerprints.set(ptr->imageid,
+					FingerprintInfo::get(sb));
+			}
+			ReplicationRecord	r(ptr->journalid);
+			r.uuid = ptr->record.uuid;
+			r.tempname = ptr->tempname;
+			r.checksum = ptr->checksum;
+			r.imageid = ptr->imageid;
+			journal.update(ptr->journalid, r);
+			count++;
+		}
+		dst->_database->commit("replication");
+	} catch (...) {
+		dst->_database->rollback("replication");
+		dst->_database->commit("replication");
+		for (auto ptr = work.begin(); ptr != work.end(); ptr++) {
+			unlink((dst->_directory + "/" + ptr->tempname).c_str());
+		}
+		throw;
+	}
+
+	// move the files into place and close the journal entries
+	std::list<long>	done;
+	for (auto ptr = work.begin(); ptr != work.end(); ptr++) {
+		if (!ptr->copied) {
+			continue;
+		}
+		std::string	tempname = dst->_directory + "/" + ptr->tempname;
+		std::string	fullname = dst->pathname(ptr->imageid);
+		if (rename(tempname.c_str(), fullname.c_str()) < 0) {
+			std::string	msg = stringprintf("cannot rename %s to "
+				"%s: %s", tempname.c_str(), fullname.c_str(),
+				strerror(errno));
+			debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+			throw std::runtime_error(msg);
+		}
+		done.push_back(ptr->journalid);
+	}
+	journal.remove(done);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%d of %d images replicated to %s",
+		count, work.size(), dst->name().c_str());
+	return count;
+}
+
 /**
  * \brief Replicate images from one repository to another
  *
+ * The files are copied in batches of batchsize() images, with up to
+ * parallelism() files copied concurrently. An image without a UUID
+ * cannot be tracked by the journal, it is saved through the image
+ * interface of the target repository instead, which assigns a UUID.
+ *
  * \param remove	If this flag is set then images that are not in the
  *			source directory are deleted from target directory
  */
@@ -36,9 +571,18 @@ int	RepoReplicator::replicate(ImageRepoPtr src, ImageRepoPtr dst,
 	bool remove) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "replicating from %s to %s",
 		src->name().c_str(), dst->name().c_str());
+	recover(dst);
 	int	count = 0;
-	std::set<UUID>	srcuuids = src->getUUIDs(std::string("0 = 0"));
-	std::set<UUID>	dstuuids = dst->getUUIDs(std::string("0 = 0"));
+	uuidmap_t	srcmap = uuidmap(src);
+	uuidmap_t	dstmap = uuidmap(dst);
+	std::set<UUID>	srcuuids;
+	for (auto ptr = srcmap.begin(); ptr != srcmap.end(); ptr++) {
+		srcuuids.insert(ptr->first);
+	}
+	std::set<UUID>	dstuuids;
+	for (auto ptr = dstmap.begin(); ptr != dstmap.end(); ptr++) {
+		dstuuids.insert(ptr->first);
+	}
 	std::set<UUID>	tocopy;
 
 	// determine the difference
@@ -49,17 +593,35 @@ int	RepoReplicator::replicate(ImageRepoPtr src, ImageRepoPtr dst,
 
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "found %d items to replicate",
 		tocopy.size());
-	std::set<long>	ids = uuid2ids(src, tocopy);
 
-	// copy the entries
+	// images without UUID go through the image interface
+	if (tocopy.erase(UUID(std::string("")))) {
+		std::set<UUID>	empty;
+		empty.insert(UUID(std::string("")));
+		std::set<long>	ids = uuid2ids(srcmap, empty);
+		for (auto ptr = ids.begin(); ptr != ids.end(); ptr++) {
+			debug(LOG_DEBUG, DEBUG_LOG, 0, "save image %ld "
+				"without uuid", *ptr);
+			dst->save(src->getImage(*ptr));
+			count++;
+		}
+	}
+
+	// copy the files in batches
+	std::set<long>	ids = uuid2ids(srcmap, tocopy);
+	std::vector<long>	batch;
 	for (auto ptr = ids.begin(); ptr != ids.end(); ptr++) {
-		debug(LOG_DEBUG, DEBUG_LOG, 0,
-			"copy id %d to repo %s", *ptr, dst->name().c_str());
-		dst->save(src->getImage(*ptr));
-		count++;
+		batch.push_back(*ptr);
+		if (batch.size() >= _batchsize) {
+			count += copybatch(src, dst, batch);
+			batch.clear();
+		}
+	}
+	if (batch.size() > 0) {
+		count += copybatch(src, dst, batch);
 	}
 
-	// if the remove flag is set, remove the 
+	// if the remove flag is set, remove the
 	if (!remove) {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "don't delete");
 		return count;
@@ -74,8 +636,8 @@ int	RepoReplicator::replicate(ImageRepoPtr src, ImageRepoPtr dst,
 		dstuuids.begin(), dstuuids.end(),
 		srcuuids.begin(), srcuuids.end(),
 		std::inserter(toremove, toremove.begin()));
-	ids = uuid2ids(dst, toremove);
-	for (auto ptr = ids.begin(); ptr != ids.end(); ptr++) {
+	std::set<long>	removeids = uuid2ids(dstmap, toremove);
+	for (auto ptr = removeids.begin(); ptr != removeids.end(); ptr++) {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "remove %d from %s",
 			*ptr, dst->name().c_str());
 		dst->remove(*ptr);
@@ -88,7 +650,7 @@ int	RepoReplicator::replicate(ImageRepoPtr src, ImageRepoPtr dst,
 }
 
 /**
- * \brief synchronize images between two repositories
+ * \brief synchronize images between two repositories
  *
  * This methods ensures that all images are present in both repositories
  */
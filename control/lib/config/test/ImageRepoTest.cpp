@@ -30,14 +30,18 @@ public:
 	void	testScan();
 	void	testImage();
 	void	testSelect();
+	void	testRescan();
 	void	testRemove();
+	void	testUpdate();
 	//void	testXXX();
 
 	CPPUNIT_TEST_SUITE(ImageRepoTest);
 	CPPUNIT_TEST(testScan);
 	CPPUNIT_TEST(testImage);
 	CPPUNIT_TEST(testSelect);
+	CPPUNIT_TEST(testRescan);
 	CPPUNIT_TEST(testRemove);
+	CPPUNIT_TEST(testUpdate);
 	//CPPUNIT_TEST(testXXX);
 	CPPUNIT_TEST_SUITE_END();
 };
@@ -129,9 +133,29 @@ void	ImageRepoTest::testSelect() {
 	std::set<ImageEnvelope>	resultset = repo.get(spec);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "found %d darks with temperature -47",
 		resultset.size());
+	// the metadata is retrieved for all images in a single query
+	std::set<ImageEnvelope>::const_iterator	ii;
+	for (ii = resultset.begin(); ii != resultset.end(); ii++) {
+		CPPUNIT_ASSERT(ii->metadata.hasMetadata("EXPTIME"));
+		CPPUNIT_ASSERT(ii->metadata.hasMetadata("INSTRUME"));
+	}
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "testSelect() end");
 }
 
+/**
+ * \brief A second scan must not read any files again
+ */
+void	ImageRepoTest::testRescan() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRescan() begin");
+	ImageRepo	repo("repotest", database, directory, false);
+	long	count = repo.count();
+	long	added = repo.scan();
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "first scan added %ld images", added);
+	CPPUNIT_ASSERT(repo.count() == count + added);
+	CPPUNIT_ASSERT(repo.scan() == 0);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRescan() end");
+}
+
 void	ImageRepoTest::testRemove() {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRemove() begin");
 	ImageRepo	repo("repotest", database, directory, false);
@@ -145,6 +169,52 @@ void	ImageRepoTest::testRemove() {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRemove() end");
 }
 
+/**
+ * \brief Changed and renamed files keep their id
+ */
+void	ImageRepoTest::testUpdate() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testUpdate() begin");
+	ImageRepo	repo("repotest", database, directory, false);
+	repo.scan();
+	Image<unsigned short>	*image
+		= new Image<unsigned short>(ImageSize(64, 48));
+	ImagePtr	imageptr(image);
+	imageptr->setMetadata(FITSKeywords::meta("PURPOSE", "dark"));
+	imageptr->setMetadata(FITSKeywords::meta("EXPTIME", 10.));
+	long	imageid = repo.save(imageptr);
+	UUID	uuid((std::string)imageptr->getMetadata("UUID"));
+	long	count = repo.count();
+
+	// a changed file is updated in place
+	std::string	filename = repo.pathname(imageid);
+	{
+		FITSupdatefile	updatefile(filename);
+		updatefile.setMetadata(FITSKeywords::meta("EXPTIME", 20.));
+	}
+	struct timeval	times[2];
+	gettimeofday(&times[0], NULL);
+	times[0].tv_sec -= 100;
+	times[1] = times[0];
+	utimes(filename.c_str(), times);
+	CPPUNIT_ASSERT(repo.scan() == 1);
+	CPPUNIT_ASSERT(repo.count() == count);
+	CPPUNIT_ASSERT(repo.getId(uuid) == imageid);
+	ImageEnvelope	envelope = repo.getEnvelope(imageid);
+	CPPUNIT_ASSERT((double)envelope.metadata.getMetadata("EXPTIME") == 20.);
+
+	// a renamed file keeps its id and gets the new name
+	std::string	newname = directory + "/renamed-test.fits";
+	unlink(newname.c_str());
+	CPPUNIT_ASSERT(rename(filename.c_str(), newname.c_str()) == 0);
+	CPPUNIT_ASSERT(repo.scan() == 1);
+	CPPUNIT_ASSERT(repo.count() == count);
+	CPPUNIT_ASSERT(repo.getId(uuid) == imageid);
+	CPPUNIT_ASSERT(repo.pathname(imageid) == newname);
+	CPPUNIT_ASSERT(repo.scan() == 0);
+	repo.remove(imageid);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testUpdate() end");
+}
+
 #if 0
 void	ImageRepoTest::testXXX() {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "testXXX() begin");
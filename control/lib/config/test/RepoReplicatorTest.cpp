@@ -0,0 +1,179 @@
+/*
+ * RepoReplicatorTest.cpp -- Tests for the RepoReplicator class
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <AstroDebug.h>
+#include <AstroProject.h>
+#include <AstroIO.h>
+#include <includes.h>
+#include <fstream>
+#include <sstream>
+#include "../ImageRepoTables.h"
+
+using namespace astro::project;
+using namespace astro::persistence;
+using namespace astro::image;
+using namespace astro::io;
+
+namespace astro {
+namespace test {
+
+class RepoReplicatorTest: public CppUnit::TestFixture {
+	ImageRepoPtr	src;
+	ImageRepoPtr	dst;
+	ImageRepoPtr	repo(const std::string& name);
+public:
+	void	setUp();
+	void	tearDown();
+	void	testReplicate();
+	void	testRecover();
+
+	CPPUNIT_TEST_SUITE(RepoReplicatorTest);
+	CPPUNIT_TEST(testReplicate);
+	CPPUNIT_TEST(testRecover);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RepoReplicatorTest);
+
+/**
+ * \brief Create an empty repository with its own database and directory
+ */
+ImageRepoPtr	RepoReplicatorTest::repo(const std::string& name) {
+	std::string	directory = std::string("tmp/") + name;
+	std::string	databasename = directory + ".db";
+	system((std::string("rm -rf ") + directory).c_str());
+	mkdir(directory.c_str(), 0777);
+	unlink(databasename.c_str());
+	Database	database = DatabaseFactory::get(databasename);
+	return ImageRepoPtr(new ImageRepo(name, database, directory, false));
+}
+
+void	RepoReplicatorTest::setUp() {
+	src = repo("replsrc");
+	dst = repo("repldst");
+}
+
+void	RepoReplicatorTest::tearDown() {
+	src.reset();
+	dst.reset();
+}
+
+static std::string	contents(const std::string& filename) {
+	std::ifstream	in(filename.c_str(), std::ios::binary);
+	std::ostringstream	out;
+	out << in.rdbuf();
+	return out.str();
+}
+
+static void	fill(ImageRepoPtr repo, int n) {
+	for (int i = 0; i < n; i++) {
+		Image<unsigned short>	*image
+			= new Image<unsigned short>(ImageSize(64, 48));
+		image->fill(100 * i);
+		ImagePtr	imageptr(image);
+		imageptr->setMetadata(FITSKeywords::meta("PURPOSE", "dark"));
+		imageptr->setMetadata(FITSKeywords::meta("EXPTIME", 10. * i));
+		repo->save(imageptr);
+	}
+}
+
+void	RepoReplicatorTest::testReplicate() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testReplicate() begin");
+	fill(src, 5);
+	RepoReplicator	replicator;
+	replicator.parallelism(2);
+	replicator.batchsize(2);
+	CPPUNIT_ASSERT(replicator.replicate(src, dst) == 5);
+	CPPUNIT_ASSERT(dst->count() == 5);
+
+	// the copies must be identical to the originals
+	std::set<UUID>	uuids = src->getUUIDs(std::string("0 = 0"));
+	for (auto ptr = uuids.begin(); ptr != uuids.end(); ptr++) {
+		long	srcid = src->getId(*ptr);
+		long	dstid = dst->getId(*ptr);
+		CPPUNIT_ASSERT(contents(src->pathname(srcid))
+			== contents(dst->pathname(dstid)));
+		ImageEnvelope	envelope = dst->getEnvelope(dstid);
+		CPPUNIT_ASSERT(envelope.metadata.hasMetadata("EXPTIME"));
+	}
+
+	// nothing left to do
+	CPPUNIT_ASSERT(replicator.replicate(src, dst) == 0);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testReplicate() end");
+}
+
+/**
+ * \brief Replications interrupted at different stages are completed
+ *
+ * The journal of the target gets an entry whose index rows were written
+ * but whose file was not renamed yet, one whose temporary file was
+ * damaged, and one whose file was only partially copied.
+ */
+void	RepoReplicatorTest::testRecover() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRecover() begin");
+	fill(src, 3);
+	RepoReplicator	replicator;
+	CPPUNIT_ASSERT(replicator.replicate(src, dst) == 3);
+	std::vector<int>	ids = dst->getIds();
+	CPPUNIT_ASSERT(ids.size() == 3);
+	Database	database = DatabaseFactory::get("tmp/repldst.db");
+	ReplicationTable	journal(database);
+
+	// the index rows were written, but the file was not renamed
+	long	resumed = ids[0];
+	UUID	resumeduuid = dst->getEnvelope(resumed).uuid();
+	std::string	resumedname = dst->pathname(resumed);
+	std::string	original = contents(resumedname);
+	ReplicationRecord	r1;
+	r1.uuid = (std::string)resumeduuid;
+	r1.tempname = ".replicate-resumed.part";
+	r1.imageid = resumed;
+	std::string	tempname1 = "tmp/repldst/" + r1.tempname;
+	CPPUNIT_ASSERT(0 == rename(resumedname.c_str(), tempname1.c_str()));
+	r1.checksum = RepoReplicator::checksum(tempname1);
+	journal.add(r1);
+
+	// the temporary file was damaged after the index rows were written
+	long	damaged = ids[1];
+	std::string	damagedname = dst->pathname(damaged);
+	ReplicationRecord	r2;
+	r2.uuid = (std::string)dst->getEnvelope(damaged).uuid();
+	r2.tempname = ".replicate-damaged.part";
+	r2.imageid = damaged;
+	std::string	tempname2 = "tmp/repldst/" + r2.tempname;
+	CPPUNIT_ASSERT(0 == rename(damagedname.c_str(), tempname2.c_str()));
+	r2.checksum = RepoReplicator::checksum(tempname2);
+	CPPUNIT_ASSERT(0 == truncate(tempname2.c_str(), 100));
+	journal.add(r2);
+
+	// the file was partially copied before the index rows were written
+	ReplicationRecord	r3;
+	r3.uuid = "partial";
+	r3.tempname = ".replicate-partial.part";
+	std::string	tempname3 = "tmp/repldst/" + r3.tempname;
+	{
+		std::ofstream	out(tempname3.c_str());
+		out << "incomplete";
+	}
+	journal.add(r3);
+
+	// the damaged image is copied again, the others are complete
+	CPPUNIT_ASSERT(replicator.replicate(src, dst) == 1);
+	CPPUNIT_ASSERT(journal.count() == 0);
+	CPPUNIT_ASSERT(dst->count() == 3);
+	CPPUNIT_ASSERT(dst->getId(resumeduuid) == resumed);
+	CPPUNIT_ASSERT(contents(resumedname) == original);
+	CPPUNIT_ASSERT(!dst->has(damaged));
+	CPPUNIT_ASSERT(0 != access(tempname1.c_str(), F_OK));
+	CPPUNIT_ASSERT(0 != access(tempname2.c_str(), F_OK));
+	CPPUNIT_ASSERT(0 != access(tempname3.c_str(), F_OK));
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRecover() end");
+}
+
+} // namespace test
+} // namespace astro
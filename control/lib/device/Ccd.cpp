@@ -105,6 +105,28 @@ Ccd::Ccd(const CcdInfo& _info)
 	parameter("limit_magnitude", limit_magnitude);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "using limit magnitude %.2f",
 		limit_magnitude);
+
+	// get the stream pipeline and image queue settings
+	try {
+		if (hasProperty("pipelinedepth")) {
+			pipelinedepth(std::stoul(getProperty("pipelinedepth")));
+		}
+		if (hasProperty("pipelinepolicy")) {
+			pipelinepolicy(ImageQueue::string2droppolicy(
+				getProperty("pipelinepolicy")));
+		}
+		if (hasProperty("droppolicy")) {
+			droppolicy(ImageQueue::string2droppolicy(
+				getProperty("droppolicy")));
+		}
+	} catch (const std::exception& x) {
+		debug(LOG_ERR, DEBUG_LOG, 0, "stream settings unusable: %s",
+			x.what());
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "pipeline depth %lu, policy %s, "
+		"queue policy %s", pipelinedepth(),
+		ImageQueue::droppolicy2string(pipelinepolicy()).c_str(),
+		ImageQueue::droppolicy2string(droppolicy()).c_str());
 }
 
 /**
@@ -62,8 +62,11 @@ ImagePtr	DarkWork::common(astro::thread::ThreadBase& /* thread */) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "start to build dark %s",
 		exposure.toString().c_str());
 
-	// retrieve all the images
-	ImageSequence	images;
+	// retrieve the images and add them to the dark as they arrive,
+	// so that only one image has to be kept in memory
+	calibration::DarkFrameFactory	darkfactory;
+	darkfactory.badpixellimitstddevs(_badpixellimit);
+	calibration::DarkFrameBuilder	darkbuilder(darkfactory);
 	for (_imageno = 0; _imageno < imagecount(); _imageno++) {
 		_ccd->startExposure(exposure);
 		if (!_ccd->wait()) {
@@ -71,16 +74,13 @@ ImagePtr	DarkWork::common(astro::thread::ThreadBase& /* thread */) {
 				"exposure %d failed, aborting",  _imageno);
 			return ImagePtr(NULL);
 		}
-		ImagePtr	image = _ccd->getImage();
-		images.push_back(image);
+		darkbuilder.add(_ccd->getImage());
 		update();
 	}
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "got %d images", _imageno);
 
 	// construct the dark image from the images retrieved
-	calibration::DarkFrameFactory	darkfactory;
-	darkfactory.badpixellimitstddevs(_badpixellimit);
-	_darkimage = darkfactory(images);
+	_darkimage = darkbuilder();
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "got an %s dark image with %s pixels",
 		_darkimage->size().toString().c_str(),
 		astro::demangle(_darkimage->pixel_type().name()).c_str());
@@ -62,8 +62,10 @@ ImagePtr	FlatWork::common(astro::thread::ThreadBase& /* thread */) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "start to build flat %s",
 		exposure.toString().c_str());
 
-	// retrieve all the images
-	ImageSequence	images;
+	// retrieve the images and add them to the flat as they arrive,
+	// so that only one image has to be kept in memory
+	calibration::FlatFrameFactory	flatfactory;
+	calibration::FlatFrameBuilder	flatbuilder(flatfactory, _darkimage);
 	for (_imageno = 0; _imageno < imagecount(); _imageno++) {
 		_ccd->startExposure(exposure);
 		if (!_ccd->wait()) {
@@ -71,15 +73,13 @@ ImagePtr	FlatWork::common(astro::thread::ThreadBase& /* thread */) {
 				"exposure %d failed, aborting",  _imageno);
 			return ImagePtr(NULL);
 		}
-		ImagePtr	image = _ccd->getImage();
-		images.push_back(image);
+		flatbuilder.add(_ccd->getImage());
 		update();
 	}
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "got %d images", imagecount());
 
 	// construct the flat image from the images retrieved
-	calibration::FlatFrameFactory	flatfactory;
-	_flatimage = flatfactory(images, _darkimage);
+	_flatimage = flatbuilder();
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "got an %s flat image with %s pixels",
 		_flatimage->size().toString().c_str(),
 		astro::demangle(_flatimage->pixel_type().name()).c_str());
@@ -0,0 +1,107 @@
+/*
+ * ImageBufferPool.cpp -- recycle images of streams
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroCamera.h>
+#include <AstroDebug.h>
+
+namespace astro {
+namespace camera {
+
+/**
+ * \brief Destroy the free images when the pool goes away
+ */
+ImageBufferPool::pooldata::~pooldata() {
+	for (auto i = free.begin(); i != free.end(); i++) {
+		delete *i;
+	}
+}
+
+/**
+ * \brief Create a pool
+ *
+ * \param maxbuffers	maximum number of free images kept in the pool
+ */
+ImageBufferPool::ImageBufferPool(unsigned long maxbuffers)
+	: _data(new pooldata()) {
+	_data->maxbuffers = maxbuffers;
+	_data->allocated = 0;
+	_data->recycled = 0;
+}
+
+/**
+ * \brief Return an image to the pool
+ *
+ * This is the deleter of the images handed out by the pool. Images
+ * outliving the pool or exceeding its capacity are destroyed.
+ */
+void	ImageBufferPool::recycle(std::weak_ptr<pooldata> data,
+		ImageBase *image) {
+	pooldataptr	pool = data.lock();
+	if (pool) {
+		std::unique_lock<std::mutex>	lock(pool->mutex);
+		if (pool->free.size() < pool->maxbuffers) {
+			pool->free.push_back(image);
+			return;
+		}
+	}
+	delete image;
+}
+
+unsigned long	ImageBufferPool::maxbuffers() const {
+	std::unique_lock<std::mutex>	lock(_data->mutex);
+	return _data->maxbuffers;
+}
+
+/**
+ * \brief Change the capacity of the pool, dropping excess images
+ */
+void	ImageBufferPool::maxbuffers(unsigned long m) {
+	std::unique_lock<std::mutex>	lock(_data->mutex);
+	_data->maxbuffers = m;
+	while (_data->free.size() > m) {
+		delete _data->free.front();
+		_data->free.pop_front();
+	}
+}
+
+/**
+ * \brief Number of images that had to be allocated
+ */
+unsigned long	ImageBufferPool::allocated() const {
+	std::unique_lock<std::mutex>	lock(_data->mutex);
+	return _data->allocated;
+}
+
+/**
+ * \brief Number of images that could be taken from the pool
+ */
+unsigned long	ImageBufferPool::recycled() const {
+	std::unique_lock<std::mutex>	lock(_data->mutex);
+	return _data->recycled;
+}
+
+/**
+ * \brief Number of free images in the pool
+ */
+unsigned long	ImageBufferPool::available() const {
+	std::unique_lock<std::mutex>	lock(_data->mutex);
+	return _data->free.size();
+}
+
+/**
+ * \brief Destroy all free images
+ */
+void	ImageBufferPool::clear() {
+	std::unique_lock<std::mutex>	lock(_data->mutex);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "clearing %lu images",
+		_data->free.size());
+	while (_data->free.size() > 0) {
+		delete _data->free.front();
+		_data->free.pop_front();
+	}
+}
+
+} // namespace camera
+} // namespace astro
@@ -5,6 +5,8 @@
  */
 #include <AstroCamera.h>
 #include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <stdexcept>
 
 namespace astro {
 namespace camera {
@@ -18,7 +20,8 @@ namespace camera {
  * \param maxqueuelength	the maximum number of entries in the queue
  */
 ImageQueue::ImageQueue(unsigned long maxqueuelength)
-	: _maxqueuelength(maxqueuelength) {
+	: _maxqueuelength(maxqueuelength), _droppolicy(newest),
+	  _blocking(true) {
 	_processed = 0;
 	_dropped = 0;
 	_sequence = 0;
@@ -44,6 +47,8 @@ ImageQueueEntry	ImageQueue::getEntry(bool block) {
 		if (queue.size() > 0) {
 			ImageQueueEntry	result = queue.front();
 			queue.pop_front();
+			// wake up producers waiting for space in the queue
+			condition.notify_all();
 			return result;
 		}
 		if (!block) {
@@ -69,13 +74,26 @@ void	ImageQueue::add(const Exposure& exposure, ImagePtr image) {
  * \brief Add an entry to the queue
  *
  * As a side effect, the entry contains the sequence number in the queue
- * after it was added to the queue
+ * after it was added to the queue. If the queue is full, the drop policy
+ * decides whether the oldest entry is removed, the new entry is dropped,
+ * or the caller waits until there is space in the queue.
  *
  * \param entry		queue entry to add
  */
 void	ImageQueue::add(ImageQueueEntry& entry) {
 	std::unique_lock<std::mutex>	lock(mutex);
 	_processed++;
+	while ((queue.size() >= _maxqueuelength) && (_droppolicy == block)
+		&& (_blocking)) {
+		condition.wait(lock);
+	}
+	if ((queue.size() >= _maxqueuelength) && (_droppolicy == oldest)
+		&& (queue.size() > 0)) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "dropping oldest image %ld",
+			queue.front().sequence);
+		queue.pop_front();
+		_dropped++;
+	}
 	if (queue.size() < _maxqueuelength) {
 		entry.sequence = _sequence++;
 		queue.push_back(entry);
@@ -91,5 +109,51 @@ void	ImageQueue::add(ImageQueueEntry& entry) {
 	condition.notify_all();
 }
 
+/**
+ * \brief Allow or prevent blocking in add
+ *
+ * When a stream is stopped, producers waiting for space in the queue
+ * must be released, they then drop their image.
+ */
+void	ImageQueue::blocking(bool b) {
+	std::unique_lock<std::mutex>	lock(mutex);
+	_blocking = b;
+	condition.notify_all();
+}
+
+/**
+ * \brief Convert a drop policy to a string
+ */
+std::string	ImageQueue::droppolicy2string(droppolicy_type d) {
+	switch (d) {
+	case oldest:
+		return std::string("oldest");
+	case newest:
+		return std::string("newest");
+	case block:
+		return std::string("block");
+	}
+	throw std::runtime_error("unknown drop policy");
+}
+
+/**
+ * \brief Convert a string to a drop policy
+ */
+ImageQueue::droppolicy_type	ImageQueue::string2droppolicy(
+					const std::string& s) {
+	if (s == "oldest") {
+		return oldest;
+	}
+	if (s == "newest") {
+		return newest;
+	}
+	if (s == "block") {
+		return block;
+	}
+	std::string	msg = stringprintf("unknown drop policy '%s'", s.c_str());
+	debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+	throw std::runtime_error(msg);
+}
+
 } // namespace camera
 } // namespace astro
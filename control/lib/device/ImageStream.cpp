@@ -15,7 +15,8 @@ namespace camera {
  * \brief Construct a stream
  */
 ImageStream::ImageStream(unsigned long _maxqueuelength)
-	: ImageQueue(_maxqueuelength) {
+	: ImageQueue(_maxqueuelength), _imagesink(NULL), _pipelinedepth(2),
+	  _pipelinepolicy(block), _bufferpool(4) {
 	private_data = NULL;
 }
 
@@ -31,30 +32,60 @@ ImageStream::~ImageStream() {
 	}
 }
 
+/**
+ * \brief Stop and destroy the stream thread
+ *
+ * The thread is detached from the stream while holding the lock, but it
+ * is only joined after the lock has been released, because the delivery
+ * thread may be waiting for the lock in operator(). It then finds that
+ * the stream is no longer streaming and drops the image.
+ */
 void	ImageStream::cleanup() {
-	std::lock_guard<std::recursive_mutex>	lock(_mutex);
-	ImageStreamThread	*t = (ImageStreamThread *)private_data;
+	ImageStreamThread	*t = NULL;
+	{
+		std::lock_guard<std::recursive_mutex>	lock(_mutex);
+		t = (ImageStreamThread *)private_data;
+		private_data = NULL;
+	}
+	if (NULL == t) {
+		return;
+	}
+	// release a delivery thread waiting for space in the queue
+	blocking(false);
 	try {
 		t->stop();
 	} catch (...) {
 	}
 	delete t;
-	private_data = NULL;
+	// images still in use return to the pool, but the free ones are
+	// not needed until the next stream is started
+	_bufferpool.clear();
 }
 
 /**
  * \brief start a stream with a given exposure structure
  */
 void	ImageStream::startStream(const Exposure& exposure) {
+	// make sure the stream is not running yet, but remove a thread
+	// that has terminated on its own
+	{
+		std::lock_guard<std::recursive_mutex>	lock(_mutex);
+		if (private_data) {
+			ImageStreamThread	*t
+				= (ImageStreamThread *)private_data;
+			if (t->running()) {
+				throw std::logic_error("stream already running");
+			}
+		}
+	}
+	cleanup();
+
 	std::lock_guard<std::recursive_mutex>	lock(_mutex);
 	_streamexposure = exposure;
-	// make sure the stream is not running yet
-	if (private_data) {
-		ImageStreamThread	*t = (ImageStreamThread *)private_data;
-		if (t->running()) {
-			throw std::logic_error("stream already running");
-		}
-		cleanup();
+	blocking(true);
+	{
+		std::unique_lock<std::mutex>	slock(_statisticsmutex);
+		_statistics = ImageStreamStatistics();
 	}
 
 	// find out whether we also are a CCD, in which case we can really
@@ -74,10 +105,9 @@ void	ImageStream::startStream(const Exposure& exposure) {
  * \brief Stop the stream
  */
 void	ImageStream::stopStream() {
-	std::lock_guard<std::recursive_mutex>	lock(_mutex);
-	if (private_data) {
-		cleanup();
-	}
+	cleanup();
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "stream stopped: %s",
+		statistics().toString().c_str());
 }
 
 /**
@@ -96,6 +126,14 @@ Exposure	ImageStream::streamExposure() {
 	return _streamexposure;
 }
 
+/**
+ * \brief Get counters and timing of the stream
+ */
+ImageStreamStatistics	ImageStream::statistics() {
+	std::unique_lock<std::mutex>	lock(_statisticsmutex);
+	return _statistics;
+}
+
 /**
  * \brief Find out whether stream is still streaming
  */
@@ -112,21 +150,29 @@ bool	ImageStream::streaming() {
  * \brief Process an image entry
  *
  * This method sends the entry to the queue if no sink is defined, but
- * if there is a sink, the image is sent there.
+ * if there is a sink, the image is sent there. The lock is not held
+ * while the sink processes the image or while waiting for space in
+ * the queue, so that neither can prevent the stream from stopping.
  */
 void	ImageStream::operator()(const ImageQueueEntry& entry) {
-	std::lock_guard<std::recursive_mutex>	lock(_mutex);
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "new queue entry received");
-	// check whether streaming is already turned off, in which case
-	// we should not process any images (we shouldn't even be called ;-)
-	if (!streaming()) {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "image %s sent after stop, dropped",
-			entry.exposure.toString().c_str());
-		return;
+	ImageSink	*sink = NULL;
+	{
+		std::lock_guard<std::recursive_mutex>	lock(_mutex);
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "new queue entry received");
+		// check whether streaming is already turned off, in which case
+		// we should not process any images (we shouldn't even be
+		// called ;-)
+		if (!streaming()) {
+			debug(LOG_DEBUG, DEBUG_LOG, 0,
+				"image %s sent after stop, dropped",
+				entry.exposure.toString().c_str());
+			return;
+		}
+		sink = _imagesink;
 	}
-	if (_imagesink) {
+	if (sink) {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "sending entry to sink");
-		(*_imagesink)(entry);
+		(*sink)(entry);
 	} else {
 		ImageQueueEntry	newentry(entry);
 		try {
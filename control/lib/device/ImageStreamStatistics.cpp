@@ -0,0 +1,30 @@
+/*
+ * ImageStreamStatistics.cpp -- counters and timing of an image stream
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroCamera.h>
+#include <AstroFormat.h>
+
+namespace astro {
+namespace camera {
+
+ImageStreamStatistics::ImageStreamStatistics()
+	: exposed(0), delivered(0), dropped(0), exposuretime(0),
+	  readouttime(0), deliverytime(0), stalltime(0) {
+}
+
+/**
+ * \brief Display the average time per image for each stage
+ */
+std::string	ImageStreamStatistics::toString() const {
+	double	n = (exposed > 0) ? exposed : 1;
+	double	d = (delivered > 0) ? delivered : 1;
+	return stringprintf("exposed=%ld, delivered=%ld, dropped=%ld, "
+		"exposure=%.3fs, readout=%.3fs, delivery=%.3fs, stall=%.3fs",
+		exposed, delivered, dropped, exposuretime / n,
+		readouttime / n, deliverytime / d, stalltime / n);
+}
+
+} // namespace camera
+} // namespace astro
@@ -30,6 +30,18 @@ static void	imagestreammain(ImageStreamThread *ist) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "imagestreammain terminates");
 }
 
+/**
+ * \brief Auxiliary function to launch the delivery thread
+ */
+static void	imagedeliverymain(ImageStreamThread *ist) {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "imagedeliverymain starting");
+	try {
+		ist->deliver();
+	} catch (...) {
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "imagedeliverymain terminates");
+}
+
 /**
  * \brief Construct a new thread
  *
@@ -38,7 +50,8 @@ static void	imagestreammain(ImageStreamThread *ist) {
  */
 ImageStreamThread::ImageStreamThread(ImageStream& stream, Ccd *ccd)
 	: _stream(stream), _ccd(ccd), _running(true),
-	  _thread(imagestreammain, this) {
+	  _thread(imagestreammain, this),
+	  _delivery(imagedeliverymain, this) {
 }
 
 /**
@@ -47,11 +60,16 @@ ImageStreamThread::ImageStreamThread(ImageStream& stream, Ccd *ccd)
 ImageStreamThread::~ImageStreamThread() {
 	stop();
 	_thread.join();
+	_delivery.join();
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "stream thread destroyed");
 }
 
 /**
  * \brief main function of the thread
+ *
+ * This is the acquisition stage, it starts the next exposure as soon
+ * as the image of the previous exposure has been handed off to the
+ * delivery stage.
  */
 void	ImageStreamThread::run() {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "start the image stream thread");
@@ -59,21 +77,34 @@ void	ImageStreamThread::run() {
 	try {
 		while (_running) {
 			debug(LOG_DEBUG, DEBUG_LOG, 0, "start new exposure");
+			Timer	timer;
+			timer.start();
 			Exposure	exposure = _stream.streamExposure();
 			_ccd->startExposure(exposure);
 			debug(LOG_DEBUG, DEBUG_LOG, 0, "waiting");
 			_ccd->wait();
+			timer.end();
+			double	exposuretime = timer.elapsed();
+			timer.start();
 			ImagePtr	image = _ccd->getImage();
+			timer.end();
 			debug(LOG_DEBUG, DEBUG_LOG, 0, "image retrieved");
+			{
+				std::unique_lock<std::mutex>	lock(
+					_stream._statisticsmutex);
+				_stream._statistics.exposed++;
+				_stream._statistics.exposuretime += exposuretime;
+				_stream._statistics.readouttime
+					+= timer.elapsed();
+			}
 
 			// create a new entry
 			ImageQueueEntry	entry(_ccd->getExposure(), image);
 			entry.sequence = counter++;
 			debug(LOG_DEBUG, DEBUG_LOG, 0, "image entry prepared");
 
-			// hand the entry over to the stream
-			_stream(entry);
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "image added");
+			// hand the entry over to the delivery thread
+			handoff(entry);
 
 			// verify the state
 			debug(LOG_DEBUG, DEBUG_LOG, 0, "CCD state: %s",
@@ -84,15 +115,104 @@ void	ImageStreamThread::run() {
 		debug(LOG_ERR, DEBUG_LOG, 0, "error in image loop: %s",
 			x.what());
 	}
+	// make sure the delivery thread also terminates
+	stop();
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "terminating the image stream thread");
 }
 
+/**
+ * \brief Hand an entry to the delivery thread
+ *
+ * If the pending queue is full, the pipeline policy of the stream decides
+ * whether the oldest pending entry or the new entry is dropped, or
+ * whether we wait for the delivery thread.
+ */
+void	ImageStreamThread::handoff(ImageQueueEntry& entry) {
+	std::unique_lock<std::mutex>	lock(_mutex);
+	unsigned long	depth = std::max(1UL, _stream.pipelinedepth());
+	ImageQueue::droppolicy_type	policy = _stream.pipelinepolicy();
+	if ((_pending.size() >= depth) && (policy == ImageQueue::block)) {
+		Timer	timer;
+		timer.start();
+		while ((_pending.size() >= depth) && (_running)) {
+			_condition.wait(lock);
+		}
+		timer.end();
+		std::unique_lock<std::mutex>	slock(_stream._statisticsmutex);
+		_stream._statistics.stalltime += timer.elapsed();
+	}
+	if (!_running) {
+		return;
+	}
+	if (_pending.size() >= depth) {
+		{
+			std::unique_lock<std::mutex>	slock(
+				_stream._statisticsmutex);
+			_stream._statistics.dropped++;
+		}
+		if (policy == ImageQueue::newest) {
+			debug(LOG_DEBUG, DEBUG_LOG, 0, "dropping new image %ld",
+				entry.sequence);
+			return;
+		}
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "dropping pending image %ld",
+			_pending.front().sequence);
+		_pending.pop_front();
+	}
+	_pending.push_back(entry);
+	_condition.notify_all();
+}
+
+/**
+ * \brief main function of the delivery thread
+ */
+void	ImageStreamThread::deliver() {
+	Exposure	noexposure;
+	while (true) {
+		ImageQueueEntry	entry(noexposure);
+		{
+			std::unique_lock<std::mutex>	lock(_mutex);
+			while ((_pending.size() == 0) && (_running)) {
+				_condition.wait(lock);
+			}
+			if (!_running) {
+				// images still pending would only be dropped
+				// by the stream anyway
+				_pending.clear();
+				return;
+			}
+			entry = _pending.front();
+			_pending.pop_front();
+			_condition.notify_all();
+		}
+
+		// hand the entry over to the stream
+		Timer	timer;
+		timer.start();
+		try {
+			_stream(entry);
+		} catch (const std::exception& x) {
+			debug(LOG_ERR, DEBUG_LOG, 0, "cannot deliver image "
+				"%ld: %s", entry.sequence, x.what());
+		}
+		timer.end();
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "image added");
+		std::unique_lock<std::mutex>	slock(_stream._statisticsmutex);
+		_stream._statistics.delivered++;
+		_stream._statistics.deliverytime += timer.elapsed();
+	}
+}
+
 /**
  * \brief Stop the thread
  */
 void	ImageStreamThread::stop() {
-	// make sure no other expsure is started
-	_running = false;
+	// make sure no other expsure is started, and wake up both stages
+	{
+		std::unique_lock<std::mutex>	lock(_mutex);
+		_running = false;
+		_condition.notify_all();
+	}
 
 	// cancel the current exposure
 	try {
@@ -6,6 +6,8 @@
 #include <AstroCamera.h>
 #include <AstroDebug.h>
 #include <AstroUtils.h>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <thread>
 #include <atomic>
@@ -15,26 +17,31 @@ namespace camera {
 
 /**
  * \brief ImageStreamThread is private data for the Image Stream base class
+ *
+ * The stream is a pipeline of two stages. The acquisition thread exposes
+ * and reads out images and puts them into the pending queue, the delivery
+ * thread takes them from there and hands them to the stream. The length
+ * of the pending queue is limited by the pipeline depth of the stream,
+ * the pipeline policy of the stream decides what happens when it is full.
  */
 class ImageStreamThread {
-#if 0
-	// This is a temporary exposure structure. It can be changed at
-	// any time, but 
-#endif
 	ImageStream&	_stream;
 	Ccd	*_ccd;
 	volatile std::atomic_bool	_running;
 public:
 	bool	running() const { return _running; }
 private:
+	std::mutex	_mutex; // protects _pending
+	std::condition_variable	_condition;
+	std::deque<ImageQueueEntry>	_pending;
 	std::thread	_thread;
-#if 0
-	std::mutex	_mutex; // mediate access to _exposure
-#endif
+	std::thread	_delivery;
+	void	handoff(ImageQueueEntry& entry);
 public:
 	ImageStreamThread(ImageStream& stream, Ccd *ccd);
 	~ImageStreamThread();
 	void	run();
+	void	deliver();
 	void	stop();
 	void	wait();
 };
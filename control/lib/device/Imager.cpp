@@ -46,6 +46,7 @@ void	Imager::dark(ImagePtr dark) {
 	astro::event(EVENT_CLASS, astro::events::INFO,
 		astro::events::Event::DEVICE, msg);
 	_dark = dark;
+	_kernel.reset();
 }
 
 /**
@@ -59,10 +60,17 @@ void	Imager::flat(ImagePtr flat) {
 	astro::event(EVENT_CLASS, astro::events::INFO,
 		astro::events::Event::DEVICE, msg);
 	_flat = flat;
+	_kernel.reset();
 }
 
 /**
  * \brief Apply image correction
+ *
+ * Dark subtraction, flat division and bad pixel interpolation are done
+ * in a single pass by a calibration kernel. The kernel is kept for
+ * the next image, as long as the frame and the calibration images
+ * don't change.
+ *
  * \param	image to process
  */
 void	Imager::operator()(ImagePtr image) {
@@ -73,32 +81,28 @@ void	Imager::operator()(ImagePtr image) {
 		(_dark) ? "" : " no", (_flat) ? "" : " no",
 		_interpolation);
 
-	// perform dark correction
-	if ((_dark) && (_darksubtract)) {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "perform dark correction");
-		DarkCorrector	corrector(_dark, frame);
-		corrector(image, _interpolation);
-	} else {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "skipping dark correction");
-	}
-
-	// perform flat correction
-	if ((_flat) && (_flatdivide)) {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "perform flat correction");
-		FlatCorrector	corrector(_flat, frame);
-		corrector(image, _interpolation);
-	} else {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "skipping flat correction");
+	ImagePtr	dark = (_darksubtract) ? _dark : ImagePtr();
+	ImagePtr	flat = (_flatdivide) ? _flat : ImagePtr();
+	if ((!dark) && (!flat)) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "skipping dark/flat correction");
+		// XXX-Interpolation This step isn't really necessary any longer
+		if ((_interpolate) && (_dark)) {
+			debug(LOG_DEBUG, DEBUG_LOG, 0, "interpolate bad pixels");
+			Interpolator	interpolator(_dark, frame);
+			interpolator(image);
+		}
+		return;
 	}
 
-	// XXX-Interpolation This step isn't really necessary any longer
-	if ((_interpolate) && (_dark)) {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "interpolate bad pixels");
-		Interpolator	interpolator(_dark, frame);
-		interpolator(image);
-	} else {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "skipping interpolation");
+	if ((!_kernel) || (!(_kernelframe == frame))) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "new kernel for frame %s",
+			frame.toString().c_str());
+		_kernel = CalibrationKernelPtr(new CalibrationKernel(dark, flat,
+			frame));
+		_kernelframe = frame;
 	}
+	_kernel->interpolate((_interpolate) || (_interpolation != 0));
+	(*_kernel)(image);
 }
 
 /**
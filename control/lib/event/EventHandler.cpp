@@ -107,7 +107,7 @@ void	EventHandler::process(const std::string& file, int line,
 
 	// save the record in the database table
 	EventTable	table(database);
-	int	id = table.add(record);
+	int	id = table.queue(record);
 	record.id(id);
 
 	// if a callback is installed, send the event to the callback
@@ -189,13 +189,14 @@ void	CalibrationStore::addPoint(long id, const CalibrationPoint& point) {
 		point.toString().c_str(), id);
 	CalibrationPointRecord	record(0, id, point);
 	CalibrationPointTable	t(_database);
-	t.add(record);
+	t.queue(record);
 }
 
 /**
  * \brief remove all points that belong to a calibration identified by an id
  */
 void	CalibrationStore::removePoints(long id) {
+	persistence::BatchWriter::sync(_database, "calibrationpoint");
 	std::string	query(  "delete from calibrationpoint "
                                 "where calibration = ?");
         persistence::StatementPtr    statement = _database->statement(query);
@@ -56,6 +56,10 @@ std::string	RefreshingTracker::toString() const {
 
 /**
  * \brief Refresh by creating a copy of the image, and updating the offset
+ *
+ * The spectrum of the new reference image is computed here, so that
+ * correlating a new image only needs one forward and one inverse
+ * Fourier transform.
  */
 void	RefreshingTracker::refresh(const ConstImageAdapter<double>& adapter,
 		const Point offset) {
@@ -63,6 +67,7 @@ void	RefreshingTracker::refresh(const ConstImageAdapter<double>& adapter,
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "refreshing with image %s",
 		_image->size().toString().c_str());
 	_imageptr = ImagePtr(_image);
+	_correlator.reference(*_image);
 	_offset = _offset + offset;
 	_lastimagetime = Timer::gettime();
 }
@@ -86,9 +91,19 @@ Point	RefreshingTracker::correlate(const ConstImageAdapter<double>& adapter,
 	return _offset + offset;
 }
 
+/**
+ * \brief Perform phase correlation with the prepared reference image
+ */
 Point	RefreshingTracker::correlate(const ConstImageAdapter<double>& adapter) {
-	PhaseCorrelator	pc;
-	return correlate(adapter, pc);
+	Point	offset = _correlator.correlate(adapter).first;
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "correlate %s with %s -> %s",
+		_image->size().toString().c_str(),
+		adapter.getSize().toString().c_str(),
+		offset.toString().c_str());
+	if (refreshNeeded()) {
+		refresh(adapter, offset);
+	}
+	return _offset + offset;
 }
 
 } // namespace guiding
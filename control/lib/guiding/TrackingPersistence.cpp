@@ -78,8 +78,9 @@ std::string	TrackingTableAdapter::createstatement() {
 	);
 }
 
+template<typename row_type>
 TrackingPointRecord	TrackingTableAdapter::row_to_object(int objectid,
-			const Row& row) {
+			const row_type& row) {
 	double	when = row["trackingtime"]->doubleValue();
 	Point	offset(row["xoffset"]->doubleValue(),
 			row["yoffset"]->doubleValue());
@@ -97,6 +98,11 @@ TrackingPointRecord	TrackingTableAdapter::row_to_object(int objectid,
 	return tracking;
 }
 
+template TrackingPointRecord	TrackingTableAdapter::row_to_object(
+			int objectid, const Row& row);
+template TrackingPointRecord	TrackingTableAdapter::row_to_object(
+			int objectid, const CursorRow& row);
+
 UpdateSpec	TrackingTableAdapter::object_to_updatespec(const TrackingPointRecord& tracking) {
 	UpdateSpec	spec;
 	FieldValueFactory	factory;
@@ -44,7 +44,8 @@ class TrackingTableAdapter {
 public:
 static std::string	tablename();
 static std::string	createstatement();
-static TrackingPointRecord	row_to_object(int objectid, const astro::persistence::Row& row);
+template<typename row_type>
+static TrackingPointRecord	row_to_object(int objectid, const row_type& row);
 static astro::persistence::UpdateSpec	object_to_updatespec(const TrackingPointRecord& tracking);
 };
 
@@ -104,10 +104,11 @@ void	TrackingProcess::callback(const TrackingPoint& trackingpoint) {
 	}
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "TRACK %d: store point %s", _id,
 			trackingpoint.toString().c_str());
-	// add point to table
+	// queue the point, tracking points arrive too fast for a
+	// transaction per point
 	TrackingPointRecord	tracking(0, _id, trackingpoint);
 	TrackingTable	trackingtable(database());
-	trackingtable.add(tracking);
+	trackingtable.queue(tracking);
 }
 
 /**
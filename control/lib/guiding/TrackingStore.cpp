@@ -49,6 +49,20 @@ std::list<long>	TrackingStore::getTrackings(
 	return table.selectids(condition);
 }
 
+/**
+ * \brief Retrieve tracking points through a cursor
+ *
+ * Histories can have hundreds of thousands of points, so they are read
+ * through a cursor instead of building a Row for each point.
+ */
+static std::list<TrackingPointRecord>	history(Database database,
+		const std::string& condition) {
+	TrackingTable	table(database);
+	ObjectCollector<TrackingPointRecord, TrackingTableAdapter>	collector;
+	table.select(condition, collector);
+	return collector.objects;
+}
+
 /**
  * \brief Retrieve a list of all TrackingPoints
  *
@@ -57,8 +71,7 @@ std::list<long>	TrackingStore::getTrackings(
 std::list<TrackingPointRecord>	TrackingStore::getHistory(long id) {
 	std::ostringstream	out;
 	out << "track = " << id << " order by trackingtime";
-	TrackingTable	table(_database);
-	return table.select(out.str());
+	return history(_database, out.str());
 }
 
 /**
@@ -79,8 +92,7 @@ std::list<TrackingPointRecord>	TrackingStore::getHistory(long id,
 		break;
 	}
 	out << " order by trackingtime";
-	TrackingTable	table(_database);
-	return table.select(out.str());
+	return history(_database, out.str());
 }
 
 /**
@@ -126,6 +138,8 @@ void	TrackingStore::deleteTrackingHistory(long id) {
 	if (!table.exists(id)) {
 		return;
 	}
+	// queued points must not be written after their track is gone
+	persistence::BatchWriter::sync(_database, "tracking");
 	table.remove(id);
 	std::string	query(	"delete from tracking "
 				"where track = ?");
@@ -154,7 +168,9 @@ TrackingSummary	TrackingStore::getSummary(long id) {
 	summary.starttime = track.whenstarted;
 	summary.guideportcalid = track.guideportcalid;
 	summary.adaptiveopticscalid = track.adaptiveopticscalid;
-	// get the summary information about the point data
+	// get the summary information about the point data, including
+	// the points still queued for writing
+	persistence::BatchWriter::sync(_database, "tracking");
 	std::ostringstream	qstr;
 	qstr << "select controltype, count(*), ";
 	qstr << "avg(xoffset) as xmean, ";
@@ -0,0 +1,100 @@
+/*
+ * TrackingStoreTest.cpp -- test the tracking store with queued points
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroGuiding.h>
+#include <AstroPersistence.h>
+#include <TrackingPersistence.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <AstroDebug.h>
+#include <includes.h>
+
+using namespace astro::guiding;
+using namespace astro::persistence;
+
+namespace astro {
+namespace test {
+
+class TrackingStoreTest : public CppUnit::TestFixture {
+	Database	database;
+	long	track();
+	void	queue(long id, int n);
+public:
+	void	setUp();
+	void	tearDown();
+	void	testSummary();
+	void	testDelete();
+
+	CPPUNIT_TEST_SUITE(TrackingStoreTest);
+	CPPUNIT_TEST(testSummary);
+	CPPUNIT_TEST(testDelete);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TrackingStoreTest);
+
+void	TrackingStoreTest::setUp() {
+	unlink("trackingstoretest.db");
+	DatabaseFactory	dbf;
+	database = dbf.get("trackingstoretest.db");
+}
+
+void	TrackingStoreTest::tearDown() {
+	database.reset();
+}
+
+/**
+ * \brief Create a track
+ */
+long	TrackingStoreTest::track() {
+	Track	t(time(NULL), "test", "ccd", "guideport", "ao");
+	TrackRecord	record(0, t);
+	TrackTable	table(database);
+	return table.add(record);
+}
+
+/**
+ * \brief Queue tracking points like the tracking process does
+ */
+void	TrackingStoreTest::queue(long id, int n) {
+	TrackingTable	table(database);
+	for (int i = 0; i < n; i++) {
+		TrackingPoint	point(i, Point(i, 2 * i), Point(0, 0));
+		table.queue(TrackingPointRecord(0, id, point));
+	}
+}
+
+/**
+ * \brief The summary includes the points still queued
+ */
+void	TrackingStoreTest::testSummary() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testSummary() begin");
+	long	id = track();
+	queue(id, 10);
+	TrackingStore	store(database);
+	TrackingSummary	summary = store.getSummary(id);
+	CPPUNIT_ASSERT(summary.count() == 10);
+	CPPUNIT_ASSERT(summary.lastoffset == Point(9, 18));
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testSummary() end");
+}
+
+/**
+ * \brief Deleting a track does not leave queued points behind
+ */
+void	TrackingStoreTest::testDelete() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testDelete() begin");
+	long	id = track();
+	queue(id, 10);
+	TrackingStore	store(database);
+	store.deleteTrackingHistory(id);
+	BatchWriter::get(database)->flush();
+	CPPUNIT_ASSERT(!store.contains(id));
+	CPPUNIT_ASSERT(store.getHistory(id).size() == 0);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testDelete() end");
+}
+
+} // namespace test
+} // namespace astro
@@ -30,6 +30,17 @@ Analyzer::Analyzer(const ConstImageAdapter<double>& baseimage,
 		throw std::range_error(msg);
 	}
 	_hanning = false;
+	_preparedpatchsize = 0;
+	_preparedhanning = false;
+}
+
+/**
+ * \brief The rectangle of a patch centered at a point
+ */
+static ImageRectangle	patchwindow(const ImagePoint& where, int patchsize) {
+	ImagePoint	patchcorner(where.x() - patchsize / 2,
+				where.y() - patchsize / 2);
+	return ImageRectangle(patchcorner, ImageSize(patchsize, patchsize));
 }
 
 
@@ -57,18 +68,38 @@ std::vector<Residual>	Analyzer::operator()(const ConstImageAdapter<double>& imag
 		}
 	}
 
-	// now compute the shift for each point
-	std::vector<Residual>	result;
-	for (auto pt = points.begin(); pt != points.end(); pt++) {
+	// the spectra of the base image patches only have to be computed
+	// again if the patch layout changes
+	if ((points != _points) || (_patchsize != _preparedpatchsize)
+		|| (_hanning != _preparedhanning)) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "new layout of %d patches",
+			points.size());
+		_points = points;
+		_preparedpatchsize = _patchsize;
+		_preparedhanning = _hanning;
+		_correlators.clear();
+		_correlators.resize(points.size(), PhaseCorrelator(_hanning));
+	}
+
+	// now compute the shift for each point, every patch has its own
+	// correlator, so the patches can be processed in parallel
+	int	n = points.size();
+	std::vector<Residual>	residuals(n, Residual(ImagePoint(), Point()));
+	std::vector<int>	valid(n, 0);
+#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < n; i++) {
 		try {
-			Residual	residual = translation(image, *pt,
-							_patchsize);
-			if (residual.valid()) {
-				result.push_back(residual);
-			}
+			residuals[i] = translation(image, i);
+			valid[i] = residuals[i].valid();
 		} catch (const std::exception& x) {
 			debug(LOG_DEBUG, DEBUG_LOG, 0, "ignoring point %s: %s",
-				pt->toString().c_str(), x.what());
+				points[i].toString().c_str(), x.what());
+		}
+	}
+	std::vector<Residual>	result;
+	for (int i = 0; i < n; i++) {
+		if (valid[i]) {
+			result.push_back(residuals[i]);
 		}
 	}
 
@@ -84,15 +115,36 @@ std::vector<Residual>	Analyzer::operator()(const ConstImageAdapter<double>& imag
 	return result;
 }
 
+/**
+ * \brief Get the translation of a patch using the prepared correlator
+ *
+ * The base image patch is the reference of the correlator, so the
+ * translation found goes from the base image to the image, which is
+ * the opposite of what the residual needs.
+ */
+Residual	Analyzer::translation(const ConstImageAdapter<double>& image,
+	size_t patch) const {
+	const ImagePoint&	where = _points[patch];
+	ImageRectangle	window = patchwindow(where, _preparedpatchsize);
+	PhaseCorrelator&	pc = _correlators[patch];
+	if (!pc.prepared()) {
+		WindowAdapter<double>	basepatch(_baseimage, window);
+		pc.reference(basepatch);
+	}
+	WindowAdapter<double>	imagepatch(image, window);
+	std::pair<Point, double>	delta = pc.correlate(imagepatch);
+	Point	translation = -delta.first;
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%s -> %s", where.toString().c_str(),
+		translation.toString().c_str());
+	return Residual(where, translation, delta.second);
+}
+
 Residual	Analyzer::translation(const ConstImageAdapter<double>&image,
 	const ImagePoint& where, int patchsize) const {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "get translation at %s",
 		std::string(where).c_str());
 	// create the subwindow we want to lock at
-	int	xoffset = where.x() - patchsize / 2;
-	int	yoffset = where.y() - patchsize / 2;
-	ImagePoint	patchcorner(xoffset, yoffset);
-	ImageRectangle	window(patchcorner, ImageSize(patchsize, patchsize));
+	ImageRectangle	window = patchwindow(where, patchsize);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "window: %s",
 		window.toString().c_str());
 
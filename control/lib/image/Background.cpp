@@ -97,54 +97,6 @@ TileSet	TileFactory::operator()(const ConstImageAdapter<float>& image) const {
 	return result;
 }
 
-//////////////////////////////////////////////////////////////////////
-// Order statistics adapter
-//////////////////////////////////////////////////////////////////////
-
-template<typename T>
-class OrderStatisticsFilter : public PixelTypeFilter<T, T> {
-	unsigned int	_order;
-public:
-	OrderStatisticsFilter(unsigned int order) : _order(order) { }
-        virtual T       filter(const ConstImageAdapter<T>& image);
-        virtual T       operator()(const ConstImageAdapter<T>& image);
-};
-
-template<typename T>
-T	OrderStatisticsFilter<T>::operator()(
-		const ConstImageAdapter<T>& image) {
-	Timer	timer;
-	timer.start();
-	if (image.getSize().getPixels() < _order) {
-		throw std::range_error("not enough pixels in image");
-	}
-	unsigned int	width = image.getSize().width();
-	unsigned int	height = image.getSize().height();
-	// there are two ways one can implement this: either use an ordered
-	// container or use and unordered container and sort later. It turns
-	// out the using an ordered contained is about 70% slower
-	//std::multiset<T>	v;
-	std::vector<T>	v;
-	for (unsigned int x = 0; x < width; x++) {
-		for (unsigned int y = 0; y < height; y++) {
-			//v.insert(image.pixel(x, y));
-			v.push_back(image.pixel(x, y));
-		}
-	}
-	//typename std::multiset<T>::const_iterator	vp = v.begin();
-	//for (unsigned int n = 0; n < _order; n++) { vp++; }
-	sort(v.begin(), v.end());
-	timer.end();
-	//debug(LOG_DEBUG, DEBUG_LOG, 0, "order time: %.6f", timer.elapsed());
-	//return *vp;
-	return v[_order];
-}
-
-template<typename T>
-T	OrderStatisticsFilter<T>::filter(const ConstImageAdapter<T>& image) {
-	return operator()(image);
-}
-
 //////////////////////////////////////////////////////////////////////
 // Optimization problem solution: the LowerBound class
 //////////////////////////////////////////////////////////////////////
@@ -207,18 +159,19 @@ FunctionPtr	MinimumEstimator<FunctionType>::operator()(const ImagePoint& center,
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "start new iteration %d, h = %s",
 			iterationcount, h->toString().c_str());
 
-		// compute the order statistics in a tile
-		TileSet::const_iterator	tileiterator;
-		for (tileiterator = tileset.begin();
-			tileiterator != tileset.end();
-			tileiterator++) {
-			WindowAdapter<float>	wa(_image, *tileiterator);
-			FunctionPtrSubtractionAdapter	la(wa, h,
-				tileiterator->origin());
-			OrderStatisticsFilter<float>	of(_alpha);
-			float	Z = of(la);
-//debug(LOG_DEBUG, DEBUG_LOG, 0, "Z = %f", Z);
-			tv.push_back(std::make_pair(*tileiterator, Z));
+		// compute the order statistics of all tiles in parallel
+		FunctionPtrSubtractionAdapter	la(_image, h, ImagePoint());
+		std::vector<ImageRectangle>	tiles(tileset.begin(),
+							tileset.end());
+		size_t	pixels = tf.tilesize().getPixels();
+		if (pixels <= _alpha) {
+			throw std::range_error("not enough pixels in tile");
+		}
+		PercentileFilter<float>	of(_alpha / (double)(pixels - 1));
+		std::vector<Percentiles>	Z = of(la, tiles);
+		for (size_t i = 0; i < tileset.size(); i++) {
+			tv.push_back(std::make_pair(tileset[i],
+				(float)Z[i].values()[0]));
 		}
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "values computed");
 
@@ -4,6 +4,7 @@
  * (c) 2013 Prof Dr Andreas Mueller, Hochschule Rapperswil
  */
 #include <Blurr.h>
+#include <AstroConvolve.h>
 #include <fftw3.h>
 #include <math.h>
 #include <AstroDebug.h>
@@ -91,13 +92,6 @@ Image<double>	Blurr::operator()(const Image<double>& image) {
 					sizeof(fftw_complex) * nc);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "transform memory allocated");
 
-	// plan the fourier transform for the forward transform
-	fftw_plan	p = fftw_plan_dft_r2c_2d(n0, n1, 
-				image.pixels, af, FFTW_ESTIMATE);
-	fftw_plan	q = fftw_plan_dft_r2c_2d(n0, n1, 
-				blurr.pixels, bf, FFTW_ESTIMATE);
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "transforms planned");
-
 	// compute the values of the blurring function
 	double	value = 1. / (n0 * n1);
 	debug(LOG_DEBUG, DEBUG_LOG, 0,
@@ -114,8 +108,8 @@ Image<double>	Blurr::operator()(const Image<double>& image) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "blurr kernel computed");
 
 	// compute the fourier transforms
-	fftw_execute(p);
-	fftw_execute(q);
+	FFTWPlans::r2c(image.size(), image.pixels, af);
+	FFTWPlans::r2c(blurr.size(), blurr.pixels, bf);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "transform computed");
 
 	// compute the product
@@ -132,18 +126,12 @@ Image<double>	Blurr::operator()(const Image<double>& image) {
 	Image<double>	blurred(n1, n0);
 
 	// compute the inverse fourier transform
-	fftw_plan	r = fftw_plan_dft_c2r_2d(n0, n1,
-				af, blurred.pixels, FFTW_ESTIMATE);
-	fftw_execute(r);
+	FFTWPlans::c2r(blurred.size(), af, blurred.pixels);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "inverse transform computed");
 
 	// clean up the memory allocated
-	fftw_destroy_plan(r);
-	fftw_destroy_plan(q);
-	fftw_destroy_plan(p);
 	fftw_free(af);
 	fftw_free(bf);
-	fftw_cleanup();
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "blurr computation complete");
 
 	// return the blurred image
@@ -47,12 +47,26 @@ ImagePtr	CalibrationFrameFactory::operator()(
 void	CalibrationFrameFactory::copyMetadata(ImagePtr calframe,
 		const ImageSequence& images,
 		const std::string& purpose) const {
-	// if there aren't any images, skip ahead to the new meta data
+	ImagePtr	firstimage;
 	if (images.size() > 0) {
-		// get the first image, which is used to get the common 
-		// metadata from
-		ImagePtr firstimage = *images.begin();
+		firstimage = *images.begin();
+	}
+	copyMetadata(calframe, firstimage, images.size(), purpose);
+}
 
+/**
+ * \brief Copy metadata to a calibration frame built incrementally
+ *
+ * \param calframe	the calibration frame to copy metadata to
+ * \param firstimage	the first image used to build the frame, only
+ *			its metadata is used
+ * \param count		the number of images used to build the frame
+ */
+void	CalibrationFrameFactory::copyMetadata(ImagePtr calframe,
+		ImagePtr firstimage, size_t count,
+		const std::string& purpose) const {
+	// if there aren't any images, skip ahead to the new meta data
+	if (firstimage) {
 		// copy information about the images
 		copy_metadata("EXPTIME");
 		copy_metadata("XBINNING");
@@ -71,7 +85,7 @@ void	CalibrationFrameFactory::copyMetadata(ImagePtr calframe,
 	// add common information about subframes
 	calframe->setMetadata(io::FITSKeywords::meta("PURPOSE", purpose));
 	calframe->setMetadata(io::FITSKeywords::meta("CALSUBFM",
-		(long)images.size()));
+		(long)count));
 }
 
 } // calibration
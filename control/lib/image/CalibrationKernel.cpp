@@ -0,0 +1,392 @@
+/*
+ * CalibrationKernel.cpp -- fused dark, flat, interpolation and binning
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroCalibration.h>
+#include <AstroAdapter.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <AstroIO.h>
+#include <PixelValue.h>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+using namespace astro::image;
+using namespace astro::adapter;
+
+namespace astro {
+namespace calibration {
+
+/**
+ * \brief Create a kernel for a frame
+ *
+ * Dark and flat may be of any primitive pixel type, and either may be
+ * missing. Flat values that are not positive are treated as bad pixels.
+ *
+ * \param dark		the dark image, or a null pointer
+ * \param flat		the flat image, or a null pointer
+ * \param rectangle	the frame of the images to calibrate, the full
+ *			calibration image if it is the default rectangle
+ */
+CalibrationKernel::CalibrationKernel(ImagePtr dark, ImagePtr flat,
+	const ImageRectangle rectangle)
+	: _interpolate(false), _binning(1),
+	  _minvalue(-std::numeric_limits<double>::infinity()),
+	  _maxvalue(std::numeric_limits<double>::infinity()) {
+	ImageRectangle	frame = rectangle;
+	if (frame == ImageRectangle()) {
+		if (dark) {
+			frame = ImageRectangle(ImagePoint(), dark->size());
+		} else if (flat) {
+			frame = ImageRectangle(ImagePoint(), flat->size());
+		} else {
+			std::string	msg("kernel needs a frame or a "
+				"calibration image");
+			debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+			throw std::runtime_error(msg);
+		}
+	}
+	_size = frame.size();
+	int	w = _size.width();
+	int	h = _size.height();
+	size_t	npixels = _size.getPixels();
+	_dark.resize(npixels, 0.);
+	_gain.resize(npixels, 1.);
+	_bad.resize(npixels, 0);
+
+	std::unique_ptr<ConstPixelValueAdapter<float> >	pvdark;
+	std::unique_ptr<WindowAdapter<float> >	wdark;
+	if (dark) {
+		pvdark.reset(new ConstPixelValueAdapter<float>(dark));
+		wdark.reset(new WindowAdapter<float>(*pvdark, frame));
+	}
+	std::unique_ptr<ConstPixelValueAdapter<float> >	pvflat;
+	std::unique_ptr<WindowAdapter<float> >	wflat;
+	if (flat) {
+		pvflat.reset(new ConstPixelValueAdapter<float>(flat));
+		wflat.reset(new WindowAdapter<float>(*pvflat, frame));
+	}
+
+	// extract the calibration values, bad pixels get values that make
+	// the pass over the image produce what the correctors would
+#pragma omp parallel
+	{
+	std::vector<float>	darkrow(w, 0.);
+	std::vector<float>	flatrow(w, 1.);
+#pragma omp for schedule(static)
+	for (int y = 0; y < h; y++) {
+		if (wdark) {
+			wdark->readrow(y, 0, w, darkrow.data());
+		}
+		if (wflat) {
+			wflat->readrow(y, 0, w, flatrow.data());
+		}
+		size_t	offset = (size_t)y * w;
+		for (int x = 0; x < w; x++) {
+			float	d = darkrow[x];
+			float	f = flatrow[x];
+			if (d != d) {
+				// the dark corrector turns these pixels off
+				_dark[offset + x] = 0.;
+				_gain[offset + x] = 0.;
+				_bad[offset + x] = 1;
+				continue;
+			}
+			_dark[offset + x] = d;
+			if ((f != f) || (f <= 0)) {
+				// the flat corrector leaves these alone
+				_bad[offset + x] = 1;
+				continue;
+			}
+			_gain[offset + x] = 1. / f;
+		}
+	}
+	}
+
+	// index the bad pixels by row
+	_badrows.resize(h + 1);
+	for (int y = 0; y < h; y++) {
+		_badrows[y] = _badpixels.size();
+		size_t	offset = (size_t)y * w;
+		for (int x = 0; x < w; x++) {
+			if (_bad[offset + x]) {
+				_badpixels.push_back(offset + x);
+			}
+		}
+	}
+	_badrows[h] = _badpixels.size();
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "kernel for %s: %s dark, %s flat, "
+		"%d bad pixels", frame.toString().c_str(),
+		(dark) ? "with" : "no", (flat) ? "with" : "no",
+		_badpixels.size());
+}
+
+/**
+ * \brief Set the binning factor
+ */
+void	CalibrationKernel::binning(int b) {
+	if (b < 1) {
+		std::string	msg = stringprintf("bad binning factor %d", b);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::range_error(msg);
+	}
+	_binning = b;
+}
+
+/**
+ * \brief Set the range of the calibrated pixel values
+ *
+ * Integer pixel types are always clamped to the range of the type.
+ */
+void	CalibrationKernel::clamp(double minvalue, double maxvalue) {
+	if (minvalue > maxvalue) {
+		std::string	msg = stringprintf("bad clamp range [%f,%f]",
+			minvalue, maxvalue);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::range_error(msg);
+	}
+	_minvalue = minvalue;
+	_maxvalue = maxvalue;
+}
+
+/**
+ * \brief Calibrated value of a single pixel
+ *
+ * The difference to the dark is clamped to 0 before the flat division,
+ * NaN pixels of floating point images stay NaN.
+ */
+template<typename Pixel, typename W>
+static inline W	calibrated(Pixel p, float d, float g, W lo, W hi) {
+	W	v = (W)p - d;
+	v = (v < 0) ? 0 : v;
+	v = v * g;
+	v = (v < lo) ? lo : v;
+	return (v > hi) ? hi : v;
+}
+
+/**
+ * \brief Calibrate a row
+ *
+ * This is the inner loop of the kernel. It has no branches that depend
+ * on the pixel, so the compiler can vectorize it.
+ */
+template<typename Pixel, typename W, typename Out>
+static void	calibraterow(const Pixel *in, const float *dark,
+			const float *gain, Out *out, int w, W lo, W hi) {
+#pragma omp simd
+	for (int x = 0; x < w; x++) {
+		out[x] = calibrated<Pixel, W>(in[x], dark[x], gain[x], lo, hi);
+	}
+}
+
+/**
+ * \brief Interpolate a bad pixel from the uncalibrated image
+ *
+ * The good neighbours are calibrated on the fly, so the interpolation
+ * only reads the raw image and can be done before the image is
+ * calibrated in place. For mosaic images, green pixels use the diagonal
+ * neighbours, red and blue pixels the neighbours at distance 2, as the
+ * MosaicInterpolator does. A pixel without good neighbours keeps its
+ * calibrated value.
+ */
+template<typename Pixel, typename W>
+W	CalibrationKernel::interpolated(const Image<Pixel>& image,
+		size_t offset, W lo, W hi) const {
+	static const int	mono[4][2] = {
+		{ -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 }
+	};
+	static const int	green[4][2] = {
+		{ -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 }
+	};
+	static const int	redblue[4][2] = {
+		{ -2, 0 }, { 2, 0 }, { 0, -2 }, { 0, 2 }
+	};
+	int	w = _size.width();
+	int	h = _size.height();
+	int	x = offset % w;
+	int	y = offset / w;
+	MosaicType	mosaic = image.getMosaicType();
+	const int	(*neighbours)[2] = mono;
+	if (mosaic.isMosaic()) {
+		neighbours = (mosaic.isG(x, y)) ? green : redblue;
+	}
+	W	sum = 0;
+	int	counter = 0;
+	for (int i = 0; i < 4; i++) {
+		int	nx = x + neighbours[i][0];
+		int	ny = y + neighbours[i][1];
+		if ((nx < 0) || (nx >= w) || (ny < 0) || (ny >= h)) {
+			continue;
+		}
+		size_t	n = (size_t)ny * w + nx;
+		if (_bad[n]) {
+			continue;
+		}
+		sum += calibrated<Pixel, W>(image.pixels[n], _dark[n],
+			_gain[n], lo, hi);
+		counter++;
+	}
+	if (0 == counter) {
+		return calibrated<Pixel, W>(image.pixels[offset], _dark[offset],
+			_gain[offset], lo, hi);
+	}
+	return sum / counter;
+}
+
+/**
+ * \brief Calibrate an image of a given pixel type
+ *
+ * Without binning, the image is calibrated in place. With binning,
+ * each thread calibrates the rows contributing to a binned row into
+ * a buffer and adds the pixels of the same color. The sums are clamped
+ * to the range of the pixel type.
+ */
+template<typename Pixel, typename W>
+ImagePtr	CalibrationKernel::calibrate(Image<Pixel>& image) const {
+	int	w = _size.width();
+	int	h = _size.height();
+	W	lo = _minvalue;
+	W	hi = _maxvalue;
+	if (std::numeric_limits<Pixel>::is_integer) {
+		lo = std::max(lo, (W)0);
+		hi = std::min(hi, (W)std::numeric_limits<Pixel>::max());
+	}
+
+	// interpolated values of the bad pixels, from the raw image
+	std::vector<W>	badvalues;
+	if (_interpolate) {
+		badvalues.resize(_badpixels.size());
+#pragma omp parallel for schedule(static)
+		for (size_t k = 0; k < _badpixels.size(); k++) {
+			badvalues[k] = interpolated<Pixel, W>(image,
+				_badpixels[k], lo, hi);
+		}
+	}
+
+	if (_binning == 1) {
+#pragma omp parallel for schedule(static)
+		for (int y = 0; y < h; y++) {
+			size_t	offset = (size_t)y * w;
+			Pixel	*row = image.pixels + offset;
+			calibraterow<Pixel, W, Pixel>(row, &_dark[offset],
+				&_gain[offset], row, w, lo, hi);
+			if (_interpolate) {
+				for (size_t k = _badrows[y]; k < _badrows[y + 1];
+					k++) {
+					row[_badpixels[k] - offset] = badvalues[k];
+				}
+			}
+		}
+		return ImagePtr();
+	}
+
+	// binning combines pixels of the same color
+	MosaicType	mosaic = image.getMosaicType();
+	int	cell = (mosaic.isMosaic()) ? 2 : 1;
+	int	b = _binning;
+	int	bw = cell * (w / (cell * b));
+	int	bh = cell * (h / (cell * b));
+	if ((bw == 0) || (bh == 0)) {
+		std::string	msg = stringprintf("image %s too small for "
+			"binning %d", _size.toString().c_str(), b);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	Image<Pixel>	*result = new Image<Pixel>(bw, bh);
+	ImagePtr	resultptr(result);
+	W	typemax = (std::numeric_limits<Pixel>::is_integer)
+			? (W)std::numeric_limits<Pixel>::max()
+			: std::numeric_limits<W>::infinity();
+#pragma omp parallel
+	{
+	std::vector<W>	row(w);
+	std::vector<W>	sum(bw);
+#pragma omp for schedule(static)
+	for (int by = 0; by < bh; by++) {
+		std::fill(sum.begin(), sum.end(), (W)0);
+		for (int j = 0; j < b; j++) {
+			int	y = cell * ((by / cell) * b + j) + (by % cell);
+			size_t	offset = (size_t)y * w;
+			calibraterow<Pixel, W, W>(image.pixels + offset,
+				&_dark[offset], &_gain[offset], row.data(), w,
+				lo, hi);
+			if (_interpolate) {
+				for (size_t k = _badrows[y]; k < _badrows[y + 1];
+					k++) {
+					row[_badpixels[k] - offset] = badvalues[k];
+				}
+			}
+			for (int bx = 0; bx < bw; bx++) {
+				int	x = cell * ((bx / cell) * b) + (bx % cell);
+				for (int i = 0; i < b; i++) {
+					sum[bx] += row[x + cell * i];
+				}
+			}
+		}
+		Pixel	*out = result->pixels + (size_t)by * bw;
+		for (int bx = 0; bx < bw; bx++) {
+			W	v = sum[bx];
+			out[bx] = (v > typemax) ? typemax : v;
+		}
+	}
+	}
+
+	// the binned image has the metadata of the original
+	result->metadata(image.metadata());
+	result->setMosaicType(mosaic);
+	int	xbin = 1, ybin = 1;
+	if (image.hasMetadata("XBINNING")) {
+		xbin = (int)image.getMetadata("XBINNING");
+	}
+	if (image.hasMetadata("YBINNING")) {
+		ybin = (int)image.getMetadata("YBINNING");
+	}
+	result->setMetadata(io::FITSKeywords::meta("XBINNING",
+		(long)(xbin * b)));
+	result->setMetadata(io::FITSKeywords::meta("YBINNING",
+		(long)(ybin * b)));
+	return resultptr;
+}
+
+#define	calibrate_typed(Pixel, W)					\
+{									\
+	Image<Pixel>	*timage = dynamic_cast<Image<Pixel> *>(&*image);\
+	if (NULL != timage) {						\
+		ImagePtr	result = calibrate<Pixel, W>(*timage);	\
+		return (result) ? result : image;			\
+	}								\
+}
+
+/**
+ * \brief Calibrate an image
+ *
+ * Without binning, the image is calibrated in place and returned,
+ * otherwise a new binned image is returned.
+ */
+ImagePtr	CalibrationKernel::operator()(ImagePtr image) const {
+	if (image->size() != _size) {
+		std::string	msg = stringprintf("image size %s does not "
+			"match kernel size %s",
+			image->size().toString().c_str(),
+			_size.toString().c_str());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "calibrate %s image%s, binning %d",
+		image->info().c_str(), (_interpolate) ? ", interpolate" : "",
+		_binning);
+	calibrate_typed(unsigned short, float);
+	calibrate_typed(float, float);
+	calibrate_typed(unsigned char, float);
+	calibrate_typed(double, double);
+	calibrate_typed(unsigned int, double);
+	calibrate_typed(unsigned long, double);
+	std::string	msg("calibration only for primitive types");
+	debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+	throw std::runtime_error(msg);
+}
+
+} // namespace calibration
+} // namespace astro
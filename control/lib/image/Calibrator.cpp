@@ -49,21 +49,32 @@ template<typename T>
 ImagePtr	TypedCalibrator<T>::operator()(const ImagePtr image) const {
 	ConstPixelValueAdapter<T>	im(image);
 	Image<T>	*result = new Image<T>(image->size());
-	for (int x = 0; x < image->size().width(); x++) {
-		for (int y = 0; y < image->size().height(); y++) {
-			T	darkvalue = dark.pixel(x, y);
+	int	w = image->size().width();
+	int	h = image->size().height();
+#pragma omp parallel
+	{
+	std::vector<T>	darkrow(w);
+	std::vector<T>	flatrow(w);
+#pragma omp for schedule(static)
+	for (int y = 0; y < h; y++) {
+		dark.readrow(y, 0, w, darkrow.data());
+		flat.readrow(y, 0, w, flatrow.data());
+		T	*r = result->pixels + result->pixeloffset(0, y);
+		for (int x = 0; x < w; x++) {
+			T	darkvalue = darkrow[x];
 			// if the pixel is bad give 
 			if (darkvalue != darkvalue) {
-				result->pixel(x, y) = nan;;
+				r[x] = nan;
 				continue;
 			}
 			T	v = im.pixel(x, y) - darkvalue;
 			if (v < 0) {
 				v = 0;
 			}
-			result->pixel(x, y) = v / flat.pixel(x, y);
+			r[x] = v / flatrow[x];
 		}
 	}
+	}
 	return ImagePtr(result);
 }
 
@@ -0,0 +1,214 @@
+/*
+ * Combiner.cpp -- combine pixel values of a stack with outlier rejection
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroStacking.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <algorithm>
+#include <cmath>
+
+namespace astro {
+namespace image {
+namespace stacking {
+
+/**
+ * \brief Mean of the first n values
+ */
+static double	mean(const std::vector<double>& values, size_t n) {
+	double	s = 0;
+	for (size_t i = 0; i < n; i++) {
+		s += values[i];
+	}
+	return s / n;
+}
+
+/**
+ * \brief Standard deviation of the first n values around m
+ */
+static double	stddev(const std::vector<double>& values, size_t n, double m) {
+	double	s = 0;
+	for (size_t i = 0; i < n; i++) {
+		double	d = values[i] - m;
+		s += d * d;
+	}
+	return sqrt(s / n);
+}
+
+/**
+ * \brief Move the values inside [lo, hi] to the front
+ *
+ * \return the number of values retained, or n if all values would
+ *         have been rejected
+ */
+static size_t	retain(std::vector<double>& values, size_t n,
+			double lo, double hi) {
+	std::vector<double>::iterator	end = std::partition(values.begin(),
+		values.begin() + n,
+		[lo, hi](double v) { return (v >= lo) && (v <= hi); });
+	size_t	k = end - values.begin();
+	return (k == 0) ? n : k;
+}
+
+/**
+ * \brief Construct a combiner
+ *
+ * \param method	the rejection method
+ * \param kappa		rejection threshold in units of the standard deviation
+ * \param iterations	maximum number of rejection passes
+ */
+Combiner::Combiner(Stacker::method_type method, double kappa, int iterations)
+	: _method(method), _kappa(kappa), _iterations(iterations) {
+	if (_kappa <= 0) {
+		std::string	msg = stringprintf("bad kappa value %f", _kappa);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+}
+
+/**
+ * \brief Median of the first n values
+ */
+double	Combiner::median(std::vector<double>& values, size_t n) const {
+	std::vector<double>::iterator	mid = values.begin() + n / 2;
+	std::nth_element(values.begin(), mid, values.begin() + n);
+	double	m = *mid;
+	if (0 == (n % 2)) {
+		m = (m + *std::max_element(values.begin(), mid)) / 2;
+	}
+	return m;
+}
+
+/**
+ * \brief Iterative kappa-sigma clipping around the mean
+ */
+double	Combiner::kappasigma(std::vector<double>& values) const {
+	size_t	n = values.size();
+	for (int i = 0; (i < _iterations) && (n > 2); i++) {
+		double	m = mean(values, n);
+		double	s = stddev(values, n, m);
+		if (s <= 0) {
+			break;
+		}
+		size_t	k = retain(values, n, m - _kappa * s, m + _kappa * s);
+		if (k == n) {
+			break;
+		}
+		n = k;
+	}
+	return mean(values, n);
+}
+
+/**
+ * \brief Sigma clipping with a winsorized estimate of mean and sigma
+ *
+ * Center and spread are computed from a copy of the values in which
+ * outliers are replaced by the boundary values, so that a few extreme
+ * pixels (satellite trails, cosmic rays) don't inflate sigma and
+ * hide themselves.
+ */
+double	Combiner::winsorizedsigma(std::vector<double>& values) const {
+	size_t	n = values.size();
+	std::vector<double>	w(n);
+	for (int i = 0; (i < _iterations) && (n > 2); i++) {
+		// robust estimates of center and spread
+		std::copy(values.begin(), values.begin() + n, w.begin());
+		double	m = median(w, n);
+		double	s = stddev(values, n, m);
+		for (int j = 0; j < 10; j++) {
+			double	lo = m - 1.5 * s;
+			double	hi = m + 1.5 * s;
+			for (size_t l = 0; l < n; l++) {
+				w[l] = std::min(hi, std::max(lo, values[l]));
+			}
+			double	previous = s;
+			m = mean(w, n);
+			// correction for the variance lost by winsorizing
+			s = 1.134 * stddev(w, n, m);
+			if (fabs(s - previous) <= 0.0005 * previous) {
+				break;
+			}
+		}
+		if (s <= 0) {
+			break;
+		}
+		size_t	k = retain(values, n, m - _kappa * s, m + _kappa * s);
+		if (k == n) {
+			break;
+		}
+		n = k;
+	}
+	return mean(values, n);
+}
+
+/**
+ * \brief Rejection based on a straight line fit to the sorted values
+ *
+ * This works better than sigma clipping for large stacks with a
+ * gradient in the pixel values, e.g. from changing sky background.
+ */
+double	Combiner::linearfit(std::vector<double>& values) const {
+	size_t	n = values.size();
+	for (int i = 0; (i < _iterations) && (n > 3); i++) {
+		std::sort(values.begin(), values.begin() + n);
+		// least squares fit of v = a + b * index
+		double	sx = 0, sy = 0, sxx = 0, sxy = 0;
+		for (size_t l = 0; l < n; l++) {
+			sx += l;
+			sy += values[l];
+			sxx += l * (double)l;
+			sxy += l * values[l];
+		}
+		double	b = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+		double	a = (sy - b * sx) / n;
+		double	s = 0;
+		for (size_t l = 0; l < n; l++) {
+			s += fabs(values[l] - (a + b * l));
+		}
+		s = s / n;
+		if (s <= 0) {
+			break;
+		}
+		// keep the values close to the line, this preserves the order
+		size_t	k = 0;
+		for (size_t l = 0; l < n; l++) {
+			if (fabs(values[l] - (a + b * l)) <= _kappa * s) {
+				values[k++] = values[l];
+			}
+		}
+		if ((k == n) || (k == 0)) {
+			break;
+		}
+		n = k;
+	}
+	return mean(values, n);
+}
+
+/**
+ * \brief Combine the values
+ *
+ * The values vector is reordered by the rejection algorithms.
+ */
+double	Combiner::operator()(std::vector<double>& values) const {
+	if (values.size() == 0) {
+		return 0;
+	}
+	switch (_method) {
+	case Stacker::SUM:
+		return mean(values, values.size());
+	case Stacker::MEDIAN:
+		return median(values, values.size());
+	case Stacker::KAPPA_SIGMA:
+		return kappasigma(values);
+	case Stacker::WINSORIZED_SIGMA:
+		return winsorizedsigma(values);
+	case Stacker::LINEAR_FIT:
+		return linearfit(values);
+	}
+	throw std::runtime_error("unknown stacking method");
+}
+
+} // namespace stacking
+} // namespace image
+} // namespace astro
@@ -0,0 +1,332 @@
+/*
+ * ComponentLabeler.cpp -- label connected components with union find
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroImage.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <limits>
+
+namespace astro {
+namespace image {
+
+/**
+ * \brief Number of rows in a strip labeled by a single thread
+ */
+static const int	striprows = 64;
+
+/**
+ * \brief Find the root of a provisional label, halving the path
+ */
+static unsigned int	root(std::vector<unsigned int>& parent, unsigned int l) {
+	while (parent[l] != l) {
+		parent[l] = parent[parent[l]];
+		l = parent[l];
+	}
+	return l;
+}
+
+/**
+ * \brief Join the sets of two provisional labels
+ *
+ * The smaller label always becomes the root, so that the roots are the
+ * labels that were assigned first.
+ */
+static unsigned int	unite(std::vector<unsigned int>& parent,
+				unsigned int a, unsigned int b) {
+	a = root(parent, a);
+	b = root(parent, b);
+	if (a < b) {
+		parent[b] = a;
+		return a;
+	}
+	parent[a] = b;
+	return b;
+}
+
+ComponentStatistics::ComponentStatistics() : _area(0),
+	_xmin(std::numeric_limits<int>::max()),
+	_ymin(std::numeric_limits<int>::max()),
+	_xmax(std::numeric_limits<int>::min()),
+	_ymax(std::numeric_limits<int>::min()),
+	_flux(0), _xmoment(0), _ymoment(0),
+	_peak(-std::numeric_limits<double>::infinity()) {
+}
+
+/**
+ * \brief Merge the statistics of another part of the same component
+ */
+void	ComponentStatistics::add(const ComponentStatistics& other) {
+	if (0 == other._area) {
+		return;
+	}
+	_area += other._area;
+	if (other._xmin < _xmin) { _xmin = other._xmin; }
+	if (other._xmax > _xmax) { _xmax = other._xmax; }
+	if (other._ymin < _ymin) { _ymin = other._ymin; }
+	if (other._ymax > _ymax) { _ymax = other._ymax; }
+	_flux += other._flux;
+	_xmoment += other._xmoment;
+	_ymoment += other._ymoment;
+	if (other._peak > _peak) {
+		_peak = other._peak;
+		_peakpoint = other._peakpoint;
+	}
+}
+
+ImageRectangle	ComponentStatistics::boundingbox() const {
+	if (0 == _area) {
+		return ImageRectangle();
+	}
+	return ImageRectangle(ImagePoint(_xmin, _ymin),
+		ImageSize(_xmax - _xmin + 1, _ymax - _ymin + 1));
+}
+
+/**
+ * \brief x coordinate of the flux weighted centroid
+ *
+ * If the flux is not positive, the center of the bounding box is used.
+ */
+double	ComponentStatistics::xcentroid() const {
+	if (_flux > 0) {
+		return _xmoment / _flux;
+	}
+	return (_xmin + _xmax) / 2.;
+}
+
+double	ComponentStatistics::ycentroid() const {
+	if (_flux > 0) {
+		return _ymoment / _flux;
+	}
+	return (_ymin + _ymax) / 2.;
+}
+
+std::string	ComponentStatistics::toString() const {
+	return stringprintf("area=%lu, box=%s, flux=%.1f, "
+		"centroid=(%.2f,%.2f), peak=%.1f at %s", _area,
+		boundingbox().toString().c_str(), _flux, xcentroid(),
+		ycentroid(), _peak, _peakpoint.toString().c_str());
+}
+
+/**
+ * \brief Construct a labeler
+ *
+ * \param eightconnected	whether diagonal neighbours are connected,
+ *				by default only the four direct neighbours are
+ */
+ComponentLabeler::ComponentLabeler(bool eightconnected)
+	: _eightconnected(eightconnected) {
+}
+
+/**
+ * \brief Prepare the label image and the strips for the first pass
+ */
+void	ComponentLabeler::begin(const ImageSize& size) {
+	_size = size;
+	_labels.assign(size.getPixels(), 0);
+	_components.clear();
+	_strips.clear();
+	for (int y = 0; y < _size.height(); y += striprows) {
+		Strip	strip;
+		strip.ymin = y;
+		strip.ymax = std::min(y + striprows, _size.height());
+		// label 0 is the background
+		strip.parent.push_back(0);
+		strip.statistics.push_back(ComponentStatistics());
+		_strips.push_back(strip);
+	}
+}
+
+/**
+ * \brief Assign provisional labels to a row of a strip
+ *
+ * A pixel takes the label of its left or upper neighbours, if they
+ * have different labels, the two labels are recorded as equivalent.
+ * The rows above the strip are not looked at, they are only joined
+ * to the strip in the end() method.
+ */
+void	ComponentLabeler::labelrow(Strip& strip, int y, const double *values,
+		double threshold) {
+	int	width = _size.width();
+	unsigned int	*current = &_labels[(size_t)y * width];
+	const unsigned int	*previous = (y > strip.ymin)
+					? current - width : NULL;
+	for (int x = 0; x < width; x++) {
+		double	v = values[x];
+		if (!(v >= threshold)) {
+			continue;
+		}
+		unsigned int	l = (x > 0) ? current[x - 1] : 0;
+		if (previous) {
+			unsigned int	u = previous[x];
+			if (_eightconnected) {
+				if ((0 == u) && (x > 0)) {
+					u = previous[x - 1];
+				}
+				if ((x < width - 1) && (previous[x + 1])) {
+					if (u) {
+						u = unite(strip.parent, u,
+							previous[x + 1]);
+					} else {
+						u = previous[x + 1];
+					}
+				}
+			}
+			if (u) {
+				l = (l && (l != u)) ? unite(strip.parent, l, u)
+					: u;
+			}
+		}
+		if (0 == l) {
+			l = strip.parent.size();
+			strip.parent.push_back(l);
+			strip.statistics.push_back(ComponentStatistics());
+		}
+		current[x] = l;
+		strip.statistics[l].add(x, y, v);
+	}
+}
+
+/**
+ * \brief Join the strips and assign the final labels
+ */
+void	ComponentLabeler::end() {
+	int	width = _size.width();
+	int	nstrips = _strips.size();
+
+	// combine the provisional labels of all strips into a single
+	// union find structure
+	std::vector<unsigned int>	base(nstrips);
+	std::vector<unsigned int>	parent(1, 0);
+	for (int s = 0; s < nstrips; s++) {
+		base[s] = parent.size() - 1;
+		const std::vector<unsigned int>&	p = _strips[s].parent;
+		for (size_t l = 1; l < p.size(); l++) {
+			parent.push_back(base[s] + p[l]);
+		}
+	}
+
+	// join components that touch across a strip boundary
+	for (int s = 1; s < nstrips; s++) {
+		int	y = _strips[s].ymin;
+		const unsigned int	*current = &_labels[(size_t)y * width];
+		const unsigned int	*previous = current - width;
+		for (int x = 0; x < width; x++) {
+			if (0 == current[x]) {
+				continue;
+			}
+			unsigned int	l = base[s] + current[x];
+			int	xmin = (_eightconnected && (x > 0)) ? x - 1 : x;
+			int	xmax = (_eightconnected && (x < width - 1))
+					? x + 1 : x;
+			for (int xx = xmin; xx <= xmax; xx++) {
+				if (previous[xx]) {
+					unite(parent, l,
+						base[s - 1] + previous[xx]);
+				}
+			}
+		}
+	}
+
+	// number the roots in ascending order and collect the statistics,
+	// roots are always smaller than the labels of their sets, so
+	// they are numbered before any of their members
+	std::vector<unsigned int>	final(parent.size(), 0);
+	for (int s = 0; s < nstrips; s++) {
+		const std::vector<ComponentStatistics>&	statistics
+			= _strips[s].statistics;
+		for (size_t l = 1; l < statistics.size(); l++) {
+			unsigned int	g = base[s] + l;
+			unsigned int	r = root(parent, g);
+			if (r == g) {
+				_components.push_back(ComponentStatistics());
+				final[g] = _components.size();
+			} else {
+				final[g] = final[r];
+			}
+			_components[final[g] - 1].add(statistics[l]);
+		}
+	}
+
+	// second pass: replace provisional labels by final labels
+#pragma omp parallel for schedule(dynamic)
+	for (int s = 0; s < nstrips; s++) {
+		unsigned int	*p = &_labels[(size_t)_strips[s].ymin * width];
+		unsigned int	*e = &_labels[(size_t)_strips[s].ymax * width];
+		for (; p < e; p++) {
+			if (*p) {
+				*p = final[base[s] + *p];
+			}
+		}
+	}
+	_strips.clear();
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%u components in %s image",
+		ncomponents(), _size.toString().c_str());
+}
+
+/**
+ * \brief Get the statistics of a component
+ *
+ * \param label		the label of the component, starting at 1
+ */
+const ComponentStatistics&	ComponentLabeler::component(
+					unsigned int label) const {
+	if ((label < 1) || (label > _components.size())) {
+		std::string	msg = stringprintf("no component with label %u",
+			label);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::range_error(msg);
+	}
+	return _components[label - 1];
+}
+
+/**
+ * \brief Write the mask of a component into an image
+ *
+ * Pixels of the component are set to 255, all other pixels of the
+ * labeled area are set to 0.
+ *
+ * \param label		the label of the component
+ * \param image		the image to write the mask to
+ * \param origin	position of the labeled area inside the image
+ */
+void	ComponentLabeler::mask(unsigned int label,
+		ImageAdapter<unsigned char>& image,
+		const ImagePoint& origin) const {
+	int	width = _size.width();
+	int	height = _size.height();
+	int	x0 = origin.x();
+	int	y0 = origin.y();
+	for (int y = 0; y < height; y++) {
+		const unsigned int	*l = &_labels[(size_t)y * width];
+		for (int x = 0; x < width; x++) {
+			image.writablepixel(x0 + x, y0 + y)
+				= ((label) && (l[x] == label)) ? 255 : 0;
+		}
+	}
+}
+
+/**
+ * \brief Get the points of a component
+ *
+ * Only the bounding box of the component has to be scanned for this.
+ */
+std::list<ImagePoint>	ComponentLabeler::points(unsigned int label) const {
+	std::list<ImagePoint>	result;
+	if (0 == label) {
+		return result;
+	}
+	ImageRectangle	box = component(label).boundingbox();
+	for (int x = box.xmin(); x < box.xmax(); x++) {
+		for (int y = box.ymin(); y < box.ymax(); y++) {
+			if (label == this->label(x, y)) {
+				result.push_back(ImagePoint(x, y));
+			}
+		}
+	}
+	return result;
+}
+
+} // namespace image
+} // namespace astro
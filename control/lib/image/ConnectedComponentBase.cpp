@@ -5,6 +5,7 @@
  */
 #include <AstroImage.h>
 #include <AstroDebug.h>
+#include <AstroAdapter.h>
 
 namespace astro {
 namespace image {
@@ -50,100 +51,6 @@ void	ConnectedComponentBase::setupRoi(const ImageRectangle& rectangle) {
 	}
 }
 
-/**
- * \brief Grow the connected component around a point
- *
- * \param image		the connected comopnent image to grow
- * \param x		the x coordinate of the point to grow
- * \param y		the y coordinate of the poitn to grow
- */
-unsigned char	ConnectedComponentBase::growpixel(ImageAdapter<unsigned char>& image,
-			int x, int y) const {
-	unsigned char	v = image.pixel(x, y);
-	if (v == 0) {
-		return 0;
-	}
-	if (v == 255) {
-		return 255;
-	}
-	// left neighbor
-	if (x > _roi.xmin()) {
-		if (image.pixel(x - 1, y) == 255) {
-			return 255;
-		}
-	}
-	// bottom neighbor
-	if (y > _roi.ymin()) {
-		if (image.pixel(x, y - 1) == 255) {
-			return 255;
-		}
-	}
-	// right neighbor
-	if (x < _roi.xmax() - 1) {
-		if (image.pixel(x + 1, y) == 255) {
-			return 255;
-		}
-	}
-	// top neighbor
-	if (y < _roi.ymax() - 1) {
-		if (image.pixel(x, y + 1) == 255) {
-			return 255;
-		}
-	}
-	return v;
-}
-
-/**
- * \brief Grow the connected component
- *
- * \param image	image to grow the connected component
- */
-int	ConnectedComponentBase::grow(ImageAdapter<unsigned char>& image) const {
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "growing in %s image in roi %s",
-		image.getSize().toString().c_str(), _roi.toString().c_str());
-
-	// get the region of interest boundaries
-	int	xmin = _roi.xmin();
-	int	ymin = _roi.ymin();
-	int	xmax = _roi.xmax();
-	int	ymax = _roi.ymax();
-
-	// forward check
-	int	counter_forward = 0;
-	for (int y = ymin; y < ymax; y++) {
-		for (int x = ymin; x < xmax; x++) {
-			if (image.pixel(x, y) == 255) {
-				continue;
-			}
-			if (255 == growpixel(image, x, y)) {
-				image.writablepixel(x, y) = 255;
-				counter_forward++;
-			}
-		}
-	}
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "forward gave %d new points",
-		counter_forward);
-
-	// backward check
-	int	counter_backward = 0;
-	for (int y = ymax - 1; y >= ymin; y--) {
-		for (int x = xmax - 1; x >= xmin; x--) {
-			if (image.pixel(x, y) == 255) {
-				continue;
-			}
-			if (255 == growpixel(image, x, y)) {
-				image.writablepixel(x, y) = 255;
-				counter_backward++;
-			}
-		}
-	}
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "backward gave %d new points",
-		counter_backward);
-
-	// return the number of new pixels in this round
-	return counter_forward + counter_backward;
-}
-
 /**
  * \brief compute the connected component of the argument image
  *
@@ -181,62 +88,24 @@ WindowedImage<unsigned char>	*ConnectedComponentBase::component(
 		throw std::runtime_error(msg);
 	}
 
-	// create a new image
-	WindowedImage<unsigned char>	*connected
-		= new WindowedImage<unsigned char>(image.getSize(), _roi);
-	// XXX connected->fill(0);
-
-	// create the region of interest
-	int	xmin = _roi.xmin();
-	int	ymin = _roi.ymin();
-	int	xmax = _roi.xmax();
-	int	ymax = _roi.ymax();
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "[%d,%d] x [%d,%d]",
-		xmin, xmax, ymin, ymax);
-
-	// convert pixel values to 0/1
-	unsigned int	counter = 0;
-	for (int x = xmin; x < xmax; x++) {
-		for (int y = ymin; y < ymax; y++) {
-			connected->writablepixel(x, y)
-				= (image.pixel(x, y) > 0) ? 1 : 0;
-			counter += connected->pixel(x, y);
-		}
-	}
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "%u candidate pixels", counter);
-
-	// special case: if the point is set, then we can grow the
-	// connected component from it
-	int	componentpixels = 0;
-	if (connected->ConstImageAdapter<unsigned char>::pixel(_point) > 0) {
-		connected->ImageAdapter<unsigned char>::writablepixel(_point)
-			= 255;
-		componentpixels = 1;
-		int	newpixels = 0;
-		do {
-			newpixels = grow(*connected);
-			componentpixels += newpixels;
-			debug(LOG_DEBUG, DEBUG_LOG, 0,
-				"added %d new pixels (now %d)",
-				newpixels, componentpixels);
-		} while (newpixels > 0);
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "no new pixels added, total %d",
-			componentpixels);
+	// label the components inside the roi, the point belongs to
+	// at most one of them
+	adapter::WindowAdapter<unsigned char>	window(image, _roi);
+	ComponentLabeler	labeler;
+	labeler(window, 1);
+	unsigned int	label = labeler.label(_point - _roi.origin());
+	if (label) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "component: %s",
+			labeler.component(label).toString().c_str());
 	} else {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "point %s is not accepted",
 			_point.toString().c_str());
 	}
 
-	// everything that is not marked so far has to be turned off
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "turn off pixels outside component");
-	for (int x = xmin; x < xmax; x++) {
-		for (int y = ymin; y < ymax; y++) {
-			if (connected->pixel(x, y) < 255)
-				connected->writablepixel(x, y) = 0;
-		}
-	}
-	
-	// done
+	// create a new image containing only the component of the point
+	WindowedImage<unsigned char>	*connected
+		= new WindowedImage<unsigned char>(image.getSize(), _roi);
+	labeler.mask(label, *connected, _roi.origin());
 	return connected;
 }
 
@@ -45,9 +45,17 @@ static void	dark_correct(Image<ImagePixelType>& image,
 	// correct all pixels
 	int	bad_imagepixel_counter = 0;
 	int	bad_darkpixel_counter = 0;
-	for (int x = 0; x < image.size().width(); x++) {
-		for (int y = 0; y < image.size().height(); y++) {
-			ImagePixelType	ip = image.pixel(x, y);
+	int	w = image.size().width();
+	int	h = image.size().height();
+#pragma omp parallel reduction(+:bad_imagepixel_counter,bad_darkpixel_counter)
+	{
+	std::vector<DarkPixelType>	darkrow(w);
+#pragma omp for schedule(static)
+	for (int y = 0; y < h; y++) {
+		dark.readrow(y, 0, w, darkrow.data());
+		ImagePixelType	*row = image.pixels + image.pixeloffset(0, y);
+		for (int x = 0; x < w; x++) {
+			ImagePixelType	ip = row[x];
 
 			// skip NaN pixels, as we cannot do anything about them
 			if (ip != ip) {
@@ -55,7 +63,7 @@ static void	dark_correct(Image<ImagePixelType>& image,
 				continue;
 			}
 
-			DarkPixelType	dp = dark.pixel(x, y);
+			DarkPixelType	dp = darkrow[x];
 			// turn off (make nan) pixels that are marked nan
 			// in the dark
 			if (dp != dp) {
@@ -71,9 +79,10 @@ static void	dark_correct(Image<ImagePixelType>& image,
 					ip = 0;
 				}
 			}
-			image.pixel(x, y) = ip;
+			row[x] = ip;
 		}
 	}
+	}
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "bad pixels: image %d, dark %d",
 		bad_imagepixel_counter, bad_darkpixel_counter);
 }
@@ -0,0 +1,123 @@
+/*
+ * DarkFrameBuilder.cpp -- build dark frames one image at a time
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroCalibration.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <AstroIO.h>
+#include <stdexcept>
+#include "ImageMean.h"
+#include "ImageAccumulator.h"
+
+using namespace astro::image;
+
+namespace astro {
+namespace calibration {
+
+/**
+ * \brief Construct a dark frame builder
+ *
+ * \param factory	the factory providing the bad pixel parameters
+ * \param robust	whether to reject outliers like the factory does
+ */
+DarkFrameBuilder::DarkFrameBuilder(const DarkFrameFactory& factory,
+	bool robust) : _factory(factory), _robust(robust) {
+}
+
+/**
+ * \brief Set the robust flag, this is only possible before adding images
+ */
+void	DarkFrameBuilder::robust(bool r) {
+	if (_accumulator) {
+		throw std::logic_error("cannot change mode after first image");
+	}
+	_robust = r;
+}
+
+/**
+ * \brief Add an image
+ *
+ * The first image decides about the pixel type of the dark image, like
+ * in the DarkFrameFactory. Only the metadata of the first image is kept.
+ */
+void	DarkFrameBuilder::add(ImagePtr image) {
+	if (!_accumulator) {
+		unsigned int	floatlimit = std::numeric_limits<float>::digits;
+		if (image->bitsPerPlane() <= floatlimit) {
+			_accumulator = ImageAccumulatorPtr(
+				new ImageAccumulator<float>(image->size(),
+					_robust));
+		} else {
+			_accumulator = ImageAccumulatorPtr(
+				new ImageAccumulator<double>(image->size(),
+					_robust));
+		}
+		_first = ImagePtr(new ImageBase(*image));
+	}
+	_accumulator->add(image);
+}
+
+/**
+ * \brief Number of images added so far
+ */
+size_t	DarkFrameBuilder::count() const {
+	return (_accumulator) ? _accumulator->count() : 0;
+}
+
+/**
+ * \brief Compute the mean and variance from an accumulator
+ *
+ * The mean image gets the mosaic type and filter of the first image,
+ * as ImageMean would set them.
+ */
+template<typename T>
+static void	meanvariance(ImageAccumulator<T>& accumulator, ImagePtr first,
+			ImagePtr& meanimage, ImagePtr& varianceimage) {
+	accumulator.result(meanimage, varianceimage);
+	meanimage->setMosaicType(first->getMosaicType());
+	if (first->hasMetadata("FILTER")) {
+		meanimage->setMetadata(first->getMetadata("FILTER"));
+	}
+}
+
+/**
+ * \brief Compute the dark image from the images added so far
+ */
+ImagePtr	DarkFrameBuilder::operator()() {
+	if (0 == count()) {
+		debug(LOG_ERR, DEBUG_LOG, 0,
+			"cannot create dark from no images");
+		throw std::runtime_error("no images added to dark builder");
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "building dark from %d images",
+		count());
+	bool	gridded = _first->getMosaicType().isMosaic();
+	ImagePtr	meanimage;
+	ImagePtr	varianceimage;
+	ImagePtr	result;
+	ImageAccumulator<float>	*floataccumulator
+		= dynamic_cast<ImageAccumulator<float> *>(&*_accumulator);
+	if (floataccumulator) {
+		meanvariance(*floataccumulator, _first, meanimage,
+			varianceimage);
+		ImageMean<float>	im(meanimage, varianceimage);
+		result = _factory.dark<float>(im, gridded);
+	} else {
+		ImageAccumulator<double>	*doubleaccumulator
+			= dynamic_cast<ImageAccumulator<double> *>(
+				&*_accumulator);
+		meanvariance(*doubleaccumulator, _first, meanimage,
+			varianceimage);
+		ImageMean<double>	im(meanimage, varianceimage);
+		result = _factory.dark<double>(im, gridded);
+	}
+
+	// copy the metadata
+	_factory.copyMetadata(result, _first, count(), "dark");
+	return result;
+}
+
+} // calibration
+} // astro
@@ -155,20 +155,7 @@ template<typename DarkPixelType>
 ImagePtr	DarkFrameFactory::dark(const ImageSequence& images) const {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "plain dark processing");
 	ImageMean<DarkPixelType>	im(images, true);
-	size_t	badpixels = subdark<DarkPixelType>(im, Subgrid());
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "total bad pixels: %d", badpixels);
-	
-	// that's it, we now have a dark image
-	ImagePtr	darkimg = im.getImagePtr();
-
-	// set some common metadata about bad pixels
-	darkimg->setMetadata(FITSKeywords::meta("BADPIXEL", (long)badpixels));
-	darkimg->setMetadata(FITSKeywords::meta("BDPXLLIM",
-		(double)badpixellimitstddevs()));
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "plain dark image creation completed");
-
-	// return the dark image
-	return darkimg;
+	return dark<DarkPixelType>(im, false);
 }
 
 template
@@ -203,30 +190,64 @@ ImagePtr	DarkFrameFactory::dark(const ImageSequence& images,
 
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "gridded dark processing");
 	ImageMean<DarkPixelType>	im(images, true);
-	// perform the dark computation for each individual subgrid
+	return dark<DarkPixelType>(im, true);
+}
+
+template
+ImagePtr	DarkFrameFactory::dark<float>(const ImageSequence& images,
+			bool gridded) const;
+template
+ImagePtr	DarkFrameFactory::dark<double>(const ImageSequence& images,
+			bool gridded) const;
+
+/**
+ * \brief Construct the dark image from pixel mean and variance
+ *
+ * This is the part of the dark construction common to image sequences
+ * and to the DarkFrameBuilder: bad pixel detection, either on the
+ * complete image or separately on each of the four 2x2 subgrids.
+ *
+ * \param im		mean and variance of the images
+ * \param gridded	whether or not to use 2x2 subgrids
+ */
+template<typename DarkPixelType>
+ImagePtr	DarkFrameFactory::dark(ImageMean<DarkPixelType>& im,
+			bool gridded) const {
 	size_t	badpixels = 0;
-	ImageSize	step(2, 2);
-	badpixels += subdark<DarkPixelType>(im,
-			Subgrid(ImagePoint(0, 0), step));
-	badpixels += subdark<DarkPixelType>(im,
-			Subgrid(ImagePoint(1, 0), step));
-	badpixels += subdark<DarkPixelType>(im,
-			Subgrid(ImagePoint(0, 1), step));
-	badpixels += subdark<DarkPixelType>(im,
-			Subgrid(ImagePoint(1, 1), step));
+	if (gridded) {
+		// perform the dark computation for each individual subgrid
+		ImageSize	step(2, 2);
+		badpixels += subdark<DarkPixelType>(im,
+				Subgrid(ImagePoint(0, 0), step));
+		badpixels += subdark<DarkPixelType>(im,
+				Subgrid(ImagePoint(1, 0), step));
+		badpixels += subdark<DarkPixelType>(im,
+				Subgrid(ImagePoint(0, 1), step));
+		badpixels += subdark<DarkPixelType>(im,
+				Subgrid(ImagePoint(1, 1), step));
+	} else {
+		badpixels = subdark<DarkPixelType>(im, Subgrid());
+	}
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "total bad pixels: %d", badpixels);
+
+	// that's it, we now have a dark image
 	ImagePtr	darkimg = im.getImagePtr();
+
+	// set some common metadata about bad pixels
 	darkimg->setMetadata(FITSKeywords::meta("BADPIXEL", (long)badpixels));
 	darkimg->setMetadata(FITSKeywords::meta("BDPXLLIM",
 		(double)badpixellimitstddevs()));
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "dark image creation completed");
+
+	// return the dark image
 	return darkimg;
 }
 
 template
-ImagePtr	DarkFrameFactory::dark<float>(const ImageSequence& images,
+ImagePtr	DarkFrameFactory::dark<float>(ImageMean<float>& im,
 			bool gridded) const;
 template
-ImagePtr	DarkFrameFactory::dark<double>(const ImageSequence& images,
+ImagePtr	DarkFrameFactory::dark<double>(ImageMean<double>& im,
 			bool gridded) const;
 
 /**
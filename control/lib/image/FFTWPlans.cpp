@@ -0,0 +1,216 @@
+/*
+ * FFTWPlans.cpp -- process wide cache of FFTW plans
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroConvolve.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <includes.h>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <cstdlib>
+
+namespace astro {
+namespace image {
+
+// n0, n1, direction, alignment of input and output array
+typedef std::tuple<int, int, int, int, int>	plankey_t;
+typedef std::map<plankey_t, fftw_plan>	planmap_t;
+
+static std::recursive_mutex	plan_mutex;
+static planmap_t	plans;
+static bool	plans_initialized = false;
+static bool	plans_measure = false;
+static int	plans_threads = 1;
+static std::string	plans_wisdom;
+static bool	plans_unsaved = false;
+
+/**
+ * \brief Save the wisdom when the process exits
+ */
+static void	save_at_exit() {
+	try {
+		FFTWPlans::save();
+	} catch (...) {
+	}
+}
+
+/**
+ * \brief Initialize FFTW threads before the first plan
+ *
+ * Must be called with the plan mutex held.
+ */
+static void	setup() {
+	if (plans_initialized) {
+		return;
+	}
+	plans_initialized = true;
+#ifdef HAVE_LIBFFTW3_THREADS
+	fftw_init_threads();
+#endif /* HAVE_LIBFFTW3_THREADS */
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "FFTW plans: %s, %d threads",
+		(plans_measure) ? "measure" : "estimate", plans_threads);
+}
+
+/**
+ * \brief Get the plan for a transform, creating it if necessary
+ *
+ * Plans are created on scratch arrays, because FFTW_MEASURE overwrites
+ * the arrays during planning. If the arrays of the caller do not have
+ * the SIMD alignment FFTW prefers, an unaligned plan is created.
+ */
+static fftw_plan	getplan(FFTWPlans::direction_type direction,
+				const ImageSize& size, void *in, void *out) {
+	int	n0 = size.height();
+	int	n1 = size.width();
+	int	ain = fftw_alignment_of((double *)in);
+	int	aout = fftw_alignment_of((double *)out);
+	plankey_t	key(n0, n1, direction, ain, aout);
+
+	std::unique_lock<std::recursive_mutex>	lock(plan_mutex);
+	planmap_t::iterator	i = plans.find(key);
+	if (i != plans.end()) {
+		return i->second;
+	}
+	setup();
+
+	// create the plan
+	unsigned int	flags = (plans_measure) ? FFTW_MEASURE : FFTW_ESTIMATE;
+	if ((ain != 0) || (aout != 0)) {
+		flags |= FFTW_UNALIGNED;
+	}
+#ifdef HAVE_LIBFFTW3_THREADS
+	fftw_plan_with_nthreads(plans_threads);
+#endif /* HAVE_LIBFFTW3_THREADS */
+	size_t	nc = n0 * (1 + n1 / 2);
+	double	*real = fftw_alloc_real(size.getPixels());
+	fftw_complex	*complex = fftw_alloc_complex(nc);
+	fftw_plan	plan = NULL;
+	switch (direction) {
+	case FFTWPlans::R2C:
+		plan = fftw_plan_dft_r2c_2d(n0, n1, real, complex, flags);
+		break;
+	case FFTWPlans::C2R:
+		plan = fftw_plan_dft_c2r_2d(n0, n1, complex, real, flags);
+		break;
+	}
+	fftw_free(real);
+	fftw_free(complex);
+	if (NULL == plan) {
+		std::string	msg = stringprintf("cannot plan %s transform "
+			"for %s", (direction == FFTWPlans::R2C) ? "r2c" : "c2r",
+			size.toString().c_str());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	plans.insert(std::make_pair(key, plan));
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "new %s plan for %s, %d plans cached",
+		(direction == FFTWPlans::R2C) ? "r2c" : "c2r",
+		size.toString().c_str(), plans.size());
+
+	// measured plans are worth remembering for the next process
+	if (plans_measure) {
+		plans_unsaved = true;
+	}
+	return plan;
+}
+
+/**
+ * \brief Real to complex transform of an image of the given size
+ *
+ * \param size	size of the real image, the complex array must have room
+ *		for size.height() * (size.width() / 2 + 1) values
+ */
+void	FFTWPlans::r2c(const ImageSize& size, double *in, fftw_complex *out) {
+	fftw_plan	plan = getplan(R2C, size, in, out);
+	fftw_execute_dft_r2c(plan, in, out);
+}
+
+/**
+ * \brief Complex to real transform producing an image of the given size
+ */
+void	FFTWPlans::c2r(const ImageSize& size, fftw_complex *in, double *out) {
+	fftw_plan	plan = getplan(C2R, size, in, out);
+	fftw_execute_dft_c2r(plan, in, out);
+}
+
+/**
+ * \brief Plan with FFTW_MEASURE instead of FFTW_ESTIMATE
+ */
+void	FFTWPlans::measure(bool m) {
+	std::unique_lock<std::recursive_mutex>	lock(plan_mutex);
+	if (m != plans_measure) {
+		clear();
+		plans_measure = m;
+	}
+}
+
+/**
+ * \brief Set the number of threads FFTW uses for a transform
+ */
+void	FFTWPlans::threads(int n) {
+	std::unique_lock<std::recursive_mutex>	lock(plan_mutex);
+	if (n < 1) {
+		n = 1;
+	}
+	if (n != plans_threads) {
+		clear();
+		plans_threads = n;
+	}
+}
+
+/**
+ * \brief Load wisdom from a file and remember it for save()
+ *
+ * The wisdom is saved to the same file when the process exits.
+ */
+void	FFTWPlans::wisdom(const std::string& filename) {
+	std::unique_lock<std::recursive_mutex>	lock(plan_mutex);
+	if (plans_wisdom.size() == 0) {
+		std::atexit(save_at_exit);
+	}
+	plans_wisdom = filename;
+	if (fftw_import_wisdom_from_filename(plans_wisdom.c_str())) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "FFTW wisdom loaded from %s",
+			plans_wisdom.c_str());
+	}
+}
+
+/**
+ * \brief Save the wisdom of plans measured since the last save
+ */
+void	FFTWPlans::save() {
+	std::unique_lock<std::recursive_mutex>	lock(plan_mutex);
+	if ((!plans_unsaved) || (plans_wisdom.size() == 0)) {
+		return;
+	}
+	if (!fftw_export_wisdom_to_filename(plans_wisdom.c_str())) {
+		std::string	msg = stringprintf("cannot save FFTW wisdom "
+			"to %s", plans_wisdom.c_str());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	plans_unsaved = false;
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "FFTW wisdom saved to %s",
+		plans_wisdom.c_str());
+}
+
+/**
+ * \brief Destroy all cached plans
+ *
+ * No transform may be running while the plans are destroyed.
+ */
+void	FFTWPlans::clear() {
+	std::unique_lock<std::recursive_mutex>	lock(plan_mutex);
+	planmap_t::iterator	i;
+	for (i = plans.begin(); i != plans.end(); i++) {
+		fftw_destroy_plan(i->second);
+	}
+	plans.clear();
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "FFTW plan cache cleared");
+}
+
+} // namespace image
+} // namespace astro
@@ -65,59 +65,19 @@ size_t	FITS::writeFITS(ImagePtr image, const std::string& filename) {
 /**
  * \brief Write an image to a buffer
  *
- * This is done by first writing the image to a temporary file (which is 
- * supported by the FITS library) and then reading the file as a raw file
- * back from the temporary file.
+ * The image is written to a cfitsio memory file, so no temporary file
+ * is needed. The buffer is allocated with malloc and must be freed by
+ * the caller.
  *
  * \param image		the image to write
  * \param buffer	the pointer to the buffer
  * \param buffersize	the size of the buffer
  */
 size_t	FITS::writeFITS(ImagePtr image, void **buffer, size_t *buffersize) {
-	// create a filename
-	char	filename[1024];
-	char	*tmpdir = getenv("TMPDIR");
-	if (tmpdir) {
-		snprintf(filename, sizeof(filename), "%s/XXXXXX.fits", tmpdir);
-	} else {
-		strcpy(filename, "/var/tmp/XXXXXX.fits");
-	}
-	int	fd = mkstemps(filename, 5);
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "filename created: %s", filename);
-	close(fd);	// prevent a file descriptor leak
-
-	// write the image to the temporary file
-	ssize_t	s = write(image, std::string(filename));
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "%lu bytes written", s);
-
-	// prepare a buffer
-	unsigned char	*b = (unsigned char *)malloc(s);
-	if (NULL == b) {
-		std::string	msg = stringprintf("cannot allocate: %s",
-			strerror(errno));
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s", msg.c_str());
-		unlink(filename);
-		throw std::runtime_error(msg);
-	}
-
-	// read the data 
-	fd = open(filename, O_RDONLY);
-	if (s != ::read(fd, b, s)) {
-		std::string	msg = stringprintf("cannot read %s: %s",
-			filename, strerror(errno));
-		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
-		close(fd);
-		throw std::runtime_error(msg);
-	}
-
-	// cleanup
-	close(fd);
-	unlink(filename);
-
-	// copy the data
-	*buffer = b;
-	*buffersize = s;
-	return s;
+	io::FITSout	out(buffer, buffersize);
+	out.write(image);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%lu bytes written", *buffersize);
+	return *buffersize;
 }
 
 /**
@@ -141,44 +101,8 @@ ImagePtr	FITS::readFITS(const std::string& filename) {
  * \param buffersize	size of the buffer to read
  */
 ImagePtr	FITS::readFITS(void *buffer, size_t buffersize) {
-	char	filename[1024];
-	if (getenv("TMPDIR")) {
-		snprintf(filename, sizeof(filename), "%s/tempXXXXXX.fits",
-			getenv("TMPDIR"));
-	} else {
-		strcpy(filename, "/tmp/tempXXXXXX.fits");
-	}
-
-	// open the temporary file
-	int	fd = mkstemps(filename, 5);
-	if (fd < 0) {
-		std::string	msg = stringprintf("cannot create %s: %s",
-			filename, strerror(errno));
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s", msg.c_str());
-		throw std::runtime_error(msg);
-	}
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "using temp file %s", filename);
-
-	// write the data to the file
-	ssize_t	rc = ::write(fd, buffer, buffersize);
-	if ((rc < 0) || (buffersize != (size_t)rc)) {
-		std::string	msg = stringprintf("cannot write %s: %s",
-			filename, strerror(errno));
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s", msg.c_str());
-		close(fd);
-		throw std::runtime_error(msg);
-	}
-	close(fd);
-
-	// read the image back from the file
-	io::FITSin	in(filename);
-	ImagePtr	image = in.read();
-
-	// unlink the file
-	unlink(filename);
-
-	// return the image
-	return image;
+	io::FITSin	in(buffer, buffersize);
+	return in.read();
 }
 
 } // namespace image
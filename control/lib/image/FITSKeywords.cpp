@@ -20,7 +20,7 @@ typedef struct {
 	bool	unique;
 } FITSKeyword;
 
-#define	Nkeywords	108
+#define	Nkeywords	112
 FITSKeyword	keywords[Nkeywords] = {
 // standard keywords
 { // 0
@@ -671,6 +671,30 @@ FITSKeyword	keywords[Nkeywords] = {
 	std::string("number of calibration subframes"),
 	std::type_index(typeid(long)),
 	true
+},
+{ // 108
+	std::string("CD1_1"),
+	std::string("coordinate transformation matrix element"),
+	std::type_index(typeid(double)),
+	true
+},
+{ // 109
+	std::string("CD1_2"),
+	std::string("coordinate transformation matrix element"),
+	std::type_index(typeid(double)),
+	true
+},
+{ // 110
+	std::string("CD2_1"),
+	std::string("coordinate transformation matrix element"),
+	std::type_index(typeid(double)),
+	true
+},
+{ // 111
+	std::string("CD2_2"),
+	std::string("coordinate transformation matrix element"),
+	std::type_index(typeid(double)),
+	true
 }
 };
 
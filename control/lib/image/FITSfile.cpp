@@ -121,6 +121,156 @@ ImageMetadata	FITSfile::getAllMetadata() const {
 	return meta;
 }
 
+/**
+ * \brief Write a metadata value to the header of the current HDU
+ *
+ * HISTORY and COMMENT entries are always appended, all other keywords
+ * are either written as new keys or, if update is set, replace an
+ * existing key of the same name in place.
+ *
+ * \param keyword	the keyword to write
+ * \param value		the value to write for the keyword
+ * \param update	whether to update an existing key
+ */
+void	FITSfile::writekey(const std::string& keyword, const Metavalue& value,
+		bool update) {
+	const char	*key = keyword.c_str();
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "writing '%s'",
+		value.toString().c_str());
+	const char	*comment = value.getComment().c_str();
+	std::type_index	type = value.getType();
+	int	status = 0;
+	int	rc = 0;
+	decltype(&fits_write_key)	writer
+		= (update) ? &fits_update_key : &fits_write_key;
+
+	if (type == std::type_index(typeid(bool))) {
+		int	logicalvalue = (bool)value;
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (bool)%s",
+			key, (logicalvalue) ? "true" : "false");
+		rc = writer(fptr, TLOGICAL, key, &logicalvalue,
+			comment, &status);
+		goto writedone;
+	}
+
+	if (type == std::type_index(typeid(std::string))) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (string)%s",
+			key, value.getValue().c_str());
+		rc = writer(fptr, TSTRING, key,
+			(void *)value.getValue().c_str(),
+			comment, &status);
+		goto writedone;
+	}
+
+	if (type == std::type_index(typeid(char))) {
+		char	charvalue = (char)value;
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (char)%d",
+			key, charvalue);
+		rc = writer(fptr, TBYTE, key, &charvalue,
+			comment, &status);
+		goto writedone;
+	}
+
+	if (type == std::type_index(typeid(short))) {
+		short	shortvalue = (short)value;
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (short)%d",
+			key, shortvalue);
+		rc = writer(fptr, TSHORT, key, &shortvalue,
+			comment, &status);
+		goto writedone;
+	}
+
+	if (type == std::type_index(typeid(unsigned short))) {
+		unsigned short	ushortvalue = (unsigned short)value;
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (ushort)%hu",
+			key, ushortvalue);
+		rc = writer(fptr, TUSHORT, key, &ushortvalue,
+			comment, &status);
+		goto writedone;
+	}
+
+	if (type == std::type_index(typeid(int))) {
+		int	intvalue = (int)value;
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (int)%d",
+			key, intvalue);
+		rc = writer(fptr, TINT, key, &intvalue,
+			comment, &status);
+		goto writedone;
+	}
+
+	if (type == std::type_index(typeid(unsigned int))) {
+		unsigned int	uintvalue = (unsigned int)value;
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (uint)%u",
+			key, uintvalue);
+		rc = writer(fptr, TUINT, key, &uintvalue,
+			comment, &status);
+		goto writedone;
+	}
+
+	if (type == std::type_index(typeid(long))) {
+		long	longvalue = (long)value;
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (long)%ld",
+			key, longvalue);
+		rc = writer(fptr, TLONG, key, &longvalue,
+			comment, &status);
+		goto writedone;
+	}
+
+	if (type == std::type_index(typeid(unsigned long))) {
+		unsigned long	ulongvalue = (unsigned long)value;
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (ulong)%lu",
+			key, ulongvalue);
+		rc = writer(fptr, TULONG, key, &ulongvalue,
+			comment, &status);
+		goto writedone;
+	}
+
+	if (type == std::type_index(typeid(float))) {
+		float	floatvalue = (float)value;
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (float)%f",
+			key, floatvalue);
+		rc = writer(fptr, TFLOAT, key, &floatvalue,
+			comment, &status);
+		goto writedone;
+	}
+
+	if (type == std::type_index(typeid(double))) {
+		double doublevalue = (double)value;
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (double)%f",
+			key, doublevalue);
+		rc = writer(fptr, TDOUBLE, key, &doublevalue,
+			comment, &status);
+		goto writedone;
+	}
+
+	if (type == std::type_index(typeid(FITSdate))) {
+		rc = writer(fptr, TSTRING, key,
+			(void *)((std::string)value).c_str(),
+			comment, &status);
+		goto writedone;
+	}
+
+	if (type == std::type_index(typeid(void))) {
+		if (key == std::string("HISTORY")) {
+			rc = fits_write_history(fptr, comment, &status);
+			debug(LOG_DEBUG, DEBUG_LOG, 0, "write HISTORY: %s, %d", comment, rc);
+		}
+		if (key == std::string("COMMENT")) {
+			rc = fits_write_comment(fptr, comment, &status);
+		}
+		goto writedone;
+	}
+
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "cannot write entry of type %s",
+		type.name());
+	return;
+
+writedone:
+	if (rc) {
+		throw FITSexception(errormsg(status), filename);
+	}
+}
+
 } // namespace io
 } // namespace astro
 
@@ -0,0 +1,229 @@
+/*
+ * FITSheader.cpp -- header only access to FITS files
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroIO.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <includes.h>
+#include <cerrno>
+#include <list>
+#include <mutex>
+
+namespace astro {
+namespace io {
+
+/**
+ * \brief Copy the header information from an open FITS file
+ */
+FITSheader::FITSheader(const FITSinfileBase& infile)
+	: _size(infile.getSize()), _pixeltype(infile.getPixeltype()),
+	  _planes(infile.getPlanes()), _imgtype(infile.getImgtype()),
+	  _metadata(infile.getAllMetadata()) {
+}
+
+/**
+ * \brief Number of bytes of a single value in a plane
+ */
+int	FITSheader::getBytesPerPlane() const {
+	switch (_imgtype) {
+	case BYTE_IMG:
+	case SBYTE_IMG:
+		return sizeof(unsigned char);
+	case USHORT_IMG:
+	case SHORT_IMG:
+		return sizeof(unsigned short);
+	case ULONG_IMG:
+	case LONG_IMG:
+		return sizeof(unsigned int);
+	case FLOAT_IMG:
+		return sizeof(float);
+	case DOUBLE_IMG:
+		return sizeof(double);
+	}
+	return 1;
+}
+
+/**
+ * \brief Pixel value type of the image in the file
+ */
+std::type_index	FITSheader::getPixelType() const {
+	switch (_imgtype) {
+	case BYTE_IMG:
+	case SBYTE_IMG:
+		return typeid(unsigned char);
+	case USHORT_IMG:
+	case SHORT_IMG:
+		return typeid(unsigned short);
+	case ULONG_IMG:
+	case LONG_IMG:
+		return typeid(unsigned int);
+	case FLOAT_IMG:
+		return typeid(float);
+	case DOUBLE_IMG:
+		return typeid(double);
+	}
+	throw std::runtime_error("pixel type not found");
+}
+
+bool	FITSheader::hasMetadata(const std::string& key) const {
+	return _metadata.hasMetadata(key);
+}
+
+Metavalue	FITSheader::getMetadata(const std::string& key) const {
+	return _metadata.getMetadata(key);
+}
+
+/**
+ * \brief Entry of the header cache
+ *
+ * The modification time, size and inode identify the version of the
+ * file the header was read from.
+ */
+typedef struct headercacheentry_s {
+	std::string	filename;
+	struct timespec	mtime;
+	off_t	size;
+	ino_t	inode;
+	FITSheaderPtr	header;
+} headercacheentry_t;
+
+typedef std::list<headercacheentry_t>	headercachelist;
+
+static std::mutex	headercache_mutex;
+static headercachelist	headercache;
+static std::map<std::string, headercachelist::iterator>	headercache_index;
+static size_t	headercache_capacity = 64;
+static unsigned long	headercache_hits = 0;
+static unsigned long	headercache_misses = 0;
+
+static bool	samefile(const headercacheentry_t& entry, const struct stat& sb) {
+	return (entry.mtime.tv_sec == sb.st_mtim.tv_sec)
+		&& (entry.mtime.tv_nsec == sb.st_mtim.tv_nsec)
+		&& (entry.size == sb.st_size)
+		&& (entry.inode == sb.st_ino);
+}
+
+/**
+ * \brief Remove the least recently used entries beyond the capacity
+ *
+ * The caller must hold the cache mutex.
+ */
+static void	trim_headercache() {
+	while (headercache.size() > headercache_capacity) {
+		headercache_index.erase(headercache.back().filename);
+		headercache.pop_back();
+	}
+}
+
+size_t	FITSheaderCache::capacity() {
+	std::unique_lock<std::mutex>	lock(headercache_mutex);
+	return headercache_capacity;
+}
+
+void	FITSheaderCache::capacity(size_t c) {
+	std::unique_lock<std::mutex>	lock(headercache_mutex);
+	headercache_capacity = c;
+	trim_headercache();
+}
+
+/**
+ * \brief Get the header of a file, read it only if necessary
+ *
+ * The file is read without holding the cache lock, so that headers of
+ * different files can be read concurrently.
+ *
+ * \param filename	name of the FITS file
+ */
+FITSheaderPtr	FITSheaderCache::get(const std::string& filename) {
+	struct stat	sb;
+	if (stat(filename.c_str(), &sb) < 0) {
+		std::string	cause = stringprintf("cannot stat: %s",
+			strerror(errno));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s: %s", filename.c_str(),
+			cause.c_str());
+		throw FITSexception(cause, filename);
+	}
+	{
+		std::unique_lock<std::mutex>	lock(headercache_mutex);
+		auto	i = headercache_index.find(filename);
+		if (i != headercache_index.end()) {
+			if (samefile(*i->second, sb)) {
+				headercache.splice(headercache.begin(),
+					headercache, i->second);
+				headercache_hits++;
+				return i->second->header;
+			}
+			debug(LOG_DEBUG, DEBUG_LOG, 0, "%s has changed",
+				filename.c_str());
+			headercache.erase(i->second);
+			headercache_index.erase(i);
+		}
+		headercache_misses++;
+	}
+
+	// read the header from the file
+	FITSheaderPtr	header;
+	{
+		FITSinfileBase	infile(filename);
+		header = FITSheaderPtr(new FITSheader(infile));
+	}
+
+	// add the header to the cache, unless another thread was faster
+	std::unique_lock<std::mutex>	lock(headercache_mutex);
+	if (headercache_index.find(filename) != headercache_index.end()) {
+		return header;
+	}
+	headercacheentry_t	entry;
+	entry.filename = filename;
+	entry.mtime = sb.st_mtim;
+	entry.size = sb.st_size;
+	entry.inode = sb.st_ino;
+	entry.header = header;
+	headercache.push_front(entry);
+	headercache_index[filename] = headercache.begin();
+	trim_headercache();
+	return header;
+}
+
+/**
+ * \brief Forget the header of a file
+ */
+void	FITSheaderCache::invalidate(const std::string& filename) {
+	std::unique_lock<std::mutex>	lock(headercache_mutex);
+	auto	i = headercache_index.find(filename);
+	if (i == headercache_index.end()) {
+		return;
+	}
+	headercache.erase(i->second);
+	headercache_index.erase(i);
+}
+
+void	FITSheaderCache::clear() {
+	std::unique_lock<std::mutex>	lock(headercache_mutex);
+	headercache.clear();
+	headercache_index.clear();
+}
+
+unsigned long	FITSheaderCache::hits() {
+	std::unique_lock<std::mutex>	lock(headercache_mutex);
+	return headercache_hits;
+}
+
+unsigned long	FITSheaderCache::misses() {
+	std::unique_lock<std::mutex>	lock(headercache_mutex);
+	return headercache_misses;
+}
+
+/**
+ * \brief Read the header of a file without the pixel data
+ *
+ * \param filename	name of the FITS file
+ */
+FITSheaderPtr	FITSinfileBase::header(const std::string& filename) {
+	return FITSheaderCache::get(filename);
+}
+
+} // namespace io
+} // namespace astro
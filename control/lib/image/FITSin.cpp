@@ -14,9 +14,36 @@ namespace io {
  *
  * \brief filename 	Name of the file to read
  */
-FITSin::FITSin(const std::string& _filename) : filename(_filename) {
+FITSin::FITSin(const std::string& _filename) : filename(_filename),
+	_buffer(NULL), _buffersize(0) {
 }
 
+/**
+ * \brief Construct a generic FITS reader for a memory buffer
+ *
+ * The buffer is not copied, it must remain valid until the read method
+ * has returned.
+ *
+ * \param buffer	memory buffer containing the FITS data
+ * \param buffersize	size of the memory buffer
+ */
+FITSin::FITSin(const void *buffer, size_t buffersize) : filename("memory"),
+	_buffer(buffer), _buffersize(buffersize) {
+}
+
+/**
+ * \brief Auxiliary class to describe where the FITS data comes from
+ */
+struct fitssource {
+	const std::string&	filename;
+	const void	*buffer;
+	size_t	buffersize;
+	fitssource(const std::string& _filename, const void *_buffer,
+		size_t _buffersize)
+		: filename(_filename), buffer(_buffer),
+		  buffersize(_buffersize) { }
+};
+
 /**
  * \brief Do the dirty work of the read
  *
@@ -25,9 +52,11 @@ FITSin::FITSin(const std::string& _filename) : filename(_filename) {
  * in a new ImagePtr and reset the old type specific pointer.
  */
 template<typename P>
-static ImagePtr	do_read(const std::string& filename) {
-	FITSinfile<P>	reader(filename);
-	Image<P>	*image = reader.read();
+static ImagePtr	do_read(const fitssource& source) {
+	std::shared_ptr<FITSinfile<P> >	reader((NULL != source.buffer)
+		? new FITSinfile<P>(source.buffer, source.buffersize)
+		: new FITSinfile<P>(source.filename));
+	Image<P>	*image = reader->read();
 	ImagePtr	result(image);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "result is an %d x %d image",
 		result->size().width(), result->size().height());
@@ -38,7 +67,11 @@ static ImagePtr	do_read(const std::string& filename) {
  * \brief Read a file.
  */
 ImagePtr	FITSin::read() {
-	FITSinfileBase	infile(filename);
+	std::shared_ptr<FITSinfileBase>	infileptr((NULL != _buffer)
+		? new FITSinfileBase(_buffer, _buffersize)
+		: new FITSinfileBase(filename));
+	FITSinfileBase&	infile = *infileptr;
+	fitssource	source(filename, _buffer, _buffersize);
 	ImagePtr	result;
 
 	// if the file has X/YORGSUBF information, apply it
@@ -70,30 +103,30 @@ ImagePtr	FITSin::read() {
 		case BYTE_IMG:
 		case SBYTE_IMG:
 			result = (xyz)
-				? do_read<XYZ<unsigned char> >(filename)
-				: do_read<RGB<unsigned char> >(filename);
+				? do_read<XYZ<unsigned char> >(source)
+				: do_read<RGB<unsigned char> >(source);
 			break;
 		case USHORT_IMG:
 		case SHORT_IMG:
 			result = (xyz)
-				? do_read<XYZ<unsigned short> >(filename)
-				: do_read<RGB<unsigned short> >(filename);
+				? do_read<XYZ<unsigned short> >(source)
+				: do_read<RGB<unsigned short> >(source);
 			break;
 		case ULONG_IMG:
 		case LONG_IMG:
 			result = (xyz)
-				? do_read<XYZ<unsigned int> >(filename)
-				: do_read<RGB<unsigned int> >(filename);
+				? do_read<XYZ<unsigned int> >(source)
+				: do_read<RGB<unsigned int> >(source);
 			break;
 		case FLOAT_IMG:
 			result = (xyz)
-				? do_read<XYZ<float> >(filename)
-				: do_read<RGB<float> >(filename);
+				? do_read<XYZ<float> >(source)
+				: do_read<RGB<float> >(source);
 			break;
 		case DOUBLE_IMG:
 			result = (xyz)
-				? do_read<XYZ<double> >(filename)
-				: do_read<RGB<double> >(filename);
+				? do_read<XYZ<double> >(source)
+				: do_read<RGB<double> >(source);
 			break;
 		}
 		result->setOrigin(origin);
@@ -106,21 +139,21 @@ ImagePtr	FITSin::read() {
 		switch (infile.getImgtype()) {				\
 		case BYTE_IMG:						\
 		case SBYTE_IMG:						\
-			result = do_read<Multiplane<unsigned char, n> >(filename);\
+			result = do_read<Multiplane<unsigned char, n> >(source);\
 			break;						\
 		case USHORT_IMG:					\
 		case SHORT_IMG:						\
-			result = do_read<Multiplane<unsigned short, n> >(filename);\
+			result = do_read<Multiplane<unsigned short, n> >(source);\
 			break;						\
 		case ULONG_IMG:						\
 		case LONG_IMG:						\
-			result = do_read<Multiplane<unsigned int, n> >(filename);\
+			result = do_read<Multiplane<unsigned int, n> >(source);\
 			break;						\
 		case FLOAT_IMG:						\
-			result = do_read<Multiplane<float, n> >(filename);\
+			result = do_read<Multiplane<float, n> >(source);\
 			break;						\
 		case DOUBLE_IMG:					\
-			result = do_read<Multiplane<double, n> >(filename);\
+			result = do_read<Multiplane<double, n> >(source);\
 			break;						\
 		}							\
 		result->setOrigin(origin);				\
@@ -138,21 +171,21 @@ ImagePtr	FITSin::read() {
 		switch (infile.getImgtype()) {
 		case BYTE_IMG:
 		case SBYTE_IMG:
-			result = do_read<unsigned char>(filename);
+			result = do_read<unsigned char>(source);
 			break;
 		case USHORT_IMG:
 		case SHORT_IMG:
-			result = do_read<unsigned short>(filename);
+			result = do_read<unsigned short>(source);
 			break;
 		case ULONG_IMG:
 		case LONG_IMG:
-			result = do_read<unsigned int>(filename);
+			result = do_read<unsigned int>(source);
 			break;
 		case FLOAT_IMG:
-			result = do_read<float>(filename);
+			result = do_read<float>(source);
 			break;
 		case DOUBLE_IMG:
-			result = do_read<double>(filename);
+			result = do_read<double>(source);
 			break;
 		}
 	}
@@ -20,13 +20,44 @@ namespace io {
  * \param filename	name of the file to read the image from
  */
 FITSinfileBase::FITSinfileBase(const std::string& filename)
-	: FITSfile(filename, 0, 0, 0) {
+	: FITSfile(filename, 0, 0, 0), _membuffer(NULL), _membuffersize(0) {
 	int	status = 0;
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "open FITS file '%s'",
 		filename.c_str());
 	if (fits_open_file(&fptr, filename.c_str(), READONLY, &status)) {
 		throw FITSexception(errormsg(status), filename);
 	}
+	setup();
+}
+
+/**
+ * \brief Open a FITS file contained in a memory buffer
+ *
+ * The buffer is not copied, so it has to remain valid as long as this
+ * object exists. This allows to decode FITS data received over the network
+ * without a round trip through a temporary file.
+ *
+ * \param buffer	the memory buffer containing the FITS data
+ * \param buffersize	the size of the buffer
+ */
+FITSinfileBase::FITSinfileBase(const void *buffer, size_t buffersize)
+	: FITSfile(std::string("memory"), 0, 0, 0),
+	  _membuffer(const_cast<void *>(buffer)), _membuffersize(buffersize) {
+	int	status = 0;
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "open FITS memory file of size %lu",
+		buffersize);
+	if (fits_open_memfile(&fptr, filename.c_str(), READONLY,
+		&_membuffer, &_membuffersize, 0, NULL, &status)) {
+		throw FITSexception(errormsg(status), filename);
+	}
+	setup();
+}
+
+/**
+ * \brief Read image parameters and headers common to all FITS files
+ */
+void	FITSinfileBase::setup() {
+	int	status = 0;
 
 	/* read the dimensions of the image from the file */
 	int	naxis;
@@ -11,10 +11,25 @@ using namespace astro::image;
 namespace astro {
 namespace io {
 
-FITSout::FITSout(const std::string& _filename) : filename(_filename) {
+FITSout::FITSout(const std::string& _filename) : filename(_filename),
+	_buffer(NULL), _buffersize(NULL) {
 	_precious = true;
 }
 
+/**
+ * \brief Construct a FITSout object that writes to memory
+ *
+ * After the write, *buffer points to a malloc()ed buffer containing
+ * the FITS data and *buffersize is the size of the FITS data. The
+ * caller is responsible to free the buffer.
+ */
+FITSout::FITSout(void **buffer, size_t *buffersize)
+	: filename("memory"), _buffer(buffer), _buffersize(buffersize) {
+	_precious = false;
+	*_buffer = NULL;
+	*_buffersize = 0;
+}
+
 /**
  * \brief Find out whether a file exists
  */
@@ -53,6 +68,37 @@ static bool	do_write(const std::string& filename, const ImagePtr image,
 	return true;
 }
 
+/**
+ * \brief Write an image with a given pixel type to a memory buffer
+ *
+ * The size of the buffer allocated by cfitsio may be larger than the
+ * FITS data, so the size is corrected to the size of the FITS data
+ * after the memory file has been closed.
+ */
+template<typename P>
+static bool	do_write(void **buffer, size_t *buffersize,
+			const ImagePtr image) {
+	Image<P>	*im = dynamic_cast<Image<P> *>(&*image);
+	if (NULL == im) {
+		return false;
+	}
+	size_t	filesize = 0;
+	try {
+		FITSoutfile<P>	outfile(buffer, buffersize);
+		outfile.write(*im);
+		filesize = outfile.filesize();
+	} catch (...) {
+		if (NULL != *buffer) {
+			free(*buffer);
+		}
+		*buffer = NULL;
+		*buffersize = 0;
+		throw;
+	}
+	*buffersize = filesize;
+	return true;
+}
+
 /**
  * \brief Write the image to the file
  *
@@ -61,7 +107,11 @@ static bool	do_write(const std::string& filename, const ImagePtr image,
 void	FITSout::write(const ImagePtr image) {
 	// test the various types, and call the do_write template 
 #define	do_write_typed(type)						\
-	if (do_write<type >(filename, image, precious())) {		\
+	if (NULL != _buffer) {						\
+		if (do_write<type >(_buffer, _buffersize, image)) {	\
+			return;						\
+		}							\
+	} else if (do_write<type >(filename, image, precious())) {	\
 		return;							\
 	}
 	do_write_typed(unsigned char)
@@ -93,7 +143,13 @@ void	FITSout::write(const ImagePtr image) {
 	do_write_typed(YUYV<double>)
 
 #define	do_write_multi(type, n)						\
-	if (do_write<Multiplane<type, n> >(filename, image, precious())) {\
+	if (NULL != _buffer) {						\
+		if (do_write<Multiplane<type, n> >(_buffer, _buffersize,\
+			image)) {					\
+			return;						\
+		}							\
+	} else if (do_write<Multiplane<type, n> >(filename, image,	\
+		precious())) {						\
 		return;							\
 	}
 	do_write_multi(unsigned char,  1)
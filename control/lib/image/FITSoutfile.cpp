@@ -19,14 +19,31 @@ namespace io {
  */
 FITSoutfileBase::FITSoutfileBase(const std::string &filename,
 	int pixeltype, int planes, int imgtype) 
-	: FITSfile(filename, pixeltype, planes, imgtype) {
+	: FITSfile(filename, pixeltype, planes, imgtype),
+	  _buffer(NULL), _buffersize(NULL) {
 	_precious = true;
 }
 
 /**
- * \brief write the image format information to the header
+ * \brief Create an in memory FITS file for writing
+ *
+ * \param buffer	pointer to the buffer pointer, the buffer is allocated
+ *			with malloc and belongs to the caller
+ * \param buffersize	pointer to the size of the buffer
  */
-void	FITSoutfileBase::write(const ImageBase& image) {
+FITSoutfileBase::FITSoutfileBase(void **buffer, size_t *buffersize,
+	int pixeltype, int planes, int imgtype) 
+	: FITSfile(std::string("memory"), pixeltype, planes, imgtype),
+	  _buffer(buffer), _buffersize(buffersize) {
+	_precious = false;
+	*_buffer = NULL;
+	*_buffersize = 0;
+}
+
+/**
+ * \brief Create the FITS file on disk
+ */
+void	FITSoutfileBase::create() {
 	// if the file exists but is not precious, and writable, unlink it
 	struct stat	sb;
 	int	rc = stat(filename.c_str(), &sb);
@@ -73,6 +90,49 @@ void	FITSoutfileBase::write(const ImageBase& image) {
 	if (fits_create_file(&fptr, filename.c_str(), &status)) {
 		throw FITSexception(errormsg(status));
 	}
+}
+
+/**
+ * \brief Create the FITS file in memory
+ *
+ * The buffer is allocated large enough for the pixel data and a generous
+ * header, so that cfitsio does not have to reallocate it while the
+ * pixels are written.
+ */
+void	FITSoutfileBase::creatememory(const ImageBase& image) {
+	size_t	datasize = image.size().getPixels() * planes
+			* image.bytesPerPlane();
+	size_t	headersize = (3 + image.nMetadata() / 36) * 2880;
+	size_t	estimate = 2880 * ((headersize + datasize) / 2880 + 1);
+	*_buffer = malloc(estimate);
+	if (NULL == *_buffer) {
+		std::string	msg = stringprintf("cannot allocate %lu bytes "
+			"for FITS buffer", estimate);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw FITSexception(msg);
+	}
+	*_buffersize = estimate;
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "create FITS memory file of size %lu",
+		estimate);
+	int	status = 0;
+	if (fits_create_memfile(&fptr, _buffer, _buffersize, 2880 * 10,
+		realloc, &status)) {
+		free(*_buffer);
+		*_buffer = NULL;
+		*_buffersize = 0;
+		throw FITSexception(errormsg(status));
+	}
+}
+
+/**
+ * \brief write the image format information to the header
+ */
+void	FITSoutfileBase::write(const ImageBase& image) {
+	if (inmemory()) {
+		creatememory(image);
+	} else {
+		create();
+	}
 
 	// find the dimensions
 	long	naxis = 3;
@@ -80,7 +140,7 @@ void	FITSoutfileBase::write(const ImageBase& image) {
 		image.size().width(), image.size().height(), planes
 	};
 
-	status = 0;
+	int	status = 0;
 	if (fits_create_img(fptr, imgtype, naxis, naxes, &status)) {
 		throw FITSexception(errormsg(status), filename);
 	}
@@ -89,140 +149,7 @@ void	FITSoutfileBase::write(const ImageBase& image) {
 	// an image
 	ImageMetadata::const_iterator	i;
 	for (i = image.begin(); i != image.end(); i++) {
-		const char	*key = i->first.c_str();
-		Metavalue	value = i->second;
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "writing '%s'",
-			value.toString().c_str());
-		const char	*comment = value.getComment().c_str();
-		std::type_index	type = value.getType();
-		int	status = 0;
-		int	rc = 0;
-
-		if (type == std::type_index(typeid(bool))) {
-			int	logicalvalue = (bool)value;
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (bool)%s",
-				key, (logicalvalue) ? "true" : "false");
-			rc = fits_write_key(fptr, TLOGICAL, key, &logicalvalue,
-				comment, &status);
-			goto writedone;
-		}
-
-		if (type == std::type_index(typeid(std::string))) {
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (string)%s",
-				key, value.getValue().c_str());
-			rc = fits_write_key(fptr, TSTRING, key,
-				(void *)value.getValue().c_str(),
-				comment, &status);
-			goto writedone;
-		}
-
-		if (type == std::type_index(typeid(char))) {
-			char	charvalue = (char)value;
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (char)%d",
-				key, charvalue);
-			rc = fits_write_key(fptr, TBYTE, key, &charvalue,
-				comment, &status);
-			goto writedone;
-		}
-
-		if (type == std::type_index(typeid(short))) {
-			short	shortvalue = (short)value;
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (short)%d",
-				key, shortvalue);
-			rc = fits_write_key(fptr, TSHORT, key, &shortvalue,
-				comment, &status);
-			goto writedone;
-		}
-
-		if (type == std::type_index(typeid(unsigned short))) {
-			unsigned short	ushortvalue = (unsigned short)value;
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (ushort)%hu",
-				key, ushortvalue);
-			rc = fits_write_key(fptr, TUSHORT, key, &ushortvalue,
-				comment, &status);
-			goto writedone;
-		}
-
-		if (type == std::type_index(typeid(int))) {
-			int	intvalue = (int)value;
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (int)%d",
-				key, intvalue);
-			rc = fits_write_key(fptr, TINT, key, &intvalue,
-				comment, &status);
-			goto writedone;
-		}
-
-		if (type == std::type_index(typeid(unsigned int))) {
-			unsigned int	uintvalue = (unsigned int)value;
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (uint)%u",
-				key, uintvalue);
-			rc = fits_write_key(fptr, TUINT, key, &uintvalue,
-				comment, &status);
-			goto writedone;
-		}
-
-		if (type == std::type_index(typeid(long))) {
-			long	longvalue = (long)value;
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (long)%ld",
-				key, longvalue);
-			rc = fits_write_key(fptr, TLONG, key, &longvalue,
-				comment, &status);
-			goto writedone;
-		}
-
-		if (type == std::type_index(typeid(unsigned long))) {
-			unsigned long	ulongvalue = (unsigned long)value;
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (ulong)%lu",
-				key, ulongvalue);
-			rc = fits_write_key(fptr, TULONG, key, &ulongvalue,
-				comment, &status);
-			goto writedone;
-		}
-
-		if (type == std::type_index(typeid(float))) {
-			float	floatvalue = (float)value;
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (float)%f",
-				key, floatvalue);
-			rc = fits_write_key(fptr, TFLOAT, key, &floatvalue,
-				comment, &status);
-			goto writedone;
-		}
-
-		if (type == std::type_index(typeid(double))) {
-			double doublevalue = (double)value;
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "%s: (double)%f",
-				key, doublevalue);
-			rc = fits_write_key(fptr, TDOUBLE, key, &doublevalue,
-				comment, &status);
-			goto writedone;
-		}
-
-		if (type == std::type_index(typeid(FITSdate))) {
-			rc = fits_write_key(fptr, TSTRING, key,
-				(void *)((std::string)value).c_str(),
-				comment, &status);
-			goto writedone;
-		}
-
-		if (type == std::type_index(typeid(void))) {
-			if (key == std::string("HISTORY")) {
-				rc = fits_write_history(fptr, comment, &status);
-				debug(LOG_DEBUG, DEBUG_LOG, 0, "write HISTORY: %s, %d", comment, rc);
-			}
-			if (key == std::string("COMMENT")) {
-				rc = fits_write_comment(fptr, comment, &status);
-			}
-			goto writedone;
-		}
-
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "cannot write entry of type %s",
-			type.name());
-		continue;
-	
-	writedone:
-		if (rc) {
-			throw FITSexception(errormsg(status), filename);
-		}
+		writekey(i->first, i->second, false);
 	}
 }
 
@@ -231,8 +158,8 @@ void	FITSoutfileBase::write(const ImageBase& image) {
  */
 void	FITSoutfileBase::postwrite() {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "postwrite called");
-	// not precious, do nothing
-	if (!precious()) {
+	// not precious or in memory, do nothing
+	if ((!precious()) || inmemory()) {
 		return;
 	}
 
@@ -254,6 +181,27 @@ void	FITSoutfileBase::postwrite() {
 	}
 }
 
+/**
+ * \brief Compute the size of the FITS data written so far
+ *
+ * For the single HDU files written by this class, the end of the data
+ * unit is the size of the file. This is used to find the size of an
+ * in memory FITS file, because the buffer allocated by cfitsio may be
+ * larger than the FITS data.
+ */
+size_t	FITSoutfileBase::filesize() const {
+	if (NULL == fptr) {
+		return 0;
+	}
+	LONGLONG	headstart, datastart, dataend;
+	int	status = 0;
+	if (fits_get_hduaddrll(fptr, &headstart, &datastart, &dataend,
+		&status)) {
+		throw FITSexception(errormsg(status), filename);
+	}
+	return dataend;
+}
+
 /**
  * \brief constructor specializations of FITSoutfile for all types
  */
@@ -261,6 +209,10 @@ void	FITSoutfileBase::postwrite() {
 template<>								\
 FITSoutfile<T >::FITSoutfile(const std::string& filename)		\
 	: FITSoutfileBase(filename, pix, planes, img) {			\
+}									\
+template<>								\
+FITSoutfile<T >::FITSoutfile(void **buffer, size_t *buffersize)	\
+	: FITSoutfileBase(buffer, buffersize, pix, planes, img) {	\
 }
 
 // basic type monochrome pixels
@@ -299,6 +251,11 @@ FITS_OUT_CONSTRUCTOR(YUYV<double>, TDOUBLE, 3, DOUBLE_IMG)
 template<>								\
 FITSoutfile<Multiplane<T, planes> >::FITSoutfile(const std::string& filename)		\
 	: FITSoutfileBase(filename, pix, planes, img) {			\
+}									\
+template<>								\
+FITSoutfile<Multiplane<T, planes> >::FITSoutfile(void **buffer,	\
+	size_t *buffersize)						\
+	: FITSoutfileBase(buffer, buffersize, pix, planes, img) {	\
 }
 
 FITS_OUT_CONSTRUCTOR_MULTI(unsigned char, TBYTE, 1, BYTE_IMG)
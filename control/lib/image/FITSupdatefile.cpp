@@ -0,0 +1,65 @@
+/*
+ * FITSupdatefile.cpp -- update the headers of a FITS file in place
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroIO.h>
+#include <AstroDebug.h>
+#include <includes.h>
+
+namespace astro {
+namespace io {
+
+/**
+ * \brief Open a FITS file for header updates
+ *
+ * \param filename	name of the file to update
+ */
+FITSupdatefile::FITSupdatefile(const std::string& filename)
+	: FITSfile(filename, 0, 0, 0) {
+	int	status = 0;
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "open FITS file '%s' for update",
+		filename.c_str());
+	if (fits_open_file(&fptr, filename.c_str(), READWRITE, &status)) {
+		throw FITSexception(errormsg(status), filename);
+	}
+}
+
+/**
+ * \brief Close the file and forget the cached header
+ *
+ * The file is closed here rather than in the base class destructor,
+ * so that the header cache cannot pick up a partially written header.
+ */
+FITSupdatefile::~FITSupdatefile() {
+	if (NULL != fptr) {
+		int	status = 0;
+		if (fits_close_file(fptr, &status)) {
+			debug(LOG_ERR, DEBUG_LOG, 0, "cannot close %s: %s",
+				filename.c_str(), errormsg(status).c_str());
+		}
+		fptr = NULL;
+	}
+	FITSheaderCache::invalidate(filename);
+}
+
+/**
+ * \brief Set a single keyword
+ */
+void	FITSupdatefile::setMetadata(const Metavalue& value) {
+	writekey(value.getKeyword(), value, true);
+}
+
+/**
+ * \brief Set all keywords of a metadata set
+ */
+void	FITSupdatefile::setMetadata(const ImageMetadata& metadata) {
+	for (auto i = metadata.begin(); i != metadata.end(); i++) {
+		writekey(i->first, i->second, true);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%lu keywords updated in %s",
+		metadata.size(), filename.c_str());
+}
+
+} // namespace io
+} // namespace astro
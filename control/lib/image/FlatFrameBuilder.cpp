@@ -0,0 +1,129 @@
+/*
+ * FlatFrameBuilder.cpp -- build flat frames one image at a time
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroCalibration.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <AstroIO.h>
+#include <stdexcept>
+#include "ImageMean.h"
+#include "ImageAccumulator.h"
+
+using namespace astro::image;
+
+namespace astro {
+namespace calibration {
+
+/**
+ * \brief Construct a flat frame builder
+ *
+ * \param factory	the factory providing mosaic and interpolation flags
+ * \param bias		the bias image, must have float or double pixels
+ * \param robust	whether to reject outliers like the factory does
+ */
+FlatFrameBuilder::FlatFrameBuilder(const FlatFrameFactory& factory,
+	ImagePtr bias, bool robust)
+	: _factory(factory), _bias(bias), _robust(robust) {
+	if ((_bias) && (NULL == dynamic_cast<Image<float> *>(&*_bias))
+		&& (NULL == dynamic_cast<Image<double> *>(&*_bias))) {
+		throw std::runtime_error("no useful bias image supplied");
+	}
+}
+
+/**
+ * \brief Set the robust flag, this is only possible before adding images
+ */
+void	FlatFrameBuilder::robust(bool r) {
+	if (_accumulator) {
+		throw std::logic_error("cannot change mode after first image");
+	}
+	_robust = r;
+}
+
+/**
+ * \brief Add an image
+ *
+ * The pixel type of the flat is the pixel type of the bias image, or
+ * float if there is no bias image.
+ */
+void	FlatFrameBuilder::add(ImagePtr image) {
+	if (!_accumulator) {
+		if (dynamic_cast<Image<double> *>(&*_bias)) {
+			_accumulator = ImageAccumulatorPtr(
+				new ImageAccumulator<double>(image->size(),
+					_robust, _bias));
+		} else {
+			_accumulator = ImageAccumulatorPtr(
+				new ImageAccumulator<float>(image->size(),
+					_robust, _bias));
+		}
+		_first = ImagePtr(new ImageBase(*image));
+	}
+	_accumulator->add(image);
+}
+
+/**
+ * \brief Number of images added so far
+ */
+size_t	FlatFrameBuilder::count() const {
+	return (_accumulator) ? _accumulator->count() : 0;
+}
+
+/**
+ * \brief Compute the mean and variance from an accumulator
+ */
+template<typename T>
+static void	meanvariance(ImageAccumulator<T>& accumulator, ImagePtr first,
+			ImagePtr& meanimage, ImagePtr& varianceimage) {
+	accumulator.result(meanimage, varianceimage);
+	meanimage->setMosaicType(first->getMosaicType());
+	if (first->hasMetadata("FILTER")) {
+		meanimage->setMetadata(first->getMetadata("FILTER"));
+	}
+}
+
+/**
+ * \brief Compute the flat image from the images added so far
+ */
+ImagePtr	FlatFrameBuilder::operator()() {
+	if (0 == count()) {
+		throw std::runtime_error("no images supplied for flat");
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "building flat from %d images",
+		count());
+	ImagePtr	meanimage;
+	ImagePtr	varianceimage;
+	ImagePtr	result;
+	ImageAccumulator<float>	*floataccumulator
+		= dynamic_cast<ImageAccumulator<float> *>(&*_accumulator);
+	if (floataccumulator) {
+		meanvariance(*floataccumulator, _first, meanimage,
+			varianceimage);
+		ImageMean<float>	im(meanimage, varianceimage);
+		Image<float>	*floatbias
+			= dynamic_cast<Image<float> *>(&*_bias);
+		if (floatbias) {
+			result = _factory.flat<float>(im, *floatbias);
+		} else {
+			result = _factory.flat(im);
+		}
+	} else {
+		ImageAccumulator<double>	*doubleaccumulator
+			= dynamic_cast<ImageAccumulator<double> *>(
+				&*_accumulator);
+		meanvariance(*doubleaccumulator, _first, meanimage,
+			varianceimage);
+		ImageMean<double>	im(meanimage, varianceimage);
+		result = _factory.flat<double>(im,
+			*dynamic_cast<Image<double> *>(&*_bias));
+	}
+
+	// copy the meta data information from the first image
+	_factory.copyMetadata(result, _first, count(), "flat");
+	return result;
+}
+
+} // calibration
+} // astro
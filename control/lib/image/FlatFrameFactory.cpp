@@ -101,7 +101,30 @@ ImagePtr	FlatFrameFactory::flat(const ImageSequence& images,
 	// the variance nevertheless
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "compute mean of images");
 	ImageMean<FlatPixelType>	im(images, bias, true);
+	return flat<FlatPixelType>(im, bias);
+}
+
+template
+ImagePtr	FlatFrameFactory::flat(
+			const astro::image::ImageSequence& images,
+			const Image<float>& bias) const;
+template
+ImagePtr	FlatFrameFactory::flat(
+			const astro::image::ImageSequence& images,
+			const Image<double>& bias) const;
 
+/**
+ * \brief Construct a flat image from the pixel means of the images
+ *
+ * This is the part of the flat construction common to image sequences
+ * and to the FlatFrameBuilder.
+ *
+ * \param im		mean of the bias corrected images
+ * \param bias		the bias image, its NaNs are copied to the flat
+ */
+template<typename FlatPixelType>
+ImagePtr	FlatFrameFactory::flat(ImageMean<FlatPixelType>& im,
+			const Image<FlatPixelType>& bias) const {
 	// extract the image
 	ImagePtr	result = im.getImagePtr();
 	Image<FlatPixelType>	*image
@@ -144,12 +167,10 @@ ImagePtr	FlatFrameFactory::flat(const ImageSequence& images,
 }
 
 template
-ImagePtr	FlatFrameFactory::flat(
-			const astro::image::ImageSequence& images,
+ImagePtr	FlatFrameFactory::flat(ImageMean<float>& im,
 			const Image<float>& bias) const;
 template
-ImagePtr	FlatFrameFactory::flat(
-			const astro::image::ImageSequence& images,
+ImagePtr	FlatFrameFactory::flat(ImageMean<double>& im,
 			const Image<double>& bias) const;
 
 /**
@@ -166,7 +187,15 @@ ImagePtr	FlatFrameFactory::flat(const ImageSequence& images) const {
 	// the variance nevertheless
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "compute mean of images");
 	ImageMean<float>	im(images, true);
+	return flat(im);
+}
 
+/**
+ * \brief Construct a flat image from the pixel means of the images
+ *
+ * \param im	the mean of the images without bias correction
+ */
+ImagePtr	FlatFrameFactory::flat(ImageMean<float>& im) const {
 	// extract the image, which consists of mean values for each pixel
 	ImagePtr	result = im.getImagePtr();
 	Image<float>	*image = dynamic_cast<Image<float> *>(&*result);
@@ -6,6 +6,7 @@
 #include <AstroConvolve.h>
 #include <fftw3.h>
 #include <math.h>
+#include <cstring>
 #include <AstroDebug.h>
 #include <AstroFormat.h>
 #include <AstroAdapter.h>
@@ -69,11 +70,7 @@ void	FourierImage::fourier(const Image<double>& image) {
 		n0, n1);
 
 	// compute the fourier transform
-	fftw_plan	p = fftw_plan_dft_r2c_2d(n0, n1, image.pixels,
-				(fftw_complex *)pixels, FFTW_ESTIMATE);
-	fftw_execute(p);
-	fftw_destroy_plan(p);
-	fftw_cleanup();
+	FFTWPlans::r2c(image.size(), image.pixels, (fftw_complex *)pixels);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "fourier transform completed");
 }
 
@@ -142,12 +139,13 @@ ImagePtr	FourierImage::inverse(bool absolute) const {
 	int	n0 = _orig.height();
 	int	n1 = _orig.width();
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "inverse transform, (%d,%d)", n0, n1);
-	// compute the fourier transform
-	fftw_plan	p = fftw_plan_dft_c2r_2d(n0, n1, (fftw_complex *)pixels,
-				image->pixels, FFTW_ESTIMATE);
-	fftw_execute(p);
-	fftw_destroy_plan(p);
-	fftw_cleanup();
+	// compute the fourier transform, on a copy because the complex
+	// to real transform destroys its input
+	size_t	nc = n0 * (1 + n1 / 2);
+	fftw_complex	*in = fftw_alloc_complex(nc);
+	memcpy(in, pixels, nc * sizeof(fftw_complex));
+	FFTWPlans::c2r(_orig, in, image->pixels);
+	fftw_free(in);
 
 	// normalize to the dimensions of the domain
 	double	value = 1. / (n0 * n1);
@@ -0,0 +1,90 @@
+/*
+ * ImageAccumulator.cpp -- spill file for the image accumulators
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include "ImageAccumulator.h"
+#include <cstring>
+#include <cerrno>
+
+namespace astro {
+namespace calibration {
+
+/**
+ * \brief Create the temporary file
+ *
+ * The file disappears when it is closed.
+ */
+SpillFile::SpillFile() : _length(0), _data(NULL), _maplength(0) {
+	_file = tmpfile();
+	if (NULL == _file) {
+		std::string	msg = stringprintf("cannot create spill file: %s",
+			strerror(errno));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+}
+
+SpillFile::~SpillFile() {
+	unmap();
+	fclose(_file);
+}
+
+/**
+ * \brief Append data to the file
+ */
+void	SpillFile::write(const void *data, size_t length) {
+	if (NULL != _data) {
+		throw std::logic_error("cannot write to mapped spill file");
+	}
+	if (length != fwrite(data, 1, length, _file)) {
+		std::string	msg = stringprintf("cannot write spill file: %s",
+			strerror(errno));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	_length += length;
+}
+
+/**
+ * \brief Map a window of the file for reading
+ *
+ * Any previous window is unmapped first. The offset need not be page
+ * aligned, the returned pointer points to the byte at the offset.
+ */
+const void	*SpillFile::map(size_t offset, size_t length) {
+	unmap();
+	if ((offset + length > _length) || (0 == length)) {
+		std::string	msg = stringprintf("window %lu+%lu outside spill "
+			"file of %lu bytes", offset, length, _length);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	fflush(_file);
+	size_t	pageoffset = offset % sysconf(_SC_PAGESIZE);
+	void	*data = mmap(NULL, length + pageoffset, PROT_READ, MAP_SHARED,
+		fileno(_file), offset - pageoffset);
+	if (MAP_FAILED == data) {
+		std::string	msg = stringprintf("cannot map spill file: %s",
+			strerror(errno));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	_data = data;
+	_maplength = length + pageoffset;
+	return (const char *)_data + pageoffset;
+}
+
+/**
+ * \brief Remove the mapping of the current window
+ */
+void	SpillFile::unmap() {
+	if (NULL != _data) {
+		munmap(_data, _maplength);
+		_data = NULL;
+		_maplength = 0;
+	}
+}
+
+} // namespace calibration
+} // namespace astro
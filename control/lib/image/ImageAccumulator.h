@@ -0,0 +1,252 @@
+/*
+ * ImageAccumulator.h -- incremental mean and variance of image pixels
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#ifndef _ImageAccumulator_h
+#define _ImageAccumulator_h
+
+#include <includes.h>
+#include <AstroCalibration.h>
+#include <PixelValue.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <memory>
+#include <cstdio>
+
+namespace astro {
+namespace calibration {
+
+/**
+ * \brief Anonymous temporary file that can be mapped for reading
+ *
+ * Images are appended to the file one after the other. To read them,
+ * a window of the file is mapped into memory, so only the pages of that
+ * window occupy address space and memory, no matter how many images
+ * the file contains.
+ */
+class SpillFile {
+	FILE	*_file;
+	size_t	_length;
+	void	*_data;
+	size_t	_maplength;
+	SpillFile(const SpillFile& other);
+	SpillFile&	operator=(const SpillFile& other);
+public:
+	SpillFile();
+	~SpillFile();
+	size_t	length() const { return _length; }
+	void	write(const void *data, size_t length);
+	const void	*map(size_t offset, size_t length);
+	void	unmap();
+};
+
+/**
+ * \brief Type independent base class for the image accumulators
+ */
+class ImageAccumulatorBase {
+public:
+	virtual ~ImageAccumulatorBase() { }
+	virtual void	add(ImagePtr image) = 0;
+	virtual size_t	count() const = 0;
+};
+
+/**
+ * \brief Accumulate mean and variance of each pixel over many images
+ *
+ * Mean and variance are updated with Welford's algorithm for each image
+ * added, so the memory needed does not depend on the number of images.
+ * NaN pixels are skipped, like ImageMean does. If a dark image is given,
+ * it is subtracted from each image, clamping negative values to zero.
+ *
+ * In robust mode, the dark corrected images are also written to a spill
+ * file. The result then rejects values that are more than k standard
+ * deviations away from the mean, exactly as the second pass of ImageMean
+ * does, mapping one image of the spill file at a time.
+ */
+template<typename T>
+class ImageAccumulator : public ImageAccumulatorBase {
+	ImageSize	_size;
+	ImagePtr	_darkptr;
+	const Image<T>	*_dark;
+	size_t	_count;
+	std::vector<T>	_mean;
+	std::vector<T>	_m2;
+	std::vector<unsigned int>	_n;
+	std::unique_ptr<SpillFile>	_spill;
+	T	darkvalue(int x, int y) const {
+		return (_dark) ? _dark->pixel(x, y) : 0;
+	}
+public:
+	ImageAccumulator(const ImageSize& size, bool robust,
+		ImagePtr dark = ImagePtr());
+	virtual void	add(ImagePtr image);
+	virtual size_t	count() const { return _count; }
+	void	result(ImagePtr& meanimage, ImagePtr& varianceimage,
+			unsigned int k = 3);
+};
+
+/**
+ * \brief Construct an accumulator for images of a given size
+ *
+ * \param size		size of the images
+ * \param robust	whether to keep the images for outlier rejection
+ * \param dark		dark image to subtract, must have pixel type T
+ */
+template<typename T>
+ImageAccumulator<T>::ImageAccumulator(const ImageSize& size, bool robust,
+	ImagePtr dark) : _size(size), _darkptr(dark), _dark(NULL), _count(0),
+	_mean(size.getPixels(), 0), _m2(size.getPixels(), 0),
+	_n(size.getPixels(), 0) {
+	if (_darkptr) {
+		_dark = dynamic_cast<const Image<T> *>(&*_darkptr);
+		if (NULL == _dark) {
+			throw std::runtime_error("dark has wrong pixel type");
+		}
+		if (_dark->size() != _size) {
+			throw std::runtime_error("dark size does not match");
+		}
+	}
+	if (robust) {
+		_spill = std::unique_ptr<SpillFile>(new SpillFile());
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "accumulator for %s images%s",
+		_size.toString().c_str(), (robust) ? ", robust" : "");
+}
+
+/**
+ * \brief Add an image to the accumulator
+ */
+template<typename T>
+void	ImageAccumulator<T>::add(ImagePtr image) {
+	if (image->size() != _size) {
+		std::string	msg = stringprintf("image size %s does not "
+			"match %s", image->size().toString().c_str(),
+			_size.toString().c_str());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	if (isColorImage(image)) {
+		std::string	msg("cannot accumulate color images");
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	ConstPixelValue<T>	pv(image);
+	int	width = _size.width();
+	int	height = _size.height();
+	std::vector<T>	values;
+	if (_spill) {
+		values.resize(_size.getPixels());
+	}
+#pragma omp parallel for
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			size_t	i = (size_t)y * width + x;
+			T	v = pv.pixelvalue(x, y);
+			T	d = darkvalue(x, y);
+			if ((v == v) && (d == d)) {
+				v = (v < d) ? 0 : (v - d);
+				unsigned int	n = ++_n[i];
+				T	delta = v - _mean[i];
+				_mean[i] += delta / n;
+				_m2[i] += delta * (v - _mean[i]);
+			}
+			if (_spill) {
+				values[i] = v;
+			}
+		}
+	}
+	if (_spill) {
+		_spill->write(values.data(), values.size() * sizeof(T));
+	}
+	_count++;
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%d images accumulated", _count);
+}
+
+/**
+ * \brief Compute mean and variance images
+ *
+ * Pixels that are NaN in the dark image or in all images are NaN in
+ * mean and variance.
+ *
+ * \param meanimage	the mean image is returned in this pointer
+ * \param varianceimage	the variance image is returned in this pointer
+ * \param k		number of standard deviations for outlier rejection
+ */
+template<typename T>
+void	ImageAccumulator<T>::result(ImagePtr& meanimage,
+		ImagePtr& varianceimage, unsigned int k) {
+	Image<T>	*mean = new Image<T>(_size);
+	meanimage = ImagePtr(mean);
+	Image<T>	*var = new Image<T>(_size);
+	varianceimage = ImagePtr(var);
+	int	npixels = _size.getPixels();
+	int	width = _size.width();
+	T	nan = std::numeric_limits<T>::quiet_NaN();
+
+	// without outlier rejection, the result is mean and variance
+	if (!_spill) {
+#pragma omp parallel for
+		for (int i = 0; i < npixels; i++) {
+			int	x = i % width, y = i / width;
+			T	d = darkvalue(x, y);
+			bool	valid = (d == d) && (_n[i] > 0);
+			mean->pixel(x, y) = (valid) ? _mean[i] : nan;
+			var->pixel(x, y) = (valid) ? (_m2[i] / _n[i]) : nan;
+		}
+		return;
+	}
+
+	// sum the values that are not too far off in the mean and variance
+	// images, one image of the spill file at a time
+	mean->fill(0);
+	var->fill(0);
+	std::vector<unsigned int>	counter(npixels, 0);
+	size_t	imagelength = npixels * sizeof(T);
+	for (size_t j = 0; j < _count; j++) {
+		const T	*data = (const T *)_spill->map(j * imagelength,
+			imagelength);
+#pragma omp parallel for
+		for (int i = 0; i < npixels; i++) {
+			if (0 == _n[i]) {
+				continue;
+			}
+			T	v = data[i];
+			T	EX = _mean[i];
+			T	stddevk = k * sqrt(_m2[i] / _n[i]);
+			if (stddevk < 1) {
+				stddevk = std::numeric_limits<T>::infinity();
+			}
+			if ((v != v) || (fabs(v - EX) > stddevk)) {
+				continue;
+			}
+			mean->pixels[i] += v;
+			var->pixels[i] += v * v;
+			counter[i]++;
+		}
+		_spill->unmap();
+	}
+
+	// convert the sums into mean and variance
+#pragma omp parallel for
+	for (int i = 0; i < npixels; i++) {
+		int	x = i % width, y = i / width;
+		T	d = darkvalue(x, y);
+		if ((d != d) || (0 == counter[i])) {
+			mean->pixel(x, y) = nan;
+			var->pixel(x, y) = nan;
+			continue;
+		}
+		T	EX = mean->pixels[i] / counter[i];
+		mean->pixels[i] = EX;
+		var->pixels[i] = var->pixels[i] / counter[i] - EX * EX;
+	}
+}
+
+} // namespace calibration
+} // namespace astro
+
+#endif /* _ImageAccumulator_h */
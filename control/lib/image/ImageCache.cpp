@@ -0,0 +1,316 @@
+/*
+ * ImageCache.cpp -- memory budgeted cache of decoded image files
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <ImageCache.h>
+#include <AstroIO.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <includes.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace astro {
+namespace image {
+
+/**
+ * \brief Maximum number of files waiting to be prefetched
+ */
+static const size_t	prefetch_queue_length = 16;
+
+/**
+ * \brief An image in the cache together with the version of its file
+ */
+typedef struct imagecacheentry_s {
+	std::string	filename;
+	struct timespec	mtime;
+	off_t	filesize;
+	ino_t	inode;
+	ImagePtr	image;
+	size_t	bytes;
+} imagecacheentry_t;
+
+typedef std::list<imagecacheentry_t>	imagecachelist;
+
+/**
+ * \brief The state of the cache
+ *
+ * The state is allocated once and never destroyed, because a prefetch
+ * thread may still be running while the program exits.
+ */
+class imagecachestate {
+public:
+	std::mutex	mutex;
+	std::condition_variable	condition;
+	imagecachelist	entries;
+	std::map<std::string, imagecachelist::iterator>	index;
+	std::set<std::string>	loading;
+	std::deque<std::string>	queue;
+	bool	prefetching;
+	size_t	budget;
+	size_t	bytes;
+	unsigned long	hits;
+	unsigned long	misses;
+	unsigned long	prefetched;
+	imagecachestate() : prefetching(false), budget(256 * 1024 * 1024),
+		bytes(0), hits(0), misses(0), prefetched(0) { }
+	void	remove(std::map<std::string,
+			imagecachelist::iterator>::iterator i);
+	void	trim();
+};
+
+static imagecachestate&	state() {
+	static imagecachestate	*s = new imagecachestate();
+	return *s;
+}
+
+/**
+ * \brief Remove an entry, the caller must hold the lock
+ */
+void	imagecachestate::remove(std::map<std::string,
+		imagecachelist::iterator>::iterator i) {
+	bytes -= i->second->bytes;
+	entries.erase(i->second);
+	index.erase(i);
+}
+
+/**
+ * \brief Drop least recently used images until the budget is met
+ */
+void	imagecachestate::trim() {
+	while ((bytes > budget) && (entries.size() > 0)) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "dropping %s from image cache",
+			entries.back().filename.c_str());
+		remove(index.find(entries.back().filename));
+	}
+}
+
+static bool	samefile(const imagecacheentry_t& entry, const struct stat& sb) {
+	return (entry.mtime.tv_sec == sb.st_mtim.tv_sec)
+		&& (entry.mtime.tv_nsec == sb.st_mtim.tv_nsec)
+		&& (entry.filesize == sb.st_size)
+		&& (entry.inode == sb.st_ino);
+}
+
+/**
+ * \brief Get an image from the cache or read it
+ *
+ * If another thread is already reading the same file, e.g. because it
+ * is being prefetched, we wait for that thread instead of reading the
+ * file a second time.
+ *
+ * \param filename	name of the FITS file
+ * \param prefetch	whether the image is read by the prefetch thread
+ */
+static ImagePtr	load(const std::string& filename, bool prefetch) {
+	imagecachestate&	s = state();
+	struct stat	sb;
+	if (stat(filename.c_str(), &sb) < 0) {
+		std::string	msg = stringprintf("cannot stat %s: %s",
+			filename.c_str(), strerror(errno));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	std::unique_lock<std::mutex>	lock(s.mutex);
+	while (true) {
+		auto	i = s.index.find(filename);
+		if (i != s.index.end()) {
+			if (samefile(*i->second, sb)) {
+				s.entries.splice(s.entries.begin(), s.entries,
+					i->second);
+				if (!prefetch) {
+					s.hits++;
+				}
+				return i->second->image;
+			}
+			debug(LOG_DEBUG, DEBUG_LOG, 0, "%s has changed",
+				filename.c_str());
+			s.remove(i);
+		}
+		if (s.loading.find(filename) == s.loading.end()) {
+			break;
+		}
+		s.condition.wait(lock);
+	}
+	if (prefetch) {
+		s.prefetched++;
+	} else {
+		s.misses++;
+	}
+	s.loading.insert(filename);
+	lock.unlock();
+
+	// read the file without holding the lock
+	ImagePtr	image;
+	try {
+		io::FITSin	in(filename);
+		image = in.read();
+	} catch (...) {
+		lock.lock();
+		s.loading.erase(filename);
+		s.condition.notify_all();
+		throw;
+	}
+
+	lock.lock();
+	s.loading.erase(filename);
+	s.condition.notify_all();
+	imagecacheentry_t	entry;
+	entry.filename = filename;
+	entry.mtime = sb.st_mtim;
+	entry.filesize = sb.st_size;
+	entry.inode = sb.st_ino;
+	entry.image = image;
+	entry.bytes = image->size().getPixels() * image->bytesPerPixel();
+	if (entry.bytes > s.budget) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%s too large for image cache",
+			filename.c_str());
+		return image;
+	}
+	s.entries.push_front(entry);
+	s.index[filename] = s.entries.begin();
+	s.bytes += entry.bytes;
+	s.trim();
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "image cache: %lu images, %lu bytes",
+		s.entries.size(), s.bytes);
+	return image;
+}
+
+size_t	ImageCache::budget() {
+	std::unique_lock<std::mutex>	lock(state().mutex);
+	return state().budget;
+}
+
+void	ImageCache::budget(size_t b) {
+	std::unique_lock<std::mutex>	lock(state().mutex);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "image cache budget: %lu bytes", b);
+	state().budget = b;
+	state().trim();
+}
+
+/**
+ * \brief Get the image contained in a file
+ *
+ * \param filename	name of the FITS file
+ */
+ImagePtr	ImageCache::get(const std::string& filename) {
+	return load(filename, false);
+}
+
+/**
+ * \brief Find out whether an image is in the cache
+ */
+bool	ImageCache::contains(const std::string& filename) {
+	std::unique_lock<std::mutex>	lock(state().mutex);
+	return state().index.find(filename) != state().index.end();
+}
+
+/**
+ * \brief Main function of the prefetch thread
+ *
+ * The thread terminates as soon as there is nothing left to prefetch.
+ */
+static void	prefetchmain() {
+	imagecachestate&	s = state();
+	while (true) {
+		std::string	filename;
+		{
+			std::unique_lock<std::mutex>	lock(s.mutex);
+			if (s.queue.size() == 0) {
+				s.prefetching = false;
+				return;
+			}
+			filename = s.queue.front();
+			s.queue.pop_front();
+		}
+		try {
+			load(filename, true);
+		} catch (const std::exception& x) {
+			debug(LOG_WARNING, DEBUG_LOG, 0, "cannot prefetch %s: %s",
+				filename.c_str(), x.what());
+		}
+	}
+}
+
+/**
+ * \brief Read a file in the background
+ *
+ * Files already in the cache or already waiting to be read are ignored.
+ * If too many files are waiting, the oldest requests are dropped, as
+ * they are the least likely to still be useful.
+ */
+void	ImageCache::prefetch(const std::string& filename) {
+	imagecachestate&	s = state();
+	std::unique_lock<std::mutex>	lock(s.mutex);
+	if ((s.index.find(filename) != s.index.end())
+		|| (s.loading.find(filename) != s.loading.end())
+		|| (std::find(s.queue.begin(), s.queue.end(), filename)
+			!= s.queue.end())) {
+		return;
+	}
+	s.queue.push_back(filename);
+	while (s.queue.size() > prefetch_queue_length) {
+		s.queue.pop_front();
+	}
+	if (!s.prefetching) {
+		s.prefetching = true;
+		std::thread(prefetchmain).detach();
+	}
+}
+
+void	ImageCache::prefetch(const std::list<std::string>& filenames) {
+	for (auto f = filenames.begin(); f != filenames.end(); f++) {
+		prefetch(*f);
+	}
+}
+
+/**
+ * \brief Forget the image of a file
+ */
+void	ImageCache::invalidate(const std::string& filename) {
+	std::unique_lock<std::mutex>	lock(state().mutex);
+	auto	i = state().index.find(filename);
+	if (i != state().index.end()) {
+		state().remove(i);
+	}
+}
+
+void	ImageCache::clear() {
+	std::unique_lock<std::mutex>	lock(state().mutex);
+	state().entries.clear();
+	state().index.clear();
+	state().bytes = 0;
+}
+
+unsigned long	ImageCache::hits() {
+	std::unique_lock<std::mutex>	lock(state().mutex);
+	return state().hits;
+}
+
+unsigned long	ImageCache::misses() {
+	std::unique_lock<std::mutex>	lock(state().mutex);
+	return state().misses;
+}
+
+unsigned long	ImageCache::prefetched() {
+	std::unique_lock<std::mutex>	lock(state().mutex);
+	return state().prefetched;
+}
+
+size_t	ImageCache::bytes() {
+	std::unique_lock<std::mutex>	lock(state().mutex);
+	return state().bytes;
+}
+
+size_t	ImageCache::count() {
+	std::unique_lock<std::mutex>	lock(state().mutex);
+	return state().entries.size();
+}
+
+} // namespace image
+} // namespace astro
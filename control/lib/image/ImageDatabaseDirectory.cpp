@@ -64,6 +64,7 @@ void	ImageDatabaseDirectory::remove(const std::string& filename) {
 			filename.c_str());
 		std::list<long>	idlist = imagetable.selectids(condition);
 		if (idlist.size() != 1) {
+			_database->commit();
 			return;
 		}
 
@@ -234,5 +235,51 @@ void	ImageDatabaseDirectory::write(ImagePtr image,
 	_database->commit();
 }
 
+/**
+ * \brief Update the metadata in the file and in the database
+ *
+ * Only the attributes that change are replaced in the database, the
+ * file is updated in place by the ImageDirectory.
+ */
+void	ImageDatabaseDirectory::setMetadata(const std::string& filename,
+		const ImageMetadata& metadata) {
+	ImageDirectory::setMetadata(filename, metadata);
+	if (!_database) {
+		debug(LOG_WARNING, DEBUG_LOG, 0, "warning: no database");
+		return;
+	}
+
+	_database->begin();
+	try {
+		ImageTable	imagetable(_database);
+		std::string	condition = stringprintf("filename = '%s'",
+					filename.c_str());
+		long	imageid = imagetable.id(condition);
+		ImageInfoRecord	record = imagetable.byid(imageid);
+		record.filesize = fileSize(filename);
+		imagetable.update(imageid, record);
+
+		// replace the attributes, comment like entries are added
+		ImageAttributeTable	attributetable(_database);
+		for (auto m = metadata.begin(); m != metadata.end(); m++) {
+			if ((m->first != "HISTORY") && (m->first != "COMMENT")) {
+				condition = stringprintf("image = %ld and "
+					"name = '%s'", imageid,
+					m->first.c_str());
+				attributetable.remove(condition);
+			}
+			ImageAttributeRecord	attrs(0, imageid, *m);
+			attributetable.add(attrs);
+		}
+	} catch (const std::exception& x) {
+		std::string	msg = stringprintf("cannot update metadata of "
+			"%s in database: %s", filename.c_str(), x.what());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		_database->rollback();
+		throw std::runtime_error(msg);
+	}
+	_database->commit();
+}
+
 } // namespace image
 } // namespace astro
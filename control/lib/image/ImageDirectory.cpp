@@ -10,8 +10,10 @@
 #include <dirent.h>
 #include <unistd.h>
 #include <AstroIO.h>
+#include <ImageCache.h>
 #include <string.h>
 #include <errno.h>
+#include <algorithm>
 
 namespace astro {
 namespace image {
@@ -118,69 +120,15 @@ long	ImageDirectory::fileAge(const std::string& name) const {
  * \param filename	base name of the file
  */
 int	ImageDirectory::bytesPerPixel(const std::string& filename) const {
-	std::string	f = fullname(filename);
-	io::FITSinfileBase	infile(f);
-
-	switch (infile.getImgtype()) {
-	case BYTE_IMG:
-	case SBYTE_IMG:
-		return sizeof(unsigned char) * infile.getPlanes();
-	case USHORT_IMG:
-	case SHORT_IMG:
-		return sizeof(unsigned short) * infile.getPlanes();
-	case ULONG_IMG:
-	case LONG_IMG:
-		return sizeof(unsigned long) * infile.getPlanes();
-	case FLOAT_IMG:
-		return sizeof(float) * infile.getPlanes();
-	case DOUBLE_IMG:
-		return sizeof(double) * infile.getPlanes();
-	}
-	return 2;
+	return io::FITSinfileBase::header(fullname(filename))->getBytesPerPixel();
 }
 
 int	ImageDirectory::bytesPerPlane(const std::string& filename) const {
-	std::string	f = fullname(filename);
-	io::FITSinfileBase	infile(f);
-
-	switch (infile.getImgtype()) {
-	case BYTE_IMG:
-	case SBYTE_IMG:
-		return sizeof(unsigned char);
-	case USHORT_IMG:
-	case SHORT_IMG:
-		return sizeof(unsigned short);
-	case ULONG_IMG:
-	case LONG_IMG:
-		return sizeof(unsigned long);
-	case FLOAT_IMG:
-		return sizeof(float);
-	case DOUBLE_IMG:
-		return sizeof(double);
-	}
-	return 1;
+	return io::FITSinfileBase::header(fullname(filename))->getBytesPerPlane();
 }
 
 std::type_index	ImageDirectory::pixelType(const std::string& filename) const {
-	std::string	f = fullname(filename);
-	io::FITSinfileBase	infile(f);
-
-	switch (infile.getImgtype()) {
-	case BYTE_IMG:
-	case SBYTE_IMG:
-		return typeid(unsigned char);
-	case USHORT_IMG:
-	case SHORT_IMG:
-		return typeid(unsigned short);
-	case ULONG_IMG:
-	case LONG_IMG:
-		return typeid(unsigned int);
-	case FLOAT_IMG:
-		return typeid(float);
-	case DOUBLE_IMG:
-		return typeid(double);
-	}
-	throw std::runtime_error("pixel type not found");
+	return io::FITSinfileBase::header(fullname(filename))->getPixelType();
 }
 
 /**
@@ -319,6 +267,7 @@ void	ImageDirectory::remove(const std::string& filename) {
 			filename.c_str(), strerror(errno));
 		throw std::runtime_error("cannot remove file");
 	}
+	ImageCache::invalidate(fullname(filename));
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "file %s removed (unlink)",
 		filename.c_str());
 }
@@ -326,11 +275,51 @@ void	ImageDirectory::remove(const std::string& filename) {
 /**
  * \brief retrieve an image from the image directory
  *
+ * The image comes from the image cache and is shared with other users
+ * of the same file, so it must not be modified. Callers that want to
+ * change the image have to read the file with FITSin themselves.
+ *
  * \param filename	name of the image file
  */
 ImagePtr	ImageDirectory::getImagePtr(const std::string& filename) {
-	astro::io::FITSin	in(fullname(filename));
-	return in.read();
+	return ImageCache::get(fullname(filename));
+}
+
+/**
+ * \brief Prefetch the images following a file in the sorted file list
+ *
+ * Clients usually browse through the images of the directory in the
+ * order of the listing, so reading the following images in the
+ * background hides the time needed to decode them.
+ *
+ * \param filename	name of the image file currently in use
+ * \param count		number of following images to prefetch
+ */
+void	ImageDirectory::prefetch(const std::string& filename, int count) {
+	std::list<std::string>	names = fileList();
+	names.sort();
+	auto	i = std::find(names.begin(), names.end(), filename);
+	if (i == names.end()) {
+		return;
+	}
+	while ((count-- > 0) && (++i != names.end())) {
+		ImageCache::prefetch(fullname(*i));
+	}
+}
+
+/**
+ * \brief Find out whether an image has a meta value
+ *
+ * Only the header of the file is read, and it is cached, so repeated
+ * queries for the same file don't even open the file again.
+ *
+ * \param filename	name of the file
+ * \param keyword	keyword to query from the image
+ */
+bool	ImageDirectory::hasMetadata(const std::string& filename,
+			const std::string& keyword) {
+	return io::FITSinfileBase::header(fullname(filename))
+		->hasMetadata(keyword);
 }
 
 /**
@@ -341,22 +330,26 @@ ImagePtr	ImageDirectory::getImagePtr(const std::string& filename) {
  */
 Metavalue	ImageDirectory::getMetadata(const std::string& filename,
 			const std::string& keyword) {
-	return getImagePtr(filename)->getMetadata(keyword);
+	return io::FITSinfileBase::header(fullname(filename))
+		->getMetadata(keyword);
 }
 
 /**
  * \brief Set the meta data in an image
  *
+ * The keywords are changed in the header of the file, the pixel data
+ * is neither read nor written.
+ *
  * \param filename	name of the image file where to set the metaadta
  * \param metadata	metadata to set in the image
  */
 void	ImageDirectory::setMetadata(const std::string& filename,
 		const ImageMetadata& metadata) {
-	ImagePtr	image = getImagePtr(filename);
-	for (auto ptr = metadata.begin(); ptr != metadata.end(); ptr++) {
-		image->setMetadata(ptr->second);
+	{
+		io::FITSupdatefile	file(fullname(filename));
+		file.setMetadata(metadata);
 	}
-	write(image, filename);
+	ImageCache::invalidate(fullname(filename));
 }
 
 } // namespace image
@@ -75,6 +75,7 @@ public:
 	ImageMean(const ImageSequence& images, bool _enableVariance = false);
 	ImageMean(const ImageSequence& images, const Image<T>& dark,
 		bool _enableVariance = false);
+	ImageMean(ImagePtr meanimage, ImagePtr varianceimage);
 
 	T	mean(const Subgrid grid = Subgrid()) const;
 	T	mean(const ImageRectangle& rectangle,
@@ -276,7 +277,7 @@ void	ImageMean<T>::compute(int x, int y, T darkvalue) {
  */
 template<typename T>
 ImageMean<T>::ImageMean(const ImageSequence& images, bool _enableVariance)
-		: enableVariance(_enableVariance) {
+		: enableVariance(_enableVariance), k(3) {
 	// compute the PixelValue objects
 	setup_pv(images);
 
@@ -290,9 +291,6 @@ ImageMean<T>::ImageMean(const ImageSequence& images, bool _enableVariance)
 		}
 	}
 
-	// number of standard deviations for bad pixels
-	k = 3;
-
 	// compute statistics
 	statistics();
 }
@@ -307,7 +305,7 @@ ImageMean<T>::ImageMean(const ImageSequence& images, bool _enableVariance)
  */
 template<typename T>
 ImageMean<T>::ImageMean(const ImageSequence& images, const Image<T>& dark,
-	bool _enableVariance) : enableVariance(_enableVariance) {
+	bool _enableVariance) : enableVariance(_enableVariance), k(3) {
 	// compute the PixelValue objects
 	setup_pv(images);
 
@@ -322,8 +320,27 @@ ImageMean<T>::ImageMean(const ImageSequence& images, const Image<T>& dark,
 		}
 	}
 
-	// number of standard deviations for bad pixels
-	k = 3;
+	// compute statistics
+	statistics();
+}
+
+/**
+ * \brief Construct an ImageMean object from precomputed images
+ *
+ * This is used by the calibration frame builders, which compute mean
+ * and variance incrementally. The mean image should already carry the
+ * mosaic type and filter information of the images.
+ */
+template<typename T>
+ImageMean<T>::ImageMean(ImagePtr meanimage, ImagePtr varianceimage)
+	: enableVariance(true), k(3), imageptr(meanimage),
+	  varptr(varianceimage) {
+	size = imageptr->size();
+	image = dynamic_cast<Image<T> *>(&*imageptr);
+	var = dynamic_cast<Image<T> *>(&*varptr);
+	if ((NULL == image) || (NULL == var)) {
+		throw std::runtime_error("mean/variance have wrong pixel type");
+	}
 
 	// compute statistics
 	statistics();
@@ -0,0 +1,102 @@
+/*
+ * LayerStore.cpp -- temporary storage for transformed layers of a stack
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include "LayerStore.h"
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+
+namespace astro {
+namespace image {
+namespace stacking {
+
+/**
+ * \brief Construct an empty layer store
+ *
+ * \param size		size of the layers
+ * \param planes	number of color planes of each layer
+ * \param tilesize	size of the square tiles
+ */
+LayerStore::LayerStore(const ImageSize& size, int planes, int tilesize)
+	: _size(size), _planes(planes), _tilesize(tilesize) {
+	if ((_tilesize <= 0) || (_planes <= 0)) {
+		std::string	msg = stringprintf("bad layer store parameters: "
+			"tilesize = %d, planes = %d", _tilesize, _planes);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	_tilesx = (_size.width() + _tilesize - 1) / _tilesize;
+	_tilesy = (_size.height() + _tilesize - 1) / _tilesize;
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "layer store %s, %dx%d tiles of size %d",
+		_size.toString().c_str(), _tilesx, _tilesy, _tilesize);
+}
+
+/**
+ * \brief Destroy the layer store
+ *
+ * The temporary files disappear when they are closed.
+ */
+LayerStore::~LayerStore() {
+	std::vector<FILE *>::iterator	i;
+	for (i = _files.begin(); i != _files.end(); i++) {
+		fclose(*i);
+	}
+}
+
+/**
+ * \brief Create the temporary file for a new layer
+ */
+FILE	*LayerStore::newlayer() {
+	FILE	*file = tmpfile();
+	if (NULL == file) {
+		std::string	msg = stringprintf("cannot create layer file: %s",
+			strerror(errno));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	_files.push_back(file);
+	return file;
+}
+
+/**
+ * \brief Append a tile to a layer file
+ */
+void	LayerStore::write(FILE *file, const std::vector<float>& tile) {
+	if (tile.size() != fwrite(tile.data(), sizeof(float), tile.size(),
+		file)) {
+		std::string	msg = stringprintf("cannot write layer tile: %s",
+			strerror(errno));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+}
+
+/**
+ * \brief Read a tile of a layer
+ *
+ * \param layer		the layer index
+ * \param tx		the horizontal tile index
+ * \param ty		the vertical tile index
+ * \param tile		buffer for the tile values
+ */
+void	LayerStore::read(int layer, int tx, int ty, float *tile) const {
+	FILE	*file = _files[layer];
+	size_t	bytes = tilevalues() * sizeof(float);
+	off_t	offset = ((off_t)ty * _tilesx + tx) * bytes;
+	ssize_t	rc = pread(fileno(file), tile, bytes, offset);
+	if (rc != (ssize_t)bytes) {
+		std::string	msg = stringprintf("cannot read tile (%d,%d) "
+			"of layer %d: %s", tx, ty, layer,
+			(rc < 0) ? strerror(errno) : "short read");
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+}
+
+} // namespace stacking
+} // namespace image
+} // namespace astro
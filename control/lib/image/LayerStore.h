@@ -0,0 +1,170 @@
+/*
+ * LayerStore.h -- temporary storage for transformed layers of a stack
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#ifndef _LayerStore_h
+#define _LayerStore_h
+
+#include <AstroStacking.h>
+#include <AstroAdapter.h>
+#include <cstdio>
+
+namespace astro {
+namespace image {
+namespace stacking {
+
+// access to the color planes of accumulator pixels
+static inline double	planevalue(float v, int) { return v; }
+static inline double	planevalue(double v, int) { return v; }
+template<typename T>
+static inline double	planevalue(const RGB<T>& v, int plane) {
+	switch (plane) {
+	case 0:	return v.R;
+	case 1:	return v.G;
+	}
+	return v.B;
+}
+
+static inline void	setplane(float& p, int, double v) { p = v; }
+static inline void	setplane(double& p, int, double v) { p = v; }
+template<typename T>
+static inline void	setplane(RGB<T>& p, int plane, double v) {
+	switch (plane) {
+	case 0:	p.R = v; return;
+	case 1:	p.G = v; return;
+	}
+	p.B = v;
+}
+
+/**
+ * \brief Storage for the layers of a stack in temporary files
+ *
+ * Each layer is written to an anonymous temporary file as float values,
+ * organized in square tiles, so that the values of a tile in all layers
+ * can be read with a single read per layer. This keeps the memory needed
+ * for rejection stacking at one tile per layer, independent of the size
+ * of the images.
+ */
+class LayerStore {
+	ImageSize	_size;
+	int	_planes;
+	int	_tilesize;
+	int	_tilesx;
+	int	_tilesy;
+	std::vector<FILE *>	_files;
+	size_t	tilevalues() const {
+		return (size_t)_tilesize * _tilesize * _planes;
+	}
+	FILE	*newlayer();
+	void	write(FILE *file, const std::vector<float>& tile);
+	void	read(int layer, int tx, int ty, float *tile) const;
+public:
+	LayerStore(const ImageSize& size, int planes, int tilesize);
+	~LayerStore();
+	int	layers() const { return _files.size(); }
+	const ImageSize&	size() const { return _size; }
+
+	template<typename P>
+	void	add(const ConstImageAdapter<P>& image);
+
+	template<typename P>
+	ImagePtr	combine(const Combiner& combiner) const;
+};
+typedef std::shared_ptr<LayerStore>	LayerStorePtr;
+
+/**
+ * \brief Add a layer to the store
+ */
+template<typename P>
+void	LayerStore::add(const ConstImageAdapter<P>& image) {
+	if (image.getSize() != _size) {
+		throw std::runtime_error("image sizes in stack don't match");
+	}
+	FILE	*file = newlayer();
+	std::vector<float>	tile(tilevalues());
+	for (int ty = 0; ty < _tilesy; ty++) {
+		for (int tx = 0; tx < _tilesx; tx++) {
+			std::fill(tile.begin(), tile.end(), 0.f);
+			int	x0 = tx * _tilesize;
+			int	y0 = ty * _tilesize;
+			int	x1 = std::min(x0 + _tilesize, _size.width());
+			int	y1 = std::min(y0 + _tilesize, _size.height());
+			for (int y = y0; y < y1; y++) {
+				for (int x = x0; x < x1; x++) {
+					P	p = image.pixel(x, y);
+					size_t	offset = ((y - y0) * _tilesize
+							+ (x - x0)) * _planes;
+					for (int plane = 0; plane < _planes;
+						plane++) {
+						tile[offset + plane]
+							= planevalue(p, plane);
+					}
+				}
+			}
+			write(file, tile);
+		}
+	}
+	fflush(file);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "layer %d stored", layers() - 1);
+}
+
+/**
+ * \brief Combine all layers tile by tile
+ *
+ * The result is scaled by the number of layers, so that it has the
+ * same scale as the sum computed by the SUM method.
+ */
+template<typename P>
+ImagePtr	LayerStore::combine(const Combiner& combiner) const {
+	Image<P>	*result = new Image<P>(_size);
+	ImagePtr	resultptr(result);
+	int	n = layers();
+	if (n == 0) {
+		result->fill(P(0));
+		return resultptr;
+	}
+	size_t	tv = tilevalues();
+	std::vector<float>	tiles(n * tv);
+	int	pixels = _tilesize * _tilesize;
+	for (int ty = 0; ty < _tilesy; ty++) {
+		for (int tx = 0; tx < _tilesx; tx++) {
+			for (int l = 0; l < n; l++) {
+				read(l, tx, ty, &tiles[l * tv]);
+			}
+			int	x0 = tx * _tilesize;
+			int	y0 = ty * _tilesize;
+			int	w = std::min(_tilesize, _size.width() - x0);
+			int	h = std::min(_tilesize, _size.height() - y0);
+#pragma omp parallel
+			{
+			std::vector<double>	values(n);
+#pragma omp for
+			for (int i = 0; i < pixels; i++) {
+				int	x = i % _tilesize;
+				int	y = i / _tilesize;
+				if ((x >= w) || (y >= h)) {
+					continue;
+				}
+				P	p;
+				for (int plane = 0; plane < _planes; plane++) {
+					for (int l = 0; l < n; l++) {
+						values[l] = tiles[l * tv
+							+ i * _planes + plane];
+					}
+					setplane(p, plane, n * combiner(values));
+				}
+				result->pixel(x0 + x, y0 + y) = p;
+			}
+			}
+		}
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%d layers combined", n);
+	return resultptr;
+}
+
+} // namespace stacking
+} // namespace image
+} // namespace astro
+
+#endif /* _LayerStore_h */
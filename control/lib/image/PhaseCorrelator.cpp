@@ -9,8 +9,10 @@
 #include <AstroAdapter.h>
 #include <AstroFilter.h>
 #include <AstroIO.h>
+#include <AstroConvolve.h>
 #include <fftw3.h>
 #include <includes.h>
+#include <atomic>
 
 using namespace astro::adapter;
 using namespace astro::io;
@@ -19,7 +21,7 @@ namespace astro {
 namespace image {
 namespace transform {
 
-static unsigned int	correlation_counter = 1;
+static std::atomic<unsigned int>	correlation_counter(1);
 
 static inline double	sqr(double x) {
 	return x * x;
@@ -111,9 +113,10 @@ void	PhaseCorrelator::write(const Image<double>& image) {
 			_imagedir.c_str());
 		return;
 	}
+	// correlators may run in several threads at the same time
+	unsigned int	counter = correlation_counter++;
 	std::string	filename = stringprintf("%s/%s-%05d.fits",
-		_imagedir.c_str(), _prefix.c_str(),
-		correlation_counter);
+		_imagedir.c_str(), _prefix.c_str(), counter);
 	try {
 		FITSoutfile<double>	out(filename);
 		out.setPrecious(false);
@@ -125,28 +128,75 @@ void	PhaseCorrelator::write(const Image<double>& image) {
 			x.what());
 	}
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "file %s written, counter = %d",
-		filename.c_str(), correlation_counter);
-	correlation_counter++;
+		filename.c_str(), counter);
 }
 
 /**
- * \brief Find displacement between two images using phase correlation.
+ * \brief Fill an fftw array with the pixels of an adapter
+ */
+static void	fill(double *a, const ConstImageAdapter<double>& image) {
+	ImageSize	size = image.getSize();
+	int	w = size.width();
+	int	h = size.height();
+	for (int y = 0; y < h; y++) {
+		for (int x = 0; x < w; x++) {
+			a[size.offset(x, y)] = image.pixel(x, y);
+		}
+	}
+}
+
+/**
+ * \brief Compute the windowed reference image and its spectrum
  *
- * This method applies a Hanning window to the two images, computes the
- * Fourier transforms, takes the product (with the first fourier transform
- * complex conjugated) and computes the reverse transform. Then the maximum
- * is found and a 5x5 centroid around the maximum computed. This gives
- * subpixel accuracy for image translations.
+ * The reference arrays are allocated anew, copies of the correlator
+ * that share the previous reference are not affected.
  */
-std::pair<Point, double> PhaseCorrelator::operator()(
-		const ConstImageAdapter<double>& fromimage,
-		const ConstImageAdapter<double>& toimage) {
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "correlating images %s ~ %s",
-		fromimage.getSize().toString().c_str(),
-		toimage.getSize().toString().c_str());
+void	PhaseCorrelator::prepare(const ConstImageAdapter<double>& fromimage) {
+	_size = fromimage.getSize();
+	size_t	n = _size.getPixels();
+	size_t	nc = _size.height() * (1 + _size.width() / 2);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "pixel count: %lu, "
+		"fourier transform pixel count: %lu", n, nc);
+	_reference = std::shared_ptr<double>(fftw_alloc_real(n), fftw_free);
+	_spectrum = std::shared_ptr<double>(
+		(double *)fftw_alloc_complex(nc), fftw_free);
+	_work = std::shared_ptr<double>(fftw_alloc_real(n), fftw_free);
+	_workspectrum = std::shared_ptr<double>(
+		(double *)fftw_alloc_complex(nc), fftw_free);
 
-	// ensure that both images are of the same size
-	ImageSize	size = fromimage.getSize();
+	// apply the window to the reference image
+	if (_hanning) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "using Hanning windows");
+		HanningWindow	windowed(fromimage);
+		fill(_reference.get(), windowed);
+	} else {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "using Rectangular windows");
+		RectangleWindow	windowed(fromimage);
+		fill(_reference.get(), windowed);
+	}
+
+	// the real to complex transform preserves its input, so the
+	// windowed reference remains available for the debug images
+	FFTWPlans::r2c(_size, _reference.get(),
+		(fftw_complex *)_spectrum.get());
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "reference %s prepared",
+		_size.toString().c_str());
+}
+
+/**
+ * \brief Correlate an image with the prepared reference
+ *
+ * This only needs the transform of the new image and the inverse
+ * transform of the product with the reference spectrum.
+ */
+std::pair<Point, double>	PhaseCorrelator::compute(
+		const ConstImageAdapter<double>& toimage) {
+	if (!_spectrum) {
+		std::string	msg("no reference for phase correlation");
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	ImageSize	size = _size;
 	if (size != toimage.getSize()) {
 		std::string	msg = stringprintf("images differ in size: "
 			"%s != %s", size.toString().c_str(),
@@ -154,73 +204,39 @@ std::pair<Point, double> PhaseCorrelator::operator()(
 		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
 		throw std::runtime_error(msg);
 	}
-	size_t	n = size.getPixels();
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "image has %lu pixels", n);
-	
-	// allocate memory for the images
-	double	*a = new double[n];
-	double	*b = new double[n];
-
-	// allocate memory for the fourier transforms
-	size_t	nc = size.width() * (1 + size.height() / 2);
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "pixel count: %lu, "
-		"fourier transform pixel count: %lu", n, nc);
-	fftw_complex	*af = (fftw_complex *)fftw_malloc(
-					sizeof(fftw_complex) * nc);
-	fftw_complex	*bf = (fftw_complex *)fftw_malloc(
-					sizeof(fftw_complex) * nc);
-
-	// create a plan for the fourier transform
-	fftw_plan	p = fftw_plan_dft_r2c_2d(size.height(), size.width(),
-				a, af, 0);
-	fftw_plan	q = fftw_plan_dft_r2c_2d(size.height(), size.width(),
-				b, bf, 0);
+	size_t	nc = size.height() * (1 + size.width() / 2);
+	double	*b = _work.get();
+	fftw_complex	*af = (fftw_complex *)_spectrum.get();
+	fftw_complex	*bf = (fftw_complex *)_workspectrum.get();
 
-	// we also already need a back transform
-	fftw_plan	r = fftw_plan_dft_c2r_2d(size.height(), size.width(),
-				af, a, 0);
-
-	// compute the values for the hanning windows
-	const ConstImageAdapter<double>	*windowedfrom = NULL;
+	// copy the image into the work array, applying the window
 	const ConstImageAdapter<double>	*windowedto = NULL;
 	if (_hanning) {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "using Hanning windows");
-		windowedfrom = new HanningWindow(fromimage);
 		windowedto = new HanningWindow(toimage);
 	} else {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "using Rectangular windows");
-		windowedfrom = new RectangleWindow(fromimage);
 		windowedto = new IdentityAdapter<double>(toimage);
 	}
+	fill(b, *windowedto);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "applied window to image");
 
-	// now copy the data into the arrays, applying the hanning window
-	// at the same time
-	for (int x = 0; x < size.width(); x++) {
-		for (int y = 0; y < size.height(); y++) {
-			a[size.offset(x, y)] = windowedfrom->pixel(x, y);
-			b[size.offset(x, y)] = windowedto->pixel(x, y);
-		}
-	}
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "applied window to both images");
-
-	// now compute the fourier transforms
-	fftw_execute(p);
-	fftw_execute(q);
+	// now compute the fourier transform, the plans come from the
+	// plan cache because this is called for every guide image
+	FFTWPlans::r2c(size, b, bf);
 
 	// compute the product of the two fourier transforms
 	for (unsigned int i = 0; i < nc; i++) {
 		fftw_complex	product;
 		product[0] =  af[i][0] * bf[i][0] + af[i][1] * bf[i][1];
 		product[1] = -af[i][1] * bf[i][0] + af[i][0] * bf[i][1];
-		af[i][0] = product[0];
-		af[i][1] = product[1];
+		bf[i][0] = product[0];
+		bf[i][1] = product[1];
 	}
 
 	// perform the reverse Fourier transform
-	fftw_execute(r);
+	FFTWPlans::c2r(size, bf, b);
 
 	// construct an adapter tothe array containing the fourier transform
-	ArrayAdapter<double>	aa(a, size);
+	ArrayAdapter<double>	aa(b, size);
 	ImagePoint	center(size.width() / 2, size.height() / 2);
 	TilingAdapter<double>	ta(aa, center);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "center of %s image: %s",
@@ -241,14 +257,17 @@ std::pair<Point, double> PhaseCorrelator::operator()(
 	filter::PeakFinder	pf(maxcandidate, 20);
 	Point	result = pf(ta) - center;
 
-	// if required, write everything into a single image
-	if ((result.x() == result.x()) && (result.y() == result.y())) {
+	// if required, write everything into a single image, this is
+	// only needed when debugging
+	if ((debuglevel >= LOG_DEBUG)
+		&& (result.x() == result.x()) && (result.y() == result.y())) {
 		Image<double>	composite(3 * size.width(), size.height());
 
 		// copy the from image into a subimage at left
 		SubimageAdapter<double>	fromsubimage(composite,
 			ImageRectangle(ImagePoint(0,0), size));
-		RangeNormalizationAdapter<double>	fromnorm(*windowedfrom);
+		ArrayAdapter<double>	windowedfrom(_reference.get(), size);
+		RangeNormalizationAdapter<double>	fromnorm(windowedfrom);
 		copy(fromsubimage, fromnorm);
 
 		// copy the from image into a subimage at center
@@ -270,30 +289,68 @@ std::pair<Point, double> PhaseCorrelator::operator()(
 			FITSKeywords::meta(std::string("YOFFSET"), result.y()));
 		write(composite);
 	}
-	
-	// clean up the memory allocated
-	fftw_destroy_plan(r);
-	fftw_destroy_plan(q);
-	fftw_destroy_plan(p);
-	fftw_free(af);
-	fftw_free(bf);
-	fftw_cleanup();
-
-	// we should now remove the window adapters
-	if (windowedfrom) { delete windowedfrom; windowedfrom = NULL; }
-	if (windowedto)   { delete windowedto;   windowedto = NULL;   }
 
-	// at this point we no longer need the a and b arrays, so we free
-	// them in order not to forget this later
-	delete[] a;
-	delete[] b;
+	// we should now remove the window adapter
+	delete windowedto;
 
 	// result
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "[%d] translation: %s",
-		correlation_counter - 1, result.toString().c_str());
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "translation: %s",
+		result.toString().c_str());
 	return std::make_pair(result, max);
 }
 
+/**
+ * \brief Prepare the reference image for subsequent correlations
+ *
+ * The window is applied to the reference image and its Fourier transform
+ * is computed once, so that each call to correlate() only has to
+ * transform the new image.
+ */
+void	PhaseCorrelator::reference(const ConstImageAdapter<double>& fromimage) {
+	prepare(fromimage);
+}
+
+/**
+ * \brief Find the displacement of an image relative to the reference
+ */
+std::pair<Point, double>	PhaseCorrelator::correlate(
+		const ConstImageAdapter<double>& toimage) {
+	return compute(toimage);
+}
+
+/**
+ * \brief Find displacement between two images using phase correlation.
+ *
+ * This method applies a Hanning window to the two images, computes the
+ * Fourier transforms, takes the product (with the first fourier transform
+ * complex conjugated) and computes the reverse transform. Then the maximum
+ * is found and a 5x5 centroid around the maximum computed. This gives
+ * subpixel accuracy for image translations.
+ *
+ * The from image becomes the reference of the correlator. If many images
+ * are correlated with the same image, it is cheaper to call reference()
+ * once and then correlate() for each image.
+ */
+std::pair<Point, double> PhaseCorrelator::operator()(
+		const ConstImageAdapter<double>& fromimage,
+		const ConstImageAdapter<double>& toimage) {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "correlating images %s ~ %s",
+		fromimage.getSize().toString().c_str(),
+		toimage.getSize().toString().c_str());
+
+	// ensure that both images are of the same size
+	ImageSize	size = fromimage.getSize();
+	if (size != toimage.getSize()) {
+		std::string	msg = stringprintf("images differ in size: "
+			"%s != %s", size.toString().c_str(),
+			toimage.getSize().toString().c_str());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	prepare(fromimage);
+	return compute(toimage);
+}
+
 
 } // namespace transform
 } // namespace image
@@ -0,0 +1,155 @@
+/*
+ * PointTree.cpp -- two dimensional k-d tree
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroTransform.h>
+#include <algorithm>
+#include <limits>
+
+namespace astro {
+namespace image {
+namespace transform {
+
+static double	coordinate(const Point& point, bool xaxis) {
+	return (xaxis) ? point.x() : point.y();
+}
+
+static double	distance2(const Point& a, const Point& b) {
+	double	dx = a.x() - b.x();
+	double	dy = a.y() - b.y();
+	return dx * dx + dy * dy;
+}
+
+/**
+ * \brief Build the tree for a set of points
+ */
+PointTree::PointTree(const std::vector<Point>& points) : _points(points) {
+	_tree.resize(_points.size());
+	for (size_t i = 0; i < _tree.size(); i++) {
+		_tree[i] = i;
+	}
+	build(0, _tree.size(), true);
+}
+
+/**
+ * \brief Partition a range so that the middle element splits it
+ */
+void	PointTree::build(int lo, int hi, bool xaxis) {
+	if (hi - lo < 2) {
+		return;
+	}
+	int	mid = (lo + hi) / 2;
+	std::nth_element(_tree.begin() + lo, _tree.begin() + mid,
+		_tree.begin() + hi,
+		[&](int a, int b) {
+			return coordinate(_points[a], xaxis)
+				< coordinate(_points[b], xaxis);
+		}
+	);
+	build(lo, mid, !xaxis);
+	build(mid + 1, hi, !xaxis);
+}
+
+/**
+ * \brief Collect the k nearest points of a range in a max heap
+ */
+void	PointTree::nearest(int lo, int hi, bool xaxis, const Point& point,
+		unsigned int k,
+		std::vector<std::pair<double, int> >& heap) const {
+	if (lo >= hi) {
+		return;
+	}
+	int	mid = (lo + hi) / 2;
+	int	i = _tree[mid];
+	double	d2 = distance2(point, _points[i]);
+	if (heap.size() < k) {
+		heap.push_back(std::make_pair(d2, i));
+		std::push_heap(heap.begin(), heap.end());
+	} else if (d2 < heap.front().first) {
+		std::pop_heap(heap.begin(), heap.end());
+		heap.back() = std::make_pair(d2, i);
+		std::push_heap(heap.begin(), heap.end());
+	}
+	// search the side containing the point first, the other side only
+	// if the splitting line is closer than the worst point found
+	double	delta = coordinate(point, xaxis) - coordinate(_points[i], xaxis);
+	if (delta < 0) {
+		nearest(lo, mid, !xaxis, point, k, heap);
+	} else {
+		nearest(mid + 1, hi, !xaxis, point, k, heap);
+	}
+	if ((heap.size() < k) || (delta * delta < heap.front().first)) {
+		if (delta < 0) {
+			nearest(mid + 1, hi, !xaxis, point, k, heap);
+		} else {
+			nearest(lo, mid, !xaxis, point, k, heap);
+		}
+	}
+}
+
+/**
+ * \brief Collect all points of a range within a radius
+ */
+void	PointTree::within(int lo, int hi, bool xaxis, const Point& point,
+		double radius, std::vector<int>& result) const {
+	if (lo >= hi) {
+		return;
+	}
+	int	mid = (lo + hi) / 2;
+	int	i = _tree[mid];
+	if (distance2(point, _points[i]) <= radius * radius) {
+		result.push_back(i);
+	}
+	double	delta = coordinate(point, xaxis) - coordinate(_points[i], xaxis);
+	if (delta <= radius) {
+		within(lo, mid, !xaxis, point, radius, result);
+	}
+	if (delta >= -radius) {
+		within(mid + 1, hi, !xaxis, point, radius, result);
+	}
+}
+
+/**
+ * \brief Find the index of the point closest to a point
+ *
+ * \return	the index of the closest point, or -1 if the tree is empty
+ */
+int	PointTree::nearest(const Point& point) const {
+	std::vector<std::pair<double, int> >	heap;
+	nearest(0, _tree.size(), true, point, 1, heap);
+	return (heap.size()) ? heap.front().second : -1;
+}
+
+/**
+ * \brief Find the indices of the k points closest to a point
+ *
+ * The indices are ordered by increasing distance.
+ */
+std::vector<int>	PointTree::nearest(const Point& point,
+				unsigned int k) const {
+	std::vector<std::pair<double, int> >	heap;
+	if (k > 0) {
+		nearest(0, _tree.size(), true, point, k, heap);
+	}
+	std::sort_heap(heap.begin(), heap.end());
+	std::vector<int>	result;
+	for (auto ptr = heap.begin(); ptr != heap.end(); ptr++) {
+		result.push_back(ptr->second);
+	}
+	return result;
+}
+
+/**
+ * \brief Find the indices of all points within a radius of a point
+ */
+std::vector<int>	PointTree::within(const Point& point,
+				double radius) const {
+	std::vector<int>	result;
+	within(0, _tree.size(), true, point, radius, result);
+	return result;
+}
+
+} // namespace transform
+} // namespace image
+} // namespace astro
@@ -0,0 +1,241 @@
+/*
+ * RiceCoder.cpp -- lossless delta/Rice compression of 16 bit pixel arrays
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroIO.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <stdint.h>
+
+namespace astro {
+namespace io {
+
+// the Rice parameter is written with 5 bits, the largest parameter needed
+// for zigzag mapped 16 bit differences is 16, the code 31 marks a block
+// of values that are written uncompressed with 17 bits each.
+#define	RICE_PARAMETER_BITS	5
+#define	RICE_MAX_PARAMETER	16
+#define	RICE_RAW_BLOCK		31
+#define	RICE_RAW_BITS		17
+
+/**
+ * \brief Bit writer appending to a byte vector
+ */
+class RiceBitWriter {
+	std::vector<unsigned char>&	_data;
+	uint64_t	_accumulator;
+	int	_bits;
+	void	drain() {
+		while (_bits >= 8) {
+			_bits -= 8;
+			_data.push_back((_accumulator >> _bits) & 0xff);
+		}
+	}
+public:
+	RiceBitWriter(std::vector<unsigned char>& data)
+		: _data(data), _accumulator(0), _bits(0) { }
+	void	put(uint32_t value, int count) {
+		_accumulator = (_accumulator << count)
+			| (value & ((((uint64_t)1) << count) - 1));
+		_bits += count;
+		drain();
+	}
+	void	unary(uint32_t q) {
+		while (q >= 24) {
+			put(0xffffff, 24);
+			q -= 24;
+		}
+		// q one bits followed by a zero bit
+		put(((1 << q) - 1) << 1, q + 1);
+	}
+	void	flush() {
+		if (_bits > 0) {
+			put(0, 8 - _bits);
+		}
+	}
+};
+
+/**
+ * \brief Bit reader for the compressed data
+ */
+class RiceBitReader {
+	const unsigned char	*_data;
+	size_t	_datasize;
+	size_t	_offset;
+	uint64_t	_accumulator;
+	int	_bits;
+	void	fill() {
+		while ((_bits <= 56) && (_offset < _datasize)) {
+			_accumulator |= ((uint64_t)_data[_offset++])
+						<< (56 - _bits);
+			_bits += 8;
+		}
+		if (_bits <= 0) {
+			throw std::runtime_error("compressed data truncated");
+		}
+	}
+public:
+	RiceBitReader(const unsigned char *data, size_t datasize)
+		: _data(data), _datasize(datasize), _offset(0),
+		  _accumulator(0), _bits(0) { }
+	uint32_t	get(int count) {
+		if (count == 0) {
+			return 0;
+		}
+		if (_bits < count) {
+			fill();
+			if (_bits < count) {
+				throw std::runtime_error(
+					"compressed data truncated");
+			}
+		}
+		uint32_t	result = _accumulator >> (64 - count);
+		_accumulator <<= count;
+		_bits -= count;
+		return result;
+	}
+	uint32_t	unary() {
+		uint32_t	q = 0;
+		while (1) {
+			if (_bits == 0) {
+				fill();
+			}
+			// count the leading one bits in the accumulator
+			uint64_t	inverted = ~_accumulator;
+			int	ones = (inverted == 0) ? 64
+					: __builtin_clzll(inverted);
+			if (ones < _bits) {
+				q += ones;
+				_accumulator = (ones == 63) ? 0
+					: (_accumulator << (ones + 1));
+				_bits -= ones + 1;
+				return q;
+			}
+			q += _bits;
+			_accumulator = 0;
+			_bits = 0;
+		}
+	}
+};
+
+/**
+ * \brief Map a signed difference to an unsigned value
+ */
+static inline uint32_t	zigzag(int32_t d) {
+	return (d >= 0) ? (((uint32_t)d) << 1) : ((((uint32_t)(-d)) << 1) - 1);
+}
+
+static inline int32_t	unzigzag(uint32_t v) {
+	return (v & 1) ? -(int32_t)((v + 1) >> 1) : (int32_t)(v >> 1);
+}
+
+/**
+ * \brief Construct a Rice coder
+ *
+ * \param blocksize	number of values sharing the same Rice parameter
+ */
+RiceCoder::RiceCoder(int blocksize) : _blocksize(blocksize) {
+	if (_blocksize <= 0) {
+		throw std::runtime_error("Rice block size must be positive");
+	}
+}
+
+/**
+ * \brief Compress an array of 16 bit values
+ *
+ * \param values	the values to compress
+ * \param n		the number of values
+ * \param result	the vector the compressed data is appended to
+ */
+void	RiceCoder::encode(const unsigned short *values, size_t n,
+		std::vector<unsigned char>& result) const {
+	RiceBitWriter	writer(result);
+	std::vector<uint32_t>	mapped(_blocksize);
+	int32_t	previous = 0;
+	for (size_t offset = 0; offset < n; offset += _blocksize) {
+		size_t	m = std::min((size_t)_blocksize, n - offset);
+
+		// compute the differences of the block
+		uint64_t	sum = 0;
+		for (size_t i = 0; i < m; i++) {
+			int32_t	value = values[offset + i];
+			mapped[i] = zigzag(value - previous);
+			previous = value;
+			sum += mapped[i];
+		}
+
+		// estimate the Rice parameter from the mean value, and
+		// check the neighbouring parameters for the exact cost
+		uint64_t	mean = sum / m;
+		int	k0 = 0;
+		while ((k0 < RICE_MAX_PARAMETER) && ((mean >> k0) > 1)) {
+			k0++;
+		}
+		int	bestk = RICE_RAW_BLOCK;
+		uint64_t	bestcost = RICE_RAW_BITS * m;
+		for (int k = std::max(0, k0 - 1);
+			k <= std::min(RICE_MAX_PARAMETER, k0 + 1); k++) {
+			uint64_t	cost = m * (1 + k);
+			for (size_t i = 0; i < m; i++) {
+				cost += mapped[i] >> k;
+			}
+			if (cost < bestcost) {
+				bestcost = cost;
+				bestk = k;
+			}
+		}
+
+		// write the block
+		writer.put(bestk, RICE_PARAMETER_BITS);
+		if (bestk == RICE_RAW_BLOCK) {
+			for (size_t i = 0; i < m; i++) {
+				writer.put(mapped[i], RICE_RAW_BITS);
+			}
+			continue;
+		}
+		for (size_t i = 0; i < m; i++) {
+			writer.unary(mapped[i] >> bestk);
+			writer.put(mapped[i], bestk);
+		}
+	}
+	writer.flush();
+}
+
+/**
+ * \brief Decompress an array of 16 bit values
+ *
+ * \param data		the compressed data
+ * \param datasize	the size of the compressed data
+ * \param values	the array to receive the values
+ * \param n		the number of values to decompress
+ */
+void	RiceCoder::decode(const unsigned char *data, size_t datasize,
+		unsigned short *values, size_t n) const {
+	RiceBitReader	reader(data, datasize);
+	int32_t	previous = 0;
+	for (size_t offset = 0; offset < n; offset += _blocksize) {
+		size_t	m = std::min((size_t)_blocksize, n - offset);
+		int	k = reader.get(RICE_PARAMETER_BITS);
+		if ((k > RICE_MAX_PARAMETER) && (k != RICE_RAW_BLOCK)) {
+			std::string	msg = stringprintf("bad Rice parameter "
+				"%d at offset %lu", k, offset);
+			debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+			throw std::runtime_error(msg);
+		}
+		for (size_t i = 0; i < m; i++) {
+			uint32_t	v;
+			if (k == RICE_RAW_BLOCK) {
+				v = reader.get(RICE_RAW_BITS);
+			} else {
+				uint32_t	q = reader.unary();
+				v = (q << k) | reader.get(k);
+			}
+			previous += unzigzag(v);
+			values[offset + i] = previous;
+		}
+	}
+}
+
+} // namespace io
+} // namespace astro
@@ -9,7 +9,9 @@
 #include <AstroTransform.h>
 #include <AstroFilter.h>
 #include <cmath>
+#include <vector>
 #include "ReductionAdapter.h"
+#include "LayerStore.h"
 
 using namespace astro::image;
 using namespace astro::image::transform;
@@ -82,15 +84,23 @@ void	Accumulator<AccumulatorPixel, Pixel>::accumulate(
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "accumulating new image: %d",
 		_counter++);
 
-	// add new pixels
+	// add new pixels row by row, so that each thread works on
+	// contiguous memory
 	int	w = _imageptr->size().width();
 	int	h = _imageptr->size().height();
-	for (int x = 0; x < w; x++) {
-		for (int y = 0; y < h; y++) {
-			_imageptr->pixel(x, y)
-				= _imageptr->pixel(x, y) + add.pixel(x, y);
+#pragma omp parallel
+	{
+	std::vector<AccumulatorPixel>	row(w);
+#pragma omp for schedule(static)
+	for (int y = 0; y < h; y++) {
+		add.readrow(y, 0, w, row.data());
+		AccumulatorPixel	*p = _imageptr->pixels
+					+ _imageptr->pixeloffset(0, y);
+		for (int x = 0; x < w; x++) {
+			p[x] = p[x] + row[x];
 		}
 	}
+	}
 }
 
 Transform	Stacker::findtransform(const ConstImageAdapter<double>& base,
@@ -205,6 +215,8 @@ class MonochromeStacker : public Stacker {
 		return dynamic_cast<Image<Pixel>*>(&*_baseimage);
 	}
 	Accumulator<AccumulatorPixel, Pixel>	_accumulator;
+	LayerStorePtr	_layers;
+	void	accumulate(const ConstImageAdapter<AccumulatorPixel>& image);
 public:
 	MonochromeStacker(ImagePtr baseimage_ptr)
 		: Stacker(baseimage_ptr), _accumulator(baseimage()) {
@@ -216,10 +228,37 @@ public:
 	void	add(const ConstImageAdapter<Pixel>& image,
 			Transform initial_transform);
 	void	add(ImagePtr imageptr, Transform initial_transform);
-	ImagePtr	image() {
+	ImagePtr	image();
+};
+
+/**
+ * \brief Add a layer to the accumulator or to the layer store
+ */
+template<typename AccumulatorPixel, typename Pixel>
+void	MonochromeStacker<AccumulatorPixel, Pixel>::accumulate(
+		const ConstImageAdapter<AccumulatorPixel>& image) {
+	if (method() == SUM) {
+		_accumulator.accumulate(image);
+		return;
+	}
+	if (!_layers) {
+		_layers = LayerStorePtr(new LayerStore(image.getSize(), 1,
+			tilesize()));
+	}
+	_layers->add(image);
+}
+
+/**
+ * \brief Get the stacked image
+ */
+template<typename AccumulatorPixel, typename Pixel>
+ImagePtr	MonochromeStacker<AccumulatorPixel, Pixel>::image() {
+	if ((method() == SUM) || (!_layers)) {
 		return _accumulator.image();
 	}
-};
+	Combiner	combiner(method(), kappa(), iterations());
+	return _layers->combine<AccumulatorPixel>(combiner);
+}
 
 template<typename AccumulatorPixel, typename Pixel>
 void	MonochromeStacker<AccumulatorPixel, Pixel>::add(
@@ -229,7 +268,7 @@ void	MonochromeStacker<AccumulatorPixel, Pixel>::add(
 	if (notransform()) {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "accumulate with no transform");
 		ConvertingAdapter<AccumulatorPixel, Pixel>	accumulatorimage(image);
-		_accumulator.accumulate(accumulatorimage);
+		accumulate(accumulatorimage);
 		return;
 	}
 
@@ -251,7 +290,7 @@ void	MonochromeStacker<AccumulatorPixel, Pixel>::add(
 	// create an adapter that applies the transform to the image
 	TransformAdapter<AccumulatorPixel>	transformadapter(
 		accumulatorimage, transform.inverse(), false);
-	_accumulator.accumulate(transformadapter);
+	accumulate(transformadapter);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "image added");
 }
 
@@ -275,6 +314,9 @@ class RGBStacker : public Stacker {
 		return dynamic_cast<Image<RGB<Pixel> >*>(&*_baseimageptr);
 	}
 	Accumulator<RGB<AccumulatorPixel>, RGB<Pixel> >	_accumulator;
+	LayerStorePtr	_layers;
+	void	accumulate(
+		const ConstImageAdapter<RGB<AccumulatorPixel> >& image);
 public:
 	RGBStacker(ImagePtr baseimageptr) : Stacker(baseimageptr),
 		_baseimageptr(baseimageptr), _accumulator(baseimage()) {
@@ -291,10 +333,37 @@ public:
 
 	void	add(ImagePtr imageptr, Transform inital_transform);
 	
-	ImagePtr	image() {
+	ImagePtr	image();
+};
+
+/**
+ * \brief Add a layer to the accumulator or to the layer store
+ */
+template<typename AccumulatorPixel, typename Pixel>
+void	RGBStacker<AccumulatorPixel, Pixel>::accumulate(
+		const ConstImageAdapter<RGB<AccumulatorPixel> >& image) {
+	if (method() == SUM) {
+		_accumulator.accumulate(image);
+		return;
+	}
+	if (!_layers) {
+		_layers = LayerStorePtr(new LayerStore(image.getSize(), 3,
+			tilesize()));
+	}
+	_layers->add(image);
+}
+
+/**
+ * \brief Get the stacked image
+ */
+template<typename AccumulatorPixel, typename Pixel>
+ImagePtr	RGBStacker<AccumulatorPixel, Pixel>::image() {
+	if ((method() == SUM) || (!_layers)) {
 		return _accumulator.image();
 	}
-};
+	Combiner	combiner(method(), kappa(), iterations());
+	return _layers->combine<RGB<AccumulatorPixel> >(combiner);
+}
 
 /**
  * \brief Add an image to the stack
@@ -310,7 +379,7 @@ void	RGBStacker<AccumulatorPixel, Pixel>::add(
 	// first handle the case where there is no transform
 	if (notransform()) {
 		RGBAdapter<AccumulatorPixel, Pixel>	accumulatorimage(image);
-		_accumulator.accumulate(accumulatorimage);
+		accumulate(accumulatorimage);
 		return;
 	}
 
@@ -330,7 +399,7 @@ void	RGBStacker<AccumulatorPixel, Pixel>::add(
 	// create an adapter that applies the transform to the image
 	TransformAdapter<RGB<AccumulatorPixel> >	transformadapter(
 		accumulatorimage, transform.inverse(), false);
-	_accumulator.accumulate(transformadapter);
+	accumulate(transformadapter);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "image added");
 }
 
@@ -351,6 +420,45 @@ void	RGBStacker<AccumulatorPixel, Pixel>::add(ImagePtr newimage,
 //////////////////////////////////////////////////////////////////////
 // Implementation of the Stacker class
 //////////////////////////////////////////////////////////////////////
+/**
+ * \brief Convert a stacking method to a string
+ */
+std::string	Stacker::method2string(method_type m) {
+	switch (m) {
+	case SUM:		return std::string("sum");
+	case MEDIAN:		return std::string("median");
+	case KAPPA_SIGMA:	return std::string("kappasigma");
+	case WINSORIZED_SIGMA:	return std::string("winsorized");
+	case LINEAR_FIT:	return std::string("linearfit");
+	}
+	throw std::runtime_error("unknown stacking method");
+}
+
+/**
+ * \brief Convert a string to a stacking method
+ */
+Stacker::method_type	Stacker::string2method(const std::string& m) {
+	if (m == "sum") {
+		return SUM;
+	}
+	if (m == "median") {
+		return MEDIAN;
+	}
+	if (m == "kappasigma") {
+		return KAPPA_SIGMA;
+	}
+	if (m == "winsorized") {
+		return WINSORIZED_SIGMA;
+	}
+	if (m == "linearfit") {
+		return LINEAR_FIT;
+	}
+	std::string	msg = stringprintf("unknown stacking method '%s'",
+		m.c_str());
+	debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+	throw std::runtime_error(msg);
+}
+
 #define	get_monochrome_stacker(baseimage, AccumulatorPixel, Pixel)	\
 {									\
 	Image<Pixel>	*imagep						\
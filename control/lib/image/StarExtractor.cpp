@@ -7,7 +7,7 @@
 #include <AstroDebug.h>
 #include <AstroFormat.h>
 #include <AstroFilter.h>
-#include "LevelExtractor.h"
+#include <algorithm>
 
 namespace astro {
 namespace image {
@@ -35,7 +35,13 @@ StarExtractor::StarExtractor(const StarExtractor& other)
  * \brief Main star extractor method
  *
  * This method looks for large values in an image and determines their
- * properties of a star.
+ * properties of a star. The pixels above a level are labeled into
+ * connected components, and each component becomes a star at its
+ * flux weighted centroid with the peak value as the brightness. Stars
+ * are taken in order of decreasing brightness, as long as they are not
+ * within the search radius of a brighter star or of the image border.
+ * While there are not enough stars, the level is halved, until it
+ * reaches the mean of the image.
  *
  * \param image		the image to extract stars from
  * \param criterion	the criterion to use to accept a star
@@ -46,20 +52,81 @@ std::vector<Star>	StarExtractor::stars(
 	std::vector<Star>	result;
 	// find the maximum value in the image
 	double	m = filter::Max<double, double>().filter(image);
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "maximum value: %f", m);
-
-	// create a level extractor that looks for stars with a brightness
-	// at a certain level
-	LevelExtractor	extractor(m);
-	extractor.radius(searchradius());
-	extractor.maxstars(numberofstars());
-	do {
+	double	mean = filter::Mean<double, double>().filter(image);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "maximum value: %f, mean: %f", m, mean);
+
+	int	w = image.getSize().width();
+	int	h = image.getSize().height();
+	double	r = _searchradius;
+
+	// stars that were rejected by the criterion still keep other stars
+	// away, like accepted stars do
+	std::vector<Star>	rejected;
+	auto	isolated = [&](const Star& star) {
+		for (auto ptr = result.begin(); ptr != result.end(); ptr++) {
+			if (distance(*ptr, star) < r) {
+				return false;
+			}
+		}
+		for (auto ptr = rejected.begin(); ptr != rejected.end();
+			ptr++) {
+			if (distance(*ptr, star) < r) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	ComponentLabeler	labeler;
+	double	level = m;
+	while (result.size() < _numberofstars) {
 		// while we don't have enough stars, lower the level at which
 		// we are looking for stars
-		extractor.level(extractor.level() / 2);
-		extractor.analyze(image, criterion);
-	} while (_numberofstars > extractor.nstars());
-	return extractor.stars(_numberofstars);
+		level = level / 2;
+		if (level <= mean) {
+			std::string	msg = stringprintf("have not enough stars: "
+				"%d < %d", result.size(), _numberofstars);
+			debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+			throw std::range_error(msg);
+		}
+		labeler(image, level);
+
+		// convert the components into stars, brightest first
+		std::vector<Star>	candidates;
+		const std::vector<ComponentStatistics>&	components
+			= labeler.components();
+		for (auto ptr = components.begin(); ptr != components.end();
+			ptr++) {
+			Point	center(ptr->xcentroid(), ptr->ycentroid());
+			if ((center.x() < r) || (center.x() >= w - r)
+				|| (center.y() < r) || (center.y() >= h - r)) {
+				continue;
+			}
+			candidates.push_back(Star(center, ptr->peak()));
+		}
+		std::sort(candidates.rbegin(), candidates.rend());
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%d candidates at level %f",
+			candidates.size(), level);
+
+		for (auto ptr = candidates.begin();
+			(ptr != candidates.end())
+				&& (result.size() < _numberofstars); ptr++) {
+			if (!isolated(*ptr)) {
+				continue;
+			}
+			if (criterion.accept(*ptr)) {
+				debug(LOG_DEBUG, DEBUG_LOG, 0, "star %s accepted",
+					ptr->toString().c_str());
+				result.push_back(*ptr);
+			} else {
+				debug(LOG_DEBUG, DEBUG_LOG, 0, "star %s rejected",
+					ptr->toString().c_str());
+				rejected.push_back(*ptr);
+			}
+		}
+	}
+	std::sort(result.rbegin(), result.rend());
+	return result;
 }
 
 /**
@@ -5,6 +5,8 @@
  */
 #include <AstroTransform.h>
 #include <cmath>
+#include <algorithm>
+#include <random>
 
 namespace astro {
 namespace image {
@@ -16,6 +18,34 @@ namespace transform {
 TriangleSet::TriangleSet() {
 	_allow_mirror = false;
 	_tolerance = 0.01;
+	_startolerance = 2;
+	_iterations = 500;
+}
+
+/**
+ * \brief The stars to verify transforms with
+ *
+ * If the set does not know the stars the triangles were built from, the
+ * distinct vertices of the triangles are used instead.
+ */
+std::vector<Point>	TriangleSet::stars() const {
+	if (_stars.size() > 0) {
+		return _stars;
+	}
+	std::vector<Point>	result;
+	for (auto ptr = begin(); ptr != end(); ptr++) {
+		for (int i = 0; i < 3; i++) {
+			result.push_back((*ptr)[i]);
+		}
+	}
+	std::sort(result.begin(), result.end(),
+		[](const Point& a, const Point& b) {
+			return (a.x() < b.x())
+				|| ((a.x() == b.x()) && (a.y() < b.y()));
+		}
+	);
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+	return result;
 }
 
 /**
@@ -38,137 +68,94 @@ const Triangle& TriangleSet::closest(const Triangle& other) const {
 	return *candidate;
 }
 
-class TrianglePair : public std::pair<Triangle, Triangle> {
-public:
-	TrianglePair(const Triangle& t1, const Triangle& t2)
-		: std::pair<Triangle, Triangle>(t1, t2) {
-	}
-	std::string	toString() const {
-		return stringprintf("%s ~ %s, d=%f, rotate=%f, scale=%f",
-			first.toString().c_str(), second.toString().c_str(),
-			first.distance(second),
-			first.rotate_to(second) * 180 / M_PI,
-			first.scale_to(second));
-	}
-};
-
-
-class PairFunction {
-public:
-	virtual double	operator()(const TrianglePair& pair) const = 0;
-};
-
-class RotateTo : public PairFunction {
-public:
-	virtual double	operator()(const TrianglePair& pair) const {
-		return pair.first.rotate_to(pair.second);
-	}
-};
-
-class ScaleTo : public PairFunction {
-public:
-	virtual double	operator()(const TrianglePair& pair) const {
-		return log(pair.first.scale_to(pair.second));
-	}
-};
+typedef std::pair<const Triangle *, const Triangle *>	TrianglePair;
 
-template<int n>
-class CharacteristicValue {
-	PairFunction&	_pairfunction;
-	double	_min;
-	double	_max;
-	double	_delta;
-	int	counts[n];
-	int	_maxindex;
-public:
-	double	delta() const { return _delta; }
-private:
-	int	index(double v) const {
-		if (v < _min) {
-			return 0;
-		}
-		if (v > _max) {
-			return n - 1;
-		}
-		return trunc((v - _min) / _delta);
-	}
-public:
-	CharacteristicValue(PairFunction& pairfunction, double min, double max)
-		: _pairfunction(pairfunction), _min(min), _max(max) {
-		_delta = (_max - _min) / n;
-		std::fill_n(counts, n, 0);
-	}
-	void	add(const TrianglePair& pair) {
-		double	v = _pairfunction(pair);
-		counts[index(v)]++;
-	}
-	void	evaluate() {
-		int	count = -1;
-		for (int i = 0; i < n; i++) {
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "counts[%d] = %d, %f", i,
-				counts[i], _min + _delta * (i + 0.5));
-			if (counts[i] > count) {
-				_maxindex = i;
-				count = counts[_maxindex];
-			}
+/**
+ * \brief Transform suggested by a pair of matching triangles
+ */
+static Transform	pairtransform(const TrianglePair& pair) {
+	if (pair.first->mirror_to(*pair.second)) {
+		std::vector<Point>	from;
+		std::vector<Point>	to;
+		for (int i = 0; i < 3; i++) {
+			from.push_back((*pair.first)[i]);
+			to.push_back((*pair.second)[i]);
 		}
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "characteristic bin: %d (%d)",
-			_maxindex, count);
-	}
-	double	value() const {
-		return _min + (_maxindex + 0.5) * _delta;
+		TransformFactory	tf;
+		return tf(from, to);
 	}
-	bool	faroff(const TrianglePair& pair) const {
-		double	v = _pairfunction(pair);
-		int	i = index(v);
-		if ((n - 1) == _maxindex) {
-			return ((i > 0) && (i < n - 2));
+	return pair.first->to(*pair.second);
+}
+
+/**
+ * \brief Find the stars that a transform maps close to a target star
+ *
+ * \param transform	the transform to verify
+ * \param from		the stars to transform
+ * \param to		tree of the target stars
+ * \param tolerance	maximum distance of a match
+ * \param matches	if not NULL, receives the indices of the matching
+ *			target stars, or -1 for stars without match
+ */
+static int	inliers(const Transform& transform,
+			const std::vector<Point>& from, const PointTree& to,
+			double tolerance, std::vector<int> *matches = NULL) {
+	int	counter = 0;
+	for (size_t i = 0; i < from.size(); i++) {
+		Point	p = transform(from[i]);
+		int	j = to.nearest(p);
+		if ((j >= 0) && (distance(p, to[j]) <= tolerance)) {
+			counter++;
+		} else {
+			j = -1;
 		}
-		if (0 == _maxindex) {
-			return ((i > 1) && (i < n - 1));
+		if (matches) {
+			matches->push_back(j);
 		}
-		return (std::abs(_maxindex - i) > 1);
-	}
-};
-
-double	angle_reduce(double a) {
-	while (a > M_PI) {
-		a -= 2 * M_PI;
 	}
-	while (a < -M_PI) {
-		a += 2 * M_PI;
-	}
-	return a;
+	return counter;
 }
 
 /**
  * \brief Find the closest transform from a set of triangles
+ *
+ * Each triangle is paired with all triangles of the other set that have
+ * invariants within _tolerance, found with a k-d tree. Each pair
+ * suggests a transform, and the transform that maps the most stars of
+ * this set onto stars of the other set wins. If there are more pairs
+ * than _iterations, a random sample of the pairs is tried (RANSAC).
+ * The result is fitted to all star pairs the winning transform matches.
  */
 Transform	TriangleSet::closest(const TriangleSet& other) const {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "finding transform from %d to %d "
 		"triangles", size(), other.size());
-	// for each triangle find a close triangle in the other set, the
-	// parameter _tolerance decides how close is close enough
-	std::list<TrianglePair>	trianglepairs;
+	// index the other triangles by their invariants
+	std::vector<const Triangle *>	targets;
+	std::vector<Point>	invariants;
+	for (auto ptr = other.begin(); ptr != other.end(); ptr++) {
+		targets.push_back(&*ptr);
+		invariants.push_back(ptr->invariants());
+	}
+	PointTree	index(invariants);
+
+	// for each triangle find the triangles in the other set that are
+	// close enough, the parameter _tolerance decides how close is close
+	// enough
+	std::vector<TrianglePair>	trianglepairs;
 	for (auto ptr = begin(); ptr != end(); ptr++) {
-		Triangle	b = other.closest(*ptr);
-		// reject pairs with that imply mirror images
-		if (!_allow_mirror) {
-			if (b.mirror_to(*ptr)) {
+		std::vector<int>	close = index.within(ptr->invariants(),
+						_tolerance);
+		for (auto i = close.begin(); i != close.end(); i++) {
+			const Triangle	*b = targets[*i];
+			// reject pairs with that imply mirror images
+			if ((!_allow_mirror) && (b->mirror_to(*ptr))) {
 				continue;
 			}
+			trianglepairs.push_back(TrianglePair(&*ptr, b));
 		}
-		// reject pairs that are not close enough
-		double	d = ptr->distance(b);
-		if (d > _tolerance) {
-			continue;
-		}
-		// add the pair to the set
-		TrianglePair	pair(*ptr, b);
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "closest triangle: %s",
-			pair.toString().c_str());
-		trianglepairs.push_back(pair);
 	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%d candidate triangle pairs",
+		trianglepairs.size());
 
 	// stop if we have no suitable triangle pairs
 	if (trianglepairs.size() == 0) {
@@ -178,141 +165,55 @@ Transform	TriangleSet::closest(const TriangleSet& other) const {
 		throw std::runtime_error(msg);
 	}
 
-	// some of the triangle pairs may have scales or rotation angles
-	// that are completely off, so we now find common scales and rotation
-	// angles using a histogram
-	RotateTo	anglefunction;
-	CharacteristicValue<256>	anglehistogram(anglefunction,
-						0, 2 * M_PI);
-	for (auto p = trianglepairs.begin(); p != trianglepairs.end(); p++) {
-		anglehistogram.add(*p);
-	}
-	anglehistogram.evaluate();
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "characteristic angle: %f",
-		anglehistogram.value() * 180 / M_PI);
-
-	// remove all triangle pairs that are far off the common values
-	int	counter = 0;
-	auto ptr = trianglepairs.begin();
-	while (ptr != trianglepairs.end()) {
-		if (anglehistogram.faroff(*ptr)) {
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "exclude %s",
-				ptr->toString().c_str());
-			ptr = trianglepairs.erase(ptr);
-			counter++;
-		} else {
-			ptr++;
-		}
-	}
-	debug(LOG_DEBUG, DEBUG_LOG, 0,
-		"%d pairs excluded: rotation angle far from %f",
-		counter, anglehistogram.value() * 180 / M_PI);
-
-	// remove all triangles for which the angle is far off.
-	double	rotatebase = anglehistogram.value();
-	double	rotatesum = 0, rotate2sum = 0;
-	ptr = trianglepairs.begin();
-	while (ptr != trianglepairs.end()) {
-		double	r = ptr->first.rotate_to(ptr->second) - rotatebase;
-		r = angle_reduce(r);
-		rotatesum += r;
-		rotate2sum += r * r;
-		ptr++;
-	}
-	counter = 0;
-	ptr = trianglepairs.begin();
-	double	mean = rotatesum / trianglepairs.size() + rotatebase;
-	double	stddev = sqrt(rotate2sum / trianglepairs.size());
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "rotate mean: %f, stddev: %f",
-		mean * 180 / M_PI, stddev * 180 / M_PI);
-	while (ptr != trianglepairs.end()) {
-		double	r = ptr->first.rotate_to(ptr->second) - mean;
-		r = angle_reduce(r);
-		if (fabs(r) > stddev) {
-			ptr = trianglepairs.erase(ptr);
-			counter++;
-		} else {
-			ptr++;
+	// verify the transforms suggested by the pairs against the stars
+	std::vector<Point>	from = stars();
+	PointTree	to(other.stars());
+	int	enough = (8 * std::min(from.size(), to.size())) / 10;
+	std::mt19937	generator(trianglepairs.size());
+	bool	sample = (trianglepairs.size() > _iterations);
+	size_t	n = (sample) ? _iterations : trianglepairs.size();
+	Transform	transform;
+	int	best = 0;
+	for (size_t h = 0; (h < n) && (best < enough); h++) {
+		size_t	k = (sample) ? (generator() % trianglepairs.size()) : h;
+		Transform	t = pairtransform(trianglepairs[k]);
+		int	count = inliers(t, from, to, _startolerance);
+		if (count > best) {
+			best = count;
+			transform = t;
 		}
 	}
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "%d pairs excluded for too large "
-		"rotation angle", counter);
-
-	// collect scale values
-	ScaleTo	scalefunction;
-	CharacteristicValue<101>	scalehistogram(scalefunction, -1, 1);
-	for (auto p = trianglepairs.begin(); p != trianglepairs.end(); p++) {
-		scalehistogram.add(*p);
-	}
-	scalehistogram.evaluate();
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "characteristic scale: %f",
-		exp(scalehistogram.value()));
-
-	// remove the triangle pairs that have bad scale
-	counter = 0;
-	ptr = trianglepairs.begin();
-	while (ptr != trianglepairs.end()) {
-		if (scalehistogram.faroff(*ptr)) {
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "exclude %s",
-				ptr->toString().c_str());
-			ptr = trianglepairs.erase(ptr);
-			counter++;
-		} else {
-			ptr++;
-		}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "best transform matches %d of %d stars",
+		best, from.size());
+	if (best < 3) {
+		std::string	msg = stringprintf("no transform matches at "
+			"least 3 stars within %f pixels", _startolerance);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
 	}
-	debug(LOG_DEBUG, DEBUG_LOG, 0,
-		"%d pairs excluded: scale factor far from %f",
-		counter, exp(scalehistogram.value()));
 
-	// compute the mean and variance of the scale
-	double	scalesum = 0, scale2sum = 0;
-	ptr = trianglepairs.begin();
-	while (ptr != trianglepairs.end()) {
-		double	s = ptr->first.scale_to(ptr->second);
-		scalesum += s;
-		scale2sum += s * s;
-		ptr++;
-	}
-	mean = scalesum / trianglepairs.size();
-	stddev = sqrt((scale2sum / trianglepairs.size()) - mean * mean);
-	counter = 0;
-	ptr = trianglepairs.begin();
-	while (ptr != trianglepairs.end()) {
-		double	s = ptr->first.scale_to(ptr->second);
-		if ((fabs(s - mean) / stddev) > 1) {
-			ptr = trianglepairs.erase(ptr);
-			counter++;
-		} else {
-			ptr++;
+	// fit the transform to all matching star pairs, twice because the
+	// better transform may match a few more stars
+	for (int iteration = 0; iteration < 2; iteration++) {
+		std::vector<int>	matches;
+		inliers(transform, from, to, _startolerance, &matches);
+		std::vector<Point>	f;
+		std::vector<Point>	t;
+		for (size_t i = 0; i < from.size(); i++) {
+			if (matches[i] >= 0) {
+				f.push_back(from[i]);
+				t.push_back(to[matches[i]]);
+			}
 		}
-	}
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "%d pairs eliminated for scale variance",
-		counter);
-
-	// display the triangles we plan to use for transform computation
-	std::list<TrianglePair>::const_iterator	tp;
-	int	i;
-	for (i = 0, tp = trianglepairs.begin();
-		tp != trianglepairs.end(); i++, tp++) {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "using triangle pair %d: %s",
-			i, tp->toString().c_str());
-	}
-
-	// now that we have triangles that we know match, we can also 
-	// construct a set of points that should match
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "found %d matching triangles",
-		trianglepairs.size());
-	std::vector<Point>	from;
-	std::vector<Point>	to;
-	for (tp = trianglepairs.begin(); tp != trianglepairs.end(); tp++) {
-		for (int i = 0; i < 3; i++) {
-			from.push_back(tp->first[i]);
-			to.push_back(tp->second[i]);
+		if (f.size() < 3) {
+			break;
 		}
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "fitting to %d star pairs",
+			f.size());
+		TransformFactory	tf;
+		transform = tf(f, t);
 	}
-	TransformFactory	tf;
-	return tf(from, to);
+	return transform;
 }
 
 } // namespace transform
@@ -5,6 +5,7 @@
  */
 #include <AstroTransform.h>
 #include <AstroDebug.h>
+#include <algorithm>
 
 namespace astro {
 namespace image {
@@ -13,6 +14,7 @@ namespace transform {
 TriangleSetFactory::TriangleSetFactory() {
 	_radius = 16;
 	_numberofstars = 20;
+	_neighbors = 10;
 }
 
 bool	TriangleSetFactory::good(const Triangle& t, double l) const {
@@ -76,6 +78,12 @@ TriangleSet	TriangleSetFactory::get(const ConstImageAdapter<double>& image) cons
 
 /**
  * \brief Convert a star set into a triangle set
+ *
+ * If there are at most _neighbors + 1 stars, all triangles are formed.
+ * Otherwise each star only forms triangles with pairs of its _neighbors
+ * nearest stars, and the length limit is lowered to half the typical
+ * distance of the farthest of these neighbours, so that the triangles
+ * are not all rejected as too small in dense star fields.
  */
 TriangleSet	TriangleSetFactory::get(const std::vector<Star>& stars,
 			double l) const {
@@ -85,27 +93,56 @@ TriangleSet	TriangleSetFactory::get(const std::vector<Star>& stars,
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "Star[%d] %s", i++,
 			ptr->toString().c_str());
 	}
+	std::vector<Point>	points(stars.begin(), stars.end());
+	result.stars(points);
 
-	// now go through the whole image and produce triangles
-	std::vector<Star>::const_iterator	p1, p2, p3;
-	for (p1 = stars.begin(); p1 != stars.end(); p1++) {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "p1 = %s",
-			p1->toString().c_str());
-		auto ptr = p1 + 1;
-		if (ptr == stars.end()) {
-			continue;
+	// find the neighbours of each star
+	int	n = points.size();
+	std::vector<std::vector<int> >	neighbors(n);
+	bool	all = ((unsigned int)n <= _neighbors + 1);
+	if (all) {
+		for (int j = 0; j < n; j++) {
+			for (int k = 0; k < n; k++) {
+				if (k != j) {
+					neighbors[j].push_back(k);
+				}
+			}
+		}
+	} else {
+		PointTree	tree(points);
+		std::vector<double>	farthest;
+		for (int j = 0; j < n; j++) {
+			// the nearest point is the star itself
+			neighbors[j] = tree.nearest(points[j], _neighbors + 1);
+			neighbors[j].erase(neighbors[j].begin());
+			farthest.push_back(distance(points[j],
+				points[neighbors[j].back()]));
 		}
-		for (p2 = ptr; p2 != stars.end(); p2++) {
-			debug(LOG_DEBUG, DEBUG_LOG, 0, "p2 = %s",
-				p2->toString().c_str());
-			auto	ptr = p2 + 1;
-			if (ptr == stars.end()) {
+		std::nth_element(farthest.begin(),
+			farthest.begin() + n / 2, farthest.end());
+		double	limit = farthest[n / 2] / 2;
+		if (limit < l) {
+			l = limit;
+		}
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%d neighbors, length limit %f",
+			_neighbors, l);
+	}
+
+	// now produce the triangles, when all stars are neighbours, each
+	// triangle is formed only once, otherwise the set removes the
+	// duplicates
+	for (int j = 0; j < n; j++) {
+		const std::vector<int>&	nb = neighbors[j];
+		for (size_t a = 0; a < nb.size(); a++) {
+			if (all && (nb[a] < j)) {
 				continue;
 			}
-			for (p3 = ptr; p3 != stars.end(); p3++) {
-				debug(LOG_DEBUG, DEBUG_LOG, 0, "p3 = %s",
-					p3->toString().c_str());
-				Triangle	t(*p1, *p2, *p3);
+			for (size_t b = a + 1; b < nb.size(); b++) {
+				if (all && (nb[b] < j)) {
+					continue;
+				}
+				Triangle	t(points[j], points[nb[a]],
+						points[nb[b]]);
 				if (good(t, l)) {
 					result.insert(result.begin(), t);
 				}
@@ -0,0 +1,154 @@
+/*
+ * CalibrationBuilderTest.cpp -- compare calibration builders with factories
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+
+#include <AstroCalibration.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <AstroDebug.h>
+#include <cmath>
+
+using namespace astro::image;
+using namespace astro::calibration;
+
+namespace astro {
+namespace test {
+
+class CalibrationBuilderTest : public CppUnit::TestFixture {
+public:
+	void	setUp() { }
+	void	tearDown() { }
+	void	testDark();
+	void	testDarkPlain();
+	void	testFlat();
+
+	CPPUNIT_TEST_SUITE(CalibrationBuilderTest);
+	CPPUNIT_TEST(testDark);
+	CPPUNIT_TEST(testDarkPlain);
+	CPPUNIT_TEST(testFlat);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CalibrationBuilderTest);
+
+/**
+ * \brief A sequence of noisy images with a hot pixel and a cosmic ray
+ */
+static ImageSequence	testimages(int n, unsigned short level) {
+	ImageSequence	images;
+	for (int i = 0; i < n; i++) {
+		Image<unsigned short>	*image
+			= new Image<unsigned short>(32, 24);
+		for (int x = 0; x < 32; x++) {
+			for (int y = 0; y < 24; y++) {
+				image->pixel(x, y) = level
+					+ ((x * 7 + y * 13 + i * 5) % 17);
+			}
+		}
+		image->pixel(5, 7) = 4000;
+		if (i == 3) {
+			image->pixel(20, 10) = 60000;
+		}
+		images.push_back(ImagePtr(image));
+	}
+	return images;
+}
+
+static bool	same(ImagePtr a, ImagePtr b) {
+	Image<float>	*fa = dynamic_cast<Image<float> *>(&*a);
+	Image<float>	*fb = dynamic_cast<Image<float> *>(&*b);
+	if ((NULL == fa) || (NULL == fb) || (fa->size() != fb->size())) {
+		return false;
+	}
+	for (int x = 0; x < fa->size().width(); x++) {
+		for (int y = 0; y < fa->size().height(); y++) {
+			float	va = fa->pixel(x, y);
+			float	vb = fb->pixel(x, y);
+			if ((va != va) || (vb != vb)) {
+				if ((va == va) || (vb == vb)) {
+					return false;
+				}
+				continue;
+			}
+			if (fabs(va - vb) > 1e-3 * (1 + fabs(va))) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * \brief The robust builder reproduces the dark of the factory
+ */
+void	CalibrationBuilderTest::testDark() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testDark() begin");
+	ImageSequence	images = testimages(20, 1000);
+	DarkFrameFactory	factory;
+	factory.detect_bad_pixels(true);
+	ImagePtr	dark = factory(images);
+
+	DarkFrameBuilder	builder(factory);
+	ImageSequence::const_iterator	i;
+	for (i = images.begin(); i != images.end(); i++) {
+		builder.add(*i);
+	}
+	CPPUNIT_ASSERT(builder.count() == 20);
+	ImagePtr	built = builder();
+	CPPUNIT_ASSERT(same(dark, built));
+	// the cosmic ray must have been rejected
+	Image<float>	*b = dynamic_cast<Image<float> *>(&*built);
+	CPPUNIT_ASSERT(fabs(b->pixel(20, 10) - 1008) < 10);
+	CPPUNIT_ASSERT((long)built->getMetadata("CALSUBFM") == 20);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testDark() end");
+}
+
+/**
+ * \brief Without rejection the builder computes the plain mean
+ */
+void	CalibrationBuilderTest::testDarkPlain() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testDarkPlain() begin");
+	ImageSequence	images = testimages(10, 1000);
+	DarkFrameBuilder	builder(DarkFrameFactory(), false);
+	ImageSequence::const_iterator	i;
+	for (i = images.begin(); i != images.end(); i++) {
+		builder.add(*i);
+	}
+	ImagePtr	built = builder();
+	Image<float>	*b = dynamic_cast<Image<float> *>(&*built);
+	double	sum = 0;
+	for (i = images.begin(); i != images.end(); i++) {
+		sum += dynamic_cast<Image<unsigned short> *>(&**i)->pixel(2, 3);
+	}
+	CPPUNIT_ASSERT(fabs(b->pixel(2, 3) - sum / 10) < 1e-3);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testDarkPlain() end");
+}
+
+/**
+ * \brief The flat builder reproduces the flat of the factory
+ */
+void	CalibrationBuilderTest::testFlat() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testFlat() begin");
+	ImageSequence	images = testimages(8, 20000);
+	Image<float>	*bias = new Image<float>(32, 24);
+	ImagePtr	biasptr(bias);
+	bias->fill(1000);
+	bias->pixel(5, 7) = std::numeric_limits<float>::quiet_NaN();
+	FlatFrameFactory	factory;
+	ImagePtr	flat = factory(images, biasptr);
+
+	FlatFrameBuilder	builder(factory, biasptr);
+	ImageSequence::const_iterator	i;
+	for (i = images.begin(); i != images.end(); i++) {
+		builder.add(*i);
+	}
+	ImagePtr	built = builder();
+	CPPUNIT_ASSERT(same(flat, built));
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testFlat() end");
+}
+
+} // namespace test
+} // namespace astro
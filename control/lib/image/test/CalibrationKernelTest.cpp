@@ -0,0 +1,182 @@
+/*
+ * CalibrationKernelTest.cpp -- compare the kernel with the correctors
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+
+#include <AstroCalibration.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <AstroDebug.h>
+#include <cmath>
+#include <limits>
+
+using namespace astro::image;
+using namespace astro::calibration;
+
+namespace astro {
+namespace test {
+
+class CalibrationKernelTest : public CppUnit::TestFixture {
+public:
+	void	setUp() { }
+	void	tearDown() { }
+	void	testCorrectors();
+	void	testInterpolate();
+	void	testBinning();
+
+	CPPUNIT_TEST_SUITE(CalibrationKernelTest);
+	CPPUNIT_TEST(testCorrectors);
+	CPPUNIT_TEST(testInterpolate);
+	CPPUNIT_TEST(testBinning);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CalibrationKernelTest);
+
+static const int	width = 40;
+static const int	height = 30;
+
+static ImagePtr	testimage() {
+	Image<unsigned short>	*image
+		= new Image<unsigned short>(width, height);
+	for (int x = 0; x < width; x++) {
+		for (int y = 0; y < height; y++) {
+			image->pixel(x, y) = 1000 + ((x * 37 + y * 101) % 500);
+		}
+	}
+	return ImagePtr(image);
+}
+
+static ImagePtr	testdark() {
+	Image<float>	*dark = new Image<float>(width, height);
+	for (int x = 0; x < width; x++) {
+		for (int y = 0; y < height; y++) {
+			dark->pixel(x, y) = 100 + ((x + y) % 7);
+		}
+	}
+	dark->pixel(7, 5) = std::numeric_limits<float>::quiet_NaN();
+	dark->pixel(20, 20) = std::numeric_limits<float>::quiet_NaN();
+	return ImagePtr(dark);
+}
+
+static ImagePtr	testflat() {
+	Image<float>	*flat = new Image<float>(width, height);
+	for (int x = 0; x < width; x++) {
+		for (int y = 0; y < height; y++) {
+			flat->pixel(x, y) = 0.8 + 0.01 * ((x * y) % 20);
+		}
+	}
+	return ImagePtr(flat);
+}
+
+/**
+ * \brief Without interpolation the kernel must agree with the correctors
+ */
+void	CalibrationKernelTest::testCorrectors() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testCorrectors() begin");
+	ImagePtr	dark = testdark();
+	ImagePtr	flat = testflat();
+	ImagePtr	image1 = testimage();
+	DarkCorrector	darkcorrector(dark);
+	darkcorrector(image1, 0);
+	FlatCorrector	flatcorrector(flat);
+	flatcorrector(image1, 0);
+
+	ImagePtr	image2 = testimage();
+	CalibrationKernel	kernel(dark, flat);
+	CPPUNIT_ASSERT(kernel.badpixels() == 2);
+	ImagePtr	result = kernel(image2);
+	CPPUNIT_ASSERT(result == image2);
+
+	Image<unsigned short>	*i1
+		= dynamic_cast<Image<unsigned short> *>(&*image1);
+	Image<unsigned short>	*i2
+		= dynamic_cast<Image<unsigned short> *>(&*image2);
+	for (int x = 0; x < width; x++) {
+		for (int y = 0; y < height; y++) {
+			// the correctors truncate twice, the kernel only once
+			int	d = (int)i1->pixel(x, y) - (int)i2->pixel(x, y);
+			CPPUNIT_ASSERT(std::abs(d) <= 2);
+		}
+	}
+	CPPUNIT_ASSERT(i2->pixel(7, 5) == 0);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testCorrectors() end");
+}
+
+/**
+ * \brief Bad pixels are the mean of their good neighbours
+ */
+void	CalibrationKernelTest::testInterpolate() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testInterpolate() begin");
+	ImagePtr	dark = testdark();
+	ImagePtr	reference = testimage();
+	CalibrationKernel	plain(dark, ImagePtr());
+	plain(reference);
+
+	ImagePtr	image = testimage();
+	CalibrationKernel	kernel(dark, ImagePtr());
+	kernel.interpolate(true);
+	kernel(image);
+
+	Image<unsigned short>	*r
+		= dynamic_cast<Image<unsigned short> *>(&*reference);
+	Image<unsigned short>	*i
+		= dynamic_cast<Image<unsigned short> *>(&*image);
+	float	expected = (r->pixel(6, 5) + r->pixel(8, 5)
+				+ r->pixel(7, 4) + r->pixel(7, 6)) / 4.;
+	CPPUNIT_ASSERT(fabs(i->pixel(7, 5) - expected) <= 1);
+	CPPUNIT_ASSERT(i->pixel(6, 5) == r->pixel(6, 5));
+
+	// for mosaic images, red pixels use the red neighbours
+	ImagePtr	mosaic = testimage();
+	mosaic->setMosaicType(MosaicType::BAYER_RGGB);
+	ImagePtr	mosaicreference = testimage();
+	mosaicreference->setMosaicType(MosaicType::BAYER_RGGB);
+	plain(mosaicreference);
+	kernel(mosaic);
+	Image<unsigned short>	*mr
+		= dynamic_cast<Image<unsigned short> *>(&*mosaicreference);
+	Image<unsigned short>	*m
+		= dynamic_cast<Image<unsigned short> *>(&*mosaic);
+	expected = (mr->pixel(18, 20) + mr->pixel(22, 20)
+			+ mr->pixel(20, 18) + mr->pixel(20, 22)) / 4.;
+	CPPUNIT_ASSERT(fabs(m->pixel(20, 20) - expected) <= 1);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testInterpolate() end");
+}
+
+/**
+ * \brief Binning adds pixels of the same color and clamps the sums
+ */
+void	CalibrationKernelTest::testBinning() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBinning() begin");
+	ImagePtr	image = testimage();
+	image->setMosaicType(MosaicType::BAYER_RGGB);
+	Image<unsigned short>	*i
+		= dynamic_cast<Image<unsigned short> *>(&*image);
+	i->pixel(1, 0) = 60000;
+	i->pixel(3, 0) = 60000;
+	CalibrationKernel	kernel(ImagePtr(), ImagePtr(),
+		ImageRectangle(ImagePoint(), image->size()));
+	kernel.binning(2);
+	ImagePtr	result = kernel(image);
+	CPPUNIT_ASSERT(result != image);
+	// only complete 2x2 cells of each color are binned
+	CPPUNIT_ASSERT(result->size() == ImageSize(20, 14));
+	CPPUNIT_ASSERT(result->getMosaicType().isMosaic());
+	Image<unsigned short>	*b
+		= dynamic_cast<Image<unsigned short> *>(&*result);
+	// the red pixel (2,2) of the binned image comes from the red
+	// pixels (4,4), (6,4), (4,6) and (6,6)
+	int	sum = i->pixel(4, 4) + i->pixel(6, 4) + i->pixel(4, 6)
+			+ i->pixel(6, 6);
+	CPPUNIT_ASSERT(b->pixel(2, 2) == sum);
+	// the green pixel (1,0) gets (1,0), (3,0), (1,2) and (3,2)
+	CPPUNIT_ASSERT(b->pixel(1, 0) == 65535);
+	CPPUNIT_ASSERT((int)result->getMetadata("XBINNING") == 2);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBinning() end");
+}
+
+} // namespace test
+} // namespace astro
@@ -0,0 +1,134 @@
+/*
+ * CombinerTest.cpp -- test the rejection methods of the stacker
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+
+#include <AstroStacking.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <AstroDebug.h>
+#include <cmath>
+
+using namespace astro::image;
+using namespace astro::image::stacking;
+
+namespace astro {
+namespace test {
+
+class CombinerTest : public CppUnit::TestFixture {
+public:
+	void	setUp() { }
+	void	tearDown() { }
+	void	testMedian();
+	void	testKappaSigma();
+	void	testWinsorized();
+	void	testLinearFit();
+	void	testStacker();
+
+	CPPUNIT_TEST_SUITE(CombinerTest);
+	CPPUNIT_TEST(testMedian);
+	CPPUNIT_TEST(testKappaSigma);
+	CPPUNIT_TEST(testWinsorized);
+	CPPUNIT_TEST(testLinearFit);
+	CPPUNIT_TEST(testStacker);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+/**
+ * \brief 30 values around 100 with two large outliers
+ */
+static std::vector<double>	values() {
+	std::vector<double>	result;
+	for (int i = 0; i < 30; i++) {
+		result.push_back(100 + ((i * 7) % 11) - 5);
+	}
+	result.push_back(5000);
+	result.push_back(4000);
+	return result;
+}
+
+void	CombinerTest::testMedian() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testMedian() begin");
+	Combiner	combiner(Stacker::MEDIAN);
+	std::vector<double>	v = values();
+	CPPUNIT_ASSERT(fabs(combiner(v) - 100) <= 1);
+	std::vector<double>	w = { 3, 1, 2, 4 };
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(2.5, combiner(w), 1e-10);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testMedian() end");
+}
+
+void	CombinerTest::testKappaSigma() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testKappaSigma() begin");
+	Combiner	combiner(Stacker::KAPPA_SIGMA, 2.5, 5);
+	std::vector<double>	v = values();
+	double	m = combiner(v);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "kappa sigma mean: %f", m);
+	CPPUNIT_ASSERT(fabs(m - 100) < 1);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testKappaSigma() end");
+}
+
+void	CombinerTest::testWinsorized() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testWinsorized() begin");
+	Combiner	combiner(Stacker::WINSORIZED_SIGMA, 2.5, 5);
+	std::vector<double>	v = values();
+	double	m = combiner(v);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "winsorized mean: %f", m);
+	CPPUNIT_ASSERT(fabs(m - 100) < 1);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testWinsorized() end");
+}
+
+void	CombinerTest::testLinearFit() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testLinearFit() begin");
+	Combiner	combiner(Stacker::LINEAR_FIT, 2.5, 5);
+	std::vector<double>	v = values();
+	double	m = combiner(v);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "linear fit mean: %f", m);
+	CPPUNIT_ASSERT(fabs(m - 100) < 1);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testLinearFit() end");
+}
+
+/**
+ * \brief Stack images with a simulated satellite trail in one of them
+ */
+void	CombinerTest::testStacker() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testStacker() begin");
+	int	w = 150, h = 100;
+	ImagePtr	base(new Image<unsigned short>(w, h));
+	StackerPtr	stacker = Stacker::get(base);
+	stacker->notransform(true);
+	stacker->method(Stacker::KAPPA_SIGMA);
+	stacker->kappa(2);
+	stacker->tilesize(32);
+	int	n = 10;
+	for (int i = 0; i < n; i++) {
+		Image<unsigned short>	*image
+			= new Image<unsigned short>(w, h);
+		ImagePtr	imageptr(image);
+		for (int x = 0; x < w; x++) {
+			for (int y = 0; y < h; y++) {
+				image->pixel(x, y) = 1000 + ((x + y + i) % 5);
+			}
+		}
+		if (i == 3) {
+			for (int x = 0; x < w; x++) {
+				image->pixel(x, x % h) = 60000;
+			}
+		}
+		stacker->add(imageptr);
+	}
+	ImagePtr	result = stacker->image();
+	Image<float>	*stacked = dynamic_cast<Image<float> *>(&*result);
+	CPPUNIT_ASSERT(stacked != NULL);
+	for (int x = 0; x < w; x++) {
+		double	v = stacked->pixel(x, x % h) / n;
+		CPPUNIT_ASSERT(fabs(v - 1002) < 5);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testStacker() end");
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CombinerTest);
+
+} // namespace test
+} // namespace astro
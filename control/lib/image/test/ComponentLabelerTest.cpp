@@ -0,0 +1,253 @@
+/*
+ * ComponentLabelerTest.cpp -- compare component labeling with flood fill
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+
+#include <AstroImage.h>
+#include <AstroTransform.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <AstroDebug.h>
+#include <cmath>
+#include <map>
+
+using namespace astro::image;
+using namespace astro::image::transform;
+
+namespace astro {
+namespace test {
+
+class ComponentLabelerTest : public CppUnit::TestFixture {
+public:
+	void	setUp() { }
+	void	tearDown() { }
+	void	testLabels();
+	void	testStatistics();
+	void	testConnectedComponent();
+	void	testStarExtractor();
+
+	CPPUNIT_TEST_SUITE(ComponentLabelerTest);
+	CPPUNIT_TEST(testLabels);
+	CPPUNIT_TEST(testStatistics);
+	CPPUNIT_TEST(testConnectedComponent);
+	CPPUNIT_TEST(testStarExtractor);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ComponentLabelerTest);
+
+/**
+ * \brief Label an image with a simple flood fill
+ */
+static std::vector<int>	floodfill(const Image<unsigned char>& image,
+		bool eightconnected) {
+	int	w = image.size().width();
+	int	h = image.size().height();
+	std::vector<int>	labels(w * h, 0);
+	int	next = 0;
+	for (int y = 0; y < h; y++) {
+		for (int x = 0; x < w; x++) {
+			if ((0 == image.pixel(x, y)) || labels[y * w + x]) {
+				continue;
+			}
+			labels[y * w + x] = ++next;
+			std::vector<ImagePoint>	stack(1, ImagePoint(x, y));
+			while (stack.size()) {
+				ImagePoint	p = stack.back();
+				stack.pop_back();
+				for (int dy = -1; dy <= 1; dy++) {
+					for (int dx = -1; dx <= 1; dx++) {
+						if (!eightconnected && dx && dy) {
+							continue;
+						}
+						int	xx = p.x() + dx;
+						int	yy = p.y() + dy;
+						if ((xx < 0) || (xx >= w) || (yy < 0)
+							|| (yy >= h)) {
+							continue;
+						}
+						if (image.pixel(xx, yy)
+							&& !labels[yy * w + xx]) {
+							labels[yy * w + xx] = next;
+							stack.push_back(
+								ImagePoint(xx, yy));
+						}
+					}
+				}
+			}
+		}
+	}
+	return labels;
+}
+
+/**
+ * \brief Labels must agree with flood fill up to renumbering
+ */
+static void	compare(const Image<unsigned char>& image, bool eightconnected) {
+	std::vector<int>	reference = floodfill(image, eightconnected);
+	ComponentLabeler	labeler(eightconnected);
+	labeler(image, 1);
+	int	w = image.size().width();
+	int	h = image.size().height();
+	std::map<int, unsigned int>	forward;
+	std::map<unsigned int, int>	backward;
+	for (int y = 0; y < h; y++) {
+		for (int x = 0; x < w; x++) {
+			int	r = reference[y * w + x];
+			unsigned int	l = labeler.label(x, y);
+			CPPUNIT_ASSERT((0 == r) == (0 == l));
+			if (0 == r) {
+				continue;
+			}
+			if (forward.find(r) == forward.end()) {
+				forward[r] = l;
+				backward[l] = r;
+			}
+			CPPUNIT_ASSERT(forward[r] == l);
+			CPPUNIT_ASSERT(backward[l] == r);
+		}
+	}
+	CPPUNIT_ASSERT(labeler.ncomponents() == forward.size());
+}
+
+void	ComponentLabelerTest::testLabels() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testLabels() begin");
+	// the image is higher than a strip, so components have to be
+	// joined across strip boundaries
+	Image<unsigned char>	image(150, 300);
+	for (int x = 0; x < 150; x++) {
+		for (int y = 0; y < 300; y++) {
+			image.pixel(x, y) = (((x * 7 + y * 13) % 17) < 7) ? 1 : 0;
+		}
+	}
+	// a spiral that only becomes connected at the bottom
+	for (int y = 10; y < 290; y++) {
+		image.pixel(20, y) = 1;
+		image.pixel(21, y) = 0;
+		image.pixel(40, y) = 1;
+		image.pixel(39, y) = 0;
+	}
+	for (int x = 20; x <= 40; x++) {
+		image.pixel(x, 289) = 1;
+	}
+	compare(image, false);
+	compare(image, true);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testLabels() end");
+}
+
+void	ComponentLabelerTest::testStatistics() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testStatistics() begin");
+	Image<float>	image(100, 100);
+	image.fill(0);
+	// a U shaped component with values 1 and a single peak
+	for (int y = 60; y < 70; y++) {
+		image.pixel(10, y) = 1;
+		image.pixel(20, y) = 1;
+	}
+	for (int x = 10; x <= 20; x++) {
+		image.pixel(x, 70) = 1;
+	}
+	image.pixel(20, 60) = 5;
+	// a second component
+	image.pixel(50, 50) = 2;
+	ComponentLabeler	labeler;
+	labeler(image, 0.5);
+	CPPUNIT_ASSERT(labeler.ncomponents() == 2);
+	unsigned int	label = labeler.label(10, 60);
+	CPPUNIT_ASSERT(label == labeler.label(20, 65));
+	const ComponentStatistics&	c = labeler.component(label);
+	CPPUNIT_ASSERT(c.area() == 31);
+	CPPUNIT_ASSERT(c.boundingbox() == ImageRectangle(ImagePoint(10, 60),
+		ImageSize(11, 11)));
+	CPPUNIT_ASSERT(c.flux() == 35);
+	CPPUNIT_ASSERT(c.peak() == 5);
+	CPPUNIT_ASSERT(c.peakpoint() == ImagePoint(20, 60));
+	double	xc = 0, yc = 0;
+	for (int x = 0; x < 100; x++) {
+		for (int y = 0; y < 100; y++) {
+			if (labeler.label(x, y) == label) {
+				xc += x * image.pixel(x, y);
+				yc += y * image.pixel(x, y);
+			}
+		}
+	}
+	CPPUNIT_ASSERT(fabs(c.xcentroid() - xc / 35) < 1e-9);
+	CPPUNIT_ASSERT(fabs(c.ycentroid() - yc / 35) < 1e-9);
+	CPPUNIT_ASSERT(labeler.points(label).size() == 31);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testStatistics() end");
+}
+
+void	ComponentLabelerTest::testConnectedComponent() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testConnectedComponent() begin");
+	Image<unsigned char>	image(100, 100);
+	image.fill(0);
+	for (int x = 10; x < 90; x++) {
+		image.pixel(x, 30) = 1;
+		image.pixel(x, 60) = 1;
+	}
+	for (int y = 30; y < 60; y++) {
+		image.pixel(80, y) = 1;
+	}
+	// the roi cuts the connection at x = 80
+	ConnectedComponentBase	cc(ImagePoint(20, 30),
+		ImageRectangle(ImagePoint(0, 0), ImageSize(70, 100)));
+	WindowedImage<unsigned char>	*connected = cc.component(image);
+	CPPUNIT_ASSERT(ConnectedComponentBase::count(*connected) == 60);
+	CPPUNIT_ASSERT(connected->pixel(20, 60) == 0);
+	delete connected;
+
+	ConnectedComponentBase	all(ImagePoint(20, 30));
+	connected = all.component(image);
+	CPPUNIT_ASSERT(ConnectedComponentBase::count(*connected) == 189);
+	CPPUNIT_ASSERT(connected->pixel(20, 60) == 255);
+	delete connected;
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testConnectedComponent() end");
+}
+
+void	ComponentLabelerTest::testStarExtractor() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testStarExtractor() begin");
+	Image<double>	image(200, 150);
+	image.fill(10);
+	double	stars[4][3] = {
+		{ 40.3, 50.7, 1000 },
+		{ 150.0, 100.0, 600 },
+		{ 100.5, 30.5, 300 },
+		{ 102.0, 33.0, 200 }	// too close to the previous star
+	};
+	for (int x = 0; x < 200; x++) {
+		for (int y = 0; y < 150; y++) {
+			for (int i = 0; i < 4; i++) {
+				double	r2 = sqr(x - stars[i][0])
+						+ sqr(y - stars[i][1]);
+				image.pixel(x, y) += stars[i][2] * exp(-r2 / 4);
+			}
+		}
+	}
+	StarExtractor	extractor(3, 10);
+	StarAcceptanceCriterion	criterion(image);
+	ImagePtr	imageptr(new Image<double>(image));
+	std::vector<Star>	result = extractor.stars(imageptr, criterion);
+	CPPUNIT_ASSERT(result.size() == 3);
+	for (int i = 0; i < 3; i++) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "star %s",
+			result[i].toString().c_str());
+		CPPUNIT_ASSERT(fabs(result[i].x() - stars[i][0]) < 1);
+		CPPUNIT_ASSERT(fabs(result[i].y() - stars[i][1]) < 1);
+	}
+
+	// there are no more than three isolated stars
+	extractor.numberofstars(4);
+	bool	thrown = false;
+	try {
+		extractor.stars(imageptr, criterion);
+	} catch (const std::range_error& x) {
+		thrown = true;
+	}
+	CPPUNIT_ASSERT(thrown);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testStarExtractor() end");
+}
+
+} // namespace test
+} // namespace astro
@@ -0,0 +1,109 @@
+/*
+ * FFTWPlansTest.cpp -- test the FFTW plan cache
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroConvolve.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <AstroDebug.h>
+#include <cmath>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace astro::image;
+
+namespace astro {
+namespace test {
+
+class FFTWPlansTest : public CppUnit::TestFixture {
+public:
+	void	setUp() { }
+	void	tearDown() { FFTWPlans::clear(); }
+	void	testRoundtrip();
+	void	testUnaligned();
+	void	testWisdom();
+
+	CPPUNIT_TEST_SUITE(FFTWPlansTest);
+	CPPUNIT_TEST(testRoundtrip);
+	CPPUNIT_TEST(testUnaligned);
+	CPPUNIT_TEST(testWisdom);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+/**
+ * \brief Transform forward and back with the arrays given
+ */
+static void	roundtrip(const ImageSize& size, double *in, double *out,
+			fftw_complex *f) {
+	int	n = size.getPixels();
+	for (int i = 0; i < n; i++) {
+		in[i] = sin(0.1 * i) + (i % 7);
+	}
+	FFTWPlans::r2c(size, in, f);
+	FFTWPlans::c2r(size, f, out);
+	for (int i = 0; i < n; i++) {
+		CPPUNIT_ASSERT(fabs(out[i] / n - in[i]) < 1e-9);
+	}
+}
+
+void	FFTWPlansTest::testRoundtrip() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRoundtrip() begin");
+	ImageSize	size(60, 40);
+	double	*in = fftw_alloc_real(size.getPixels());
+	double	*out = fftw_alloc_real(size.getPixels());
+	fftw_complex	*f = fftw_alloc_complex(40 * (60 / 2 + 1));
+	// the second round uses the cached plans
+	roundtrip(size, in, out, f);
+	roundtrip(size, in, out, f);
+	fftw_free(in);
+	fftw_free(out);
+	fftw_free(f);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRoundtrip() end");
+}
+
+void	FFTWPlansTest::testUnaligned() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testUnaligned() begin");
+	ImageSize	size(33, 17);
+	int	n = size.getPixels();
+	double	*in = fftw_alloc_real(n + 1);
+	double	*out = fftw_alloc_real(n + 1);
+	fftw_complex	*f = fftw_alloc_complex(17 * (33 / 2 + 1));
+	roundtrip(size, in + 1, out + 1, f);
+	roundtrip(size, in, out, f);
+	fftw_free(in);
+	fftw_free(out);
+	fftw_free(f);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testUnaligned() end");
+}
+
+/**
+ * \brief Wisdom of measured plans is written by save()
+ */
+void	FFTWPlansTest::testWisdom() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testWisdom() begin");
+	std::string	filename("fftwtest.wisdom");
+	unlink(filename.c_str());
+	FFTWPlans::wisdom(filename);
+	FFTWPlans::measure(true);
+	ImageSize	size(24, 20);
+	double	*in = fftw_alloc_real(size.getPixels());
+	double	*out = fftw_alloc_real(size.getPixels());
+	fftw_complex	*f = fftw_alloc_complex(20 * (24 / 2 + 1));
+	roundtrip(size, in, out, f);
+	fftw_free(in);
+	fftw_free(out);
+	fftw_free(f);
+	FFTWPlans::save();
+	FFTWPlans::measure(false);
+	struct stat	sb;
+	CPPUNIT_ASSERT(0 == stat(filename.c_str(), &sb));
+	CPPUNIT_ASSERT(sb.st_size > 0);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testWisdom() end");
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FFTWPlansTest);
+
+} // namespace test
+} // namespace astro
@@ -0,0 +1,150 @@
+/*
+ * FITSheaderTest.cpp -- header only access and in place header updates
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroIO.h>
+#include <AstroDebug.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <includes.h>
+
+using namespace astro::io;
+using namespace astro::image;
+
+namespace astro {
+namespace test {
+
+class FITSheaderTest : public CppUnit::TestFixture {
+	std::string	filename;
+public:
+	void	setUp();
+	void	tearDown();
+	void	testHeader();
+	void	testCache();
+	void	testUpdate();
+
+	CPPUNIT_TEST_SUITE(FITSheaderTest);
+	CPPUNIT_TEST(testHeader);
+	CPPUNIT_TEST(testCache);
+	CPPUNIT_TEST(testUpdate);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FITSheaderTest);
+
+static long	filesize(const std::string& filename) {
+	struct stat	sb;
+	if (stat(filename.c_str(), &sb) < 0) {
+		return -1;
+	}
+	return sb.st_size;
+}
+
+/**
+ * \brief Write a small image with some metadata
+ */
+void	FITSheaderTest::setUp() {
+	filename = "tmp/header_test.fits";
+	unlink(filename.c_str());
+	Image<unsigned short>	image(320, 200);
+	for (int x = 0; x < 320; x++) {
+		for (int y = 0; y < 200; y++) {
+			image.pixel(x, y) = x * y;
+		}
+	}
+	image.setMetadata(FITSKeywords::meta(std::string("INSTRUME"),
+		std::string("SimCam")));
+	image.setMetadata(FITSKeywords::meta(std::string("EXPTIME"), 1.5));
+	FITSoutfile<unsigned short>	out(filename);
+	out.setPrecious(false);
+	out.write(image);
+}
+
+void	FITSheaderTest::tearDown() {
+	unlink(filename.c_str());
+	FITSheaderCache::clear();
+}
+
+void	FITSheaderTest::testHeader() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testHeader() begin");
+	FITSheaderPtr	header = FITSinfileBase::header(filename);
+	CPPUNIT_ASSERT(header->getSize() == ImageSize(320, 200));
+	CPPUNIT_ASSERT(header->getPlanes() == 1);
+	CPPUNIT_ASSERT(header->getBytesPerPlane() == sizeof(unsigned short));
+	CPPUNIT_ASSERT(header->getPixelType()
+		== std::type_index(typeid(unsigned short)));
+	CPPUNIT_ASSERT(header->hasMetadata("INSTRUME"));
+	CPPUNIT_ASSERT(trim((std::string)header->getMetadata("INSTRUME"))
+		== "SimCam");
+	CPPUNIT_ASSERT((double)header->getMetadata("EXPTIME") == 1.5);
+	CPPUNIT_ASSERT(!header->hasMetadata("GAIN"));
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testHeader() end");
+}
+
+/**
+ * \brief A header must only be read again if the file changes
+ */
+void	FITSheaderTest::testCache() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testCache() begin");
+	FITSheaderPtr	first = FITSinfileBase::header(filename);
+	unsigned long	hits = FITSheaderCache::hits();
+	unsigned long	misses = FITSheaderCache::misses();
+	FITSheaderPtr	second = FITSinfileBase::header(filename);
+	CPPUNIT_ASSERT(first.get() == second.get());
+	CPPUNIT_ASSERT(FITSheaderCache::hits() == hits + 1);
+	CPPUNIT_ASSERT(FITSheaderCache::misses() == misses);
+
+	// a new file with the same name must be read again
+	setUp();
+	FITSheaderPtr	third = FITSinfileBase::header(filename);
+	CPPUNIT_ASSERT(FITSheaderCache::misses() == misses + 1);
+	CPPUNIT_ASSERT((double)third->getMetadata("EXPTIME") == 1.5);
+
+	// a cache without capacity never returns a cached header
+	size_t	capacity = FITSheaderCache::capacity();
+	FITSheaderCache::capacity(0);
+	FITSinfileBase::header(filename);
+	CPPUNIT_ASSERT(FITSheaderCache::misses() == misses + 2);
+	FITSheaderCache::capacity(capacity);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testCache() end");
+}
+
+/**
+ * \brief Updating the header must keep the pixels and the file size
+ */
+void	FITSheaderTest::testUpdate() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testUpdate() begin");
+	long	size = filesize(filename);
+	FITSinfileBase::header(filename);
+	{
+		FITSupdatefile	file(filename);
+		ImageMetadata	metadata;
+		metadata.setMetadata(FITSKeywords::meta(
+			std::string("EXPTIME"), 30.));
+		metadata.setMetadata(FITSKeywords::meta(
+			std::string("GAIN"), 2.));
+		file.setMetadata(metadata);
+	}
+	// the new keyword fits into the padding of the header block
+	CPPUNIT_ASSERT(filesize(filename) == size);
+
+	FITSheaderPtr	header = FITSinfileBase::header(filename);
+	CPPUNIT_ASSERT((double)header->getMetadata("EXPTIME") == 30.);
+	CPPUNIT_ASSERT((double)header->getMetadata("GAIN") == 2.);
+	CPPUNIT_ASSERT(trim((std::string)header->getMetadata("INSTRUME"))
+		== "SimCam");
+
+	FITSin	in(filename);
+	ImagePtr	image = in.read();
+	Image<unsigned short>	*imagep
+		= dynamic_cast<Image<unsigned short> *>(&*image);
+	CPPUNIT_ASSERT(imagep != NULL);
+	CPPUNIT_ASSERT(imagep->pixel(17, 11) == 17 * 11);
+	CPPUNIT_ASSERT((double)image->getMetadata("EXPTIME") == 30.);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testUpdate() end");
+}
+
+} // namespace test
+} // namespace astro
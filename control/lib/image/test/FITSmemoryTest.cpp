@@ -0,0 +1,185 @@
+/*
+ * FITSmemoryTest.cpp -- test in memory FITS encoding and decoding
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+
+#include <AstroIO.h>
+#include <AstroUtils.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <config.h>
+#include <includes.h>
+#include <AstroDebug.h>
+
+using namespace astro::io;
+using namespace astro::image;
+
+namespace astro {
+namespace test {
+
+class FITSmemoryTest : public CppUnit::TestFixture {
+public:
+	void	setUp() { }
+	void	tearDown() { }
+	void	testUShort();
+	void	testRGB();
+	void	testMetadata();
+	void	testBenchmark();
+
+	CPPUNIT_TEST_SUITE(FITSmemoryTest);
+	CPPUNIT_TEST(testUShort);
+	CPPUNIT_TEST(testRGB);
+	CPPUNIT_TEST(testMetadata);
+	CPPUNIT_TEST(testBenchmark);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+static ImagePtr	ushortimage(int width, int height) {
+	Image<unsigned short>	*image = new Image<unsigned short>(width, height);
+	for (int x = 0; x < width; x++) {
+		for (int y = 0; y < height; y++) {
+			image->pixel(x, y) = (x * y) % 65536;
+		}
+	}
+	return ImagePtr(image);
+}
+
+void	FITSmemoryTest::testUShort() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testUShort() begin");
+	ImagePtr	image = ushortimage(640, 480);
+	void	*buffer = NULL;
+	size_t	buffersize = 0;
+	FITSout	out(&buffer, &buffersize);
+	out.write(image);
+	CPPUNIT_ASSERT(buffer != NULL);
+	CPPUNIT_ASSERT(0 == (buffersize % 2880));
+	CPPUNIT_ASSERT(buffersize >= 2 * 640 * 480);
+
+	FITSin	in(buffer, buffersize);
+	ImagePtr	copy = in.read();
+	free(buffer);
+	CPPUNIT_ASSERT(copy->size() == image->size());
+	Image<unsigned short>	*a
+		= dynamic_cast<Image<unsigned short> *>(&*image);
+	Image<unsigned short>	*b
+		= dynamic_cast<Image<unsigned short> *>(&*copy);
+	CPPUNIT_ASSERT(b != NULL);
+	for (int x = 0; x < 640; x += 7) {
+		for (int y = 0; y < 480; y += 5) {
+			CPPUNIT_ASSERT(a->pixel(x, y) == b->pixel(x, y));
+		}
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testUShort() end");
+}
+
+void	FITSmemoryTest::testRGB() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRGB() begin");
+	Image<RGB<unsigned char> >	*image
+		= new Image<RGB<unsigned char> >(256, 256);
+	for (int x = 0; x < 256; x++) {
+		for (int y = 0; y < 256; y++) {
+			image->pixel(x, y).R = x;
+			image->pixel(x, y).G = (x + y) % 256;
+			image->pixel(x, y).B = y;
+		}
+	}
+	ImagePtr	imageptr(image);
+	FITS	fits;
+	void	*buffer = NULL;
+	size_t	buffersize = 0;
+	fits.writeFITS(imageptr, &buffer, &buffersize);
+	ImagePtr	copy = fits.readFITS(buffer, buffersize);
+	free(buffer);
+	Image<RGB<unsigned char> >	*b
+		= dynamic_cast<Image<RGB<unsigned char> > *>(&*copy);
+	CPPUNIT_ASSERT(b != NULL);
+	CPPUNIT_ASSERT(b->pixel(17, 33).R == 17);
+	CPPUNIT_ASSERT(b->pixel(17, 33).G == 50);
+	CPPUNIT_ASSERT(b->pixel(17, 33).B == 33);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRGB() end");
+}
+
+void	FITSmemoryTest::testMetadata() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testMetadata() begin");
+	ImagePtr	image = ushortimage(64, 48);
+	image->setMetadata(FITSKeywords::meta(std::string("EXPTIME"), 1.5));
+	image->setMetadata(FITSKeywords::meta(std::string("INSTRUME"),
+		std::string("SIM")));
+	image->setOrigin(ImagePoint(12, 34));
+	void	*buffer = NULL;
+	size_t	buffersize = 0;
+	FITSout	out(&buffer, &buffersize);
+	out.write(image);
+	FITSin	in(buffer, buffersize);
+	ImagePtr	copy = in.read();
+	free(buffer);
+	CPPUNIT_ASSERT(copy->hasMetadata("EXPTIME"));
+	CPPUNIT_ASSERT((double)copy->getMetadata("EXPTIME") == 1.5);
+	CPPUNIT_ASSERT(copy->getMetadata("INSTRUME").getValue() == "SIM");
+	CPPUNIT_ASSERT(copy->origin() == ImagePoint(12, 34));
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testMetadata() end");
+}
+
+/**
+ * \brief Compare the frame rate of the temporary file and in memory paths
+ *
+ * The temporary file path is what the ICE conversion functions used to do:
+ * write the image to a file, read it back into a buffer, and decode it
+ * again from a file.
+ */
+void	FITSmemoryTest::testBenchmark() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBenchmark() begin");
+	ImagePtr	image = ushortimage(1920, 1080);
+	const int	frames = 20;
+
+	// temporary file round trip
+	std::string	filename("tmp/membench.fits");
+	Timer	timer;
+	timer.start();
+	for (int i = 0; i < frames; i++) {
+		unlink(filename.c_str());
+		FITSout	out(filename);
+		out.setPrecious(false);
+		out.write(image);
+		ImageBuffer	filebuffer(filename);
+		unlink(filename.c_str());
+		int	fd = open(filename.c_str(), O_CREAT | O_WRONLY, 0666);
+		if (fd >= 0) {
+			if (write(fd, filebuffer.data(), filebuffer.size()) < 0) {
+				debug(LOG_ERR, DEBUG_LOG, 0, "write failed");
+			}
+			close(fd);
+		}
+		FITSin	in(filename);
+		in.read();
+	}
+	timer.end();
+	unlink(filename.c_str());
+	double	fileframes = frames / timer.elapsed();
+
+	// in memory round trip
+	timer.start();
+	for (int i = 0; i < frames; i++) {
+		void	*buffer = NULL;
+		size_t	buffersize = 0;
+		FITSout	out(&buffer, &buffersize);
+		out.write(image);
+		FITSin	in(buffer, buffersize);
+		in.read();
+		free(buffer);
+	}
+	timer.end();
+	double	memoryframes = frames / timer.elapsed();
+
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%s frames: temp file %.1f frames/s, "
+		"memory %.1f frames/s", image->size().toString().c_str(),
+		fileframes, memoryframes);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBenchmark() end");
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FITSmemoryTest);
+
+} // namespace test
+} // namespace astro
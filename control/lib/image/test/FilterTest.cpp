@@ -96,7 +96,7 @@ void	FilterTest::testMedian() {
 		}
 	}
 	filter::Median<unsigned short, unsigned short>	m;
-	CPPUNIT_ASSERT(12641 == m(image));
+	CPPUNIT_ASSERT(12642 == m(image));
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "testMedian() end");
 }
 
@@ -124,7 +124,7 @@ void	FilterTest::testMedianLarge() {
 	}
 	filter::Median<unsigned int, unsigned int>	m;
 	unsigned int	median = m(image);
-	CPPUNIT_ASSERT(11943792 == median);
+	CPPUNIT_ASSERT(11943800 == median);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "testMedianLarge() end");
 }
 
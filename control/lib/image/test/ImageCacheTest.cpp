@@ -0,0 +1,160 @@
+/*
+ * ImageCacheTest.cpp -- memory budgeted cache of decoded image files
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <ImageCache.h>
+#include <AstroIO.h>
+#include <AstroDebug.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <includes.h>
+#include <thread>
+#include <chrono>
+
+using namespace astro::io;
+using namespace astro::image;
+
+namespace astro {
+namespace test {
+
+class ImageCacheTest : public CppUnit::TestFixture {
+	std::string	filename1;
+	std::string	filename2;
+	size_t	budget;
+	void	write(const std::string& filename, unsigned short value);
+public:
+	void	setUp();
+	void	tearDown();
+	void	testHit();
+	void	testBudget();
+	void	testChange();
+	void	testPrefetch();
+
+	CPPUNIT_TEST_SUITE(ImageCacheTest);
+	CPPUNIT_TEST(testHit);
+	CPPUNIT_TEST(testBudget);
+	CPPUNIT_TEST(testChange);
+	CPPUNIT_TEST(testPrefetch);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ImageCacheTest);
+
+/**
+ * \brief Write a 320x200 image with constant pixel value
+ */
+void	ImageCacheTest::write(const std::string& filename,
+		unsigned short value) {
+	unlink(filename.c_str());
+	Image<unsigned short>	image(320, 200);
+	image.fill(value);
+	FITSoutfile<unsigned short>	out(filename);
+	out.setPrecious(false);
+	out.write(image);
+}
+
+static unsigned short	value(ImagePtr image) {
+	Image<unsigned short>	*imagep
+		= dynamic_cast<Image<unsigned short> *>(&*image);
+	CPPUNIT_ASSERT(imagep != NULL);
+	return imagep->pixel(13, 7);
+}
+
+void	ImageCacheTest::setUp() {
+	filename1 = "tmp/cache_test_1.fits";
+	filename2 = "tmp/cache_test_2.fits";
+	write(filename1, 1);
+	write(filename2, 2);
+	budget = ImageCache::budget();
+	ImageCache::clear();
+}
+
+void	ImageCacheTest::tearDown() {
+	ImageCache::budget(budget);
+	ImageCache::clear();
+	unlink(filename1.c_str());
+	unlink(filename2.c_str());
+}
+
+/**
+ * \brief A second request for the same file must not read it again
+ */
+void	ImageCacheTest::testHit() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testHit() begin");
+	unsigned long	hits = ImageCache::hits();
+	unsigned long	misses = ImageCache::misses();
+	ImagePtr	first = ImageCache::get(filename1);
+	CPPUNIT_ASSERT(ImageCache::misses() == misses + 1);
+	CPPUNIT_ASSERT(ImageCache::contains(filename1));
+	ImagePtr	second = ImageCache::get(filename1);
+	CPPUNIT_ASSERT(first.get() == second.get());
+	CPPUNIT_ASSERT(ImageCache::hits() == hits + 1);
+	CPPUNIT_ASSERT(ImageCache::misses() == misses + 1);
+	CPPUNIT_ASSERT(ImageCache::bytes() == 320 * 200 * sizeof(unsigned short));
+	CPPUNIT_ASSERT(value(second) == 1);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testHit() end");
+}
+
+/**
+ * \brief The least recently used image is dropped to meet the budget
+ */
+void	ImageCacheTest::testBudget() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBudget() begin");
+	size_t	imagesize = 320 * 200 * sizeof(unsigned short);
+	ImageCache::budget(imagesize + imagesize / 2);
+	ImageCache::get(filename1);
+	ImageCache::get(filename2);
+	CPPUNIT_ASSERT(ImageCache::count() == 1);
+	CPPUNIT_ASSERT(!ImageCache::contains(filename1));
+	CPPUNIT_ASSERT(ImageCache::contains(filename2));
+	CPPUNIT_ASSERT(ImageCache::bytes() <= ImageCache::budget());
+
+	// an image larger than the budget is returned but not kept
+	ImageCache::budget(imagesize / 2);
+	CPPUNIT_ASSERT(ImageCache::count() == 0);
+	CPPUNIT_ASSERT(value(ImageCache::get(filename1)) == 1);
+	CPPUNIT_ASSERT(ImageCache::count() == 0);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBudget() end");
+}
+
+/**
+ * \brief A file that has been replaced must be read again
+ */
+void	ImageCacheTest::testChange() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testChange() begin");
+	CPPUNIT_ASSERT(value(ImageCache::get(filename1)) == 1);
+	write(filename1, 3);
+	unsigned long	misses = ImageCache::misses();
+	CPPUNIT_ASSERT(value(ImageCache::get(filename1)) == 3);
+	CPPUNIT_ASSERT(ImageCache::misses() == misses + 1);
+	CPPUNIT_ASSERT(ImageCache::count() == 1);
+
+	ImageCache::invalidate(filename1);
+	CPPUNIT_ASSERT(!ImageCache::contains(filename1));
+	CPPUNIT_ASSERT(ImageCache::bytes() == 0);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testChange() end");
+}
+
+/**
+ * \brief A prefetched image is found in the cache without a miss
+ */
+void	ImageCacheTest::testPrefetch() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testPrefetch() begin");
+	unsigned long	prefetched = ImageCache::prefetched();
+	ImageCache::prefetch(filename2);
+	int	timeout = 100;
+	while ((!ImageCache::contains(filename2)) && (timeout-- > 0)) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	}
+	CPPUNIT_ASSERT(ImageCache::contains(filename2));
+	CPPUNIT_ASSERT(ImageCache::prefetched() == prefetched + 1);
+	unsigned long	misses = ImageCache::misses();
+	CPPUNIT_ASSERT(value(ImageCache::get(filename2)) == 2);
+	CPPUNIT_ASSERT(ImageCache::misses() == misses);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testPrefetch() end");
+}
+
+} // namespace test
+} // namespace astro
@@ -0,0 +1,166 @@
+/*
+ * PercentileTest.cpp -- compare the percentile filter with sorting
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+
+#include <AstroFilter.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <AstroDebug.h>
+#include <cmath>
+#include <limits>
+
+using namespace astro::image;
+using namespace astro::image::filter;
+
+namespace astro {
+namespace test {
+
+class PercentileTest : public CppUnit::TestFixture {
+public:
+	void	setUp() { }
+	void	tearDown() { }
+	void	testHistogram();
+	void	testSelection();
+	void	testTiles();
+
+	CPPUNIT_TEST_SUITE(PercentileTest);
+	CPPUNIT_TEST(testHistogram);
+	CPPUNIT_TEST(testSelection);
+	CPPUNIT_TEST(testTiles);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PercentileTest);
+
+/**
+ * \brief Order statistic for a level computed by sorting
+ */
+template<typename T>
+static double	sorted(const Image<T>& image, double level) {
+	std::vector<double>	values;
+	for (size_t i = 0; i < image.size().getPixels(); i++) {
+		if (image.pixels[i] == image.pixels[i]) {
+			values.push_back(image.pixels[i]);
+		}
+	}
+	std::sort(values.begin(), values.end());
+	return values[percentile_rank(level, values.size())];
+}
+
+static std::vector<double>	testlevels() {
+	std::vector<double>	levels;
+	levels.push_back(0.001);
+	levels.push_back(0.5);
+	levels.push_back(0.999);
+	return levels;
+}
+
+void	PercentileTest::testHistogram() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testHistogram() begin");
+	Image<unsigned short>	image(400, 300);
+	for (int x = 0; x < 400; x++) {
+		for (int y = 0; y < 300; y++) {
+			image.pixel(x, y) = (x * 31 + y * y * 7) % 5000;
+		}
+	}
+	std::vector<double>	levels = testlevels();
+	PercentileFilter<unsigned short>	filter(levels, true);
+	Percentiles	p = filter(image);
+	CPPUNIT_ASSERT(p.count() == 120000);
+	for (size_t i = 0; i < levels.size(); i++) {
+		CPPUNIT_ASSERT(p.value(levels[i]) == sorted(image, levels[i]));
+	}
+
+	// the MAD is the median of the absolute deviations
+	Image<unsigned short>	deviations(400, 300);
+	double	m = p.median();
+	for (size_t i = 0; i < image.size().getPixels(); i++) {
+		deviations.pixels[i] = fabs(image.pixels[i] - m);
+	}
+	CPPUNIT_ASSERT(p.mad() == sorted(deviations, 0.5));
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testHistogram() end");
+}
+
+void	PercentileTest::testSelection() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testSelection() begin");
+	Image<float>	image(400, 300);
+	for (int x = 0; x < 400; x++) {
+		for (int y = 0; y < 300; y++) {
+			image.pixel(x, y) = sin(x * 0.37 + y * 1.3) * 100
+				+ ((x * 7 + y * 13) % 11);
+		}
+	}
+	image.pixel(17, 18) = std::numeric_limits<float>::quiet_NaN();
+	std::vector<double>	levels = testlevels();
+	PercentileFilter<float>	filter(levels, true);
+	Percentiles	p = filter(image);
+	CPPUNIT_ASSERT(p.count() == 119999);
+	for (size_t i = 0; i < levels.size(); i++) {
+		CPPUNIT_ASSERT(p.value(levels[i]) == sorted(image, levels[i]));
+	}
+	Image<float>	deviations(400, 300);
+	double	m = p.median();
+	for (size_t i = 0; i < image.size().getPixels(); i++) {
+		deviations.pixels[i] = fabs(image.pixels[i] - m);
+	}
+	CPPUNIT_ASSERT(fabs(p.mad() - sorted(deviations, 0.5)) < 1e-4);
+
+	// a tiny sample gives wide brackets, but the same result
+	filter.samplesize(100);
+	Percentiles	q = filter(image);
+	for (size_t i = 0; i < levels.size(); i++) {
+		CPPUNIT_ASSERT(q.value(levels[i]) == p.value(levels[i]));
+	}
+
+	// a width that divides the sampling step must not restrict the
+	// sample to a few columns of a horizontal gradient
+	Image<float>	gradient(100, 100);
+	for (int x = 0; x < 100; x++) {
+		for (int y = 0; y < 100; y++) {
+			gradient.pixel(x, y) = x + y * 0.001;
+		}
+	}
+	Percentiles	g = filter(gradient);
+	for (size_t i = 0; i < levels.size(); i++) {
+		CPPUNIT_ASSERT(g.value(levels[i]) == sorted(gradient, levels[i]));
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testSelection() end");
+}
+
+void	PercentileTest::testTiles() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testTiles() begin");
+	Image<unsigned short>	image(300, 200);
+	for (int x = 0; x < 300; x++) {
+		for (int y = 0; y < 200; y++) {
+			image.pixel(x, y) = 1000 * (x / 100) + (x * y) % 97;
+		}
+	}
+	std::vector<ImageRectangle>	tiles;
+	for (int x = 0; x < 300; x += 100) {
+		for (int y = 0; y < 200; y += 100) {
+			tiles.push_back(ImageRectangle(ImagePoint(x, y),
+				ImageSize(100, 100)));
+		}
+	}
+	PercentileFilter<unsigned short>	filter(0.5);
+	std::vector<Percentiles>	p = filter(image, tiles);
+	CPPUNIT_ASSERT(p.size() == tiles.size());
+	for (size_t i = 0; i < tiles.size(); i++) {
+		Image<unsigned short>	tile(100, 100);
+		for (int x = 0; x < 100; x++) {
+			for (int y = 0; y < 100; y++) {
+				tile.pixel(x, y) = image.pixel(
+					tiles[i].origin().x() + x,
+					tiles[i].origin().y() + y);
+			}
+		}
+		CPPUNIT_ASSERT(p[i].median() == sorted(tile, 0.5));
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testTiles() end");
+}
+
+} // namespace test
+} // namespace astro
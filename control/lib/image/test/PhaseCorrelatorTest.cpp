@@ -39,6 +39,7 @@ public:
 	void	testTriangle();
 	void	testMoon();
 	void	testOrion();
+	void	testPrepared();
 
 	CPPUNIT_TEST_SUITE(PhaseCorrelatorTest);
 //	CPPUNIT_TEST(testInteger);
@@ -52,6 +53,7 @@ public:
 //	CPPUNIT_TEST(testTriangle);
 //	CPPUNIT_TEST(testMoon);
 	CPPUNIT_TEST(testOrion);
+	CPPUNIT_TEST(testPrepared);
 	CPPUNIT_TEST_SUITE_END();
 };
 
@@ -97,6 +99,43 @@ void	PhaseCorrelatorTest::testInteger() {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "end Integer test");
 }
 
+static void	blob(Image<double>& image, double cx, double cy) {
+	for (int x = 0; x < image.size().width(); x++) {
+		for (int y = 0; y < image.size().height(); y++) {
+			double	r = hypot(x - cx, y - cy);
+			image.pixel(x, y) = 100 * exp(-r * r / 50);
+		}
+	}
+}
+
+/**
+ * \brief Correlate several images with a prepared reference
+ */
+void	PhaseCorrelatorTest::testPrepared() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "start Prepared test");
+	int	N = 128;
+	Image<double>	fromimage(N, N);
+	blob(fromimage, 60, 70);
+	PhaseCorrelator	prepared;
+	prepared.reference(fromimage);
+	CPPUNIT_ASSERT(prepared.prepared());
+	for (int i = 1; i <= 3; i++) {
+		Image<double>	toimage(N, N);
+		blob(toimage, 60 + i, 70 - 2 * i);
+		Point	translation = prepared.correlate(toimage).first;
+		PhaseCorrelator	pc;
+		Point	direct = pc(fromimage, toimage).first;
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "prepared %s, direct %s",
+			translation.toString().c_str(),
+			direct.toString().c_str());
+		CPPUNIT_ASSERT(fabs(translation.x() - direct.x()) < 1e-6);
+		CPPUNIT_ASSERT(fabs(translation.y() - direct.y()) < 1e-6);
+		CPPUNIT_ASSERT(fabs(translation.x() - i) < 0.5);
+		CPPUNIT_ASSERT(fabs(translation.y() + 2 * i) < 0.5);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "end Prepared test");
+}
+
 void	PhaseCorrelatorTest::testIntegerNegative() {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "start IntegerNegative test");
 	// create an image
@@ -0,0 +1,164 @@
+/*
+ * RiceCoderTest.cpp -- test the delta/Rice coder for raw image transport
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+
+#include <AstroIO.h>
+#include <AstroUtils.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <AstroDebug.h>
+#include <cstdlib>
+#include <cmath>
+
+using namespace astro::io;
+using namespace astro::image;
+
+namespace astro {
+namespace test {
+
+class RiceCoderTest : public CppUnit::TestFixture {
+public:
+	void	setUp() { }
+	void	tearDown() { }
+	void	testRoundtrip();
+	void	testExtremes();
+	void	testTruncated();
+	void	testBenchmark();
+
+	CPPUNIT_TEST_SUITE(RiceCoderTest);
+	CPPUNIT_TEST(testRoundtrip);
+	CPPUNIT_TEST(testExtremes);
+	CPPUNIT_TEST(testTruncated);
+	CPPUNIT_TEST(testBenchmark);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+/**
+ * \brief Create a simulated camera frame: sky background, noise and stars
+ */
+static Image<unsigned short>	*simulatedframe(int width, int height) {
+	Image<unsigned short>	*image = new Image<unsigned short>(width, height);
+	srandom(4711);
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			double	noise = ((random() % 64) + (random() % 64)) - 64;
+			image->pixel(x, y) = 1000 + noise;
+		}
+	}
+	for (int i = 0; i < 200; i++) {
+		int	cx = random() % width;
+		int	cy = random() % height;
+		for (int dx = -5; dx <= 5; dx++) {
+			for (int dy = -5; dy <= 5; dy++) {
+				int	x = cx + dx, y = cy + dy;
+				if ((x < 0) || (x >= width) || (y < 0) || (y >= height))
+					continue;
+				double	v = image->pixel(x, y)
+					+ 40000 * exp(-(dx * dx + dy * dy) / 4.);
+				image->pixel(x, y) = (v > 65535) ? 65535 : v;
+			}
+		}
+	}
+	return image;
+}
+
+void	RiceCoderTest::testRoundtrip() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRoundtrip() begin");
+	Image<unsigned short>	*image = simulatedframe(640, 480);
+	ImagePtr	imageptr(image);
+	RiceCoder	coder;
+	std::vector<unsigned char>	data;
+	size_t	n = image->size().getPixels();
+	coder.encode(image->pixels, n, data);
+	CPPUNIT_ASSERT(data.size() < 2 * n);
+	std::vector<unsigned short>	values(n);
+	coder.decode(data.data(), data.size(), values.data(), n);
+	for (size_t i = 0; i < n; i++) {
+		CPPUNIT_ASSERT(values[i] == image->pixels[i]);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRoundtrip() end");
+}
+
+void	RiceCoderTest::testExtremes() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testExtremes() begin");
+	// alternating extreme values and a length that is not a multiple
+	// of the block size
+	size_t	n = 1001;
+	std::vector<unsigned short>	original(n);
+	for (size_t i = 0; i < n; i++) {
+		original[i] = (i % 2) ? 65535 : ((i % 3) ? 0 : 12345);
+	}
+	RiceCoder	coder(17);
+	std::vector<unsigned char>	data;
+	coder.encode(original.data(), n, data);
+	std::vector<unsigned short>	values(n);
+	coder.decode(data.data(), data.size(), values.data(), n);
+	CPPUNIT_ASSERT(values == original);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testExtremes() end");
+}
+
+void	RiceCoderTest::testTruncated() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testTruncated() begin");
+	size_t	n = 4096;
+	std::vector<unsigned short>	original(n);
+	for (size_t i = 0; i < n; i++) {
+		original[i] = random() % 65536;
+	}
+	RiceCoder	coder;
+	std::vector<unsigned char>	data;
+	coder.encode(original.data(), n, data);
+	std::vector<unsigned short>	values(n);
+	bool	failed = false;
+	try {
+		coder.decode(data.data(), data.size() / 2, values.data(), n);
+	} catch (const std::runtime_error& x) {
+		failed = true;
+	}
+	CPPUNIT_ASSERT(failed);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testTruncated() end");
+}
+
+/**
+ * \brief Compare bandwidth and encode time of FITS and raw/Rice transport
+ */
+void	RiceCoderTest::testBenchmark() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBenchmark() begin");
+	Image<unsigned short>	*image = simulatedframe(4096, 3072);
+	ImagePtr	imageptr(image);
+	size_t	n = image->size().getPixels();
+
+	// FITS encoding in memory, as used by the FITS stream encoding
+	Timer	timer;
+	timer.start();
+	void	*buffer = NULL;
+	size_t	buffersize = 0;
+	FITSout	out(&buffer, &buffersize);
+	out.write(imageptr);
+	timer.end();
+	free(buffer);
+	double	fitstime = timer.elapsed();
+
+	// Rice encoding of the raw pixels
+	timer.start();
+	RiceCoder	coder;
+	std::vector<unsigned char>	data;
+	data.reserve(2 * n);
+	coder.encode(image->pixels, n, data);
+	timer.end();
+	double	ricetime = timer.elapsed();
+
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%s frame: FITS %lu bytes in %.3fs, "
+		"raw %lu bytes, Rice %lu bytes (%.1f%%) in %.3fs",
+		image->size().toString().c_str(), buffersize, fitstime,
+		2 * n, data.size(), 100. * data.size() / (2. * n), ricetime);
+	CPPUNIT_ASSERT(data.size() < buffersize);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBenchmark() end");
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RiceCoderTest);
+
+} // namespace test
+} // namespace astro
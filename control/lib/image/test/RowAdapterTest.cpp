@@ -0,0 +1,146 @@
+/*
+ * RowAdapterTest.cpp -- test row access to adapters and row materialization
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroAdapter.h>
+#include <AstroTransform.h>
+#include <AstroUtils.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <AstroDebug.h>
+#include <cmath>
+
+using namespace astro::image;
+using namespace astro::image::transform;
+using namespace astro::adapter;
+
+namespace astro {
+namespace test {
+
+class RowAdapterTest : public CppUnit::TestFixture {
+public:
+	void	setUp() { }
+	void	tearDown() { }
+	void	testRow();
+	void	testChain();
+	void	testBenchmark();
+
+	CPPUNIT_TEST_SUITE(RowAdapterTest);
+	CPPUNIT_TEST(testRow);
+	CPPUNIT_TEST(testChain);
+	CPPUNIT_TEST(testBenchmark);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+static Image<unsigned short>	*testimage(int w, int h) {
+	Image<unsigned short>	*image = new Image<unsigned short>(w, h);
+	for (int x = 0; x < w; x++) {
+		for (int y = 0; y < h; y++) {
+			image->pixel(x, y) = (x * 37 + y * 101) % 60000;
+		}
+	}
+	return image;
+}
+
+/**
+ * \brief Compare readrow with pixel access for a row segment
+ */
+template<typename Pixel>
+static void	comparerow(const ConstImageAdapter<Pixel>& adapter, int y,
+			int x0, int n) {
+	std::vector<Pixel>	row(n);
+	adapter.readrow(y, x0, n, row.data());
+	for (int i = 0; i < n; i++) {
+		CPPUNIT_ASSERT(row[i] == adapter.pixel(x0 + i, y));
+	}
+}
+
+void	RowAdapterTest::testRow() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRow() begin");
+	Image<unsigned short>	*image = testimage(64, 48);
+	ImagePtr	imageptr(image);
+	comparerow(*image, 7, 3, 50);
+	WindowAdapter<unsigned short>	window(*image,
+		ImageRectangle(ImagePoint(5, 9), ImageSize(40, 30)));
+	comparerow(window, 11, 2, 30);
+	ConvertingAdapter<float, unsigned short>	converting(*image);
+	comparerow(converting, 20, 0, 64);
+	ClampingAdapter<float, float>	clamping(converting, 1000, 20000);
+	comparerow(clamping, 30, 10, 40);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRow() end");
+}
+
+/**
+ * \brief Materialize a convert -> transform -> clamp chain
+ *
+ * The transform adapter computes the preimages of a row incrementally,
+ * so the values may differ from pixel access by rounding only.
+ */
+void	RowAdapterTest::testChain() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testChain() begin");
+	Image<unsigned short>	*image = testimage(200, 150);
+	ImagePtr	imageptr(image);
+	ConvertingAdapter<float, unsigned short>	converting(*image);
+	Transform	transform(0.1, Point(3.5, -2.25), 1.02);
+	TransformAdapter<float>	transformed(converting, transform, false);
+	ClampingAdapter<float, float>	clamping(transformed, 0, 50000);
+	Image<float>	result(clamping);
+	for (int y = 0; y < 150; y += 7) {
+		for (int x = 0; x < 200; x += 3) {
+			CPPUNIT_ASSERT(fabs(result.pixel(x, y)
+				- clamping.pixel(x, y)) < 0.01);
+		}
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testChain() end");
+}
+
+/**
+ * \brief Compare column order pixel access with row materialization
+ */
+void	RowAdapterTest::testBenchmark() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBenchmark() begin");
+	int	w = 4096, h = 3072;
+	Image<unsigned short>	*image = testimage(w, h);
+	ImagePtr	imageptr(image);
+	ConvertingAdapter<float, unsigned short>	converting(*image);
+	Transform	transform(0.01, Point(12.5, -7.25), 1);
+	TransformAdapter<float>	transformed(converting, transform, false);
+	ClampingAdapter<float, float>	clamping(transformed, 0, 50000);
+
+	// the old way: one virtual pixel call per adapter and pixel,
+	// traversing the image column by column
+	Timer	timer;
+	timer.start();
+	Image<float>	columns(w, h);
+	for (int x = 0; x < w; x++) {
+		for (int y = 0; y < h; y++) {
+			columns.pixel(x, y) = clamping.pixel(x, y);
+		}
+	}
+	timer.end();
+	double	columntime = timer.elapsed();
+
+	// row materialization through the adapter constructor
+	timer.start();
+	Image<float>	rows(clamping);
+	timer.end();
+	double	rowtime = timer.elapsed();
+
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "convert/transform/clamp %dx%d: "
+		"pixel %.3fs, rows %.3fs, speedup %.1f", w, h, columntime,
+		rowtime, columntime / rowtime);
+	for (int y = 0; y < h; y += 97) {
+		for (int x = 0; x < w; x += 89) {
+			CPPUNIT_ASSERT(fabs(rows.pixel(x, y)
+				- columns.pixel(x, y)) < 0.01);
+		}
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBenchmark() end");
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RowAdapterTest);
+
+} // namespace test
+} // namespace astro
@@ -0,0 +1,119 @@
+/*
+ * TriangleMatchingTest.cpp -- test k-d tree and triangle matching
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+
+#include <AstroTransform.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <AstroDebug.h>
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+using namespace astro::image;
+using namespace astro::image::transform;
+
+namespace astro {
+namespace test {
+
+class TriangleMatchingTest : public CppUnit::TestFixture {
+public:
+	void	setUp() { }
+	void	tearDown() { }
+	void	testPointTree();
+	void	testMatching();
+
+	CPPUNIT_TEST_SUITE(TriangleMatchingTest);
+	CPPUNIT_TEST(testPointTree);
+	CPPUNIT_TEST(testMatching);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TriangleMatchingTest);
+
+/**
+ * \brief Compare tree queries with a linear search
+ */
+void	TriangleMatchingTest::testPointTree() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testPointTree() begin");
+	std::mt19937	generator(4711);
+	std::uniform_real_distribution<double>	uniform(0, 100);
+	std::vector<Point>	points;
+	for (int i = 0; i < 500; i++) {
+		points.push_back(Point(uniform(generator), uniform(generator)));
+	}
+	PointTree	tree(points);
+	for (int q = 0; q < 50; q++) {
+		Point	p(uniform(generator), uniform(generator));
+		std::vector<int>	order(points.size());
+		for (size_t i = 0; i < order.size(); i++) {
+			order[i] = i;
+		}
+		std::sort(order.begin(), order.end(),
+			[&](int a, int b) {
+				return distance(p, points[a])
+					< distance(p, points[b]);
+			}
+		);
+		CPPUNIT_ASSERT(tree.nearest(p) == order[0]);
+		std::vector<int>	k = tree.nearest(p, 7);
+		CPPUNIT_ASSERT(k.size() == 7);
+		for (int i = 0; i < 7; i++) {
+			CPPUNIT_ASSERT(k[i] == order[i]);
+		}
+		std::vector<int>	w = tree.within(p, 10);
+		size_t	count = 0;
+		while ((count < order.size())
+			&& (distance(p, points[order[count]]) <= 10)) {
+			count++;
+		}
+		CPPUNIT_ASSERT(w.size() == count);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testPointTree() end");
+}
+
+/**
+ * \brief Match 200 stars with a large rotation, lost and spurious stars
+ */
+void	TriangleMatchingTest::testMatching() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testMatching() begin");
+	std::mt19937	generator(1234);
+	std::uniform_real_distribution<double>	x(0, 2000);
+	std::uniform_real_distribution<double>	y(0, 1500);
+	std::normal_distribution<double>	noise(0, 0.2);
+	Transform	transform(37 * M_PI / 180, Point(300, -200), 1.02);
+	std::vector<Star>	from;
+	std::vector<Star>	to;
+	for (int i = 0; i < 200; i++) {
+		Point	p(x(generator), y(generator));
+		from.push_back(Star(p));
+		// every tenth star is lost in the second image
+		if (i % 10) {
+			Point	q = transform(p) + Point(noise(generator),
+							noise(generator));
+			to.push_back(Star(q));
+		}
+	}
+	for (int i = 0; i < 20; i++) {
+		to.push_back(Star(Point(x(generator), y(generator))));
+	}
+	std::shuffle(to.begin(), to.end(), generator);
+
+	TriangleSetFactory	factory;
+	TriangleSet	fromtriangles = factory.get(from, 175);
+	TriangleSet	totriangles = factory.get(to, 175);
+	CPPUNIT_ASSERT(fromtriangles.size() > 100);
+	Transform	t = fromtriangles.closest(totriangles);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "transform found: %s",
+		t.toString().c_str());
+	for (auto ptr = from.begin(); ptr != from.end(); ptr++) {
+		CPPUNIT_ASSERT(distance(t(*ptr), transform(*ptr)) < 0.5);
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testMatching() end");
+}
+
+} // namespace test
+} // namespace astro
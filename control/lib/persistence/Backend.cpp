@@ -10,6 +10,8 @@
 #include <AstroDebug.h>
 #include <includes.h>
 #include <mutex>
+#include <set>
+#include <cctype>
 
 namespace astro {
 namespace persistence {
@@ -33,6 +35,7 @@ public:
 class Sqlite3Statement : public Statement {
 	Sqlite3Backend&	_backend;
 	sqlite3_stmt	*stmt;
+	void	prepare();
 public:
 	Sqlite3Statement(Sqlite3Backend& backend, const std::string& query);
 	virtual ~Sqlite3Statement();
@@ -47,6 +50,7 @@ protected:
         virtual Row	row();
 public:
         virtual Result  result();
+	virtual CursorPtr	cursor();
 	// retrieve values
 	virtual int	integerColumn(int colno);
 	virtual double	doubleColumn(int colno);
@@ -55,12 +59,59 @@ public:
 
 /**
  * \brief Sqlite3 backend abstraction
+ *
+ * The backend caches the schema information needed by TableBase, i.e.
+ * which tables exist and what fields they have, and keeps prepared
+ * statements for reuse after the Statement objects using them have
+ * been destroyed.
+ */
+/**
+ * \brief Cursor reading the rows of a Sqlite3 statement
+ */
+class Sqlite3Cursor : public Cursor {
+	Sqlite3Backend&	_backend;
+	sqlite3_stmt	*_stmt;
+	ColumnIndex	_index;
+	int	_columns;
+public:
+	Sqlite3Cursor(Sqlite3Backend& backend, sqlite3_stmt *stmt);
+	virtual bool	next();
+	virtual int	columns() const { return _columns; }
+	virtual const ColumnIndex&	index() const { return _index; }
+	virtual column_type	type(int colno) const;
+	virtual long	intValue(int colno) const;
+	virtual double	doubleValue(int colno) const;
+	virtual std::string	stringValue(int colno) const;
+};
+
+/**
+ * \brief Build the column index of a statement
  */
+static std::vector<std::string>	columnnames(sqlite3_stmt *stmt) {
+	std::vector<std::string>	names;
+	int	columns = sqlite3_column_count(stmt);
+	for (int colno = 0; colno < columns; colno++) {
+		names.push_back(std::string(sqlite3_column_name(stmt, colno)));
+	}
+	return names;
+}
+
 class Sqlite3Backend : public DatabaseBackend {
 	std::string	_filename;
 	sqlite3	*_database;
 public:
 	sqlite3	*database() { return _database; }
+private:
+	std::recursive_mutex	_cache_mutex;
+	std::set<std::string>	_tables;
+	std::map<std::string, std::vector<std::string> >	_fieldnames;
+	typedef std::multimap<std::string, sqlite3_stmt *>	statementmap_t;
+	statementmap_t	_statements;
+	void	pragma(const std::string& pragma, bool required);
+	void	schemachange(const std::string& query);
+public:
+	sqlite3_stmt	*pooledstatement(const std::string& query);
+	void	release(const std::string& query, sqlite3_stmt *stmt);
 
 public:
 	Sqlite3Backend(const std::string& filename);
@@ -88,17 +139,28 @@ public:
 Sqlite3Statement::Sqlite3Statement(Sqlite3Backend& backend,
 		const std::string& query) 
 	: Statement(query), _backend(backend) {
+	stmt = _backend.pooledstatement(query);
+	if (NULL == stmt) {
+		prepare();
+	}
+}
+
+/**
+ * \brief Prepare the statement if the backend has none in its pool
+ */
+void	Sqlite3Statement::prepare() {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "preparing statement with SQL: '%s'",
-		query.c_str());
-	stmt = NULL;
+		query().c_str());
+	std::unique_lock<std::recursive_mutex>	lock(
+		_backend.transaction_mutex());
 	int	rc;
 	const char	*tail;
 	if (SQLITE_OK == (rc = sqlite3_prepare_v2(_backend.database(),
-		query.c_str(), query.size(), &stmt, &tail))) {
+		query().c_str(), query().size(), &stmt, &tail))) {
 		if (NULL == stmt) {
 			std::string	cause
 				= stringprintf("not an sql query: '%s'",
-					query.c_str());
+					query().c_str());
 			debug(LOG_ERR, DEBUG_LOG, 0, "%s", cause.c_str());
 			throw BadQuery(cause);
 		}
@@ -113,15 +175,12 @@ Sqlite3Statement::Sqlite3Statement(Sqlite3Backend& backend,
 
 /**
  * \brief Destroy the statement
+ *
+ * The prepared statement goes back to the pool of the backend, which
+ * finalizes it if the pool is full.
  */
 Sqlite3Statement::~Sqlite3Statement() {
-//	debug(LOG_DEBUG, DEBUG_LOG, 0, "destroy statement '%s'",
-//		query().c_str());
-	int	rc = sqlite3_finalize(stmt);
-	if (rc != SQLITE_OK) {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "error in finalize: %s",
-			sqlite3_errmsg(_backend.database()));
-	}
+	_backend.release(query(), stmt);
 }
 
 void	Sqlite3Statement::bindInteger(int colno, int value) {
@@ -174,6 +233,8 @@ std::string	Sqlite3Statement::stringColumn(int colno) {
  * \brief Execute a statement
  */
 void	Sqlite3Statement::execute() {
+	std::unique_lock<std::recursive_mutex>	lock(
+		_backend.transaction_mutex());
 	int	retry = 0;
 	int	rc;
 	while (retry < 10) {
@@ -235,17 +296,94 @@ Row	Sqlite3Statement::row() {
 
 Result	Sqlite3Statement::result() {
 //	debug(LOG_DEBUG, DEBUG_LOG, 0, "retrieveing query result");
+	std::unique_lock<std::recursive_mutex>	lock(
+		_backend.transaction_mutex());
 	Result	result;
+	// all rows share the same column index
+	ColumnIndexPtr	index(new ColumnIndex(columnnames(stmt)));
 	while (SQLITE_ROW == sqlite3_step(stmt)) {
 //		debug(LOG_DEBUG, DEBUG_LOG, 0, "retrieveing row");
 		// process next row
 		result.push_back(row());
+		result.back().index(index);
 	}
 //	debug(LOG_DEBUG, DEBUG_LOG, 0, "query result has %d rows",
 //		result.size());
 	return result;
 }
 
+/**
+ * \brief Create a cursor for the rows of the statement
+ */
+CursorPtr	Sqlite3Statement::cursor() {
+	return CursorPtr(new Sqlite3Cursor(_backend, stmt));
+}
+
+//////////////////////////////////////////////////////////////////////
+// Sqlite3 cursor implementation
+//////////////////////////////////////////////////////////////////////
+Sqlite3Cursor::Sqlite3Cursor(Sqlite3Backend& backend, sqlite3_stmt *stmt)
+	: _backend(backend), _stmt(stmt), _index(columnnames(stmt)) {
+	_columns = sqlite3_column_count(_stmt);
+}
+
+/**
+ * \brief Advance to the next row
+ *
+ * \return false if there are no more rows
+ */
+bool	Sqlite3Cursor::next() {
+	std::unique_lock<std::recursive_mutex>	lock(
+		_backend.transaction_mutex());
+	int	retry = 0;
+	while (retry < 10) {
+		int	rc = sqlite3_step(_stmt);
+		switch (rc) {
+		case SQLITE_ROW:
+			return true;
+		case SQLITE_DONE:
+			return false;
+		case SQLITE_BUSY:
+			retry++;
+			usleep(10000);
+			break;
+		default:
+			debug(LOG_DEBUG, DEBUG_LOG, 0,
+				"sqlite3_step return code: %d", rc);
+			throw Sqlite3Exception(_backend, "cursor next");
+		}
+	}
+	throw Sqlite3Exception(_backend, "cursor next: after 10 retries");
+}
+
+Cursor::column_type	Sqlite3Cursor::type(int colno) const {
+	switch (sqlite3_column_type(_stmt, colno)) {
+	case SQLITE_INTEGER:
+		return integer_type;
+	case SQLITE_FLOAT:
+		return double_type;
+	case SQLITE_TEXT:
+		return string_type;
+	}
+	return null_type;
+}
+
+long	Sqlite3Cursor::intValue(int colno) const {
+	return sqlite3_column_int64(_stmt, colno);
+}
+
+double	Sqlite3Cursor::doubleValue(int colno) const {
+	return sqlite3_column_double(_stmt, colno);
+}
+
+std::string	Sqlite3Cursor::stringValue(int colno) const {
+	const char	*s = (const char *)sqlite3_column_text(_stmt, colno);
+	if (NULL == s) {
+		return std::string();
+	}
+	return std::string(s, sqlite3_column_bytes(_stmt, colno));
+}
+
 //////////////////////////////////////////////////////////////////////
 // Sqlite3 Backend implementation
 //////////////////////////////////////////////////////////////////////
@@ -330,13 +468,110 @@ Sqlite3Backend::Sqlite3Backend(const std::string& filename)
 		sqlite3_free(errmesg);
 		throw BadDatabase(msg);
 	}
+
+	// write ahead logging lets readers continue while the batch writer
+	// commits, and with it synchronous = NORMAL is still safe
+	pragma("PRAGMA journal_mode = WAL;", false);
+	pragma("PRAGMA synchronous = NORMAL;", false);
+}
+
+/**
+ * \brief Execute a pragma
+ *
+ * \param required	whether failure to execute the pragma is fatal
+ */
+void	Sqlite3Backend::pragma(const std::string& pragma, bool required) {
+	char	*errmesg = NULL;
+	if (sqlite3_exec(_database, pragma.c_str(), NULL, NULL, &errmesg)) {
+		std::string	msg = stringprintf("'%s' failed: %s",
+			pragma.c_str(), errmesg);
+		sqlite3_free(errmesg);
+		if (required) {
+			debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+			throw BadDatabase(msg);
+		}
+		debug(LOG_WARNING, DEBUG_LOG, 0, "%s", msg.c_str());
+	}
 }
 
 Sqlite3Backend::~Sqlite3Backend() {
+	// the batch writer still needs the connection to write queued rows
+	stopwriter();
+	statementmap_t::iterator	i;
+	for (i = _statements.begin(); i != _statements.end(); i++) {
+		sqlite3_finalize(i->second);
+	}
+	_statements.clear();
 	sqlite3_close(_database);
 	_database = NULL;
 }
 
+/**
+ * \brief Maximum number of prepared statements kept by the backend
+ */
+static const size_t	statement_pool_size = 64;
+
+/**
+ * \brief Get a prepared statement for a query from the pool
+ *
+ * \return NULL if there is no idle prepared statement for this query
+ */
+sqlite3_stmt	*Sqlite3Backend::pooledstatement(const std::string& query) {
+	std::unique_lock<std::recursive_mutex>	lock(_cache_mutex);
+	statementmap_t::iterator	i = _statements.find(query);
+	if (i == _statements.end()) {
+		return NULL;
+	}
+	sqlite3_stmt	*stmt = i->second;
+	_statements.erase(i);
+	return stmt;
+}
+
+/**
+ * \brief Return a statement to the pool
+ *
+ * The statement is reset and its bindings are cleared, so it can be used
+ * for the same query again. If the pool is full, the statement is
+ * finalized.
+ */
+void	Sqlite3Backend::release(const std::string& query, sqlite3_stmt *stmt) {
+	if (NULL == stmt) {
+		return;
+	}
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
+	{
+		std::unique_lock<std::recursive_mutex>	lock(_cache_mutex);
+		if (_statements.size() < statement_pool_size) {
+			_statements.insert(std::make_pair(query, stmt));
+			return;
+		}
+	}
+	if (SQLITE_OK != sqlite3_finalize(stmt)) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "error in finalize: %s",
+			sqlite3_errmsg(_database));
+	}
+}
+
+/**
+ * \brief Forget cached schema information if a query changes the schema
+ */
+void	Sqlite3Backend::schemachange(const std::string& query) {
+	std::string	verb;
+	std::string::const_iterator	i = query.begin();
+	while ((i != query.end()) && isspace(*i)) {
+		i++;
+	}
+	while ((i != query.end()) && isalpha(*i)) {
+		verb.push_back(tolower(*i++));
+	}
+	if ((verb == "create") || (verb == "drop") || (verb == "alter")) {
+		std::unique_lock<std::recursive_mutex>	lock(_cache_mutex);
+		_tables.clear();
+		_fieldnames.clear();
+	}
+}
+
 std::string	Sqlite3Backend::escape(const std::string& value) {
 	return value;
 }
@@ -381,8 +616,10 @@ static int	collector_callback(void *coll, int columns, char **values,
  */
 Result	Sqlite3Backend::query(const std::string& query) {
 //	debug(LOG_DEBUG, DEBUG_LOG, 0, "query: %s", query.c_str());
+	std::unique_lock<std::recursive_mutex>	lock(transaction_mutex());
 	ResultCollector	collector;
 	char	*errmsg = NULL;
+	schemachange(query);
 	int	rc = sqlite3_exec(_database, query.c_str(),
 			collector_callback, &collector, &errmsg);
 	if (SQLITE_OK == rc) {
@@ -396,10 +633,18 @@ Result	Sqlite3Backend::query(const std::string& query) {
 /**
  * \brief Retreive a list of field names of a table
  *
- * The id field is always ignored.
+ * The id field is always ignored. Field names are cached until a query
+ * changes the schema.
  */
 std::vector<std::string>	Sqlite3Backend::fieldnames(
 					const std::string& tablename) {
+	std::unique_lock<std::recursive_mutex>	tlock(transaction_mutex());
+	std::unique_lock<std::recursive_mutex>	lock(_cache_mutex);
+	std::map<std::string, std::vector<std::string> >::const_iterator	f
+		= _fieldnames.find(tablename);
+	if (f != _fieldnames.end()) {
+		return f->second;
+	}
 	std::vector<std::string>	result;
 	Result	tableinfo = query("PRAGMA table_info(" + tablename + ")");
 	Result::const_iterator	rowp;
@@ -409,38 +654,71 @@ std::vector<std::string>	Sqlite3Backend::fieldnames(
 			result.push_back(fieldname);
 		}
 	}
+	_fieldnames.insert(std::make_pair(tablename, result));
 	return result;
 }
 
 /**
  * \brief Start a transaction
+ *
+ * The calling thread owns the transaction mutex until the transaction
+ * is committed or rolled back.
  */
 void	Sqlite3Backend::begin() {
-	query("BEGIN TRANSACTION;");
+	lock_transaction();
+	try {
+		query("BEGIN TRANSACTION;");
+	} catch (...) {
+		unlock_transaction();
+		throw;
+	}
 }
 
 void	Sqlite3Backend::begin(const std::string& savepoint) {
-	query("SAVEPOINT " + savepoint + ";");
+	lock_transaction();
+	try {
+		query("SAVEPOINT " + savepoint + ";");
+	} catch (...) {
+		unlock_transaction();
+		throw;
+	}
 }
 
 /**
  * \brief Commit a transaction
+ *
+ * If the commit fails, the transaction is still open, and the caller
+ * has to roll it back.
  */
 void	Sqlite3Backend::commit() {
 	query("COMMIT TRANSACTION;");
+	unlock_transaction();
 }
 
 void	Sqlite3Backend::commit(const std::string& savepoint) {
 	query("RELEASE SAVEPOINT " + savepoint + ";");
+	unlock_transaction();
 }
 
 /**
  * \brief Roll back a transaction
  */
 void	Sqlite3Backend::rollback() {
-	query("ROLLBACK TRANSACTION;");
+	try {
+		query("ROLLBACK TRANSACTION;");
+	} catch (...) {
+		unlock_transaction();
+		throw;
+	}
+	unlock_transaction();
 }
 
+/**
+ * \brief Roll back to a savepoint
+ *
+ * This does not end the savepoint, it remains open until it is released
+ * with commit(savepoint).
+ */
 void	Sqlite3Backend::rollback(const std::string& savepoint) {
 	query("ROLLBACK TO SAVEPOINT " + savepoint + ";");
 }
@@ -449,6 +727,7 @@ void	Sqlite3Backend::rollback(const std::string& savepoint) {
  * \brief Create a statement from a query
  */
 StatementPtr	Sqlite3Backend::statement(const std::string& query) {
+	schemachange(query);
 	return StatementPtr(new Sqlite3Statement(*this, query));
 }
 
@@ -457,10 +736,16 @@ StatementPtr	Sqlite3Backend::statement(const std::string& query) {
  */
 bool	Sqlite3Backend::hastable(const std::string& tablename) {
 	//debug(LOG_DEBUG, DEBUG_LOG, 0, "check for table %s", tablename.c_str());
+	std::unique_lock<std::recursive_mutex>	tlock(transaction_mutex());
+	std::unique_lock<std::recursive_mutex>	lock(_cache_mutex);
+	if (_tables.find(tablename) != _tables.end()) {
+		return true;
+	}
 	try {
 		Result	res = query("PRAGMA table_info('" + tablename + "');");
 		if (res.size() > 0) {
 			//debug(LOG_DEBUG, DEBUG_LOG, 0, "table exists");
+			_tables.insert(tablename);
 			return true;
 		}
 	} catch (std::exception& x) {
@@ -471,6 +756,37 @@ bool	Sqlite3Backend::hastable(const std::string& tablename) {
 	return false;
 }
 
+//////////////////////////////////////////////////////////////////////
+// DatabaseBackend transaction lock
+//////////////////////////////////////////////////////////////////////
+/**
+ * \brief Acquire the transaction mutex for a new (nested) transaction
+ */
+void	DatabaseBackend::lock_transaction() {
+	_transaction_mutex.lock();
+	_transaction_owner = std::this_thread::get_id();
+	_transaction_depth++;
+}
+
+/**
+ * \brief Release the transaction mutex when a transaction ends
+ *
+ * Ending a transaction the calling thread does not own only logs an
+ * error, unlocking a mutex the thread does not hold is not allowed.
+ */
+void	DatabaseBackend::unlock_transaction() {
+	if ((_transaction_owner != std::this_thread::get_id())
+		|| (_transaction_depth <= 0)) {
+		debug(LOG_ERR, DEBUG_LOG, 0,
+			"ending a transaction this thread did not begin");
+		return;
+	}
+	if (0 == --_transaction_depth) {
+		_transaction_owner = std::thread::id();
+	}
+	_transaction_mutex.unlock();
+}
+
 //////////////////////////////////////////////////////////////////////
 // Sqlite3Exception
 //////////////////////////////////////////////////////////////////////
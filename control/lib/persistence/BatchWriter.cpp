@@ -0,0 +1,333 @@
+/*
+ * BatchWriter.cpp -- write inserts in batches in a background thread
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroPersistence.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <sstream>
+
+namespace astro {
+namespace persistence {
+
+/**
+ * \brief Create a batch writer for a database
+ *
+ * \param database	the database to write to
+ * \param maxrows	number of queued rows that triggers a write
+ * \param maxdelay	maximum time in milliseconds a row stays queued
+ */
+BatchWriter::BatchWriter(DatabaseBackend *database, size_t maxrows,
+	int maxdelay)
+	: _database(database), _maxrows(maxrows), _maxdelay(maxdelay) {
+	if (NULL == _database) {
+		debug(LOG_ERR, DEBUG_LOG, 0, "no database");
+		throw BadDatabase("no database present");
+	}
+	if (_maxrows < 1) {
+		_maxrows = 1;
+	}
+	_running = true;
+	_thread = std::thread(&BatchWriter::run, this);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "batch writer started: %d rows, %d ms",
+		_maxrows, _maxdelay);
+}
+
+/**
+ * \brief Stop the background thread and write the remaining rows
+ */
+void	BatchWriter::stop() {
+	{
+		std::unique_lock<std::mutex>	lock(_mutex);
+		_running = false;
+		_condition.notify_all();
+	}
+	if (_thread.joinable()) {
+		_thread.join();
+	}
+	try {
+		flush();
+	} catch (const std::exception& x) {
+		debug(LOG_ERR, DEBUG_LOG, 0, "cannot write remaining rows: %s",
+			x.what());
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "batch writer stopped");
+}
+
+BatchWriter::~BatchWriter() {
+	stop();
+}
+
+/**
+ * \brief Get the next free id of a table from the database
+ */
+long	BatchWriter::nextid(const std::string& tablename) {
+	std::ostringstream	out;
+	out << "select coalesce(max(id), 0) + 1 as 'nextid' from "
+		<< tablename;
+	Result	result = _database->query(out.str());
+	if (result.size() != 1) {
+		std::string	msg = stringprintf("cannot get next id for %s",
+			tablename.c_str());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	return result.front()[0]->intValue();
+}
+
+/**
+ * \brief Reserve the id for a new row
+ *
+ * The counter of a table is initialized from the database, and
+ * refreshed after all queued rows of the table have been written, so
+ * that rows written by other processes are taken into account. The
+ * counter never goes back, so an id is never handed out twice. The
+ * query runs without the queue mutex, because it needs the transaction
+ * mutex, which the background thread holds while it takes the queue
+ * mutex.
+ */
+long	BatchWriter::reserve(const std::string& tablename) {
+	std::unique_lock<std::mutex>	lock(_mutex);
+	if ((_nextids.find(tablename) == _nextids.end())
+		|| (_stale.find(tablename) != _stale.end())) {
+		lock.unlock();
+		long	databaseid = nextid(tablename);
+		lock.lock();
+		long&	counter = _nextids[tablename];
+		counter = std::max(counter, databaseid);
+		_stale.erase(tablename);
+	}
+	return _nextids[tablename]++;
+}
+
+/**
+ * \brief Queue a row for insertion
+ *
+ * \return the id the row will have in the database
+ */
+long	BatchWriter::add(const std::string& tablename,
+		const UpdateSpec& updatespec) {
+	entry_t	entry;
+	entry.tablename = tablename;
+	entry.updatespec = updatespec;
+	entry.id = reserve(tablename);
+	std::unique_lock<std::mutex>	lock(_mutex);
+	if (_queue.size() == 0) {
+		_oldest = std::chrono::steady_clock::now();
+	}
+	_queue.push_back(entry);
+	if (_queue.size() >= _maxrows) {
+		_condition.notify_all();
+	}
+	return entry.id;
+}
+
+/**
+ * \brief Find out whether rows for a table are still queued
+ *
+ * A batch that is currently being written is no longer in the queue,
+ * so this waits for the write to complete.
+ */
+bool	BatchWriter::pending(const std::string& tablename) {
+	std::unique_lock<std::recursive_mutex>	transactionlock(
+		_database->transaction_mutex());
+	std::unique_lock<std::mutex>	writelock(_write_mutex);
+	std::unique_lock<std::mutex>	lock(_mutex);
+	std::list<entry_t>::const_iterator	i;
+	for (i = _queue.begin(); i != _queue.end(); i++) {
+		if (i->tablename == tablename) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * \brief Insert a single row
+ */
+void	BatchWriter::insert(const entry_t& entry, long id) {
+	StatementPtr	stmt = _database->statement(
+		entry.updatespec.insertquery(entry.tablename));
+	entry.updatespec.bind(stmt);
+	entry.updatespec.bindid(stmt, id);
+	stmt->execute();
+}
+
+/**
+ * \brief Write a batch of rows
+ *
+ * All rows are written in a single transaction. If the transaction
+ * fails, the rows are written one by one, so that a bad row does not
+ * cost the complete batch. The ids have already been returned to the
+ * callers, so a row that cannot be written with its id is not
+ * renumbered, the write fails with an exception instead.
+ */
+void	BatchWriter::write(std::list<entry_t>& entries) {
+	if (entries.size() == 0) {
+		return;
+	}
+	std::list<entry_t>::const_iterator	i;
+	bool	batched = false;
+	try {
+		_database->begin("batchwriter");
+		try {
+			for (i = entries.begin(); i != entries.end(); i++) {
+				insert(*i, i->id);
+			}
+			_database->commit("batchwriter");
+			batched = true;
+		} catch (const std::exception& x) {
+			debug(LOG_WARNING, DEBUG_LOG, 0,
+				"batch of %d rows failed: %s", entries.size(),
+				x.what());
+			_database->rollback("batchwriter");
+			_database->commit("batchwriter");
+		}
+	} catch (const std::exception& x) {
+		debug(LOG_ERR, DEBUG_LOG, 0, "cannot use transaction: %s",
+			x.what());
+	}
+	int	lost = 0;
+	if (!batched) {
+		for (i = entries.begin(); i != entries.end(); i++) {
+			try {
+				insert(*i, i->id);
+			} catch (const std::exception& x) {
+				debug(LOG_ERR, DEBUG_LOG, 0,
+					"row %ld of %s lost: %s",
+					i->id, i->tablename.c_str(), x.what());
+				lost++;
+			}
+		}
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%d rows written",
+		entries.size() - lost);
+
+	// tables without queued rows refresh their counter from the
+	// database, so that rows written by other processes are seen
+	{
+		std::unique_lock<std::mutex>	lock(_mutex);
+		for (i = entries.begin(); i != entries.end(); i++) {
+			bool	queued = false;
+			std::list<entry_t>::const_iterator	j;
+			for (j = _queue.begin(); (j != _queue.end()) && !queued;
+				j++) {
+				queued = (j->tablename == i->tablename);
+			}
+			if (!queued) {
+				_stale.insert(i->tablename);
+			}
+		}
+	}
+
+	if (lost > 0) {
+		std::string	msg = stringprintf("%d of %d queued rows lost",
+			lost, entries.size());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+}
+
+/**
+ * \brief Write all queued rows
+ *
+ * The transaction mutex is acquired before the write mutex, in the same
+ * order as in pending(). If the calling thread is inside a transaction
+ * of its own, the batch becomes a nested savepoint of that transaction.
+ */
+void	BatchWriter::flush() {
+	std::unique_lock<std::recursive_mutex>	transactionlock(
+		_database->transaction_mutex());
+	std::unique_lock<std::mutex>	writelock(_write_mutex);
+	std::list<entry_t>	entries;
+	{
+		std::unique_lock<std::mutex>	lock(_mutex);
+		entries.swap(_queue);
+	}
+	write(entries);
+}
+
+/**
+ * \brief Main function of the background thread
+ */
+void	BatchWriter::run() {
+	std::unique_lock<std::mutex>	lock(_mutex);
+	while (_running) {
+		if (_queue.size() == 0) {
+			_condition.wait(lock);
+			continue;
+		}
+		std::chrono::steady_clock::time_point	deadline = _oldest
+			+ std::chrono::milliseconds(_maxdelay);
+		if ((_queue.size() < _maxrows)
+			&& (std::chrono::steady_clock::now() < deadline)) {
+			_condition.wait_until(lock, deadline);
+			continue;
+		}
+		lock.unlock();
+		try {
+			flush();
+		} catch (const std::exception& x) {
+			debug(LOG_ERR, DEBUG_LOG, 0, "cannot write batch: %s",
+				x.what());
+		}
+		lock.lock();
+	}
+}
+
+/**
+ * \brief Get the batch writer of a database, creating it if necessary
+ */
+BatchWriterPtr	BatchWriter::get(Database database) {
+	return database->writer(true);
+}
+
+/**
+ * \brief Write the queued rows of a table, if there are any
+ *
+ * This does not create a batch writer if the database has none.
+ */
+void	BatchWriter::sync(Database database, const std::string& tablename) {
+	BatchWriterPtr	writer = database->writer(false);
+	if (!writer) {
+		return;
+	}
+	if (writer->pending(tablename)) {
+		writer->flush();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// The batch writer of a backend
+//////////////////////////////////////////////////////////////////////
+/**
+ * \brief Get the batch writer of the backend
+ *
+ * \param create	whether to start a writer if the backend has none
+ */
+BatchWriterPtr	DatabaseBackend::writer(bool create) {
+	std::unique_lock<std::mutex>	lock(_writer_mutex);
+	if ((!_writer) && create) {
+		_writer = BatchWriterPtr(new BatchWriter(this));
+	}
+	return _writer;
+}
+
+/**
+ * \brief Stop the batch writer, must be called before the connection closes
+ */
+void	DatabaseBackend::stopwriter() {
+	BatchWriterPtr	writer;
+	{
+		std::unique_lock<std::mutex>	lock(_writer_mutex);
+		writer = _writer;
+		_writer.reset();
+	}
+	if (writer) {
+		writer->stop();
+	}
+}
+
+} // namespace persistence
+} // namespace astro
@@ -0,0 +1,216 @@
+/*
+ * ColumnResult.cpp -- column index, cursor and columnar query results
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroPersistence.h>
+#include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <FieldPersistence.h>
+
+namespace astro {
+namespace persistence {
+
+//////////////////////////////////////////////////////////////////////
+// ColumnIndex implementation
+//////////////////////////////////////////////////////////////////////
+ColumnIndex::ColumnIndex(const std::vector<std::string>& names) {
+	for (size_t colno = 0; colno < names.size(); colno++) {
+		// the first column of a name wins, like in Row
+		insert(std::make_pair(names[colno], (int)colno));
+	}
+}
+
+/**
+ * \brief Get the number of a column
+ */
+int	ColumnIndex::column(const std::string& name) const {
+	const_iterator	i = find(name);
+	if (i == end()) {
+		std::string	msg = stringprintf("column '%s' not found",
+			name.c_str());
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw NotFound(msg);
+	}
+	return i->second;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Cursor conversions
+//////////////////////////////////////////////////////////////////////
+/**
+ * \brief Time values are stored as strings or as unix time
+ */
+time_t	Cursor::timeValue(int colno) const {
+	if (type(colno) == string_type) {
+		return TimeField::string2time(stringValue(colno));
+	}
+	return intValue(colno);
+}
+
+struct timeval	Cursor::timevalValue(int colno) const {
+	if (type(colno) == string_type) {
+		return TimevalField::string2timeval(stringValue(colno));
+	}
+	TimevalField	field(doubleValue(colno));
+	return field.timevalValue();
+}
+
+//////////////////////////////////////////////////////////////////////
+// ColumnResult implementation
+//////////////////////////////////////////////////////////////////////
+/**
+ * \brief Append the value of the current row of the cursor
+ *
+ * The type of a column is the type of its first value that is not
+ * NULL, other values are converted to that type.
+ */
+void	ColumnResult::Column::append(const Cursor& cursor, int colno,
+		size_t row) {
+	Cursor::column_type	t = cursor.type(colno);
+	if ((type == Cursor::null_type) && (t != Cursor::null_type)) {
+		type = t;
+		switch (type) {
+		case Cursor::integer_type:
+			integers.resize(row);
+			break;
+		case Cursor::double_type:
+			doubles.resize(row);
+			break;
+		case Cursor::string_type:
+			strings.resize(row);
+			break;
+		default:
+			break;
+		}
+	}
+	nulls.push_back(t == Cursor::null_type);
+	switch (type) {
+	case Cursor::integer_type:
+		integers.push_back((t == Cursor::null_type)
+			? 0 : cursor.intValue(colno));
+		break;
+	case Cursor::double_type:
+		doubles.push_back((t == Cursor::null_type)
+			? 0. : cursor.doubleValue(colno));
+		break;
+	case Cursor::string_type:
+		strings.push_back((t == Cursor::null_type)
+			? std::string() : cursor.stringValue(colno));
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * \brief Read all remaining rows of a cursor
+ */
+ColumnResult::ColumnResult(Cursor& cursor)
+	: _index(new ColumnIndex(cursor.index())),
+	  _columns(cursor.columns()), _rows(0) {
+	while (cursor.next()) {
+		for (int colno = 0; colno < (int)_columns.size(); colno++) {
+			_columns[colno].append(cursor, colno, _rows);
+		}
+		_rows++;
+	}
+}
+
+const ColumnResult::Column&	ColumnResult::col(int colno) const {
+	if ((colno < 0) || (colno >= (int)_columns.size())) {
+		std::string	msg = stringprintf("no column %d", colno);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::range_error(msg);
+	}
+	return _columns[colno];
+}
+
+bool	ColumnResult::isnull(size_t row, int colno) const {
+	const Column&	c = col(colno);
+	return (c.type == Cursor::null_type) || c.nulls[row];
+}
+
+long	ColumnResult::intValue(size_t row, int colno) const {
+	const Column&	c = col(colno);
+	switch (c.type) {
+	case Cursor::integer_type:
+		return c.integers[row];
+	case Cursor::double_type:
+		return c.doubles[row];
+	case Cursor::string_type:
+		return std::stol(c.strings[row]);
+	default:
+		break;
+	}
+	throw std::runtime_error("cannot convert NULL to int");
+}
+
+double	ColumnResult::doubleValue(size_t row, int colno) const {
+	const Column&	c = col(colno);
+	switch (c.type) {
+	case Cursor::integer_type:
+		return c.integers[row];
+	case Cursor::double_type:
+		return c.doubles[row];
+	case Cursor::string_type:
+		return std::stod(c.strings[row]);
+	default:
+		break;
+	}
+	throw std::runtime_error("cannot convert NULL to double");
+}
+
+std::string	ColumnResult::stringValue(size_t row, int colno) const {
+	const Column&	c = col(colno);
+	switch (c.type) {
+	case Cursor::integer_type:
+		return stringprintf("%ld", c.integers[row]);
+	case Cursor::double_type:
+		return stringprintf("%f", c.doubles[row]);
+	case Cursor::string_type:
+		return c.strings[row];
+	default:
+		break;
+	}
+	throw std::runtime_error("cannot convert NULL to string");
+}
+
+time_t	ColumnResult::timeValue(size_t row, int colno) const {
+	const Column&	c = col(colno);
+	if (c.type == Cursor::string_type) {
+		return TimeField::string2time(c.strings[row]);
+	}
+	return intValue(row, colno);
+}
+
+/**
+ * \brief Direct access to the values of an integer column
+ */
+const std::vector<long>&	ColumnResult::integers(int colno) const {
+	const Column&	c = col(colno);
+	if (c.type != Cursor::integer_type) {
+		std::string	msg = stringprintf("column %d is not integer",
+			colno);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	return c.integers;
+}
+
+/**
+ * \brief Direct access to the values of a floating point column
+ */
+const std::vector<double>&	ColumnResult::doubles(int colno) const {
+	const Column&	c = col(colno);
+	if (c.type != Cursor::double_type) {
+		std::string	msg = stringprintf("column %d is not double",
+			colno);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	return c.doubles;
+}
+
+} // namespace persistence
+} // namespace astro
@@ -55,14 +55,27 @@ std::string	TableBase::selectquery() const {
 	return query;
 }
 
+/**
+ * \brief Write rows still queued in the batch writer for this table
+ *
+ * Rows queued through Table::queue only become visible in the database
+ * when the batch writer flushes them, so every method that reads from
+ * or changes the table first writes the pending rows.
+ */
+void	TableBase::sync() {
+	BatchWriter::sync(_database, _tablename);
+}
+
 /**
  * \brief Find the id for the next row to be inserted
  *
  * This method generates the id 1 if there are now rows in the table
  */
 long	TableBase::nextid() {
+	sync();
 	std::ostringstream	out;
-	out << "select case when count(*) = 0 then 1 else max(id + 1) end as 'nextid' from " << _tablename;
+	// max(id) uses the primary key index, count(*) would scan the table
+	out << "select coalesce(max(id), 0) + 1 as 'nextid' from " << _tablename;
 	Result	result = _database->query(out.str());
 	if (result.size() != 1) {
 		return 0;
@@ -81,6 +94,7 @@ long	TableBase::nextid() {
  * there are no rows in the table
  */
 long	TableBase::lastid() {
+	sync();
 	std::ostringstream	out;
 	out << "select max(id) as 'lastid' from " << _tablename;
 	Result	result = _database->query(out.str());
@@ -101,6 +115,7 @@ long	TableBase::lastid() {
  * \brief Retrieve with a given id
  */
 Row	TableBase::rowbyid(long objectid) {
+	sync();
 	std::string	sq = selectquery(); 
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "select query: %s, id = %d", sq.c_str(),
 		objectid);
@@ -119,9 +134,13 @@ Row	TableBase::rowbyid(long objectid) {
 
 /**
  * \brief Add a new row, return the id
+ *
+ * While the database has a batch writer, the id comes from its counter,
+ * so that it cannot collide with the id of a queued row.
  */
 long	TableBase::addrow(const UpdateSpec& updatespec) {
-	int	objectid = nextid();
+	BatchWriterPtr	writer = _database->writer(false);
+	long	objectid = (writer) ? writer->reserve(_tablename) : nextid();
 	std::string	query = updatespec.insertquery(_tablename);
 	StatementPtr	stmt = _database->statement(query);
 	updatespec.bind(stmt);
@@ -134,6 +153,7 @@ long	TableBase::addrow(const UpdateSpec& updatespec) {
  * \brief Update a row in the database
  */
 void	TableBase::updaterow(long objectid, const UpdateSpec& updatespec) {
+	sync();
 	std::string	query = updatespec.updatequery(_tablename);
 	StatementPtr	stmt = _database->statement(query);
 	updatespec.bind(stmt);
@@ -145,6 +165,7 @@ void	TableBase::updaterow(long objectid, const UpdateSpec& updatespec) {
  * \brief Check whether a certain id appears in the database
  */
 bool	TableBase::exists(long objectid) {
+	sync();
 	std::ostringstream	out;
 	out << "select count(*) from " << _tablename << " where id = ?";
 	StatementPtr	stmt = _database->statement(out.str());
@@ -183,6 +204,7 @@ void	TableBase::remove(const std::list<long>& objectids) {
  * /brief Remove all rows that match a condition
  */
 void	TableBase::remove(const std::string& condition) {
+	sync();
 	std::ostringstream	out;
 	out << "delete from " << _tablename << " where " << condition;
 	StatementPtr	stmt = _database->statement(out.str());
@@ -193,6 +215,7 @@ void	TableBase::remove(const std::string& condition) {
  * \brief retrieve a list of all object ids satisfying a condition
  */
 std::list<long>	TableBase::selectids(const std::string& condition) {
+	sync();
 	std::ostringstream	out;
 	out << "select id from " << _tablename << " where " << condition;
 	Result	result = _database->query(out.str());
@@ -210,6 +233,17 @@ std::list<long>	TableBase::selectids(const std::string& condition) {
  * \brief Retrieve with a given id
  */
 Result	TableBase::selectrows(const std::string& condition) {
+	StatementPtr	stmt = selectstatement(condition);
+	Result	result = stmt->result();
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "result has %d rows", result.size());
+	return result;
+}
+
+/**
+ * \brief Build the statement selecting the id and all fields of rows
+ */
+StatementPtr	TableBase::selectstatement(const std::string& condition) {
+	sync();
 	std::ostringstream	out;
 	out << "select id, ";
 	out << std::for_each(_fieldnames.begin(), _fieldnames.end(),
@@ -218,8 +252,16 @@ Result	TableBase::selectrows(const std::string& condition) {
 	out << " where " << condition;
 	std::string	query = out.str();
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "select query: %s", query.c_str());
-	StatementPtr	stmt = _database->statement(query);
-	Result	result = stmt->result();
+	return _database->statement(query);
+}
+
+/**
+ * \brief Retrieve the rows satisfying a condition in columnar form
+ */
+ColumnResult	TableBase::selectcolumns(const std::string& condition) {
+	StatementPtr	stmt = selectstatement(condition);
+	CursorPtr	cursor = stmt->cursor();
+	ColumnResult	result(*cursor);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "result has %d rows", result.size());
 	return result;
 }
@@ -228,6 +270,7 @@ Result	TableBase::selectrows(const std::string& condition) {
  * \brief Find the record id the satisfies some uniqueness constraint
  */
 long	TableBase::id(const std::string& condition) {
+	sync();
 	std::ostringstream	out;
 	out << "select id from " << _tablename << " where " << condition;
 	Result	result = _database->query(out.str());
@@ -259,6 +302,7 @@ long	TableBase::count() {
  * \brief Count rows that satisfy a condition
  */
 long	TableBase::count(const std::string& condition) {
+	sync();
 	std::ostringstream	out;
 	out << "select count(*) from " << _tablename << " where " << condition;
 	Result	result = _database->query(out.str());
@@ -0,0 +1,176 @@
+/*
+ * BatchWriterTest.cpp -- tests for the batch writer
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroUtils.h>
+#include <AstroDebug.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <AstroPersistence.h>
+#include "../Testtable.h"
+
+using namespace astro::persistence;
+
+namespace astro {
+namespace test {
+
+class BatchWriterTest : public CppUnit::TestFixture {
+public:
+	void	setUp() { }
+	void	tearDown() { }
+	void	testQueue();
+	void	testMixed();
+	void	testBenchmark();
+	void	testTransaction();
+	void	testLifetime();
+
+	CPPUNIT_TEST_SUITE(BatchWriterTest);
+	CPPUNIT_TEST(testQueue);
+	CPPUNIT_TEST(testMixed);
+	CPPUNIT_TEST(testBenchmark);
+	CPPUNIT_TEST(testTransaction);
+	CPPUNIT_TEST(testLifetime);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BatchWriterTest);
+
+static TestRecord	testentry(int i) {
+	TestRecord	entry(0);
+	entry.intfield(i);
+	entry.doublefield(i / 10.);
+	entry.stringfield("batch");
+	entry.timefield(time(NULL));
+	return entry;
+}
+
+/**
+ * \brief Queued rows get consecutive ids and are visible to queries
+ */
+void	BatchWriterTest::testQueue() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testQueue() begin");
+	DatabaseFactory	dbf;
+	Database	database = dbf.get("batchtest.db");
+	Table<TestRecord, TesttableAdapter>	table(database);
+	table.remove("0 = 0");
+	long	first = table.queue(testentry(0));
+	for (int i = 1; i < 250; i++) {
+		long	id = table.queue(testentry(i));
+		CPPUNIT_ASSERT(id == first + i);
+	}
+	CPPUNIT_ASSERT(table.count() == 250);
+	TestRecord	entry = table.byid(first + 17);
+	CPPUNIT_ASSERT(entry.intfield() == 17);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testQueue() end");
+}
+
+/**
+ * \brief Rows added directly and queued rows don't conflict
+ */
+void	BatchWriterTest::testMixed() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testMixed() begin");
+	DatabaseFactory	dbf;
+	Database	database = dbf.get("batchtest.db");
+	Table<TestRecord, TesttableAdapter>	table(database);
+	table.remove("0 = 0");
+	long	id1 = table.queue(testentry(1));
+	long	id2 = table.add(testentry(2));
+	long	id3 = table.queue(testentry(3));
+	CPPUNIT_ASSERT(id1 != id2);
+	CPPUNIT_ASSERT(id2 != id3);
+	CPPUNIT_ASSERT(table.byid(id1).intfield() == 1);
+	CPPUNIT_ASSERT(table.byid(id2).intfield() == 2);
+	CPPUNIT_ASSERT(table.byid(id3).intfield() == 3);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testMixed() end");
+}
+
+/**
+ * \brief Compare the insert rate of add and queue
+ */
+void	BatchWriterTest::testBenchmark() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBenchmark() begin");
+	DatabaseFactory	dbf;
+	Database	database = dbf.get("batchtest.db");
+	Table<TestRecord, TesttableAdapter>	table(database);
+	table.remove("0 = 0");
+	int	n = 500;
+
+	Timer	timer;
+	timer.start();
+	for (int i = 0; i < n; i++) {
+		table.add(testentry(i));
+	}
+	timer.end();
+	double	addtime = timer.elapsed();
+
+	timer.start();
+	for (int i = 0; i < n; i++) {
+		table.queue(testentry(i));
+	}
+	BatchWriter::get(database)->flush();
+	timer.end();
+	double	queuetime = timer.elapsed();
+
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%d rows: add %.3fs (%.0f rows/s), "
+		"queue %.3fs (%.0f rows/s)", n, addtime, n / addtime,
+		queuetime, n / queuetime);
+	CPPUNIT_ASSERT(table.count() == 2 * n);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBenchmark() end");
+}
+
+/**
+ * \brief Batches don't become part of a transaction of another thread
+ *
+ * The main thread rolls back a transaction while another thread queues
+ * rows, none of the queued rows may be lost by the rollback.
+ */
+void	BatchWriterTest::testTransaction() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testTransaction() begin");
+	DatabaseFactory	dbf;
+	Database	database = dbf.get("batchtest.db");
+	Table<TestRecord, TesttableAdapter>	table(database);
+	table.remove("0 = 0");
+	std::thread	queuer([&table]() {
+		for (int i = 0; i < 200; i++) {
+			table.queue(testentry(i));
+			std::this_thread::sleep_for(
+				std::chrono::milliseconds(1));
+		}
+	});
+	for (int i = 0; i < 20; i++) {
+		database->begin();
+		table.add(testentry(1000 + i));
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		database->rollback();
+	}
+	queuer.join();
+	BatchWriter::get(database)->flush();
+	CPPUNIT_ASSERT(table.count() == 200);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testTransaction() end");
+}
+
+/**
+ * \brief Queued rows are written when the database is closed
+ */
+void	BatchWriterTest::testLifetime() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testLifetime() begin");
+	DatabaseFactory	dbf;
+	{
+		Database	database = dbf.get("batchtest.db");
+		Table<TestRecord, TesttableAdapter>	table(database);
+		table.remove("0 = 0");
+		for (int i = 0; i < 10; i++) {
+			table.queue(testentry(i));
+		}
+	}
+	Database	database = dbf.get("batchtest.db");
+	CPPUNIT_ASSERT(!database->writer(false));
+	Table<TestRecord, TesttableAdapter>	table(database);
+	CPPUNIT_ASSERT(table.count() == 10);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testLifetime() end");
+}
+
+} // namespace test
+} // namespace astro
@@ -0,0 +1,203 @@
+/*
+ * CursorTest.cpp -- tests for cursors and columnar results
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroUtils.h>
+#include <AstroDebug.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <AstroPersistence.h>
+#include "../Testtable.h"
+#include <cmath>
+
+using namespace astro::persistence;
+
+namespace astro {
+namespace test {
+
+class CursorTest : public CppUnit::TestFixture {
+	static void	fill(int n);
+public:
+	void	setUp() { }
+	void	tearDown() { }
+	void	testCursor();
+	void	testColumns();
+	void	testCollector();
+	void	testBenchmark();
+
+	CPPUNIT_TEST_SUITE(CursorTest);
+	CPPUNIT_TEST(testCursor);
+	CPPUNIT_TEST(testColumns);
+	CPPUNIT_TEST(testCollector);
+	CPPUNIT_TEST(testBenchmark);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CursorTest);
+
+/**
+ * \brief Fill the test table with n rows
+ */
+void	CursorTest::fill(int n) {
+	DatabaseFactory	dbf;
+	Database	database = dbf.get("cursortest.db");
+	Table<TestRecord, TesttableAdapter>	table(database);
+	table.remove("0 = 0");
+	for (int i = 0; i < n; i++) {
+		TestRecord	entry(0);
+		entry.intfield(i);
+		entry.doublefield(i / 4.);
+		entry.stringfield(stringprintf("row %d", i));
+		entry.timefield(1500000000 + i);
+		table.queue(entry);
+	}
+	BatchWriter::get(database)->flush();
+}
+
+/**
+ * \brief Visitor summing the int and float fields
+ */
+class SumVisitor {
+	int	_intfield;
+	int	_floatfield;
+public:
+	double	sum;
+	long	rows;
+	SumVisitor() : _intfield(-1), _floatfield(-1), sum(0), rows(0) { }
+	void	operator()(const Cursor& cursor) {
+		if (_intfield < 0) {
+			_intfield = cursor.column("intfield");
+			_floatfield = cursor.column("floatfield");
+		}
+		sum += cursor.intValue(_intfield)
+			+ cursor.doubleValue(_floatfield);
+		rows++;
+	}
+};
+
+void	CursorTest::testCursor() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testCursor() begin");
+	fill(100);
+	DatabaseFactory	dbf;
+	Database	database = dbf.get("cursortest.db");
+	Table<TestRecord, TesttableAdapter>	table(database);
+	SumVisitor	visitor;
+	long	n = table.select("intfield < 10", visitor);
+	CPPUNIT_ASSERT(n == 10);
+	CPPUNIT_ASSERT(visitor.rows == 10);
+	CPPUNIT_ASSERT(fabs(visitor.sum - 45 * 1.25) < 1e-9);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testCursor() end");
+}
+
+void	CursorTest::testColumns() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testColumns() begin");
+	fill(100);
+	DatabaseFactory	dbf;
+	Database	database = dbf.get("cursortest.db");
+	Table<TestRecord, TesttableAdapter>	table(database);
+	ColumnResult	columns = table.selectcolumns("0 = 0 order by intfield");
+	CPPUNIT_ASSERT(columns.size() == 100);
+	int	intfield = columns.column("intfield");
+	int	floatfield = columns.column("floatfield");
+	int	stringfield = columns.column("stringfield");
+	CPPUNIT_ASSERT(columns.type(intfield) == Cursor::integer_type);
+	const std::vector<double>&	f = columns.doubles(floatfield);
+	for (size_t row = 0; row < columns.size(); row++) {
+		CPPUNIT_ASSERT(columns.intValue(row, intfield) == (int)row);
+		CPPUNIT_ASSERT(f[row] == row / 4.);
+	}
+	CPPUNIT_ASSERT(columns.stringValue(17, stringfield) == "row 17");
+	// hashed access by name through rows must agree with the columns
+	Result	rows = table.selectrows("intfield = 17");
+	CPPUNIT_ASSERT(rows.size() == 1);
+	CPPUNIT_ASSERT(rows.front()["stringfield"]->stringValue() == "row 17");
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testColumns() end");
+}
+
+/**
+ * \brief Adapter reading the string field and a 64 bit value from a row
+ */
+class StringAdapter {
+public:
+	template<typename row_type>
+	static std::pair<long, std::string>	row_to_object(int objectid,
+			const row_type& row) {
+		return std::make_pair(row["intfield"]->intValue() << 32,
+			row["stringfield"]->stringValue());
+	}
+};
+
+void	CursorTest::testCollector() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testCollector() begin");
+	fill(10);
+	DatabaseFactory	dbf;
+	Database	database = dbf.get("cursortest.db");
+	Table<TestRecord, TesttableAdapter>	table(database);
+	ObjectCollector<std::pair<long, std::string>, StringAdapter>	collector;
+	table.select("intfield < 3 order by intfield", collector);
+	CPPUNIT_ASSERT(collector.objects.size() == 3);
+	CPPUNIT_ASSERT(collector.objects.back().second == "row 2");
+	CPPUNIT_ASSERT(collector.objects.back().first == (2L << 32));
+	// integers beyond 32 bits survive the cursor
+	StatementPtr	stmt = database->statement(
+		"select 3 * 4294967296 as value");
+	CursorPtr	cursor = stmt->cursor();
+	CPPUNIT_ASSERT(cursor->next());
+	CPPUNIT_ASSERT(cursor->intValue(0) == 3 * 4294967296L);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testCollector() end");
+}
+
+/**
+ * \brief Compare rows, cursor and columns for a large table
+ */
+void	CursorTest::testBenchmark() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBenchmark() begin");
+	int	n = 100000;
+	fill(n);
+	DatabaseFactory	dbf;
+	Database	database = dbf.get("cursortest.db");
+	Table<TestRecord, TesttableAdapter>	table(database);
+
+	Timer	timer;
+	timer.start();
+	Result	rows = table.selectrows("0 = 0");
+	double	rowsum = 0;
+	Result::const_iterator	r;
+	for (r = rows.begin(); r != rows.end(); r++) {
+		rowsum += (*r)["intfield"]->intValue()
+			+ (*r)["floatfield"]->doubleValue();
+	}
+	timer.end();
+	double	rowtime = timer.elapsed();
+
+	timer.start();
+	SumVisitor	visitor;
+	table.select("0 = 0", visitor);
+	timer.end();
+	double	cursortime = timer.elapsed();
+
+	timer.start();
+	ColumnResult	columns = table.selectcolumns("0 = 0");
+	const std::vector<long>&	i
+		= columns.integers(columns.column("intfield"));
+	const std::vector<double>&	f
+		= columns.doubles(columns.column("floatfield"));
+	double	columnsum = 0;
+	for (size_t row = 0; row < columns.size(); row++) {
+		columnsum += i[row] + f[row];
+	}
+	timer.end();
+	double	columntime = timer.elapsed();
+
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "%d rows: rows %.3fs, cursor %.3fs "
+		"(%.1fx), columns %.3fs (%.1fx)", n, rowtime, cursortime,
+		rowtime / cursortime, columntime, rowtime / columntime);
+	CPPUNIT_ASSERT(fabs(rowsum - visitor.sum) < 1e-6);
+	CPPUNIT_ASSERT(fabs(rowsum - columnsum) < 1e-6);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testBenchmark() end");
+}
+
+} // namespace test
+} // namespace astro
@@ -30,6 +30,8 @@ ImageCalibrationStep::ImageCalibrationStep(NodePaths& parent)
 	_interpolate = true;
 	_demosaic = false;
 	_flip = false;
+	_hflip = false;
+	_binning = 1;
 }
 
 /**
@@ -39,11 +41,8 @@ ProcessingStep::state	ImageCalibrationStep::do_work() {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "start work in calibration");
 	int	darkid = -1;
 	int	flatid = -1;
-
-	astro::camera::Imager	imager;
-
-	// set interpolation step width
-	imager.interpolation(_interpolation);
+	ImagePtr	darkimage;
+	ImagePtr	flatimage;
 
 	// check for the dark image
 	if (_dark) {
@@ -52,9 +51,7 @@ ProcessingStep::state	ImageCalibrationStep::do_work() {
 			darkid);
 		ImageStep	*imagestep = dynamic_cast<ImageStep*>(&*_dark);
 		if (imagestep) {
-			ImagePtr	darkimage = imagestep->image();
-			imager.dark(darkimage);
-			imager.darksubtract(true);
+			darkimage = imagestep->image();
 			debug(LOG_DEBUG, DEBUG_LOG, 0, "found %s dark image",
 				darkimage->size().toString().c_str());
 		} else {
@@ -69,9 +66,7 @@ ProcessingStep::state	ImageCalibrationStep::do_work() {
 			flatid);
 		ImageStep	*imagestep = dynamic_cast<ImageStep*>(&*_flat);
 		if (imagestep) {
-			ImagePtr	flatimage = imagestep->image();
-			imager.flat(flatimage);
-			imager.flatdivide(true);
+			flatimage = imagestep->image();
 			debug(LOG_DEBUG, DEBUG_LOG, 0, "found %s flat image",
 				flatimage->size().toString().c_str());
 		} else {
@@ -98,17 +93,23 @@ ProcessingStep::state	ImageCalibrationStep::do_work() {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "no precursor image");
 		return ProcessingStep::failed;
 	}
-	_image = astro::image::ops::duplicate(imagestep->image());
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "precursor image duplicate: %s, %s",
+	ImagePtr	rawimage = imagestep->image();
+
+	// dark, flat, interpolation and binning in a single pass, the
+	// kernel works in place unless it bins the image
+	astro::calibration::CalibrationKernel	kernel(darkimage, flatimage,
+		rawimage->getFrame());
+	kernel.interpolate((_interpolate) || (_interpolation != 0));
+	kernel.binning(_binning);
+	if (_binning > 1) {
+		_image = kernel(rawimage);
+	} else {
+		_image = kernel(astro::image::ops::duplicate(rawimage));
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "calibrated image: %s, %s",
 		_image->size().toString().c_str(),
 		demangle_string(_image->pixel_type()).c_str());
 
-	// perform interpolation
-	imager.interpolate(_interpolate);
-
-	// perform processing
-	imager(_image);
-
 	// perform debayering
 	if (_demosaic) {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "demosaicing");
@@ -172,6 +173,9 @@ std::string	ImageCalibrationStep::what() const {
 		out << "no flat, ";
 	}
 	out << ((!_interpolate) ? "don't " : "") << "interpolate, ";
+	if (_binning > 1) {
+		out << "binning " << _binning << ", ";
+	}
 	out << ((!_demosaic) ? "don't " : "") << "demosaic, ";
 	out << ((!_flip) ? "don't " : "") << "flip";
 	return out.str();
@@ -10,6 +10,8 @@
 #include <algorithm>
 #include <includes.h>
 #include <AstroDebug.h>
+#include <AstroFormat.h>
+#include <AstroIO.h>
 #include <algorithm>
 
 using namespace astro::adapter;
@@ -71,6 +73,100 @@ ImagePtr	ImageStep::precursorimage(std::vector<int> exclude) const {
 	return precursorimage;
 }
 
+/**
+ * \brief Remove the spill file when the step goes away
+ */
+ImageStep::~ImageStep() {
+	if (_spillfile.size() > 0) {
+		unlink(_spillfile.c_str());
+	}
+}
+
+/**
+ * \brief Get the image of the step
+ *
+ * A spilled image is read back from its file each time, it is not kept
+ * in memory, because it was spilled to stay within the memory limit.
+ * The file is read without holding the image lock, so that a slow read
+ * does not block the memory accounting of the processor network.
+ */
+ImagePtr	ImageStep::image() {
+	std::string	spillfile;
+	{
+		std::unique_lock<std::mutex>	lock(_imagemutex);
+		if ((_image) || (_spillfile.size() == 0)) {
+			return _image;
+		}
+		spillfile = _spillfile;
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "reading spilled image %s",
+		spillfile.c_str());
+	io::FITSin	in(spillfile);
+	return in.read();
+}
+
+/**
+ * \brief Number of pixel bytes this step keeps in memory
+ */
+size_t	ImageStep::imagebytes() {
+	std::unique_lock<std::mutex>	lock(_imagemutex);
+	if (!_image) {
+		return 0;
+	}
+	return _image->size().getPixels() * _image->bytesPerPixel();
+}
+
+/**
+ * \brief Forget the image, no step needs it any more
+ */
+void	ImageStep::release() {
+	std::unique_lock<std::mutex>	lock(_imagemutex);
+	_image.reset();
+	if (_spillfile.size() > 0) {
+		unlink(_spillfile.c_str());
+		_spillfile = std::string();
+	}
+}
+
+/**
+ * \brief Write the image to a file in a directory and free the memory
+ *
+ * The file is written without holding the image lock, only the pointers
+ * are exchanged under the lock. If the image changed in the meantime,
+ * the file is discarded.
+ *
+ * \return	whether any memory was freed
+ */
+bool	ImageStep::spill(const std::string& directory) {
+	ImagePtr	image;
+	{
+		std::unique_lock<std::mutex>	lock(_imagemutex);
+		if (!_image) {
+			return false;
+		}
+		image = _image;
+	}
+	std::string	filename = stringprintf("%s/step-%d.fits",
+		directory.c_str(), id());
+	{
+		io::FITSout	out(filename);
+		out.setPrecious(false);
+		out.write(image);
+	}
+	std::unique_lock<std::mutex>	lock(_imagemutex);
+	if (_image != image) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "image of step %d changed "
+			"while spilling", id());
+		unlink(filename.c_str());
+		return false;
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "image of step %d spilled to %s",
+		id(), filename.c_str());
+	_spillfile = filename;
+	_image.reset();
+	return true;
+}
+
 class inconsistent_size : public std::exception {
 };
 
@@ -93,6 +93,11 @@ void	ProcessorParser::startCalibrate(const attr_t& attrs) {
 		}
 	}
 
+	i = attrs.find(std::string("binning"));
+	if (i != attrs.end()) {
+		cal->binning(std::stoi(i->second));
+	}
+
 	startCommon(attrs);
 	if (cal->dark()) {
 		step->add_precursor(cal->dark());
@@ -0,0 +1,44 @@
+/*
+ * ParseSolveStep.cpp
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <includes.h>
+#include <AstroProcess.h>
+#include "ProcessorParser.h"
+
+namespace astro {
+namespace process {
+
+void	ProcessorParser::startSolve(const attr_t& attrs) {
+	// create the solving step
+	SolveStep	*s = new SolveStep(nodePaths());
+	ProcessingStepPtr	step(s);
+
+	// remember everyhwere
+	push(step);
+
+	// parse attributes
+	attr_t::const_iterator	i;
+	if (attrs.end() == (i = attrs.find("index"))) {
+		std::string	msg("solve step needs an index attribute");
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	s->index(i->second);
+	if (attrs.end() != (i = attrs.find("minscale"))) {
+		s->minscale(std::stod(i->second));
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "set minscale to %f",
+			s->minscale());
+	}
+	if (attrs.end() != (i = attrs.find("maxscale"))) {
+		s->maxscale(std::stod(i->second));
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "set maxscale to %f",
+			s->maxscale());
+	}
+
+	startCommon(attrs);
+}
+
+} // namespace process
+} // namespace astro
@@ -94,6 +94,24 @@ void	ProcessorParser::startStack(const attr_t& attrs) {
 		}
 	}
 
+	if (attrs.end() != (i = attrs.find("method"))) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "set stacking method to %s",
+			i->second.c_str());
+		ss->method(astro::image::stacking::Stacker::string2method(
+			i->second));
+	}
+	if (attrs.end() != (i = attrs.find("kappa"))) {
+		double	kappa = std::stod(i->second);
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "set kappa to %f", kappa);
+		ss->kappa(kappa);
+	}
+	if (attrs.end() != (i = attrs.find("iterations"))) {
+		int	iterations = std::stoi(i->second);
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "set iterations to %d",
+			iterations);
+		ss->iterations(iterations);
+	}
+
 	startCommon(attrs);
 
 	if (ss->baseimage()) {
@@ -9,6 +9,11 @@
 #include <AstroFormat.h>
 #include <AstroExceptions.h>
 #include <AstroUtils.h>
+#include <AstroIO.h>
+#include <includes.h>
+#include <condition_variable>
+#include <deque>
+#include <set>
 
 namespace astro {
 namespace process {
@@ -18,9 +23,24 @@ namespace process {
  */
 ProcessorNetwork::ProcessorNetwork() {
 	_maxthreads = 1;
+	_memorylimit = 0;
+	_start = 0;
+	_end = 0;
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "create a new processor network");
 }
 
+/**
+ * \brief Set the number of steps that may run at the same time
+ */
+void	ProcessorNetwork::maxthreads(int m) {
+	if (m < 1) {
+		std::string	msg = stringprintf("bad number of threads %d", m);
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	_maxthreads = m;
+}
+
 /**
  * \brief Add a processing step to a network
  *
@@ -197,11 +217,436 @@ int	ProcessorNetwork::process(const ProcessingStep::steps& steps) {
 	return -1;
 }
 
+/**
+ * \brief State of the scheduler while a network is processed
+ *
+ * Each worker has its own queue. Successors made ready by a step are
+ * queued at the front of the queue of the worker that ran the step, so
+ * the worker continues with images that were just computed, an idle
+ * worker steals the oldest entry from the back of another queue. Steps
+ * take seconds to minutes, so a single lock for all queues suffices.
+ *
+ * The memory accounting only uses byte counts recorded in the scheduler,
+ * so the scheduler lock is never held while waiting for the image lock
+ * of a step, which may be held during a slow spill or read.
+ */
+class NetworkScheduler {
+public:
+	typedef std::map<int, ProcessingStep::steps>	graph_t;
+	graph_t	successors;
+	graph_t	precursors;
+	std::set<int>	relevant;
+	std::map<int, ProcessorNetwork::steptiming_t>	timings;
+private:
+	size_t	_memorylimit;
+	std::mutex	_mutex;
+	std::condition_variable	_condition;
+	std::vector<std::deque<int> >	_queues;
+	std::set<int>	_scheduled;
+	std::set<int>	_finished;
+	int	_running;
+	// expected image size of each step, bytes held by finished steps,
+	// and bytes reserved for the steps currently running
+	std::map<int, size_t>	_sizes;
+	std::map<int, size_t>	_resident;
+	std::map<int, size_t>	_reserved;
+	std::mutex	_spoolmutex;
+	std::string	_spooldirectory;
+	static ImageStep	*imagestep(int id);
+	bool	needed(int id);
+	size_t	held();
+	size_t	estimate(int id);
+	size_t	presize(int id);
+	bool	next(int worker, int& id);
+	void	execute(int id);
+	void	managememory();
+	std::string	spooldirectory();
+	void	work(int worker);
+public:
+	NetworkScheduler(int threads, size_t memorylimit);
+	~NetworkScheduler();
+	bool	executed(int id);
+	void	schedule(int worker, int id);
+	void	presize();
+	void	run();
+	void	releaseall();
+};
+
+NetworkScheduler::NetworkScheduler(int threads, size_t memorylimit)
+	: _memorylimit(memorylimit), _queues(threads), _running(0) {
+}
+
+/**
+ * \brief Remove the spool directory, the spill files are gone by now
+ */
+NetworkScheduler::~NetworkScheduler() {
+	if (_spooldirectory.size() > 0) {
+		rmdir(_spooldirectory.c_str());
+	}
+}
+
+ImageStep	*NetworkScheduler::imagestep(int id) {
+	return dynamic_cast<ImageStep *>(&*ProcessingStep::byid(id));
+}
+
+bool	NetworkScheduler::executed(int id) {
+	std::unique_lock<std::mutex>	lock(_mutex);
+	return _scheduled.find(id) != _scheduled.end();
+}
+
+/**
+ * \brief Find out whether a step that has not run yet needs an image
+ *
+ * Steps like the gamma step compute their image only when asked for it,
+ * so their own image is empty, and the image of the precursor is needed
+ * as long as their successors need them. The caller must hold the lock.
+ */
+bool	NetworkScheduler::needed(int id) {
+	const ProcessingStep::steps&	s = successors[id];
+	for (auto i = s.begin(); i != s.end(); i++) {
+		if (relevant.find(*i) == relevant.end()) {
+			continue;
+		}
+		if (_finished.find(*i) == _finished.end()) {
+			return true;
+		}
+		ImageStep	*step = imagestep(*i);
+		if ((NULL != step) && (step->ondemand()) && needed(*i)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * \brief Memory held by finished steps and reserved for running steps
+ *
+ * The caller must hold the lock.
+ */
+size_t	NetworkScheduler::held() {
+	size_t	result = 0;
+	for (auto i = _resident.begin(); i != _resident.end(); i++) {
+		result += i->second;
+	}
+	for (auto i = _reserved.begin(); i != _reserved.end(); i++) {
+		result += i->second;
+	}
+	return result;
+}
+
+/**
+ * \brief Estimate the memory a step needs for its result
+ *
+ * Most steps produce an image of the size of their largest input, the
+ * sizes of inputs computed in this run are known by now. Steps computing
+ * their image on demand do not keep an image. The caller must hold the
+ * lock.
+ */
+size_t	NetworkScheduler::estimate(int id) {
+	ImageStep	*step = imagestep(id);
+	if ((NULL == step) || (step->ondemand())) {
+		return 0;
+	}
+	auto	i = _sizes.find(id);
+	size_t	result = (i != _sizes.end()) ? i->second : 0;
+	const ProcessingStep::steps&	p = precursors[id];
+	for (auto j = p.begin(); j != p.end(); j++) {
+		auto	k = _sizes.find(*j);
+		if (k != _sizes.end()) {
+			result = std::max(result, k->second);
+		}
+	}
+	return result;
+}
+
+/**
+ * \brief Find the expected size of the image of a step
+ *
+ * The size of a file is taken from its FITS header, without reading
+ * the pixels. Steps that already have an image use its size, all other
+ * steps are assumed to produce an image of the size of their largest
+ * input. This must not be called while workers are running.
+ */
+size_t	NetworkScheduler::presize(int id) {
+	auto	i = _sizes.find(id);
+	if (i != _sizes.end()) {
+		return i->second;
+	}
+	size_t	result = 0;
+	ProcessingStepPtr	step = ProcessingStep::byid(id);
+	FileImageStep	*file = dynamic_cast<FileImageStep *>(&*step);
+	if (NULL != file) {
+		try {
+			io::FITSheaderPtr	header
+				= io::FITSheaderCache::get(file->fullname());
+			result = header->getSize().getPixels()
+				* header->getBytesPerPixel();
+		} catch (const std::exception& x) {
+			debug(LOG_DEBUG, DEBUG_LOG, 0, "no header for step %d: %s",
+				id, x.what());
+		}
+	}
+	ImageStep	*image = dynamic_cast<ImageStep *>(&*step);
+	if ((0 == result) && (NULL != image) && (!image->ondemand())) {
+		result = image->imagebytes();
+	}
+	if (0 == result) {
+		const ProcessingStep::steps&	p = step->precursors();
+		for (auto j = p.begin(); j != p.end(); j++) {
+			result = std::max(result, presize(*j));
+		}
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "step %d expected size %lu", id,
+		result);
+	_sizes[id] = result;
+	return result;
+}
+
+/**
+ * \brief Find the expected image sizes of all relevant steps
+ */
+void	NetworkScheduler::presize() {
+	for (auto i = relevant.begin(); i != relevant.end(); i++) {
+		presize(*i);
+	}
+}
+
+/**
+ * \brief Queue a step that is ready to run, the caller holds the lock
+ */
+void	NetworkScheduler::schedule(int worker, int id) {
+	if (_scheduled.find(id) != _scheduled.end()) {
+		return;
+	}
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "worker %d: step %d ready", worker, id);
+	_scheduled.insert(id);
+	_queues[worker % _queues.size()].push_front(id);
+}
+
+/**
+ * \brief Get the next step for a worker, the caller must hold the lock
+ *
+ * If a memory limit is set, a step is only started if its result will
+ * fit, unless nothing is running, in which case waiting would not free
+ * any memory.
+ */
+bool	NetworkScheduler::next(int worker, int& id) {
+	int	n = _queues.size();
+	for (int k = 0; k < n; k++) {
+		std::deque<int>&	queue = _queues[(worker + k) % n];
+		if (queue.size() == 0) {
+			continue;
+		}
+		int	candidate = (k == 0) ? queue.front() : queue.back();
+		if ((_memorylimit > 0) && (_running > 0)
+			&& (held() + estimate(candidate) > _memorylimit)) {
+			debug(LOG_DEBUG, DEBUG_LOG, 0, "step %d must wait for "
+				"memory", candidate);
+			return false;
+		}
+		if (k == 0) {
+			queue.pop_front();
+		} else {
+			debug(LOG_DEBUG, DEBUG_LOG, 0, "worker %d steals step %d",
+				worker, candidate);
+			queue.pop_back();
+		}
+		_reserved[candidate] = estimate(candidate);
+		id = candidate;
+		return true;
+	}
+	return false;
+}
+
+/**
+ * \brief Run a step and record its timing and the memory it holds
+ */
+void	NetworkScheduler::execute(int id) {
+	ProcessingStepPtr	step = ProcessingStep::byid(id);
+	ProcessorNetwork::steptiming_t	timing;
+	timing.start = Timer::gettime();
+	step->work();
+	timing.end = Timer::gettime();
+	timing.result = step->status();
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "step %d '%s' %s after %.3fs", id,
+		step->name().c_str(),
+		ProcessingStep::statename(timing.result).c_str(),
+		timing.end - timing.start);
+	ImageStep	*image = imagestep(id);
+	size_t	bytes = (NULL != image) ? image->imagebytes() : 0;
+	std::unique_lock<std::mutex>	lock(_mutex);
+	timings[id] = timing;
+	_reserved.erase(id);
+	if (bytes > 0) {
+		_sizes[id] = bytes;
+		_resident[id] = bytes;
+	}
+}
+
+/**
+ * \brief Create the directory for spilled images when it is first needed
+ */
+std::string	NetworkScheduler::spooldirectory() {
+	std::unique_lock<std::mutex>	lock(_spoolmutex);
+	if (_spooldirectory.size() > 0) {
+		return _spooldirectory;
+	}
+	const char	*tmpdir = getenv("TMPDIR");
+	std::string	templ = stringprintf("%s/astroprocess-XXXXXX",
+		(tmpdir) ? tmpdir : "/tmp");
+	std::vector<char>	buffer(templ.begin(), templ.end());
+	buffer.push_back('\0');
+	if (NULL == mkdtemp(buffer.data())) {
+		std::string	msg = stringprintf("cannot create spool "
+			"directory %s: %s", templ.c_str(), strerror(errno));
+		debug(LOG_ERR, DEBUG_LOG, 0, "%s", msg.c_str());
+		throw std::runtime_error(msg);
+	}
+	_spooldirectory = std::string(buffer.data());
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "spilling images to %s",
+		_spooldirectory.c_str());
+	return _spooldirectory;
+}
+
+/**
+ * \brief Release images no longer needed, spill images over the limit
+ *
+ * Images of terminal steps are the results of the network, they are
+ * never released.
+ */
+void	NetworkScheduler::managememory() {
+	typedef std::pair<size_t, ImageStep *>	candidate_t;
+	std::list<candidate_t>	releasable;
+	std::list<candidate_t>	spillable;
+	size_t	bytes;
+	{
+		std::unique_lock<std::mutex>	lock(_mutex);
+		for (auto i = _finished.begin(); i != _finished.end(); i++) {
+			ImageStep	*step = imagestep(*i);
+			if ((NULL == step) || (successors[*i].size() == 0)) {
+				continue;
+			}
+			auto	r = _resident.find(*i);
+			size_t	b = (r != _resident.end()) ? r->second : 0;
+			if (needed(*i)) {
+				if (b > 0) {
+					spillable.push_back(std::make_pair(b, step));
+				}
+			} else {
+				releasable.push_back(std::make_pair(b, step));
+			}
+		}
+		bytes = held();
+	}
+	for (auto i = releasable.begin(); i != releasable.end(); i++) {
+		if (i->first > 0) {
+			debug(LOG_DEBUG, DEBUG_LOG, 0, "release image of step %d",
+				i->second->id());
+		}
+		i->second->release();
+		std::unique_lock<std::mutex>	lock(_mutex);
+		_resident.erase(i->second->id());
+		bytes -= std::min(bytes, i->first);
+	}
+	if ((_memorylimit == 0) || (bytes <= _memorylimit)) {
+		return;
+	}
+	// spill the largest images first
+	spillable.sort([](const candidate_t& a, const candidate_t& b) -> bool {
+			return a.first > b.first;
+		});
+	for (auto i = spillable.begin();
+		(i != spillable.end()) && (bytes > _memorylimit); i++) {
+		try {
+			if (i->second->spill(spooldirectory())) {
+				std::unique_lock<std::mutex>	lock(_mutex);
+				_resident.erase(i->second->id());
+				bytes -= std::min(bytes, i->first);
+			}
+		} catch (const std::exception& x) {
+			debug(LOG_ERR, DEBUG_LOG, 0, "cannot spill step %d: %s",
+				i->second->id(), x.what());
+			return;
+		}
+	}
+}
+
+/**
+ * \brief Main function of a worker thread
+ */
+void	NetworkScheduler::work(int worker) {
+	std::unique_lock<std::mutex>	lock(_mutex);
+	while (true) {
+		int	id;
+		if (next(worker, id)) {
+			_running++;
+			lock.unlock();
+			execute(id);
+			lock.lock();
+			_running--;
+			_finished.insert(id);
+			// queue the successors that have become ready
+			const ProcessingStep::steps&	s = successors[id];
+			for (auto i = s.begin(); i != s.end(); i++) {
+				if ((relevant.find(*i) != relevant.end())
+					&& (ProcessingStep::needswork
+					== ProcessingStep::byid(*i)->status())) {
+					schedule(worker, *i);
+				}
+			}
+			lock.unlock();
+			managememory();
+			lock.lock();
+			_condition.notify_all();
+			continue;
+		}
+		bool	empty = std::all_of(_queues.begin(), _queues.end(),
+			[](const std::deque<int>& q) { return q.size() == 0; });
+		if (empty && (_running == 0)) {
+			_condition.notify_all();
+			return;
+		}
+		_condition.wait(lock);
+	}
+}
+
+/**
+ * \brief Run all scheduled steps and the steps they make ready
+ */
+void	NetworkScheduler::run() {
+	std::vector<std::thread>	threads;
+	for (size_t worker = 0; worker < _queues.size(); worker++) {
+		threads.push_back(std::thread(&NetworkScheduler::work, this,
+			(int)worker));
+	}
+	for (auto t = threads.begin(); t != threads.end(); t++) {
+		t->join();
+	}
+}
+
+/**
+ * \brief Release all images except those of the terminal steps
+ */
+void	NetworkScheduler::releaseall() {
+	for (auto i = _finished.begin(); i != _finished.end(); i++) {
+		ImageStep	*step = imagestep(*i);
+		if ((NULL != step) && (successors[*i].size() > 0)) {
+			step->release();
+		}
+	}
+}
+
 /**
  * \brief Process the complete network
+ *
+ * The steps that need work are found the same way as process(int) does,
+ * descending from the terminals only through idle steps. They are then
+ * run by up to maxthreads() workers, and the successors they make ready
+ * are run as soon as their precursors are complete.
  */
 void	ProcessorNetwork::process() {
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "start processing");
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "start processing with %d threads",
+		_maxthreads);
 	ProcessingStep::steps	t = terminals();
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "found %d terminals", t.size());
 	int	counter = 0;
@@ -213,19 +658,131 @@ void	ProcessorNetwork::process() {
 				++counter, stepid, step->verboseinfo().c_str());
 		}
 	);
-	int	id;
-	while (0 <= (id = process(t))) {
-		ProcessingStepPtr	step = ProcessingStep::byid(id);
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "working on id=%d '%s'", id,
-			step->name().c_str());
-		ProcessingThreadPtr	t(new ProcessingThread(step));
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "wait for thread to complete");
-		if (t->joinable()) {
-			t->join();
+	_timings.clear();
+	_start = Timer::gettime();
+	NetworkScheduler	scheduler(_maxthreads, _memorylimit);
+	while (true) {
+		// find the steps that need work
+		std::list<int>	pending(t.begin(), t.end());
+		std::set<int>	visited;
+		int	ready = 0;
+		while (pending.size() > 0) {
+			int	id = pending.front();
+			pending.pop_front();
+			if (!visited.insert(id).second) {
+				continue;
+			}
+			ProcessingStepPtr	step = ProcessingStep::byid(id);
+			scheduler.relevant.insert(id);
+			scheduler.precursors[id] = step->precursors();
+			scheduler.successors[id] = step->successors();
+			switch (step->status()) {
+			case ProcessingStep::needswork:
+				if (!scheduler.executed(id)) {
+					scheduler.schedule(ready++, id);
+				}
+				break;
+			case ProcessingStep::idle:
+				pending.insert(pending.end(),
+					step->precursors().begin(),
+					step->precursors().end());
+				break;
+			default:
+				break;
+			}
+		}
+		if (ready == 0) {
+			break;
+		}
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "%d steps ready", ready);
+		scheduler.presize();
+		scheduler.run();
+	}
+	scheduler.releaseall();
+	_end = Timer::gettime();
+	_timings = scheduler.timings;
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "end processing, %d steps in %.3fs",
+		_timings.size(), _end - _start);
+}
+
+/**
+ * \brief Find the chain of executed steps that determined the run time
+ *
+ * Each step is assigned the length of the longest chain of executed
+ * precursors ending in it, the critical path ends in the step where
+ * this is largest.
+ */
+ProcessingStep::steps	ProcessorNetwork::criticalpath() const {
+	std::vector<std::pair<double, int> >	order;
+	for (auto i = _timings.begin(); i != _timings.end(); i++) {
+		order.push_back(std::make_pair(i->second.end, i->first));
+	}
+	std::sort(order.begin(), order.end());
+	std::map<int, double>	length;
+	std::map<int, int>	previous;
+	int	last = -1;
+	for (auto i = order.begin(); i != order.end(); i++) {
+		int	id = i->second;
+		const steptiming_t&	timing = _timings.find(id)->second;
+		double	l = 0;
+		const ProcessingStep::steps&	p
+			= ProcessingStep::byid(id)->precursors();
+		for (auto j = p.begin(); j != p.end(); j++) {
+			auto	k = length.find(*j);
+			if ((k != length.end()) && (k->second > l)) {
+				l = k->second;
+				previous[id] = *j;
+			}
+		}
+		length[id] = l + timing.end - timing.start;
+		if ((last < 0) || (length[id] > length[last])) {
+			last = id;
 		}
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "thread joined");
-	} 
-	debug(LOG_DEBUG, DEBUG_LOG, 0, "end processing");
+	}
+	ProcessingStep::steps	result;
+	while (last >= 0) {
+		result.push_front(last);
+		auto	i = previous.find(last);
+		last = (i != previous.end()) ? i->second : -1;
+	}
+	return result;
+}
+
+/**
+ * \brief Report the timing of the last call to process()
+ *
+ * \param out	the stream to write the report to
+ */
+void	ProcessorNetwork::report(std::ostream& out) const {
+	double	busy = 0;
+	for (auto i = _timings.begin(); i != _timings.end(); i++) {
+		ProcessingStepPtr	step = ProcessingStep::byid(i->first);
+		double	duration = i->second.end - i->second.start;
+		busy += duration;
+		out << stringprintf("step %4d %-20.20s %-10s start %8.3fs "
+			"time %8.3fs", i->first, step->name().c_str(),
+			ProcessingStep::statename(i->second.result).c_str(),
+			i->second.start - _start, duration) << std::endl;
+	}
+	double	wall = _end - _start;
+	out << stringprintf("%d steps, elapsed %.3fs, busy %.3fs, "
+		"parallelism %.2f", _timings.size(), wall, busy,
+		(wall > 0) ? (busy / wall) : 0.) << std::endl;
+	ProcessingStep::steps	path = criticalpath();
+	double	length = 0;
+	std::string	chain;
+	for (auto i = path.begin(); i != path.end(); i++) {
+		const steptiming_t&	timing = _timings.find(*i)->second;
+		length += timing.end - timing.start;
+		ProcessingStepPtr	step = ProcessingStep::byid(*i);
+		if (chain.size() > 0) {
+			chain.append(" -> ");
+		}
+		chain.append((step->name().size() > 0) ? step->name()
+			: stringprintf("#%d", *i));
+	}
+	out << stringprintf("critical path %.3fs: %s", length,
+		chain.c_str()) << std::endl;
 }
 
 /**
@@ -147,6 +147,10 @@ void	ProcessorParser::startElement(const std::string& name,
 		startDeconvolution(attrs);
 		return;
 	}
+	if (name == std::string("solve")) {
+		startSolve(attrs);
+		return;
+	}
 	std::string	msg = stringprintf("don't know how to handle <%s>",
 		name.c_str());
 	throw std::runtime_error(msg);
@@ -62,6 +62,7 @@ class ProcessorParser {
 	void	startLRGB(const attr_t& attrs);
 	void	startGamma(const attr_t& attrs);
 	void	startDeconvolution(const attr_t& attrs);
+	void	startSolve(const attr_t& attrs);
 public:
 	ProcessorParser();
 	void	startElement(const std::string& name, const attr_t& attrs);
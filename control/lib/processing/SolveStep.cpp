@@ -0,0 +1,56 @@
+/*
+ * SolveStep.cpp -- implementation of the plate solving step
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroProcess.h>
+#include <AstroSolver.h>
+#include <AstroImageops.h>
+
+namespace astro {
+namespace process {
+
+/**
+ * \brief Construct a new SolveStep
+ *
+ * By default, the pixel scale of the solution is not restricted.
+ */
+SolveStep::SolveStep(NodePaths& parent) : ImageStep(parent),
+	_minscale(0), _maxscale(0) {
+}
+
+/**
+ * \brief Work function for plate solving
+ *
+ * The precursor image is copied, so that the precursor keeps its
+ * metadata.
+ */
+ProcessingStep::state	SolveStep::do_work() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "start solving with index %s",
+		_index.c_str());
+	try {
+		ImagePtr	precursor = precursorimage();
+		catalog::QuadIndex	index(_index);
+		catalog::PlateSolver	solver(index);
+		solver.scalerange(_minscale, _maxscale);
+		catalog::PlateSolution	solution = solver(precursor);
+		_image = image::ops::duplicate(precursor);
+		solution.addMetadata(*_image);
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "solution: %s",
+			solution.toString().c_str());
+		return ProcessingStep::complete;
+	} catch (const std::exception& x) {
+		debug(LOG_ERR, DEBUG_LOG, 0, "processing error: %s", x.what());
+	}
+	return ProcessingStep::failed;
+}
+
+/**
+ * \brief Inform about what we are doing
+ */
+std::string	SolveStep::what() const {
+	return std::string("Plate solve an image");
+}
+
+} // namespace process
+} // namespace astro
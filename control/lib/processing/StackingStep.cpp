@@ -25,6 +25,9 @@ StackingStep::StackingStep(NodePaths& parent) : ImageStep(parent) {
 	_usetriangles = false;
 	_rigid = false;
 	_rescale = true;	// rescale by default
+	_method = astro::image::stacking::Stacker::SUM;
+	_kappa = 3;
+	_iterations = 5;
 }
 
 #define do_rescale(Pixel)						\
@@ -102,6 +105,9 @@ ProcessingStep::state	StackingStep::do_work() {
 	stacker->notransform(_notransform);
 	stacker->usetriangles(_usetriangles);
 	stacker->rigid(_rigid);
+	stacker->method(_method);
+	stacker->kappa(_kappa);
+	stacker->iterations(_iterations);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "stacker created and parametrized");
 	
 	// add the precursor images (except the base image)
@@ -144,7 +150,9 @@ ProcessingStep::state	StackingStep::do_work() {
  */
 std::string	StackingStep::what() const {
 	std::ostringstream	out;
-	out << "stack images on base image '" << _baseimage->name();
+	out << "stack images ("
+		<< astro::image::stacking::Stacker::method2string(_method)
+		<< ") on base image '" << _baseimage->name();
 	out << "'(" << _baseimage->id() << "):";
 	ProcessingStep::steps::const_iterator	i;
 	for (i = precursors().begin(); i != precursors().end(); i++) {
@@ -211,5 +211,33 @@ ImagePtr	WritableFileImageStep::image() {
 	return FileImageStep::image();
 }
 
+size_t	WritableFileImageStep::imagebytes() {
+	std::unique_lock<std::recursive_mutex>	lock(_mutex);
+	if (!_image) {
+		return 0;
+	}
+	return _image->size().getPixels() * _image->bytesPerPixel();
+}
+
+void	WritableFileImageStep::release() {
+	std::unique_lock<std::recursive_mutex>	lock(_mutex);
+	_image.reset();
+}
+
+/**
+ * \brief Free the memory of the image
+ *
+ * The image was written to the destination file, so image() can read it
+ * back from there, no additional file is needed.
+ */
+bool	WritableFileImageStep::spill(const std::string& /* directory */) {
+	std::unique_lock<std::recursive_mutex>	lock(_mutex);
+	if (!_image) {
+		return false;
+	}
+	_image.reset();
+	return true;
+}
+
 } // namespace process
 } // namespade astro
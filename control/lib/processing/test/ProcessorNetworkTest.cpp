@@ -0,0 +1,263 @@
+/*
+ * ProcessorNetworkTest.cpp -- test parallel processing of a network
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <AstroProcess.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <AstroDebug.h>
+#include <includes.h>
+#include <atomic>
+#include <chrono>
+
+using namespace astro::process;
+using namespace astro::image;
+
+namespace astro {
+namespace test {
+
+/**
+ * \brief Image step recording when it runs
+ *
+ * The step produces an image of a given size filled with its id, and
+ * fails if any precursor image does not contain the id of the precursor.
+ */
+class TestImageStep : public ImageStep {
+	int	_size;
+	int	_duration;
+public:
+	static std::mutex	ordermutex;
+	static std::vector<int>	order;
+	static std::atomic<int>	running;
+	static std::atomic<int>	maxrunning;
+	static std::atomic<int>	spilled;
+	TestImageStep(NodePaths& parent, int size, int duration)
+		: ImageStep(parent), _size(size), _duration(duration) { }
+	virtual ProcessingStep::state	do_work();
+	virtual bool	spill(const std::string& directory);
+	virtual std::string	what() const { return std::string("test"); }
+};
+
+std::mutex	TestImageStep::ordermutex;
+std::vector<int>	TestImageStep::order;
+std::atomic<int>	TestImageStep::running(0);
+std::atomic<int>	TestImageStep::maxrunning(0);
+std::atomic<int>	TestImageStep::spilled(0);
+
+ProcessingStep::state	TestImageStep::do_work() {
+	int	r = ++running;
+	int	m = maxrunning;
+	while ((r > m) && !maxrunning.compare_exchange_weak(m, r)) { }
+	ProcessingStep::state	result = ProcessingStep::complete;
+	ImageSequence	images = precursorimages();
+	int	i = 0;
+	for (auto p = precursors().begin(); p != precursors().end(); p++, i++) {
+		Image<unsigned short>	*img
+			= dynamic_cast<Image<unsigned short> *>(&*images[i]);
+		if ((NULL == img) || (img->pixel(0, 0) != *p)) {
+			debug(LOG_ERR, DEBUG_LOG, 0, "bad image from %d", *p);
+			result = ProcessingStep::failed;
+		}
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(_duration));
+	Image<unsigned short>	*image
+		= new Image<unsigned short>(ImageSize(_size, _size));
+	image->fill(id());
+	{
+		std::unique_lock<std::mutex>	lock(_imagemutex);
+		_image = ImagePtr(image);
+	}
+	{
+		std::unique_lock<std::mutex>	lock(ordermutex);
+		order.push_back(id());
+	}
+	running--;
+	return result;
+}
+
+bool	TestImageStep::spill(const std::string& directory) {
+	bool	result = ImageStep::spill(directory);
+	if (result) {
+		spilled++;
+	}
+	return result;
+}
+
+class ProcessorNetworkTest : public CppUnit::TestFixture {
+	ProcessorNetworkPtr	network;
+	ProcessingStepPtr	step(int size, int duration,
+				std::list<ProcessingStepPtr> precursors
+					= std::list<ProcessingStepPtr>());
+	size_t	position(ProcessingStepPtr step);
+public:
+	void	setUp();
+	void	tearDown();
+	void	testParallel();
+	void	testRelease();
+	void	testSpill();
+	void	testMemoryLimit();
+	void	testCriticalPath();
+
+	CPPUNIT_TEST_SUITE(ProcessorNetworkTest);
+	CPPUNIT_TEST(testParallel);
+	CPPUNIT_TEST(testRelease);
+	CPPUNIT_TEST(testSpill);
+	CPPUNIT_TEST(testMemoryLimit);
+	CPPUNIT_TEST(testCriticalPath);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ProcessorNetworkTest);
+
+void	ProcessorNetworkTest::setUp() {
+	network = ProcessorNetworkPtr(new ProcessorNetwork());
+	TestImageStep::order.clear();
+	TestImageStep::running = 0;
+	TestImageStep::maxrunning = 0;
+	TestImageStep::spilled = 0;
+}
+
+void	ProcessorNetworkTest::tearDown() {
+	network.reset();
+}
+
+/**
+ * \brief Create a test step and add it to the network
+ */
+ProcessingStepPtr	ProcessorNetworkTest::step(int size, int duration,
+				std::list<ProcessingStepPtr> precursors) {
+	ProcessingStepPtr	result(new TestImageStep(*network, size,
+		duration));
+	ProcessingStep::remember(result);
+	network->add(result);
+	for (auto i = precursors.begin(); i != precursors.end(); i++) {
+		result->add_precursor(*i);
+	}
+	if (precursors.size() == 0) {
+		result->status(ProcessingStep::needswork);
+	}
+	return result;
+}
+
+/**
+ * \brief Position of a step in the order of execution
+ */
+size_t	ProcessorNetworkTest::position(ProcessingStepPtr step) {
+	auto	i = std::find(TestImageStep::order.begin(),
+		TestImageStep::order.end(), step->id());
+	CPPUNIT_ASSERT(i != TestImageStep::order.end());
+	return i - TestImageStep::order.begin();
+}
+
+static size_t	imagebytes(ProcessingStepPtr step) {
+	return dynamic_cast<ImageStep *>(&*step)->imagebytes();
+}
+
+void	ProcessorNetworkTest::testParallel() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testParallel() begin");
+	ProcessingStepPtr	a = step(10, 200);
+	ProcessingStepPtr	b = step(10, 200);
+	ProcessingStepPtr	c = step(10, 200, { a });
+	ProcessingStepPtr	d = step(10, 200, { b });
+	ProcessingStepPtr	e = step(10, 10, { c, d });
+	network->maxthreads(2);
+	network->process();
+	CPPUNIT_ASSERT(TestImageStep::order.size() == 5);
+	CPPUNIT_ASSERT(TestImageStep::maxrunning == 2);
+	CPPUNIT_ASSERT(position(a) < position(c));
+	CPPUNIT_ASSERT(position(b) < position(d));
+	CPPUNIT_ASSERT(position(e) == 4);
+	CPPUNIT_ASSERT(e->status() == ProcessingStep::complete);
+	CPPUNIT_ASSERT(network->timings().size() == 5);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testParallel() end");
+}
+
+void	ProcessorNetworkTest::testRelease() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRelease() begin");
+	ProcessingStepPtr	a = step(10, 10);
+	ProcessingStepPtr	b = step(10, 10, { a });
+	ProcessingStepPtr	c = step(10, 10, { b });
+	network->maxthreads(2);
+	network->process();
+	CPPUNIT_ASSERT(c->status() == ProcessingStep::complete);
+	// only the terminal keeps its image
+	CPPUNIT_ASSERT(imagebytes(a) == 0);
+	CPPUNIT_ASSERT(imagebytes(b) == 0);
+	CPPUNIT_ASSERT(imagebytes(c) == 10 * 10 * sizeof(unsigned short));
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testRelease() end");
+}
+
+void	ProcessorNetworkTest::testSpill() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testSpill() begin");
+	// a spilled image is read back from the spool file
+	ProcessingStepPtr	a = step(100, 10);
+	a->work();
+	ImageStep	*imagestep = dynamic_cast<ImageStep *>(&*a);
+	CPPUNIT_ASSERT(imagestep->spill("."));
+	CPPUNIT_ASSERT(imagestep->imagebytes() == 0);
+	ImagePtr	image = imagestep->image();
+	Image<unsigned short>	*img
+		= dynamic_cast<Image<unsigned short> *>(&*image);
+	CPPUNIT_ASSERT(NULL != img);
+	CPPUNIT_ASSERT(img->size() == ImageSize(100, 100));
+	CPPUNIT_ASSERT(img->pixel(50, 50) == a->id());
+	imagestep->release();
+	CPPUNIT_ASSERT(!imagestep->image());
+
+	// both inputs of the last step do not fit, so one is spilled and
+	// read back when the last step runs
+	TestImageStep::spilled = 0;
+	ProcessingStepPtr	b = step(100, 10);
+	ProcessingStepPtr	c = step(100, 10);
+	ProcessingStepPtr	d = step(10, 10, { b, c });
+	network->maxthreads(1);
+	network->memorylimit(30000);
+	network->process();
+	CPPUNIT_ASSERT(TestImageStep::spilled == 1);
+	CPPUNIT_ASSERT(d->status() == ProcessingStep::complete);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testSpill() end");
+}
+
+void	ProcessorNetworkTest::testMemoryLimit() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testMemoryLimit() begin");
+	// without a limit, the two successors run concurrently
+	ProcessingStepPtr	a = step(100, 10);
+	step(100, 200, { a });
+	step(100, 200, { a });
+	network->maxthreads(2);
+	network->process();
+	CPPUNIT_ASSERT(TestImageStep::maxrunning == 2);
+
+	// with a limit, the second successor waits for the first
+	setUp();
+	ProcessingStepPtr	b = step(100, 10);
+	ProcessingStepPtr	c = step(100, 200, { b });
+	ProcessingStepPtr	d = step(100, 200, { b });
+	network->maxthreads(2);
+	network->memorylimit(30000);
+	network->process();
+	CPPUNIT_ASSERT(TestImageStep::maxrunning == 1);
+	CPPUNIT_ASSERT(c->status() == ProcessingStep::complete);
+	CPPUNIT_ASSERT(d->status() == ProcessingStep::complete);
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testMemoryLimit() end");
+}
+
+void	ProcessorNetworkTest::testCriticalPath() {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testCriticalPath() begin");
+	ProcessingStepPtr	a = step(10, 50);
+	ProcessingStepPtr	b = step(10, 300);
+	ProcessingStepPtr	c = step(10, 50, { a });
+	ProcessingStepPtr	d = step(10, 50, { b, c });
+	network->maxthreads(2);
+	network->process();
+	ProcessingStep::steps	path = network->criticalpath();
+	CPPUNIT_ASSERT(path.size() == 2);
+	CPPUNIT_ASSERT(path.front() == b->id());
+	CPPUNIT_ASSERT(path.back() == d->id());
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "testCriticalPath() end");
+}
+
+} // namespace test
+} // namespace astro
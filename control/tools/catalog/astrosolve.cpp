@@ -0,0 +1,213 @@
+/*
+ * astrosolve.cpp -- build quad indexes and solve images offline
+ *
+ * (c) 2026 Prof Dr Andreas Mueller, Hochschule Rapperswil
+ */
+#include <stdexcept>
+#include <stdlib.h>
+#include <iostream>
+#include <includes.h>
+#include <AstroDebug.h>
+#include <AstroSolver.h>
+#include <AstroIO.h>
+#include <AstroUtils.h>
+
+using namespace astro;
+using namespace astro::catalog;
+using namespace astro::io;
+
+namespace astro {
+namespace app {
+namespace astrosolve {
+
+static CatalogFactory::BackendType	backend = CatalogFactory::Tycho2;
+static std::string	path;
+static float	maglimit = 12;
+static double	minfield = 0.5;
+static double	maxfield = 4;
+static double	minscale = 0;
+static double	maxscale = 0;
+static bool	force = false;
+
+/**
+ * \brief Build an index from the catalog
+ */
+static int	buildmain(const std::string& indexfile) {
+	CatalogPtr	catalog = (path.size())
+				? CatalogFactory::get(backend, path)
+				: CatalogFactory::get(backend);
+	QuadIndexBuilder	builder(catalog);
+	builder.maglimit(maglimit);
+	builder.scales(Angle(minfield, Angle::Degrees),
+		Angle(maxfield, Angle::Degrees));
+	builder.build(indexfile);
+	QuadIndex	index(indexfile);
+	std::cout << "index " << indexfile << ": " << index.nstars()
+		<< " stars" << std::endl;
+	for (unsigned int level = 0; level < index.nlevels(); level++) {
+		std::cout << "level " << level << ": cell size "
+			<< index.scale(level).degrees() << " degrees, "
+			<< index.nquads(level) << " quads" << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * \brief Solve an image and optionally write it with WCS keywords
+ */
+static int	solvemain(const std::string& indexfile,
+			const std::string& imagefile,
+			const std::string& outfilename) {
+	QuadIndex	index(indexfile);
+	FITSin	infile(imagefile);
+	ImagePtr	image = infile.read();
+	PlateSolver	solver(index);
+	solver.scalerange(minscale, maxscale);
+	PlateSolution	solution = solver(image);
+	std::cout << solution.toString() << std::endl;
+	if (0 == outfilename.size()) {
+		return EXIT_SUCCESS;
+	}
+	solution.addMetadata(*image);
+	FITSout	outfile(outfilename);
+	outfile.setPrecious(!force);
+	outfile.write(image);
+	return EXIT_SUCCESS;
+}
+
+static void	usage(const char *progname) {
+	Path	p(progname);
+	std::cout << "usage:" << std::endl;
+	std::cout << std::endl;
+	std::cout << "    " << p.basename() << " [ options ] build <index>"
+		<< std::endl;
+	std::cout << "    " << p.basename() << " [ options ] solve <index> "
+		"<image> [ <out> ]" << std::endl;
+	std::cout << std::endl;
+	std::cout << "build a quad index from a local star catalog (first "
+		"syntax), or find the" << std::endl;
+	std::cout << "position of an image in the sky using such an index "
+		"(second syntax). If" << std::endl;
+	std::cout << "<out> is given, the image is written to it with WCS "
+		"keywords added." << std::endl;
+	std::cout << std::endl;
+	std::cout << "options:" << std::endl;
+	std::cout << std::endl;
+	std::cout << "    -c,--catalog=<c>       catalog to build the index "
+		"from, tycho2 or ucac4" << std::endl;
+	std::cout << "                           (default tycho2)"
+		<< std::endl;
+	std::cout << "    -d,--debug             increase debug level"
+		<< std::endl;
+	std::cout << "    -f,--force             overwrite existing output "
+		"file" << std::endl;
+	std::cout << "    -m,--maglimit=<m>      faintest stars to use for "
+		"the index (default 12)" << std::endl;
+	std::cout << "    -p,--path=<path>       path to the catalog"
+		<< std::endl;
+	std::cout << "    -w,--minfield=<w>      smallest field size [deg] "
+		"(default 0.5)" << std::endl;
+	std::cout << "    -W,--maxfield=<w>      largest field size [deg] "
+		"(default 4)" << std::endl;
+	std::cout << "    -s,--minscale=<s>      smallest pixel scale "
+		"[arcsec/pixel]" << std::endl;
+	std::cout << "    -S,--maxscale=<s>      largest pixel scale "
+		"[arcsec/pixel]" << std::endl;
+	std::cout << "    -h,-?,--help           display this help message"
+		<< std::endl;
+	std::cout << std::endl;
+}
+
+static struct option	longopts[] = {
+{ "catalog",	required_argument,	NULL,	'c' }, /* 0 */
+{ "debug",	no_argument,		NULL,	'd' }, /* 1 */
+{ "force",	no_argument,		NULL,	'f' }, /* 2 */
+{ "maglimit",	required_argument,	NULL,	'm' }, /* 3 */
+{ "path",	required_argument,	NULL,	'p' }, /* 4 */
+{ "minfield",	required_argument,	NULL,	'w' }, /* 5 */
+{ "maxfield",	required_argument,	NULL,	'W' }, /* 6 */
+{ "minscale",	required_argument,	NULL,	's' }, /* 7 */
+{ "maxscale",	required_argument,	NULL,	'S' }, /* 8 */
+{ "help",	no_argument,		NULL,	'h' }, /* 9 */
+{ NULL,		0,			NULL,	 0  }, /* 10 */
+};
+
+/**
+ * \brief Main function for the astrosolve program
+ */
+int	main(int argc, char *argv[]) {
+	int	c;
+	int	longindex;
+	while (EOF != (c = getopt_long(argc, argv, "c:dfm:p:w:W:s:S:h?",
+		longopts, &longindex)))
+		switch (c) {
+		case 'c':
+			if (std::string(optarg) == "tycho2") {
+				backend = CatalogFactory::Tycho2;
+			} else if (std::string(optarg) == "ucac4") {
+				backend = CatalogFactory::Ucac4;
+			} else {
+				throw std::runtime_error("unknown catalog");
+			}
+			break;
+		case 'd':
+			debuglevel = LOG_DEBUG;
+			break;
+		case 'f':
+			force = true;
+			break;
+		case 'm':
+			maglimit = atof(optarg);
+			break;
+		case 'p':
+			path = std::string(optarg);
+			break;
+		case 'w':
+			minfield = atof(optarg);
+			break;
+		case 'W':
+			maxfield = atof(optarg);
+			break;
+		case 's':
+			minscale = atof(optarg);
+			break;
+		case 'S':
+			maxscale = atof(optarg);
+			break;
+		case 'h':
+		case '?':
+			usage(argv[0]);
+			return EXIT_SUCCESS;
+		default:
+			throw std::runtime_error("unknown option");
+		}
+
+	if (argc <= optind + 1) {
+		throw std::runtime_error("not enough arguments");
+	}
+	std::string	command = std::string(argv[optind++]);
+	std::string	indexfile = std::string(argv[optind++]);
+	if (command == "build") {
+		return buildmain(indexfile);
+	}
+	if (command == "solve") {
+		if (argc <= optind) {
+			throw std::runtime_error("image file missing");
+		}
+		std::string	imagefile = std::string(argv[optind++]);
+		std::string	outfilename;
+		if (optind < argc) {
+			outfilename = std::string(argv[optind++]);
+		}
+		return solvemain(indexfile, imagefile, outfilename);
+	}
+	throw std::runtime_error("unknown command '" + command + "'");
+}
+
+} // namespace astrosolve
+} // namespace app
+} // namespace astro
+
+int	main(int argc, char *argv[]) {
+	return astro::main_function<astro::app::astrosolve::main>(argc, argv);
+}
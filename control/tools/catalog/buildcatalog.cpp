@@ -7,6 +7,7 @@
 #include <AstroFormat.h>
 #include "../lib/catalogs/CatalogBackend.h"
 #include "../lib/catalogs/CutoverConditions.h"
+#include "../lib/catalogs/CompactCatalog.h"
 #include <includes.h>
 #include <iostream>
 #include <typeinfo>
@@ -18,7 +19,8 @@ namespace astro {
 namespace app {
 namespace buildcatalog {
 
-static void	addfromcatalog(DatabaseBackendCreator& database,
+template<typename creator>
+static void	addfromcatalog(creator& database,
 			CatalogPtr catalog,
 			CutoverCondition& condition, int loginterval) {
 	int	counter = 0;
@@ -50,14 +52,68 @@ static void	addfromcatalog(DatabaseBackendCreator& database,
 		counter, catalog->name().c_str(), condition.toString().c_str());
 }
 
+/**
+ * \brief Add the stars of all catalogs to a database or compact catalog
+ *
+ * The cutover conditions make sure that each star is only added from
+ * one catalog, even if it is contained in several of them.
+ */
+template<typename creator>
+static void	addcatalogs(creator& database, const std::string& bscdir,
+			const std::string& hipparcosfile,
+			const std::string& tycho2file,
+			const std::string& ucac4dir) {
+	// open the Bright star catalog
+	if (bscdir.size()) {
+		CatalogPtr	catalog
+			= CatalogFactory::get(CatalogFactory::BSC, bscdir);
+		BSCCondition	condition(CutoverCondition::unlimited);
+		addfromcatalog(database, catalog, condition, 100000);
+	}
+
+	// open the hipparcos catalog
+	if (hipparcosfile.size()) {
+		CatalogPtr	catalog
+			= CatalogFactory::get(CatalogFactory::Hipparcos,
+				hipparcosfile);
+		HipparcosCondition	condition;
+		addfromcatalog(database, catalog, condition, 10000);
+	} else {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "Hipparcos catalog disabled");
+	}
+
+	// open the Tycho2 catalog
+	if (tycho2file.size()) {
+		CatalogPtr	catalog
+			= CatalogFactory::get(CatalogFactory::Tycho2,
+				tycho2file);
+		Tycho2Condition	condition;
+		addfromcatalog(database, catalog, condition, 100000);
+	} else {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "Tycho2 catalog disabled");
+	}
+
+	// open the Ucac4 catalog
+	if (ucac4dir.size()) {
+		CatalogPtr	catalog
+			= CatalogFactory::get(CatalogFactory::Ucac4,
+				ucac4dir);
+		Ucac4Condition	condition;
+		addfromcatalog(database, catalog, condition, 100000);
+	} else {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "UCAC4 catalog disabled");
+	}
+}
+
 static struct option	longopts[] = {
 { "all",	required_argument,	NULL,		'a' }, /* 0 */
 { "bsc",	required_argument,	NULL,		'B' }, /* 1 */
-{ "debug",	no_argument,		NULL,		'd' }, /* 2 */
-{ "help",	required_argument,	NULL,		'h' }, /* 3 */
-{ "hipparcos",	required_argument,	NULL,		'H' }, /* 4 */
-{ "tycho2",	required_argument,	NULL,		'T' }, /* 5 */
-{ "ucac4",	required_argument,	NULL,		'U' }, /* 6 */
+{ "compact",	no_argument,		NULL,		'c' }, /* 2 */
+{ "debug",	no_argument,		NULL,		'd' }, /* 3 */
+{ "help",	required_argument,	NULL,		'h' }, /* 4 */
+{ "hipparcos",	required_argument,	NULL,		'H' }, /* 5 */
+{ "tycho2",	required_argument,	NULL,		'T' }, /* 6 */
+{ "ucac4",	required_argument,	NULL,		'U' }, /* 7 */
 { NULL,		0,			NULL,		0   }
 };
 
@@ -66,6 +122,8 @@ static void	usage(const char *progname) {
 	std::cout << "usage: " << std::endl;
 	std::cout << "    " << progname << " [ options ] dbfile" << std::endl;
 	std::cout << "options:" << std::endl;
+	std::cout << " -c,--compact          write a compact catalog file "
+		"instead of a database" << std::endl;
 	std::cout << " -d,--debug            increase debug level" << std::endl;
 	std::cout << " -h,-?,--help          display this help message";
 	std::cout << std::endl;
@@ -88,7 +146,8 @@ int	main(int argc, char *argv[]) {
 	std::string	hipparcosfile;
 	std::string	tycho2file;
 	std::string	ucac4dir;
-	while (EOF != (c = getopt_long(argc, argv, "B:dhH:T:U:?", longopts,
+	bool	compact = false;
+	while (EOF != (c = getopt_long(argc, argv, "a:B:cdhH:T:U:?", longopts,
 		&longindex)))
 		switch (c) {
 		case 'a':
@@ -100,6 +159,9 @@ int	main(int argc, char *argv[]) {
 		case 'B':
 			bscdir = std::string(optarg);
 			break;
+		case 'c':
+			compact = true;
+			break;
 		case 'd':
 			debuglevel = LOG_DEBUG;
 			break;
@@ -126,128 +188,23 @@ int	main(int argc, char *argv[]) {
 	}
 	std::string	databasefilename(argv[optind++]);
 
+	// build a compact catalog file
+	if (compact) {
+		CompactCatalogCreator	creator(databasefilename);
+		addcatalogs(creator, bscdir, hipparcosfile, tycho2file,
+			ucac4dir);
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "writing %llu stars",
+			creator.count());
+		creator.write();
+		return EXIT_SUCCESS;
+	}
+
 	// open the database catalog
 	DatabaseBackendCreator	database(databasefilename);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "number of stars already present: %lld",
 		database.count());
 	database.prepare();
-
-	// open the Bright star catalog
-	if (bscdir.size()) {
-		CatalogPtr	catalog
-			= CatalogFactory::get(CatalogFactory::BSC, bscdir);
-		BSCCondition	condition(CutoverCondition::unlimited);
-		addfromcatalog(database, catalog, condition, 100000);
-#if 0
-		int	counter = 0;
-		CatalogIterator	i;
-		for (i = catalog->begin(); i != catalog->end(); ++i) {
-			Star	s = *i;
-			if (condition(s)) {
-				database.add(s);
-				counter++;
-			}
-		}
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "%d stars added, %s", counter,
-			condition.toString().c_str());
-#endif
-	}
-
-	// open the hipparcos catalog
-	if (hipparcosfile.size()) {
-		CatalogPtr	catalog
-			= CatalogFactory::get(CatalogFactory::Hipparcos,
-				hipparcosfile);
-		HipparcosCondition	condition;
-		addfromcatalog(database, catalog, condition, 10000);
-#if 0
-		int	counter = 0;
-		CatalogIterator	i;
-		for (i = catalog->begin(); i != catalog->end(); ++i) {
-			Star	s = *i;
-			if (condition(s)) {
-				database.add(s);
-				counter++;
-				if (0 == (counter % 10000)) {
-					debug(LOG_DEBUG, DEBUG_LOG, 0,
-						"%d Hipparcos stars added",
-						counter);
-				}
-			}
-		}
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "%d Hipparcos stars added %s",
-			counter, condition.toString().c_str());
-#endif
-	} else {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "Hipparcos catalog disabled");
-	}
-
-	// open the Tycho2 catalog
-	if (tycho2file.size()) {
-		CatalogPtr	catalog
-			= CatalogFactory::get(CatalogFactory::Tycho2,
-				tycho2file);
-		Tycho2Condition	condition;
-		addfromcatalog(database, catalog, condition, 100000);
-#if 0
-		int	counter = 0;
-		int	steps = 0;
-		CatalogIterator	i;
-		for (i = catalog->begin(); i != catalog->end(); ++i) {
-			steps++;
-			try {
-				Star	s = *i;
-				if (condition(s)) {
-					database.add(s);
-					counter++;
-					if (0 == (counter % 100000)) {
-						debug(LOG_DEBUG, DEBUG_LOG, 0,
-							"%d Tycho2 stars added,"
-							" %d skipped",
-							counter,
-							steps - counter);
-					}
-				}
-			} catch (const std::exception& x) {
-				//debug(LOG_DEBUG, DEBUG_LOG, 0,
-				//	"tycho2 catalog error at %d: %s",
-				//	steps, x.what());
-			}
-		}
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "%d Tycho2 stars added, %s",
-			counter, condition.toString().c_str());
-#endif
-	} else {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "Tycho2 catalog disabled");
-	}
-
-	// open the Ucac4 catalog
-	if (ucac4dir.size()) {
-		CatalogPtr	catalog
-			= CatalogFactory::get(CatalogFactory::Ucac4,
-				ucac4dir);
-		Ucac4Condition	condition;
-		addfromcatalog(database, catalog, condition, 100000);
-#if 0
-		int	counter = 0;
-		CatalogIterator	i;
-		for (i = catalog->begin(); i != catalog->end(); ++i) {
-			Star	s = *i;
-			if (condition(s)) {
-				database.add(s);
-				counter++;
-				if (0 == (counter % 1000000)) {
-					debug(LOG_DEBUG, DEBUG_LOG, 0,
-						"%d Ucac4 stars added", counter);
-				}
-			}
-		}
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "%d Ucac4 stars added, %s",
-			counter, condition.toString().c_str());
-#endif
-	} else {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "UCAC4 catalog disabled");
-	}
+	addcatalogs(database, bscdir, hipparcosfile, tycho2file, ucac4dir);
 
 	// cleanup
 	database.finalize();
@@ -12,7 +12,6 @@
 #include <AstroInterpolation.h>
 #include <AstroIO.h>
 #include <AstroDemosaic.h>
-#include <AstroImager.h>
 #include <AstroUtils.h>
 #include <AstroOperators.h>
 #include <AstroAdapter.h>
@@ -48,6 +47,8 @@ static void	usage(const char *progname) {
 	std::cout << "  -M,--max=<max>          clamp the image values to at most <max>"
 		<< std::endl;
 	std::cout << "  -b,--bayer              demosaic bayer images" << std::endl;
+	std::cout << "  -B,--binning=<b>        add <b>x<b> pixels of the same color"
+		<< std::endl;
 	std::cout << "  -f,--flip               flip image (useful for HyperStar)" << std::endl;
 	std::cout << "  -i,--interpolate        interpolate bad pixels" << std::endl;
 	std::cout << "  -d,--debug              increase debug level" << std::endl;
@@ -64,7 +65,8 @@ static struct option	longopts[] = {
 { "min",		required_argument,	NULL,	'm' }, /* 6 */
 { "max",		required_argument,	NULL,	'M' }, /* 7 */
 { "interpolate",	no_argument,		NULL,	'i' }, /* 8 */
-{ NULL,			0,			NULL,	 0  }, /* 9 */
+{ "binning",		required_argument,	NULL,	'B' }, /* 9 */
+{ NULL,			0,			NULL,	 0  }, /* 10 */
 };
 
 /**
@@ -80,14 +82,18 @@ int	main(int argc, char *argv[]) {
 	bool	demosaic = false;
 	bool	interpolate = false;
 	bool	flip = false;
+	int	binning = 1;
 
 	// parse the command line
-	while (EOF != (c = getopt_long(argc, argv, "dD:F:?hfm:M:bi",
+	while (EOF != (c = getopt_long(argc, argv, "dD:F:?hfm:M:biB:",
 		longopts, &longindex)))
 		switch (c) {
 		case 'b':
 			demosaic = true;
 			break;
+		case 'B':
+			binning = std::stoi(optarg);
+			break;
 		case 'd':
 			debuglevel = LOG_DEBUG;
 			break;
@@ -133,9 +139,6 @@ int	main(int argc, char *argv[]) {
 	FITSin	infile(infilename);
 	ImagePtr	image = infile.read();
 
-	// build the Imager
-	Imager	imager;
-
 	// if we have a dark correction, apply it
 	ImagePtr	dark;
 	if (NULL != darkfilename) {
@@ -143,27 +146,22 @@ int	main(int argc, char *argv[]) {
 			darkfilename);
 		FITSin	darkin(darkfilename);
 		dark = darkin.read();
-		imager.dark(dark);
-		imager.darksubtract(true);
 	}
 
 	// if we have a flat file, we perform flat correction
+	ImagePtr	flat;
 	if (NULL != flatfilename) {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "flat correction: %s",
 			flatfilename);
 		FITSin	flatin(flatfilename);
-		ImagePtr	flat = flatin.read();
-		imager.flat(flat);
-		imager.flatdivide(true);
-	}
-
-	// perform bad pixel interpolation
-	if (interpolate) {
-		imager.interpolate(true);
+		flat = flatin.read();
 	}
 
-	// apply imager corrections
-	imager(image);
+	// dark, flat, bad pixel interpolation, clamping and binning are
+	// all done in a single pass over the image
+	CalibrationKernel	kernel(dark, flat, image->getFrame());
+	kernel.interpolate(interpolate);
+	kernel.binning(binning);
 
 	// if minvalue or maxvalue are set, clamp the image values
 	if ((minvalue >= 0) || (maxvalue >= 0)) {
@@ -173,9 +171,9 @@ int	main(int argc, char *argv[]) {
 		if (maxvalue < 0) {
 			maxvalue = std::numeric_limits<double>::infinity();
 		}
-		Clamper	clamp(minvalue, maxvalue);
-		clamp(image);
+		kernel.clamp(minvalue, maxvalue);
 	}
+	image = kernel(image);
 
 	// if demosaic is requested we do that now
 	ImagePtr	outimage;
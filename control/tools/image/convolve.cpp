@@ -7,6 +7,7 @@
 #include <AstroImage.h>
 #include <AstroDebug.h>
 #include <AstroConvolve.h>
+#include <AstroConfig.h>
 #include <AstroIO.h>
 
 using namespace astro::image;
@@ -74,6 +75,9 @@ int	main(int argc, char *argv[]) {
 	const char	*in2filename = argv[optind++];
 	const char	*outfilename = argv[optind++];
 
+	// FFTW planning settings from the configuration
+	astro::config::FFTWConfiguration::apply();
+
 	// read the image from the file
 	FITSin	in1file(in1filename);
 	ImagePtr	image1 = in1file.read();
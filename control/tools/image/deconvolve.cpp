@@ -6,6 +6,7 @@
 #include <AstroIO.h>
 #include <includes.h>
 #include <AstroConvolve.h>
+#include <AstroConfig.h>
 
 namespace astro {
 namespace app {
@@ -215,6 +216,9 @@ int	main(int argc, char *argv[]) {
 	const char	*infilename = argv[optind++];
 	const char	*outfilename = argv[optind++];
 
+	// FFTW planning settings from the configuration
+	astro::config::FFTWConfiguration::apply();
+
 	// read the image from the file
 	io::FITSin	infile(infilename);
 	ImagePtr	image = infile.read();
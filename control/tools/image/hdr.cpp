@@ -8,6 +8,7 @@
 #include <AstroIO.h>
 #include <AstroAdapter.h>
 #include <AstroConvolve.h>
+#include <AstroConfig.h>
 
 namespace astro {
 namespace app {
@@ -110,6 +111,9 @@ int	main(int argc, char *argv[]) {
 	}
 	std::string	outfile(argv[optind++]);
 
+	// FFTW planning settings from the configuration
+	astro::config::FFTWConfiguration::apply();
+
 	// convert the mask image to double, as we have to fourier transform it
 	FourierImage	*fmask = NULL;
 	typeconvert(unsigned char, maskptr);
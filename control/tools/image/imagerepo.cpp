@@ -26,6 +26,8 @@ namespace app {
 namespace imagerepo {
 
 bool	verbose = false;
+bool	recursive = false;
+int	jobs = 0;
 
 /**
  * \brief Command to add an image to the repository
@@ -213,6 +215,9 @@ int	command_replicate(const std::string& srcreponame,
 	}
 	std::string	dstreponame = arguments[2];
 	RepoReplicator	replicator;
+	if (jobs > 0) {
+		replicator.parallelism(jobs);
+	}
 	ConfigurationPtr	configuration = Configuration::get();
 	ImageRepoConfigurationPtr	imagerepos
 		= ImageRepoConfiguration::get(configuration);
@@ -233,6 +238,9 @@ int	command_synchronize(const std::string& repo1name,
 	}
 	std::string	repo2name = arguments[2];
 	RepoReplicator	replicator;
+	if (jobs > 0) {
+		replicator.parallelism(jobs);
+	}
 	ConfigurationPtr	configuration = Configuration::get();
 	ImageRepoConfigurationPtr	imagerepos
 		= ImageRepoConfiguration::get(configuration);
@@ -243,6 +251,19 @@ int	command_synchronize(const std::string& repo1name,
 	return EXIT_SUCCESS;
 }
 
+/**
+ * \brief Command to add new and changed files in the repository directory
+ */
+int	command_scan(const std::string& reponame) {
+	ConfigurationPtr	configuration = Configuration::get();
+	ImageRepoConfigurationPtr	imagerepos
+		= ImageRepoConfiguration::get(configuration);
+	ImageRepoPtr	repo = imagerepos->repo(reponame);
+	long	count = repo->scan(recursive);
+	std::cout << "files added or updated: " << count << std::endl;
+	return EXIT_SUCCESS;
+}
+
 /**
  * \brief Command to show all info about an image
  */
@@ -306,6 +327,7 @@ static void	usage(const char *progname) {
 	std::cout << "    " << path.basename() << " [ options ] <repo> add <image.fits> ...";
 	std::cout << std::endl;
 	std::cout << "    " << path.basename() << " [ options ] <repo> list" << std::endl;
+	std::cout << "    " << path.basename() << " [ options ] <repo> scan" << std::endl;
 	std::cout << "    " << path.basename() << " [ options ] <repo> get <id> <image.fits>";
 	std::cout << std::endl;
 	std::cout << "    " << path.basename() << " [ options ] <repo> { show | remove } <ids>";
@@ -319,7 +341,9 @@ static void	usage(const char *progname) {
 	std::cout << std::endl;
 	std::cout << "understands 'last' as the last, i.e. usually the most recent id of the";
 	std::cout << std::endl;
-	std::cout << "repository";
+	std::cout << "repository. The scan command adds images found in the repository";
+	std::cout << std::endl;
+	std::cout << "directory that are new or have changed since the last scan.";
 	std::cout << std::endl;
 	std::cout << std::endl;
 	std::cout << "    " << path.basename() << " [ options ] <srcrepo> { copy | move } <id> <targetrepo>";
@@ -342,13 +366,19 @@ static void	usage(const char *progname) {
 	std::cout << std::endl;
 	std::cout << "  -h,--help            display this help message";
 	std::cout << std::endl;
+	std::cout << "  -j,--jobs=<n>        copy <n> files concurrently during replication";
+	std::cout << std::endl;
+	std::cout << "  -r,--recursive       scan subdirectories too";
+	std::cout << std::endl;
 }
 
 static struct option	longopts[] = {
 { "config",	required_argument,	NULL,		'c' }, /* 0 */
 { "debug",	no_argument,		NULL,		'd' }, /* 1 */
 { "help",	no_argument,		NULL,		'h' }, /* 2 */
-{ "verbose",	no_argument,		NULL,		'v' }, /* 3 */
+{ "jobs",	required_argument,	NULL,		'j' }, /* 3 */
+{ "recursive",	no_argument,		NULL,		'r' }, /* 4 */
+{ "verbose",	no_argument,		NULL,		'v' }, /* 5 */
 { NULL,		0,			NULL,		0   }
 };
 
@@ -359,7 +389,7 @@ int	main(int argc, char *argv[]) {
 	std::string	configfile;
 	int	c;
 	int	longindex;
-	while (EOF != (c = getopt_long(argc, argv, "c:dhv", longopts,
+	while (EOF != (c = getopt_long(argc, argv, "c:dhj:rv", longopts,
 		&longindex))) {
 		switch (c) {
 		case 'c':
@@ -372,6 +402,12 @@ int	main(int argc, char *argv[]) {
 		case 'h':
 			usage(argv[0]);
 			return EXIT_SUCCESS;
+		case 'j':
+			jobs = std::stoi(optarg);
+			break;
+		case 'r':
+			recursive = true;
+			break;
 		case 'v':
 			verbose = true;
 			break;
@@ -419,6 +455,9 @@ int	main(int argc, char *argv[]) {
 	if (command == "get") {
 		return command_get(reponame, arguments);
 	}
+	if (command == "scan") {
+		return command_scan(reponame);
+	}
 	if (command == "remove") {
 		return command_remove(reponame, arguments);
 	}
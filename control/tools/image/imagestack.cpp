@@ -27,6 +27,9 @@ static struct option	longopts[] = {
 { "patchsize",		required_argument,	NULL,	'p' }, /* 4 */
 { "searchradius",	required_argument,	NULL,	's' }, /* 5 */
 { "transform",		required_argument,	NULL,	't' }, /* 6 */
+{ "method",		required_argument,	NULL,	'm' }, /* 7 */
+{ "kappa",		required_argument,	NULL,	'k' }, /* 8 */
+{ "iterations",		required_argument,	NULL,	'i' }, /* 9 */
 { NULL,			0,			NULL,	 0  }
 };
 
@@ -47,6 +50,10 @@ static void	usage(const char *progname) {
 	std::cout << std::endl;
 	std::cout << "options:" << std::endl;
 	std::cout << " -d,--debug             increase debug level" << std::endl;
+	std::cout << " -i,--iterations=<i>    perform at most <i> rejection iterations" << std::endl;
+	std::cout << " -k,--kappa=<k>         reject pixels more than <k> sigma off" << std::endl;
+	std::cout << " -m,--method=<m>        combine layers with method <m>, one of sum," << std::endl;
+	std::cout << "                        median, kappasigma, winsorized, linearfit" << std::endl;
 	std::cout << " -n,--number=<n>        number of stars to evaluate" << std::endl;
 	std::cout << " -o,--output=<outfile>  filename of output file" << std::endl;
 	std::cout << " -p,--patchsize=<s>     use patch size <s> for translation analysis" << std::endl;
@@ -66,12 +73,24 @@ int	main(int argc, char *argv[]) {
 	int	numberofstars = 20;
 	int	searchradius = 10;
 	bool	notransform = false;
-	while (EOF != (c = getopt_long(argc, argv, "dh?o:p:n:s:t", longopts,
+	Stacker::method_type	method = Stacker::SUM;
+	double	kappa = 3;
+	int	iterations = 5;
+	while (EOF != (c = getopt_long(argc, argv, "dh?i:k:m:o:p:n:s:t", longopts,
 		&longindex))) {
 		switch (c) {
 		case 'd':
 			debuglevel = LOG_DEBUG;
 			break;
+		case 'i':
+			iterations = std::stoi(optarg);
+			break;
+		case 'k':
+			kappa = std::stod(optarg);
+			break;
+		case 'm':
+			method = Stacker::string2method(optarg);
+			break;
 		case 'n':
 			numberofstars = std::stoi(optarg);
 			break;
@@ -115,8 +134,12 @@ int	main(int argc, char *argv[]) {
 	stacker->numberofstars(numberofstars);
 	stacker->searchradius(searchradius);
 	stacker->notransform(notransform);
+	stacker->method(method);
+	stacker->kappa(kappa);
+	stacker->iterations(iterations);
 
-	// read all the images
+	// read all the images, the stacker only keeps what it needs, so
+	// images can be released as soon as they are added
 	while (optind < argc) {
 		FITSin	in(argv[optind++]);
 		ImagePtr	image = in.read();
@@ -103,16 +103,16 @@ int	main(int argc, char *argv[]) {
 		throw std::runtime_error(msg);
 	}
 
-	ImageSequence	images;
+	// read the images one at a time, only one of them is in memory
+	DarkFrameBuilder	builder(dff);
 	for (; optind < argc; optind++) {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "reading file %s", argv[optind]);
 		std::string	name(argv[optind]);
 		FITSin	infile(name);
-		ImagePtr	image = infile.read();
-		images.push_back(image);
+		builder.add(infile.read());
 	}
 
-	ImagePtr	dark = dff(images);
+	ImagePtr	dark = builder();
 
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "dark image %d x %d generated",
 		dark->size().width(), dark->size().height());
@@ -100,18 +100,9 @@ int	main(int argc, char *argv[]) {
 		return EXIT_FAILURE;
 	}
 
-	// read the images into memory
-	ImageSequence	images;
-	for (; optind < argc; optind++) {
-		debug(LOG_DEBUG, DEBUG_LOG, 0, "reading file %s", argv[optind]);
-		std::string	name(argv[optind]);
-		FITSin	infile(name);
-		ImagePtr	image = infile.read();
-		images.push_back(image);
-	}
-
 	// Get the bias image. This can come from a file, in which case we
-	// have to read the image from the file
+	// have to read the image from the file. Without a bias file, the
+	// first image decides about the size of the empty bias image.
 	ImagePtr	bias;
 	if (NULL != biasfilename) {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "reading bias image: %s",
@@ -122,15 +113,30 @@ int	main(int argc, char *argv[]) {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "got bias %d x %d, %s",
 			bias->size().width(), bias->size().height(),
 			bias->info().c_str());
-	} else {
-		bias = ImagePtr(new Image<float>(images[0]->size()));
+	}
+
+	// read the images one at a time and add them to the flat
+	std::unique_ptr<FlatFrameBuilder>	builder;
+	for (; optind < argc; optind++) {
+		debug(LOG_DEBUG, DEBUG_LOG, 0, "reading file %s", argv[optind]);
+		std::string	name(argv[optind]);
+		FITSin	infile(name);
+		ImagePtr	image = infile.read();
+		if (!builder) {
+			if (!bias) {
+				bias = ImagePtr(new Image<float>(image->size()));
+			}
+			builder = std::unique_ptr<FlatFrameBuilder>(
+				new FlatFrameBuilder(fff, bias));
+		}
+		builder->add(image);
 	}
 
 	// now produce the flat image
 	ImagePtr	flat;
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "computing flat image%s",
 		(fff.mosaic()) ? " (mosaic)" : "");
-	flat = fff(images, bias);
+	flat = (*builder)();
 
 	// display some info about the flat image
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "flat image %d x %d generated",
@@ -5,6 +5,7 @@
  */
 #include <includes.h>
 #include <AstroProcess.h>
+#include <AstroConfig.h>
 #include <AstroUtils.h>
 #include <AstroFormat.h>
 #include <AstroDebug.h>
@@ -29,7 +30,13 @@ void	usage(const char *progname) {
 	std::cout << "  -d,--debug          show debug messages" << std::endl;
 	std::cout << "  -h,--help,-?        show this help message and exit"
 		<< std::endl;
-	std::cout << "  -v,--verbose        show additional information" << std::endl;
+	std::cout << "  -j,--jobs=<n>       run up to <n> independent steps at the same time"
+		<< std::endl;
+	std::cout << "  -m,--memory=<mb>    keep at most <mb> MB of intermediate images in"
+		<< std::endl;
+	std::cout << "                      memory, spill the rest to disk" << std::endl;
+	std::cout << "  -v,--verbose        show additional information and a timing report"
+		<< std::endl;
 	std::cout << "  -n,--net            display the dependency net and exit" << std::endl;
 }
 
@@ -37,6 +44,8 @@ void	usage(const char *progname) {
 static struct option	longopts[] = {
 { "debug",	no_argument,	NULL,	'd' },
 { "help",	no_argument,	NULL,	'h' },
+{ "jobs",	required_argument,	NULL,	'j' },
+{ "memory",	required_argument,	NULL,	'm' },
 { "verbose",	no_argument,	NULL,	'v' },
 { "net",	no_argument,	NULL,	'n' },
 { NULL,		0,		NULL,	 0  }
@@ -47,10 +56,12 @@ static struct option	longopts[] = {
  */
 int	main(int argc, char *argv[]) {
 	bool	netonly = false;
+	int	jobs = 1;
+	size_t	memory = 0;
 	int	c;
 	int	longindex;
 	debugthreads = 1;
-	while (EOF != (c = getopt_long(argc, argv, "dh?vn",
+	while (EOF != (c = getopt_long(argc, argv, "dh?j:m:vn",
 			longopts, &longindex)))
 		switch (c) {
 		case 'd':
@@ -59,6 +70,12 @@ int	main(int argc, char *argv[]) {
 		case 'h':
 			usage(argv[0]);
 			return EXIT_SUCCESS;
+		case 'j':
+			jobs = std::stoi(optarg);
+			break;
+		case 'm':
+			memory = std::stoul(optarg) * 1024 * 1024;
+			break;
 		case 'n':
 			netonly = true;
 			break;
@@ -76,6 +93,9 @@ int	main(int argc, char *argv[]) {
 	}
 	std::string	filename(argv[optind++]);
 
+	// FFTW planning settings from the configuration
+	astro::config::FFTWConfiguration::apply();
+
 	// construct a process and execute it
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "processing '%s'", filename.c_str());
 	ProcessorFactory	factory;
@@ -92,8 +112,13 @@ int	main(int argc, char *argv[]) {
 
 	// execute the network
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "start execution");
+	network->maxthreads(jobs);
+	network->memorylimit(memory);
 	network->process();
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "processing complete");
+	if (ProcessingStep::verbose()) {
+		network->report(std::cout);
+	}
 
 	// that's it
 	return EXIT_SUCCESS;
@@ -11,7 +11,7 @@ namespace snowgui {
  * \brief Create the image sink
  */
 TakeImageSink::TakeImageSink(QObject *parent)
-	: QObject(parent), snowstar::ImageSink() {
+	: QObject(parent), snowstar::RawImageSink() {
 	qRegisterMetaType<astro::image::ImagePtr>("astro::image::ImagePtr");
 
 	_enabled = true;
@@ -37,7 +37,29 @@ void	TakeImageSink::image(const snowstar::ImageQueueEntry& entry,
 	}
 
 	// convert the image to an astro::image::ImagePtr
-	astro::image::ImagePtr  image = snowstar::convertfile(entry.imagedata);
+	newimage(snowstar::convertimage(entry));
+}
+
+/**
+ * \brief handle a new image in a raw stream encoding
+ */
+void	TakeImageSink::rawimage(const snowstar::RawImageQueueEntry& entry,
+		const Ice::Current& /* current */) {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "got raw image of size %dx%d, "
+		"size = %ld",
+		entry.exposure0.frame.size.width,
+		entry.exposure0.frame.size.height,
+		entry.imagedata.size());
+	if (!_enabled) {
+		return;
+	}
+	newimage(snowstar::convertimage(entry));
+}
+
+/**
+ * \brief send a decoded image to the preview
+ */
+void	TakeImageSink::newimage(astro::image::ImagePtr image) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0,
 		"image has depth %d, bits_per_pixel = %d",
 		image->planes(), image->bitsPerPixel());
@@ -13,9 +13,10 @@
 
 namespace snowgui {
 
-class TakeImageSink : public QObject, public snowstar::ImageSink {
+class TakeImageSink : public QObject, public snowstar::RawImageSink {
 	Q_OBJECT
 	bool	_enabled;
+	void	newimage(astro::image::ImagePtr image);
 public:
 	explicit TakeImageSink(QObject *parent = NULL);
 	virtual ~TakeImageSink();
@@ -23,6 +24,8 @@ public:
 	// methods for the ImageSink
 	void	image(const snowstar::ImageQueueEntry& entry,
 			const Ice::Current& current);
+	void	rawimage(const snowstar::RawImageQueueEntry& entry,
+			const Ice::Current& current);
 	void	stop(const Ice::Current& current);
 
 signals:
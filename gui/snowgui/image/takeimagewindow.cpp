@@ -153,6 +153,9 @@ void	takeimagewindow::setupStream() {
 
 		// register the image sink
 		_ccd->registerSink(_sinkidentity);
+
+		// use the most efficient encoding the server offers
+		snowstar::negotiateStreamEncoding(_ccd);
 	} catch (const std::exception& x) {
 		debug(LOG_DEBUG, DEBUG_LOG, 0, "cannot create image sink: %s",
 			x.what());
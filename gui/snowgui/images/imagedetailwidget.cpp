@@ -96,10 +96,26 @@ void	imagedetailwidget::setImage(snowstar::ImagePrx image) {
 
 /**
  * \brief preview the image (JPEG transfer instead of FITS)
+ *
+ * The server bins the image so that it is at most 1024 pixels wide and
+ * high, which keeps the transfer small on slow connections.
  */
 void	imagedetailwidget::previewImage() {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "preview image %s", _image->name().c_str());
-	snowstar::ImageBuffer	file = _image->file(snowstar::ImageEncodingJPEG);
+	snowstar::ImageSize	size = _image->size();
+	int	scale = (std::max(size.width, size.height) + 1023) / 1024;
+	snowstar::ImageBuffer	file;
+	try {
+		snowstar::ImageRectangle	roi;
+		roi.origin.x = 0;
+		roi.origin.y = 0;
+		roi.size.width = 0;
+		roi.size.height = 0;
+		file = _image->preview(roi, std::max(scale, 1),
+			snowstar::ImageEncodingJPEG);
+	} catch (const Ice::OperationNotExistException& x) {
+		file = _image->file(snowstar::ImageEncodingJPEG);
+	}
 	_imageptr = snowstar::convertimage(file);
 	if (_imageptr) {
 		ui->saveButton->setEnabled(false);
@@ -113,8 +129,7 @@ void	imagedetailwidget::previewImage() {
  */
 void	imagedetailwidget::loadImage() {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "load image %s", _image->name().c_str());
-	snowstar::ImageBuffer	file = _image->file(snowstar::ImageEncodingFITS);
-	_imageptr = snowstar::convertimage(file);
+	_imageptr = snowstar::convert(_image);
 	if (_imageptr) {
 		ui->saveButton->setEnabled(true);
 		emit offerImage(_imageptr, std::string());
@@ -26,7 +26,20 @@ void	PreviewImageSink::image(const snowstar::ImageQueueEntry& entry,
 		entry.exposure0.frame.size.height,
 		entry.imagedata.size());
 	// convert the image to an astro::image::ImagePtr
-	astro::image::ImagePtr	image = snowstar::convertfile(entry.imagedata);
+	newimage(snowstar::convertimage(entry));
+}
+
+void	PreviewImageSink::rawimage(const snowstar::RawImageQueueEntry& entry,
+			const Ice::Current& /* current */) {
+	debug(LOG_DEBUG, DEBUG_LOG, 0, "got raw image of size %dx%d, "
+		"size = %ld",
+		entry.exposure0.frame.size.width,
+		entry.exposure0.frame.size.height,
+		entry.imagedata.size());
+	newimage(snowstar::convertimage(entry));
+}
+
+void	PreviewImageSink::newimage(astro::image::ImagePtr image) {
 	debug(LOG_DEBUG, DEBUG_LOG, 0,
 		"image has depth %d, bits_per_pixel = %d",
 		image->planes(), image->bitsPerPixel());
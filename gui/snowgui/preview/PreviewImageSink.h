@@ -11,13 +11,16 @@
 
 namespace snowgui {
 
-class PreviewImageSink : public snowstar::ImageSink {
+class PreviewImageSink : public snowstar::RawImageSink {
 	PreviewWindow	*_preview;
+	void	newimage(astro::image::ImagePtr image);
 public:
 	PreviewImageSink(PreviewWindow *preview);
 	virtual ~PreviewImageSink();
 	void	image(const snowstar::ImageQueueEntry& entry,
 			const Ice::Current& current);
+	void	rawimage(const snowstar::RawImageQueueEntry& entry,
+			const Ice::Current& current);
 	void	stop(const Ice::Current& current);
 };
 
@@ -460,6 +460,7 @@ void	PreviewWindow::startStream() {
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "registering the sink");
 	_ccd->registerSink(ident);
 	debug(LOG_DEBUG, DEBUG_LOG, 0, "registration complete");
+	snowstar::negotiateStreamEncoding(_ccd);
 
 	// get the Exposure structure
 	astro::camera::Exposure	exposure = getExposure();